@@ -98,6 +98,25 @@ QemuFwCfgIsAvailable (
 }
 
 
+/**
+  Returns a boolean indicating if the firmware configuration interface
+  transfers data with DMA.
+
+  @retval TRUE   The DMA interface is available
+  @retval FALSE  The DMA interface is not available, or the firmware
+                 configuration interface itself is not available
+
+**/
+BOOLEAN
+EFIAPI
+QemuFwCfgDmaIsAvailable (
+  VOID
+  )
+{
+  return (BOOLEAN)(QemuFwCfgIsAvailable () && mFwCfgDmaAddress != 0);
+}
+
+
 RETURN_STATUS
 EFIAPI
 QemuFwCfgInitialize (
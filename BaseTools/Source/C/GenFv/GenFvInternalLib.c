@@ -21,6 +21,9 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #ifdef __GNUC__
 #include <sys/stat.h>
 #endif
+#if defined(__GNUC__) && !defined(_WIN32)
+#include <sys/mman.h>
+#endif
 #include <string.h>
 #ifndef __GNUC__
 #include <io.h>
@@ -34,6 +37,8 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include "FvLib.h"
 #include "PeCoffLib.h"
 
+#include <Guid/FvFileDirectory.h>
+
 #define ARM64_UNCONDITIONAL_JUMP_INSTRUCTION      0x14000000
 
 /*
@@ -65,6 +70,24 @@ EFI_GUID  mFileGuidArray [MAX_NUMBER_OF_FILES_IN_FV];
 EFI_GUID  mZeroGuid                           = {0x0, 0x0, 0x0, {0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0}};
 EFI_GUID  mDefaultCapsuleGuid                 = {0x3B6686BD, 0x0D76, 0x4030, { 0xB7, 0x0E, 0xB5, 0x51, 0x9E, 0x2F, 0xC5, 0xA0 }};
 EFI_GUID  mEfiFfsSectionAlignmentPaddingGuid  = EFI_FFS_SECTION_ALIGNMENT_PADDING_GUID;
+EFI_GUID  mEdkiiFvFileDirectoryGuid           = EDKII_FV_FILE_DIRECTORY_GUID;
+
+//
+// Number of bytes the FV file directory adds to the input FV extension header.
+//
+STATIC UINT32   mFvFileDirectoryGrowth = 0;
+
+//
+// Contents of an input file of the FV, mapped or read once when the FV size
+// is calculated, and copied from there into the FV image by AddFile().
+//
+typedef struct {
+  UINT8     *Buffer;
+  UINTN     Size;
+  BOOLEAN   Mapped;
+} FV_INPUT_FILE;
+
+STATIC FV_INPUT_FILE  mFvInputFiles[MAX_NUMBER_OF_FILES_IN_FV];
 
 CHAR8      *mFvbAttributeName[] = {
   EFI_FVB2_READ_DISABLED_CAP_STRING,
@@ -1034,6 +1057,118 @@ Returns:
   return EFI_SUCCESS;
 }
 
+STATIC
+EFI_STATUS
+LoadFvInputFile (
+  IN  CHAR8          *FileName,
+  OUT FV_INPUT_FILE  *Input
+  )
+/*++
+
+Routine Description:
+
+  This function maps an input file of the FV into memory, or reads it where
+  files cannot be mapped. The mapping is private: the FFS checks write to the
+  contents temporarily, which does not change the file.
+
+Arguments:
+
+  FileName      The name of the file.
+  Input         The contents of the file.
+
+Returns:
+
+  EFI_SUCCESS              The file has been mapped or read.
+  EFI_ABORTED              The file cannot be opened or read.
+  EFI_OUT_OF_RESOURCES     No enough buffer is allocated.
+
+--*/
+{
+  FILE    *InputFile;
+  UINTN   NumBytesRead;
+
+  InputFile = fopen (LongFilePath (FileName), "rb");
+  if (InputFile == NULL) {
+    Error (NULL, 0, 0001, "Error opening file", FileName);
+    return EFI_ABORTED;
+  }
+
+  Input->Size   = _filelength (fileno (InputFile));
+  Input->Mapped = FALSE;
+
+#if defined(__GNUC__) && !defined(_WIN32)
+  if (Input->Size > 0) {
+    Input->Buffer = mmap (NULL, Input->Size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno (InputFile), 0);
+    if (Input->Buffer != MAP_FAILED) {
+      Input->Mapped = TRUE;
+      fclose (InputFile);
+      return EFI_SUCCESS;
+    }
+  }
+#endif
+
+  //
+  // Keep at least a byte allocated, so that a NULL buffer means the file has
+  // not been loaded.
+  //
+  Input->Buffer = malloc (Input->Size + 1);
+  if (Input->Buffer == NULL) {
+    fclose (InputFile);
+    Error (NULL, 0, 4001, "Resource", "memory cannot be allocated!");
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  NumBytesRead = fread (Input->Buffer, sizeof (UINT8), Input->Size, InputFile);
+  fclose (InputFile);
+  if (NumBytesRead != Input->Size) {
+    free (Input->Buffer);
+    Input->Buffer = NULL;
+    Error (NULL, 0, 0004, "Error reading file", FileName);
+    return EFI_ABORTED;
+  }
+
+  return EFI_SUCCESS;
+}
+
+STATIC
+VOID
+FreeFvInputFiles (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  This function unmaps or frees the input files of the FV.
+
+Arguments:
+
+  None
+
+Returns:
+
+  None
+
+--*/
+{
+  UINTN   Index;
+
+  for (Index = 0; Index < MAX_NUMBER_OF_FILES_IN_FV; Index++) {
+    if (mFvInputFiles[Index].Buffer == NULL) {
+      continue;
+    }
+#if defined(__GNUC__) && !defined(_WIN32)
+    if (mFvInputFiles[Index].Mapped) {
+      munmap (mFvInputFiles[Index].Buffer, mFvInputFiles[Index].Size);
+    } else
+#endif
+    {
+      free (mFvInputFiles[Index].Buffer);
+    }
+    mFvInputFiles[Index].Buffer = NULL;
+  }
+}
+
 STATIC
 BOOLEAN
 AdjustInternalFfsPadding (
@@ -1197,6 +1332,9 @@ Routine Description:
   This function adds a file to the FV image.  The file will pad to the
   appropriate alignment if required.
 
+  The file is copied from its mapped contents to its place in the FV image,
+  and rebased there.
+
 Arguments:
 
   FvImage       The memory image of the FV to add it to.  The current offset
@@ -1217,16 +1355,19 @@ Returns:
 
 --*/
 {
-  FILE                  *NewFile;
+  FV_INPUT_FILE         *Input;
+  EFI_FFS_FILE_HEADER   *InputFile;
+  EFI_FFS_FILE_HEADER   *FfsFile;
   UINTN                 FileSize;
   UINT8                 *FileBuffer;
-  UINTN                 NumBytesRead;
   UINT32                CurrentFileAlignment;
+  UINTN                 Misalignment;
   EFI_STATUS            Status;
   UINTN                 Index1;
   UINT8                 FileGuidString[PRINTED_GUID_BUFFER_SIZE];
 
   Index1 = 0;
+  FileBuffer = NULL;
   //
   // Verify input parameters.
   //
@@ -1235,65 +1376,36 @@ Returns:
   }
 
   //
-  // Read the file to add
-  //
-  NewFile = fopen (LongFilePath (FvInfo->FvFiles[Index]), "rb");
-
-  if (NewFile == NULL) {
-    Error (NULL, 0, 0001, "Error opening file", FvInfo->FvFiles[Index]);
-    return EFI_ABORTED;
-  }
-
-  //
-  // Get the file size
-  //
-  FileSize = _filelength (fileno (NewFile));
-
-  //
-  // Read the file into a buffer
+  // Use the file contents loaded when the FV size was calculated.
   //
-  FileBuffer = malloc (FileSize);
-  if (FileBuffer == NULL) {
-    fclose (NewFile);
-    Error (NULL, 0, 4001, "Resource", "memory cannot be allocated!");
-    return EFI_OUT_OF_RESOURCES;
-  }
-
-  NumBytesRead = fread (FileBuffer, sizeof (UINT8), FileSize, NewFile);
-
-  //
-  // Done with the file, from this point on we will just use the buffer read.
-  //
-  fclose (NewFile);
-
-  //
-  // Verify read successful
-  //
-  if (NumBytesRead != sizeof (UINT8) * FileSize) {
-    free  (FileBuffer);
-    Error (NULL, 0, 0004, "Error reading file", FvInfo->FvFiles[Index]);
-    return EFI_ABORTED;
+  Input = &mFvInputFiles[Index];
+  if (Input->Buffer == NULL) {
+    Status = LoadFvInputFile (FvInfo->FvFiles[Index], Input);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
   }
+  InputFile = (EFI_FFS_FILE_HEADER *) Input->Buffer;
+  FileSize  = Input->Size;
 
   //
   // For None PI Ffs file, directly add them into FvImage.
   //
   if (!FvInfo->IsPiFvImage) {
-    memcpy (FvImage->CurrentFilePointer, FileBuffer, FileSize);
+    memcpy (FvImage->CurrentFilePointer, InputFile, FileSize);
     if (FvInfo->SizeofFvFiles[Index] > FileSize) {
       FvImage->CurrentFilePointer += FvInfo->SizeofFvFiles[Index];
     } else {
       FvImage->CurrentFilePointer += FileSize;
     }
-    goto Done;
+    return EFI_SUCCESS;
   }
 
   //
   // Verify Ffs file
   //
-  Status = VerifyFfsFile ((EFI_FFS_FILE_HEADER *)FileBuffer);
+  Status = VerifyFfsFile (InputFile);
   if (EFI_ERROR (Status)) {
-    free (FileBuffer);
     Error (NULL, 0, 3000, "Invalid", "%s is not a valid FFS file.", FvInfo->FvFiles[Index]);
     return EFI_INVALID_PARAMETER;
   }
@@ -1302,7 +1414,6 @@ Returns:
   // Verify space exists to add the file
   //
   if (FileSize > (UINTN) ((UINTN) *VtfFileImage - (UINTN) FvImage->CurrentFilePointer)) {
-    free (FileBuffer);
     Error (NULL, 0, 4002, "Resource", "FV space is full, not enough room to add file %s.", FvInfo->FvFiles[Index]);
     return EFI_OUT_OF_RESOURCES;
   }
@@ -1311,27 +1422,18 @@ Returns:
   // Verify the input file is the duplicated file in this Fv image
   //
   for (Index1 = 0; Index1 < Index; Index1 ++) {
-    if (CompareGuid ((EFI_GUID *) FileBuffer, &mFileGuidArray [Index1]) == 0) {
+    if (CompareGuid ((EFI_GUID *) InputFile, &mFileGuidArray [Index1]) == 0) {
       Error (NULL, 0, 2000, "Invalid parameter", "the %dth file and %uth file have the same file GUID.", (unsigned) Index1 + 1, (unsigned) Index + 1);
-      PrintGuid ((EFI_GUID *) FileBuffer);
-      free (FileBuffer);
+      PrintGuid ((EFI_GUID *) InputFile);
       return EFI_INVALID_PARAMETER;
     }
   }
-  CopyMem (&mFileGuidArray [Index], FileBuffer, sizeof (EFI_GUID));
-
-  //
-  // Update the file state based on polarity of the FV.
-  //
-  UpdateFfsFileState (
-    (EFI_FFS_FILE_HEADER *) FileBuffer,
-    (EFI_FIRMWARE_VOLUME_HEADER *) FvImage->FileImage
-    );
+  CopyMem (&mFileGuidArray [Index], InputFile, sizeof (EFI_GUID));
 
   //
   // Check if alignment is required
   //
-  ReadFfsAlignment ((EFI_FFS_FILE_HEADER *) FileBuffer, &CurrentFileAlignment);
+  ReadFfsAlignment (InputFile, &CurrentFileAlignment);
 
   //
   // Find the largest alignment of all the FFS files in the FV
@@ -1342,7 +1444,7 @@ Returns:
   //
   // If we have a VTF file, add it at the top.
   //
-  if (IsVtfFile ((EFI_FFS_FILE_HEADER *) FileBuffer)) {
+  if (IsVtfFile (InputFile)) {
     if ((UINTN) *VtfFileImage == (UINTN) FvImage->Eof) {
       //
       // No previous VTF, add this one.
@@ -1351,29 +1453,31 @@ Returns:
       //
       // Sanity check. The file MUST align appropriately
       //
-      if (((UINTN) *VtfFileImage + GetFfsHeaderLength((EFI_FFS_FILE_HEADER *)FileBuffer) - (UINTN) FvImage->FileImage) % (1 << CurrentFileAlignment)) {
+      if (((UINTN) *VtfFileImage + GetFfsHeaderLength(InputFile) - (UINTN) FvImage->FileImage) % (1 << CurrentFileAlignment)) {
         Error (NULL, 0, 3000, "Invalid", "VTF file cannot be aligned on a %u-byte boundary.", (unsigned) (1 << CurrentFileAlignment));
-        free (FileBuffer);
         return EFI_ABORTED;
       }
       //
-      // Rebase the PE or TE image in FileBuffer of FFS file for XIP
+      // copy VTF File, and update the file state based on polarity of the FV.
+      //
+      memcpy (*VtfFileImage, InputFile, FileSize);
+      UpdateFfsFileState (
+        *VtfFileImage,
+        (EFI_FIRMWARE_VOLUME_HEADER *) FvImage->FileImage
+        );
+      //
+      // Rebase the PE or TE image in the VTF file for XIP
       // Rebase for the debug genfvmap tool
       //
-      Status = FfsRebase (FvInfo, FvInfo->FvFiles[Index], (EFI_FFS_FILE_HEADER *) FileBuffer, (UINTN) *VtfFileImage - (UINTN) FvImage->FileImage, FvMapFile);
+      Status = FfsRebase (FvInfo, FvInfo->FvFiles[Index], *VtfFileImage, (UINTN) *VtfFileImage - (UINTN) FvImage->FileImage, FvMapFile);
       if (EFI_ERROR (Status)) {
         Error (NULL, 0, 3000, "Invalid", "Could not rebase %s.", FvInfo->FvFiles[Index]);
         return Status;
       }
-      //
-      // copy VTF File
-      //
-      memcpy (*VtfFileImage, FileBuffer, FileSize);
 
-      PrintGuidToBuffer ((EFI_GUID *) FileBuffer, FileGuidString, sizeof (FileGuidString), TRUE);
+      PrintGuidToBuffer ((EFI_GUID *) *VtfFileImage, FileGuidString, sizeof (FileGuidString), TRUE);
       fprintf (FvReportFile, "0x%08X %s\n", (unsigned)(UINTN) (((UINT8 *)*VtfFileImage) - (UINTN)FvImage->FileImage), FileGuidString);
 
-      free (FileBuffer);
       DebugMsg (NULL, 0, 9, "Add VTF FFS file in FV image", NULL);
       return EFI_SUCCESS;
     } else {
@@ -1381,7 +1485,6 @@ Returns:
       // Already found a VTF file.
       //
       Error (NULL, 0, 3000, "Invalid", "multiple VTF files are not permitted within a single FV.");
-      free (FileBuffer);
       return EFI_ABORTED;
     }
   }
@@ -1389,12 +1492,31 @@ Returns:
   //
   // Add pad file if necessary
   //
-  if (!AdjustInternalFfsPadding ((EFI_FFS_FILE_HEADER *) FileBuffer, FvImage,
-         1 << CurrentFileAlignment, &FileSize)) {
+  Misalignment = ((UINTN) FvImage->CurrentFilePointer - (UINTN) FvImage->FileImage + GetFfsHeaderLength (InputFile)) &
+                 ((1 << CurrentFileAlignment) - 1);
+  if (Misalignment != 0 && (InputFile->Attributes & FFS_ATTRIB_FIXED) != 0) {
+    //
+    // The padding section of a fixed file may absorb the misalignment, which
+    // changes the file: work on a copy of it.
+    //
+    FileBuffer = malloc (FileSize);
+    if (FileBuffer == NULL) {
+      Error (NULL, 0, 4001, "Resource", "memory cannot be allocated!");
+      return EFI_OUT_OF_RESOURCES;
+    }
+    memcpy (FileBuffer, InputFile, FileSize);
+    InputFile = (EFI_FFS_FILE_HEADER *) FileBuffer;
+    if (AdjustInternalFfsPadding (InputFile, FvImage, 1 << CurrentFileAlignment, &FileSize)) {
+      Misalignment = 0;
+    }
+  }
+  if (Misalignment != 0) {
     Status = AddPadFile (FvImage, 1 << CurrentFileAlignment, *VtfFileImage, NULL, FileSize);
     if (EFI_ERROR (Status)) {
       Error (NULL, 0, 4002, "Resource", "FV space is full, could not add pad file for data alignment property.");
-      free (FileBuffer);
+      if (FileBuffer != NULL) {
+        free (FileBuffer);
+      }
       return EFI_ABORTED;
     }
   }
@@ -1403,24 +1525,34 @@ Returns:
   //
   if ((UINTN) (FvImage->CurrentFilePointer + FileSize) <= (UINTN) (*VtfFileImage)) {
     //
-    // Rebase the PE or TE image in FileBuffer of FFS file for XIP.
-    // Rebase Bs and Rt drivers for the debug genfvmap tool.
+    // Copy the file, and update the file state based on polarity of the FV.
     //
-    Status = FfsRebase (FvInfo, FvInfo->FvFiles[Index], (EFI_FFS_FILE_HEADER *) FileBuffer, (UINTN) FvImage->CurrentFilePointer - (UINTN) FvImage->FileImage, FvMapFile);
-  if (EFI_ERROR (Status)) {
-    Error (NULL, 0, 3000, "Invalid", "Could not rebase %s.", FvInfo->FvFiles[Index]);
-    return Status;
-  }
+    FfsFile = (EFI_FFS_FILE_HEADER *) FvImage->CurrentFilePointer;
+    memcpy (FfsFile, InputFile, FileSize);
+    if (FileBuffer != NULL) {
+      free (FileBuffer);
+    }
+    UpdateFfsFileState (
+      FfsFile,
+      (EFI_FIRMWARE_VOLUME_HEADER *) FvImage->FileImage
+      );
     //
-    // Copy the file
+    // Rebase the PE or TE image of the FFS file for XIP.
+    // Rebase Bs and Rt drivers for the debug genfvmap tool.
     //
-    memcpy (FvImage->CurrentFilePointer, FileBuffer, FileSize);
-    PrintGuidToBuffer ((EFI_GUID *) FileBuffer, FileGuidString, sizeof (FileGuidString), TRUE);
+    Status = FfsRebase (FvInfo, FvInfo->FvFiles[Index], FfsFile, (UINTN) FvImage->CurrentFilePointer - (UINTN) FvImage->FileImage, FvMapFile);
+    if (EFI_ERROR (Status)) {
+      Error (NULL, 0, 3000, "Invalid", "Could not rebase %s.", FvInfo->FvFiles[Index]);
+      return Status;
+    }
+    PrintGuidToBuffer ((EFI_GUID *) FfsFile, FileGuidString, sizeof (FileGuidString), TRUE);
     fprintf (FvReportFile, "0x%08X %s\n", (unsigned) (FvImage->CurrentFilePointer - FvImage->FileImage), FileGuidString);
     FvImage->CurrentFilePointer += FileSize;
   } else {
     Error (NULL, 0, 4002, "Resource", "FV space is full, cannot add file %s.", FvInfo->FvFiles[Index]);
-    free (FileBuffer);
+    if (FileBuffer != NULL) {
+      free (FileBuffer);
+    }
     return EFI_ABORTED;
   }
   //
@@ -1430,12 +1562,6 @@ Returns:
     FvImage->CurrentFilePointer++;
   }
 
-Done:
-  //
-  // Free allocated memory.
-  //
-  free (FileBuffer);
-
   return EFI_SUCCESS;
 }
 
@@ -2517,6 +2643,220 @@ Returns:
   return EFI_SUCCESS;
 }
 
+STATIC
+EDKII_FV_FILE_DIRECTORY_HEADER *
+FindFvFileDirectory (
+  IN EFI_FIRMWARE_VOLUME_EXT_HEADER  *ExtHeader
+  )
+/*++
+
+Routine Description:
+
+  This function finds the FV file directory entry in a FV extension header.
+
+Arguments:
+
+  ExtHeader     The FV extension header.
+
+Returns:
+
+  The FV file directory entry, or NULL if the FV extension header has none.
+
+--*/
+{
+  EFI_FIRMWARE_VOLUME_EXT_ENTRY   *ExtEntry;
+  UINT32                          Index;
+
+  for (Index = sizeof (EFI_FIRMWARE_VOLUME_EXT_HEADER);
+       Index + sizeof (EFI_FIRMWARE_VOLUME_EXT_ENTRY) <= ExtHeader->ExtHeaderSize;
+       Index += ExtEntry->ExtEntrySize) {
+    ExtEntry = (EFI_FIRMWARE_VOLUME_EXT_ENTRY *) ((UINT8 *) ExtHeader + Index);
+    if (ExtEntry->ExtEntrySize < sizeof (EFI_FIRMWARE_VOLUME_EXT_ENTRY) ||
+        Index + ExtEntry->ExtEntrySize > ExtHeader->ExtHeaderSize) {
+      break;
+    }
+    if (ExtEntry->ExtEntryType == EFI_FV_EXT_TYPE_GUID_TYPE &&
+        ExtEntry->ExtEntrySize >= sizeof (EDKII_FV_FILE_DIRECTORY_HEADER) &&
+        CompareGuid (&((EDKII_FV_FILE_DIRECTORY_HEADER *) ExtEntry)->FormatType, &mEdkiiFvFileDirectoryGuid) == 0) {
+      return (EDKII_FV_FILE_DIRECTORY_HEADER *) ExtEntry;
+    }
+  }
+
+  return NULL;
+}
+
+STATIC
+EFI_STATUS
+ReserveFvFileDirectory (
+  IN OUT EFI_FIRMWARE_VOLUME_EXT_HEADER  **ExtHeader,
+  IN     UINTN                           FileCount
+  )
+/*++
+
+Routine Description:
+
+  This function grows the FV file directory entry of the FV extension header,
+  as generated by GenFds with an empty list, so that it can list FileCount
+  files. The entries are filled in by UpdateFvFileDirectory() once all the
+  files have been added to the FV.
+
+Arguments:
+
+  ExtHeader     The FV extension header, reallocated if it has to grow.
+  FileCount     The number of files that will be added to the FV.
+
+Returns:
+
+  EFI_SUCCESS             The FV file directory has been reserved, or the FV
+                          extension header has no FV file directory.
+  EFI_OUT_OF_RESOURCES    No enough buffer is allocated.
+
+--*/
+{
+  EDKII_FV_FILE_DIRECTORY_HEADER  *Directory;
+  EFI_FIRMWARE_VOLUME_EXT_HEADER  *NewExtHeader;
+  UINTN                           DirectoryOffset;
+  UINTN                           DirectoryEnd;
+  UINTN                           Growth;
+
+  mFvFileDirectoryGrowth = 0;
+
+  Directory = FindFvFileDirectory (*ExtHeader);
+  if (Directory == NULL) {
+    return EFI_SUCCESS;
+  }
+
+  Directory->EntryCount = 0;
+  DirectoryOffset = (UINTN) Directory - (UINTN) *ExtHeader;
+  DirectoryEnd    = DirectoryOffset + Directory->Hdr.ExtEntrySize;
+  if (sizeof (EDKII_FV_FILE_DIRECTORY_HEADER) + FileCount * sizeof (EDKII_FV_FILE_DIRECTORY_ENTRY) > MAX_UINT16) {
+    Warning (NULL, 0, 0, "Too many files in FV", "the FV file directory is left empty.");
+    return EFI_SUCCESS;
+  }
+  if (sizeof (EDKII_FV_FILE_DIRECTORY_HEADER) + FileCount * sizeof (EDKII_FV_FILE_DIRECTORY_ENTRY) <= Directory->Hdr.ExtEntrySize) {
+    return EFI_SUCCESS;
+  }
+  Growth = sizeof (EDKII_FV_FILE_DIRECTORY_HEADER) + FileCount * sizeof (EDKII_FV_FILE_DIRECTORY_ENTRY) - Directory->Hdr.ExtEntrySize;
+
+  NewExtHeader = malloc ((*ExtHeader)->ExtHeaderSize + Growth);
+  if (NewExtHeader == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // Copy everything up to the end of the directory entry, zero the new
+  // directory entries, and move the extension entries following it.
+  //
+  memcpy (NewExtHeader, *ExtHeader, DirectoryEnd);
+  memset ((UINT8 *) NewExtHeader + DirectoryEnd, 0, Growth);
+  memcpy ((UINT8 *) NewExtHeader + DirectoryEnd + Growth, (UINT8 *) *ExtHeader + DirectoryEnd, (*ExtHeader)->ExtHeaderSize - DirectoryEnd);
+  NewExtHeader->ExtHeaderSize += (UINT32) Growth;
+  Directory = (EDKII_FV_FILE_DIRECTORY_HEADER *) ((UINT8 *) NewExtHeader + DirectoryOffset);
+  Directory->Hdr.ExtEntrySize = (UINT16) (Directory->Hdr.ExtEntrySize + Growth);
+
+  free (*ExtHeader);
+  *ExtHeader = NewExtHeader;
+  mFvFileDirectoryGrowth = (UINT32) Growth;
+
+  return EFI_SUCCESS;
+}
+
+STATIC
+int
+CompareFvFileDirectoryEntry (
+  IN CONST VOID  *Left,
+  IN CONST VOID  *Right
+  )
+{
+  CONST EDKII_FV_FILE_DIRECTORY_ENTRY  *LeftEntry;
+  CONST EDKII_FV_FILE_DIRECTORY_ENTRY  *RightEntry;
+  int                                  Result;
+
+  LeftEntry  = (CONST EDKII_FV_FILE_DIRECTORY_ENTRY *) Left;
+  RightEntry = (CONST EDKII_FV_FILE_DIRECTORY_ENTRY *) Right;
+
+  Result = memcmp (&LeftEntry->Name, &RightEntry->Name, sizeof (EFI_GUID));
+  if (Result != 0) {
+    return Result;
+  }
+
+  //
+  // Keep files with the same name in FV order.
+  //
+  if (LeftEntry->Offset < RightEntry->Offset) {
+    return -1;
+  }
+  return LeftEntry->Offset > RightEntry->Offset ? 1 : 0;
+}
+
+STATIC
+VOID
+UpdateFvFileDirectory (
+  IN MEMORY_FILE  *FvImage
+  )
+/*++
+
+Routine Description:
+
+  This function fills in the FV file directory of the FV extension header with
+  the name and the offset of every file in the FV, sorted by name. Pad files
+  are not listed. The FV library must have been initialized with the FV.
+
+Arguments:
+
+  FvImage       The memory image of the FV, with all the files added.
+
+Returns:
+
+  None.
+
+--*/
+{
+  EFI_FIRMWARE_VOLUME_HEADER      *FvHeader;
+  EFI_FIRMWARE_VOLUME_EXT_HEADER  *ExtHeader;
+  EDKII_FV_FILE_DIRECTORY_HEADER  *Directory;
+  EDKII_FV_FILE_DIRECTORY_ENTRY   *Entry;
+  UINT32                          MaxEntryCount;
+  UINT32                          EntryCount;
+  EFI_FFS_FILE_HEADER             *FfsFile;
+
+  FvHeader = (EFI_FIRMWARE_VOLUME_HEADER *) FvImage->FileImage;
+  if (FvHeader->ExtHeaderOffset == 0) {
+    return;
+  }
+  ExtHeader = (EFI_FIRMWARE_VOLUME_EXT_HEADER *) (FvImage->FileImage + FvHeader->ExtHeaderOffset);
+  Directory = FindFvFileDirectory (ExtHeader);
+  if (Directory == NULL) {
+    return;
+  }
+
+  MaxEntryCount = (Directory->Hdr.ExtEntrySize - sizeof (EDKII_FV_FILE_DIRECTORY_HEADER)) / sizeof (EDKII_FV_FILE_DIRECTORY_ENTRY);
+  Entry         = (EDKII_FV_FILE_DIRECTORY_ENTRY *) (Directory + 1);
+  EntryCount    = 0;
+
+  for (FfsFile = NULL; GetNextFile (FfsFile, &FfsFile) == EFI_SUCCESS && FfsFile != NULL;) {
+    if (FfsFile->Type == EFI_FV_FILETYPE_FFS_PAD) {
+      continue;
+    }
+    if (EntryCount == MaxEntryCount) {
+      //
+      // A partial directory would hide files from the lookup, so leave it empty.
+      //
+      Warning (NULL, 0, 0, "FV file directory is full", "the FV file directory is left empty.");
+      EntryCount = 0;
+      break;
+    }
+    memcpy (&Entry[EntryCount].Name, &FfsFile->Name, sizeof (EFI_GUID));
+    Entry[EntryCount].Offset = (UINT32) ((UINTN) FfsFile - (UINTN) FvHeader);
+    EntryCount++;
+  }
+
+  qsort (Entry, EntryCount, sizeof (EDKII_FV_FILE_DIRECTORY_ENTRY), CompareFvFileDirectoryEntry);
+  Directory->EntryCount = EntryCount;
+
+  DebugMsg (NULL, 0, 9, "FV file directory", "%u files listed", (unsigned) EntryCount);
+}
+
 EFI_STATUS
 GenerateFvImage (
   IN CHAR8                *InfFileImage,
@@ -2667,6 +3007,17 @@ Returns:
     }
     memcpy (&mFvDataInfo.FvNameGuid, &FvExtHeader->FvName, sizeof (EFI_GUID));
     mFvDataInfo.FvNameGuidSet = TRUE;
+
+    //
+    // Make room for the FV file directory if it is requested
+    //
+    for (Index = 0; mFvDataInfo.FvFiles[Index][0] != 0; Index++) {
+    }
+    Status = ReserveFvFileDirectory (&FvExtHeader, Index);
+    if (EFI_ERROR (Status)) {
+      free (FvExtHeader);
+      return Status;
+    }
   } else if (mFvDataInfo.FvNameGuidSet) {
     //
     // Allocate a buffer for the FV Extension Header
@@ -3004,6 +3355,13 @@ Returns:
     FvHeader->Checksum = CalculateChecksum16 ((UINT16 *) FvHeader, FvHeader->HeaderLength / sizeof (UINT16));
   }
 
+  //
+  // Fill in the FV file directory now that the file offsets are known
+  //
+  if (FvExtHeader != NULL) {
+    UpdateFvFileDirectory (&FvImageMemoryFile);
+  }
+
   //
   // Update FV Alignment attribute to the largest alignment of all the FFS files in the FV
   //
@@ -3044,6 +3402,8 @@ WriteFile:
   }
 
 Finish:
+  FreeFvInputFiles ();
+
   if (FvBufferHeader != NULL) {
     free (FvBufferHeader);
   }
@@ -3175,6 +3535,7 @@ Returns:
   EFI_FFS_FILE_HEADER FfsHeader;
   UINTN               VtfFileSize;
   UINTN               MaxPadFileSize;
+  EFI_STATUS          Status;
 
   FvExtendHeaderSize = 0;
   MaxPadFileSize = 0;
@@ -3211,7 +3572,7 @@ Returns:
       Error (NULL, 0, 0001, "Error opening file", mFvDataInfo.FvExtHeaderFile);
       return EFI_ABORTED;
     }
-    FvExtendHeaderSize = _filelength (fileno (fpin));
+    FvExtendHeaderSize = _filelength (fileno (fpin)) + mFvFileDirectoryGrowth;
     fclose (fpin);
     if (sizeof (EFI_FFS_FILE_HEADER) + FvExtendHeaderSize >= MAX_FFS_SIZE) {
       CurrentOffset += sizeof (EFI_FFS_FILE_HEADER2) + FvExtendHeaderSize;
@@ -3226,22 +3587,19 @@ Returns:
   }
 
   //
-  // Accumulate every FFS file size.
+  // Accumulate every FFS file size. The files are mapped or read once here,
+  // AddFile() copies them from memory.
   //
+  FreeFvInputFiles ();
   for (Index = 0; FvInfoPtr->FvFiles[Index][0] != 0; Index++) {
-    //
-    // Open FFS file
-    //
-    fpin = NULL;
-    fpin = fopen (LongFilePath (FvInfoPtr->FvFiles[Index]), "rb");
-    if (fpin == NULL) {
-      Error (NULL, 0, 0001, "Error opening file", FvInfoPtr->FvFiles[Index]);
+    Status = LoadFvInputFile (FvInfoPtr->FvFiles[Index], &mFvInputFiles[Index]);
+    if (EFI_ERROR (Status)) {
       return EFI_ABORTED;
     }
     //
     // Get the file size
     //
-    FfsFileSize = _filelength (fileno (fpin));
+    FfsFileSize = mFvInputFiles[Index].Size;
     if (FfsFileSize >= MAX_FFS_SIZE) {
       FfsHeaderSize = sizeof(EFI_FFS_FILE_HEADER2);
       mIsLargeFfs = TRUE;
@@ -3251,11 +3609,8 @@ Returns:
     //
     // Read Ffs File header
     //
-    fread (&FfsHeader, sizeof (UINT8), sizeof (EFI_FFS_FILE_HEADER), fpin);
-    //
-    // close file
-    //
-    fclose (fpin);
+    memset (&FfsHeader, 0, sizeof (EFI_FFS_FILE_HEADER));
+    memcpy (&FfsHeader, mFvInputFiles[Index].Buffer, MIN (FfsFileSize, sizeof (EFI_FFS_FILE_HEADER)));
 
     if (FvInfoPtr->IsPiFvImage) {
         //
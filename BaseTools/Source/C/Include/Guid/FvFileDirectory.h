@@ -0,0 +1,37 @@
+/** @file
+  Firmware volume file directory, an optional EFI_FV_EXT_TYPE_GUID_TYPE entry
+  of the firmware volume extension header that lists the name and the offset
+  of every file of the firmware volume, sorted by name.
+
+  This mirrors MdeModulePkg/Include/Guid/FvFileDirectory.h.
+
+  Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __FV_FILE_DIRECTORY_GUID_H__
+#define __FV_FILE_DIRECTORY_GUID_H__
+
+#define EDKII_FV_FILE_DIRECTORY_GUID \
+  { \
+    0xfb433b49, 0x4ea7, 0x46ff, { 0xac, 0x73, 0xe0, 0x91, 0xae, 0x80, 0x91, 0x3e } \
+  }
+
+#pragma pack(1)
+
+typedef struct {
+  EFI_GUID                          Name;
+  UINT32                            Offset;
+} EDKII_FV_FILE_DIRECTORY_ENTRY;
+
+typedef struct {
+  EFI_FIRMWARE_VOLUME_EXT_ENTRY     Hdr;
+  EFI_GUID                          FormatType;
+  UINT32                            EntryCount;
+} EDKII_FV_FILE_DIRECTORY_HEADER;
+
+#pragma pack()
+
+#endif
@@ -14,6 +14,7 @@ import hashlib
 from collections import defaultdict
 from GenFds.FdfParser import FdfParser
 from Workspace.WorkspaceCommon import GetModuleLibInstances
+from Workspace import MetaFileCache
 from AutoGen import GenMake
 from AutoGen.AutoGen import AutoGen
 from AutoGen.PlatformAutoGen import PlatformAutoGen
@@ -108,6 +109,7 @@ class WorkspaceAutoGen(AutoGen):
         #
         # Mark now build in AutoGen Phase
         #
+        self.PreParseMetaFiles()
         #
         # Collect Platform Guids to support Guid name in Fdfparser.
         #
@@ -134,6 +136,16 @@ class WorkspaceAutoGen(AutoGen):
         self.CreatePcdTokenNumberFile()
         self.GeneratePlatformLevelHash()
 
+    #
+    # Parse the INF files of all arches in parallel, before they are used one by one
+    #
+    def PreParseMetaFiles(self):
+        InfList = []
+        for Arch in self.ArchList:
+            Platform = self.BuildDatabase[self.MetaFile, Arch, self.BuildTarget, self.ToolChain]
+            InfList.extend(Platform.InfList)
+        MetaFileCache.PreParse(InfList)
+
     #
     # Merge Arch
     #
@@ -899,6 +911,7 @@ class WorkspaceAutoGen(AutoGen):
             FdsCommandDict["quiet"] = True
 
         FdsCommandDict["GenfdsMultiThread"] = GlobalData.gEnableGenfdsMultiThread
+        FdsCommandDict["GenfdsInProcess"] = GlobalData.gEnableGenfdsInProcess
         if GlobalData.gIgnoreSource:
             FdsCommandDict["IgnoreSources"] = True
 
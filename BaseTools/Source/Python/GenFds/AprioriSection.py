@@ -14,7 +14,7 @@ from struct import pack
 import Common.LongFilePathOs as os
 from io import BytesIO
 from .FfsFileStatement import FileStatement
-from .GenFdsGlobalVariable import GenFdsGlobalVariable
+from .GenFdsGlobalVariable import GenFdsGlobalVariable, WorkspaceLock
 from Common.StringUtils import NormPath
 from Common.Misc import SaveFileOnChange, PathClass
 from Common.EdkLogger import error as EdkLoggerError
@@ -80,17 +80,18 @@ class AprioriSection (object):
                     Dict['$(ARCH)'] = Arch
                 InfFileName = GenFdsGlobalVariable.MacroExtend(InfFileName, Dict, Arch)
 
-                if Arch:
-                    Inf = GenFdsGlobalVariable.WorkSpace.BuildObject[PathClass(InfFileName, GenFdsGlobalVariable.WorkSpaceDir), Arch, GenFdsGlobalVariable.TargetName, GenFdsGlobalVariable.ToolChainTag]
-                    Guid = Inf.Guid
-                else:
-                    Inf = GenFdsGlobalVariable.WorkSpace.BuildObject[PathClass(InfFileName, GenFdsGlobalVariable.WorkSpaceDir), TAB_COMMON, GenFdsGlobalVariable.TargetName, GenFdsGlobalVariable.ToolChainTag]
-                    Guid = Inf.Guid
-
-                    if not Inf.Module.Binaries:
-                        EdkLoggerError("GenFds", RESOURCE_NOT_AVAILABLE,
-                                        "INF %s not found in build ARCH %s!" \
-                                        % (InfFileName, GenFdsGlobalVariable.ArchList))
+                with WorkspaceLock:
+                    if Arch:
+                        Inf = GenFdsGlobalVariable.WorkSpace.BuildObject[PathClass(InfFileName, GenFdsGlobalVariable.WorkSpaceDir), Arch, GenFdsGlobalVariable.TargetName, GenFdsGlobalVariable.ToolChainTag]
+                        Guid = Inf.Guid
+                    else:
+                        Inf = GenFdsGlobalVariable.WorkSpace.BuildObject[PathClass(InfFileName, GenFdsGlobalVariable.WorkSpaceDir), TAB_COMMON, GenFdsGlobalVariable.TargetName, GenFdsGlobalVariable.ToolChainTag]
+                        Guid = Inf.Guid
+
+                        if not Inf.Module.Binaries:
+                            EdkLoggerError("GenFds", RESOURCE_NOT_AVAILABLE,
+                                            "INF %s not found in build ARCH %s!" \
+                                            % (InfFileName, GenFdsGlobalVariable.ArchList))
 
             GuidPart = Guid.split('-')
             Buffer.write(pack('I', int(GuidPart[0], 16)))
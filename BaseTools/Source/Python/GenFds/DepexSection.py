@@ -11,7 +11,7 @@
 #
 from __future__ import absolute_import
 from . import Section
-from .GenFdsGlobalVariable import GenFdsGlobalVariable
+from .GenFdsGlobalVariable import GenFdsGlobalVariable, WorkspaceLocked
 import Common.LongFilePathOs as os
 from CommonDataClass.FdfClass import DepexSectionClassObject
 from AutoGen.GenDepex import DependencyExpression
@@ -31,6 +31,7 @@ class DepexSection (DepexSectionClassObject):
     def __init__(self):
         DepexSectionClassObject.__init__(self)
 
+    @WorkspaceLocked
     def __FindGuidValue(self, CName):
         for Arch in GenFdsGlobalVariable.ArchList:
             PkgList = GenFdsGlobalVariable.WorkSpace.GetPackageList(GenFdsGlobalVariable.ActivePlatform,
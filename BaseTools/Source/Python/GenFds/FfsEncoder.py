@@ -0,0 +1,357 @@
+## @file
+# In-process section and FFS encapsulation, byte compatible with GenSec and GenFfs
+#
+#  Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+#
+#  SPDX-License-Identifier: BSD-2-Clause-Patent
+#
+
+##
+# Import Modules
+#
+from __future__ import absolute_import
+import re
+from struct import pack, unpack_from
+import Common.LongFilePathOs as os
+from Common.Misc import PackGUID, CreateDirectory
+from Common.LongFilePathSupport import OpenLongFilePath as open
+
+MAX_SECTION_SIZE = 0x1000000
+MAX_FFS_SIZE = 0x1000000
+
+EFI_SECTION_COMPRESSION = 0x01
+EFI_SECTION_GUID_DEFINED = 0x02
+EFI_SECTION_PE32 = 0x10
+EFI_SECTION_TE = 0x12
+EFI_SECTION_VERSION = 0x14
+EFI_SECTION_FIRMWARE_VOLUME_IMAGE = 0x17
+EFI_SECTION_FREEFORM_SUBTYPE_GUID = 0x18
+EFI_SECTION_RAW = 0x19
+
+EFI_GUIDED_SECTION_PROCESSING_REQUIRED = 0x01
+EFI_TE_IMAGE_HEADER_SIGNATURE = 0x5A56
+EFI_TE_IMAGE_HEADER_SIZE = 40
+EFI_FREEFORM_SUBTYPE_GUID_SECTION_SIZE = 20
+
+FFS_ATTRIB_LARGE_FILE = 0x01
+FFS_ATTRIB_DATA_ALIGNMENT2 = 0x02
+FFS_ATTRIB_FIXED = 0x04
+FFS_ATTRIB_CHECKSUM = 0x40
+FFS_FIXED_CHECKSUM = 0xAA
+EFI_FILE_STATE = 0x07
+
+EFI_FFS_SECTION_ALIGNMENT_PADDING_GUID = PackGUID('04132C8D-0A22-4FA8-826E-8BBFEFDB836C'.split('-'))
+
+# Leaf section types GenSec wraps with a common section header
+LeafSectionType = {
+    'EFI_SECTION_PE32'                  : 0x10,
+    'EFI_SECTION_PIC'                   : 0x11,
+    'EFI_SECTION_TE'                    : 0x12,
+    'EFI_SECTION_DXE_DEPEX'             : 0x13,
+    'EFI_SECTION_COMPATIBILITY16'       : 0x16,
+    'EFI_SECTION_FIRMWARE_VOLUME_IMAGE' : 0x17,
+    'EFI_SECTION_FREEFORM_SUBTYPE_GUID' : 0x18,
+    'EFI_SECTION_RAW'                   : 0x19,
+    'EFI_SECTION_PEI_DEPEX'             : 0x1B,
+    'EFI_SECTION_SMM_DEPEX'             : 0x1C
+}
+
+FfsFileType = {
+    'EFI_FV_FILETYPE_RAW'                   : 0x01,
+    'EFI_FV_FILETYPE_FREEFORM'              : 0x02,
+    'EFI_FV_FILETYPE_SECURITY_CORE'         : 0x03,
+    'EFI_FV_FILETYPE_PEI_CORE'              : 0x04,
+    'EFI_FV_FILETYPE_DXE_CORE'              : 0x05,
+    'EFI_FV_FILETYPE_PEIM'                  : 0x06,
+    'EFI_FV_FILETYPE_DRIVER'                : 0x07,
+    'EFI_FV_FILETYPE_COMBINED_PEIM_DRIVER'  : 0x08,
+    'EFI_FV_FILETYPE_APPLICATION'           : 0x09,
+    'EFI_FV_FILETYPE_SMM'                   : 0x0A,
+    'EFI_FV_FILETYPE_FIRMWARE_VOLUME_IMAGE' : 0x0B,
+    'EFI_FV_FILETYPE_COMBINED_SMM_DXE'      : 0x0C,
+    'EFI_FV_FILETYPE_SMM_CORE'              : 0x0D,
+    'EFI_FV_FILETYPE_MM_STANDALONE'         : 0x0E,
+    'EFI_FV_FILETYPE_MM_CORE_STANDALONE'    : 0x0F
+}
+
+AlignName = ["1", "2", "4", "8", "16", "32", "64", "128", "256", "512",
+             "1K", "2K", "4K", "8K", "16K", "32K", "64K", "128K", "256K",
+             "512K", "1M", "2M", "4M", "8M", "16M"]
+
+FfsValidAlignName = ["8", "16", "128", "512", "1K", "4K", "32K", "64K", "128K", "256K",
+                     "512K", "1M", "2M", "4M", "8M", "16M"]
+
+FfsValidAlign = [0, 8, 16, 128, 512, 1024, 4096, 32768, 65536, 131072, 262144,
+                 524288, 1048576, 2097152, 4194304, 8388608, 16777216]
+
+GuidPattern = re.compile(r'^[0-9a-fA-F]{8}-[0-9a-fA-F]{4}-[0-9a-fA-F]{4}-[0-9a-fA-F]{4}-[0-9a-fA-F]{12}$')
+VersionPattern = re.compile(r'^[A-Za-z0-9_.\-]+$')
+
+## Build the common section header, or the extended one for a large section
+#
+#   @param  Type            Section type
+#   @param  DataLength      Length of the data following the header
+#   @param  ExtraLength     Length of the type specific header fields
+#   @retval bytes           The common section header
+#
+def _SectionHeader(Type, DataLength, ExtraLength=0):
+    TotalLength = 4 + ExtraLength + DataLength
+    if TotalLength >= MAX_SECTION_SIZE:
+        return pack('<3BBI', 0xff, 0xff, 0xff, Type, TotalLength + 4)
+    return pack('<3BB', TotalLength & 0xff, (TotalLength >> 8) & 0xff, (TotalLength >> 16) & 0xff, Type)
+
+def _Checksum8(Data):
+    return (0x100 - (sum(bytearray(Data)) & 0xff)) & 0xff
+
+def _StringToAlignment(AlignString):
+    for Index, Name in enumerate(AlignName):
+        if AlignString.upper() == Name:
+            return 1 << Index
+    return None
+
+def _ReadFiles(FileList):
+    Contents = []
+    for File in FileList:
+        if not os.path.isfile(File):
+            return None
+        with open(File, 'rb') as Fd:
+            Contents.append(Fd.read())
+    return Contents
+
+def _WriteFile(Output, Data):
+    DirName = os.path.dirname(Output)
+    if DirName and not CreateDirectory(DirName):
+        return False
+    with open(Output, 'wb') as Fd:
+        Fd.write(Data)
+    return True
+
+## Offsets of the section data that must be aligned, as GetSectionContents() of GenSec/GenFfs
+#
+#   @param  Data            Section file contents
+#   @retval tuple           (HeaderSize, TeOffset, Type), or None if the header is truncated
+#
+def _SectionDataOffsets(Data):
+    HeaderSize = 8 if len(Data) >= MAX_SECTION_SIZE else 4
+    if len(Data) < HeaderSize:
+        return None
+    Type = bytearray(Data)[3]
+    TeOffset = 0
+    if Type == EFI_SECTION_TE:
+        if len(Data) < HeaderSize + EFI_TE_IMAGE_HEADER_SIZE:
+            return None
+        Signature = unpack_from('<H', Data, HeaderSize)[0]
+        if Signature == EFI_TE_IMAGE_HEADER_SIGNATURE:
+            TeOffset = (unpack_from('<H', Data, HeaderSize + 6)[0] - EFI_TE_IMAGE_HEADER_SIZE) & 0xFFFFFFFF
+    elif Type == EFI_SECTION_GUID_DEFINED:
+        if len(Data) < HeaderSize + 20:
+            return None
+        DataOffset, Attributes = unpack_from('<HH', Data, HeaderSize + 16)
+        if (Attributes & EFI_GUIDED_SECTION_PROCESSING_REQUIRED) == 0:
+            HeaderSize = DataOffset
+    return HeaderSize, TeOffset, Type
+
+## Concatenate section files, padding each to its required data alignment
+#
+#   @param  Contents        Section file contents
+#   @param  AlignList       Alignment of each section, or None
+#   @param  Fixed           The FFS file has the FFS_ATTRIB_FIXED attribute (GenFfs only)
+#   @param  ForFfs          Use the GenFfs rules for the pad sections
+#   @retval tuple           (Data, MaxAlignment, PeSectionNum), or None if not supported
+#
+def _SectionContents(Contents, AlignList, Fixed=False, ForFfs=False):
+    Buffer = bytearray()
+    MaxAlignment = 1
+    PeSectionNum = 0
+    for Index, Data in enumerate(Contents):
+        Buffer.extend(b'\0' * (-len(Buffer) & 0x03))
+        Size = len(Buffer)
+        if AlignList is not None:
+            Align = AlignList[Index]
+            Offsets = _SectionDataOffsets(Data)
+            if Offsets is None:
+                return None
+            HeaderSize, TeOffset, Type = Offsets
+            if Type in (EFI_SECTION_TE, EFI_SECTION_PE32, EFI_SECTION_GUID_DEFINED,
+                        EFI_SECTION_COMPRESSION, EFI_SECTION_FIRMWARE_VOLUME_IMAGE):
+                PeSectionNum += 1
+            if TeOffset != 0:
+                TeOffset = (Align - (TeOffset % Align)) % Align
+            if (Size + HeaderSize + TeOffset) % Align != 0:
+                Offset = (Size + 4 + HeaderSize + TeOffset + Align - 1) & ~(Align - 1) & 0xFFFFFFFF
+                Offset = (Offset - Size - HeaderSize - TeOffset) & 0xFFFFFFFF
+                if Offset >= MAX_SECTION_SIZE:
+                    return None
+                Pad = bytearray(Offset)
+                Pad[0:3] = bytearray([Offset & 0xff, (Offset >> 8) & 0xff, (Offset >> 16) & 0xff])
+                if ForFfs and Fixed and MaxAlignment <= 1 and Offset >= EFI_FREEFORM_SUBTYPE_GUID_SECTION_SIZE:
+                    Pad[3] = EFI_SECTION_FREEFORM_SUBTYPE_GUID
+                    Pad[4:20] = EFI_FFS_SECTION_ALIGNMENT_PADDING_GUID
+                else:
+                    Pad[3] = EFI_SECTION_RAW
+                Buffer.extend(Pad)
+            MaxAlignment = max(MaxAlignment, Align)
+        Buffer.extend(Data)
+    return bytes(Buffer), MaxAlignment, PeSectionNum
+
+## Generate a section the way GenSec does
+#
+#   Handles the leaf sections, the PI_NONE compression section and the dummy
+#   section without type (EFI_SECTION_ALL). GUIDed sections, compressed sections
+#   and alignments taken from the PE image are left to GenSec.
+#
+#   @param  Output          Output section file
+#   @param  Input           Input files
+#   @param  Type            GenSec section type name, or None for EFI_SECTION_ALL
+#   @param  CompressionType Compression type name of EFI_SECTION_COMPRESSION
+#   @param  InputAlign      Alignment of each input file
+#   @retval True            The section was generated
+#   @retval False           The section must be generated by GenSec
+#
+def GenerateSection(Output, Input, Type=None, CompressionType=None, InputAlign=[]):
+    if not Input:
+        return False
+    AlignList = None
+    if InputAlign:
+        if len(InputAlign) != len(Input):
+            return False
+        AlignList = [_StringToAlignment(Align) for Align in InputAlign]
+        if None in AlignList:
+            return False
+    Contents = _ReadFiles(Input)
+    if Contents is None:
+        return False
+
+    if Type is None:
+        Result = _SectionContents(Contents, AlignList)
+        if Result is None:
+            return False
+        Data = Result[0]
+    elif Type == 'EFI_SECTION_COMPRESSION':
+        if CompressionType is None or CompressionType.upper() != 'PI_NONE':
+            return False
+        Result = _SectionContents(Contents, None)
+        if Result is None:
+            return False
+        Payload = Result[0]
+        Extra = pack('<IB', len(Payload), 0)
+        Data = _SectionHeader(EFI_SECTION_COMPRESSION, len(Payload), len(Extra)) + Extra + Payload
+    elif Type in LeafSectionType:
+        if len(Contents) != 1:
+            return False
+        Data = _SectionHeader(LeafSectionType[Type], len(Contents[0])) + Contents[0]
+    else:
+        return False
+    return _WriteFile(Output, Data)
+
+## Generate a version section the way GenSec does
+#
+#   @param  Output          Output section file
+#   @param  Ver             Version string
+#   @param  BuildNumber     Build number string
+#   @retval True            The section was generated
+#   @retval False           The section must be generated by GenSec
+#
+def GenerateVersionSection(Output, Ver, BuildNumber=None):
+    #
+    # GenSec gets the string through the shell, only the plain ones are
+    # guaranteed to arrive unchanged.
+    #
+    if not VersionPattern.match(Ver):
+        return False
+    VersionNumber = 0
+    if BuildNumber:
+        if not re.match(r'^-?\d+$', BuildNumber):
+            return False
+        VersionNumber = int(BuildNumber)
+    if VersionNumber < 0 or VersionNumber > 0xFFFF:
+        return False
+    String = Ver.encode('utf-16-le') + b'\0\0'
+    Data = _SectionHeader(EFI_SECTION_VERSION, len(String), 2) + pack('<H', VersionNumber) + String
+    return _WriteFile(Output, Data)
+
+## Generate an FFS file the way GenFfs does
+#
+#   @param  Output          Output FFS file
+#   @param  Input           Input section files
+#   @param  Type            GenFfs file type name
+#   @param  Guid            File name GUID string
+#   @param  Fixed           Set FFS_ATTRIB_FIXED
+#   @param  CheckSum        Set FFS_ATTRIB_CHECKSUM
+#   @param  Align           File alignment name
+#   @param  SectionAlign    Alignment of each input section
+#   @retval True            The FFS file was generated
+#   @retval False           The FFS file must be generated by GenFfs
+#
+def GenerateFfs(Output, Input, Type, Guid, Fixed=False, CheckSum=False, Align=None, SectionAlign=None):
+    if Type not in FfsFileType or not GuidPattern.match(Guid) or not Input:
+        return False
+    FfsType = FfsFileType[Type]
+    FfsAttrib = 0
+    if Fixed:
+        FfsAttrib |= FFS_ATTRIB_FIXED
+    if CheckSum:
+        FfsAttrib |= FFS_ATTRIB_CHECKSUM
+
+    FfsAlign = 0
+    if Align:
+        if Align.upper() in FfsValidAlignName:
+            FfsAlign = FfsValidAlignName.index(Align.upper())
+        elif Align not in ('1', '2', '4'):
+            return False
+
+    AlignList = []
+    for Index in range(len(Input)):
+        Alignment = 1
+        if SectionAlign and SectionAlign[Index]:
+            Alignment = _StringToAlignment(SectionAlign[Index])
+            if Alignment is None:
+                return False
+        AlignList.append(Alignment)
+
+    Contents = _ReadFiles(Input)
+    if Contents is None:
+        return False
+    Result = _SectionContents(Contents, AlignList, Fixed, True)
+    if Result is None:
+        return False
+    Body, MaxAlignment, PeSectionNum = Result
+
+    #
+    # Leave the file types with an invalid number of images to GenFfs, which
+    # reports the error.
+    #
+    if FfsType in (0x03, 0x04, 0x05) and PeSectionNum != 1:
+        return False
+    if FfsType in (0x06, 0x07, 0x08, 0x09) and PeSectionNum < 1:
+        return False
+
+    for Index in range(len(FfsValidAlign) - 1):
+        if MaxAlignment > FfsValidAlign[Index] and MaxAlignment <= FfsValidAlign[Index + 1]:
+            break
+    else:
+        Index = len(FfsValidAlign) - 1
+    FfsAlign = max(FfsAlign, Index)
+
+    if len(Body) + 24 >= MAX_FFS_SIZE:
+        FfsAttrib |= FFS_ATTRIB_LARGE_FILE
+        SizeField = b'\0\0\0'
+        ExtendedSize = pack('<Q', len(Body) + 32)
+    else:
+        FileSize = len(Body) + 24
+        SizeField = pack('<3B', FileSize & 0xff, (FileSize >> 8) & 0xff, (FileSize >> 16) & 0xff)
+        ExtendedSize = b''
+    if FfsAlign < 8:
+        Attributes = FfsAttrib | (FfsAlign << 3)
+    else:
+        Attributes = FfsAttrib | ((FfsAlign & 0x7) << 3) | FFS_ATTRIB_DATA_ALIGNMENT2
+
+    Name = PackGUID(Guid.split('-'))
+    Header = bytearray(Name + pack('<BBBB', 0, 0, FfsType, Attributes & 0xff) + SizeField + b'\0' + ExtendedSize)
+    Header[16] = _Checksum8(Header)
+    if Attributes & FFS_ATTRIB_CHECKSUM:
+        Header[17] = _Checksum8(Body)
+    else:
+        Header[17] = FFS_FIXED_CHECKSUM
+    Header[23] = EFI_FILE_STATE
+    return _WriteFile(Output, bytes(Header) + Body)
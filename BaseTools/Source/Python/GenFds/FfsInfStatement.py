@@ -15,7 +15,7 @@ from . import Rule
 import Common.LongFilePathOs as os
 from io import BytesIO
 from struct import *
-from .GenFdsGlobalVariable import GenFdsGlobalVariable
+from .GenFdsGlobalVariable import GenFdsGlobalVariable, WorkspaceLock, WorkspaceLocked
 from .Ffs import SectionSuffix,FdfFvFileTypeToFileType
 import subprocess
 import sys
@@ -76,6 +76,7 @@ class FfsInfStatement(FfsInfStatementClassObject):
     ## GetFinalTargetSuffixMap() method
     #
     #    Get final build target list
+    @WorkspaceLocked
     def GetFinalTargetSuffixMap(self):
         if not self.InfModule or not self.CurrentArch:
             return []
@@ -148,6 +149,7 @@ class FfsInfStatement(FfsInfStatementClassObject):
     #   @param  self        The object pointer
     #   @param  Dict        dictionary contains macro and value pair
     #
+    @WorkspaceLocked
     def __InfParse__(self, Dict = None, IsGenFfs=False):
 
         GenFdsGlobalVariable.VerboseLogger( " Begine parsing INf file : %s" %self.InfFileName)
@@ -598,6 +600,7 @@ class FfsInfStatement(FfsInfStatementClassObject):
     #   @param  self        The object pointer
     #   @retval list        Arch list
     #
+    @WorkspaceLocked
     def __GetPlatformArchList__(self):
 
         InfFileKey = os.path.normpath(mws.join(GenFdsGlobalVariable.WorkSpaceDir, self.InfFileName))
@@ -971,13 +974,16 @@ class FfsInfStatement(FfsInfStatementClassObject):
             if not HasGeneratedFlag:
                 UniVfrOffsetFileSection = ""
                 ModuleFileName = mws.join(GenFdsGlobalVariable.WorkSpaceDir, self.InfFileName)
-                InfData = GenFdsGlobalVariable.WorkSpace.BuildObject[PathClass(ModuleFileName), self.CurrentArch]
+                with WorkspaceLock:
+                    InfData = GenFdsGlobalVariable.WorkSpace.BuildObject[PathClass(ModuleFileName), self.CurrentArch]
+                    InfSources = InfData.Sources
+                    InfBuildType = InfData.BuildType
                 #
                 # Search the source list in InfData to find if there are .vfr file exist.
                 #
                 VfrUniBaseName = {}
                 VfrUniOffsetList = []
-                for SourceFile in InfData.Sources:
+                for SourceFile in InfSources:
                     if SourceFile.Type.upper() == ".VFR" :
                         #
                         # search the .map file to find the offset of vfr binary in the PE32+/TE file.
@@ -992,7 +998,7 @@ class FfsInfStatement(FfsInfStatementClassObject):
 
                 if len(VfrUniBaseName) > 0:
                     if IsMakefile:
-                        if InfData.BuildType != 'UEFI_HII':
+                        if InfBuildType != 'UEFI_HII':
                             UniVfrOffsetFileName = os.path.join(self.OutputPath, self.BaseName + '.offset')
                             UniVfrOffsetFileSection = os.path.join(self.OutputPath, self.BaseName + 'Offset' + '.raw')
                             UniVfrOffsetFileNameList = []
@@ -12,6 +12,7 @@
 from __future__ import absolute_import
 import Common.LongFilePathOs as os
 import subprocess
+import time
 from io import BytesIO
 from struct import *
 from . import FfsFileStatement
@@ -22,6 +23,7 @@ from Common.LongFilePathSupport import OpenLongFilePath as open
 from Common.DataType import *
 
 FV_UI_EXT_ENTY_GUID = 'A67DF1FA-8DE8-4E98-AF09-4BDF2EFFBC7C'
+FV_FILE_DIRECTORY_EXT_ENTRY_GUID = 'FB433B49-4EA7-46FF-AC73-E091AE80913E'
 
 ## generate FV
 #
@@ -55,6 +57,7 @@ class FV (object):
         self.FvForceRebase = None
         self.FvRegionInFD = None
         self.UsedSizeEnable = False
+        self.FileDirectoryEnable = False
         self.FvExtEntryTypeValue = []
         self.FvExtEntryType = []
         self.FvExtEntryData = []
@@ -72,6 +75,11 @@ class FV (object):
     #   @retval string      Generated FV file path
     #
     def AddToBuffer (self, Buffer, BaseAddress=None, BlockSize= None, BlockNum=None, ErasePloarity='1',  MacroDict = None, Flag=False):
+        # The thread waiting for the lock then finds the FV generated
+        with GenFdsGlobalVariable.GetFvLock(self.UiFvName):
+            return self._AddToBuffer(Buffer, BaseAddress, BlockSize, BlockNum, ErasePloarity, MacroDict, Flag)
+
+    def _AddToBuffer (self, Buffer, BaseAddress=None, BlockSize= None, BlockNum=None, ErasePloarity='1',  MacroDict = None, Flag=False):
         if BaseAddress is None and self.UiFvName.upper() + 'fv' in GenFdsGlobalVariable.ImageBinDict:
             return GenFdsGlobalVariable.ImageBinDict[self.UiFvName.upper() + 'fv']
         if MacroDict is None:
@@ -94,6 +102,7 @@ class FV (object):
                                 GenFdsGlobalVariable.ErrorLogger("Capsule %s in FD region can't contain a FV %s in FD region." % (self.CapsuleName, self.UiFvName.upper()))
         if not Flag:
             GenFdsGlobalVariable.InfLogger( "\nGenerating %s FV" %self.UiFvName)
+        StartTime = time.time()
         GenFdsGlobalVariable.LargeFileInFvFlags.append(False)
         FFSGuid = None
 
@@ -226,6 +235,7 @@ class FV (object):
                         self.FvAlignment = str (FvAlignmentValue)
                     FvFileObj.close()
                     GenFdsGlobalVariable.ImageBinDict[self.UiFvName.upper() + 'fv'] = FvOutputFile
+                    GenFdsGlobalVariable.FvBuildTimeDict[self.UiFvName.upper()] = time.time() - StartTime
                     GenFdsGlobalVariable.LargeFileInFvFlags.pop()
                 else:
                     GenFdsGlobalVariable.ErrorLogger("Invalid FV file %s." % self.UiFvName)
@@ -328,6 +338,10 @@ class FV (object):
                     if self.FvAttributeDict[FvAttribute].upper() in ('TRUE', '1'):
                         self.UsedSizeEnable = True
                     continue
+                if FvAttribute == "FvFileDirectoryEnable":
+                    if self.FvAttributeDict[FvAttribute].upper() in ('TRUE', '1'):
+                        self.FileDirectoryEnable = True
+                    continue
                 self.FvInfFile.append("EFI_"            + \
                                           FvAttribute       + \
                                           ' = '             + \
@@ -343,7 +357,7 @@ class FV (object):
         # Generate FV extension header file
         #
         if not self.FvNameGuid:
-            if len(self.FvExtEntryType) > 0 or self.UsedSizeEnable:
+            if len(self.FvExtEntryType) > 0 or self.UsedSizeEnable or self.FileDirectoryEnable:
                 GenFdsGlobalVariable.ErrorLogger("FV Extension Header Entries declared for %s with no FvNameGuid declaration." % (self.UiFvName))
         else:
             TotalSize = 16 + 4
@@ -358,6 +372,24 @@ class FV (object):
                 # } EFI_FIRMWARE_VOLUME_EXT_ENTRY_USED_SIZE_TYPE;
                 Buffer += pack('HHL', 8, 3, 0)
 
+            if self.FileDirectoryEnable:
+                #
+                # Create an empty EXT entry for the FV file directory,
+                # GenFv grows it and lists the FV files in it.
+                # This GUID is used: FB433B49-4EA7-46FF-AC73-E091AE80913E
+                #
+                TotalSize += (4 + 16 + 4)
+                Guid = FV_FILE_DIRECTORY_EXT_ENTRY_GUID.split('-')
+                #
+                # Layout:
+                #   EFI_FIRMWARE_VOLUME_EXT_ENTRY: size 4
+                #   GUID: size 16
+                #   UINT32 EntryCount
+                #
+                Buffer += (pack('HH', (4 + 16 + 4), 0x0002)
+                           + PackGUID(Guid)
+                           + pack('=L', 0))
+
             if self.FvNameString == 'TRUE':
                 #
                 # Create EXT entry for FV UI name
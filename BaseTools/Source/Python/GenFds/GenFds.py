@@ -18,6 +18,8 @@ from glob import glob
 from struct import unpack
 from linecache import getlines
 from io import BytesIO
+from concurrent.futures import ThreadPoolExecutor
+from multiprocessing import cpu_count
 
 import Common.LongFilePathOs as os
 from Common.TargetTxtClassObject import TargetTxtDict
@@ -33,8 +35,10 @@ from Common.BuildToolError import FatalError, GENFDS_ERROR, CODE_ERROR, FORMAT_I
 from Workspace.WorkspaceDatabase import WorkspaceDatabase
 
 from .FdfParser import FdfParser, Warning
-from .GenFdsGlobalVariable import GenFdsGlobalVariable
+from .GenFdsGlobalVariable import GenFdsGlobalVariable, LargeFileFlagStack
 from .FfsFileStatement import FileStatement
+from .FfsInfStatement import FfsInfStatement
+from .FvImageSection import FvImageSection
 import Common.DataType as DataType
 from struct import Struct
 
@@ -94,8 +98,9 @@ def resetFdsGlobalVariable():
     GenFdsGlobalVariable.CopyList   = []
     GenFdsGlobalVariable.ModuleFile = ''
     GenFdsGlobalVariable.EnableGenfdsMultiThread = True
+    GenFdsGlobalVariable.EnableGenfdsInProcess = False
 
-    GenFdsGlobalVariable.LargeFileInFvFlags = []
+    GenFdsGlobalVariable.LargeFileInFvFlags = LargeFileFlagStack()
     GenFdsGlobalVariable.EFI_FIRMWARE_FILE_SYSTEM3_GUID = '5473C07A-3DCB-4dca-BD6F-1E9689E7349A'
     GenFdsGlobalVariable.LARGE_FILE_SIZE = 0x1000000
 
@@ -103,6 +108,7 @@ def resetFdsGlobalVariable():
 
     # FvName, FdName, CapName in FDF, Image file name
     GenFdsGlobalVariable.ImageBinDict = {}
+    GenFdsGlobalVariable.FvBuildTimeDict = {}
 
 def GenFdsApi(FdsCommandDict, WorkSpaceDataBase=None):
     global Workspace
@@ -142,6 +148,7 @@ def GenFdsApi(FdsCommandDict, WorkSpaceDataBase=None):
                 GenFdsGlobalVariable.EnableGenfdsMultiThread = True
             else:
                 GenFdsGlobalVariable.EnableGenfdsMultiThread = False
+            GenFdsGlobalVariable.EnableGenfdsInProcess = bool(FdsCommandDict.get("GenfdsInProcess"))
         os.chdir(GenFdsGlobalVariable.WorkSpaceDir)
 
         # set multiple workspace
@@ -376,6 +383,9 @@ def GenFdsApi(FdsCommandDict, WorkSpaceDataBase=None):
         """Display FV space info."""
         GenFds.DisplayFvSpaceInfo(FdfParserObj)
 
+        """Display FV build time."""
+        GenFds.DisplayFvBuildTime()
+
     except Warning as X:
         EdkLogger.error(X.ToolName, FORMAT_INVALID, File=X.FileName, Line=X.LineNumber, ExtraData=X.Message, RaiseError=False)
         ReturnCode = FORMAT_INVALID
@@ -407,6 +417,7 @@ def OptionsToCommandDict(Options):
     FdsCommandDict["debug"] = Options.debug
     FdsCommandDict["Workspace"] = Options.Workspace
     FdsCommandDict["GenfdsMultiThread"] = not Options.NoGenfdsMultiThread
+    FdsCommandDict["GenfdsInProcess"] = Options.GenfdsInProcess
     FdsCommandDict["fdf_file"] = [PathClass(Options.filename)] if Options.filename else []
     FdsCommandDict["build_target"] = Options.BuildTarget
     FdsCommandDict["toolchain_tag"] = Options.ToolChain
@@ -465,6 +476,7 @@ def myOptionParser():
     Parser.add_option("--pcd", action="append", dest="OptionPcd", help="Set PCD value by command line. Format: \"PcdName=Value\" ")
     Parser.add_option("--genfds-multi-thread", action="store_true", dest="GenfdsMultiThread", default=True, help="Enable GenFds multi thread to generate ffs file.")
     Parser.add_option("--no-genfds-multi-thread", action="store_true", dest="NoGenfdsMultiThread", default=False, help="Disable GenFds multi thread to generate ffs file.")
+    Parser.add_option("--genfds-in-process", action="store_true", dest="GenfdsInProcess", default=False, help="Generate the sections and ffs files inside GenFds instead of calling GenSec and GenFfs where possible.")
 
     Options, _ = Parser.parse_args()
     return Options
@@ -518,10 +530,7 @@ class GenFds(object):
                 Buffer.close()
                 return
         elif GenFds.OnlyGenerateThisFv is None:
-            for FvObj in GenFdsGlobalVariable.FdfParser.Profile.FvDict.values():
-                Buffer = BytesIO()
-                FvObj.AddToBuffer(Buffer)
-                Buffer.close()
+            GenFds.GenFvImages(list(GenFdsGlobalVariable.FdfParser.Profile.FvDict.values()))
 
         if GenFds.OnlyGenerateThisFv is None and GenFds.OnlyGenerateThisFd is None and GenFds.OnlyGenerateThisCap is None:
             if GenFdsGlobalVariable.FdfParser.Profile.CapsuleDict != {}:
@@ -534,6 +543,135 @@ class GenFds(object):
                 for OptRomObj in GenFdsGlobalVariable.FdfParser.Profile.OptRomDict.values():
                     OptRomObj.AddToBuffer(None)
 
+    ## GenFvImages()
+    #
+    #   Generate the FV images not yet generated as part of an FD. The FVs that
+    #   share no module or nested FV/FD with any other FV are independent
+    #   and are generated by parallel threads, the others serially afterwards.
+    #
+    #   @param  FvList          FV objects to generate
+    #
+    @staticmethod
+    def GenFvImages(FvList):
+        FvList = [FvObj for FvObj in FvList if FvObj.UiFvName.upper() + 'fv' not in GenFdsGlobalVariable.ImageBinDict]
+        KeyCount = {}
+        FvKeyList = []
+        for FvObj in FvList:
+            Keys = GenFds.GetFvDependencyKeys(FvObj)
+            FvKeyList.append(Keys)
+            for Key in Keys:
+                KeyCount[Key] = KeyCount.get(Key, 0) + 1
+
+        ParallelList = []
+        SerialList = []
+        for FvObj, Keys in zip(FvList, FvKeyList):
+            if all(KeyCount[Key] == 1 for Key in Keys):
+                ParallelList.append(FvObj)
+            else:
+                SerialList.append(FvObj)
+
+        if GenFdsGlobalVariable.EnableGenfdsMultiThread and len(ParallelList) > 1:
+            with ThreadPoolExecutor(max_workers=min(len(ParallelList), cpu_count())) as Executor:
+                FutureList = [Executor.submit(GenFds.GenFvImage, FvObj) for FvObj in ParallelList]
+                for Future in FutureList:
+                    Future.result()
+        else:
+            SerialList = ParallelList + SerialList
+
+        for FvObj in SerialList:
+            GenFds.GenFvImage(FvObj)
+
+    ## GenFvImage()
+    #
+    #   @param  FvObj           FV object to generate
+    #
+    @staticmethod
+    def GenFvImage(FvObj):
+        Buffer = BytesIO()
+        FvObj.AddToBuffer(Buffer)
+        Buffer.close()
+
+    ## GetFvDependencyKeys()
+    #
+    #   Collect the names of the FV itself and of the modules, files, nested FVs
+    #   and FDs whose outputs are written while generating it, including those of
+    #   the nested FVs.
+    #
+    #   @param  FvObj           FV object
+    #   @param  Visited         Names of the nested FVs already collected
+    #   @retval set             The upper case names
+    #
+    @staticmethod
+    def GetFvDependencyKeys(FvObj, Visited=None):
+        if Visited is None:
+            Visited = set()
+        Keys = set()
+        if FvObj.UiFvName:
+            Keys.add(FvObj.UiFvName.upper())
+            Visited.add(FvObj.UiFvName.upper())
+        NestedFvList = []
+        for FfsObj in FvObj.FfsList:
+            if isinstance(FfsObj, FfsInfStatement):
+                Keys.add(FfsObj.InfFileName.upper())
+                for RuleObj in GenFds.GetInfRuleCandidates(FfsObj):
+                    NestedFvList.extend(GenFds.GetNestedFvs(getattr(RuleObj, 'SectionList', [])))
+            elif isinstance(FfsObj, FileStatement):
+                # The output directory of the file is named after its GUID
+                if FfsObj.NameGuid:
+                    Keys.add(FfsObj.NameGuid.upper())
+                if FfsObj.FvName:
+                    NestedFvList.append(FfsObj.FvName)
+                if FfsObj.FdName:
+                    Keys.add(FfsObj.FdName.upper())
+                NestedFvList.extend(GenFds.GetNestedFvs(FfsObj.SectionList))
+
+        for NestedFv in NestedFvList:
+            if not isinstance(NestedFv, str):
+                # FV defined inline in the section
+                Keys |= GenFds.GetFvDependencyKeys(NestedFv, Visited)
+                continue
+            Keys.add(NestedFv.upper())
+            NestedFvObj = GenFdsGlobalVariable.FdfParser.Profile.FvDict.get(NestedFv.upper())
+            if NestedFvObj is not None and NestedFv.upper() not in Visited:
+                Visited.add(NestedFv.upper())
+                Keys |= GenFds.GetFvDependencyKeys(NestedFvObj, Visited)
+        return Keys
+
+    ## GetNestedFvs()
+    #
+    #   Walk a section tree, including the sections encapsulated by GUIDED and
+    #   COMPRESS sections, for FV_IMAGE sections.
+    #
+    #   @param  SectionList     The sections
+    #   @retval list            The FV names, or the FV objects defined inline
+    #
+    @staticmethod
+    def GetNestedFvs(SectionList):
+        NestedFvList = []
+        for SectionObj in SectionList:
+            if isinstance(SectionObj, FvImageSection):
+                if SectionObj.FvName:
+                    NestedFvList.append(SectionObj.FvName)
+                elif SectionObj.Fv is not None:
+                    NestedFvList.append(SectionObj.Fv)
+            NestedFvList.extend(GenFds.GetNestedFvs(getattr(SectionObj, 'SectionList', None) or []))
+        return NestedFvList
+
+    ## GetInfRuleCandidates()
+    #
+    #   Get the rules an INF statement may be generated with. The module type
+    #   and arch are only known once the INF is parsed, so all the rules with
+    #   the template name of the statement are returned.
+    #
+    #   @param  FfsObj          INF statement
+    #   @retval list            The rule objects
+    #
+    @staticmethod
+    def GetInfRuleCandidates(FfsObj):
+        TemplateName = (FfsObj.Rule or '').upper()
+        return [RuleObj for RuleObj in GenFdsGlobalVariable.FdfParser.Profile.RuleDict.values()
+                if (RuleObj.TemplateName or '').upper() == TemplateName]
+
     @staticmethod
     def GenFfsMakefile(OutputDir, FdfParserObject, WorkSpace, ArchList, GlobalData):
         GenFdsGlobalVariable.SetEnv(FdfParserObject, WorkSpace, ArchList, GlobalData)
@@ -638,6 +776,18 @@ class GenFds(object):
                                            + str(UsedSizeValue) + ' (' + hex(UsedSizeValue) + ')' + ' used, '\
                                            + str(FreeSizeValue) + ' (' + hex(FreeSizeValue) + ')' + ' free')
 
+    ## DisplayFvBuildTime()
+    #
+    #   Print the time spent generating each FV, longest first.
+    #
+    @staticmethod
+    def DisplayFvBuildTime():
+        if not GenFdsGlobalVariable.FvBuildTimeDict:
+            return
+        GenFdsGlobalVariable.InfLogger('\nFV Build Time')
+        for Name, Seconds in sorted(GenFdsGlobalVariable.FvBuildTimeDict.items(), key=lambda Item: Item[1], reverse=True):
+            GenFdsGlobalVariable.InfLogger('%s %.2f seconds' % (Name, Seconds))
+
     ## PreprocessImage()
     #
     #   @param  BuildDb         Database from build meta data files
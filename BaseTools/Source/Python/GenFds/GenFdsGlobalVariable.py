@@ -18,6 +18,7 @@ from sys import stdout
 from subprocess import PIPE,Popen
 from struct import Struct
 from array import array
+from threading import local, Lock, RLock
 
 from Common.BuildToolError import COMMAND_FAILURE,GENFDS_ERROR
 from Common import EdkLogger
@@ -33,6 +34,46 @@ from Common.MultipleWorkspace import MultipleWorkspace as mws
 import Common.GlobalData as GlobalData
 from Common.BuildToolError import *
 from AutoGen.AutoGen import CalculatePriorityValue
+from . import FfsEncoder
+
+## Per-thread flag stack
+#
+#   Independent FVs are generated by parallel threads, and each of them tracks
+#   its own (possibly nested) large file flags.
+#
+class LargeFileFlagStack(local):
+    def __init__(self):
+        self.Flags = []
+
+    def append(self, Flag):
+        self.Flags.append(Flag)
+
+    def pop(self):
+        return self.Flags.pop()
+
+    def __getitem__(self, Index):
+        return self.Flags[Index]
+
+    def __setitem__(self, Index, Flag):
+        self.Flags[Index] = Flag
+
+    def __len__(self):
+        return len(self.Flags)
+
+## Lock of the workspace database
+#
+#   The build data objects parse their meta files on first use, and the
+#   workspace database they share is not thread-safe, so the threads generating
+#   independent FVs use them one at a time.
+#
+WorkspaceLock = RLock()
+
+## Decorator running a function which uses the workspace database under its lock
+def WorkspaceLocked(Function):
+    def LockedFunction(*Args, **KwArgs):
+        with WorkspaceLock:
+            return Function(*Args, **KwArgs)
+    return LockedFunction
 
 ## Global variables
 #
@@ -73,6 +114,7 @@ class GenFdsGlobalVariable:
     CopyList   = []
     ModuleFile = ''
     EnableGenfdsMultiThread = True
+    EnableGenfdsInProcess = False
 
     #
     # The list whose element are flags to indicate if large FFS or SECTION files exist in FV.
@@ -81,9 +123,9 @@ class GenFdsGlobalVariable:
     # if it is greater than 0xFFFFFF, the tail flag in list is set to true,
     # and EFI_FIRMWARE_FILE_SYSTEM3_GUID is passed to C GenFv.
     # At the end of generation of FV, pop the flag.
-    # List is used as a stack to handle nested FV generation.
+    # List is used as a stack to handle nested FV generation, one per thread.
     #
-    LargeFileInFvFlags = []
+    LargeFileInFvFlags = LargeFileFlagStack()
     EFI_FIRMWARE_FILE_SYSTEM3_GUID = '5473C07A-3DCB-4dca-BD6F-1E9689E7349A'
     LARGE_FILE_SIZE = 0x1000000
 
@@ -92,6 +134,26 @@ class GenFdsGlobalVariable:
     # FvName, FdName, CapName in FDF, Image file name
     ImageBinDict = {}
 
+    # FvName in FDF, seconds spent generating the FV
+    FvBuildTimeDict = {}
+
+    # FvName in FDF, lock held by the thread generating the FV
+    FvLockDict = {}
+    FvLockDictLock = Lock()
+
+    ## GetFvLock()
+    #
+    #   Get the lock that keeps two threads from generating the same FV at once,
+    #   for example a FV nested in two FVs generated in parallel.
+    #
+    #   @param  FvName          The name of the FV
+    #   @retval RLock           The lock of the FV
+    #
+    @staticmethod
+    def GetFvLock(FvName):
+        with GenFdsGlobalVariable.FvLockDictLock:
+            return GenFdsGlobalVariable.FvLockDict.setdefault(FvName.upper(), RLock())
+
     ## LoadBuildRule
     #
     @staticmethod
@@ -196,6 +258,7 @@ class GenFdsGlobalVariable:
     #    @param Arch: current arch
     #
     @staticmethod
+    @WorkspaceLocked
     def GetModuleCodaTargetList(Inf, Arch):
         BuildRules = GenFdsGlobalVariable.GetBuildRules(Inf, Arch)
         if not BuildRules:
@@ -332,6 +395,7 @@ class GenFdsGlobalVariable:
         GenFdsGlobalVariable.ActivePlatform = GlobalData.gActivePlatform
         GenFdsGlobalVariable.ConfDir  = GlobalData.gConfDirectory
         GenFdsGlobalVariable.EnableGenfdsMultiThread = GlobalData.gEnableGenfdsMultiThread
+        GenFdsGlobalVariable.EnableGenfdsInProcess = GlobalData.gEnableGenfdsInProcess
         for Arch in ArchList:
             GenFdsGlobalVariable.OutputDirDict[Arch] = os.path.normpath(
                 os.path.join(GlobalData.gWorkspace,
@@ -501,6 +565,8 @@ class GenFdsGlobalVariable:
             else:
                 if not GenFdsGlobalVariable.NeedsUpdate(Output, list(Input) + [CommandFile]):
                     return
+                if GenFdsGlobalVariable.EnableGenfdsInProcess and FfsEncoder.GenerateVersionSection(Output, Ver, BuildNumber):
+                    return
                 GenFdsGlobalVariable.CallExternalTool(Cmd, "Failed to generate section")
         else:
             Cmd += ("-o", Output)
@@ -516,7 +582,9 @@ class GenFdsGlobalVariable:
                     GenFdsGlobalVariable.SecCmdList.append(' '.join(Cmd).strip())
             elif GenFdsGlobalVariable.NeedsUpdate(Output, list(Input) + [CommandFile]):
                 GenFdsGlobalVariable.DebugLogger(EdkLogger.DEBUG_5, "%s needs update because of newer %s" % (Output, Input))
-                GenFdsGlobalVariable.CallExternalTool(Cmd, "Failed to generate section")
+                if not (GenFdsGlobalVariable.EnableGenfdsInProcess and not Guid and not DummyFile and
+                        FfsEncoder.GenerateSection(Output, Input, Type, CompressionType, InputAlign)):
+                    GenFdsGlobalVariable.CallExternalTool(Cmd, "Failed to generate section")
                 if (os.path.getsize(Output) >= GenFdsGlobalVariable.LARGE_FILE_SIZE and
                     GenFdsGlobalVariable.LargeFileInFvFlags):
                     GenFdsGlobalVariable.LargeFileInFvFlags[-1] = True
@@ -572,6 +640,8 @@ class GenFdsGlobalVariable:
         else:
             if not GenFdsGlobalVariable.NeedsUpdate(Output, list(Input) + [CommandFile]):
                 return
+            if GenFdsGlobalVariable.EnableGenfdsInProcess and FfsEncoder.GenerateFfs(Output, Input, Type, Guid, Fixed, CheckSum, Align, SectionAlign):
+                return
             GenFdsGlobalVariable.CallExternalTool(Cmd, "Failed to generate FFS")
 
     @staticmethod
@@ -802,6 +872,7 @@ class GenFdsGlobalVariable:
     #   @param  PcdPattern           pattern that labels a PCD.
     #
     @staticmethod
+    @WorkspaceLocked
     def GetPcdValue (PcdPattern):
         if PcdPattern is None:
             return None
@@ -850,6 +921,7 @@ class GenFdsGlobalVariable:
 #  @param  CurrentArchList  Arch list
 #  @param  NameGuid         The Guid name
 #
+@WorkspaceLocked
 def FindExtendTool(KeyStringList, CurrentArchList, NameGuid):
     if GenFdsGlobalVariable.GuidToolDefinition:
         if NameGuid in GenFdsGlobalVariable.GuidToolDefinition:
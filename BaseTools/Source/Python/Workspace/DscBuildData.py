@@ -829,6 +829,19 @@ class DscBuildData(PlatformBuildClassObject):
             self._Modules[ModuleFile] = Module
         return self._Modules
 
+    ## Retrieve the INF files of the modules and libraries, without parsing them
+    @cached_property
+    def InfList(self):
+        RetVal = []
+        Macros = self._Macros
+        for Type in (MODEL_META_DATA_COMPONENT, MODEL_EFI_LIBRARY_CLASS, MODEL_EFI_LIBRARY_INSTANCE):
+            for Record in self._RawData[Type, self._Arch]:
+                File = Record[1] if Type == MODEL_EFI_LIBRARY_CLASS else Record[0]
+                File = PathClass(NormPath(File, Macros), GlobalData.gWorkspace, Arch=self._Arch)
+                if File.Validate('.inf')[0] == 0:
+                    RetVal.append(File)
+        return RetVal
+
     ## Retrieve all possible library instances used in this platform
     @property
     def LibraryInstances(self):
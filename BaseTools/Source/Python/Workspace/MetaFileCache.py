@@ -0,0 +1,218 @@
+## @file
+# This file is used to cache the parse result of INF and DEC files on disk
+#
+# The records an INF or DEC file is parsed into depend on nothing but the file
+# content and a few global settings, so they are saved in the build cache
+# directory and loaded by the next build, or by the AutoGen worker processes,
+# instead of parsing the file again.
+#
+# Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+# SPDX-License-Identifier: BSD-2-Clause-Patent
+#
+
+##
+# Import Modules
+#
+from __future__ import absolute_import
+import Common.LongFilePathOs as os
+import sys
+import uuid
+import pickle
+import hashlib
+from multiprocessing import Pool, cpu_count
+
+import Common.EdkLogger as EdkLogger
+import Common.GlobalData as GlobalData
+from Common.LongFilePathSupport import OpenLongFilePath as open
+from Common.StringUtils import NormPath
+from Common.Misc import PathClass
+from CommonDataClass.DataClass import MODEL_FILE_INF, MODEL_FILE_DEC, MODEL_META_DATA_PACKAGE
+
+## Version of the cache entry format, change it if the saved data changes
+_CACHE_VERSION_ = 1
+
+## Parser attributes describing where the file comes from, not what it contains
+_PARSER_CONTEXT_ = ('_Table', '_RawTable', 'MetaFile', '_FileDir', '_Arch', '_FileType', '_Owner', '_From')
+
+## Hash of the parser code, computed once
+_ToolHash = None
+
+## Get the directory of the cache
+#
+#   @retval     The cache directory, or None if the cache is not available
+#
+def GetCacheDir():
+    if not os.path.isabs(GlobalData.gDatabasePath):
+        return None
+    return os.path.join(os.path.dirname(GlobalData.gDatabasePath), 'MetaFileCache')
+
+## Check if the parse result of a file can be cached
+def IsCacheable(FileType):
+    return FileType in (MODEL_FILE_INF, MODEL_FILE_DEC)
+
+## Hash the code of the parser, so that a BaseTools update drops the old entries
+def _GetToolHash():
+    global _ToolHash
+    if _ToolHash is None:
+        Hash = hashlib.sha1(str(_CACHE_VERSION_).encode())
+        for Module in ('Workspace.MetaFileParser', 'Workspace.MetaFileTable', 'Workspace.MetaFileCommentParser'):
+            File = getattr(sys.modules.get(Module), '__file__', None)
+            if File and os.path.isfile(File):
+                with open(File, 'rb') as Fd:
+                    Hash.update(Fd.read())
+        _ToolHash = Hash.hexdigest()
+    return _ToolHash
+
+## Get the path of the cache entry of a meta file
+#
+#   @param      ParserClass     The class of the parser
+#   @param      MetaFile        The meta file
+#
+#   @retval     The path of the cache entry, or None if the file can't be read
+#
+def GetCacheFile(ParserClass, MetaFile):
+    CacheDir = GetCacheDir()
+    if CacheDir is None:
+        return None
+    try:
+        with open(str(MetaFile), 'rb') as Fd:
+            Content = Fd.read()
+    except:
+        return None
+    CheckUsage = bool(GlobalData.gOptions and getattr(GlobalData.gOptions, 'CheckUsage', False))
+    Hash = hashlib.sha1(_GetToolHash().encode())
+    Hash.update(ParserClass.__name__.encode())
+    Hash.update(str(MetaFile).encode())
+    Hash.update(str(sorted(GlobalData.gGlobalDefines)).encode())
+    Hash.update(str(CheckUsage).encode())
+    Hash.update(Content)
+    return os.path.join(CacheDir, Hash.hexdigest() + '.pkl')
+
+## Load the parse result of a meta file from the cache
+#
+#   @param      Parser          The parser of the file, which has not parsed it yet
+#
+#   @retval     True            The records are stored in the table of the parser
+#   @retval     False           No usable cache entry
+#
+def Load(Parser):
+    if not IsCacheable(Parser._FileType):
+        return False
+    CacheFile = GetCacheFile(type(Parser), Parser.MetaFile)
+    if CacheFile is None or not os.path.isfile(CacheFile):
+        return False
+    try:
+        with open(CacheFile, 'rb') as Fd:
+            State, RecordList = pickle.load(Fd)
+    except:
+        EdkLogger.debug(EdkLogger.DEBUG_5, "Ignore broken cache entry %s" % CacheFile)
+        return False
+    Parser.__dict__.update(State)
+    Parser._Table.RestoreContent(RecordList)
+    Parser._Done()
+    return True
+
+## Save the parse result of a meta file to the cache
+#
+#   @param      Parser          The parser of the file, which has just parsed it
+#
+def Save(Parser):
+    if not IsCacheable(Parser._FileType):
+        return
+    CacheFile = GetCacheFile(type(Parser), Parser.MetaFile)
+    if CacheFile is None or os.path.isfile(CacheFile):
+        return
+    State = dict((Name, Value) for Name, Value in vars(Parser).items() if Name not in _PARSER_CONTEXT_)
+    TempFile = '%s.%s' % (CacheFile, uuid.uuid4().hex)
+    try:
+        if not os.path.isdir(os.path.dirname(CacheFile)):
+            os.makedirs(os.path.dirname(CacheFile))
+        with open(TempFile, 'wb') as Fd:
+            pickle.dump((State, Parser._Table.GetContent()), Fd, pickle.HIGHEST_PROTOCOL)
+        # another process may have saved the same entry meanwhile
+        if os.path.isfile(CacheFile):
+            os.remove(TempFile)
+        else:
+            os.rename(TempFile, CacheFile)
+    except:
+        EdkLogger.debug(EdkLogger.DEBUG_5, "Failed to save cache entry %s" % CacheFile)
+        if os.path.isfile(TempFile):
+            try:
+                os.remove(TempFile)
+            except:
+                pass
+
+## Set up the global settings of a worker process of PreParse()
+def _InitWorker(Workspace, GlobalDefines, DatabasePath, Options):
+    GlobalData.gWorkspace = Workspace
+    GlobalData.gGlobalDefines = GlobalDefines
+    GlobalData.gDatabasePath = DatabasePath
+    GlobalData.gOptions = Options
+    # errors are reported by the main process when it parses the file again
+    EdkLogger.SetLevel(EdkLogger.SILENT)
+
+## Parse a meta file in a worker process of PreParse(), which saves the result
+#
+#   @retval     The [Packages] of an INF file
+#
+def _ParseWorker(Task):
+    from Workspace.WorkspaceDatabase import WorkspaceDatabase
+    from Workspace.MetaFileTable import MetaFileStorage
+    MetaFile, FileType = Task
+    try:
+        Db = WorkspaceDatabase()
+        Parser = Db.BuildObject._FILE_PARSER_[FileType](MetaFile, FileType, None, MetaFileStorage(Db, MetaFile, FileType))
+        Parser.StartParse()
+        if FileType == MODEL_FILE_INF:
+            return [Record[0] for Record in Parser._RawTable.Query(MODEL_META_DATA_PACKAGE)]
+    except:
+        pass
+    return []
+
+## Parse the INF files of a platform, and the DEC files they depend on, in parallel
+#
+# The files which have no cache entry are parsed by a pool of worker
+# processes, then the build parses them one by one from the cache.
+#
+#   @param      InfList         The INF files the platform uses
+#
+def PreParse(InfList):
+    if GetCacheDir() is None or cpu_count() < 2:
+        return
+    from Workspace.MetaFileParser import MetaFileParser, InfParser, DecParser
+
+    def _GetMissList(FileList, ParserClass):
+        MissList = []
+        Checked = set()
+        for MetaFile in FileList:
+            if MetaFile in MetaFileParser.MetaFiles or MetaFile in Checked:
+                continue
+            Checked.add(MetaFile)
+            CacheFile = GetCacheFile(ParserClass, MetaFile)
+            if CacheFile is not None and not os.path.isfile(CacheFile):
+                MissList.append(MetaFile)
+        return MissList
+
+    InfMissList = _GetMissList(InfList, InfParser)
+    if len(InfMissList) < 2:
+        return
+
+    EdkLogger.verbose("Parsing %d INF files in parallel" % len(InfMissList))
+    WorkerPool = Pool(min(cpu_count(), len(InfMissList)), _InitWorker,
+                      (GlobalData.gWorkspace, GlobalData.gGlobalDefines, GlobalData.gDatabasePath, GlobalData.gOptions))
+    try:
+        DecList = []
+        for PackageList in WorkerPool.map(_ParseWorker, [(Inf, MODEL_FILE_INF) for Inf in InfMissList]):
+            for Package in PackageList:
+                if '$(' in Package:
+                    continue
+                Dec = PathClass(NormPath(Package), GlobalData.gWorkspace)
+                if Dec.Validate('.dec')[0] == 0:
+                    DecList.append(Dec)
+        DecMissList = _GetMissList(DecList, DecParser)
+        if DecMissList:
+            EdkLogger.verbose("Parsing %d DEC files in parallel" % len(DecMissList))
+            WorkerPool.map(_ParseWorker, [(Dec, MODEL_FILE_DEC) for Dec in DecMissList])
+    finally:
+        WorkerPool.close()
+        WorkerPool.join()
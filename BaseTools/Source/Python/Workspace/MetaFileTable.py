@@ -64,6 +64,24 @@ class MetaFileTable():
     def GetAll(self):
         return [item for item in self.CurrentContent if item[0] >= 0 and item[-1]>=0]
 
+    ## Get the records stored by the parser, without the end flag
+    def GetContent(self):
+        return [item for item in self.CurrentContent if item[0] >= 0]
+
+    ## Store the records got from GetContent() of a previous parse
+    #
+    # The records get new IDs in this table, so BelongsToItem is translated to
+    # the new ID of the owner record.
+    #
+    # @param RecordList:     The records to store
+    #
+    def RestoreContent(self, RecordList):
+        IdMap = {-1: -1}
+        for Record in RecordList:
+            Args = list(Record[1:])
+            Args[6] = IdMap.get(Args[6], Args[6])
+            IdMap[Record[0]] = self.Insert(*Args)
+
 ## Python class representation of table storing module data
 class ModuleTable(MetaFileTable):
     _COLUMN_ = '''
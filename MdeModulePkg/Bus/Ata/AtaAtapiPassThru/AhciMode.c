@@ -1489,28 +1489,25 @@ AhciStopCommand (
 }
 
 /**
-  Start command for give slot on specific port.
+  Start the command list processing of specific port, without issuing any
+  command.
 
   @param  PciIo              The PCI IO protocol instance.
   @param  Port               The number of port.
-  @param  CommandSlot        The number of Command Slot.
   @param  Timeout            The timeout value of start, uses 100ns as a unit.
 
-  @retval EFI_DEVICE_ERROR   The command start unsuccessfully.
+  @retval EFI_DEVICE_ERROR   The port start unsuccessfully.
   @retval EFI_TIMEOUT        The operation is time out.
-  @retval EFI_SUCCESS        The command start successfully.
+  @retval EFI_SUCCESS        The port start successfully.
 
 **/
 EFI_STATUS
-EFIAPI
-AhciStartCommand (
+AhciStartPort (
   IN  EFI_PCI_IO_PROTOCOL       *PciIo,
   IN  UINT8                     Port,
-  IN  UINT8                     CommandSlot,
   IN  UINT64                    Timeout
   )
 {
-  UINT32     CmdSlotBit;
   EFI_STATUS Status;
   UINT32     PortStatus;
   UINT32     StartCmd;
@@ -1523,8 +1520,6 @@ AhciStartCommand (
   //
   Capability = AhciReadReg(PciIo, EFI_AHCI_CAPABILITY_OFFSET);
 
-  CmdSlotBit = (UINT32) (1 << CommandSlot);
-
   AhciClearPortStatus (
     PciIo,
     Port
@@ -1571,6 +1566,42 @@ AhciStartCommand (
   Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_CMD;
   AhciOrReg (PciIo, Offset, EFI_AHCI_PORT_CMD_ST | StartCmd);
 
+  return EFI_SUCCESS;
+}
+
+/**
+  Start command for give slot on specific port.
+
+  @param  PciIo              The PCI IO protocol instance.
+  @param  Port               The number of port.
+  @param  CommandSlot        The number of Command Slot.
+  @param  Timeout            The timeout value of start, uses 100ns as a unit.
+
+  @retval EFI_DEVICE_ERROR   The command start unsuccessfully.
+  @retval EFI_TIMEOUT        The operation is time out.
+  @retval EFI_SUCCESS        The command start successfully.
+
+**/
+EFI_STATUS
+EFIAPI
+AhciStartCommand (
+  IN  EFI_PCI_IO_PROTOCOL       *PciIo,
+  IN  UINT8                     Port,
+  IN  UINT8                     CommandSlot,
+  IN  UINT64                    Timeout
+  )
+{
+  UINT32     CmdSlotBit;
+  EFI_STATUS Status;
+  UINT32     Offset;
+
+  CmdSlotBit = (UINT32) (1 << CommandSlot);
+
+  Status = AhciStartPort (PciIo, Port, Timeout);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
   //
   // Setting the command
   //
@@ -2121,6 +2152,86 @@ AhciPacketCommandExecute (
   return Status;
 }
 
+/**
+  Allocate the command tables of queued commands, if the HBA supports Native
+  Command Queuing. Commands are not queued if they cannot be allocated.
+
+  @param  PciIo                 The PCI IO protocol instance.
+  @param  AhciRegisters         The pointer to the EFI_AHCI_REGISTERS.
+  @param  MaxCommandSlotNumber  The number of command slots per port.
+  @param  Support64Bit          Whether the HBA supports 64-bit addressing.
+
+**/
+VOID
+AhciCreateNcqCommandTables (
+  IN     EFI_PCI_IO_PROTOCOL    *PciIo,
+  IN OUT EFI_AHCI_REGISTERS     *AhciRegisters,
+  IN     UINT8                  MaxCommandSlotNumber,
+  IN     BOOLEAN                Support64Bit
+  )
+{
+  EFI_STATUS            Status;
+  UINTN                 Bytes;
+  VOID                  *Buffer;
+  VOID                  *Map;
+  UINT64                MaxNcqCommandTableSize;
+  EFI_PHYSICAL_ADDRESS  AhciNcqCommandTablePciAddr;
+
+  AhciRegisters->NcqSlotNumber = 0;
+  if ((AhciReadReg (PciIo, EFI_AHCI_CAPABILITY_OFFSET) & EFI_AHCI_CAP_SNCQ) == 0) {
+    return;
+  }
+
+  Buffer = NULL;
+  MaxNcqCommandTableSize = MaxCommandSlotNumber * sizeof (EFI_AHCI_NCQ_COMMAND_TABLE);
+  Status = PciIo->AllocateBuffer (
+                    PciIo,
+                    AllocateAnyPages,
+                    EfiBootServicesData,
+                    EFI_SIZE_TO_PAGES ((UINTN) MaxNcqCommandTableSize),
+                    &Buffer,
+                    0
+                    );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_WARN, "AHCI: Native Command Queuing disabled - %r\n", Status));
+    return;
+  }
+
+  ZeroMem (Buffer, (UINTN) MaxNcqCommandTableSize);
+  Bytes  = (UINTN) MaxNcqCommandTableSize;
+
+  Status = PciIo->Map (
+                    PciIo,
+                    EfiPciIoOperationBusMasterCommonBuffer,
+                    Buffer,
+                    &Bytes,
+                    &AhciNcqCommandTablePciAddr,
+                    &Map
+                    );
+  if (!EFI_ERROR (Status) &&
+      ((Bytes != MaxNcqCommandTableSize) ||
+       ((!Support64Bit) && (AhciNcqCommandTablePciAddr > 0x100000000ULL)))) {
+    PciIo->Unmap (PciIo, Map);
+    Status = EFI_OUT_OF_RESOURCES;
+  }
+
+  if (EFI_ERROR (Status)) {
+    PciIo->FreeBuffer (
+             PciIo,
+             EFI_SIZE_TO_PAGES ((UINTN) MaxNcqCommandTableSize),
+             Buffer
+             );
+    DEBUG ((DEBUG_WARN, "AHCI: Native Command Queuing disabled - %r\n", Status));
+    return;
+  }
+
+  AhciRegisters->AhciNcqCommandTable        = Buffer;
+  AhciRegisters->AhciNcqCommandTablePciAddr = (EFI_AHCI_NCQ_COMMAND_TABLE *)(UINTN)AhciNcqCommandTablePciAddr;
+  AhciRegisters->MaxNcqCommandTableSize     = MaxNcqCommandTableSize;
+  AhciRegisters->MapNcqCommandTable         = Map;
+  AhciRegisters->NcqSlotNumber              = MaxCommandSlotNumber;
+}
+
 /**
   Allocate transfer-related data struct which is used at AHCI mode.
 
@@ -2328,6 +2439,8 @@ AhciCreateTransferDescriptor (
   }
   AhciRegisters->AhciCommandTablePciAddr = (EFI_AHCI_COMMAND_TABLE *)(UINTN)AhciCommandTablePciAddr;
 
+  AhciCreateNcqCommandTables (PciIo, AhciRegisters, MaxCommandSlotNumber, Support64Bit);
+
   return EFI_SUCCESS;
   //
   // Map error or unable to map the whole CmdList buffer into a contiguous region.
@@ -2706,6 +2819,483 @@ AhciPuisEnable (
   return Status;
 }
 
+/**
+  Find the hard disk a non-blocking task is sent to.
+
+  @param[in]  Instance        A pointer to the ATA_ATAPI_PASS_THRU_INSTANCE instance.
+  @param[in]  Port            The port number of the device.
+  @param[in]  PortMultiplier  The port multiplier port number of the device.
+
+  @return The device info of the hard disk, or NULL if there is none.
+
+**/
+EFI_ATA_DEVICE_INFO *
+AhciNcqGetDevice (
+  IN  ATA_ATAPI_PASS_THRU_INSTANCE  *Instance,
+  IN  UINT16                        Port,
+  IN  UINT16                        PortMultiplier
+  )
+{
+  LIST_ENTRY  *Node;
+
+  Node = SearchDeviceInfoList (Instance, Port, PortMultiplier, EfiIdeHarddisk);
+  if (Node == NULL) {
+    return NULL;
+  }
+
+  return ATA_ATAPI_DEVICE_INFO_FROM_THIS (Node);
+}
+
+/**
+  Decide how many commands may be queued to a hard disk, from its IDENTIFY data.
+
+  @param[in]  Instance        A pointer to the ATA_ATAPI_PASS_THRU_INSTANCE instance.
+  @param[in]  Port            The port number of the device.
+  @param[in]  PortMultiplier  The port multiplier port number of the device.
+  @param[in]  IdentifyData    The IDENTIFY data of the device.
+
+**/
+VOID
+AhciNcqInitializeDevice (
+  IN  ATA_ATAPI_PASS_THRU_INSTANCE  *Instance,
+  IN  UINT16                        Port,
+  IN  UINT16                        PortMultiplier,
+  IN  EFI_IDENTIFY_DATA             *IdentifyData
+  )
+{
+  EFI_ATA_DEVICE_INFO  *DeviceInfo;
+  UINT16               SataCapabilities;
+
+  DeviceInfo = AhciNcqGetDevice (Instance, Port, PortMultiplier);
+  if ((DeviceInfo == NULL) || (Instance->AhciRegisters.NcqSlotNumber == 0)) {
+    return;
+  }
+
+  //
+  // Word 76 BIT8 reports NCQ support, word 75 the queue depth minus one.
+  // Queued commands always use 48-bit addressing.
+  //
+  SataCapabilities = IdentifyData->AtaData.serial_ata_capabilities;
+  if ((SataCapabilities == 0) || (SataCapabilities == 0xFFFF) ||
+      ((SataCapabilities & BIT8) == 0) ||
+      ((IdentifyData->AtaData.command_set_supported_83 & BIT10) == 0)) {
+    return;
+  }
+
+  DeviceInfo->NcqQueueDepth = (UINT8) MIN (
+                                        (IdentifyData->AtaData.queue_depth & 0x1F) + 1,
+                                        Instance->AhciRegisters.NcqSlotNumber
+                                        );
+  DEBUG ((
+    DEBUG_INFO,
+    "port [%d] port multiplier [%d] queues up to %d commands\n",
+    Port,
+    PortMultiplier,
+    DeviceInfo->NcqQueueDepth
+    ));
+}
+
+/**
+  Check whether a non-blocking task can be issued as a queued command now, and
+  find the command slot to issue it in.
+
+  Only DMA EXT reads and writes are queued, as READ/WRITE FPDMA QUEUED.
+
+  @param[in]   Instance  A pointer to the ATA_ATAPI_PASS_THRU_INSTANCE instance.
+  @param[in]   Task      The task to check.
+  @param[out]  Slot      The free command slot to use.
+
+  @retval TRUE   The task can be issued in Slot.
+  @retval FALSE  The task must wait, or cannot be queued at all.
+
+**/
+BOOLEAN
+AhciNcqCanQueue (
+  IN  ATA_ATAPI_PASS_THRU_INSTANCE  *Instance,
+  IN  ATA_NONBLOCK_TASK             *Task,
+  OUT UINT8                         *Slot
+  )
+{
+  EFI_ATA_PASS_THRU_COMMAND_PACKET  *Packet;
+  EFI_ATA_DEVICE_INFO               *DeviceInfo;
+  UINT32                            DataCount;
+  INTN                              FreeSlot;
+
+  Packet = Task->Packet;
+  if ((Packet->Protocol == EFI_ATA_PASS_THRU_PROTOCOL_UDMA_DATA_IN) &&
+      (Packet->Acb->AtaCommand == ATA_CMD_READ_DMA_EXT)) {
+    DataCount = Packet->InTransferLength;
+  } else if ((Packet->Protocol == EFI_ATA_PASS_THRU_PROTOCOL_UDMA_DATA_OUT) &&
+             (Packet->Acb->AtaCommand == ATA_CMD_WRITE_DMA_EXT)) {
+    DataCount = Packet->OutTransferLength;
+  } else {
+    return FALSE;
+  }
+
+  if ((DataCount == 0) ||
+      (DataCount > (UINT64) EFI_AHCI_NCQ_MAX_PRDT * EFI_AHCI_MAX_DATA_PER_PRDT)) {
+    return FALSE;
+  }
+
+  //
+  // Queued commands in flight must all target the same device, since the
+  // command list is shared by all ports.
+  //
+  if ((Instance->NcqActiveSlots != 0) &&
+      ((Task->Port != Instance->NcqPort) || (Task->PortMultiplier != Instance->NcqPortMultiplier))) {
+    return FALSE;
+  }
+
+  DeviceInfo = AhciNcqGetDevice (Instance, Task->Port, Task->PortMultiplier);
+  if ((DeviceInfo == NULL) || (DeviceInfo->NcqQueueDepth == 0)) {
+    return FALSE;
+  }
+
+  FreeSlot = LowBitSet32 (~Instance->NcqActiveSlots);
+  if ((FreeSlot < 0) || (FreeSlot >= DeviceInfo->NcqQueueDepth)) {
+    return FALSE;
+  }
+
+  *Slot = (UINT8) FreeSlot;
+  return TRUE;
+}
+
+/**
+  Issue a non-blocking task as a queued command.
+
+  @param[in]  Instance  A pointer to the ATA_ATAPI_PASS_THRU_INSTANCE instance.
+  @param[in]  Task      The task to issue.
+  @param[in]  Slot      The free command slot to issue it in, which is also
+                        its tag.
+
+  @retval EFI_SUCCESS          The command is issued.
+  @retval EFI_BAD_BUFFER_SIZE  The data buffer cannot be mapped.
+  @return others               The port cannot be started.
+
+**/
+EFI_STATUS
+AhciNcqStartTask (
+  IN  ATA_ATAPI_PASS_THRU_INSTANCE  *Instance,
+  IN  ATA_NONBLOCK_TASK             *Task,
+  IN  UINT8                         Slot
+  )
+{
+  EFI_STATUS                        Status;
+  EFI_PCI_IO_PROTOCOL               *PciIo;
+  EFI_AHCI_REGISTERS                *AhciRegisters;
+  EFI_ATA_PASS_THRU_COMMAND_PACKET  *Packet;
+  EFI_AHCI_NCQ_COMMAND_TABLE        *CommandTable;
+  EFI_AHCI_COMMAND_LIST             *CommandList;
+  EFI_AHCI_COMMAND_FIS              CFis;
+  EFI_PCI_IO_PROTOCOL_OPERATION     Flag;
+  EFI_PHYSICAL_ADDRESS              PhyAddr;
+  BOOLEAN                           Read;
+  VOID                              *MemoryAddr;
+  UINT32                            DataCount;
+  UINTN                             MapLength;
+  UINT32                            PrdtNumber;
+  UINT32                            PrdtIndex;
+  UINT8                             Port;
+  UINT8                             PortMultiplier;
+  UINT32                            Offset;
+  DATA_64                           Data64;
+
+  PciIo          = Instance->PciIo;
+  AhciRegisters  = &Instance->AhciRegisters;
+  Packet         = Task->Packet;
+  Port           = (UINT8) Task->Port;
+  PortMultiplier = (UINT8) ((Task->PortMultiplier == 0xFFFF) ? 0 : Task->PortMultiplier);
+
+  Read = (BOOLEAN) (Packet->Protocol == EFI_ATA_PASS_THRU_PROTOCOL_UDMA_DATA_IN);
+  if (Read) {
+    Flag       = EfiPciIoOperationBusMasterWrite;
+    MemoryAddr = Packet->InDataBuffer;
+    DataCount  = Packet->InTransferLength;
+  } else {
+    Flag       = EfiPciIoOperationBusMasterRead;
+    MemoryAddr = Packet->OutDataBuffer;
+    DataCount  = Packet->OutTransferLength;
+  }
+
+  MapLength = DataCount;
+  Status = PciIo->Map (
+                    PciIo,
+                    Flag,
+                    MemoryAddr,
+                    &MapLength,
+                    &PhyAddr,
+                    &Task->Map
+                    );
+  if (EFI_ERROR (Status) || (DataCount != MapLength)) {
+    if (!EFI_ERROR (Status)) {
+      PciIo->Unmap (PciIo, Task->Map);
+    }
+    Task->Map = NULL;
+    return EFI_BAD_BUFFER_SIZE;
+  }
+
+  //
+  // READ/WRITE FPDMA QUEUED carry the sector count in the feature registers,
+  // the tag in the sector count register, and FUA in bit 7 of the device
+  // register.
+  //
+  AhciBuildCommandFis (&CFis, Packet->Acb);
+  CFis.AhciCFisCmd         = Read ? ATA_CMD_READ_FPDMA_QUEUED : ATA_CMD_WRITE_FPDMA_QUEUED;
+  CFis.AhciCFisFeature     = Packet->Acb->AtaSectorCount;
+  CFis.AhciCFisFeatureExp  = Packet->Acb->AtaSectorCountExp;
+  CFis.AhciCFisSecCount    = (UINT8) (Slot << ATA_NCQ_TAG_SHIFT);
+  CFis.AhciCFisSecCountExp = 0;
+  CFis.AhciCFisDevHead     = BIT6;
+  CFis.AhciCFisPmNum       = PortMultiplier;
+
+  CommandTable = &AhciRegisters->AhciNcqCommandTable[Slot];
+  ZeroMem (CommandTable, sizeof (EFI_AHCI_NCQ_COMMAND_TABLE));
+  CopyMem (&CommandTable->CommandFis, &CFis, sizeof (EFI_AHCI_COMMAND_FIS));
+
+  PrdtNumber = (DataCount + EFI_AHCI_MAX_DATA_PER_PRDT - 1) / EFI_AHCI_MAX_DATA_PER_PRDT;
+  for (PrdtIndex = 0; PrdtIndex < PrdtNumber; PrdtIndex++) {
+    Data64.Uint64 = PhyAddr + (UINT64) PrdtIndex * EFI_AHCI_MAX_DATA_PER_PRDT;
+    CommandTable->PrdtTable[PrdtIndex].AhciPrdtDba  = Data64.Uint32.Lower32;
+    CommandTable->PrdtTable[PrdtIndex].AhciPrdtDbau = Data64.Uint32.Upper32;
+    CommandTable->PrdtTable[PrdtIndex].AhciPrdtDbc  =
+      MIN (DataCount - PrdtIndex * EFI_AHCI_MAX_DATA_PER_PRDT, EFI_AHCI_MAX_DATA_PER_PRDT) - 1;
+  }
+
+  CommandList = &AhciRegisters->AhciCmdList[Slot];
+  ZeroMem (CommandList, sizeof (EFI_AHCI_COMMAND_LIST));
+  CommandList->AhciCmdCfl   = EFI_AHCI_FIS_REGISTER_H2D_LENGTH / 4;
+  CommandList->AhciCmdW     = Read ? 0 : 1;
+  CommandList->AhciCmdPrdtl = PrdtNumber;
+  CommandList->AhciCmdPmp   = PortMultiplier;
+  Data64.Uint64 = (UINT64)(UINTN) &AhciRegisters->AhciNcqCommandTablePciAddr[Slot];
+  CommandList->AhciCmdCtba  = Data64.Uint32.Lower32;
+  CommandList->AhciCmdCtbau = Data64.Uint32.Upper32;
+
+  if (Instance->NcqActiveSlots == 0) {
+    Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_CMD;
+    AhciAndReg (PciIo, Offset, (UINT32)~(EFI_AHCI_PORT_CMD_DLAE | EFI_AHCI_PORT_CMD_ATAPI));
+
+    Status = AhciStartPort (PciIo, Port, ATA_ATAPI_TIMEOUT);
+    if (EFI_ERROR (Status)) {
+      PciIo->Unmap (PciIo, Task->Map);
+      Task->Map = NULL;
+      return Status;
+    }
+
+    Instance->NcqPort           = Task->Port;
+    Instance->NcqPortMultiplier = Task->PortMultiplier;
+  }
+
+  DEBUG ((DEBUG_VERBOSE, "Starting queued command in slot %d:\n", Slot));
+  AhciPrintCommandBlock (Packet->Acb, DEBUG_VERBOSE);
+
+  //
+  // PxSACT must be set before PxCI for a queued command.
+  //
+  Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_SACT;
+  AhciWriteReg (PciIo, Offset, (UINT32) 1 << Slot);
+  Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_CI;
+  AhciWriteReg (PciIo, Offset, (UINT32) 1 << Slot);
+
+  Instance->NcqActiveSlots |= (UINT32) 1 << Slot;
+  Task->IsStart = TRUE;
+  Task->IsNcq   = TRUE;
+  Task->NcqTag  = Slot;
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Abort all queued commands in flight.
+
+  The port is stopped, and the aborted tasks are left in the non-blocking task
+  list as not started, with their data buffer unmapped.
+
+  @param[in]  Instance  A pointer to the ATA_ATAPI_PASS_THRU_INSTANCE instance.
+
+**/
+VOID
+EFIAPI
+AhciNcqAbort (
+  IN  ATA_ATAPI_PASS_THRU_INSTANCE  *Instance
+  )
+{
+  LIST_ENTRY         *Entry;
+  ATA_NONBLOCK_TASK  *Task;
+
+  if (Instance->NcqActiveSlots == 0) {
+    return;
+  }
+
+  //
+  // Clearing PxCMD.ST also clears PxSACT and PxCI.
+  //
+  AhciStopCommand (Instance->PciIo, (UINT8) Instance->NcqPort, ATA_ATAPI_TIMEOUT);
+  AhciDisableFisReceive (Instance->PciIo, (UINT8) Instance->NcqPort, ATA_ATAPI_TIMEOUT);
+
+  for (Entry = GetFirstNode (&Instance->NonBlockingTaskList);
+       !IsNull (&Instance->NonBlockingTaskList, Entry);
+       Entry = GetNextNode (&Instance->NonBlockingTaskList, Entry)) {
+    Task = ATA_NON_BLOCK_TASK_FROM_ENTRY (Entry);
+    if (!Task->IsNcq) {
+      continue;
+    }
+
+    Instance->PciIo->Unmap (Instance->PciIo, Task->Map);
+    Task->Map     = NULL;
+    Task->IsNcq   = FALSE;
+    Task->IsStart = FALSE;
+  }
+
+  Instance->NcqActiveSlots = 0;
+}
+
+/**
+  Complete the queued commands that are done, and issue the non-blocking tasks
+  at the head of the task list as queued commands, as long as the device
+  accepts more.
+
+  A queued command is complete when the device clears its bit in PxSACT. If the
+  device reports an error, all queued commands are aborted and Native Command
+  Queuing is disabled for the device; the tasks are then executed one by one.
+
+  @param[in]  Instance  A pointer to the ATA_ATAPI_PASS_THRU_INSTANCE instance.
+
+  @retval EFI_NOT_READY  Queued commands are in flight.
+  @retval EFI_SUCCESS    No queued command is in flight. The task at the head
+                         of the list, if any, must be executed without queuing.
+  @retval EFI_TIMEOUT    A queued command timed out. All queued commands were
+                         aborted.
+
+**/
+EFI_STATUS
+EFIAPI
+AhciNcqTransferRoutine (
+  IN  ATA_ATAPI_PASS_THRU_INSTANCE  *Instance
+  )
+{
+  EFI_STATUS           Status;
+  EFI_PCI_IO_PROTOCOL  *PciIo;
+  LIST_ENTRY           *Entry;
+  LIST_ENTRY           *NextEntry;
+  ATA_NONBLOCK_TASK    *Task;
+  EFI_ATA_DEVICE_INFO  *DeviceInfo;
+  UINT8                Port;
+  UINT32               Offset;
+  UINT32               PortInterrupt;
+  UINT32               Completed;
+  BOOLEAN              TimedOut;
+  UINT8                Slot;
+  UINT8                LogData[512];
+
+  if (Instance->AhciRegisters.NcqSlotNumber == 0) {
+    return EFI_SUCCESS;
+  }
+
+  PciIo = Instance->PciIo;
+
+  if (Instance->NcqActiveSlots != 0) {
+    Port = (UINT8) Instance->NcqPort;
+
+    Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_IS;
+    PortInterrupt = AhciReadReg (PciIo, Offset);
+    if ((PortInterrupt & EFI_AHCI_PORT_IS_ERROR_MASK) != 0) {
+      DEBUG ((DEBUG_ERROR, "AHCI: Queued command failed on port %d, PxIS: %X\n", Port, PortInterrupt));
+      AhciRecoverPortError (PciIo, Port);
+      AhciNcqAbort (Instance);
+
+      //
+      // Reading the NCQ Command Error log gets the device out of its error state.
+      //
+      AhciReadLogExt (
+        PciIo,
+        &Instance->AhciRegisters,
+        Port,
+        (UINT8) ((Instance->NcqPortMultiplier == 0xFFFF) ? 0 : Instance->NcqPortMultiplier),
+        LogData,
+        ATA_NCQ_ERROR_LOG,
+        0
+        );
+
+      DeviceInfo = AhciNcqGetDevice (Instance, Instance->NcqPort, Instance->NcqPortMultiplier);
+      if (DeviceInfo != NULL) {
+        DeviceInfo->NcqQueueDepth = 0;
+      }
+      return EFI_SUCCESS;
+    }
+
+    Offset    = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_SACT;
+    Completed = Instance->NcqActiveSlots & ~AhciReadReg (PciIo, Offset);
+    TimedOut  = FALSE;
+
+    for (Entry = GetFirstNode (&Instance->NonBlockingTaskList);
+         !IsNull (&Instance->NonBlockingTaskList, Entry);
+         Entry = NextEntry) {
+      NextEntry = GetNextNode (&Instance->NonBlockingTaskList, Entry);
+      Task      = ATA_NON_BLOCK_TASK_FROM_ENTRY (Entry);
+      if (!Task->IsNcq) {
+        continue;
+      }
+
+      if ((Completed & ((UINT32) 1 << Task->NcqTag)) == 0) {
+        if (!Task->InfiniteWait) {
+          if (Task->RetryTimes == 0) {
+            TimedOut = TRUE;
+          } else {
+            Task->RetryTimes--;
+          }
+        }
+        continue;
+      }
+
+      PciIo->Unmap (PciIo, Task->Map);
+      ZeroMem (Task->Packet->Asb, sizeof (EFI_ATA_STATUS_BLOCK));
+      Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_TFD;
+      Task->Packet->Asb->AtaStatus = (UINT8) AhciReadReg (PciIo, Offset);
+
+      Instance->NcqActiveSlots &= ~((UINT32) 1 << Task->NcqTag);
+      RemoveEntryList (&Task->Link);
+      gBS->SignalEvent (Task->Event);
+      FreePool (Task);
+    }
+
+    if (TimedOut) {
+      DEBUG ((DEBUG_ERROR, "AHCI: Queued command timed out on port %d\n", Port));
+      AhciNcqAbort (Instance);
+      return EFI_TIMEOUT;
+    }
+
+    if (Instance->NcqActiveSlots == 0) {
+      AhciStopCommand (PciIo, Port, ATA_ATAPI_TIMEOUT);
+      AhciDisableFisReceive (PciIo, Port, ATA_ATAPI_TIMEOUT);
+    }
+  }
+
+  //
+  // Issue tasks in list order, stopping at the first one that cannot be
+  // queued, so that a task that is not queued never overtakes another.
+  //
+  for (Entry = GetFirstNode (&Instance->NonBlockingTaskList);
+       !IsNull (&Instance->NonBlockingTaskList, Entry);
+       Entry = GetNextNode (&Instance->NonBlockingTaskList, Entry)) {
+    Task = ATA_NON_BLOCK_TASK_FROM_ENTRY (Entry);
+    if (Task->IsNcq) {
+      continue;
+    }
+
+    if (Task->IsStart || !AhciNcqCanQueue (Instance, Task, &Slot)) {
+      break;
+    }
+
+    Status = AhciNcqStartTask (Instance, Task, Slot);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+  }
+
+  return (Instance->NcqActiveSlots != 0) ? EFI_NOT_READY : EFI_SUCCESS;
+}
+
 /**
   Initialize ATA host controller at AHCI mode.
 
@@ -3033,6 +3623,7 @@ AhciModeInitialization (
           0,
           &Buffer
           );
+        AhciNcqInitializeDevice (Instance, Port, 0xFFFF, &Buffer);
       }
 
       //
@@ -13,6 +13,7 @@
 #define EFI_AHCI_CAPABILITY_OFFSET             0x0000
 #define   EFI_AHCI_CAP_SAM                     BIT18
 #define   EFI_AHCI_CAP_SSS                     BIT27
+#define   EFI_AHCI_CAP_SNCQ                    BIT30
 #define   EFI_AHCI_CAP_S64A                    BIT31
 #define EFI_AHCI_GHC_OFFSET                    0x0004
 #define   EFI_AHCI_GHC_RESET                   BIT0
@@ -194,6 +195,22 @@ typedef union {
 
 #define AHCI_COMMAND_RETRIES  5
 
+//
+// Native Command Queuing. A queued command is identified by its tag, which is
+// also the number of the command slot it is issued in.
+//
+#define ATA_CMD_READ_FPDMA_QUEUED              0x60
+#define ATA_CMD_WRITE_FPDMA_QUEUED             0x61
+#define   ATA_NCQ_TAG_SHIFT                    3
+#define ATA_NCQ_ERROR_LOG                      0x10
+
+#define EFI_AHCI_NCQ_MAX_SLOTS                 32
+//
+// Enough for the largest transfer issued by AtaBusDxe, 0xFFFF blocks of 4KB.
+// Larger transfers are not queued.
+//
+#define EFI_AHCI_NCQ_MAX_PRDT                  64
+
 #pragma pack(1)
 //
 // Command List structure includes total 32 entries.
@@ -284,6 +301,16 @@ typedef struct {
   EFI_AHCI_COMMAND_PRDT     PrdtTable[65535];     // The scatter/gather list for data transfer
 } EFI_AHCI_COMMAND_TABLE;
 
+//
+// Command table of a queued command. One is allocated per command slot.
+//
+typedef struct {
+  EFI_AHCI_COMMAND_FIS      CommandFis;       // A software constructed FIS.
+  EFI_AHCI_ATAPI_COMMAND    AtapiCmd;         // 12 or 16 bytes ATAPI cmd.
+  UINT8                     Reserved[0x30];
+  EFI_AHCI_COMMAND_PRDT     PrdtTable[EFI_AHCI_NCQ_MAX_PRDT];
+} EFI_AHCI_NCQ_COMMAND_TABLE;
+
 //
 // Received FIS structure
 //
@@ -323,6 +350,14 @@ typedef struct {
   VOID                      *MapRFis;
   VOID                      *MapCmdList;
   VOID                      *MapCommandTable;
+  //
+  // Command tables for queued commands, NULL if the HBA does not support NCQ.
+  //
+  EFI_AHCI_NCQ_COMMAND_TABLE *AhciNcqCommandTable;
+  EFI_AHCI_NCQ_COMMAND_TABLE *AhciNcqCommandTablePciAddr;
+  UINT64                    MaxNcqCommandTableSize;
+  VOID                      *MapNcqCommandTable;
+  UINT8                     NcqSlotNumber;
 } EFI_AHCI_REGISTERS;
 
 /**
@@ -98,7 +98,10 @@ ATA_ATAPI_PASS_THRU_INSTANCE gAtaAtapiPassThruInstanceTemplate = {
   {                   // NonBlocking TaskList
     NULL,
     NULL
-  }
+  },
+  0,                  // NcqActiveSlots
+  0,                  // NcqPort
+  0                   // NcqPortMultiplier
 };
 
 ATAPI_DEVICE_PATH    mAtapiDevicePathTemplate = {
@@ -193,6 +196,7 @@ AtaPassThruPassThruExecute (
   EFI_ATA_PASS_THRU_CMD_PROTOCOL  Protocol;
   EFI_ATA_HC_WORK_MODE            Mode;
   EFI_STATUS                      Status;
+  EFI_TPL                         OldTpl;
 
   Protocol = Packet->Protocol;
 
@@ -284,6 +288,23 @@ AtaPassThruPassThruExecute (
         //
         PortMultiplierPort = 0;
       }
+
+      //
+      // Queued commands keep the port running between two timer ticks. Let
+      // them complete before a blocking command takes the port over.
+      //
+      if ((Task == NULL) && (Instance->NcqActiveSlots != 0)) {
+        OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+        while (Instance->NcqActiveSlots != 0) {
+          AsyncNonBlockingTransferRoutine (NULL, Instance);
+          //
+          // Stall for 100us.
+          //
+          MicroSecondDelay (100);
+        }
+        gBS->RestoreTPL (OldTpl);
+      }
+
       switch (Protocol) {
         case EFI_ATA_PASS_THRU_PROTOCOL_ATA_NON_DATA:
           Status = AhciNonDataTransfer (
@@ -408,6 +429,22 @@ AsyncNonBlockingTransferRoutine (
   // no task in the list or the device is busy with task (EFI_NOT_READY).
   //
   while (TRUE) {
+    //
+    // In AHCI mode, the tasks that can be queued are issued together, and
+    // the other tasks are executed once no queued command is in flight.
+    //
+    if (Instance->Mode == EfiAtaAhciMode) {
+      Status = AhciNcqTransferRoutine (Instance);
+      if (Status == EFI_NOT_READY) {
+        break;
+      }
+
+      if (EFI_ERROR (Status)) {
+        DestroyAsynTaskList (Instance, TRUE);
+        break;
+      }
+    }
+
     if (!IsListEmpty (EntryHeader)) {
       Entry = GetFirstNode (EntryHeader);
       Task  = ATA_NON_BLOCK_TASK_FROM_ENTRY (Entry);
@@ -917,6 +954,9 @@ AtaAtapiPassThruStop (
     gBS->CloseEvent (Instance->TimerEvent);
     Instance->TimerEvent = NULL;
   }
+  if (Instance->Mode == EfiAtaAhciMode) {
+    AhciNcqAbort (Instance);
+  }
   DestroyAsynTaskList (Instance, FALSE);
   //
   // Free allocated resource
@@ -941,6 +981,17 @@ AtaAtapiPassThruStop (
   //
   if (Instance->Mode == EfiAtaAhciMode) {
     AhciRegisters = &Instance->AhciRegisters;
+    if (AhciRegisters->AhciNcqCommandTable != NULL) {
+      PciIo->Unmap (
+               PciIo,
+               AhciRegisters->MapNcqCommandTable
+               );
+      PciIo->FreeBuffer (
+               PciIo,
+               EFI_SIZE_TO_PAGES ((UINTN) AhciRegisters->MaxNcqCommandTableSize),
+               AhciRegisters->AhciNcqCommandTable
+               );
+    }
     PciIo->Unmap (
              PciIo,
              AhciRegisters->MapCommandTable
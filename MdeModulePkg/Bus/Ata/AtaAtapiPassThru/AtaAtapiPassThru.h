@@ -74,6 +74,11 @@ typedef struct {
   EFI_ATA_DEVICE_TYPE               Type;
 
   EFI_IDENTIFY_DATA                 *IdentifyData;
+  //
+  // Number of commands that may be queued to the device at once, 0 if
+  // Native Command Queuing is not used.
+  //
+  UINT8                             NcqQueueDepth;
 } EFI_ATA_DEVICE_INFO;
 
 typedef struct {
@@ -118,6 +123,14 @@ typedef struct {
   //
   EFI_EVENT                         TimerEvent;
   LIST_ENTRY                        NonBlockingTaskList;
+
+  //
+  // Command slots of the queued commands in flight in AHCI mode. All of them
+  // target the device at NcqPort and NcqPortMultiplier.
+  //
+  UINT32                            NcqActiveSlots;
+  UINT16                            NcqPort;
+  UINT16                            NcqPortMultiplier;
 } ATA_ATAPI_PASS_THRU_INSTANCE;
 
 //
@@ -138,6 +151,8 @@ struct _ATA_NONBLOCK_TASK {
   VOID                              *TableMap;       // Pointer to PRD table map.
   EFI_ATA_DMA_PRD                   *MapBaseAddress; //  Pointer to range Base address for Map.
   UINTN                             PageCount;       //  The page numbers used by PCIO freebuffer.
+  BOOLEAN                           IsNcq;           // Issued as a queued command.
+  UINT8                             NcqTag;          // Tag and command slot of the queued command.
 };
 
 //
@@ -1149,6 +1164,45 @@ AhciDmaTransfer (
   IN     ATA_NONBLOCK_TASK            *Task
   );
 
+/**
+  Complete the queued commands that are done, and issue the non-blocking tasks
+  at the head of the task list as queued commands, as long as the device
+  accepts more.
+
+  A queued command is complete when the device clears its bit in PxSACT. If the
+  device reports an error, all queued commands are aborted and Native Command
+  Queuing is disabled for the device; the tasks are then executed one by one.
+
+  @param[in]  Instance  A pointer to the ATA_ATAPI_PASS_THRU_INSTANCE instance.
+
+  @retval EFI_NOT_READY  Queued commands are in flight.
+  @retval EFI_SUCCESS    No queued command is in flight. The task at the head
+                         of the list, if any, must be executed without queuing.
+  @retval EFI_TIMEOUT    A queued command timed out. All queued commands were
+                         aborted.
+
+**/
+EFI_STATUS
+EFIAPI
+AhciNcqTransferRoutine (
+  IN  ATA_ATAPI_PASS_THRU_INSTANCE  *Instance
+  );
+
+/**
+  Abort all queued commands in flight.
+
+  The port is stopped, and the aborted tasks are left in the non-blocking task
+  list as not started, with their data buffer unmapped.
+
+  @param[in]  Instance  A pointer to the ATA_ATAPI_PASS_THRU_INSTANCE instance.
+
+**/
+VOID
+EFIAPI
+AhciNcqAbort (
+  IN  ATA_ATAPI_PASS_THRU_INSTANCE  *Instance
+  );
+
 /**
   Start a PIO data transfer on specific port.
 
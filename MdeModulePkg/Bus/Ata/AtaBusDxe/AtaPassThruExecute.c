@@ -807,7 +807,16 @@ AccessAtaDevice(
   if ((Token != NULL) && (Token->Event != NULL)) {
     OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
 
-    if (!IsListEmpty (&AtaDevice->AtaSubTaskList)) {
+    //
+    // A request waits for the previous one to complete, unless the device
+    // supports Native Command Queuing (IDENTIFY word 76 BIT8). The ATA pass
+    // thru driver may then have the DMA commands of several requests in
+    // flight at once.
+    //
+    if (!IsListEmpty (&AtaDevice->AtaSubTaskList) &&
+        !(AtaDevice->UdmaValid && AtaDevice->Lba48Bit &&
+          (AtaDevice->IdentifyData->serial_ata_capabilities != 0xFFFF) &&
+          ((AtaDevice->IdentifyData->serial_ata_capabilities & BIT8) != 0))) {
       AtaTask = AllocateZeroPool (sizeof (ATA_BUS_ASYN_TASK));
       if (AtaTask == NULL) {
         gBS->RestoreTPL (OldTpl);
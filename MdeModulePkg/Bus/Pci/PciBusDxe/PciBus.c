@@ -329,6 +329,11 @@ PciBusDriverBindingStart (
     ParentDevicePath
     );
 
+  //
+  // Load the topology found by the previous boot
+  //
+  PciTopologyCacheLoad ();
+
   Status = EFI_SUCCESS;
   //
   // Enumerate the entire host bridge
@@ -362,6 +367,11 @@ PciBusDriverBindingStart (
     return Status;
   }
 
+  //
+  // Store the topology for the next boot
+  //
+  PciTopologyCacheSave ();
+
   //
   // Start all the devices under the entire host bridge.
   //
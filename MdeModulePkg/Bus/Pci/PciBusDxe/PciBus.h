@@ -37,6 +37,8 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/ReportStatusCodeLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiRuntimeServicesTableLib.h>
+#include <Library/HobLib.h>
 #include <Library/DevicePathLib.h>
 #include <Library/PcdLib.h>
 
@@ -80,6 +82,7 @@ typedef enum {
 #include "PciPowerManagement.h"
 #include "PciHotPlugSupport.h"
 #include "PciLib.h"
+#include "PciTopologyCache.h"
 
 #define VGABASE1  0x3B0
 #define VGALIMIT1 0x3BB
@@ -110,6 +110,14 @@ PciPciDeviceInfoCollector (
 
     for (Func = 0; Func <= PCI_MAX_FUNC; Func++) {
 
+      //
+      // Skip the device if the previous boot found it absent
+      //
+      if (Func == 0 &&
+          PciTopologyCacheSkipDevice (Bridge->PciRootBridgeIo, StartBusNumber, Device)) {
+        break;
+      }
+
       //
       // Check to see whether PCI device is present
       //
@@ -121,6 +129,15 @@ PciPciDeviceInfoCollector (
                  (UINT8) Func
                  );
 
+      if (Func == 0) {
+        PciTopologyCacheRecordDevice (
+          Bridge->PciRootBridgeIo,
+          StartBusNumber,
+          Device,
+          (BOOLEAN) !EFI_ERROR (Status)
+          );
+      }
+
       if (EFI_ERROR (Status) && Func == 0) {
         //
         // go to next device if there is no Function 0
@@ -1089,6 +1089,14 @@ PciScanBus (
     TempReservedBusNum = 0;
     for (Func = 0; Func <= PCI_MAX_FUNC; Func++) {
 
+      //
+      // Skip the device if the previous boot found it absent
+      //
+      if (Func == 0 &&
+          PciTopologyCacheSkipDevice (PciRootBridgeIo, StartBusNumber, Device)) {
+        break;
+      }
+
       //
       // Check to see whether a pci device is present
       //
@@ -1100,6 +1108,15 @@ PciScanBus (
                 Func
                 );
 
+      if (Func == 0) {
+        PciTopologyCacheRecordDevice (
+          PciRootBridgeIo,
+          StartBusNumber,
+          Device,
+          (BOOLEAN) !EFI_ERROR (Status)
+          );
+      }
+
       if (EFI_ERROR (Status) && Func == 0) {
         //
         // go to next device if there is no Function 0
@@ -0,0 +1,275 @@
+/** @file
+  Cache of the PCI topology found by the previous boot, used to skip probing
+  empty device slots.
+
+  Every scan of a bus probes function 0 of all 32 devices. On systems with
+  many root bridges and sparsely populated buses, most of these config space
+  accesses hit empty slots. When the platform asserts that the hardware has
+  not changed since the previous boot (BOOT_ASSUMING_NO_CONFIGURATION_CHANGES),
+  the slots that were empty on a bus scanned by the previous boot are not
+  probed again.
+
+Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "PciBus.h"
+
+#define PCI_TOPOLOGY_CACHE_SIZE(SegmentCount) \
+  (sizeof (PCI_TOPOLOGY_CACHE) + (SegmentCount) * sizeof (PCI_TOPOLOGY_SEGMENT))
+
+//
+// The topology used to skip devices; NULL if no device may be skipped.
+//
+PCI_TOPOLOGY_CACHE  *mPciTopologyPrevious  = NULL;
+
+//
+// The contents of the variable.
+//
+PCI_TOPOLOGY_CACHE  *mPciTopologyStored    = NULL;
+UINTN               mPciTopologyStoredSize = 0;
+
+//
+// The topology recorded by the current boot; NULL if not recording.
+//
+PCI_TOPOLOGY_CACHE  *mPciTopologyCurrent   = NULL;
+
+UINTN               mPciTopologySkipped    = 0;
+
+/**
+  Find the entry of a segment in a topology cache.
+
+  @param Cache     The topology cache to search.
+  @param Segment   The PCI segment NO.
+
+  @return  The entry of the segment, or NULL if Cache has none.
+
+**/
+PCI_TOPOLOGY_SEGMENT *
+PciTopologyCacheFindSegment (
+  IN PCI_TOPOLOGY_CACHE  *Cache,
+  IN UINT32              Segment
+  )
+{
+  PCI_TOPOLOGY_SEGMENT  *Entry;
+  UINT32                Index;
+
+  Entry = (PCI_TOPOLOGY_SEGMENT *) (Cache + 1);
+  for (Index = 0; Index < Cache->SegmentCount; Index++) {
+    if (Entry[Index].Segment == Segment) {
+      return &Entry[Index];
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Prepare the topology cache for an enumeration.
+
+  The topology recorded by the previous boot is loaded, and used to skip empty
+  devices, only if PcdPciBusTopologyCache is TRUE and the boot mode is
+  BOOT_ASSUMING_NO_CONFIGURATION_CHANGES. The topology of the current boot is
+  recorded whenever PcdPciBusTopologyCache is TRUE.
+
+**/
+VOID
+PciTopologyCacheLoad (
+  VOID
+  )
+{
+  EFI_STATUS          Status;
+  PCI_TOPOLOGY_CACHE  *Stored;
+  UINTN               StoredSize;
+
+  if (!FeaturePcdGet (PcdPciBusTopologyCache) || (mPciTopologyCurrent != NULL)) {
+    return;
+  }
+
+  mPciTopologyCurrent = AllocateZeroPool (sizeof (PCI_TOPOLOGY_CACHE));
+  if (mPciTopologyCurrent == NULL) {
+    return;
+  }
+  mPciTopologyCurrent->Signature = PCI_TOPOLOGY_CACHE_SIGNATURE;
+
+  Status = GetVariable2 (
+             PCI_TOPOLOGY_CACHE_VARIABLE_NAME,
+             &gEfiCallerIdGuid,
+             (VOID **) &Stored,
+             &StoredSize
+             );
+  if (EFI_ERROR (Status)) {
+    return;
+  }
+
+  if ((StoredSize < sizeof (PCI_TOPOLOGY_CACHE)) ||
+      (Stored->Signature != PCI_TOPOLOGY_CACHE_SIGNATURE) ||
+      (Stored->SegmentCount > PCI_MAX_HOST_BRIDGE_NUM * (PCI_MAX_BUS + 1)) ||
+      (StoredSize != PCI_TOPOLOGY_CACHE_SIZE (Stored->SegmentCount))) {
+    DEBUG ((DEBUG_WARN, "PciBus: Ignoring malformed topology cache\n"));
+    FreePool (Stored);
+    return;
+  }
+
+  mPciTopologyStored     = Stored;
+  mPciTopologyStoredSize = StoredSize;
+
+  if (GetBootModeHob () == BOOT_ASSUMING_NO_CONFIGURATION_CHANGES) {
+    DEBUG ((
+      DEBUG_INFO,
+      "PciBus: Using topology cache of %d segment(s)\n",
+      Stored->SegmentCount
+      ));
+    mPciTopologyPrevious = Stored;
+  }
+}
+
+/**
+  Record the result of probing function 0 of a device.
+
+  @param PciRootBridgeIo   Root bridge the bus belongs to.
+  @param Bus               PCI bus NO.
+  @param Device            PCI device NO.
+  @param Present           TRUE if function 0 of the device responded.
+
+**/
+VOID
+PciTopologyCacheRecordDevice (
+  IN EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL  *PciRootBridgeIo,
+  IN UINT8                            Bus,
+  IN UINT8                            Device,
+  IN BOOLEAN                          Present
+  )
+{
+  PCI_TOPOLOGY_SEGMENT  *Entry;
+  PCI_TOPOLOGY_CACHE    *Grown;
+  UINT32                SegmentCount;
+
+  if (mPciTopologyCurrent == NULL) {
+    return;
+  }
+
+  Entry = PciTopologyCacheFindSegment (
+            mPciTopologyCurrent,
+            (UINT32) PciRootBridgeIo->SegmentNumber
+            );
+  if (Entry == NULL) {
+    SegmentCount = mPciTopologyCurrent->SegmentCount;
+    Grown = ReallocatePool (
+              PCI_TOPOLOGY_CACHE_SIZE (SegmentCount),
+              PCI_TOPOLOGY_CACHE_SIZE (SegmentCount + 1),
+              mPciTopologyCurrent
+              );
+    if (Grown == NULL) {
+      return;
+    }
+    mPciTopologyCurrent = Grown;
+
+    Entry = (PCI_TOPOLOGY_SEGMENT *) (Grown + 1) + SegmentCount;
+    ZeroMem (Entry, sizeof (*Entry));
+    Entry->Segment = (UINT32) PciRootBridgeIo->SegmentNumber;
+    Grown->SegmentCount++;
+  }
+
+  Entry->ScannedBus[Bus / 8] |= (UINT8) (1 << (Bus % 8));
+  if (Present) {
+    Entry->DevicePresent[Bus] |= (UINT32) 1 << Device;
+  }
+}
+
+/**
+  Check whether function 0 of a device may be left unprobed, because the
+  previous boot scanned the bus and found no device there.
+
+  A skipped device is recorded as absent in the topology of the current boot.
+
+  @param PciRootBridgeIo   Root bridge the bus belongs to.
+  @param Bus               PCI bus NO.
+  @param Device            PCI device NO.
+
+  @retval TRUE   The device is known to be absent, do not probe it.
+  @retval FALSE  The device must be probed.
+
+**/
+BOOLEAN
+PciTopologyCacheSkipDevice (
+  IN EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL  *PciRootBridgeIo,
+  IN UINT8                            Bus,
+  IN UINT8                            Device
+  )
+{
+  PCI_TOPOLOGY_SEGMENT  *Entry;
+
+  if (mPciTopologyPrevious == NULL) {
+    return FALSE;
+  }
+
+  Entry = PciTopologyCacheFindSegment (
+            mPciTopologyPrevious,
+            (UINT32) PciRootBridgeIo->SegmentNumber
+            );
+  if ((Entry == NULL) ||
+      ((Entry->ScannedBus[Bus / 8] & (1 << (Bus % 8))) == 0) ||
+      ((Entry->DevicePresent[Bus] & ((UINT32) 1 << Device)) != 0)) {
+    return FALSE;
+  }
+
+  mPciTopologySkipped++;
+  PciTopologyCacheRecordDevice (PciRootBridgeIo, Bus, Device, FALSE);
+  return TRUE;
+}
+
+/**
+  Store the topology recorded so far for the next boot, if it differs from
+  what is stored already.
+
+**/
+VOID
+PciTopologyCacheSave (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Size;
+
+  if (mPciTopologyCurrent == NULL) {
+    return;
+  }
+
+  if (mPciTopologyPrevious != NULL) {
+    DEBUG ((
+      DEBUG_INFO,
+      "PciBus: Topology cache skipped %d empty device(s)\n",
+      mPciTopologySkipped
+      ));
+  }
+
+  Size = PCI_TOPOLOGY_CACHE_SIZE (mPciTopologyCurrent->SegmentCount);
+  if ((mPciTopologyStored != NULL) &&
+      (mPciTopologyStoredSize == Size) &&
+      (CompareMem (mPciTopologyStored, mPciTopologyCurrent, Size) == 0)) {
+    return;
+  }
+
+  Status = gRT->SetVariable (
+                  PCI_TOPOLOGY_CACHE_VARIABLE_NAME,
+                  &gEfiCallerIdGuid,
+                  EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS,
+                  Size,
+                  mPciTopologyCurrent
+                  );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_WARN, "PciBus: Failed to store topology cache - %r\n", Status));
+    return;
+  }
+
+  //
+  // The previous topology stays in use for the remaining host bridges.
+  //
+  if ((mPciTopologyStored != NULL) && (mPciTopologyStored != mPciTopologyPrevious)) {
+    FreePool (mPciTopologyStored);
+  }
+  mPciTopologyStored     = AllocateCopyPool (Size, mPciTopologyCurrent);
+  mPciTopologyStoredSize = (mPciTopologyStored == NULL) ? 0 : Size;
+}
@@ -0,0 +1,102 @@
+/** @file
+  Cache of the PCI topology found by the previous boot, used to skip probing
+  empty device slots.
+
+Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _EFI_PCI_TOPOLOGY_CACHE_H_
+#define _EFI_PCI_TOPOLOGY_CACHE_H_
+
+//
+// Name of the non-volatile variable, in the gEfiCallerIdGuid namespace, that
+// holds the topology found by the previous boot.
+//
+#define PCI_TOPOLOGY_CACHE_VARIABLE_NAME  L"PciTopologyCache"
+
+#define PCI_TOPOLOGY_CACHE_SIGNATURE      SIGNATURE_32 ('P', 'T', 'O', 'P')
+
+//
+// The devices found on every bus of one PCI segment. A bus whose bit is clear
+// in ScannedBus has not been scanned, and nothing is known about it.
+//
+typedef struct {
+  UINT32  Segment;
+  UINT8   ScannedBus[(PCI_MAX_BUS + 1) / 8];
+  UINT32  DevicePresent[PCI_MAX_BUS + 1];
+} PCI_TOPOLOGY_SEGMENT;
+
+//
+// Layout of the variable. The header is followed by SegmentCount instances of
+// PCI_TOPOLOGY_SEGMENT.
+//
+typedef struct {
+  UINT32  Signature;
+  UINT32  SegmentCount;
+} PCI_TOPOLOGY_CACHE;
+
+/**
+  Prepare the topology cache for an enumeration.
+
+  The topology recorded by the previous boot is loaded, and used to skip empty
+  devices, only if PcdPciBusTopologyCache is TRUE and the boot mode is
+  BOOT_ASSUMING_NO_CONFIGURATION_CHANGES. The topology of the current boot is
+  recorded whenever PcdPciBusTopologyCache is TRUE.
+
+**/
+VOID
+PciTopologyCacheLoad (
+  VOID
+  );
+
+/**
+  Check whether function 0 of a device may be left unprobed, because the
+  previous boot scanned the bus and found no device there.
+
+  A skipped device is recorded as absent in the topology of the current boot.
+
+  @param PciRootBridgeIo   Root bridge the bus belongs to.
+  @param Bus               PCI bus NO.
+  @param Device            PCI device NO.
+
+  @retval TRUE   The device is known to be absent, do not probe it.
+  @retval FALSE  The device must be probed.
+
+**/
+BOOLEAN
+PciTopologyCacheSkipDevice (
+  IN EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL  *PciRootBridgeIo,
+  IN UINT8                            Bus,
+  IN UINT8                            Device
+  );
+
+/**
+  Record the result of probing function 0 of a device.
+
+  @param PciRootBridgeIo   Root bridge the bus belongs to.
+  @param Bus               PCI bus NO.
+  @param Device            PCI device NO.
+  @param Present           TRUE if function 0 of the device responded.
+
+**/
+VOID
+PciTopologyCacheRecordDevice (
+  IN EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL  *PciRootBridgeIo,
+  IN UINT8                            Bus,
+  IN UINT8                            Device,
+  IN BOOLEAN                          Present
+  );
+
+/**
+  Store the topology recorded so far for the next boot, if it differs from
+  what is stored already.
+
+**/
+VOID
+PciTopologyCacheSave (
+  VOID
+  );
+
+#endif
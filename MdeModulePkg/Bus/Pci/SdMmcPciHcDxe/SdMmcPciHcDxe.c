@@ -139,6 +139,163 @@ InitializeSdMmcPciHcDxe (
   return Status;
 }
 
+/**
+  Get the time elapsed between two values of the performance counter.
+
+  @param[in]  Start     The performance counter value at the start.
+  @param[in]  End       The performance counter value at the end.
+
+  @return The elapsed time in nanoseconds.
+
+**/
+UINT64
+SdMmcGetElapsedTime (
+  IN UINT64             Start,
+  IN UINT64             End
+  )
+{
+  UINT64                              CounterStart;
+  UINT64                              CounterEnd;
+  UINT64                              Ticks;
+
+  GetPerformanceCounterProperties (&CounterStart, &CounterEnd);
+  if (CounterStart < CounterEnd) {
+    if (End >= Start) {
+      Ticks = End - Start;
+    } else {
+      Ticks = (CounterEnd - Start) + (End - CounterStart);
+    }
+  } else {
+    if (Start >= End) {
+      Ticks = Start - End;
+    } else {
+      Ticks = (Start - CounterEnd) + (CounterStart - End);
+    }
+  }
+
+  return GetTimeInNanoSecond (Ticks);
+}
+
+/**
+  Account a finished TRB in the transfer statistics of its slot.
+
+  Only TRBs with a data transfer are accounted.
+
+  @param[in]  Private   Pointer to driver private data.
+  @param[in]  Trb       Pointer to the finished TRB.
+  @param[in]  Status    The status the TRB finished with.
+
+**/
+VOID
+SdMmcRecordTransfer (
+  IN SD_MMC_HC_PRIVATE_DATA           *Private,
+  IN SD_MMC_HC_TRB                    *Trb,
+  IN EFI_STATUS                       Status
+  )
+{
+  SD_MMC_HC_TRANSFER_STATS            *Stats;
+  UINT64                              Now;
+  UINT64                              Latency;
+
+  if (Trb->DataLen == 0) {
+    return;
+  }
+
+  Stats = &Private->Stats[Trb->Slot];
+  if (EFI_ERROR (Status)) {
+    Stats->Errors++;
+    return;
+  }
+
+  Now     = GetPerformanceCounter ();
+  Latency = SdMmcGetElapsedTime (Trb->SubmitTime, Now);
+
+  Stats->Transfers++;
+  Stats->Bytes        += Trb->DataLen;
+  Stats->TotalLatency += Latency;
+  Stats->BusTime      += SdMmcGetElapsedTime (Trb->ExecTime, Now);
+  if (Latency > Stats->MaxLatency) {
+    Stats->MaxLatency = Latency;
+  }
+}
+
+/**
+  Report the transfer statistics of all slots.
+
+  @param[in]  Event     The Event this notify function registered to.
+  @param[in]  Context   Pointer to the context data registered to the
+                        Event.
+
+**/
+VOID
+EFIAPI
+SdMmcPciHcReportStats (
+  IN EFI_EVENT          Event,
+  IN VOID*              Context
+  )
+{
+  SD_MMC_HC_PRIVATE_DATA              *Private;
+  SD_MMC_HC_TRANSFER_STATS            *Stats;
+  UINT8                               Slot;
+  UINT64                              BusTimeUs;
+
+  Private = (SD_MMC_HC_PRIVATE_DATA*)Context;
+
+  for (Slot = 0; Slot < SD_MMC_HC_MAX_SLOT; Slot++) {
+    Stats = &Private->Stats[Slot];
+    if (Stats->Transfers == 0) {
+      continue;
+    }
+    BusTimeUs = DivU64x32 (Stats->BusTime, 1000);
+    DEBUG ((
+      DEBUG_INFO,
+      "SdMmcPciHc: Slot %d: %ld transfers (%ld failed), %ld KB, latency avg %ld us max %ld us, %ld KB/s on the bus\n",
+      Slot,
+      Stats->Transfers,
+      Stats->Errors,
+      DivU64x32 (Stats->Bytes, SIZE_1KB),
+      DivU64x64Remainder (Stats->TotalLatency, MultU64x32 (Stats->Transfers, 1000), NULL),
+      DivU64x32 (Stats->MaxLatency, 1000),
+      (BusTimeUs == 0) ? 0 : DivU64x64Remainder (MultU64x32 (DivU64x32 (Stats->Bytes, SIZE_1KB), 1000000), BusTimeUs, NULL)
+      ));
+  }
+}
+
+/**
+  Start the first TRB of the async I/O queue if it is not started yet and the
+  cmd/data lines are ready for it.
+
+  The TRB is only started here, its completion is always reported by
+  ProcessAsyncTaskList(). If the TRB cannot be started now, it is left for
+  ProcessAsyncTaskList() to start or to fail.
+
+  @param[in]  Private   Pointer to driver private data.
+
+**/
+VOID
+SdMmcStartAsyncTrb (
+  IN SD_MMC_HC_PRIVATE_DATA           *Private
+  )
+{
+  LIST_ENTRY                          *Link;
+  SD_MMC_HC_TRB                       *Trb;
+  EFI_TPL                             OldTpl;
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  Link   = GetFirstNode (&Private->Queue);
+  if (!IsNull (&Private->Queue, Link)) {
+    Trb = SD_MMC_HC_TRB_FROM_THIS (Link);
+    if (!Trb->Started && Private->Slot[Trb->Slot].MediaPresent &&
+        !EFI_ERROR (SdMmcCheckTrbEnv (Private, Trb))) {
+      Trb->Started = TRUE;
+      if (EFI_ERROR (SdMmcExecTrb (Private, Trb))) {
+        Trb->Started = FALSE;
+      }
+    }
+  }
+  gBS->RestoreTPL (OldTpl);
+}
+
 /**
   Call back function when the timer event is signaled.
 
@@ -161,16 +318,20 @@ ProcessAsyncTaskList (
   EFI_SD_MMC_PASS_THRU_COMMAND_PACKET *Packet;
   BOOLEAN                             InfiniteWait;
   EFI_EVENT                           TrbEvent;
+  UINT32                              Poll;
 
   Private = (SD_MMC_HC_PRIVATE_DATA*)Context;
 
   //
-  // Check if the first entry in the async I/O queue is done or not.
+  // Check if the first entry in the async I/O queue is done or not. Once it
+  // is done, the next entry is started in the same tick rather than in the
+  // next one, so that back to back requests do not idle the bus.
   //
-  Status = EFI_SUCCESS;
-  Trb    = NULL;
-  Link   = GetFirstNode (&Private->Queue);
-  if (!IsNull (&Private->Queue, Link)) {
+  while (TRUE) {
+    Link = GetFirstNode (&Private->Queue);
+    if (IsNull (&Private->Queue, Link)) {
+      return;
+    }
     Trb = SD_MMC_HC_TRB_FROM_THIS (Link);
     if (!Private->Slot[Trb->Slot].MediaPresent) {
       Status = EFI_NO_MEDIA;
@@ -192,37 +353,42 @@ ProcessAsyncTaskList (
       }
     }
     Status = SdMmcCheckTrbResult (Private, Trb);
-  }
+    //
+    // A command without data transfer completes within microseconds. Wait for
+    // it briefly, so that the data command usually queued behind it (e.g.
+    // after SET_BLOCK_COUNT) does not have to wait for the next tick.
+    //
+    for (Poll = 0; (Status == EFI_NOT_READY) && (Trb->DataLen == 0) && (Poll < SD_MMC_HC_ASYNC_CMD_POLL); Poll++) {
+      gBS->Stall (1);
+      Status = SdMmcCheckTrbResult (Private, Trb);
+    }
 
 Done:
-  if ((Trb != NULL) && (Status == EFI_NOT_READY)) {
-    Packet = Trb->Packet;
-    if (Packet->Timeout == 0) {
-      InfiniteWait = TRUE;
-    } else {
-      InfiniteWait = FALSE;
-    }
-    if ((!InfiniteWait) && (Trb->Timeout-- == 0)) {
-      RemoveEntryList (Link);
-      Trb->Packet->TransactionStatus = EFI_TIMEOUT;
-      TrbEvent = Trb->Event;
-      SdMmcFreeTrb (Trb);
-      DEBUG ((DEBUG_VERBOSE, "ProcessAsyncTaskList(): Signal Event %p EFI_TIMEOUT\n", TrbEvent));
-      gBS->SignalEvent (TrbEvent);
+    if (Status == EFI_NOT_READY) {
+      Packet = Trb->Packet;
+      if (Packet->Timeout == 0) {
+        InfiniteWait = TRUE;
+      } else {
+        InfiniteWait = FALSE;
+      }
+      if (InfiniteWait || (Trb->Timeout-- != 0)) {
+        return;
+      }
+      Status = EFI_TIMEOUT;
+    } else if ((Status == EFI_CRC_ERROR) && (Trb->Retries > 0)) {
+      Trb->Retries--;
+      Trb->Started = FALSE;
       return;
     }
-  } else if ((Trb != NULL) && (Status == EFI_CRC_ERROR) && (Trb->Retries > 0)) {
-    Trb->Retries--;
-    Trb->Started = FALSE;
-  } else if ((Trb != NULL)) {
+
     RemoveEntryList (Link);
     Trb->Packet->TransactionStatus = Status;
     TrbEvent = Trb->Event;
+    SdMmcRecordTransfer (Private, Trb, Status);
     SdMmcFreeTrb (Trb);
     DEBUG ((DEBUG_VERBOSE, "ProcessAsyncTaskList(): Signal Event %p with %r\n", TrbEvent, Status));
     gBS->SignalEvent (TrbEvent);
   }
-  return;
 }
 
 /**
@@ -842,6 +1008,20 @@ SdMmcPciHcDriverBindingStart (
     goto Done;
   }
 
+  //
+  // Report the transfer statistics when the OS takes over
+  //
+  Status = gBS->CreateEvent (
+                  EVT_SIGNAL_EXIT_BOOT_SERVICES,
+                  TPL_CALLBACK,
+                  SdMmcPciHcReportStats,
+                  Private,
+                  &Private->ExitBootEvent
+                  );
+  if (EFI_ERROR (Status)) {
+    goto Done;
+  }
+
   Status = gBS->InstallMultipleProtocolInterfaces (
                   &Controller,
                   &gEfiSdMmcPassThruProtocolGuid,
@@ -879,6 +1059,10 @@ Done:
       gBS->CloseEvent (Private->ConnectEvent);
     }
 
+    if ((Private != NULL) && (Private->ExitBootEvent != NULL)) {
+      gBS->CloseEvent (Private->ExitBootEvent);
+    }
+
     if (Private != NULL) {
       FreePool (Private);
     }
@@ -956,6 +1140,11 @@ SdMmcPciHcDriverBindingStop (
     gBS->CloseEvent (Private->ConnectEvent);
     Private->ConnectEvent = NULL;
   }
+  if (Private->ExitBootEvent != NULL) {
+    SdMmcPciHcReportStats (Private->ExitBootEvent, Private);
+    gBS->CloseEvent (Private->ExitBootEvent);
+    Private->ExitBootEvent = NULL;
+  }
   //
   // As the timer is closed, there is no needs to use TPL lock to
   // protect the critical region "queue".
@@ -1146,14 +1335,17 @@ SdMmcPassThruPassThru (
     return EFI_OUT_OF_RESOURCES;
   }
   //
-  // Immediately return for async I/O.
+  // Immediately return for async I/O. If the queue was idle, the TRB is
+  // started right away rather than at the next tick of the async timer.
   //
   if (Event != NULL) {
+    SdMmcStartAsyncTrb (Private);
     return EFI_SUCCESS;
   }
 
   Status = SdMmcPassThruExecSyncTrb (Private, Trb);
 
+  SdMmcRecordTransfer (Private, Trb, Status);
   SdMmcFreeTrb (Trb);
 
   return Status;
@@ -25,6 +25,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/MemoryAllocationLib.h>
 #include <Library/UefiLib.h>
 #include <Library/DevicePathLib.h>
+#include <Library/TimerLib.h>
 
 #include <Protocol/DevicePath.h>
 #include <Protocol/PciIo.h>
@@ -70,6 +71,12 @@ extern EDKII_SD_MMC_OVERRIDE        *mOverride;
 // The unit is 100us, takes 100ms as interval.
 //
 #define SD_MMC_HC_ENUM_TIMER    EFI_TIMER_PERIOD_MILLISECONDS(100)
+//
+// Time to wait, in the async transfer timer, for a command without data
+// transfer (e.g. SET_BLOCK_COUNT) to complete, so that the data command
+// queued behind it can be started in the same tick. 1 microsecond as unit.
+//
+#define SD_MMC_HC_ASYNC_CMD_POLL  100
 
 typedef enum {
   UnknownCardType,
@@ -96,6 +103,20 @@ typedef struct {
   EDKII_SD_MMC_OPERATING_PARAMETERS  OperatingParameters;
 } SD_MMC_HC_SLOT;
 
+//
+// Statistics of the data transfers of a slot. Times are in nanoseconds.
+// Latency is measured from the submission of a request to its completion,
+// bus time from the start of the command on the bus to its completion.
+//
+typedef struct {
+  UINT64                             Transfers;
+  UINT64                             Errors;
+  UINT64                             Bytes;
+  UINT64                             TotalLatency;
+  UINT64                             MaxLatency;
+  UINT64                             BusTime;
+} SD_MMC_HC_TRANSFER_STATS;
+
 typedef struct {
   UINTN                               Signature;
 
@@ -129,6 +150,12 @@ typedef struct {
   // value stored in Capabilities Register 1.
   //
   UINT32                              BaseClkFreq[SD_MMC_HC_MAX_SLOT];
+
+  //
+  // For reporting the transfer statistics at ExitBootServices().
+  //
+  EFI_EVENT                           ExitBootEvent;
+  SD_MMC_HC_TRANSFER_STATS            Stats[SD_MMC_HC_MAX_SLOT];
 } SD_MMC_HC_PRIVATE_DATA;
 
 typedef struct {
@@ -166,6 +193,12 @@ typedef struct {
   BOOLEAN                             CommandComplete;
   UINT64                              Timeout;
   UINT32                              Retries;
+  //
+  // Performance counter values at submission and at the last start of the
+  // command on the bus.
+  //
+  UINT64                              SubmitTime;
+  UINT64                              ExecTime;
 
   BOOLEAN                             PioModeTransferCompleted;
   UINT32                              PioBlockIndex;
@@ -2021,6 +2021,7 @@ SdMmcCreateTrb (
   Trb->PioModeTransferCompleted = FALSE;
   Trb->PioBlockIndex = 0;
   Trb->Private   = Private;
+  Trb->SubmitTime = GetPerformanceCounter ();
 
   if ((Packet->InTransferLength != 0) && (Packet->InDataBuffer != NULL)) {
     Trb->Data    = Packet->InDataBuffer;
@@ -2283,6 +2284,7 @@ SdMmcExecTrb (
 
   Packet = Trb->Packet;
   PciIo  = Trb->Private->PciIo;
+  Trb->ExecTime = GetPerformanceCounter ();
   //
   // Clear all bits in Error Interrupt Status Register
   //
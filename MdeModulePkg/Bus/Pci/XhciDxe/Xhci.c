@@ -1222,6 +1222,9 @@ XhcBulkTransfer (
   UINT8                   SlotId;
   EFI_STATUS              Status;
   EFI_TPL                 OldTpl;
+  UINTN                   Offset;
+  UINTN                   Length;
+  UINTN                   UrbLength;
 
   //
   // Validate the parameters
@@ -1265,20 +1268,29 @@ XhcBulkTransfer (
   //
   // Create a new URB, insert it into the asynchronous
   // schedule list, then poll the execution status.
-  //
-  Status = XhcTransfer (
-             Xhc,
-             DeviceAddress,
-             EndPointAddress,
-             DeviceSpeed,
-             MaximumPacketLength,
-             XHC_BULK_TRANSFER,
-             NULL,
-             Data[0],
-             DataLength,
-             Timeout,
-             TransferResult
-             );
+  // Transfers that do not fit on the transfer ring as a single TD are
+  // carried out as consecutive URBs, stopping at the first short one.
+  //
+  Offset = 0;
+  do {
+    Length    = MIN (*DataLength - Offset, XHC_MAX_BULK_URB_LENGTH);
+    UrbLength = Length;
+    Status = XhcTransfer (
+               Xhc,
+               DeviceAddress,
+               EndPointAddress,
+               DeviceSpeed,
+               MaximumPacketLength,
+               XHC_BULK_TRANSFER,
+               NULL,
+               (UINT8 *) Data[0] + Offset,
+               &UrbLength,
+               Timeout,
+               TransferResult
+               );
+    Offset += UrbLength;
+  } while (!EFI_ERROR (Status) && (UrbLength == Length) && (Offset < *DataLength));
+  *DataLength = Offset;
 
 ON_EXIT:
   if (EFI_ERROR (Status)) {
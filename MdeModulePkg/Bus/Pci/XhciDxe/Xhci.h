@@ -74,6 +74,12 @@ typedef struct _USB_DEV_CONTEXT      USB_DEV_CONTEXT;
 
 #define CMD_RING_TRB_NUMBER          0x100
 #define TR_RING_TRB_NUMBER           0x100
+//
+// A bulk URB is one TD with a TRB per 64KB of data, plus one TRB as the
+// buffer may start in the middle of a 64KB page. Keep it clear of the Link
+// TRB and of the dequeue pointer. Larger bulk transfers are split.
+//
+#define XHC_MAX_BULK_URB_LENGTH      ((TR_RING_TRB_NUMBER - 4) * SIZE_64KB)
 #define ERST_NUMBER                  0x01
 #define EVENT_RING_TRB_NUMBER        0x200
 
@@ -225,9 +225,11 @@ XhcCreateTransferTrb (
   UINT8                         SlotId;
   UINT8                         Dci;
   TRB                           *TrbStart;
+  LINK_TRB                      *LinkTrb;
   UINTN                         TotalLen;
   UINTN                         Len;
   UINTN                         TrbNum;
+  UINTN                         Remaining;
   EFI_PCI_IO_PROTOCOL_OPERATION MapOp;
   EFI_PHYSICAL_ADDRESS          PhyAddr;
   VOID                          *Map;
@@ -377,26 +379,45 @@ XhcCreateTransferTrb (
 
     case ED_BULK_OUT:
     case ED_BULK_IN:
+      //
+      // Build a single TD of chained Normal TRBs, so the xHC streams the
+      // whole transfer without software intervention. Only the last TRB
+      // interrupts on completion; a short packet ends the TD early and is
+      // reported through ISP. 4.11.7.1: a TRB buffer shall not span a 64KB
+      // boundary.
+      //
       TotalLen = 0;
       Len      = 0;
       TrbNum   = 0;
       TrbStart = (TRB *)(UINTN)EPRing->RingEnqueue;
       while (TotalLen < Urb->DataLen) {
-        if ((TotalLen + 0x10000) >= Urb->DataLen) {
+        Len = 0x10000 - (((UINTN) Urb->DataPhy + TotalLen) & 0xFFFF);
+        if (Len > Urb->DataLen - TotalLen) {
           Len = Urb->DataLen - TotalLen;
-        } else {
-          Len = 0x10000;
         }
+        Remaining = Urb->DataLen - TotalLen - Len;
+
         TrbStart = (TRB *)(UINTN)EPRing->RingEnqueue;
         TrbStart->TrbNormal.TRBPtrLo  = XHC_LOW_32BIT((UINT8 *) Urb->DataPhy + TotalLen);
         TrbStart->TrbNormal.TRBPtrHi  = XHC_HIGH_32BIT((UINT8 *) Urb->DataPhy + TotalLen);
         TrbStart->TrbNormal.Length    = (UINT32) Len;
-        TrbStart->TrbNormal.TDSize    = 0;
+        //
+        // 4.11.2.4: the number of packets that remain in the TD after this TRB.
+        //
+        TrbStart->TrbNormal.TDSize    = (UINT32) MIN (31, (Remaining + Urb->Ep.MaxPacket - 1) / Urb->Ep.MaxPacket);
         TrbStart->TrbNormal.IntTarget = 0;
         TrbStart->TrbNormal.ISP       = 1;
-        TrbStart->TrbNormal.IOC       = 1;
+        TrbStart->TrbNormal.CH        = (Remaining != 0) ? 1 : 0;
+        TrbStart->TrbNormal.IOC       = (Remaining != 0) ? 0 : 1;
         TrbStart->TrbNormal.Type      = TRB_TYPE_NORMAL;
         //
+        // A Link TRB within a TD shall have its chain bit set as well.
+        //
+        LinkTrb = (LINK_TRB *) (TrbStart + 1);
+        if (LinkTrb->Type == TRB_TYPE_LINK) {
+          LinkTrb->CH = TrbStart->TrbNormal.CH;
+        }
+        //
         // Update the cycle bit
         //
         TrbStart->TrbNormal.CycleBit = EPRing->RingPCS & BIT0;
@@ -890,6 +911,7 @@ CreateTransferRing (
   TransferRing->RingEnqueue  = (TRB_TEMPLATE *) TransferRing->RingSeg0;
   TransferRing->RingDequeue  = (TRB_TEMPLATE *) TransferRing->RingSeg0;
   TransferRing->RingPCS      = 1;
+  TransferRing->ShortTdEnd   = NULL;
   //
   // 4.9.2 Transfer Ring Management
   // To form a ring (or circular queue) a Link TRB may be inserted at the end of a ring to
@@ -1155,6 +1177,19 @@ XhcCheckUrbResult (
       continue;
     }
 
+    //
+    // The trailing event of a TD that ended with a short packet precedes any
+    // event of the following TDs on the same ring. Drop it before it changes
+    // the state of the URB that now owns the TRB.
+    //
+    if (CheckedUrb->Ring->ShortTdEnd != NULL) {
+      if (TRBPtr == CheckedUrb->Ring->ShortTdEnd) {
+        CheckedUrb->Ring->ShortTdEnd = NULL;
+        continue;
+      }
+      CheckedUrb->Ring->ShortTdEnd = NULL;
+    }
+
     switch (EvtTrb->Completecode) {
       case TRB_COMPLETION_STALL_ERROR:
         CheckedUrb->Result  |= EFI_USB_ERR_STALL;
@@ -1197,6 +1232,32 @@ XhcCheckUrbResult (
         }
 
         TRBType = (UINT8) (TRBPtr->Type);
+        if ((CheckedUrb->Ep.Type == XHC_BULK_TRANSFER) && (TRBType == TRB_TYPE_NORMAL)) {
+          //
+          // A bulk URB is a single chained TD that raises an event on its
+          // last TRB, or on the TRB that received a short packet. In the
+          // latter case the xHC may still report the last TRB; ignore that.
+          // The data pointer of the TRB locates it within the URB's buffer.
+          //
+          if (CheckedUrb->Finished) {
+            continue;
+          }
+          PhyAddr = (EFI_PHYSICAL_ADDRESS) (((TRANSFER_TRB_NORMAL *) TRBPtr)->TRBPtrLo |
+                                            LShiftU64 ((UINT64) ((TRANSFER_TRB_NORMAL *) TRBPtr)->TRBPtrHi, 32));
+          CheckedUrb->Completed = (UINTN) (PhyAddr - (UINTN) CheckedUrb->DataPhy) +
+                                  ((TRANSFER_TRB_NORMAL *) TRBPtr)->Length - EvtTrb->Length;
+          if ((EvtTrb->Completecode == TRB_COMPLETION_SHORT_PACKET) || (TRBPtr == CheckedUrb->TrbEnd)) {
+            CheckedUrb->StartDone = TRUE;
+            CheckedUrb->EndDone   = TRUE;
+            CheckedUrb->Finished  = TRUE;
+            CheckedUrb->EvtTrb    = (TRB_TEMPLATE *) EvtTrb;
+            if (TRBPtr != CheckedUrb->TrbEnd) {
+              CheckedUrb->Ring->ShortTdEnd = CheckedUrb->TrbEnd;
+            }
+          }
+          continue;
+        }
+
         if ((TRBType == TRB_TYPE_DATA_STAGE) ||
             (TRBType == TRB_TYPE_NORMAL) ||
             (TRBType == TRB_TYPE_ISOCH)) {
@@ -144,6 +144,12 @@ typedef struct _TRANSFER_RING {
   TRB_TEMPLATE              *RingEnqueue;
   TRB_TEMPLATE              *RingDequeue;
   UINT32                    RingPCS;
+  //
+  // Last TRB of a chained bulk TD that ended early with a short packet. The
+  // xHC may still report it in a transfer event, which must be dropped even
+  // if a newer URB has reused the TRB by then.
+  //
+  TRB_TEMPLATE              *ShortTdEnd;
 } TRANSFER_RING;
 
 typedef struct _EVENT_RING {
@@ -823,7 +823,7 @@ UsbBootReadWriteBlocks (
   UINT32                     Timeout;
 
   BlockSize = UsbMass->BlockIoMedia.BlockSize;
-  CountMax  = USB_BOOT_MAX_CARRY_SIZE / BlockSize;
+  CountMax  = UsbMass->MaxCarrySize / BlockSize;
   Status    = EFI_SUCCESS;
 
   while (TotalBlock > 0) {
@@ -906,7 +906,7 @@ UsbBootReadWriteBlocks16 (
   UINT32                    Timeout;
 
   BlockSize = UsbMass->BlockIoMedia.BlockSize;
-  CountMax  = USB_BOOT_MAX_CARRY_SIZE / BlockSize;
+  CountMax  = UsbMass->MaxCarrySize / BlockSize;
   Status    = EFI_SUCCESS;
 
   while (TotalBlock > 0) {
@@ -956,6 +956,33 @@ UsbBootReadWriteBlocks16 (
   return Status;
 }
 
+/**
+  Get the largest amount of data a single read or write command may carry.
+
+  A device operating at SuperSpeed reports a bcdUSB of 0x0300 or higher;
+  such devices are given larger commands.
+
+  @param  UsbIo                  The USB I/O Protocol instance of the device.
+
+  @return The max carried size in bytes.
+
+**/
+UINT32
+UsbBootGetMaxCarrySize (
+  IN EFI_USB_IO_PROTOCOL    *UsbIo
+  )
+{
+  EFI_USB_DEVICE_DESCRIPTOR DevDesc;
+  EFI_STATUS                Status;
+
+  Status = UsbIo->UsbGetDeviceDescriptor (UsbIo, &DevDesc);
+  if (!EFI_ERROR (Status) && (DevDesc.BcdUSB >= 0x0300)) {
+    return USB_BOOT_MAX_CARRY_SIZE_SUPER_SPEED;
+  }
+
+  return USB_BOOT_MAX_CARRY_SIZE;
+}
+
 /**
   Use the USB clear feature control transfer to clear the endpoint stall condition.
 
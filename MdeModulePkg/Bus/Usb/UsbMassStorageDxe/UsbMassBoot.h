@@ -63,6 +63,12 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 //
 #define USB_BOOT_MAX_CARRY_SIZE         SIZE_64KB
 
+//
+// Max carried size for devices operating at SuperSpeed. Larger commands
+// amortize the CBW/CSW round trips of the BOT protocol.
+//
+#define USB_BOOT_MAX_CARRY_SIZE_SUPER_SPEED  SIZE_1MB
+
 //
 // Retry mass command times, set by experience
 //
@@ -318,6 +324,22 @@ UsbBootReadWriteBlocks16 (
   IN OUT UINT8              *Buffer
   );
 
+/**
+  Get the largest amount of data a single read or write command may carry.
+
+  A device operating at SuperSpeed reports a bcdUSB of 0x0300 or higher;
+  such devices are given larger commands.
+
+  @param  UsbIo                  The USB I/O Protocol instance of the device.
+
+  @return The max carried size in bytes.
+
+**/
+UINT32
+UsbBootGetMaxCarrySize (
+  IN EFI_USB_IO_PROTOCOL    *UsbIo
+  );
+
 /**
   Use the USB clear feature control transfer to clear the endpoint stall condition.
 
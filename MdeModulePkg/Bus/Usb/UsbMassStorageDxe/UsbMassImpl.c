@@ -485,10 +485,27 @@ UsbMassInitMultiLun (
   UINT8                            Index;
   EFI_STATUS                       Status;
   EFI_STATUS                       ReturnStatus;
+  UINT32                           MaxCarrySize;
 
   ASSERT (MaxLun > 0);
   ReturnStatus = EFI_NOT_FOUND;
 
+  //
+  // The LUNs share the bulk pipes of the device.
+  //
+  MaxCarrySize = USB_BOOT_MAX_CARRY_SIZE;
+  Status = gBS->OpenProtocol (
+                  Controller,
+                  &gEfiUsbIoProtocolGuid,
+                  (VOID **) &UsbIo,
+                  This->DriverBindingHandle,
+                  Controller,
+                  EFI_OPEN_PROTOCOL_GET_PROTOCOL
+                  );
+  if (!EFI_ERROR (Status)) {
+    MaxCarrySize = UsbBootGetMaxCarrySize (UsbIo);
+  }
+
   for (Index = 0; Index <= MaxLun; Index++) {
 
     DEBUG ((EFI_D_INFO, "UsbMassInitMultiLun: Start to initialize No.%d logic unit\n", Index));
@@ -508,6 +525,7 @@ UsbMassInitMultiLun (
     UsbMass->Transport            = Transport;
     UsbMass->Context              = Context;
     UsbMass->Lun                  = Index;
+    UsbMass->MaxCarrySize         = MaxCarrySize;
 
     //
     // Initialize the media parameter data for EFI_BLOCK_IO_MEDIA of Block I/O Protocol.
@@ -648,6 +666,7 @@ UsbMassInitNonLun (
   UsbMass->OpticalStorage       = FALSE;
   UsbMass->Transport            = Transport;
   UsbMass->Context              = Context;
+  UsbMass->MaxCarrySize         = UsbBootGetMaxCarrySize (UsbIo);
 
   //
   // Initialize the media parameter data for EFI_BLOCK_IO_MEDIA of Block I/O Protocol.
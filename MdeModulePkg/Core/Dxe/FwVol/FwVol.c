@@ -42,7 +42,10 @@ FV_DEVICE mFvDevice = {
   0,
   0,
   FALSE,
-  FALSE
+  FALSE,
+  NULL,
+  NULL,
+  0
 };
 
 
@@ -282,6 +285,10 @@ FreeFvDeviceResource (
     FfsFileEntry = (FFS_FILE_LIST_ENTRY *) NextEntry;
   }
 
+  if (FvDevice->FileEntryByOffset != NULL) {
+    CoreFreePool (FvDevice->FileEntryByOffset);
+  }
+
   if (!FvDevice->IsMemoryMapped) {
     //
     // Free the cached FV buffer.
@@ -299,6 +306,174 @@ FreeFvDeviceResource (
 
 
 
+/**
+  Find the file directory of the FV and index the FFS file list by offset so
+  that the directory entries can be mapped to it.
+
+  The FV file directory is only a lookup accelerator, so the FV is simply
+  treated as having no directory if it is malformed or if there are not
+  enough resources to index the file list.
+
+  @param  FvDevice              A pointer to the FvDevice whose file list
+                                has been built.
+
+**/
+VOID
+FvInitializeFileDirectory (
+  IN OUT FV_DEVICE  *FvDevice
+  )
+{
+  EFI_FIRMWARE_VOLUME_EXT_HEADER        *ExtHeader;
+  EFI_FIRMWARE_VOLUME_EXT_ENTRY         *ExtEntryList;
+  UINTN                                 ExtHeaderEnd;
+  UINT16                                ExtEntrySize;
+  EDKII_FV_FILE_DIRECTORY_HEADER        *Directory;
+  LIST_ENTRY                            *Link;
+  UINTN                                 Index;
+
+  FvDevice->FileDirectory     = NULL;
+  FvDevice->FileEntryByOffset = NULL;
+  FvDevice->FileEntryCount    = 0;
+
+  if (FvDevice->FwVolHeader->ExtHeaderOffset == 0) {
+    return;
+  }
+
+  //
+  // Find the file directory entry in the FV extension header.
+  //
+  Directory    = NULL;
+  ExtEntrySize = 0;
+  ExtHeader    = (EFI_FIRMWARE_VOLUME_EXT_HEADER *) (FvDevice->CachedFv + FvDevice->FwVolHeader->ExtHeaderOffset);
+  ExtHeaderEnd = (UINTN) ExtHeader + ReadUnaligned32 (&ExtHeader->ExtHeaderSize);
+  if (ExtHeaderEnd > (UINTN) FvDevice->EndOfCachedFv) {
+    return;
+  }
+  ExtEntryList = (EFI_FIRMWARE_VOLUME_EXT_ENTRY *) (ExtHeader + 1);
+  while ((UINTN) ExtEntryList + sizeof (EFI_FIRMWARE_VOLUME_EXT_ENTRY) <= ExtHeaderEnd) {
+    ExtEntrySize = ReadUnaligned16 (&ExtEntryList->ExtEntrySize);
+    if ((ExtEntrySize < sizeof (EFI_FIRMWARE_VOLUME_EXT_ENTRY)) ||
+        ((UINTN) ExtEntryList + ExtEntrySize > ExtHeaderEnd)) {
+      return;
+    }
+    if ((ReadUnaligned16 (&ExtEntryList->ExtEntryType) == EFI_FV_EXT_TYPE_GUID_TYPE) &&
+        (ExtEntrySize >= sizeof (EDKII_FV_FILE_DIRECTORY_HEADER)) &&
+        CompareGuid (&((EDKII_FV_FILE_DIRECTORY_HEADER *) ExtEntryList)->FormatType, &gEdkiiFvFileDirectoryGuid)) {
+      Directory = (EDKII_FV_FILE_DIRECTORY_HEADER *) ExtEntryList;
+      break;
+    }
+    ExtEntryList = (EFI_FIRMWARE_VOLUME_EXT_ENTRY *) ((UINT8 *) ExtEntryList + ExtEntrySize);
+  }
+
+  if ((Directory == NULL) ||
+      (ReadUnaligned32 (&Directory->EntryCount) >
+       (ExtEntrySize - sizeof (EDKII_FV_FILE_DIRECTORY_HEADER)) / sizeof (EDKII_FV_FILE_DIRECTORY_ENTRY))) {
+    return;
+  }
+
+  //
+  // The FFS file list is built in offset order, so flatten it into an array
+  // that can be binary searched by offset.
+  //
+  for (Link = GetFirstNode (&FvDevice->FfsFileListHeader);
+       !IsNull (&FvDevice->FfsFileListHeader, Link);
+       Link = GetNextNode (&FvDevice->FfsFileListHeader, Link)) {
+    FvDevice->FileEntryCount++;
+  }
+  if (FvDevice->FileEntryCount == 0) {
+    return;
+  }
+
+  FvDevice->FileEntryByOffset = AllocatePool (FvDevice->FileEntryCount * sizeof (FFS_FILE_LIST_ENTRY *));
+  if (FvDevice->FileEntryByOffset == NULL) {
+    FvDevice->FileEntryCount = 0;
+    return;
+  }
+
+  Index = 0;
+  for (Link = GetFirstNode (&FvDevice->FfsFileListHeader);
+       !IsNull (&FvDevice->FfsFileListHeader, Link);
+       Link = GetNextNode (&FvDevice->FfsFileListHeader, Link)) {
+    FvDevice->FileEntryByOffset[Index++] = (FFS_FILE_LIST_ENTRY *) Link;
+  }
+
+  FvDevice->FileDirectory = Directory;
+}
+
+/**
+  Look up a file by name in the file directory of the FV.
+
+  @param  FvDevice       Pointer to the FV_DEVICE of the firmware volume.
+  @param  NameGuid       Name of the file to look up.
+
+  @return The FFS file list entry of the file, or NULL if the FV has no file
+          directory or the file is not listed in it.
+
+**/
+FFS_FILE_LIST_ENTRY *
+FvFindFileInDirectory (
+  IN FV_DEVICE          *FvDevice,
+  IN CONST EFI_GUID     *NameGuid
+  )
+{
+  EDKII_FV_FILE_DIRECTORY_ENTRY         *Entry;
+  UINTN                                 EntryCount;
+  UINTN                                 Low;
+  UINTN                                 High;
+  UINTN                                 Middle;
+  UINTN                                 Offset;
+  FFS_FILE_LIST_ENTRY                   *FfsFileEntry;
+
+  if (FvDevice->FileDirectory == NULL) {
+    return NULL;
+  }
+
+  EntryCount = ReadUnaligned32 (&FvDevice->FileDirectory->EntryCount);
+  Entry      = (EDKII_FV_FILE_DIRECTORY_ENTRY *) (FvDevice->FileDirectory + 1);
+
+  //
+  // Binary search for the first directory entry whose name is not below NameGuid.
+  //
+  Low  = 0;
+  High = EntryCount;
+  while (Low < High) {
+    Middle = Low + (High - Low) / 2;
+    if (CompareMem (&Entry[Middle].Name, NameGuid, sizeof (EFI_GUID)) < 0) {
+      Low = Middle + 1;
+    } else {
+      High = Middle;
+    }
+  }
+  if ((Low == EntryCount) || !CompareGuid (&Entry[Low].Name, NameGuid)) {
+    return NULL;
+  }
+  Offset = ReadUnaligned32 (&Entry[Low].Offset);
+
+  //
+  // Binary search for the FFS file list entry at that offset.
+  //
+  Low  = 0;
+  High = FvDevice->FileEntryCount;
+  while (Low < High) {
+    Middle = Low + (High - Low) / 2;
+    if (FvDevice->FileEntryByOffset[Middle]->FileOffset < Offset) {
+      Low = Middle + 1;
+    } else {
+      High = Middle;
+    }
+  }
+  if (Low == FvDevice->FileEntryCount) {
+    return NULL;
+  }
+
+  FfsFileEntry = FvDevice->FileEntryByOffset[Low];
+  if ((FfsFileEntry->FileOffset != Offset) || !CompareGuid (&FfsFileEntry->FfsHeader->Name, NameGuid)) {
+    return NULL;
+  }
+
+  return FfsFileEntry;
+}
+
 /**
   Check if an FV is consistent and allocate cache for it.
 
@@ -535,6 +710,7 @@ FvCheck (
 
       FfsFileEntry->FfsHeader = CacheFfsHeader;
       FfsFileEntry->FileCached = FileCached;
+      FfsFileEntry->FileOffset = (UINTN) FfsHeader - (UINTN) FvDevice->CachedFv;
       FileCached = FALSE;
       InsertTailList (&FvDevice->FfsFileListHeader, &FfsFileEntry->Link);
     }
@@ -559,6 +735,8 @@ Done:
       FileCached = FALSE;
     }
     FreeFvDeviceResource (FvDevice);
+  } else {
+    FvInitializeFileDirectory (FvDevice);
   }
 
   return Status;
@@ -21,6 +21,10 @@ typedef struct {
   EFI_FFS_FILE_HEADER             *FfsHeader;
   UINTN                           StreamHandle;
   BOOLEAN                         FileCached;
+  //
+  // Offset of the file header from the beginning of the FV
+  //
+  UINTN                           FileOffset;
 } FFS_FILE_LIST_ENTRY;
 
 typedef struct {
@@ -41,6 +45,15 @@ typedef struct {
   UINT8                                   ErasePolarity;
   BOOLEAN                                 IsFfs3Fv;
   BOOLEAN                                 IsMemoryMapped;
+
+  //
+  // File directory found in the FV extension header, and the FFS file
+  // list entries sorted by offset that the directory entries refer to.
+  // FileDirectory is NULL if the FV has no usable file directory.
+  //
+  EDKII_FV_FILE_DIRECTORY_HEADER          *FileDirectory;
+  FFS_FILE_LIST_ENTRY                     **FileEntryByOffset;
+  UINTN                                   FileEntryCount;
 } FV_DEVICE;
 
 #define FV_DEVICE_FROM_THIS(a) CR(a, FV_DEVICE, Fv, FV2_DEVICE_SIGNATURE)
@@ -382,6 +395,23 @@ IsValidFfsHeader (
   );
 
 
+/**
+  Look up a file by name in the file directory of the FV.
+
+  @param  FvDevice       Pointer to the FV_DEVICE of the firmware volume.
+  @param  NameGuid       Name of the file to look up.
+
+  @return The FFS file list entry of the file, or NULL if the FV has no file
+          directory or the file is not listed in it.
+
+**/
+FFS_FILE_LIST_ENTRY *
+FvFindFileInDirectory (
+  IN FV_DEVICE          *FvDevice,
+  IN CONST EFI_GUID     *NameGuid
+  );
+
+
 /**
   Check if it's a valid FFS file.
   Here we are sure that it has a valid FFS file header since we must call IsValidFfsHeader() first.
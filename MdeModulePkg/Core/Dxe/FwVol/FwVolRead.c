@@ -288,6 +288,7 @@ FvReadFile (
   EFI_FFS_FILE_HEADER               *FfsHeader;
   UINTN                             InputBufferSize;
   UINTN                             WholeFileSize;
+  FFS_FILE_LIST_ENTRY               *FfsFileEntry;
 
   if (NameGuid == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -295,13 +296,13 @@ FvReadFile (
 
   FvDevice = FV_DEVICE_FROM_THIS (This);
 
-
-  //
-  // Keep looking until we find the matching NameGuid.
-  // The Key is really a FfsFileEntry
-  //
-  FvDevice->LastKey = 0;
-  do {
+  FfsFileEntry = FvFindFileInDirectory (FvDevice, NameGuid);
+  if (FfsFileEntry != NULL) {
+    //
+    // The FV file directory lists the file. Set the key to the previous
+    // FfsFileEntry (or the list head) so that FvGetNextFile() returns it.
+    //
+    FvDevice->LastKey = (FFS_FILE_LIST_ENTRY *) FfsFileEntry->Link.BackLink;
     LocalFoundType = 0;
     Status = FvGetNextFile (
               This,
@@ -311,10 +312,32 @@ FvReadFile (
               &LocalAttributes,
               &FileSize
               );
-    if (EFI_ERROR (Status)) {
-      return EFI_NOT_FOUND;
+    if (EFI_ERROR (Status) || !CompareGuid (&SearchNameGuid, NameGuid)) {
+      FfsFileEntry = NULL;
     }
-  } while (!CompareGuid (&SearchNameGuid, NameGuid));
+  }
+
+  if (FfsFileEntry == NULL) {
+    //
+    // Keep looking until we find the matching NameGuid.
+    // The Key is really a FfsFileEntry
+    //
+    FvDevice->LastKey = 0;
+    do {
+      LocalFoundType = 0;
+      Status = FvGetNextFile (
+                This,
+                &FvDevice->LastKey,
+                &LocalFoundType,
+                &SearchNameGuid,
+                &LocalAttributes,
+                &FileSize
+                );
+      if (EFI_ERROR (Status)) {
+        return EFI_NOT_FOUND;
+      }
+    } while (!CompareGuid (&SearchNameGuid, NameGuid));
+  }
 
   //
   // Get a pointer to the header
@@ -242,6 +242,111 @@ FileHandleToVolume (
   return NULL;
 }
 
+/**
+  Look up a file by name in the file directory of a firmware volume.
+
+  The file directory is an optional entry of the FV extension header that
+  lists the files of the FV sorted by name. The header at the listed offset is
+  checked to carry the searched name, but the caller still needs to validate
+  the state and checksums of the file.
+
+  @param FwVolHeader     Pointer to the FV header of the volume to search
+  @param FileName        File name
+
+  @return Pointer to the header of the file, or NULL if the FV has no file
+          directory or the file is not listed in it.
+
+**/
+EFI_FFS_FILE_HEADER *
+FindFileInFvFileDirectory (
+  IN CONST EFI_FIRMWARE_VOLUME_HEADER   *FwVolHeader,
+  IN CONST EFI_GUID                     *FileName
+  )
+{
+  UINT16                                ExtHeaderOffset;
+  EFI_FIRMWARE_VOLUME_EXT_HEADER        *ExtHeader;
+  EFI_FIRMWARE_VOLUME_EXT_ENTRY         *ExtEntryList;
+  UINTN                                 ExtHeaderEnd;
+  UINT16                                ExtEntrySize;
+  EDKII_FV_FILE_DIRECTORY_HEADER        *Directory;
+  EDKII_FV_FILE_DIRECTORY_ENTRY         *Entry;
+  UINT32                                EntryCount;
+  UINT32                                Low;
+  UINT32                                High;
+  UINT32                                Middle;
+  UINT32                                Offset;
+  EFI_FFS_FILE_HEADER                   *FfsFileHeader;
+
+  ExtHeaderOffset = ReadUnaligned16 (&FwVolHeader->ExtHeaderOffset);
+  if (ExtHeaderOffset == 0) {
+    return NULL;
+  }
+
+  //
+  // Find the file directory entry in the FV extension header.
+  //
+  Directory    = NULL;
+  ExtEntrySize = 0;
+  ExtHeader    = (EFI_FIRMWARE_VOLUME_EXT_HEADER *) ((UINT8 *) FwVolHeader + ExtHeaderOffset);
+  ExtHeaderEnd = (UINTN) ExtHeader + ReadUnaligned32 (&ExtHeader->ExtHeaderSize);
+  ExtEntryList = (EFI_FIRMWARE_VOLUME_EXT_ENTRY *) (ExtHeader + 1);
+  while ((UINTN) ExtEntryList + sizeof (EFI_FIRMWARE_VOLUME_EXT_ENTRY) <= ExtHeaderEnd) {
+    ExtEntrySize = ReadUnaligned16 (&ExtEntryList->ExtEntrySize);
+    if ((ExtEntrySize < sizeof (EFI_FIRMWARE_VOLUME_EXT_ENTRY)) ||
+        ((UINTN) ExtEntryList + ExtEntrySize > ExtHeaderEnd)) {
+      return NULL;
+    }
+    if ((ReadUnaligned16 (&ExtEntryList->ExtEntryType) == EFI_FV_EXT_TYPE_GUID_TYPE) &&
+        (ExtEntrySize >= sizeof (EDKII_FV_FILE_DIRECTORY_HEADER)) &&
+        CompareGuid (&((EDKII_FV_FILE_DIRECTORY_HEADER *) ExtEntryList)->FormatType, &gEdkiiFvFileDirectoryGuid)) {
+      Directory = (EDKII_FV_FILE_DIRECTORY_HEADER *) ExtEntryList;
+      break;
+    }
+    ExtEntryList = (EFI_FIRMWARE_VOLUME_EXT_ENTRY *) ((UINT8 *) ExtEntryList + ExtEntrySize);
+  }
+
+  if (Directory == NULL) {
+    return NULL;
+  }
+
+  EntryCount = ReadUnaligned32 (&Directory->EntryCount);
+  if (EntryCount > (ExtEntrySize - sizeof (EDKII_FV_FILE_DIRECTORY_HEADER)) / sizeof (EDKII_FV_FILE_DIRECTORY_ENTRY)) {
+    return NULL;
+  }
+  Entry = (EDKII_FV_FILE_DIRECTORY_ENTRY *) (Directory + 1);
+
+  //
+  // Binary search for the first entry whose name is not below FileName.
+  //
+  Low  = 0;
+  High = EntryCount;
+  while (Low < High) {
+    Middle = Low + (High - Low) / 2;
+    if (CompareMem (&Entry[Middle].Name, FileName, sizeof (EFI_GUID)) < 0) {
+      Low = Middle + 1;
+    } else {
+      High = Middle;
+    }
+  }
+  if ((Low == EntryCount) || !CompareGuid (&Entry[Low].Name, FileName)) {
+    return NULL;
+  }
+
+  Offset = ReadUnaligned32 (&Entry[Low].Offset);
+  if ((Offset < ReadUnaligned16 (&FwVolHeader->HeaderLength)) ||
+      ((Offset & 0x07) != 0) ||
+      (Offset >= FwVolHeader->FvLength - sizeof (EFI_FFS_FILE_HEADER))) {
+    return NULL;
+  }
+
+  FfsFileHeader = (EFI_FFS_FILE_HEADER *) ((UINT8 *) FwVolHeader + Offset);
+  if (!CompareGuid (&FfsFileHeader->Name, FileName)) {
+    return NULL;
+  }
+
+  return FfsFileHeader;
+}
+
 /**
   Given the input file pointer, search for the first matching file in the
   FFS volume as defined by SearchType. The search starts from FileHeader inside
@@ -249,6 +354,8 @@ FileHandleToVolume (
   If SearchType is EFI_FV_FILETYPE_ALL, the first FFS file will return without check its file type.
   If SearchType is PEI_CORE_INTERNAL_FFS_FILE_DISPATCH_TYPE,
   the first PEIM, or COMBINED PEIM or FV file type FFS file will return.
+  If FileName is not NULL and the FV has a file directory, the search starts
+  from the file listed in the directory.
 
   @param FvHandle        Pointer to the FV header of the volume to search
   @param FileName        File name
@@ -274,6 +381,8 @@ FindFileEx (
   EFI_FIRMWARE_VOLUME_EXT_HEADER        *FwVolExtHeader;
   EFI_FFS_FILE_HEADER                   **FileHeader;
   EFI_FFS_FILE_HEADER                   *FfsFileHeader;
+  EFI_FFS_FILE_HEADER                   *FirstFileHeader;
+  EFI_FFS_FILE_HEADER                   *DirectoryFileHeader;
   UINT32                                FileLength;
   UINT32                                FileOccupiedSize;
   UINT32                                FileOffset;
@@ -303,6 +412,8 @@ FindFileEx (
   // start with the first file in the firmware volume.  Otherwise,
   // start from the FileHeader.
   //
+  FirstFileHeader     = NULL;
+  DirectoryFileHeader = NULL;
   if ((*FileHeader == NULL) || (FileName != NULL)) {
     if (FwVolHeader->ExtHeaderOffset != 0) {
       //
@@ -314,6 +425,18 @@ FindFileEx (
       FfsFileHeader = (EFI_FFS_FILE_HEADER *)((UINT8 *) FwVolHeader + FwVolHeader->HeaderLength);
     }
     FfsFileHeader = (EFI_FFS_FILE_HEADER *) ALIGN_POINTER (FfsFileHeader, 8);
+
+    if (FileName != NULL) {
+      //
+      // Start with the file listed in the FV file directory, if any. The
+      // search falls back to the first file if it turns out not to match.
+      //
+      DirectoryFileHeader = FindFileInFvFileDirectory (FwVolHeader, FileName);
+      if (DirectoryFileHeader != NULL) {
+        FirstFileHeader = FfsFileHeader;
+        FfsFileHeader   = DirectoryFileHeader;
+      }
+    }
   } else {
     if (IS_FFS_FILE2 (*FileHeader)) {
       if (!IsFfs3Fv) {
@@ -358,6 +481,12 @@ FindFileEx (
     case EFI_FILE_DATA_VALID:
     case EFI_FILE_MARKED_FOR_UPDATE:
       if (CalculateHeaderChecksum (FfsFileHeader) != 0) {
+        if (DirectoryFileHeader != NULL) {
+          //
+          // A stale or corrupt directory entry is a miss, see below.
+          //
+          break;
+        }
         ASSERT (FALSE);
         *FileHeader = NULL;
         return EFI_NOT_FOUND;
@@ -378,6 +507,10 @@ FindFileEx (
         FileOccupiedSize = GET_OCCUPIED_SIZE (FileLength, 8);
       }
 
+      if ((DirectoryFileHeader != NULL) && (FileLength > FvLength - FileOffset)) {
+        break;
+      }
+
       DataCheckSum = FFS_FIXED_CHECKSUM;
       if ((FfsFileHeader->Attributes & FFS_ATTRIB_CHECKSUM) == FFS_ATTRIB_CHECKSUM) {
         if (IS_FFS_FILE2 (FfsFileHeader)) {
@@ -387,6 +520,9 @@ FindFileEx (
         }
       }
       if (FfsFileHeader->IntegrityCheck.Checksum.File != DataCheckSum) {
+        if (DirectoryFileHeader != NULL) {
+          break;
+        }
         ASSERT (FALSE);
         *FileHeader = NULL;
         return EFI_NOT_FOUND;
@@ -437,9 +573,22 @@ FindFileEx (
       break;
 
     default:
+      if (DirectoryFileHeader != NULL) {
+        break;
+      }
       *FileHeader = NULL;
       return EFI_NOT_FOUND;
     }
+
+    if (DirectoryFileHeader != NULL) {
+      //
+      // The file listed in the FV file directory is not a valid match, or
+      // not a valid file at all, so scan the FV from the first file.
+      //
+      DirectoryFileHeader = NULL;
+      FfsFileHeader       = FirstFileHeader;
+      FileOffset          = (UINT32) ((UINT8 *) FfsFileHeader - (UINT8 *) FwVolHeader);
+    }
   }
 
   *FileHeader = NULL;
@@ -302,6 +302,27 @@ FindFileEx (
   IN OUT    EFI_PEI_FILE_HANDLE      *AprioriFile  OPTIONAL
   );
 
+/**
+  Look up a file by name in the file directory of a firmware volume.
+
+  The file directory is an optional entry of the FV extension header that
+  lists the files of the FV sorted by name. The header at the listed offset is
+  checked to carry the searched name, but the caller still needs to validate
+  the state and checksums of the file.
+
+  @param FwVolHeader     Pointer to the FV header of the volume to search
+  @param FileName        File name
+
+  @return Pointer to the header of the file, or NULL if the FV has no file
+          directory or the file is not listed in it.
+
+**/
+EFI_FFS_FILE_HEADER *
+FindFileInFvFileDirectory (
+  IN CONST EFI_FIRMWARE_VOLUME_HEADER   *FwVolHeader,
+  IN CONST EFI_GUID                     *FileName
+  );
+
 /**
   Report the information for a newly discovered FV in an unknown format.
 
@@ -45,6 +45,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Guid/FirmwareFileSystem3.h>
 #include <Guid/AprioriFileName.h>
 #include <Guid/MigratedFvInfo.h>
+#include <Guid/FvFileDirectory.h>
 
 ///
 /// It is an FFS type extension used for PeiFindFileEx. It indicates current
@@ -68,6 +69,30 @@ typedef union {
 #define CALLBACK_NOTIFY_GROWTH_STEP 32
 #define DISPATCH_NOTIFY_GROWTH_STEP 8
 
+///
+/// Number of buckets in the GUID hash index of each PPI and notify list.
+/// It must be a power of two.
+///
+#define PPI_HASH_BUCKET_COUNT       32
+
+///
+/// GUID hash index of a PEI_PPI_LIST_POINTERS array.
+///
+/// Entries of a bucket are chained by list index in installation order. A
+/// link holds the list index plus one so that zero terminates a chain and a
+/// zeroed index is empty. As only indexes are stored, the index stays valid
+/// when the lists are migrated from temporary memory; just the Next array
+/// itself has to be relocated.
+///
+typedef struct {
+  UINT16                BucketHead[PPI_HASH_BUCKET_COUNT];
+  UINT16                BucketTail[PPI_HASH_BUCKET_COUNT];
+  ///
+  /// MaxCount number of entries, parallel to the list pointers.
+  ///
+  UINT16                *Next;
+} PEI_PPI_HASH_INDEX;
+
 typedef struct {
   UINTN                 CurrentCount;
   UINTN                 MaxCount;
@@ -76,6 +101,7 @@ typedef struct {
   /// MaxCount number of entries.
   ///
   PEI_PPI_LIST_POINTERS *PpiPtrs;
+  PEI_PPI_HASH_INDEX    HashIndex;
 } PEI_PPI_LIST;
 
 typedef struct {
@@ -85,6 +111,7 @@ typedef struct {
   /// MaxCount number of entries.
   ///
   PEI_PPI_LIST_POINTERS *NotifyPtrs;
+  PEI_PPI_HASH_INDEX    HashIndex;
 } PEI_CALLBACK_NOTIFY_LIST;
 
 typedef struct {
@@ -95,6 +122,7 @@ typedef struct {
   /// MaxCount number of entries.
   ///
   PEI_PPI_LIST_POINTERS *NotifyPtrs;
+  PEI_PPI_HASH_INDEX    HashIndex;
 } PEI_DISPATCH_NOTIFY_LIST;
 
 ///
@@ -214,12 +214,21 @@ PeiCore (
         if (OldCoreData->PpiData.PpiList.PpiPtrs != NULL) {
           OldCoreData->PpiData.PpiList.PpiPtrs = (PEI_PPI_LIST_POINTERS *) ((UINT8 *) OldCoreData->PpiData.PpiList.PpiPtrs + OldCoreData->HeapOffset);
         }
+        if (OldCoreData->PpiData.PpiList.HashIndex.Next != NULL) {
+          OldCoreData->PpiData.PpiList.HashIndex.Next = (UINT16 *) ((UINT8 *) OldCoreData->PpiData.PpiList.HashIndex.Next + OldCoreData->HeapOffset);
+        }
         if (OldCoreData->PpiData.CallbackNotifyList.NotifyPtrs != NULL) {
           OldCoreData->PpiData.CallbackNotifyList.NotifyPtrs = (PEI_PPI_LIST_POINTERS *) ((UINT8 *) OldCoreData->PpiData.CallbackNotifyList.NotifyPtrs + OldCoreData->HeapOffset);
         }
+        if (OldCoreData->PpiData.CallbackNotifyList.HashIndex.Next != NULL) {
+          OldCoreData->PpiData.CallbackNotifyList.HashIndex.Next = (UINT16 *) ((UINT8 *) OldCoreData->PpiData.CallbackNotifyList.HashIndex.Next + OldCoreData->HeapOffset);
+        }
         if (OldCoreData->PpiData.DispatchNotifyList.NotifyPtrs != NULL) {
           OldCoreData->PpiData.DispatchNotifyList.NotifyPtrs = (PEI_PPI_LIST_POINTERS *) ((UINT8 *) OldCoreData->PpiData.DispatchNotifyList.NotifyPtrs + OldCoreData->HeapOffset);
         }
+        if (OldCoreData->PpiData.DispatchNotifyList.HashIndex.Next != NULL) {
+          OldCoreData->PpiData.DispatchNotifyList.HashIndex.Next = (UINT16 *) ((UINT8 *) OldCoreData->PpiData.DispatchNotifyList.HashIndex.Next + OldCoreData->HeapOffset);
+        }
         OldCoreData->Fv                   = (PEI_CORE_FV_HANDLE *) ((UINT8 *) OldCoreData->Fv + OldCoreData->HeapOffset);
         for (Index = 0; Index < OldCoreData->FvCount; Index ++) {
           if (OldCoreData->Fv[Index].PeimState != NULL) {
@@ -242,12 +251,21 @@ PeiCore (
         if (OldCoreData->PpiData.PpiList.PpiPtrs != NULL) {
           OldCoreData->PpiData.PpiList.PpiPtrs = (PEI_PPI_LIST_POINTERS *) ((UINT8 *) OldCoreData->PpiData.PpiList.PpiPtrs - OldCoreData->HeapOffset);
         }
+        if (OldCoreData->PpiData.PpiList.HashIndex.Next != NULL) {
+          OldCoreData->PpiData.PpiList.HashIndex.Next = (UINT16 *) ((UINT8 *) OldCoreData->PpiData.PpiList.HashIndex.Next - OldCoreData->HeapOffset);
+        }
         if (OldCoreData->PpiData.CallbackNotifyList.NotifyPtrs != NULL) {
           OldCoreData->PpiData.CallbackNotifyList.NotifyPtrs = (PEI_PPI_LIST_POINTERS *) ((UINT8 *) OldCoreData->PpiData.CallbackNotifyList.NotifyPtrs - OldCoreData->HeapOffset);
         }
+        if (OldCoreData->PpiData.CallbackNotifyList.HashIndex.Next != NULL) {
+          OldCoreData->PpiData.CallbackNotifyList.HashIndex.Next = (UINT16 *) ((UINT8 *) OldCoreData->PpiData.CallbackNotifyList.HashIndex.Next - OldCoreData->HeapOffset);
+        }
         if (OldCoreData->PpiData.DispatchNotifyList.NotifyPtrs != NULL) {
           OldCoreData->PpiData.DispatchNotifyList.NotifyPtrs = (PEI_PPI_LIST_POINTERS *) ((UINT8 *) OldCoreData->PpiData.DispatchNotifyList.NotifyPtrs - OldCoreData->HeapOffset);
         }
+        if (OldCoreData->PpiData.DispatchNotifyList.HashIndex.Next != NULL) {
+          OldCoreData->PpiData.DispatchNotifyList.HashIndex.Next = (UINT16 *) ((UINT8 *) OldCoreData->PpiData.DispatchNotifyList.HashIndex.Next - OldCoreData->HeapOffset);
+        }
         OldCoreData->Fv                   = (PEI_CORE_FV_HANDLE *) ((UINT8 *) OldCoreData->Fv - OldCoreData->HeapOffset);
         for (Index = 0; Index < OldCoreData->FvCount; Index ++) {
           if (OldCoreData->Fv[Index].PeimState != NULL) {
@@ -164,6 +164,11 @@ ConvertPpiPointers (
 {
   UINT8                 Index;
 
+  //
+  // The GUID hash indexes of the lists only hold list indexes, so they need
+  // no conversion here. Their Next arrays are migrated with the heap.
+  //
+
   //
   // Convert normal PPIs.
   //
@@ -419,6 +424,115 @@ DumpPpiList (
   DEBUG_CODE_END ();
 }
 
+/**
+
+  Compute the bucket of a GUID in a PPI hash index.
+
+  @param Guid            Pointer to the GUID.
+
+  @return The bucket number, which is less than PPI_HASH_BUCKET_COUNT.
+
+**/
+UINTN
+PpiHashGuid (
+  IN CONST EFI_GUID     *Guid
+  )
+{
+  UINT32                Hash;
+
+  //
+  // Fold the first and last 32 bits of the GUID, which are the most random
+  // ones for both time based and random GUIDs.
+  //
+  Hash  = ((UINT32 *)Guid)[0] ^ ((UINT32 *)Guid)[3];
+  Hash ^= Hash >> 16;
+  Hash ^= Hash >> 8;
+  return (UINTN) (Hash & (PPI_HASH_BUCKET_COUNT - 1));
+}
+
+/**
+
+  Grow the Next array of a PPI hash index along with the list it indexes.
+
+  @param HashIndex       Pointer to the hash index.
+  @param OldCount        Current number of entries of the Next array.
+  @param NewCount        New number of entries of the Next array.
+
+**/
+VOID
+GrowPpiHashIndex (
+  IN OUT PEI_PPI_HASH_INDEX   *HashIndex,
+  IN     UINTN                OldCount,
+  IN     UINTN                NewCount
+  )
+{
+  VOID                  *TempPtr;
+
+  //
+  // Links are stored as UINT16 (list index plus one).
+  //
+  ASSERT (NewCount < MAX_UINT16);
+
+  TempPtr = AllocateZeroPool (sizeof (UINT16) * NewCount);
+  ASSERT (TempPtr != NULL);
+  CopyMem (TempPtr, HashIndex->Next, sizeof (UINT16) * OldCount);
+  HashIndex->Next = TempPtr;
+}
+
+/**
+
+  Append a list entry to the tail of the chain of its GUID bucket.
+
+  @param HashIndex       Pointer to the hash index.
+  @param Index           Index of the entry in the list.
+  @param Guid            Pointer to the GUID of the entry.
+
+**/
+VOID
+InsertPpiHashIndex (
+  IN OUT PEI_PPI_HASH_INDEX   *HashIndex,
+  IN     UINTN                Index,
+  IN     CONST EFI_GUID       *Guid
+  )
+{
+  UINTN                 Bucket;
+
+  Bucket = PpiHashGuid (Guid);
+  HashIndex->Next[Index] = 0;
+  if (HashIndex->BucketTail[Bucket] == 0) {
+    HashIndex->BucketHead[Bucket] = (UINT16) (Index + 1);
+  } else {
+    HashIndex->Next[HashIndex->BucketTail[Bucket] - 1] = (UINT16) (Index + 1);
+  }
+  HashIndex->BucketTail[Bucket] = (UINT16) (Index + 1);
+}
+
+/**
+
+  Rebuild a PPI hash index from the first entries of the list it indexes.
+  It is used when entries are removed from or replaced in the list.
+
+  @param HashIndex       Pointer to the hash index.
+  @param ListPtrs        Pointer to the list of PPI or notify descriptors.
+  @param Count           Number of entries of the list to index.
+
+**/
+VOID
+RebuildPpiHashIndex (
+  IN OUT PEI_PPI_HASH_INDEX     *HashIndex,
+  IN     PEI_PPI_LIST_POINTERS  *ListPtrs,
+  IN     UINTN                  Count
+  )
+{
+  UINTN                 Index;
+
+  ZeroMem (HashIndex->BucketHead, sizeof (HashIndex->BucketHead));
+  ZeroMem (HashIndex->BucketTail, sizeof (HashIndex->BucketTail));
+  for (Index = 0; Index < Count; Index++) {
+    InsertPpiHashIndex (HashIndex, Index, ListPtrs[Index].Ppi->Guid);
+  }
+}
+
 /**
 
   This function installs an interface in the PEI PPI database by GUID.
@@ -474,6 +588,7 @@ InternalPeiInstallPpi (
     //
     if ((PpiList->Flags & EFI_PEI_PPI_DESCRIPTOR_PPI) == 0) {
       PpiListPointer->CurrentCount = LastCount;
+      RebuildPpiHashIndex (&PpiListPointer->HashIndex, PpiListPointer->PpiPtrs, LastCount);
       DEBUG((EFI_D_ERROR, "ERROR -> InstallPpi: %g %p\n", PpiList->Guid, PpiList->Ppi));
       return  EFI_INVALID_PARAMETER;
     }
@@ -492,11 +607,17 @@ InternalPeiInstallPpi (
         sizeof (PEI_PPI_LIST_POINTERS) * PpiListPointer->MaxCount
         );
       PpiListPointer->PpiPtrs = TempPtr;
+      GrowPpiHashIndex (
+        &PpiListPointer->HashIndex,
+        PpiListPointer->MaxCount,
+        PpiListPointer->MaxCount + PPI_GROWTH_STEP
+        );
       PpiListPointer->MaxCount = PpiListPointer->MaxCount + PPI_GROWTH_STEP;
     }
 
     DEBUG((EFI_D_INFO, "Install PPI: %g\n", PpiList->Guid));
     PpiListPointer->PpiPtrs[Index].Ppi = (EFI_PEI_PPI_DESCRIPTOR *) PpiList;
+    InsertPpiHashIndex (&PpiListPointer->HashIndex, Index, PpiList->Guid);
     Index++;
     PpiListPointer->CurrentCount++;
 
@@ -585,6 +706,7 @@ PeiReInstallPpi (
 {
   PEI_CORE_INSTANCE   *PrivateData;
   UINTN               Index;
+  BOOLEAN             SameBucket;
 
 
   if ((OldPpi == NULL) || (NewPpi == NULL)) {
@@ -614,7 +736,15 @@ PeiReInstallPpi (
   // Replace the old PPI with the new one.
   //
   DEBUG((EFI_D_INFO, "Reinstall PPI: %g\n", NewPpi->Guid));
+  SameBucket = (BOOLEAN) (PpiHashGuid (OldPpi->Guid) == PpiHashGuid (NewPpi->Guid));
   PrivateData->PpiData.PpiList.PpiPtrs[Index].Ppi = (EFI_PEI_PPI_DESCRIPTOR *) NewPpi;
+  if (!SameBucket) {
+    RebuildPpiHashIndex (
+      &PrivateData->PpiData.PpiList.HashIndex,
+      PrivateData->PpiData.PpiList.PpiPtrs,
+      PrivateData->PpiData.PpiList.CurrentCount
+      );
+  }
 
   //
   // Process any callback level notifies for the newly installed PPI.
@@ -666,10 +796,13 @@ PeiLocatePpi (
   PrivateData = PEI_CORE_INSTANCE_FROM_PS_THIS(PeiServices);
 
   //
-  // Search the data base for the matching instance of the GUIDed PPI.
+  // Search the hash chain of the GUID for the matching instance of the GUIDed PPI.
+  // The chain holds the PPIs in installation order.
   //
-  for (Index = 0; Index < PrivateData->PpiData.PpiList.CurrentCount; Index++) {
-    TempPtr = PrivateData->PpiData.PpiList.PpiPtrs[Index].Ppi;
+  for (Index = PrivateData->PpiData.PpiList.HashIndex.BucketHead[PpiHashGuid (Guid)];
+       Index != 0;
+       Index = PrivateData->PpiData.PpiList.HashIndex.Next[Index - 1]) {
+    TempPtr = PrivateData->PpiData.PpiList.PpiPtrs[Index - 1].Ppi;
     CheckGuid = TempPtr->Guid;
 
     //
@@ -761,6 +894,8 @@ InternalPeiNotifyPpi (
     if ((NotifyList->Flags & EFI_PEI_PPI_DESCRIPTOR_NOTIFY_TYPES) == 0) {
         CallbackNotifyListPointer->CurrentCount = LastCallbackNotifyCount;
         DispatchNotifyListPointer->CurrentCount = LastDispatchNotifyCount;
+        RebuildPpiHashIndex (&CallbackNotifyListPointer->HashIndex, CallbackNotifyListPointer->NotifyPtrs, LastCallbackNotifyCount);
+        RebuildPpiHashIndex (&DispatchNotifyListPointer->HashIndex, DispatchNotifyListPointer->NotifyPtrs, LastDispatchNotifyCount);
         DEBUG((DEBUG_ERROR, "ERROR -> NotifyPpi: %g %p\n", NotifyList->Guid, NotifyList->Notify));
       return  EFI_INVALID_PARAMETER;
     }
@@ -780,9 +915,15 @@ InternalPeiNotifyPpi (
           sizeof (PEI_PPI_LIST_POINTERS) * CallbackNotifyListPointer->MaxCount
           );
         CallbackNotifyListPointer->NotifyPtrs = TempPtr;
+        GrowPpiHashIndex (
+          &CallbackNotifyListPointer->HashIndex,
+          CallbackNotifyListPointer->MaxCount,
+          CallbackNotifyListPointer->MaxCount + CALLBACK_NOTIFY_GROWTH_STEP
+          );
         CallbackNotifyListPointer->MaxCount = CallbackNotifyListPointer->MaxCount + CALLBACK_NOTIFY_GROWTH_STEP;
       }
       CallbackNotifyListPointer->NotifyPtrs[CallbackNotifyIndex].Notify = (EFI_PEI_NOTIFY_DESCRIPTOR *) NotifyList;
+      InsertPpiHashIndex (&CallbackNotifyListPointer->HashIndex, CallbackNotifyIndex, NotifyList->Guid);
       CallbackNotifyIndex++;
       CallbackNotifyListPointer->CurrentCount++;
     } else {
@@ -800,9 +941,15 @@ InternalPeiNotifyPpi (
           sizeof (PEI_PPI_LIST_POINTERS) * DispatchNotifyListPointer->MaxCount
           );
         DispatchNotifyListPointer->NotifyPtrs = TempPtr;
+        GrowPpiHashIndex (
+          &DispatchNotifyListPointer->HashIndex,
+          DispatchNotifyListPointer->MaxCount,
+          DispatchNotifyListPointer->MaxCount + DISPATCH_NOTIFY_GROWTH_STEP
+          );
         DispatchNotifyListPointer->MaxCount = DispatchNotifyListPointer->MaxCount + DISPATCH_NOTIFY_GROWTH_STEP;
       }
       DispatchNotifyListPointer->NotifyPtrs[DispatchNotifyIndex].Notify = (EFI_PEI_NOTIFY_DESCRIPTOR *) NotifyList;
+      InsertPpiHashIndex (&DispatchNotifyListPointer->HashIndex, DispatchNotifyIndex, NotifyList->Guid);
       DispatchNotifyIndex++;
       DispatchNotifyListPointer->CurrentCount++;
     }
@@ -957,18 +1104,80 @@ ProcessNotify (
   EFI_GUID                      *SearchGuid;
   EFI_GUID                      *CheckGuid;
   EFI_PEI_NOTIFY_DESCRIPTOR     *NotifyDescriptor;
+  PEI_PPI_LIST_POINTERS         **NotifyPtrs;
+  PEI_PPI_HASH_INDEX            *NotifyHashIndex;
+  PEI_PPI_HASH_INDEX            *PpiHashIndex;
 
-  for (Index1 = NotifyStartIndex; Index1 < NotifyStopIndex; Index1++) {
-    if (NotifyType == EFI_PEI_PPI_DESCRIPTOR_NOTIFY_CALLBACK) {
-      NotifyDescriptor = PrivateData->PpiData.CallbackNotifyList.NotifyPtrs[Index1].Notify;
-    } else {
-      NotifyDescriptor = PrivateData->PpiData.DispatchNotifyList.NotifyPtrs[Index1].Notify;
+  if (NotifyType == EFI_PEI_PPI_DESCRIPTOR_NOTIFY_CALLBACK) {
+    NotifyPtrs      = &PrivateData->PpiData.CallbackNotifyList.NotifyPtrs;
+    NotifyHashIndex = &PrivateData->PpiData.CallbackNotifyList.HashIndex;
+  } else {
+    NotifyPtrs      = &PrivateData->PpiData.DispatchNotifyList.NotifyPtrs;
+    NotifyHashIndex = &PrivateData->PpiData.DispatchNotifyList.HashIndex;
+  }
+  PpiHashIndex = &PrivateData->PpiData.PpiList.HashIndex;
+
+  //
+  // The lists and the Next arrays of their hash indexes may be reallocated by
+  // the notification functions, so they are always accessed through the
+  // database instead of cached pointers. Entries added by the notification
+  // functions have indexes beyond the stop indexes and are not processed here.
+  //
+  if (InstallStopIndex - InstallStartIndex == 1) {
+    //
+    // Fast path for a single installed PPI, which is the case of every
+    // InstallPpi() with a single descriptor and of every ReInstallPpi():
+    // only the notifies hashed to the same bucket need to be checked.
+    //
+    SearchGuid = PrivateData->PpiData.PpiList.PpiPtrs[InstallStartIndex].Ppi->Guid;
+    for (Index1 = NotifyHashIndex->BucketHead[PpiHashGuid (SearchGuid)];
+         (Index1 != 0) && (Index1 <= NotifyStopIndex);
+         Index1 = NotifyHashIndex->Next[Index1 - 1]) {
+      if (Index1 <= NotifyStartIndex) {
+        continue;
+      }
+
+      NotifyDescriptor = (*NotifyPtrs)[Index1 - 1].Notify;
+      CheckGuid = NotifyDescriptor->Guid;
+      //
+      // Don't use CompareGuid function here for performance reasons.
+      // Instead we compare the GUID as INT32 at a time and branch
+      // on the first failed comparison.
+      //
+      if ((((INT32 *)SearchGuid)[0] == ((INT32 *)CheckGuid)[0]) &&
+          (((INT32 *)SearchGuid)[1] == ((INT32 *)CheckGuid)[1]) &&
+          (((INT32 *)SearchGuid)[2] == ((INT32 *)CheckGuid)[2]) &&
+          (((INT32 *)SearchGuid)[3] == ((INT32 *)CheckGuid)[3])) {
+        DEBUG ((EFI_D_INFO, "Notify: PPI Guid: %g, Peim notify entry point: %p\n",
+          SearchGuid,
+          NotifyDescriptor->Notify
+          ));
+        NotifyDescriptor->Notify (
+                            (EFI_PEI_SERVICES **) GetPeiServicesTablePointer (),
+                            NotifyDescriptor,
+                            (PrivateData->PpiData.PpiList.PpiPtrs[InstallStartIndex].Ppi)->Ppi
+                            );
+      }
     }
+    return;
+  }
+
+  for (Index1 = NotifyStartIndex; Index1 < NotifyStopIndex; Index1++) {
+    NotifyDescriptor = (*NotifyPtrs)[Index1].Notify;
 
     CheckGuid = NotifyDescriptor->Guid;
 
-    for (Index2 = InstallStartIndex; Index2 < InstallStopIndex; Index2++) {
-      SearchGuid = PrivateData->PpiData.PpiList.PpiPtrs[Index2].Ppi->Guid;
+    //
+    // Only walk the installed PPIs hashed to the bucket of the notify GUID.
+    //
+    for (Index2 = PpiHashIndex->BucketHead[PpiHashGuid (CheckGuid)];
+         (Index2 != 0) && (Index2 <= InstallStopIndex);
+         Index2 = PpiHashIndex->Next[Index2 - 1]) {
+      if (Index2 <= InstallStartIndex) {
+        continue;
+      }
+
+      SearchGuid = PrivateData->PpiData.PpiList.PpiPtrs[Index2 - 1].Ppi->Guid;
       //
       // Don't use CompareGuid function here for performance reasons.
       // Instead we compare the GUID as INT32 at a time and branch
@@ -985,7 +1194,7 @@ ProcessNotify (
         NotifyDescriptor->Notify (
                             (EFI_PEI_SERVICES **) GetPeiServicesTablePointer (),
                             NotifyDescriptor,
-                            (PrivateData->PpiData.PpiList.PpiPtrs[Index2].Ppi)->Ppi
+                            (PrivateData->PpiData.PpiList.PpiPtrs[Index2 - 1].Ppi)->Ppi
                             );
       }
     }
@@ -0,0 +1,64 @@
+/** @file
+  Firmware volume file directory.
+
+  The file directory is an optional EFI_FV_EXT_TYPE_GUID_TYPE entry of the
+  firmware volume extension header, generated by GenFv. It lists the name and
+  the offset of every file of the firmware volume, sorted by name, so that the
+  PEI and DXE cores can look up a file by name without walking all the FFS
+  file headers. Files are sorted by comparing their names as byte arrays, and
+  files with the same name are listed in the order they appear in the FV.
+
+  The directory only describes the firmware volume as it was built. Consumers
+  must check the file header found at the listed offset, and must fall back
+  to a scan of the firmware volume if it does not match or if the name is not
+  listed and the firmware volume may have been written since it was built.
+
+Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __EDKII_FV_FILE_DIRECTORY_GUID_H__
+#define __EDKII_FV_FILE_DIRECTORY_GUID_H__
+
+#define EDKII_FV_FILE_DIRECTORY_GUID \
+  { \
+    0xfb433b49, 0x4ea7, 0x46ff, { 0xac, 0x73, 0xe0, 0x91, 0xae, 0x80, 0x91, 0x3e } \
+  }
+
+#pragma pack(1)
+
+typedef struct {
+  ///
+  /// Name of the FFS file.
+  ///
+  EFI_GUID                          Name;
+  ///
+  /// Offset of the FFS file header from the beginning of the firmware volume.
+  ///
+  UINT32                            Offset;
+} EDKII_FV_FILE_DIRECTORY_ENTRY;
+
+typedef struct {
+  ///
+  /// Standard extension entry, with the type EFI_FV_EXT_TYPE_GUID_TYPE.
+  ///
+  EFI_FIRMWARE_VOLUME_EXT_ENTRY     Hdr;
+  ///
+  /// EDKII_FV_FILE_DIRECTORY_GUID.
+  ///
+  EFI_GUID                          FormatType;
+  ///
+  /// Number of EDKII_FV_FILE_DIRECTORY_ENTRY following this header.
+  ///
+  UINT32                            EntryCount;
+  //
+  // EDKII_FV_FILE_DIRECTORY_ENTRY  Entry[EntryCount];
+  //
+} EDKII_FV_FILE_DIRECTORY_HEADER;
+
+#pragma pack()
+
+extern EFI_GUID gEdkiiFvFileDirectoryGuid;
+
+#endif
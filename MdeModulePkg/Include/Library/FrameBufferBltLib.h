@@ -84,4 +84,54 @@ FrameBufferBlt (
   IN     UINTN                              Delta
   );
 
+/**
+  Pushes a rectangle of the frame buffer to the display.
+
+  @param[in] Context  The context passed to FrameBufferBltFlush ().
+  @param[in] X        The X coordinate of the rectangle.
+  @param[in] Y        The Y coordinate of the rectangle.
+  @param[in] Width    The width of the rectangle in pixels.
+  @param[in] Height   The height of the rectangle in pixels.
+
+  @retval RETURN_SUCCESS  The rectangle was pushed to the display.
+  @retval Others          The rectangle could not be pushed to the display.
+**/
+typedef
+RETURN_STATUS
+(EFIAPI *FRAME_BUFFER_FLUSH_RECTANGLE) (
+  IN VOID                                   *Context,
+  IN UINTN                                  X,
+  IN UINTN                                  Y,
+  IN UINTN                                  Width,
+  IN UINTN                                  Height
+  );
+
+/**
+  Pushes the part of the frame buffer modified by FrameBufferBlt () since the
+  last successful flush to the display.
+
+  The modified part is tracked as the smallest rectangle containing all the
+  pixels written. This allows drivers whose frame buffer is a copy of the
+  display, like virtual GPUs, to update the display once for many Blt
+  operations.
+
+  @param[in] Configure      Pointer to a configuration which was successfully
+                            created by FrameBufferBltConfigure ().
+  @param[in] FlushRectangle Function called with the modified rectangle.
+  @param[in] Context        Context passed to FlushRectangle.
+
+  @retval RETURN_SUCCESS            Nothing was modified, or FlushRectangle
+                                    succeeded.
+  @retval RETURN_INVALID_PARAMETER  Configure or FlushRectangle is NULL.
+  @retval Others                    The status returned by FlushRectangle.
+                                    The rectangle stays modified.
+**/
+RETURN_STATUS
+EFIAPI
+FrameBufferBltFlush (
+  IN     FRAME_BUFFER_CONFIGURE             *Configure,
+  IN     FRAME_BUFFER_FLUSH_RECTANGLE       FlushRectangle,
+  IN     VOID                               *Context
+  );
+
 #endif
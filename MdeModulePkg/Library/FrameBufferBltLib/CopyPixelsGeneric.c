@@ -0,0 +1,51 @@
+/** @file
+  Copy 32-bit pixels, for the architectures without a vector implementation.
+
+  Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Base.h>
+#include <Library/BaseMemoryLib.h>
+#include "FrameBufferBltLibInternal.h"
+
+/**
+  Copy 32-bit pixels.
+
+  The source and destination must not overlap, and must be 4-byte aligned.
+  FRAME_BUFFER_COPY_NON_TEMPORAL is ignored.
+
+  @param[out] Destination The pixels to write.
+  @param[in]  Source      The pixels to read.
+  @param[in]  PixelCount  The number of pixels to copy.
+  @param[in]  Flags       FRAME_BUFFER_COPY_SWAP_RED_BLUE and / or
+                          FRAME_BUFFER_COPY_NON_TEMPORAL.
+**/
+VOID
+EFIAPI
+InternalFrameBufferBltCopyPixels (
+  OUT VOID                                  *Destination,
+  IN  CONST VOID                            *Source,
+  IN  UINTN                                 PixelCount,
+  IN  UINT32                                Flags
+  )
+{
+  UINT32                                    *Dst;
+  CONST UINT32                              *Src;
+  UINT32                                    Pixel;
+
+  if ((Flags & FRAME_BUFFER_COPY_SWAP_RED_BLUE) == 0) {
+    CopyMem (Destination, Source, PixelCount * sizeof (UINT32));
+    return;
+  }
+
+  Dst = (UINT32 *) Destination;
+  Src = (CONST UINT32 *) Source;
+  while (PixelCount-- > 0) {
+    Pixel  = *Src++;
+    *Dst++ = (Pixel & 0x0000ff00) |
+             ((Pixel << 16) & 0x00ff0000) |
+             ((Pixel >> 16) & 0x000000ff);
+  }
+}
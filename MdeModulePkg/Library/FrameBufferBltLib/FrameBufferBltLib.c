@@ -14,6 +14,8 @@
 #include <Library/DebugLib.h>
 #include <Library/FrameBufferBltLib.h>
 
+#include "FrameBufferBltLibInternal.h"
+
 struct FRAME_BUFFER_CONFIGURE {
   UINT32                          PixelsPerScanLine;
   UINT32                          BytesPerPixel;
@@ -24,6 +26,14 @@ struct FRAME_BUFFER_CONFIGURE {
   EFI_PIXEL_BITMASK               PixelMasks;
   INT8                            PixelShl[4]; // R-G-B-Rsvd
   INT8                            PixelShr[4]; // R-G-B-Rsvd
+  //
+  // Smallest rectangle containing all the pixels written since the last
+  // flush. It is empty when DirtyLeft >= DirtyRight.
+  //
+  UINT32                          DirtyLeft;
+  UINT32                          DirtyTop;
+  UINT32                          DirtyRight;
+  UINT32                          DirtyBottom;
   UINT8                           LineBuffer[0];
 };
 
@@ -81,6 +91,42 @@ FrameBufferBltLibConfigurePixelFormat (
   DEBUG ((DEBUG_INFO, "Bytes per pixel: %d\n", *BytesPerPixel));
 }
 
+/**
+  Add a rectangle to the modified part of the frame buffer.
+
+  @param[in, out] Configure Pointer to a configuration which was successfully
+                            created by FrameBufferBltConfigure ().
+  @param[in]      X         X location of the rectangle.
+  @param[in]      Y         Y location of the rectangle.
+  @param[in]      Width     Width (in pixels) of the rectangle.
+  @param[in]      Height    Height of the rectangle.
+**/
+VOID
+FrameBufferBltLibMarkDirty (
+  IN OUT FRAME_BUFFER_CONFIGURE       *Configure,
+  IN     UINTN                        X,
+  IN     UINTN                        Y,
+  IN     UINTN                        Width,
+  IN     UINTN                        Height
+  )
+{
+  //
+  // The callers have checked the rectangle is within the frame buffer.
+  //
+  if (Configure->DirtyLeft >= Configure->DirtyRight) {
+    Configure->DirtyLeft   = (UINT32) X;
+    Configure->DirtyTop    = (UINT32) Y;
+    Configure->DirtyRight  = (UINT32) (X + Width);
+    Configure->DirtyBottom = (UINT32) (Y + Height);
+    return;
+  }
+
+  Configure->DirtyLeft   = MIN (Configure->DirtyLeft,   (UINT32) X);
+  Configure->DirtyTop    = MIN (Configure->DirtyTop,    (UINT32) Y);
+  Configure->DirtyRight  = MAX (Configure->DirtyRight,  (UINT32) (X + Width));
+  Configure->DirtyBottom = MAX (Configure->DirtyBottom, (UINT32) (Y + Height));
+}
+
 /**
   Create the configuration for a video frame buffer.
 
@@ -164,6 +210,10 @@ FrameBufferBltConfigure (
   Configure->Width             = FrameBufferInfo->HorizontalResolution;
   Configure->Height            = FrameBufferInfo->VerticalResolution;
   Configure->PixelsPerScanLine = FrameBufferInfo->PixelsPerScanLine;
+  Configure->DirtyLeft         = 0;
+  Configure->DirtyTop          = 0;
+  Configure->DirtyRight        = 0;
+  Configure->DirtyBottom       = 0;
 
   return RETURN_SUCCESS;
 }
@@ -223,6 +273,8 @@ FrameBufferBltLibVideoFill (
     return RETURN_INVALID_PARAMETER;
   }
 
+  FrameBufferBltLibMarkDirty (Configure, DestinationX, DestinationY, Width, Height);
+
   WidthInBytes = Width * Configure->BytesPerPixel;
 
   Uint32 = *(UINT32*) Color;
@@ -398,15 +450,19 @@ FrameBufferBltLibVideoToBltBuffer (
     Offset = Configure->BytesPerPixel * Offset;
     Source = Configure->FrameBuffer + Offset;
 
+    Destination = (UINT8 *) BltBuffer + (DstY * Delta) + (DestinationX * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL));
+
     if (Configure->PixelFormat == PixelBlueGreenRedReserved8BitPerColor) {
-      Destination = (UINT8 *) BltBuffer + (DstY * Delta) + (DestinationX * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL));
+      CopyMem (Destination, Source, WidthInBytes);
+    } else if (Configure->PixelFormat == PixelRedGreenBlueReserved8BitPerColor) {
+      InternalFrameBufferBltCopyPixels (
+        Destination,
+        Source,
+        Width,
+        FRAME_BUFFER_COPY_SWAP_RED_BLUE
+        );
     } else {
-      Destination = Configure->LineBuffer;
-    }
-
-    CopyMem (Destination, Source, WidthInBytes);
-
-    if (Configure->PixelFormat != PixelBlueGreenRedReserved8BitPerColor) {
+      CopyMem (Configure->LineBuffer, Source, WidthInBytes);
       for (IndexX = 0; IndexX < Width; IndexX++) {
         Blt = (EFI_GRAPHICS_OUTPUT_BLT_PIXEL *)
           ((UINT8 *) BltBuffer + (DstY * Delta) +
@@ -493,6 +549,8 @@ FrameBufferBltLibBufferToVideo (
     Delta = Width * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL);
   }
 
+  FrameBufferBltLibMarkDirty (Configure, DestinationX, DestinationY, Width, Height);
+
   WidthInBytes = Width * Configure->BytesPerPixel;
 
   for (SrcY = SourceY, DstY = DestinationY;
@@ -503,8 +561,26 @@ FrameBufferBltLibBufferToVideo (
     Offset = Configure->BytesPerPixel * Offset;
     Destination = Configure->FrameBuffer + Offset;
 
+    //
+    // The 32-bit formats are written with non-temporal stores, which the
+    // write-combining frame buffers absorb as full bursts.
+    //
     if (Configure->PixelFormat == PixelBlueGreenRedReserved8BitPerColor) {
       Source = (UINT8 *) BltBuffer + (SrcY * Delta) + SourceX * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL);
+      InternalFrameBufferBltCopyPixels (
+        Destination,
+        Source,
+        Width,
+        FRAME_BUFFER_COPY_NON_TEMPORAL
+        );
+    } else if (Configure->PixelFormat == PixelRedGreenBlueReserved8BitPerColor) {
+      Source = (UINT8 *) BltBuffer + (SrcY * Delta) + SourceX * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL);
+      InternalFrameBufferBltCopyPixels (
+        Destination,
+        Source,
+        Width,
+        FRAME_BUFFER_COPY_SWAP_RED_BLUE | FRAME_BUFFER_COPY_NON_TEMPORAL
+        );
     } else {
       for (IndexX = 0; IndexX < Width; IndexX++) {
         Blt =
@@ -524,10 +600,8 @@ FrameBufferBltLibBufferToVideo (
                Configure->PixelMasks.BlueMask)
             );
       }
-      Source = Configure->LineBuffer;
+      CopyMem (Destination, Configure->LineBuffer, WidthInBytes);
     }
-
-    CopyMem (Destination, Source, WidthInBytes);
   }
 
   return RETURN_SUCCESS;
@@ -588,6 +662,8 @@ FrameBufferBltLibVideoToVideo (
     return RETURN_INVALID_PARAMETER;
   }
 
+  FrameBufferBltLibMarkDirty (Configure, DestinationX, DestinationY, Width, Height);
+
   WidthInBytes = Width * Configure->BytesPerPixel;
 
   Offset = (SourceY * Configure->PixelsPerScanLine) + SourceX;
@@ -716,3 +792,53 @@ FrameBufferBlt (
     return RETURN_INVALID_PARAMETER;
   }
 }
+
+/**
+  Pushes the part of the frame buffer modified by FrameBufferBlt () since the
+  last successful flush to the display.
+
+  @param[in] Configure      Pointer to a configuration which was successfully
+                            created by FrameBufferBltConfigure ().
+  @param[in] FlushRectangle Function called with the modified rectangle.
+  @param[in] Context        Context passed to FlushRectangle.
+
+  @retval RETURN_SUCCESS            Nothing was modified, or FlushRectangle
+                                    succeeded.
+  @retval RETURN_INVALID_PARAMETER  Configure or FlushRectangle is NULL.
+  @retval Others                    The status returned by FlushRectangle.
+                                    The rectangle stays modified.
+**/
+RETURN_STATUS
+EFIAPI
+FrameBufferBltFlush (
+  IN     FRAME_BUFFER_CONFIGURE                *Configure,
+  IN     FRAME_BUFFER_FLUSH_RECTANGLE          FlushRectangle,
+  IN     VOID                                  *Context
+  )
+{
+  RETURN_STATUS                                Status;
+
+  if (Configure == NULL || FlushRectangle == NULL) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  if (Configure->DirtyLeft >= Configure->DirtyRight) {
+    return RETURN_SUCCESS;
+  }
+
+  Status = FlushRectangle (
+             Context,
+             Configure->DirtyLeft,
+             Configure->DirtyTop,
+             Configure->DirtyRight - Configure->DirtyLeft,
+             Configure->DirtyBottom - Configure->DirtyTop
+             );
+  if (!RETURN_ERROR (Status)) {
+    Configure->DirtyLeft   = 0;
+    Configure->DirtyTop    = 0;
+    Configure->DirtyRight  = 0;
+    Configure->DirtyBottom = 0;
+  }
+
+  return Status;
+}
@@ -0,0 +1,47 @@
+/** @file
+  Internal definitions of FrameBufferBltLib.
+
+  Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _FRAME_BUFFER_BLT_LIB_INTERNAL_H_
+#define _FRAME_BUFFER_BLT_LIB_INTERNAL_H_
+
+//
+// Exchange the bytes 0 and 2 of every pixel and clear the byte 3, which
+// converts between the PixelRedGreenBlueReserved8BitPerColor and
+// PixelBlueGreenRedReserved8BitPerColor formats.
+//
+#define FRAME_BUFFER_COPY_SWAP_RED_BLUE  BIT0
+
+//
+// Write the destination with non-temporal stores, which bypass the cache and
+// combine into full bursts on write-combining frame buffers.
+//
+#define FRAME_BUFFER_COPY_NON_TEMPORAL   BIT1
+
+/**
+  Copy 32-bit pixels.
+
+  The source and destination must not overlap, and must be 4-byte aligned.
+  The IA32, X64 and AARCH64 implementations process 4 or 16 pixels per
+  iteration with SSE2 or NEON instructions.
+
+  @param[out] Destination The pixels to write.
+  @param[in]  Source      The pixels to read.
+  @param[in]  PixelCount  The number of pixels to copy.
+  @param[in]  Flags       FRAME_BUFFER_COPY_SWAP_RED_BLUE and / or
+                          FRAME_BUFFER_COPY_NON_TEMPORAL.
+**/
+VOID
+EFIAPI
+InternalFrameBufferBltCopyPixels (
+  OUT VOID                                  *Destination,
+  IN  CONST VOID                            *Source,
+  IN  UINTN                                 PixelCount,
+  IN  UINT32                                Flags
+  );
+
+#endif
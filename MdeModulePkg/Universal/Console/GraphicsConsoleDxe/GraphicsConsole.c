@@ -1,7 +1,7 @@
 /** @file
   This is the main routine for initializing the Graphics Console support routines.
 
-Copyright (c) 2006 - 2019, Intel Corporation. All rights reserved.<BR>
+Copyright (c) 2006 - 2021, Intel Corporation. All rights reserved.<BR>
 SPDX-License-Identifier: BSD-2-Clause-Patent
 
 **/
@@ -36,7 +36,14 @@ GRAPHICS_CONSOLE_DEV    mGraphicsConsoleDevTemplate = {
     FALSE
   },
   (GRAPHICS_CONSOLE_MODE_DATA *) NULL,
-  (EFI_GRAPHICS_OUTPUT_BLT_PIXEL *) NULL
+  (EFI_GRAPHICS_OUTPUT_BLT_PIXEL *) NULL,
+  (EFI_GRAPHICS_OUTPUT_BLT_PIXEL *) NULL,
+  0,
+  (GRAPHICS_CONSOLE_DIRTY_ROW *) NULL,
+  (EFI_EVENT) NULL,
+  (EFI_EVENT) NULL,
+  FALSE,
+  0
 };
 
 GRAPHICS_CONSOLE_MODE_DATA mGraphicsConsoleModeData[] = {
@@ -587,6 +594,38 @@ GraphicsConsoleControllerDriverStart (
   Private->SimpleTextOutput.Mode->Mode = (INT32)PreferMode;
   DEBUG ((DEBUG_INFO, "Graphics Console Started, Mode: %d\n", PreferMode));
 
+  //
+  // Output is drawn into a shadow buffer and copied to the screen by a timer,
+  // which coalesces the updates of many calls, or at exit boot services.
+  //
+  if ((Private->GraphicsOutput != NULL) && (PcdGet32 (PcdGraphicsConsoleFlushInterval) != 0)) {
+    Status = gBS->CreateEvent (
+                    EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                    TPL_CALLBACK,
+                    GraphicsConsoleFlushNotify,
+                    Private,
+                    &Private->FlushEvent
+                    );
+    if (EFI_ERROR (Status)) {
+      goto Error;
+    }
+
+    //
+    // The timer stops at exit boot services, so copy the rows still pending
+    // then. TPL_CALLBACK keeps the copy out of the TPL_NOTIFY console services.
+    //
+    Status = gBS->CreateEvent (
+                    EVT_SIGNAL_EXIT_BOOT_SERVICES,
+                    TPL_CALLBACK,
+                    GraphicsConsoleFlushNotify,
+                    Private,
+                    &Private->ExitBootServicesEvent
+                    );
+    if (EFI_ERROR (Status)) {
+      goto Error;
+    }
+  }
+
   //
   // Install protocol interfaces for the Graphics Console device.
   //
@@ -618,6 +657,14 @@ Error:
              );
     }
 
+    if (Private->FlushEvent != NULL) {
+      gBS->CloseEvent (Private->FlushEvent);
+    }
+
+    if (Private->ExitBootServicesEvent != NULL) {
+      gBS->CloseEvent (Private->ExitBootServicesEvent);
+    }
+
     if (Private->LineBuffer != NULL) {
       FreePool (Private->LineBuffer);
     }
@@ -687,6 +734,19 @@ GraphicsConsoleControllerDriverStop (
                   );
 
   if (!EFI_ERROR (Status)) {
+    //
+    // Stop the flush timer and copy the last output to the screen
+    //
+    if (Private->FlushEvent != NULL) {
+      gBS->CloseEvent (Private->FlushEvent);
+    }
+
+    if (Private->ExitBootServicesEvent != NULL) {
+      gBS->CloseEvent (Private->ExitBootServicesEvent);
+    }
+
+    GraphicsConsoleFlushShadow (Private);
+
     //
     // Close the GOP or UGA IO Protocol
     //
@@ -710,6 +770,11 @@ GraphicsConsoleControllerDriverStop (
       FreePool (Private->LineBuffer);
     }
 
+    if (Private->Shadow != NULL) {
+      FreePool (Private->Shadow);
+      FreePool (Private->DirtyRows);
+    }
+
     if (Private->ModeData != NULL) {
       FreePool (Private->ModeData);
     }
@@ -911,6 +976,12 @@ GraphicsConsoleConOutOutputString (
   GraphicsOutput = Private->GraphicsOutput;
   UgaDraw   = Private->UgaDraw;
 
+  //
+  // Line wrapping and backspace call OutputString () recursively, only the
+  // outermost call flushes the shadow buffer.
+  //
+  Private->OutputDepth++;
+
   MaxColumn = Private->ModeData[Mode].Columns;
   MaxRow    = Private->ModeData[Mode].Rows;
   DeltaX    = (UINTN) Private->ModeData[Mode].DeltaX;
@@ -967,7 +1038,12 @@ GraphicsConsoleConOutOutputString (
       // down one row.
       //
       if (This->Mode->CursorRow == (INT32) (MaxRow - 1)) {
-        if (GraphicsOutput != NULL) {
+        if (Private->Shadow != NULL) {
+          //
+          // Scroll the shadow buffer, without moving any pixel
+          //
+          GraphicsConsoleShadowScroll (Private, &Background);
+        } else if (GraphicsOutput != NULL) {
           //
           // Scroll Screen Up One Row
           //
@@ -1128,6 +1204,11 @@ GraphicsConsoleConOutOutputString (
     Status = EFI_WARN_UNKNOWN_GLYPH;
   }
 
+  Private->OutputDepth--;
+  if (Private->OutputDepth == 0) {
+    GraphicsConsoleScheduleFlush (Private, OldTpl);
+  }
+
   gBS->RestoreTPL (OldTpl);
   return Status;
 
@@ -1321,6 +1402,13 @@ GraphicsConsoleConOutSetMode (
     FlushCursor (This);
 
     FreePool (Private->LineBuffer);
+
+    if (Private->Shadow != NULL) {
+      FreePool (Private->Shadow);
+      FreePool (Private->DirtyRows);
+      Private->Shadow    = NULL;
+      Private->DirtyRows = NULL;
+    }
   }
 
   //
@@ -1418,6 +1506,37 @@ GraphicsConsoleConOutSetMode (
     }
   }
 
+  //
+  // The screen has just been cleared, and so is the shadow buffer of the new
+  // text window. Without the shadow buffer the text is drawn on the screen.
+  //
+  if (GraphicsOutput != NULL) {
+    Private->Shadow    = AllocatePool (
+                           sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL) *
+                           ModeData->Columns * EFI_GLYPH_WIDTH *
+                           ModeData->Rows * EFI_GLYPH_HEIGHT
+                           );
+    Private->DirtyRows = AllocateZeroPool (sizeof (GRAPHICS_CONSOLE_DIRTY_ROW) * ModeData->Rows);
+    if ((Private->Shadow == NULL) || (Private->DirtyRows == NULL)) {
+      DEBUG ((DEBUG_WARN, "GraphicsConsole: no shadow buffer, drawing on the screen\n"));
+      if (Private->Shadow != NULL) {
+        FreePool (Private->Shadow);
+        Private->Shadow = NULL;
+      }
+      if (Private->DirtyRows != NULL) {
+        FreePool (Private->DirtyRows);
+        Private->DirtyRows = NULL;
+      }
+    } else {
+      SetMem32 (
+        Private->Shadow,
+        sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL) * ModeData->Columns * EFI_GLYPH_WIDTH * ModeData->Rows * EFI_GLYPH_HEIGHT,
+        *(UINT32 *) &mGraphicsEfiColors[0]
+        );
+      Private->ShadowTopRow = 0;
+    }
+  }
+
   //
   // The new mode is valid, so commit the mode change
   //
@@ -1430,6 +1549,7 @@ GraphicsConsoleConOutSetMode (
   This->Mode->CursorRow     = 0;
 
   FlushCursor (This);
+  GraphicsConsoleScheduleFlush (Private, OldTpl);
 
   Status = EFI_SUCCESS;
 
@@ -1529,6 +1649,20 @@ GraphicsConsoleConOutClearScreen (
   ModeData  = &(Private->ModeData[This->Mode->Mode]);
 
   GetTextColors (This, &Foreground, &Background);
+
+  //
+  // The pending updates of the shadow buffer are overwritten by the fill
+  //
+  if (Private->Shadow != NULL) {
+    SetMem32 (
+      Private->Shadow,
+      sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL) * ModeData->Columns * EFI_GLYPH_WIDTH * ModeData->Rows * EFI_GLYPH_HEIGHT,
+      *(UINT32 *) &Background
+      );
+    ZeroMem (Private->DirtyRows, sizeof (GRAPHICS_CONSOLE_DIRTY_ROW) * ModeData->Rows);
+    Private->ShadowTopRow = 0;
+  }
+
   if (GraphicsOutput != NULL) {
     Status = GraphicsOutput->Blt (
                         GraphicsOutput,
@@ -1563,6 +1697,7 @@ GraphicsConsoleConOutClearScreen (
   This->Mode->CursorRow     = 0;
 
   FlushCursor (This);
+  GraphicsConsoleScheduleFlush (Private, OldTpl);
 
   gBS->RestoreTPL (OldTpl);
 
@@ -1632,6 +1767,7 @@ GraphicsConsoleConOutSetCursorPosition (
   This->Mode->CursorRow     = (INT32) Row;
 
   FlushCursor (This);
+  GraphicsConsoleScheduleFlush (Private, OldTpl);
 
 Done:
   gBS->RestoreTPL (OldTpl);
@@ -1661,6 +1797,7 @@ GraphicsConsoleConOutEnableCursor (
   IN  BOOLEAN                          Visible
   )
 {
+  GRAPHICS_CONSOLE_DEV  *Private;
   EFI_TPL               OldTpl;
 
   if (This->Mode->Mode == -1) {
@@ -1672,11 +1809,14 @@ GraphicsConsoleConOutEnableCursor (
 
   OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
 
+  Private = GRAPHICS_CONSOLE_CON_OUT_DEV_FROM_THIS (This);
+
   FlushCursor (This);
 
   This->Mode->CursorVisible = Visible;
 
   FlushCursor (This);
+  GraphicsConsoleScheduleFlush (Private, OldTpl);
 
   gBS->RestoreTPL (OldTpl);
   return EFI_SUCCESS;
@@ -1768,7 +1908,41 @@ DrawUnicodeWeightAtCursorN (
   //
   GetTextColors (This, &FontInfo->ForegroundColor, &FontInfo->BackgroundColor);
 
-  if (Private->GraphicsOutput != NULL) {
+  if (Private->Shadow != NULL) {
+    //
+    // Draw into the text row in the shadow buffer, which is copied to the
+    // screen later by GraphicsConsoleFlushShadow ().
+    //
+    Blt->Width        = (UINT16) (Private->ModeData[This->Mode->Mode].Columns * EFI_GLYPH_WIDTH);
+    Blt->Height       = EFI_GLYPH_HEIGHT;
+    Blt->Image.Bitmap = GraphicsConsoleShadowRow (Private, This->Mode->CursorRow);
+
+    RowInfoArray = NULL;
+    Status = mHiiFont->StringToImage (
+                         mHiiFont,
+                         EFI_HII_IGNORE_IF_NO_GLYPH | EFI_HII_IGNORE_LINE_BREAK,
+                         String,
+                         FontInfo,
+                         &Blt,
+                         This->Mode->CursorColumn * EFI_GLYPH_WIDTH,
+                         0,
+                         &RowInfoArray,
+                         &RowInfoArraySize,
+                         NULL
+                         );
+    if (!EFI_ERROR (Status) && (RowInfoArraySize != 0)) {
+      GraphicsConsoleMarkDirty (
+        Private,
+        This->Mode->CursorRow,
+        This->Mode->CursorColumn * EFI_GLYPH_WIDTH,
+        This->Mode->CursorColumn * EFI_GLYPH_WIDTH + RowInfoArray[0].LineWidth
+        );
+    }
+
+    if (RowInfoArray != NULL) {
+      FreePool (RowInfoArray);
+    }
+  } else if (Private->GraphicsOutput != NULL) {
     //
     // If Graphics Output protocol exists, using HII Font protocol to draw.
     //
@@ -1887,6 +2061,8 @@ FlushCursor (
   EFI_GRAPHICS_OUTPUT_BLT_PIXEL_UNION Foreground;
   EFI_GRAPHICS_OUTPUT_BLT_PIXEL_UNION Background;
   EFI_GRAPHICS_OUTPUT_BLT_PIXEL_UNION BltChar[EFI_GLYPH_HEIGHT][EFI_GLYPH_WIDTH];
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL_UNION *ShadowChar;
+  UINTN                               ShadowWidth;
   UINTN                               PosX;
   UINTN                               PosY;
 
@@ -1901,6 +2077,31 @@ FlushCursor (
   GraphicsOutput = Private->GraphicsOutput;
   UgaDraw = Private->UgaDraw;
 
+  if (Private->Shadow != NULL) {
+    //
+    // Toggle the cursor in the shadow buffer, the screen is not read.
+    //
+    GetTextColors (This, &Foreground.Pixel, &Background.Pixel);
+    ShadowWidth = Private->ModeData[CurrentMode->Mode].Columns * EFI_GLYPH_WIDTH;
+    ShadowChar  = (EFI_GRAPHICS_OUTPUT_BLT_PIXEL_UNION *) GraphicsConsoleShadowRow (Private, CurrentMode->CursorRow) +
+                  CurrentMode->CursorColumn * EFI_GLYPH_WIDTH;
+    for (PosY = 0; PosY < EFI_GLYPH_HEIGHT; PosY++) {
+      for (PosX = 0; PosX < EFI_GLYPH_WIDTH; PosX++) {
+        if ((mCursorGlyph.GlyphCol1[PosY] & (BIT0 << PosX)) != 0) {
+          ShadowChar[PosY * ShadowWidth + EFI_GLYPH_WIDTH - PosX - 1].Raw ^= Foreground.Raw;
+        }
+      }
+    }
+
+    GraphicsConsoleMarkDirty (
+      Private,
+      CurrentMode->CursorRow,
+      CurrentMode->CursorColumn * EFI_GLYPH_WIDTH,
+      (CurrentMode->CursorColumn + 1) * EFI_GLYPH_WIDTH
+      );
+    return EFI_SUCCESS;
+  }
+
   //
   // In this driver, only narrow character was supported.
   //
@@ -1981,6 +2182,223 @@ FlushCursor (
   return EFI_SUCCESS;
 }
 
+/**
+  Return the first scan line of a text row in the shadow buffer.
+
+  @param  Private               The Graphics Console device.
+  @param  Row                   The text row.
+
+  @return The first pixel of the text row.
+
+**/
+EFI_GRAPHICS_OUTPUT_BLT_PIXEL *
+GraphicsConsoleShadowRow (
+  IN  GRAPHICS_CONSOLE_DEV             *Private,
+  IN  UINTN                            Row
+  )
+{
+  GRAPHICS_CONSOLE_MODE_DATA           *ModeData;
+
+  ModeData = &Private->ModeData[Private->SimpleTextOutputMode.Mode];
+  return Private->Shadow +
+         ((Private->ShadowTopRow + Row) % ModeData->Rows) * ModeData->Columns * EFI_GLYPH_WIDTH * EFI_GLYPH_HEIGHT;
+}
+
+/**
+  Record that pixels of a text row of the shadow buffer were modified.
+
+  @param  Private               The Graphics Console device.
+  @param  Row                   The text row.
+  @param  Left                  The first modified pixel of the row.
+  @param  Right                 The pixel following the last modified one.
+
+**/
+VOID
+GraphicsConsoleMarkDirty (
+  IN  GRAPHICS_CONSOLE_DEV             *Private,
+  IN  UINTN                            Row,
+  IN  UINTN                            Left,
+  IN  UINTN                            Right
+  )
+{
+  GRAPHICS_CONSOLE_DIRTY_ROW           *DirtyRow;
+
+  DirtyRow = &Private->DirtyRows[Row];
+  if (DirtyRow->Left >= DirtyRow->Right) {
+    DirtyRow->Left  = (UINT32) Left;
+    DirtyRow->Right = (UINT32) Right;
+  } else {
+    DirtyRow->Left  = MIN (DirtyRow->Left, (UINT32) Left);
+    DirtyRow->Right = MAX (DirtyRow->Right, (UINT32) Right);
+  }
+}
+
+/**
+  Scroll the text window of the shadow buffer up one row.
+
+  The top row of the ring becomes the bottom row and is cleared, all the rows
+  need to be copied to the screen again.
+
+  @param  Private               The Graphics Console device.
+  @param  Background            The color of the new bottom row.
+
+**/
+VOID
+GraphicsConsoleShadowScroll (
+  IN  GRAPHICS_CONSOLE_DEV             *Private,
+  IN  EFI_GRAPHICS_OUTPUT_BLT_PIXEL    *Background
+  )
+{
+  GRAPHICS_CONSOLE_MODE_DATA           *ModeData;
+  UINTN                                Width;
+  UINTN                                Row;
+
+  ModeData = &Private->ModeData[Private->SimpleTextOutputMode.Mode];
+  Width    = ModeData->Columns * EFI_GLYPH_WIDTH;
+
+  Private->ShadowTopRow = (Private->ShadowTopRow + 1) % ModeData->Rows;
+  SetMem32 (
+    GraphicsConsoleShadowRow (Private, ModeData->Rows - 1),
+    Width * EFI_GLYPH_HEIGHT * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL),
+    *(UINT32 *) Background
+    );
+
+  for (Row = 0; Row < ModeData->Rows; Row++) {
+    Private->DirtyRows[Row].Left  = 0;
+    Private->DirtyRows[Row].Right = (UINT32) Width;
+  }
+}
+
+/**
+  Copy the dirty rows of the shadow buffer to the screen.
+
+  @param  Private               The Graphics Console device.
+
+**/
+VOID
+GraphicsConsoleFlushShadow (
+  IN  GRAPHICS_CONSOLE_DEV             *Private
+  )
+{
+  GRAPHICS_CONSOLE_MODE_DATA           *ModeData;
+  GRAPHICS_CONSOLE_DIRTY_ROW           *DirtyRow;
+  UINTN                                Width;
+  UINTN                                Row;
+  UINTN                                NextRow;
+
+  if ((Private->Shadow == NULL) || (Private->SimpleTextOutputMode.Mode == -1)) {
+    return;
+  }
+
+  ModeData = &Private->ModeData[Private->SimpleTextOutputMode.Mode];
+  Width    = ModeData->Columns * EFI_GLYPH_WIDTH;
+
+  for (Row = 0; Row < ModeData->Rows; Row = NextRow) {
+    DirtyRow = &Private->DirtyRows[Row];
+    NextRow  = Row + 1;
+    if (DirtyRow->Left >= DirtyRow->Right) {
+      continue;
+    }
+
+    //
+    // The following rows with the same dirty pixels that are adjacent in the
+    // ring are copied by the same Blt, which is the case of all the rows
+    // after scrolling.
+    //
+    while ((NextRow < ModeData->Rows) &&
+           (((Private->ShadowTopRow + NextRow) % ModeData->Rows) != 0) &&
+           (Private->DirtyRows[NextRow].Left == DirtyRow->Left) &&
+           (Private->DirtyRows[NextRow].Right == DirtyRow->Right)) {
+      Private->DirtyRows[NextRow].Right = 0;
+      NextRow++;
+    }
+
+    Private->GraphicsOutput->Blt (
+                               Private->GraphicsOutput,
+                               GraphicsConsoleShadowRow (Private, Row),
+                               EfiBltBufferToVideo,
+                               DirtyRow->Left,
+                               0,
+                               ModeData->DeltaX + DirtyRow->Left,
+                               ModeData->DeltaY + Row * EFI_GLYPH_HEIGHT,
+                               DirtyRow->Right - DirtyRow->Left,
+                               (NextRow - Row) * EFI_GLYPH_HEIGHT,
+                               Width * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL)
+                               );
+    DirtyRow->Right = 0;
+  }
+}
+
+/**
+  Copy the dirty rows of the shadow buffer to the screen now, or arm the
+  flush timer.
+
+  The rows are copied now when there is no timer, or when the caller runs at
+  a TPL that would hold off the timer notification.
+
+  @param  Private               The Graphics Console device.
+  @param  CallerTpl             The TPL of the caller of the console service.
+
+**/
+VOID
+GraphicsConsoleScheduleFlush (
+  IN  GRAPHICS_CONSOLE_DEV             *Private,
+  IN  EFI_TPL                          CallerTpl
+  )
+{
+  EFI_STATUS                           Status;
+
+  if (Private->Shadow == NULL) {
+    return;
+  }
+
+  if ((Private->FlushEvent == NULL) || (CallerTpl >= TPL_CALLBACK)) {
+    GraphicsConsoleFlushShadow (Private);
+    return;
+  }
+
+  if (!Private->FlushPending) {
+    Status = gBS->SetTimer (
+                    Private->FlushEvent,
+                    TimerRelative,
+                    EFI_TIMER_PERIOD_MILLISECONDS (PcdGet32 (PcdGraphicsConsoleFlushInterval))
+                    );
+    if (EFI_ERROR (Status)) {
+      GraphicsConsoleFlushShadow (Private);
+      return;
+    }
+    Private->FlushPending = TRUE;
+  }
+}
+
+/**
+  Notification function of the flush timer and of exit boot services.
+
+  @param[in]  Event     The event being signaled.
+  @param[in]  Context   The Graphics Console device.
+
+**/
+VOID
+EFIAPI
+GraphicsConsoleFlushNotify (
+  IN  EFI_EVENT                        Event,
+  IN  VOID                             *Context
+  )
+{
+  GRAPHICS_CONSOLE_DEV                 *Private;
+  EFI_TPL                              OldTpl;
+
+  Private = (GRAPHICS_CONSOLE_DEV *) Context;
+
+  //
+  // Console services run at TPL_NOTIFY and may interrupt a timer notification
+  //
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  Private->FlushPending = FALSE;
+  GraphicsConsoleFlushShadow (Private);
+  gBS->RestoreTPL (OldTpl);
+}
+
 /**
   HII Database Protocol notification event handler.
 
@@ -1,7 +1,7 @@
 /** @file
   Header file for GraphicsConsole driver.
 
-Copyright (c) 2006 - 2018, Intel Corporation. All rights reserved.<BR>
+Copyright (c) 2006 - 2021, Intel Corporation. All rights reserved.<BR>
 SPDX-License-Identifier: BSD-2-Clause-Patent
 
 **/
@@ -57,6 +57,15 @@ typedef struct {
   UINT32  GopModeNumber;
 } GRAPHICS_CONSOLE_MODE_DATA;
 
+//
+// Pixels [Left, Right) of a text row that differ between the shadow buffer
+// and the screen. The row is clean when Left >= Right.
+//
+typedef struct {
+  UINT32  Left;
+  UINT32  Right;
+} GRAPHICS_CONSOLE_DIRTY_ROW;
+
 typedef struct {
   UINTN                            Signature;
   EFI_GRAPHICS_OUTPUT_PROTOCOL     *GraphicsOutput;
@@ -65,6 +74,24 @@ typedef struct {
   EFI_SIMPLE_TEXT_OUTPUT_MODE      SimpleTextOutputMode;
   GRAPHICS_CONSOLE_MODE_DATA       *ModeData;
   EFI_GRAPHICS_OUTPUT_BLT_PIXEL    *LineBuffer;
+  //
+  // Copy of the text window in memory, only used with Graphics Output
+  // protocol. It is a ring of text rows of EFI_GLYPH_HEIGHT scan lines each,
+  // ShadowTopRow being the ring index of the top text row, so scrolling
+  // only moves ShadowTopRow. NULL if the text window is drawn directly.
+  //
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL    *Shadow;
+  UINTN                            ShadowTopRow;
+  GRAPHICS_CONSOLE_DIRTY_ROW       *DirtyRows;
+  //
+  // One shot timer copying the dirty rows to the screen, and the exit boot
+  // services event doing the same for the last output. NULL if the rows are
+  // copied at the end of every call.
+  //
+  EFI_EVENT                        FlushEvent;
+  EFI_EVENT                        ExitBootServicesEvent;
+  BOOLEAN                          FlushPending;
+  UINTN                            OutputDepth;
 } GRAPHICS_CONSOLE_DEV;
 
 #define GRAPHICS_CONSOLE_CON_OUT_DEV_FROM_THIS(a) \
@@ -564,6 +591,96 @@ FlushCursor (
   IN  EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *This
   );
 
+/**
+  Return the first scan line of a text row in the shadow buffer.
+
+  @param  Private               The Graphics Console device.
+  @param  Row                   The text row.
+
+  @return The first pixel of the text row.
+
+**/
+EFI_GRAPHICS_OUTPUT_BLT_PIXEL *
+GraphicsConsoleShadowRow (
+  IN  GRAPHICS_CONSOLE_DEV             *Private,
+  IN  UINTN                            Row
+  );
+
+/**
+  Record that pixels of a text row of the shadow buffer were modified.
+
+  @param  Private               The Graphics Console device.
+  @param  Row                   The text row.
+  @param  Left                  The first modified pixel of the row.
+  @param  Right                 The pixel following the last modified one.
+
+**/
+VOID
+GraphicsConsoleMarkDirty (
+  IN  GRAPHICS_CONSOLE_DEV             *Private,
+  IN  UINTN                            Row,
+  IN  UINTN                            Left,
+  IN  UINTN                            Right
+  );
+
+/**
+  Scroll the text window of the shadow buffer up one row.
+
+  The top row of the ring becomes the bottom row and is cleared, all the rows
+  need to be copied to the screen again.
+
+  @param  Private               The Graphics Console device.
+  @param  Background            The color of the new bottom row.
+
+**/
+VOID
+GraphicsConsoleShadowScroll (
+  IN  GRAPHICS_CONSOLE_DEV             *Private,
+  IN  EFI_GRAPHICS_OUTPUT_BLT_PIXEL    *Background
+  );
+
+/**
+  Copy the dirty rows of the shadow buffer to the screen.
+
+  @param  Private               The Graphics Console device.
+
+**/
+VOID
+GraphicsConsoleFlushShadow (
+  IN  GRAPHICS_CONSOLE_DEV             *Private
+  );
+
+/**
+  Copy the dirty rows of the shadow buffer to the screen now, or arm the
+  flush timer.
+
+  The rows are copied now when there is no timer, or when the caller runs at
+  a TPL that would hold off the timer notification.
+
+  @param  Private               The Graphics Console device.
+  @param  CallerTpl             The TPL of the caller of the console service.
+
+**/
+VOID
+GraphicsConsoleScheduleFlush (
+  IN  GRAPHICS_CONSOLE_DEV             *Private,
+  IN  EFI_TPL                          CallerTpl
+  );
+
+/**
+  Notification function of the flush timer and of exit boot services.
+
+  @param[in]  Event     The event being signaled.
+  @param[in]  Context   The Graphics Console device.
+
+**/
+VOID
+EFIAPI
+GraphicsConsoleFlushNotify (
+  IN  EFI_EVENT                        Event,
+  IN  VOID                             *Context
+  );
+
 /**
   Check if the current specific mode supported the user defined resolution
   for the Graphics Console device based on Graphics Output Protocol.
@@ -111,7 +111,18 @@ TERMINAL_DEV  mTerminalDevTemplate = {
     NULL,
     NULL,
   },
-  NULL // KeyNotifyProcessEvent
+  NULL, // KeyNotifyProcessEvent
+  { 0 },  // OutputBuffer
+  0,      // OutputCount
+  NULL,   // OutputEvent
+  FALSE,  // OutputPending
+  0,      // OutputWriteDepth
+  NULL,   // ExitBootServicesEvent
+  -1,     // TerminalAttribute
+  FALSE,  // CursorPositionKnown
+  0,      // OutputBytes
+  0,      // OutputWrites
+  0       // OutputBytesSaved
 };
 
 TERMINAL_CONSOLE_MODE_DATA mTerminalConsoleModeData[] = {
@@ -673,6 +684,24 @@ TerminalDriverBindingStart (
                   &TerminalDevice->KeyNotifyProcessEvent
                   );
   ASSERT_EFI_ERROR (Status);
+  if (PcdGet32 (PcdTerminalOutputFlushInterval) != 0) {
+    Status = gBS->CreateEvent (
+                    EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                    TPL_CALLBACK,
+                    TerminalConOutTimerHandler,
+                    TerminalDevice,
+                    &TerminalDevice->OutputEvent
+                    );
+    ASSERT_EFI_ERROR (Status);
+  }
+  Status = gBS->CreateEvent (
+                  EVT_SIGNAL_EXIT_BOOT_SERVICES,
+                  TPL_NOTIFY,
+                  TerminalConOutExitBootServices,
+                  TerminalDevice,
+                  &TerminalDevice->ExitBootServicesEvent
+                  );
+  ASSERT_EFI_ERROR (Status);
 
   //
   // Allocates and initializes the FIFO buffer to be zero, used for accommodating
@@ -801,6 +830,12 @@ FreeResources:
   if (TerminalDevice->KeyNotifyProcessEvent != NULL) {
     gBS->CloseEvent (TerminalDevice->KeyNotifyProcessEvent);
   }
+  if (TerminalDevice->OutputEvent != NULL) {
+    gBS->CloseEvent (TerminalDevice->OutputEvent);
+  }
+  if (TerminalDevice->ExitBootServicesEvent != NULL) {
+    gBS->CloseEvent (TerminalDevice->ExitBootServicesEvent);
+  }
 
   if (TerminalDevice->RawFiFo != NULL) {
     FreePool (TerminalDevice->RawFiFo);
@@ -983,6 +1018,11 @@ TerminalDriverBindingStop (
         gBS->CloseEvent (TerminalDevice->SimpleInput.WaitForKey);
         gBS->CloseEvent (TerminalDevice->SimpleInputEx.WaitForKeyEx);
         gBS->CloseEvent (TerminalDevice->KeyNotifyProcessEvent);
+        if (TerminalDevice->OutputEvent != NULL) {
+          gBS->CloseEvent (TerminalDevice->OutputEvent);
+        }
+        gBS->CloseEvent (TerminalDevice->ExitBootServicesEvent);
+        TerminalFlushOutput (TerminalDevice, TPL_HIGH_LEVEL);
         TerminalFreeNotifyList (&TerminalDevice->NotifyList);
         FreePool (TerminalDevice->DevicePath);
         FreePool (TerminalDevice->TerminalConsoleModeData);
@@ -65,6 +65,11 @@ typedef struct {
 
 #define KEYBOARD_TIMER_INTERVAL         200000  // 0.02s
 
+//
+// Size of the buffer collecting the bytes sent to the serial device.
+//
+#define TERMINAL_OUTPUT_BUFFER_SIZE     1024
+
 #define TERMINAL_DEV_SIGNATURE  SIGNATURE_32 ('t', 'm', 'n', 'l')
 
 #define TERMINAL_CONSOLE_IN_EX_NOTIFY_SIGNATURE SIGNATURE_32 ('t', 'm', 'e', 'n')
@@ -122,6 +127,39 @@ typedef struct {
   EFI_SIMPLE_TEXT_INPUT_EX_PROTOCOL   SimpleInputEx;
   LIST_ENTRY                          NotifyList;
   EFI_EVENT                           KeyNotifyProcessEvent;
+
+  //
+  // The output of the console services is collected in OutputBuffer and sent
+  // to the serial device with one Write() call at the end of each service, or
+  // by OutputEvent when PcdTerminalOutputFlushInterval is not zero.
+  //
+  UINT8                               OutputBuffer[TERMINAL_OUTPUT_BUFFER_SIZE];
+  UINTN                               OutputCount;
+  EFI_EVENT                           OutputEvent;
+  BOOLEAN                             OutputPending;
+  //
+  // Number of TerminalFlushOutput() calls in SerialIo->Write(), which may be
+  // interrupted by another one.
+  //
+  UINTN                               OutputWriteDepth;
+  EFI_EVENT                           ExitBootServicesEvent;
+  //
+  // Attribute last sent to the terminal, or -1 if unknown. SetAttribute()
+  // only records the attribute, it is sent before the next character.
+  //
+  INT32                               TerminalAttribute;
+  //
+  // TRUE if the terminal cursor is known to be at the position held in
+  // SimpleTextOutputMode, in which case moving it there again sends nothing.
+  //
+  BOOLEAN                             CursorPositionKnown;
+  //
+  // Output statistics: bytes and Write() calls to the serial device, and
+  // bytes of control sequences that did not need to be sent.
+  //
+  UINT64                              OutputBytes;
+  UINT64                              OutputWrites;
+  UINT64                              OutputBytesSaved;
 } TERMINAL_DEV;
 
 #define INPUT_STATE_DEFAULT               0x00
@@ -1428,6 +1466,58 @@ IsHotPlugDevice (
   IN  EFI_DEVICE_PATH_PROTOCOL    *DevicePath
   );
 
+/**
+  Send the bytes collected in the output buffer to the serial device.
+
+  The buffer is taken at TPL_NOTIFY, and sent at WriteTpl, so that a console
+  service raising its TPL to collect output doesn't hold off the ConIn timer
+  while the serial device sends it. The bytes are never sent below the TPL the
+  function is called at, unless WriteTpl says so.
+
+  @param  TerminalDevice        The terminal device.
+  @param  WriteTpl              The TPL to send the bytes at: the TPL of the
+                                caller of the console service that raised
+                                the TPL, or TPL_HIGH_LEVEL to send them at the
+                                TPL of the caller.
+
+  @retval EFI_SUCCESS           The buffer was empty or is sent.
+  @retval EFI_DEVICE_ERROR      The serial device failed to send the bytes,
+                                which are discarded.
+
+**/
+EFI_STATUS
+TerminalFlushOutput (
+  IN TERMINAL_DEV         *TerminalDevice,
+  IN EFI_TPL              WriteTpl
+  );
+
+/**
+  Timer handler to send the output collected by the console services.
+
+  @param  Event                    Indicates the event that invoke this function.
+  @param  Context                  Indicates the calling context.
+**/
+VOID
+EFIAPI
+TerminalConOutTimerHandler (
+  IN EFI_EVENT            Event,
+  IN VOID                 *Context
+  );
+
+/**
+  Send the pending output and report the output statistics when boot services
+  are exited.
+
+  @param  Event                    Indicates the event that invoke this function.
+  @param  Context                  Indicates the calling context.
+**/
+VOID
+EFIAPI
+TerminalConOutExitBootServices (
+  IN EFI_EVENT            Event,
+  IN VOID                 *Context
+  );
+
 /**
   Timer handler to poll the key from serial.
 
@@ -79,6 +79,7 @@ TerminalConInReset (
     TerminalDevice->DevicePath
     );
 
+  TerminalFlushOutput (TerminalDevice, TPL_HIGH_LEVEL);
   Status = TerminalDevice->SerialIo->Reset (TerminalDevice->SerialIo);
 
   //
@@ -546,6 +547,7 @@ TerminalConInTimerHandler (
       SerialInTimeOut = (1 + Mode->DataBits + Mode->StopBits) * 2 * 1000000 / (UINTN) Mode->BaudRate;
     }
 
+    TerminalFlushOutput (TerminalDevice, TPL_HIGH_LEVEL);
     Status = SerialIo->SetAttributes (
                         SerialIo,
                         Mode->BaudRate,
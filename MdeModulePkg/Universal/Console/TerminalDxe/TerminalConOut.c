@@ -80,6 +80,384 @@ CHAR16 mSetCursorPositionString[]  = { ESC, '[', '0', '0', ';', '0', '0', 'H', 0
 CHAR16 mCursorForwardString[]      = { ESC, '[', '0', '0', 'C', 0 };
 CHAR16 mCursorBackwardString[]     = { ESC, '[', '0', '0', 'D', 0 };
 
+//
+// Output buffer management
+//
+
+/**
+  Send the bytes collected in the output buffer to the serial device.
+
+  The buffer is taken at TPL_NOTIFY, and sent at WriteTpl, so that a console
+  service raising its TPL to collect output doesn't hold off the ConIn timer
+  while the serial device sends it. The bytes are never sent below the TPL the
+  function is called at, unless WriteTpl says so.
+
+  @param  TerminalDevice        The terminal device.
+  @param  WriteTpl              The TPL to send the bytes at: the TPL of the
+                                caller of the console service that raised
+                                the TPL, or TPL_HIGH_LEVEL to send them at the
+                                TPL of the caller.
+
+  @retval EFI_SUCCESS           The buffer was empty or is sent.
+  @retval EFI_DEVICE_ERROR      The serial device failed to send the bytes,
+                                which are discarded.
+
+**/
+EFI_STATUS
+TerminalFlushOutput (
+  IN TERMINAL_DEV         *TerminalDevice,
+  IN EFI_TPL              WriteTpl
+  )
+{
+  EFI_STATUS  Status;
+  UINT8       Buffer[TERMINAL_OUTPUT_BUFFER_SIZE];
+  UINTN       Count;
+  UINTN       Length;
+  EFI_TPL     OldTpl;
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+  TerminalDevice->OutputPending = FALSE;
+  Count = TerminalDevice->OutputCount;
+  if (Count == 0) {
+    gBS->RestoreTPL (OldTpl);
+    return EFI_SUCCESS;
+  }
+
+  //
+  // Take the bytes out of the output buffer, which the console services may
+  // fill again while they are being sent.
+  //
+  CopyMem (Buffer, TerminalDevice->OutputBuffer, Count);
+  TerminalDevice->OutputCount = 0;
+
+  TerminalDevice->OutputWriteDepth++;
+  gBS->RestoreTPL (MIN (OldTpl, WriteTpl));
+  Length = Count;
+  Status = TerminalDevice->SerialIo->Write (
+                                      TerminalDevice->SerialIo,
+                                      &Length,
+                                      Buffer
+                                      );
+  gBS->RaiseTPL (TPL_NOTIFY);
+  TerminalDevice->OutputWriteDepth--;
+
+  TerminalDevice->OutputWrites++;
+  TerminalDevice->OutputBytes += Length;
+  if (EFI_ERROR (Status) || (Length != Count)) {
+    Status = EFI_DEVICE_ERROR;
+  }
+
+  gBS->RestoreTPL (OldTpl);
+  return Status;
+}
+
+/**
+  Append bytes to the output buffer, sending the buffer to the serial device
+  each time it is full.
+
+  The caller must be at TPL_NOTIFY.
+
+  @param  TerminalDevice        The terminal device.
+  @param  WriteTpl              The TPL to send the full buffer at, see
+                                TerminalFlushOutput().
+  @param  Bytes                 The bytes to send.
+  @param  Length                The number of bytes to send.
+
+  @retval EFI_SUCCESS           The bytes are buffered.
+  @retval EFI_DEVICE_ERROR      The serial device failed to send the buffer.
+
+**/
+EFI_STATUS
+TerminalOutputBytes (
+  IN TERMINAL_DEV         *TerminalDevice,
+  IN EFI_TPL              WriteTpl,
+  IN CONST VOID           *Bytes,
+  IN UINTN                Length
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Count;
+
+  while (Length > 0) {
+    if (TerminalDevice->OutputCount == TERMINAL_OUTPUT_BUFFER_SIZE) {
+      Status = TerminalFlushOutput (TerminalDevice, WriteTpl);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+    }
+
+    Count = MIN (Length, TERMINAL_OUTPUT_BUFFER_SIZE - TerminalDevice->OutputCount);
+    CopyMem (&TerminalDevice->OutputBuffer[TerminalDevice->OutputCount], Bytes, Count);
+    TerminalDevice->OutputCount += Count;
+    Bytes   = (CONST UINT8 *) Bytes + Count;
+    Length -= Count;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Send the output buffer at the end of a console service.
+
+  When PcdTerminalOutputFlushInterval is not zero and the caller runs below
+  TPL_CALLBACK, the buffer is sent by the timer event instead, together with
+  the output of the services called in the meantime.
+
+  @param  TerminalDevice        The terminal device.
+  @param  CallerTpl             The TPL of the caller of the console service.
+
+  @retval EFI_SUCCESS           The buffer is sent or scheduled.
+  @retval EFI_DEVICE_ERROR      The serial device failed to send the buffer.
+
+**/
+EFI_STATUS
+TerminalScheduleOutput (
+  IN TERMINAL_DEV         *TerminalDevice,
+  IN EFI_TPL              CallerTpl
+  )
+{
+  EFI_STATUS  Status;
+
+  if ((TerminalDevice->OutputEvent != NULL) && (CallerTpl < TPL_CALLBACK)) {
+    if (TerminalDevice->OutputPending) {
+      return EFI_SUCCESS;
+    }
+
+    Status = gBS->SetTimer (
+                    TerminalDevice->OutputEvent,
+                    TimerRelative,
+                    EFI_TIMER_PERIOD_MILLISECONDS (PcdGet32 (PcdTerminalOutputFlushInterval))
+                    );
+    if (!EFI_ERROR (Status)) {
+      TerminalDevice->OutputPending = TRUE;
+      return EFI_SUCCESS;
+    }
+  }
+
+  return TerminalFlushOutput (TerminalDevice, CallerTpl);
+}
+
+/**
+  Timer handler to send the output collected by the console services.
+
+  @param  Event                    Indicates the event that invoke this function.
+  @param  Context                  Indicates the calling context.
+**/
+VOID
+EFIAPI
+TerminalConOutTimerHandler (
+  IN EFI_EVENT            Event,
+  IN VOID                 *Context
+  )
+{
+  TERMINAL_DEV  *TerminalDevice;
+  EFI_STATUS    Status;
+  EFI_TPL       OldTpl;
+  BOOLEAN       Writing;
+
+  TerminalDevice = (TERMINAL_DEV *) Context;
+
+  //
+  // Don't start a write of the serial device from within another one, which
+  // this timer may have interrupted. Try again later instead.
+  //
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  Writing = (BOOLEAN) (TerminalDevice->OutputWriteDepth != 0);
+  if (Writing) {
+    Status = gBS->SetTimer (
+                    Event,
+                    TimerRelative,
+                    EFI_TIMER_PERIOD_MILLISECONDS (PcdGet32 (PcdTerminalOutputFlushInterval))
+                    );
+    Writing = (BOOLEAN) !EFI_ERROR (Status);
+  }
+  gBS->RestoreTPL (OldTpl);
+  if (Writing) {
+    return;
+  }
+
+  Status = TerminalFlushOutput (TerminalDevice, TPL_CALLBACK);
+  if (EFI_ERROR (Status)) {
+    REPORT_STATUS_CODE_WITH_DEVICE_PATH (
+      EFI_ERROR_CODE | EFI_ERROR_MINOR,
+      (EFI_PERIPHERAL_REMOTE_CONSOLE | EFI_P_EC_OUTPUT_ERROR),
+      TerminalDevice->DevicePath
+      );
+  }
+}
+
+/**
+  Send the pending output and report the output statistics when boot services
+  are exited.
+
+  @param  Event                    Indicates the event that invoke this function.
+  @param  Context                  Indicates the calling context.
+**/
+VOID
+EFIAPI
+TerminalConOutExitBootServices (
+  IN EFI_EVENT            Event,
+  IN VOID                 *Context
+  )
+{
+  TERMINAL_DEV  *TerminalDevice;
+
+  TerminalDevice = (TERMINAL_DEV *) Context;
+
+  TerminalFlushOutput (TerminalDevice, TPL_NOTIFY);
+
+  DEBUG ((
+    DEBUG_INFO,
+    "TerminalDxe: %Ld bytes sent in %Ld writes, %Ld bytes of control sequences saved\n",
+    TerminalDevice->OutputBytes,
+    TerminalDevice->OutputWrites,
+    TerminalDevice->OutputBytesSaved
+    ));
+}
+
+/**
+  Send the control sequence of the current attribute, if the terminal does not
+  have it yet.
+
+  The caller must be at TPL_NOTIFY.
+
+  @param  TerminalDevice        The terminal device.
+  @param  WriteTpl              The TPL to send the full buffer at, see
+                                TerminalFlushOutput().
+
+  @retval EFI_SUCCESS           The sequence is buffered or not needed.
+  @retval EFI_DEVICE_ERROR      The serial device failed to send the buffer.
+
+**/
+EFI_STATUS
+TerminalSyncAttribute (
+  IN TERMINAL_DEV         *TerminalDevice,
+  IN EFI_TPL              WriteTpl
+  )
+{
+  INT32         Attribute;
+  UINT8         ForegroundControl;
+  UINT8         BackgroundControl;
+  UINT8         BrightControl;
+  CHAR8         Sequence[ARRAY_SIZE (mSetAttributeString)];
+  UINTN         Index;
+  EFI_STATUS    Status;
+
+  Attribute = TerminalDevice->SimpleTextOutputMode.Attribute;
+  if (Attribute == TerminalDevice->TerminalAttribute) {
+    return EFI_SUCCESS;
+  }
+
+  //
+  //  convert Attribute value to terminal emulator
+  //  understandable foreground color
+  //
+  switch (Attribute & 0x07) {
+
+  case EFI_BLACK:
+    ForegroundControl = 30;
+    break;
+
+  case EFI_BLUE:
+    ForegroundControl = 34;
+    break;
+
+  case EFI_GREEN:
+    ForegroundControl = 32;
+    break;
+
+  case EFI_CYAN:
+    ForegroundControl = 36;
+    break;
+
+  case EFI_RED:
+    ForegroundControl = 31;
+    break;
+
+  case EFI_MAGENTA:
+    ForegroundControl = 35;
+    break;
+
+  case EFI_BROWN:
+    ForegroundControl = 33;
+    break;
+
+  default:
+
+  case EFI_LIGHTGRAY:
+    ForegroundControl = 37;
+    break;
+
+  }
+  //
+  //  bit4 of the Attribute indicates bright control
+  //  of terminal emulator.
+  //
+  BrightControl = (UINT8) ((Attribute >> 3) & 1);
+
+  //
+  //  convert Attribute value to terminal emulator
+  //  understandable background color.
+  //
+  switch ((Attribute >> 4) & 0x07) {
+
+  case EFI_BLACK:
+    BackgroundControl = 40;
+    break;
+
+  case EFI_BLUE:
+    BackgroundControl = 44;
+    break;
+
+  case EFI_GREEN:
+    BackgroundControl = 42;
+    break;
+
+  case EFI_CYAN:
+    BackgroundControl = 46;
+    break;
+
+  case EFI_RED:
+    BackgroundControl = 41;
+    break;
+
+  case EFI_MAGENTA:
+    BackgroundControl = 45;
+    break;
+
+  case EFI_BROWN:
+    BackgroundControl = 43;
+    break;
+
+  default:
+
+  case EFI_LIGHTGRAY:
+    BackgroundControl = 47;
+    break;
+  }
+  //
+  // terminal emulator's control sequence to set attributes
+  //
+  mSetAttributeString[BRIGHT_CONTROL_OFFSET]          = (CHAR16) ('0' + BrightControl);
+  mSetAttributeString[FOREGROUND_CONTROL_OFFSET + 0]  = (CHAR16) ('0' + (ForegroundControl / 10));
+  mSetAttributeString[FOREGROUND_CONTROL_OFFSET + 1]  = (CHAR16) ('0' + (ForegroundControl % 10));
+  mSetAttributeString[BACKGROUND_CONTROL_OFFSET + 0]  = (CHAR16) ('0' + (BackgroundControl / 10));
+  mSetAttributeString[BACKGROUND_CONTROL_OFFSET + 1]  = (CHAR16) ('0' + (BackgroundControl % 10));
+
+  for (Index = 0; mSetAttributeString[Index] != CHAR_NULL; Index++) {
+    Sequence[Index] = (CHAR8) mSetAttributeString[Index];
+  }
+
+  Status = TerminalOutputBytes (TerminalDevice, WriteTpl, Sequence, Index);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  TerminalDevice->TerminalAttribute = Attribute;
+  return EFI_SUCCESS;
+}
+
 //
 // Body of the ConOut functions
 //
@@ -125,6 +503,7 @@ TerminalConOutReset (
       TerminalDevice->DevicePath
       );
 
+    TerminalFlushOutput (TerminalDevice, TPL_HIGH_LEVEL);
     Status = TerminalDevice->SerialIo->Reset (TerminalDevice->SerialIo);
     if (EFI_ERROR (Status)) {
       //
@@ -176,13 +555,13 @@ TerminalConOutOutputString (
   EFI_SIMPLE_TEXT_OUTPUT_MODE *Mode;
   UINTN                       MaxColumn;
   UINTN                       MaxRow;
-  UINTN                       Length;
   UTF8_CHAR                   Utf8Char;
   CHAR8                       GraphicChar;
   CHAR8                       AsciiChar;
   EFI_STATUS                  Status;
   UINT8                       ValidBytes;
   CHAR8                       CrLfStr[2];
+  EFI_TPL                     OldTpl;
   //
   //  flag used to indicate whether condition happens which will cause
   //  return EFI_WARN_UNKNOWN_GLYPH
@@ -214,6 +593,20 @@ TerminalConOutOutputString (
           &MaxRow
           );
 
+  //
+  // Collect the output in the output buffer, and keep the timer event from
+  // sending it while it is being updated. The buffer is sent at the TPL of
+  // the caller when it fills up.
+  //
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+  if (!TerminalDevice->OutputEscChar && (*WString != CHAR_NULL)) {
+    Status = TerminalSyncAttribute (TerminalDevice, OldTpl);
+    if (EFI_ERROR (Status)) {
+      goto OutputError;
+    }
+  }
+
   for (; *WString != CHAR_NULL; WString++) {
 
     switch (TerminalDevice->TerminalType) {
@@ -255,14 +648,7 @@ TerminalConOutOutputString (
         GraphicChar = AsciiChar;
       }
 
-      Length = 1;
-
-      Status = TerminalDevice->SerialIo->Write (
-                                          TerminalDevice->SerialIo,
-                                          &Length,
-                                          &GraphicChar
-                                          );
-
+      Status = TerminalOutputBytes (TerminalDevice, OldTpl, &GraphicChar, 1);
       if (EFI_ERROR (Status)) {
         goto OutputError;
       }
@@ -271,15 +657,18 @@ TerminalConOutOutputString (
 
     case TerminalTypeVtUtf8:
       UnicodeToUtf8 (*WString, &Utf8Char, &ValidBytes);
-      Length = ValidBytes;
-      Status = TerminalDevice->SerialIo->Write (
-                                          TerminalDevice->SerialIo,
-                                          &Length,
-                                          (UINT8 *) &Utf8Char
-                                          );
+      Status = TerminalOutputBytes (TerminalDevice, OldTpl, &Utf8Char, ValidBytes);
       if (EFI_ERROR (Status)) {
         goto OutputError;
       }
+
+      //
+      // Characters beyond ASCII and the text graphics may be displayed double
+      // width.
+      //
+      if ((*WString > 0x7f) && !TerminalIsValidTextGraphics (*WString, NULL, NULL)) {
+        TerminalDevice->CursorPositionKnown = FALSE;
+      }
       break;
     }
     //
@@ -304,6 +693,14 @@ TerminalConOutOutputString (
       break;
 
     default:
+      if (*WString < L' ') {
+        //
+        // Tabs and the other control characters do not move the terminal
+        // cursor by one column.
+        //
+        TerminalDevice->CursorPositionKnown = FALSE;
+      }
+
       if (Mode->CursorColumn < (INT32) (MaxColumn - 1)) {
 
         Mode->CursorColumn++;
@@ -328,17 +725,15 @@ TerminalConOutOutputString (
           CrLfStr[0] = '\r';
           CrLfStr[1] = '\n';
 
-          Length = sizeof(CrLfStr);
-
-          Status = TerminalDevice->SerialIo->Write (
-                                                TerminalDevice->SerialIo,
-                                                &Length,
-                                                CrLfStr
-                                                );
-
+          Status = TerminalOutputBytes (TerminalDevice, OldTpl, CrLfStr, sizeof (CrLfStr));
           if (EFI_ERROR (Status)) {
             goto OutputError;
           }
+        } else if (!TerminalDevice->OutputEscChar) {
+          //
+          // Whether and when the terminal wraps depends on its settings.
+          //
+          TerminalDevice->CursorPositionKnown = FALSE;
         }
       }
       break;
@@ -347,6 +742,13 @@ TerminalConOutOutputString (
 
   }
 
+  Status = TerminalScheduleOutput (TerminalDevice, OldTpl);
+  if (EFI_ERROR (Status)) {
+    goto OutputError;
+  }
+
+  gBS->RestoreTPL (OldTpl);
+
   if (Warning) {
     return EFI_WARN_UNKNOWN_GLYPH;
   }
@@ -354,6 +756,8 @@ TerminalConOutOutputString (
   return EFI_SUCCESS;
 
 OutputError:
+  gBS->RestoreTPL (OldTpl);
+
   REPORT_STATUS_CODE_WITH_DEVICE_PATH (
     EFI_ERROR_CODE | EFI_ERROR_MINOR,
     (EFI_PERIPHERAL_REMOTE_CONSOLE | EFI_P_EC_OUTPUT_ERROR),
@@ -537,17 +941,8 @@ TerminalConOutSetAttribute (
   IN  UINTN                            Attribute
   )
 {
-  UINT8         ForegroundControl;
-  UINT8         BackgroundControl;
-  UINT8         BrightControl;
-  INT32         SavedColumn;
-  INT32         SavedRow;
-  EFI_STATUS    Status;
   TERMINAL_DEV  *TerminalDevice;
 
-  SavedColumn = 0;
-  SavedRow    = 0;
-
   //
   //  get Terminal device data structure pointer.
   //
@@ -569,120 +964,19 @@ TerminalConOutSetAttribute (
   }
 
   //
-  //  convert Attribute value to terminal emulator
-  //  understandable foreground color
+  // The control sequence is sent before the next character, see
+  // TerminalSyncAttribute(). The sequence of the previous attribute is not
+  // needed if it was not sent yet, nor is the sequence of this attribute if
+  // the terminal has it already.
   //
-  switch (Attribute & 0x07) {
-
-  case EFI_BLACK:
-    ForegroundControl = 30;
-    break;
-
-  case EFI_BLUE:
-    ForegroundControl = 34;
-    break;
-
-  case EFI_GREEN:
-    ForegroundControl = 32;
-    break;
-
-  case EFI_CYAN:
-    ForegroundControl = 36;
-    break;
-
-  case EFI_RED:
-    ForegroundControl = 31;
-    break;
-
-  case EFI_MAGENTA:
-    ForegroundControl = 35;
-    break;
-
-  case EFI_BROWN:
-    ForegroundControl = 33;
-    break;
-
-  default:
-
-  case EFI_LIGHTGRAY:
-    ForegroundControl = 37;
-    break;
-
-  }
-  //
-  //  bit4 of the Attribute indicates bright control
-  //  of terminal emulator.
-  //
-  BrightControl = (UINT8) ((Attribute >> 3) & 1);
-
-  //
-  //  convert Attribute value to terminal emulator
-  //  understandable background color.
-  //
-  switch ((Attribute >> 4) & 0x07) {
-
-  case EFI_BLACK:
-    BackgroundControl = 40;
-    break;
-
-  case EFI_BLUE:
-    BackgroundControl = 44;
-    break;
-
-  case EFI_GREEN:
-    BackgroundControl = 42;
-    break;
-
-  case EFI_CYAN:
-    BackgroundControl = 46;
-    break;
-
-  case EFI_RED:
-    BackgroundControl = 41;
-    break;
-
-  case EFI_MAGENTA:
-    BackgroundControl = 45;
-    break;
-
-  case EFI_BROWN:
-    BackgroundControl = 43;
-    break;
-
-  default:
-
-  case EFI_LIGHTGRAY:
-    BackgroundControl = 47;
-    break;
-  }
-  //
-  // terminal emulator's control sequence to set attributes
-  //
-  mSetAttributeString[BRIGHT_CONTROL_OFFSET]          = (CHAR16) ('0' + BrightControl);
-  mSetAttributeString[FOREGROUND_CONTROL_OFFSET + 0]  = (CHAR16) ('0' + (ForegroundControl / 10));
-  mSetAttributeString[FOREGROUND_CONTROL_OFFSET + 1]  = (CHAR16) ('0' + (ForegroundControl % 10));
-  mSetAttributeString[BACKGROUND_CONTROL_OFFSET + 0]  = (CHAR16) ('0' + (BackgroundControl / 10));
-  mSetAttributeString[BACKGROUND_CONTROL_OFFSET + 1]  = (CHAR16) ('0' + (BackgroundControl % 10));
-
-  //
-  // save current column and row
-  // for future scrolling back use.
-  //
-  SavedColumn                   = This->Mode->CursorColumn;
-  SavedRow                      = This->Mode->CursorRow;
-
-  TerminalDevice->OutputEscChar = TRUE;
-  Status                        = This->OutputString (This, mSetAttributeString);
-  TerminalDevice->OutputEscChar = FALSE;
-
-  if (EFI_ERROR (Status)) {
-    return EFI_DEVICE_ERROR;
+  if (TerminalDevice->TerminalAttribute != -1) {
+    if (This->Mode->Attribute != TerminalDevice->TerminalAttribute) {
+      TerminalDevice->OutputBytesSaved += ARRAY_SIZE (mSetAttributeString) - 1;
+    }
+    if ((INT32) Attribute == TerminalDevice->TerminalAttribute) {
+      TerminalDevice->OutputBytesSaved += ARRAY_SIZE (mSetAttributeString) - 1;
+    }
   }
-  //
-  //  scroll back to saved cursor position.
-  //
-  This->Mode->CursorColumn  = SavedColumn;
-  This->Mode->CursorRow     = SavedRow;
 
   This->Mode->Attribute     = (INT32) Attribute;
 
@@ -711,9 +1005,20 @@ TerminalConOutClearScreen (
 {
   EFI_STATUS    Status;
   TERMINAL_DEV  *TerminalDevice;
+  EFI_TPL       OldTpl;
 
   TerminalDevice = TERMINAL_CON_OUT_DEV_FROM_THIS (This);
 
+  //
+  // The screen is cleared to the background color of the current attribute.
+  //
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  Status = TerminalSyncAttribute (TerminalDevice, OldTpl);
+  gBS->RestoreTPL (OldTpl);
+  if (EFI_ERROR (Status)) {
+    return EFI_DEVICE_ERROR;
+  }
+
   //
   //  control sequence for clear screen request
   //
@@ -725,6 +1030,7 @@ TerminalConOutClearScreen (
     return EFI_DEVICE_ERROR;
   }
 
+  TerminalDevice->CursorPositionKnown = FALSE;
   Status = This->SetCursorPosition (This, 0, 0);
 
   return Status;
@@ -782,6 +1088,18 @@ TerminalConOutSetCursorPosition (
   if (Column >= MaxColumn || Row >= MaxRow) {
     return EFI_UNSUPPORTED;
   }
+
+  //
+  // Nothing to send if the terminal cursor is known to be there already.
+  //
+  if (TerminalDevice->CursorPositionKnown &&
+      ((UINTN) Mode->CursorColumn == Column) && ((UINTN) Mode->CursorRow == Row)) {
+    if (TerminalDevice->TerminalType != TerminalTypeTtyTerm) {
+      TerminalDevice->OutputBytesSaved += ARRAY_SIZE (mSetCursorPositionString) - 1;
+    }
+    return EFI_SUCCESS;
+  }
+
   //
   // control sequence to move the cursor
   //
@@ -790,6 +1108,7 @@ TerminalConOutSetCursorPosition (
   // it isn't necessary.
   //
   if (TerminalDevice->TerminalType == TerminalTypeTtyTerm &&
+      TerminalDevice->CursorPositionKnown &&
       (UINTN)Mode->CursorRow == Row) {
     if ((UINTN)Mode->CursorColumn > Column) {
       mCursorBackwardString[FW_BACK_OFFSET + 0] = (CHAR16) ('0' + ((Mode->CursorColumn - Column) / 10));
@@ -826,6 +1145,7 @@ TerminalConOutSetCursorPosition (
   //
   Mode->CursorColumn  = (INT32) Column;
   Mode->CursorRow     = (INT32) Row;
+  TerminalDevice->CursorPositionKnown = TRUE;
 
   return EFI_SUCCESS;
 }
@@ -523,6 +523,22 @@ EbcDebuggerHookEbcInterpret (
   return ;
 }
 
+/**
+
+  The hook in EbcExecute, to check whether the per-instruction hooks are
+  in use. The debugger always needs them.
+
+  @retval TRUE   The debugger hooks are in use.
+
+**/
+BOOLEAN
+EbcDebuggerHookIsEnabled (
+  VOID
+  )
+{
+  return TRUE;
+}
+
 /**
 
   The hook in EbcExecute, before ExecuteFunction.
@@ -88,6 +88,23 @@ EbcDebuggerHookEbcInterpret (
   return;
 }
 
+/**
+  The hook in EbcExecute, to check whether the per-instruction hooks are
+  in use. If not, EbcExecute may run pre-decoded instructions without
+  calling them.
+
+  @retval TRUE   The debugger hooks are in use.
+  @retval FALSE  The debugger hooks do nothing.
+
+**/
+BOOLEAN
+EbcDebuggerHookIsEnabled (
+  VOID
+  )
+{
+  return FALSE;
+}
+
 /**
   The hook in EbcExecute, before ExecuteFunction.
 
@@ -1339,6 +1339,833 @@ CONST VM_TABLE_ENTRY           mVmOpcodeTable[] = {
 //
 CONST UINT8                    mJMPLen[] = { 2, 2, 6, 10 };
 
+//
+// Size of the decoded instruction cache used by EbcExecute(). Must be a
+// power of 2. EBC instructions are always 2-byte aligned, so the cache is
+// indexed by IP / 2.
+//
+#define VM_DECODE_CACHE_SIZE      1024
+
+VM_DECODED_INSTRUCTION  *mVmDecodeCache = NULL;
+
+//
+// TRUE while EbcExecute() looks up or runs an entry of the cache, or a
+// block compiled by the JIT. EBC event callbacks may interrupt the
+// interpreter at any point. If they find the cache busy, they dispatch
+// through the opcode table instead, so an entry or a block is never changed
+// under the instance that is using it.
+//
+BOOLEAN                 mVmDecodeCacheBusy = FALSE;
+
+//
+// Bumped each time the cache is flushed, so that flushing does not have to
+// touch the entries. Entries are allocated zeroed, so generation 0 is never
+// valid.
+//
+UINTN                   mVmDecodeCacheGeneration = 1;
+
+/**
+  Allocate the decoded instruction cache used by EbcExecute().
+
+  If the cache can not be allocated, every instruction is dispatched
+  through the opcode table, which is slower but otherwise equivalent.
+
+  @retval EFI_SUCCESS           The cache was allocated.
+  @retval EFI_OUT_OF_RESOURCES  Memory could not be allocated for the cache.
+
+**/
+EFI_STATUS
+InitEbcDecodeCache (
+  VOID
+  )
+{
+  if (mVmDecodeCache == NULL) {
+    mVmDecodeCache = AllocateZeroPool (VM_DECODE_CACHE_SIZE * sizeof (VM_DECODED_INSTRUCTION));
+    if (mVmDecodeCache == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+
+/**
+  Free the decoded instruction cache used by EbcExecute().
+
+**/
+VOID
+FreeEbcDecodeCache (
+  VOID
+  )
+{
+  if (mVmDecodeCache != NULL) {
+    FreePool (mVmDecodeCache);
+    mVmDecodeCache = NULL;
+  }
+}
+
+
+/**
+  Invalidate all decoded instructions. This must be called whenever EBC code
+  that may have been executed is modified or unloaded.
+
+**/
+VOID
+FlushEbcDecodeCache (
+  VOID
+  )
+{
+  mVmDecodeCacheGeneration++;
+}
+
+
+/**
+  Check whether a decoded conditional jump is taken.
+
+  @param  VmPtr             A pointer to a VM context.
+  @param  Condition         CONDITION_M_xxx bits of the jump instruction.
+
+  @retval TRUE              The jump is taken.
+  @retval FALSE             The jump falls through.
+
+**/
+BOOLEAN
+VmThreadedIsBranchTaken (
+  IN VM_CONTEXT   *VmPtr,
+  IN UINT8        Condition
+  )
+{
+  if ((Condition & CONDITION_M_CONDITIONAL) == 0) {
+    return TRUE;
+  }
+
+  return (BOOLEAN) (((Condition & CONDITION_M_CS) != 0) == (VMFLAG_ISSET (VmPtr, VMFLAGS_CC) != 0));
+}
+
+
+/**
+  Evaluate a decoded CMP or CMPI instruction and update the condition flag,
+  following the rules of ExecuteCMP() and ExecuteCMPI().
+
+  @param  VmPtr             A pointer to a VM context.
+  @param  Decoded           The decoded compare instruction.
+
+**/
+VOID
+VmThreadedEvaluateCompare (
+  IN VM_CONTEXT                    *VmPtr,
+  IN CONST VM_DECODED_INSTRUCTION  *Decoded
+  )
+{
+  INT64   Op1;
+  INT64   Op2;
+  BOOLEAN Flag;
+
+  Op1 = VmPtr->Gpr[Decoded->Operand1];
+  Op2 = (INT64) Decoded->Data;
+  if (Decoded->Operand2 != VM_DECODED_NO_REGISTER) {
+    Op2 += VmPtr->Gpr[Decoded->Operand2];
+  }
+
+  Flag = FALSE;
+  if (Decoded->Is64Bit) {
+    switch (Decoded->Compare) {
+    case OPCODE_CMPEQ:
+      Flag = (BOOLEAN) (Op1 == Op2);
+      break;
+
+    case OPCODE_CMPLTE:
+      Flag = (BOOLEAN) (Op1 <= Op2);
+      break;
+
+    case OPCODE_CMPGTE:
+      Flag = (BOOLEAN) (Op1 >= Op2);
+      break;
+
+    case OPCODE_CMPULTE:
+      Flag = (BOOLEAN) ((UINT64) Op1 <= (UINT64) Op2);
+      break;
+
+    case OPCODE_CMPUGTE:
+      Flag = (BOOLEAN) ((UINT64) Op1 >= (UINT64) Op2);
+      break;
+
+    default:
+      ASSERT (0);
+    }
+  } else {
+    switch (Decoded->Compare) {
+    case OPCODE_CMPEQ:
+      Flag = (BOOLEAN) ((INT32) Op1 == (INT32) Op2);
+      break;
+
+    case OPCODE_CMPLTE:
+      Flag = (BOOLEAN) ((INT32) Op1 <= (INT32) Op2);
+      break;
+
+    case OPCODE_CMPGTE:
+      Flag = (BOOLEAN) ((INT32) Op1 >= (INT32) Op2);
+      break;
+
+    case OPCODE_CMPULTE:
+      Flag = (BOOLEAN) ((UINT32) Op1 <= (UINT32) Op2);
+      break;
+
+    case OPCODE_CMPUGTE:
+      Flag = (BOOLEAN) ((UINT32) Op1 >= (UINT32) Op2);
+      break;
+
+    default:
+      ASSERT (0);
+    }
+  }
+
+  if (Flag) {
+    VMFLAG_SET (VmPtr, VMFLAGS_CC);
+  } else {
+    VMFLAG_CLEAR (VmPtr, (UINT64)VMFLAGS_CC);
+  }
+}
+
+
+/**
+  Threaded form of MOVxx R1, R2 {Index}.
+
+  @param  VmPtr             A pointer to a VM context.
+  @param  Decoded           The decoded instruction.
+
+**/
+VOID
+VmThreadedMove (
+  IN VM_CONTEXT                    *VmPtr,
+  IN CONST VM_DECODED_INSTRUCTION  *Decoded
+  )
+{
+  VmPtr->Gpr[Decoded->Operand1] = (VM_REGISTER) (((UINT64) VmPtr->Gpr[Decoded->Operand2] + Decoded->Data) & Decoded->Mask);
+  VmPtr->Ip += Decoded->Size;
+}
+
+
+/**
+  Threaded form of MOVxx with an indirect operand. Memory is accessed as in
+  ExecuteMOVxx().
+
+  @param  VmPtr             A pointer to a VM context.
+  @param  Decoded           The decoded instruction.
+
+**/
+VOID
+VmThreadedMoveMemory (
+  IN VM_CONTEXT                    *VmPtr,
+  IN CONST VM_DECODED_INSTRUCTION  *Decoded
+  )
+{
+  UINT64  Data64;
+  UINTN   Address;
+
+  MemoryFence ();
+
+  if (OPERAND2_INDIRECT (Decoded->Operands)) {
+    Address = (UINTN) ((UINT64) VmPtr->Gpr[Decoded->Operand2] + Decoded->Data);
+    switch (Decoded->MoveSize) {
+    case sizeof (UINT8):
+      Data64 = VmReadMem8 (VmPtr, Address);
+      break;
+
+    case sizeof (UINT16):
+      Data64 = VmReadMem16 (VmPtr, Address);
+      break;
+
+    case sizeof (UINT32):
+      Data64 = VmReadMem32 (VmPtr, Address);
+      break;
+
+    default:
+      Data64 = VmReadMem64 (VmPtr, Address);
+      break;
+    }
+  } else {
+    Data64 = (UINT64) VmPtr->Gpr[Decoded->Operand2] + Decoded->Data;
+  }
+
+  if (OPERAND1_INDIRECT (Decoded->Operands)) {
+    Address = (UINTN) ((UINT64) VmPtr->Gpr[Decoded->Operand1] + Decoded->Index);
+    switch (Decoded->MoveSize) {
+    case sizeof (UINT8):
+      VmWriteMem8 (VmPtr, Address, (UINT8) Data64);
+      break;
+
+    case sizeof (UINT16):
+      VmWriteMem16 (VmPtr, Address, (UINT16) Data64);
+      break;
+
+    case sizeof (UINT32):
+      VmWriteMem32 (VmPtr, Address, (UINT32) Data64);
+      break;
+
+    default:
+      VmWriteMem64 (VmPtr, Address, Data64);
+      break;
+    }
+  } else {
+    VmPtr->Gpr[Decoded->Operand1] = (VM_REGISTER) (Data64 & Decoded->Mask);
+  }
+
+  VmPtr->Ip += Decoded->Size;
+
+  MemoryFence ();
+}
+
+
+/**
+  Threaded form of MOVI, MOVIn and MOVREL with a register destination. The
+  value stored is computed when decoding.
+
+  @param  VmPtr             A pointer to a VM context.
+  @param  Decoded           The decoded instruction.
+
+**/
+VOID
+VmThreadedMoveImmediate (
+  IN VM_CONTEXT                    *VmPtr,
+  IN CONST VM_DECODED_INSTRUCTION  *Decoded
+  )
+{
+  VmPtr->Gpr[Decoded->Operand1] = (VM_REGISTER) Decoded->Data;
+  VmPtr->Ip += Decoded->Size;
+}
+
+
+/**
+  Fused MOVI/MOVIn/MOVREL R1, Immed followed by an EBC to EBC CALL, which is
+  how calls through a function pointer are usually generated.
+
+  @param  VmPtr             A pointer to a VM context.
+  @param  Decoded           The decoded instruction pair.
+
+**/
+VOID
+VmThreadedMoveImmediateCall (
+  IN VM_CONTEXT                    *VmPtr,
+  IN CONST VM_DECODED_INSTRUCTION  *Decoded
+  )
+{
+  VmPtr->Gpr[Decoded->Operand1] = (VM_REGISTER) Decoded->Data;
+  VmPtr->Ip += Decoded->Size;
+
+  MemoryFence ();
+  ExecuteCALL (VmPtr);
+  MemoryFence ();
+}
+
+
+/**
+  Threaded form of the data manipulation instructions with both operands
+  direct. Operands and the result are handled as in ExecuteDataManip().
+
+  @param  VmPtr             A pointer to a VM context.
+  @param  Decoded           The decoded instruction.
+
+**/
+VOID
+VmThreadedDataManip (
+  IN VM_CONTEXT                    *VmPtr,
+  IN CONST VM_DECODED_INSTRUCTION  *Decoded
+  )
+{
+  UINT64  Op1;
+  UINT64  Op2;
+
+  Op2 = (UINT64) VmPtr->Gpr[Decoded->Operand2] + Decoded->Data;
+  Op1 = (UINT64) VmPtr->Gpr[Decoded->Operand1];
+  if (!Decoded->Is64Bit) {
+    if (Decoded->IsSigned) {
+      Op1 = (UINT64) (INT64) ((INT32) Op1);
+      Op2 = (UINT64) (INT64) ((INT32) Op2);
+    } else {
+      Op1 = (UINT64) ((UINT32) Op1);
+      Op2 = (UINT64) ((UINT32) Op2);
+    }
+  }
+
+  //
+  // The dispatch functions look at the opcode, so VmPtr->Ip must still
+  // point to the instruction here.
+  //
+  Op2 = mDataManipDispatchTable[Decoded->DataManipIndex](VmPtr, Op1, Op2);
+  if (!Decoded->Is64Bit) {
+    Op2 &= 0xFFFFFFFF;
+  }
+
+  VmPtr->Gpr[Decoded->Operand1] = (VM_REGISTER) Op2;
+  VmPtr->Ip += Decoded->Size;
+}
+
+
+/**
+  Threaded form of CMP R1, R2 {Immed16} and CMPI R1, Immed.
+
+  @param  VmPtr             A pointer to a VM context.
+  @param  Decoded           The decoded instruction.
+
+**/
+VOID
+VmThreadedCompare (
+  IN VM_CONTEXT                    *VmPtr,
+  IN CONST VM_DECODED_INSTRUCTION  *Decoded
+  )
+{
+  VmThreadedEvaluateCompare (VmPtr, Decoded);
+  VmPtr->Ip += Decoded->Size;
+}
+
+
+/**
+  Fused CMP/CMPI followed by a conditional JMP or JMP8.
+
+  @param  VmPtr             A pointer to a VM context.
+  @param  Decoded           The decoded instruction pair.
+
+**/
+VOID
+VmThreadedCompareJump (
+  IN VM_CONTEXT                    *VmPtr,
+  IN CONST VM_DECODED_INSTRUCTION  *Decoded
+  )
+{
+  VmThreadedEvaluateCompare (VmPtr, Decoded);
+  if (VmThreadedIsBranchTaken (VmPtr, Decoded->Condition)) {
+    VmPtr->Ip = Decoded->Target;
+  } else {
+    VmPtr->Ip += Decoded->TotalSize;
+  }
+}
+
+
+/**
+  Threaded form of JMP8 and of JMP with an immediate target.
+
+  @param  VmPtr             A pointer to a VM context.
+  @param  Decoded           The decoded instruction.
+
+**/
+VOID
+VmThreadedJump (
+  IN VM_CONTEXT                    *VmPtr,
+  IN CONST VM_DECODED_INSTRUCTION  *Decoded
+  )
+{
+  if (VmThreadedIsBranchTaken (VmPtr, Decoded->Condition)) {
+    VmPtr->Ip = Decoded->Target;
+  } else {
+    VmPtr->Ip += Decoded->Size;
+  }
+}
+
+
+/**
+  Threaded form of an EBC to EBC CALL with an immediate target. The return
+  address and frame pointer are pushed as in ExecuteCALL().
+
+  @param  VmPtr             A pointer to a VM context.
+  @param  Decoded           The decoded instruction.
+
+**/
+VOID
+VmThreadedCall (
+  IN VM_CONTEXT                    *VmPtr,
+  IN CONST VM_DECODED_INSTRUCTION  *Decoded
+  )
+{
+  VOID  *FramePtr;
+
+  MemoryFence ();
+
+  FramePtr = VmPtr->FramePtr;
+  VmPtr->Gpr[0] -= 8;
+  VmWriteMemN (VmPtr, (UINTN) VmPtr->Gpr[0], (UINTN) FramePtr);
+  VmPtr->FramePtr = (VOID *) (UINTN) VmPtr->Gpr[0];
+  VmPtr->Gpr[0] -= 8;
+  VmWriteMem64 (VmPtr, (UINTN) VmPtr->Gpr[0], (UINT64) (UINTN) (VmPtr->Ip + Decoded->Size));
+  VmPtr->Ip = Decoded->Target;
+
+  MemoryFence ();
+}
+
+
+/**
+  Decode a single instruction into its threaded form if its operands are
+  registers, immediate data or register indirect memory. Encodings that are
+  invalid or that would raise an exception are left to the opcode table
+  handlers.
+
+  @param  VmPtr             A pointer to a VM context.
+  @param  Offset            Offset of the instruction from VmPtr->Ip.
+  @param  Decoded           Receives the decoded instruction.
+
+  @retval TRUE              The instruction was decoded.
+  @retval FALSE             The instruction must be executed through
+                            mVmOpcodeTable.
+
+**/
+BOOLEAN
+VmDecodeThreadedInstruction (
+  IN  VM_CONTEXT              *VmPtr,
+  IN  UINT32                  Offset,
+  OUT VM_DECODED_INSTRUCTION  *Decoded
+  )
+{
+  VMIP    Ip;
+  UINT8   Opcode;
+  UINT8   OpcMasked;
+  UINT8   Operands;
+  INT64   Immed64;
+
+  Ip        = VmPtr->Ip + Offset;
+  Opcode    = Ip[0];
+  Operands  = Ip[1];
+  OpcMasked = (UINT8) (Opcode & OPCODE_M_OPCODE);
+
+  Decoded->Opcode   = OpcMasked;
+  Decoded->Operands = Operands;
+  Decoded->Operand1 = (UINT8) OPERAND1_REGNUM (Operands);
+  Decoded->Operand2 = (UINT8) OPERAND2_REGNUM (Operands);
+  Decoded->Data     = 0;
+  Decoded->Index    = 0;
+  Decoded->Mask     = (UINT64)~0;
+
+  switch (OpcMasked) {
+  case OPCODE_JMP8:
+    Decoded->Size       = 2;
+    Decoded->Condition  = (UINT8) (Opcode & (CONDITION_M_CONDITIONAL | CONDITION_M_CS));
+    Decoded->Target     = Ip + VmReadImmed8 (VmPtr, Offset + 1) * 2 + 2;
+    Decoded->Function   = VmThreadedJump;
+    return TRUE;
+
+  case OPCODE_JMP:
+    //
+    // Only JMP64 Immed64 and JMP32 R0 Immed32.
+    //
+    if ((Opcode & OPCODE_M_IMMDATA) == 0) {
+      return FALSE;
+    }
+
+    Decoded->Size = mJMPLen[(Opcode >> 6) & 0x03];
+    if ((Opcode & OPCODE_M_IMMDATA64) != 0) {
+      Immed64 = VmReadImmed64 (VmPtr, Offset + 2);
+    } else {
+      if ((OPERAND1_REGNUM (Operands) != 0) || OPERAND1_INDIRECT (Operands)) {
+        return FALSE;
+      }
+
+      Immed64 = VmReadImmed32 (VmPtr, Offset + 2);
+    }
+
+    if (!IS_ALIGNED ((UINTN) Immed64, sizeof (UINT16))) {
+      return FALSE;
+    }
+
+    if ((Operands & JMP_M_RELATIVE) != 0) {
+      Decoded->Target = Ip + (UINTN) Immed64 + Decoded->Size;
+    } else {
+      Decoded->Target = (VMIP) (UINTN) Immed64;
+    }
+
+    Decoded->Condition  = (UINT8) (Operands & (CONDITION_M_CONDITIONAL | CONDITION_M_CS));
+    Decoded->Function   = VmThreadedJump;
+    return TRUE;
+
+  case OPCODE_CALL:
+    //
+    // Only EBC calls with an immediate target: CALL64 Immed64, which is
+    // always absolute, and CALL32 R0 Immed32.
+    //
+    if (((Operands & OPERAND_M_NATIVE_CALL) != 0) || ((Opcode & OPCODE_M_IMMDATA) == 0)) {
+      return FALSE;
+    }
+
+    if ((Opcode & OPCODE_M_IMMDATA64) != 0) {
+      Decoded->Size   = 10;
+      Decoded->Target = (VMIP) (UINTN) VmReadImmed64 (VmPtr, Offset + 2);
+    } else {
+      if ((OPERAND1_REGNUM (Operands) != 0) || OPERAND1_INDIRECT (Operands)) {
+        return FALSE;
+      }
+
+      Decoded->Size = 6;
+      Immed64       = VmReadImmed32 (VmPtr, Offset + 2);
+      if ((Operands & OPERAND_M_RELATIVE_ADDR) != 0) {
+        Decoded->Target = Ip + Immed64 + Decoded->Size;
+      } else {
+        Decoded->Target = (VMIP) (UINTN) Immed64;
+      }
+    }
+
+    Decoded->Function = VmThreadedCall;
+    return TRUE;
+
+  case OPCODE_CMPEQ:
+  case OPCODE_CMPLTE:
+  case OPCODE_CMPGTE:
+  case OPCODE_CMPULTE:
+  case OPCODE_CMPUGTE:
+    if (OPERAND2_INDIRECT (Operands)) {
+      return FALSE;
+    }
+
+    Decoded->Size = 2;
+    if ((Opcode & OPCODE_M_IMMDATA) != 0) {
+      Decoded->Data = (UINT64) (INT64) VmReadImmed16 (VmPtr, Offset + 2);
+      Decoded->Size = 4;
+    }
+
+    Decoded->Compare  = OpcMasked;
+    Decoded->Is64Bit  = (BOOLEAN) ((Opcode & OPCODE_M_64BIT) != 0);
+    Decoded->Function = VmThreadedCompare;
+    return TRUE;
+
+  case OPCODE_CMPIEQ:
+  case OPCODE_CMPILTE:
+  case OPCODE_CMPIGTE:
+  case OPCODE_CMPIULTE:
+  case OPCODE_CMPIUGTE:
+    if (OPERAND1_INDIRECT (Operands) || ((Operands & OPERAND_M_CMPI_INDEX) != 0)) {
+      return FALSE;
+    }
+
+    if ((Opcode & OPCODE_M_CMPI32_DATA) != 0) {
+      Decoded->Data = (UINT64) (INT64) VmReadImmed32 (VmPtr, Offset + 2);
+      Decoded->Size = 6;
+    } else {
+      Decoded->Data = (UINT64) (INT64) VmReadImmed16 (VmPtr, Offset + 2);
+      Decoded->Size = 4;
+    }
+
+    //
+    // Map onto the matching CMP. The only difference is that the 64-bit
+    // unsigned CMPI compares against the zero-extended 32-bit immediate.
+    //
+    Decoded->Compare  = (UINT8) (OpcMasked - OPCODE_CMPIEQ + OPCODE_CMPEQ);
+    Decoded->Is64Bit  = (BOOLEAN) ((Opcode & OPCODE_M_CMPI64) != 0);
+    if (Decoded->Is64Bit &&
+        ((Decoded->Compare == OPCODE_CMPULTE) || (Decoded->Compare == OPCODE_CMPUGTE))) {
+      Decoded->Data = (UINT64) (UINT32) Decoded->Data;
+    }
+
+    Decoded->Operand2 = VM_DECODED_NO_REGISTER;
+    Decoded->Function = VmThreadedCompare;
+    return TRUE;
+
+  case OPCODE_MOVI:
+  case OPCODE_MOVIN:
+  case OPCODE_MOVREL:
+    //
+    // Only the register forms, which can not have an operand1 index.
+    //
+    if (OPERAND1_INDIRECT (Operands) || ((Operands & MOVI_M_IMMDATA) != 0)) {
+      return FALSE;
+    }
+
+    if ((Opcode & MOVI_M_DATAWIDTH) == MOVI_DATAWIDTH16) {
+      Immed64 = (OpcMasked == OPCODE_MOVIN) ? VmReadIndex16 (VmPtr, Offset + 2) : VmReadImmed16 (VmPtr, Offset + 2);
+      Decoded->Size = 4;
+    } else if ((Opcode & MOVI_M_DATAWIDTH) == MOVI_DATAWIDTH32) {
+      Immed64 = (OpcMasked == OPCODE_MOVIN) ? VmReadIndex32 (VmPtr, Offset + 2) : VmReadImmed32 (VmPtr, Offset + 2);
+      Decoded->Size = 6;
+    } else if ((Opcode & MOVI_M_DATAWIDTH) == MOVI_DATAWIDTH64) {
+      Immed64 = (OpcMasked == OPCODE_MOVIN) ? VmReadIndex64 (VmPtr, Offset + 2) : VmReadImmed64 (VmPtr, Offset + 2);
+      Decoded->Size = 10;
+    } else {
+      return FALSE;
+    }
+
+    if (OpcMasked == OPCODE_MOVI) {
+      if ((Operands & MOVI_M_MOVEWIDTH) == MOVI_MOVEWIDTH8) {
+        Decoded->Mask = 0x000000FF;
+      } else if ((Operands & MOVI_M_MOVEWIDTH) == MOVI_MOVEWIDTH16) {
+        Decoded->Mask = 0x0000FFFF;
+      } else if ((Operands & MOVI_M_MOVEWIDTH) == MOVI_MOVEWIDTH32) {
+        Decoded->Mask = 0x00000000FFFFFFFF;
+      }
+
+      Decoded->Data = (UINT64) Immed64 & Decoded->Mask;
+    } else if (OpcMasked == OPCODE_MOVREL) {
+      Decoded->Data = (UINT64) ((INT64) ((UINT64) (UINTN) Ip) + Immed64 + Decoded->Size);
+    } else {
+      Decoded->Data = (UINT64) Immed64;
+    }
+
+    Decoded->Function = VmThreadedMoveImmediate;
+    return TRUE;
+
+  default:
+    break;
+  }
+
+  if ((mVmOpcodeTable[OpcMasked].ExecuteFunction == ExecuteSignedDataManip) ||
+      (mVmOpcodeTable[OpcMasked].ExecuteFunction == ExecuteUnsignedDataManip)) {
+    if (OPERAND1_INDIRECT (Operands) || OPERAND2_INDIRECT (Operands)) {
+      return FALSE;
+    }
+
+    Decoded->Size = 2;
+    if ((Opcode & DATAMANIP_M_IMMDATA) != 0) {
+      Decoded->Data = (UINT64) (INT64) VmReadImmed16 (VmPtr, Offset + 2);
+      Decoded->Size = 4;
+    }
+
+    Decoded->Is64Bit        = (BOOLEAN) ((Opcode & DATAMANIP_M_64) != 0);
+    Decoded->IsSigned       = (BOOLEAN) (mVmOpcodeTable[OpcMasked].ExecuteFunction == ExecuteSignedDataManip);
+    Decoded->DataManipIndex = (UINT8) (OpcMasked - OPCODE_NOT);
+    Decoded->Function       = VmThreadedDataManip;
+    return TRUE;
+  }
+
+  if (mVmOpcodeTable[OpcMasked].ExecuteFunction == ExecuteMOVxx) {
+    //
+    // Operand1 direct with an index is invalid.
+    //
+    if (!OPERAND1_INDIRECT (Operands) && ((Opcode & OPCODE_M_IMMED_OP1) != 0)) {
+      return FALSE;
+    }
+
+    Decoded->Size = 2;
+    if ((OpcMasked <= OPCODE_MOVQW) || (OpcMasked == OPCODE_MOVNW)) {
+      if ((Opcode & OPCODE_M_IMMED_OP1) != 0) {
+        Decoded->Index = (UINT64) (INT64) VmReadIndex16 (VmPtr, Offset + 2);
+        Decoded->Size += sizeof (UINT16);
+      }
+
+      if ((Opcode & OPCODE_M_IMMED_OP2) != 0) {
+        Decoded->Data = (UINT64) (INT64) VmReadIndex16 (VmPtr, Offset + Decoded->Size);
+        Decoded->Size += sizeof (UINT16);
+      }
+    } else if ((OpcMasked <= OPCODE_MOVQD) || (OpcMasked == OPCODE_MOVND)) {
+      if ((Opcode & OPCODE_M_IMMED_OP1) != 0) {
+        Decoded->Index = (UINT64) (INT64) VmReadIndex32 (VmPtr, Offset + 2);
+        Decoded->Size += sizeof (UINT32);
+      }
+
+      if ((Opcode & OPCODE_M_IMMED_OP2) != 0) {
+        Decoded->Data = (UINT64) (INT64) VmReadIndex32 (VmPtr, Offset + Decoded->Size);
+        Decoded->Size += sizeof (UINT32);
+      }
+    } else {
+      if ((Opcode & OPCODE_M_IMMED_OP1) != 0) {
+        Decoded->Index = (UINT64) VmReadIndex64 (VmPtr, Offset + 2);
+        Decoded->Size += sizeof (UINT64);
+      }
+
+      if ((Opcode & OPCODE_M_IMMED_OP2) != 0) {
+        Decoded->Data = (UINT64) VmReadIndex64 (VmPtr, Offset + Decoded->Size);
+        Decoded->Size += sizeof (UINT64);
+      }
+    }
+
+    Decoded->MoveSize = sizeof (UINT64);
+    if ((OpcMasked == OPCODE_MOVBW) || (OpcMasked == OPCODE_MOVBD)) {
+      Decoded->MoveSize = sizeof (UINT8);
+      Decoded->Mask     = 0xFF;
+    } else if ((OpcMasked == OPCODE_MOVWW) || (OpcMasked == OPCODE_MOVWD)) {
+      Decoded->MoveSize = sizeof (UINT16);
+      Decoded->Mask     = 0xFFFF;
+    } else if ((OpcMasked == OPCODE_MOVDW) || (OpcMasked == OPCODE_MOVDD)) {
+      Decoded->MoveSize = sizeof (UINT32);
+      Decoded->Mask     = 0xFFFFFFFF;
+    } else if ((OpcMasked == OPCODE_MOVNW) || (OpcMasked == OPCODE_MOVND)) {
+      Decoded->MoveSize = sizeof (UINTN);
+      Decoded->Mask     = (UINT64)~0 >> (64 - 8 * sizeof (UINTN));
+    }
+
+    if (OPERAND1_INDIRECT (Operands) || OPERAND2_INDIRECT (Operands)) {
+      Decoded->Function = VmThreadedMoveMemory;
+    } else {
+      Decoded->Function = VmThreadedMove;
+    }
+
+    return TRUE;
+  }
+
+  return FALSE;
+}
+
+
+/**
+  Decode the instruction at VmPtr->Ip, fusing it with the next instruction
+  for the common CMP + conditional jump and MOVI + CALL sequences.
+
+  @param  VmPtr             A pointer to a VM context.
+  @param  Decoded           Receives the decoded instruction. Function is NULL
+                            if the instruction was not decoded.
+
+**/
+VOID
+VmDecodeInstruction (
+  IN  VM_CONTEXT              *VmPtr,
+  OUT VM_DECODED_INSTRUCTION  *Decoded
+  )
+{
+  VM_DECODED_INSTRUCTION  Next;
+
+  ZeroMem (Decoded, sizeof (VM_DECODED_INSTRUCTION));
+  Decoded->Ip = VmPtr->Ip;
+  if (!VmDecodeThreadedInstruction (VmPtr, 0, Decoded)) {
+    Decoded->Function = NULL;
+    return;
+  }
+
+  Decoded->TotalSize = Decoded->Size;
+  if (Decoded->Function == VmThreadedCompare) {
+    ZeroMem (&Next, sizeof (VM_DECODED_INSTRUCTION));
+    if (VmDecodeThreadedInstruction (VmPtr, Decoded->Size, &Next) &&
+        (Next.Function == VmThreadedJump) &&
+        ((Next.Condition & CONDITION_M_CONDITIONAL) != 0)) {
+      Decoded->Condition  = Next.Condition;
+      Decoded->Target     = Next.Target;
+      Decoded->TotalSize  = (UINT8) (Decoded->Size + Next.Size);
+      Decoded->Function   = VmThreadedCompareJump;
+    }
+  } else if (Decoded->Function == VmThreadedMoveImmediate) {
+    //
+    // Native calls may re-enter the interpreter, which must not happen
+    // while a decoded instruction is in use.
+    //
+    if (((*(VmPtr->Ip + Decoded->Size) & OPCODE_M_OPCODE) == OPCODE_CALL) &&
+        ((*(VmPtr->Ip + Decoded->Size + 1) & OPERAND_M_NATIVE_CALL) == 0)) {
+      Decoded->Function = VmThreadedMoveImmediateCall;
+    }
+  }
+}
+
+
+/**
+  Look up the decoded form of the instruction at VmPtr->Ip, decoding it into
+  the cache on a miss. The caller must own mVmDecodeCacheBusy.
+
+  @param  VmPtr             A pointer to a VM context.
+
+  @return The cache entry for the instruction. Its Function is NULL if the
+          instruction must be executed through mVmOpcodeTable.
+
+**/
+VM_DECODED_INSTRUCTION *
+VmLookupDecodedInstruction (
+  IN VM_CONTEXT  *VmPtr
+  )
+{
+  VM_DECODED_INSTRUCTION  *Decoded;
+
+  Decoded = &mVmDecodeCache[((UINTN) VmPtr->Ip >> 1) & (VM_DECODE_CACHE_SIZE - 1)];
+  if ((Decoded->Ip != VmPtr->Ip) || (Decoded->Generation != mVmDecodeCacheGeneration)) {
+    VmDecodeInstruction (VmPtr, Decoded);
+    Decoded->Generation = mVmDecodeCacheGeneration;
+  }
+
+  return Decoded;
+}
+
+
 /**
   Given a pointer to a new VM context, execute one or more instructions. This
   function is only used for test purposes via the EBC VM test protocol.
@@ -1422,6 +2249,9 @@ EbcExecute (
   UINT8                             StackCorrupted;
   EFI_STATUS                        Status;
   EFI_EBC_SIMPLE_DEBUGGER_PROTOCOL  *EbcSimpleDebugger;
+  BOOLEAN                           UseDecodeCache;
+  BOOLEAN                           Executed;
+  VM_DECODED_INSTRUCTION            *Decoded;
 
   mVmPtr            = VmPtr;
   EbcSimpleDebugger = NULL;
@@ -1451,6 +2281,14 @@ EbcExecute (
     }
   DEBUG_CODE_END ();
 
+  //
+  // Pre-decoded instructions and compiled blocks skip the per-instruction
+  // debugger hooks, so only use them when nothing is watching the VM.
+  //
+  UseDecodeCache = (BOOLEAN) ((mVmDecodeCache != NULL) &&
+                              (EbcSimpleDebugger == NULL) &&
+                              !EbcDebuggerHookIsEnabled ());
+
   //
   // Save the start IP for debug. For example, if we take an exception we
   // can print out the location of the exception relative to the entry point,
@@ -1473,30 +2311,56 @@ EbcExecute (
       }
     DEBUG_CODE_END ();
 
-    //
-    // Use the opcode bits to index into the opcode dispatch table. If the
-    // function pointer is null then generate an exception.
-    //
-    ExecFunc = (UINTN) mVmOpcodeTable[(*VmPtr->Ip & OPCODE_M_OPCODE)].ExecuteFunction;
-    if (ExecFunc == (UINTN) NULL) {
-      EbcDebugSignalException (EXCEPT_EBC_INVALID_OPCODE, EXCEPTION_FLAG_FATAL, VmPtr);
-      Status = EFI_UNSUPPORTED;
-      goto Done;
+    Executed = FALSE;
+    if (UseDecodeCache && !mVmDecodeCacheBusy && !VMFLAG_ISSET (VmPtr, VMFLAGS_STEP)) {
+      mVmDecodeCacheBusy = TRUE;
+
+      //
+      // Hot code may have been compiled to a native block, which runs until
+      // it reaches an instruction it does not handle.
+      //
+      Executed = EbcJitExecute (VmPtr);
+      if (!Executed) {
+        Decoded = VmLookupDecodedInstruction (VmPtr);
+        if (Decoded->Function != NULL) {
+          //
+          // Pre-decoded instruction, or a fused pair of instructions. The
+          // handlers fence around the memory accesses they do themselves.
+          //
+          Decoded->Function (VmPtr, Decoded);
+          Executed = TRUE;
+        }
+      }
+
+      mVmDecodeCacheBusy = FALSE;
     }
 
-    EbcDebuggerHookExecuteStart (VmPtr);
+    if (!Executed) {
+      //
+      // Use the opcode bits to index into the opcode dispatch table. If the
+      // function pointer is null then generate an exception.
+      //
+      ExecFunc = (UINTN) mVmOpcodeTable[(*VmPtr->Ip & OPCODE_M_OPCODE)].ExecuteFunction;
+      if (ExecFunc == (UINTN) NULL) {
+        EbcDebugSignalException (EXCEPT_EBC_INVALID_OPCODE, EXCEPTION_FLAG_FATAL, VmPtr);
+        Status = EFI_UNSUPPORTED;
+        goto Done;
+      }
 
-    //
-    // The EBC VM is a strongly ordered processor, so perform a fence operation before
-    // and after each instruction is executed.
-    //
-    MemoryFence ();
+      EbcDebuggerHookExecuteStart (VmPtr);
 
-    mVmOpcodeTable[(*VmPtr->Ip & OPCODE_M_OPCODE)].ExecuteFunction (VmPtr);
+      //
+      // The EBC VM is a strongly ordered processor, so perform a fence operation before
+      // and after each instruction is executed.
+      //
+      MemoryFence ();
 
-    MemoryFence ();
+      mVmOpcodeTable[(*VmPtr->Ip & OPCODE_M_OPCODE)].ExecuteFunction (VmPtr);
 
-    EbcDebuggerHookExecuteEnd (VmPtr);
+      MemoryFence ();
+
+      EbcDebuggerHookExecuteEnd (VmPtr);
+    }
 
     //
     // If the step flag is set, signal an exception and continue. We don't
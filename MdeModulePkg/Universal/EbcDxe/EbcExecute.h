@@ -22,6 +22,57 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 //
 #define EBCMSG(s) gST->ConOut->OutputString (gST->ConOut, s)
 
+//
+// Operand2 value used by pre-decoded CMPI, which has no second register.
+//
+#define VM_DECODED_NO_REGISTER    0xFF
+
+typedef struct _VM_DECODED_INSTRUCTION VM_DECODED_INSTRUCTION;
+
+/**
+  Execute an instruction (or a fused pair of instructions) that has already
+  been decoded by VmDecodeInstruction().
+
+  @param  VmPtr             A pointer to a VM context.
+  @param  Decoded           The decoded form of the instruction at VmPtr->Ip.
+
+**/
+typedef
+VOID
+(*VM_THREADED_FUNCTION) (
+  IN VM_CONTEXT                    *VmPtr,
+  IN CONST VM_DECODED_INSTRUCTION  *Decoded
+  );
+
+//
+// Pre-decoded form of an instruction. Only instructions whose operands are
+// registers, immediate data or register indirect memory are decoded. Their
+// behavior depends on nothing but the instruction bytes, the VM registers
+// and the memory they access. Function is NULL for everything else, which
+// then goes through mVmOpcodeTable.
+//
+struct _VM_DECODED_INSTRUCTION {
+  VMIP                  Ip;             // address of the instruction
+  UINTN                 Generation;     // mVmDecodeCacheGeneration at decode
+  VM_THREADED_FUNCTION  Function;       // handler, or NULL if not decoded
+  UINT64                Data;           // immediate data or operand2 index
+  UINT64                Index;          // operand1 index of MOVxx
+  UINT64                Mask;           // mask for the register write back
+  VMIP                  Target;         // absolute target of JMP or CALL
+  UINT8                 Opcode;         // OPCODE_xxx of the (first) instruction
+  UINT8                 Operands;       // operands byte of the (first) instruction
+  UINT8                 Size;           // size of the (first) instruction
+  UINT8                 TotalSize;      // size of a fused pair
+  UINT8                 Operand1;       // R1
+  UINT8                 Operand2;       // R2 or VM_DECODED_NO_REGISTER
+  UINT8                 Compare;        // OPCODE_CMPxx for CMP and CMPI
+  UINT8                 Condition;      // CONDITION_M_xxx bits of the jump
+  UINT8                 MoveSize;       // bytes accessed in memory by MOVxx
+  BOOLEAN               Is64Bit;
+  BOOLEAN               IsSigned;
+  UINT8                 DataManipIndex; // index into mDataManipDispatchTable
+};
+
 
 /**
   Execute an EBC image from an entry point or from a published protocol.
@@ -37,6 +88,61 @@ EbcExecute (
   IN VM_CONTEXT *VmPtr
   );
 
+/**
+  Allocate the decoded instruction cache used by EbcExecute().
+
+  If the cache can not be allocated, every instruction is dispatched
+  through the opcode table, which is slower but otherwise equivalent.
+
+  @retval EFI_SUCCESS           The cache was allocated.
+  @retval EFI_OUT_OF_RESOURCES  Memory could not be allocated for the cache.
+
+**/
+EFI_STATUS
+InitEbcDecodeCache (
+  VOID
+  );
+
+/**
+  Free the decoded instruction cache used by EbcExecute().
+
+**/
+VOID
+FreeEbcDecodeCache (
+  VOID
+  );
+
+/**
+  Invalidate all decoded instructions. This must be called whenever EBC code
+  that may have been executed is modified or unloaded.
+
+**/
+VOID
+FlushEbcDecodeCache (
+  VOID
+  );
+
+/**
+  Decode a single instruction into its threaded form if its operands are
+  registers, immediate data or register indirect memory. Encodings that are
+  invalid or that would raise an exception are left to the opcode table
+  handlers.
+
+  @param  VmPtr             A pointer to a VM context.
+  @param  Offset            Offset of the instruction from VmPtr->Ip.
+  @param  Decoded           Receives the decoded instruction.
+
+  @retval TRUE              The instruction was decoded.
+  @retval FALSE             The instruction must be executed through
+                            mVmOpcodeTable.
+
+**/
+BOOLEAN
+VmDecodeThreadedInstruction (
+  IN  VM_CONTEXT              *VmPtr,
+  IN  UINT32                  Offset,
+  OUT VM_DECODED_INSTRUCTION  *Decoded
+  );
 
 
 /**
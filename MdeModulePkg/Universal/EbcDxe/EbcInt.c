@@ -290,8 +290,9 @@ EbcDebugRegisterExceptionCallback (
   );
 
 /**
-  This EBC debugger protocol service is called by the debug agent.  Required
-  for DebugSupport compliance but is only stubbed out for EBC.
+  This EBC debugger protocol service is called by the debug agent after it
+  modified EBC code, for example to insert a breakpoint. Drops any
+  instructions the interpreter has already decoded or compiled.
 
   @param  This                  A pointer to the EFI_DEBUG_SUPPORT_PROTOCOL
                                 instance.
@@ -561,6 +562,14 @@ InitializeEbcDriver (
     goto ErrorExit;
   }
 
+  //
+  // Not fatal, without the cache EbcExecute() uses the opcode table only.
+  // The JIT compiler runs on top of the cache.
+  //
+  if (!EFI_ERROR (InitEbcDecodeCache ())) {
+    InitEbcJit ();
+  }
+
   //
   // Allocate memory for our debug protocol. Then fill in the blanks.
   //
@@ -611,6 +620,8 @@ InitializeEbcDriver (
 
 ErrorExit:
   FreeEBCStack();
+  FreeEbcDecodeCache ();
+  FreeEbcJit ();
   HandleBuffer  = NULL;
   Status = gBS->LocateHandleBuffer (
                   ByProtocol,
@@ -803,8 +814,9 @@ EbcDebugRegisterExceptionCallback (
 
 
 /**
-  This EBC debugger protocol service is called by the debug agent.  Required
-  for DebugSupport compliance but is only stubbed out for EBC.
+  This EBC debugger protocol service is called by the debug agent after it
+  modified EBC code, for example to insert a breakpoint. Drops any
+  instructions the interpreter has already decoded or compiled.
 
   @param  This                  A pointer to the EFI_DEBUG_SUPPORT_PROTOCOL
                                 instance.
@@ -827,6 +839,8 @@ EbcDebugInvalidateInstructionCache (
   IN UINT64                              Length
   )
 {
+  FlushEbcDecodeCache ();
+  FlushEbcJit ();
   return EFI_SUCCESS;
 }
 
@@ -1205,6 +1219,12 @@ EbcUnloadImage (
   //
   FreePool (ImageList);
 
+  //
+  // The image memory may be reused for other EBC code.
+  //
+  FlushEbcDecodeCache ();
+  FlushEbcJit ();
+
   EbcDebuggerHookEbcUnloadImage (ImageHandle);
 
   return EFI_SUCCESS;
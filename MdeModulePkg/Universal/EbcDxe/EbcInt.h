@@ -257,4 +257,55 @@ EbcAllocatePoolForThunk (
   IN UINTN  AllocationSize
   );
 
+/**
+  Allocate the tables and the code buffer of the JIT compiler, if it is
+  enabled with PcdEbcJitEnable.
+
+  @retval EFI_SUCCESS           The JIT compiler is ready.
+  @retval EFI_UNSUPPORTED       The JIT compiler is disabled, or there is
+                                none for this processor.
+  @retval EFI_OUT_OF_RESOURCES  Memory could not be allocated.
+
+**/
+EFI_STATUS
+InitEbcJit (
+  VOID
+  );
+
+/**
+  Free the tables and the code buffer of the JIT compiler. EBC code runs in
+  the interpreter only from then on.
+
+**/
+VOID
+FreeEbcJit (
+  VOID
+  );
+
+/**
+  Drop all compiled blocks. This must be called whenever EBC code that may
+  have been compiled is modified or unloaded.
+
+**/
+VOID
+FlushEbcJit (
+  VOID
+  );
+
+/**
+  Run the compiled block that starts at VmPtr->Ip, compiling it first if the
+  address has become hot. The caller must own mVmDecodeCacheBusy.
+
+  @param  VmPtr             A pointer to a VM context.
+
+  @retval TRUE              A block ran and VmPtr->Ip is the next instruction
+                            for the interpreter.
+  @retval FALSE             No block was run.
+
+**/
+BOOLEAN
+EbcJitExecute (
+  IN VM_CONTEXT  *VmPtr
+  );
+
 #endif // #ifndef _EBC_INT_H_
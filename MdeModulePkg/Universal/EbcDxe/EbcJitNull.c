@@ -0,0 +1,63 @@
+/** @file
+  Stubs for processors without an EBC JIT compiler, and for the EBC
+  debugger, which must see every instruction.
+
+Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "EbcInt.h"
+
+/**
+  Allocate the tables and the code buffer of the JIT compiler, if it is
+  enabled with PcdEbcJitEnable.
+
+  @retval EFI_UNSUPPORTED       There is no JIT compiler.
+
+**/
+EFI_STATUS
+InitEbcJit (
+  VOID
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+/**
+  Free the tables and the code buffer of the JIT compiler.
+
+**/
+VOID
+FreeEbcJit (
+  VOID
+  )
+{
+}
+
+/**
+  Drop all compiled blocks.
+
+**/
+VOID
+FlushEbcJit (
+  VOID
+  )
+{
+}
+
+/**
+  Run the compiled block that starts at VmPtr->Ip.
+
+  @param  VmPtr             A pointer to a VM context.
+
+  @retval FALSE             No block was run.
+
+**/
+BOOLEAN
+EbcJitExecute (
+  IN VM_CONTEXT  *VmPtr
+  )
+{
+  return FALSE;
+}
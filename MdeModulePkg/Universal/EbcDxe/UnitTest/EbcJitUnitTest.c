@@ -0,0 +1,1084 @@
+/** @file
+  Host based differential test and benchmark of the EBC x64 JIT compiler.
+  Random EBC programs are run by single-stepping through
+  EbcExecuteInstructions(), which always uses the opcode table, and then
+  through EbcExecute() with the JIT compiler enabled. The registers, the
+  condition code and the memory the programs write must match.
+
+  The code buffer is allocated with mmap() and protected with mprotect()
+  through a mock CPU architectural protocol, so a block that runs while
+  the buffer is writable, or a write to the buffer while it is executable,
+  faults just like it would with the DXE memory protection policy.
+
+  Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <time.h>
+#include <cmocka.h>
+
+#if defined (__GNUC__)
+#include <sys/mman.h>
+#endif
+
+#include "../EbcDebuggerHook.h"
+#include "EbcTestAssembler.h"
+
+#include <Protocol/Cpu.h>
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME        "EBC JIT Compiler Unit Tests"
+#define UNIT_TEST_APP_VERSION     "1.0"
+
+#define TEST_CODE_SIZE            SIZE_16KB
+#define TEST_STACK_SIZE           SIZE_64KB
+#define TEST_DATA_SIZE            256
+#define TEST_RANDOM_PROGRAMS      500
+#define TEST_RANDOM_LENGTH        48
+#define TEST_RANDOM_ITERATIONS    100
+#define TEST_SUM_ITERATIONS       1000
+#define TEST_CHECKSUM_COUNT       512
+#define TEST_CHECKSUM_ITERATIONS  2000
+#define TEST_STACK_FAULT_LOOPS    (TEST_STACK_SIZE / SIZE_1KB * 2)
+
+typedef enum {
+  TestModeStep,
+  TestModeThreaded,
+  TestModeJit
+} TEST_MODE;
+
+VM_CONTEXT             *mVmPtr = NULL;
+EFI_BOOT_SERVICES      *gBS;
+EFI_BOOT_SERVICES      mTestBootServices;
+EFI_CPU_ARCH_PROTOCOL  mTestCpu;
+BOOLEAN                mTestCpuInstalled;
+UINT64                 mTestCodeAttributes;
+UINTN                  mExceptionCount;
+UINT8                  *mTestCode;
+UINT8                  *mTestStack;
+UINT8                  *mTestData;
+UINT8                  *mTestDataInitial;
+UINT64                 *mTestChecksumSource;
+UINT64                 *mTestChecksumDestination;
+UINT64                 mRandomState;
+
+extern UINTN           mEbcJitCodeUsed;
+
+/**
+  Allocate pages that can be made executable.
+
+  @param  Type          The type of allocation to perform.
+  @param  MemoryType    The type of memory to allocate.
+  @param  Pages         The number of contiguous 4 KB pages to allocate.
+  @param  Memory        Returns the base address of the pages.
+
+  @retval EFI_SUCCESS           The pages were allocated.
+  @retval EFI_OUT_OF_RESOURCES  The pages could not be allocated.
+
+**/
+EFI_STATUS
+EFIAPI
+TestAllocatePages (
+  IN     EFI_ALLOCATE_TYPE     Type,
+  IN     EFI_MEMORY_TYPE       MemoryType,
+  IN     UINTN                 Pages,
+  IN OUT EFI_PHYSICAL_ADDRESS  *Memory
+  )
+{
+#if defined (__GNUC__)
+  VOID  *Buffer;
+
+  Buffer = mmap (NULL, EFI_PAGES_TO_SIZE (Pages), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (Buffer == MAP_FAILED) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  *Memory = (EFI_PHYSICAL_ADDRESS) (UINTN) Buffer;
+  return EFI_SUCCESS;
+#else
+  return EFI_OUT_OF_RESOURCES;
+#endif
+}
+
+/**
+  Free pages allocated with TestAllocatePages().
+
+  @param  Memory        The base address of the pages.
+  @param  Pages         The number of contiguous 4 KB pages to free.
+
+  @retval EFI_SUCCESS   The pages were freed.
+
+**/
+EFI_STATUS
+EFIAPI
+TestFreePages (
+  IN EFI_PHYSICAL_ADDRESS  Memory,
+  IN UINTN                 Pages
+  )
+{
+#if defined (__GNUC__)
+  munmap ((VOID *) (UINTN) Memory, EFI_PAGES_TO_SIZE (Pages));
+#endif
+  return EFI_SUCCESS;
+}
+
+/**
+  Apply the EFI_MEMORY_XP or EFI_MEMORY_RO attribute the JIT compiler uses
+  to pages allocated with TestAllocatePages().
+
+  @param  This             The EFI_CPU_ARCH_PROTOCOL instance.
+  @param  BaseAddress      The physical address that is the start address of
+                           a memory region.
+  @param  Length           The size in bytes of the memory region.
+  @param  Attributes       The bit mask of attributes to set for the memory
+                           region.
+
+  @retval EFI_SUCCESS      The attributes were set.
+  @retval EFI_UNSUPPORTED  The attributes are not the ones the JIT uses.
+
+**/
+EFI_STATUS
+EFIAPI
+TestSetMemoryAttributes (
+  IN EFI_CPU_ARCH_PROTOCOL  *This,
+  IN EFI_PHYSICAL_ADDRESS   BaseAddress,
+  IN UINT64                 Length,
+  IN UINT64                 Attributes
+  )
+{
+#if defined (__GNUC__)
+  INT32  Protection;
+
+  if (Attributes == EFI_MEMORY_XP) {
+    Protection = PROT_READ | PROT_WRITE;
+  } else if (Attributes == EFI_MEMORY_RO) {
+    Protection = PROT_READ | PROT_EXEC;
+  } else {
+    return EFI_UNSUPPORTED;
+  }
+
+  if (mprotect ((VOID *) (UINTN) BaseAddress, (UINTN) Length, Protection) != 0) {
+    return EFI_UNSUPPORTED;
+  }
+
+  mTestCodeAttributes = Attributes;
+  return EFI_SUCCESS;
+#else
+  return EFI_UNSUPPORTED;
+#endif
+}
+
+/**
+  Return the mock CPU architectural protocol once it is installed. The EBC
+  simple debugger is never found.
+
+  @param  Protocol      Provides the protocol to search for.
+  @param  Registration  Optional registration key.
+  @param  Interface     On return, a pointer to the first interface.
+
+  @retval EFI_SUCCESS   The CPU architectural protocol was found.
+  @retval EFI_NOT_FOUND The protocol is not installed.
+
+**/
+EFI_STATUS
+EFIAPI
+TestLocateProtocol (
+  IN  EFI_GUID  *Protocol,
+  IN  VOID      *Registration OPTIONAL,
+  OUT VOID      **Interface
+  )
+{
+  if (mTestCpuInstalled && CompareGuid (Protocol, &gEfiCpuArchProtocolGuid)) {
+    *Interface = &mTestCpu;
+    return EFI_SUCCESS;
+  }
+
+  return EFI_NOT_FOUND;
+}
+
+/**
+  Count exceptions signaled by the interpreter. None are expected.
+
+  @param  ExceptionType          Specifies the processor exception detected.
+  @param  ExceptionFlags         Specifies the exception context.
+  @param  VmPtr                  Pointer to a VM context.
+
+  @retval EFI_SUCCESS            This function completed successfully.
+
+**/
+EFI_STATUS
+EbcDebugSignalException (
+  IN EFI_EXCEPTION_TYPE                   ExceptionType,
+  IN EXCEPTION_FLAGS                      ExceptionFlags,
+  IN VM_CONTEXT                           *VmPtr
+  )
+{
+  DEBUG ((DEBUG_ERROR, "EBC exception %d at 0x%p\n", ExceptionType, VmPtr->Ip));
+  mExceptionCount++;
+  VmPtr->StopFlags |= STOPFLAG_APP_DONE;
+  return EFI_SUCCESS;
+}
+
+/**
+  The programs don't use BREAK 5.
+
+  @param  ImageHandle            The image handle.
+  @param  EbcEntryPoint          Address of the EBC code.
+  @param  Thunk                  Returned thunk.
+  @param  Flags                  Thunk flags.
+
+  @retval EFI_UNSUPPORTED        Thunks are not supported on the host.
+
+**/
+EFI_STATUS
+EbcCreateThunks (
+  IN EFI_HANDLE           ImageHandle,
+  IN VOID                 *EbcEntryPoint,
+  OUT VOID                **Thunk,
+  IN  UINT32              Flags
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+/**
+  The programs don't call native code.
+
+  @param  VmPtr            Pointer to a VM context.
+  @param  FuncAddr         Callee's address
+  @param  NewStackPointer  New stack pointer after the call
+  @param  FramePtr         New frame pointer after the call
+  @param  Size             The size of call instruction
+
+**/
+VOID
+EbcLLCALLEX (
+  IN VM_CONTEXT   *VmPtr,
+  IN UINTN        FuncAddr,
+  IN UINTN        NewStackPointer,
+  IN VOID         *FramePtr,
+  IN UINT8        Size
+  )
+{
+  EbcDebugSignalException (EXCEPT_EBC_UNDEFINED, EXCEPTION_FLAG_FATAL, VmPtr);
+}
+
+/**
+  Return the next pseudo random number (xorshift64).
+
+  @param  Limit   The upper bound, exclusive.
+
+  @return A number between 0 and Limit - 1.
+
+**/
+UINT32
+TestRandom (
+  IN UINT32  Limit
+  )
+{
+  mRandomState ^= LShiftU64 (mRandomState, 13);
+  mRandomState ^= RShiftU64 (mRandomState, 7);
+  mRandomState ^= LShiftU64 (mRandomState, 17);
+  return (UINT32) (RShiftU64 (mRandomState, 32) % Limit);
+}
+
+//
+// Register usage of the random programs. R0 is the stack pointer, R5 is
+// always 1, R6 counts the loop iterations and R7 points to mTestData. The
+// other registers hold random data.
+//
+#define TEST_REG_ONE      5
+#define TEST_REG_COUNT    6
+#define TEST_REG_DATA     7
+
+/**
+  Return a random register the programs may write.
+
+**/
+UINT8
+TestRandomDestination (
+  VOID
+  )
+{
+  return (UINT8) (1 + TestRandom (4));
+}
+
+/**
+  Return a random register the programs may read.
+
+**/
+UINT8
+TestRandomSource (
+  VOID
+  )
+{
+  UINT8  Reg;
+
+  Reg = (UINT8) (1 + TestRandom (6));
+  return (Reg == TEST_REG_COUNT) ? TEST_REG_DATA : Reg;
+}
+
+/**
+  Return a random offset into mTestData for a move of up to 8 bytes.
+
+**/
+INT16
+TestRandomDataIndex (
+  VOID
+  )
+{
+  return (INT16) TestRandom (TEST_DATA_SIZE - sizeof (UINT64) + 1);
+}
+
+/**
+  Emit a random data manipulation instruction. Divisors and shift counts are
+  based on R5, so they are never zero or out of range.
+
+  @param  Asm     Assembler state.
+
+**/
+VOID
+EmitRandomDataManip (
+  IN EBC_ASM  *Asm
+  )
+{
+  UINT8    Opcode;
+  BOOLEAN  Is64Bit;
+
+  Opcode  = (UINT8) (OPCODE_NOT + TestRandom (OPCODE_EXTNDD - OPCODE_NOT + 1));
+  Is64Bit = (BOOLEAN) (TestRandom (2) != 0);
+
+  switch (Opcode) {
+  case OPCODE_DIV:
+  case OPCODE_DIVU:
+  case OPCODE_MOD:
+  case OPCODE_MODU:
+    EmitDataManip (Asm, Opcode, Is64Bit, TestRandomDestination (), TEST_REG_ONE, (INT16) TestRandom (1000));
+    break;
+
+  case OPCODE_SHL:
+  case OPCODE_SHR:
+  case OPCODE_ASHR:
+    EmitDataManip (Asm, Opcode, Is64Bit, TestRandomDestination (), TEST_REG_ONE, (INT16) TestRandom (Is64Bit ? 63 : 31));
+    break;
+
+  default:
+    EmitDataManip (
+      Asm,
+      Opcode,
+      Is64Bit,
+      TestRandomDestination (),
+      TestRandomSource (),
+      (INT16) ((TestRandom (2) != 0) ? (INT16) TestRandom (MAX_UINT16 + 1) : 0)
+      );
+    break;
+  }
+}
+
+/**
+  Emit a random instruction that is not a jump.
+
+  @param  Asm     Assembler state.
+
+**/
+VOID
+EmitRandomStraightLine (
+  IN EBC_ASM  *Asm
+  )
+{
+  UINT8  Opcode;
+
+  Opcode = (UINT8) (OPCODE_MOVBW + TestRandom (4));
+
+  switch (TestRandom (7)) {
+  case 0:
+    if (TestRandom (2) != 0) {
+      EmitMoviqq (Asm, TestRandomDestination (), LShiftU64 (TestRandom (MAX_UINT32), 32) | TestRandom (MAX_UINT32));
+    } else {
+      EmitMoviqw (Asm, TestRandomDestination (), (INT16) TestRandom (MAX_UINT16 + 1));
+    }
+    break;
+
+  case 1:
+  case 2:
+    EmitRandomDataManip (Asm);
+    break;
+
+  case 3:
+    EmitMovIndexed (Asm, Opcode, TestRandomDestination (), FALSE, 0, TEST_REG_DATA, TRUE, TestRandomDataIndex ());
+    break;
+
+  case 4:
+    EmitMovIndexed (Asm, Opcode, TEST_REG_DATA, TRUE, TestRandomDataIndex (), TestRandomSource (), FALSE, 0);
+    break;
+
+  case 5:
+    EmitMovIndexed (Asm, Opcode, TEST_REG_DATA, TRUE, TestRandomDataIndex (), TEST_REG_DATA, TRUE, TestRandomDataIndex ());
+    break;
+
+  default:
+    EmitMovIndexed (Asm, Opcode, TestRandomDestination (), FALSE, 0, TestRandomSource (), FALSE, (INT16) TestRandom (0x1000));
+    break;
+  }
+}
+
+/**
+  Emit a random CMP or CMPI followed by a conditional JMP8 over one to three
+  random instructions.
+
+  @param  Asm     Assembler state.
+
+**/
+VOID
+EmitRandomBranch (
+  IN EBC_ASM  *Asm
+  )
+{
+  UINT8    Opcode;
+  BOOLEAN  Is64Bit;
+  UINT8    *Jmp;
+  UINT32   Count;
+
+  Is64Bit = (BOOLEAN) (TestRandom (2) != 0);
+  if (TestRandom (2) != 0) {
+    Opcode = (UINT8) (OPCODE_CMPEQ + TestRandom (OPCODE_CMPUGTE - OPCODE_CMPEQ + 1));
+    EmitCmp (Asm, Opcode, Is64Bit, TestRandomSource (), TestRandomSource ());
+  } else {
+    Opcode = (UINT8) (OPCODE_CMPIEQ + TestRandom (OPCODE_CMPIUGTE - OPCODE_CMPIEQ + 1));
+    EmitCmpi (Asm, Opcode, Is64Bit, TestRandomSource (), (INT16) TestRandom (MAX_UINT16 + 1));
+  }
+
+  Jmp = EmitJmp8 (Asm, (TestRandom (2) != 0) ? TEST_JMP_CC : TEST_JMP_CS, Asm->Ptr);
+  for (Count = TestRandom (3) + 1; Count > 0; Count--) {
+    EmitRandomStraightLine (Asm);
+  }
+
+  PatchJmp8 (Jmp, Asm->Ptr);
+}
+
+/**
+  Build a loop of random instructions that runs TEST_RANDOM_ITERATIONS
+  times, long enough for its blocks to be compiled.
+
+  @param  Asm     Assembler state.
+  @param  Seed    The seed of the program, also used for the initial
+                  registers and data.
+
+  @return The entry point of the program.
+
+**/
+VMIP
+BuildRandomProgram (
+  IN EBC_ASM  *Asm,
+  IN UINT64   Seed
+  )
+{
+  VMIP   Entry;
+  VMIP   Loop;
+  UINTN  Index;
+
+  mRandomState = Seed * 0x9E3779B97F4A7C15ULL + 1;
+
+  Entry = Asm->Ptr;
+  EmitMoviqw (Asm, TEST_REG_COUNT, TEST_RANDOM_ITERATIONS);
+
+  Loop = Asm->Ptr;
+  for (Index = 0; Index < TEST_RANDOM_LENGTH; Index++) {
+    if (TestRandom (5) == 0) {
+      EmitRandomBranch (Asm);
+    } else {
+      EmitRandomStraightLine (Asm);
+    }
+  }
+
+  EmitDataManip (Asm, OPCODE_SUB, TRUE, TEST_REG_COUNT, TEST_REG_ONE, 0);
+  EmitCmpi (Asm, OPCODE_CMPIEQ, TRUE, TEST_REG_COUNT, 0);
+  EmitJmp32 (Asm, TEST_JMP_CC, Loop);
+  EmitRet (Asm);
+
+  for (Index = 0; Index < TEST_DATA_SIZE; Index++) {
+    mTestDataInitial[Index] = (UINT8) TestRandom (MAX_UINT8 + 1);
+  }
+
+  return Entry;
+}
+
+/**
+  Add 7 to R2 in a loop of TEST_SUM_ITERATIONS iterations. The loop starts
+  with the third instruction, MOVIqw R3, 7.
+
+  @param  Asm     Assembler state.
+
+  @return The entry point of the kernel.
+
+**/
+VMIP
+BuildSumKernel (
+  IN EBC_ASM  *Asm
+  )
+{
+  VMIP  Entry;
+  VMIP  Loop;
+
+  Entry = Asm->Ptr;
+  EmitMoviqw (Asm, 1, TEST_SUM_ITERATIONS);
+  EmitMoviqw (Asm, 2, 0);
+
+  Loop = Asm->Ptr;
+  EmitMoviqw (Asm, 3, 7);
+  EmitDataManip (Asm, OPCODE_ADD, TRUE, 2, 3, 0);
+  EmitDataManip (Asm, OPCODE_SUB, TRUE, 1, TEST_REG_ONE, 0);
+  EmitCmpi (Asm, OPCODE_CMPIEQ, TRUE, 1, 0);
+  EmitJmp8 (Asm, TEST_JMP_CC, Loop);
+  EmitRet (Asm);
+  return Entry;
+}
+
+/**
+  Copy and checksum a buffer the way a network driver receive loop does.
+
+  @param  Asm     Assembler state.
+
+  @return The entry point of the kernel.
+
+**/
+VMIP
+BuildChecksumKernel (
+  IN EBC_ASM  *Asm
+  )
+{
+  VMIP  Entry;
+  VMIP  Outer;
+  VMIP  Inner;
+
+  Entry = Asm->Ptr;
+  EmitMoviqw (Asm, 4, 0);
+  EmitMoviqq (Asm, 6, TEST_CHECKSUM_ITERATIONS);
+
+  Outer = Asm->Ptr;
+  EmitMoviqq (Asm, 1, (UINT64) (UINTN) mTestChecksumSource);
+  EmitMoviqq (Asm, 2, (UINT64) (UINTN) mTestChecksumDestination);
+  EmitMoviqq (Asm, 3, TEST_CHECKSUM_COUNT);
+
+  Inner = Asm->Ptr;
+  EmitMov (Asm, OPCODE_MOVQW, 7, FALSE, 1, TRUE);
+  EmitMov (Asm, OPCODE_MOVQW, 2, TRUE, 7, FALSE);
+  EmitDataManip (Asm, OPCODE_ADD, TRUE, 4, 7, 0);
+  EmitDataManip (Asm, OPCODE_SHL, TRUE, 4, TEST_REG_ONE, 0);
+  EmitDataManip (Asm, OPCODE_ADD, TRUE, 1, TEST_REG_ONE, 7);
+  EmitDataManip (Asm, OPCODE_ADD, TRUE, 2, TEST_REG_ONE, 7);
+  EmitDataManip (Asm, OPCODE_SUB, TRUE, 3, TEST_REG_ONE, 0);
+  EmitCmpi (Asm, OPCODE_CMPIUGTE, TRUE, 3, 1);
+  EmitJmp8 (Asm, TEST_JMP_CS, Inner);
+
+  EmitDataManip (Asm, OPCODE_SUB, TRUE, 6, TEST_REG_ONE, 0);
+  EmitCmpi (Asm, OPCODE_CMPIEQ, TRUE, 6, 0);
+  EmitJmp8 (Asm, TEST_JMP_CC, Outer);
+  EmitRet (Asm);
+  return Entry;
+}
+
+/**
+  Move R0 down by 1KB per iteration for TEST_STACK_FAULT_LOOPS
+  iterations, which runs into the stack top long after the loop has been
+  compiled.
+
+  @param  Asm     Assembler state.
+
+  @return The entry point of the kernel.
+
+**/
+VMIP
+BuildStackFaultKernel (
+  IN EBC_ASM  *Asm
+  )
+{
+  VMIP  Entry;
+  VMIP  Loop;
+
+  Entry = Asm->Ptr;
+  EmitMoviqw (Asm, 1, TEST_STACK_FAULT_LOOPS);
+
+  Loop = Asm->Ptr;
+  EmitDataManip (Asm, OPCODE_SUB, TRUE, 0, TEST_REG_ONE, SIZE_1KB - 1);
+  EmitDataManip (Asm, OPCODE_SUB, TRUE, 1, TEST_REG_ONE, 0);
+  EmitCmpi (Asm, OPCODE_CMPIEQ, TRUE, 1, 0);
+  EmitJmp8 (Asm, TEST_JMP_CC, Loop);
+  EmitRet (Asm);
+  return Entry;
+}
+
+/**
+  Set up a VM context to run a program from its entry point, with R1-R4
+  taken from the random state, R5 set to 1, R7 pointing to mTestData and
+  mTestData reset to mTestDataInitial.
+
+  @param  Entry             Entry point of the program.
+  @param  Seed              Seed of the initial registers.
+  @param  VmPtr             The VM context to set up.
+
+**/
+VOID
+InitTestVm (
+  IN  VMIP        Entry,
+  IN  UINT64      Seed,
+  OUT VM_CONTEXT  *VmPtr
+  )
+{
+  UINT8  Reg;
+
+  //
+  // Same stack layout as ExecuteEbcImageEntryPoint().
+  //
+  ZeroMem (VmPtr, sizeof (VM_CONTEXT));
+  VmPtr->Ip              = Entry;
+  VmPtr->StackPool       = mTestStack;
+  VmPtr->StackTop        = mTestStack;
+  VmPtr->Gpr[0]          = (UINT64) (UINTN) (mTestStack + TEST_STACK_SIZE);
+  VmPtr->HighStackBottom = (UINTN) VmPtr->Gpr[0];
+  VmPtr->Gpr[0]         -= sizeof (UINTN);
+  *(UINTN *) (UINTN) VmPtr->Gpr[0] = (UINTN) VM_STACK_KEY_VALUE;
+  VmPtr->StackMagicPtr   = (UINTN *) (UINTN) VmPtr->Gpr[0];
+  VmPtr->LowStackTop     = (UINTN) VmPtr->Gpr[0];
+  VmPtr->Gpr[0]         -= 2 * sizeof (UINT64);
+  VmPtr->StackRetAddr    = (UINT64) VmPtr->Gpr[0];
+  VmPtr->FramePtr        = (VOID *) (UINTN) (VmPtr->Gpr[0] + 8);
+
+  mRandomState = Seed + 1;
+  for (Reg = 1; Reg < TEST_REG_ONE; Reg++) {
+    VmPtr->Gpr[Reg] = LShiftU64 (TestRandom (MAX_UINT32), 32) | TestRandom (MAX_UINT32);
+  }
+
+  VmPtr->Gpr[TEST_REG_ONE]  = 1;
+  VmPtr->Gpr[TEST_REG_DATA] = (UINT64) (UINTN) mTestData;
+  CopyMem (mTestData, mTestDataInitial, TEST_DATA_SIZE);
+
+  mExceptionCount = 0;
+}
+
+/**
+  Run a program from its entry point to the final RET.
+
+  @param  Entry             Entry point of the program.
+  @param  Mode              How to run the program.
+  @param  Seed              Seed of the initial registers.
+  @param  VmPtr             Receives the final VM state.
+
+  @return The run time in clock ticks.
+
+**/
+clock_t
+RunProgram (
+  IN  VMIP        Entry,
+  IN  TEST_MODE   Mode,
+  IN  UINT64      Seed,
+  OUT VM_CONTEXT  *VmPtr
+  )
+{
+  clock_t  Start;
+  UINTN    Count;
+
+  InitTestVm (Entry, Seed, VmPtr);
+
+  //
+  // Start every run from a cold cache, so blocks are compiled from the
+  // code that is there now.
+  //
+  FlushEbcDecodeCache ();
+  FlushEbcJit ();
+  if (Mode == TestModeJit) {
+    InitEbcJit ();
+  } else {
+    FreeEbcJit ();
+  }
+
+  Start = clock ();
+  if (Mode == TestModeStep) {
+    while ((VmPtr->StopFlags & STOPFLAG_APP_DONE) == 0) {
+      Count = 1;
+      if (EFI_ERROR (EbcExecuteInstructions (NULL, VmPtr, &Count))) {
+        break;
+      }
+    }
+  } else {
+    EbcExecute (VmPtr);
+  }
+
+  return clock () - Start;
+}
+
+/**
+  Compare the architectural state of two VM contexts.
+
+  @param  Expected    State after TestModeStep.
+  @param  Actual      State after another mode.
+
+  @retval TRUE        The states match.
+
+**/
+BOOLEAN
+CompareVmState (
+  IN VM_CONTEXT  *Expected,
+  IN VM_CONTEXT  *Actual
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < ARRAY_SIZE (Expected->Gpr); Index++) {
+    if (Expected->Gpr[Index] != Actual->Gpr[Index]) {
+      DEBUG ((DEBUG_ERROR, "R%d: expected 0x%lx, got 0x%lx\n", Index, Expected->Gpr[Index], Actual->Gpr[Index]));
+      return FALSE;
+    }
+  }
+
+  return (BOOLEAN) ((Expected->Ip == Actual->Ip) &&
+                    ((Expected->Flags & VMFLAGS_CC) == (Actual->Flags & VMFLAGS_CC)));
+}
+
+/**
+  Report the run time of a kernel.
+
+**/
+VOID
+ReportTime (
+  IN CHAR8    *Name,
+  IN CHAR8    *Mode,
+  IN clock_t  Ticks
+  )
+{
+  DEBUG ((DEBUG_INFO, "%a: %a %ld ms\n", Name, Mode, (UINT64) Ticks * 1000 / CLOCKS_PER_SEC));
+}
+
+/**
+  Check that EBC code runs in the interpreter when the CPU architectural
+  protocol is not installed yet, and that the JIT compiles it once the
+  protocol shows up.
+
+  @param[in]  Context    Unused.
+
+  @retval  UNIT_TEST_PASSED             Nothing was compiled without the
+                                        protocol.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  Code was compiled without a way to
+                                        protect it.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+NoCpuArchShouldInterpret (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EBC_ASM     Asm;
+  VMIP        Entry;
+  VM_CONTEXT  Expected;
+  VM_CONTEXT  Actual;
+
+  Asm.Ptr = mTestCode;
+  Entry   = BuildSumKernel (&Asm);
+
+  RunProgram (Entry, TestModeStep, 0, &Expected);
+
+  mTestCpuInstalled = FALSE;
+  RunProgram (Entry, TestModeJit, 0, &Actual);
+  UT_ASSERT_EQUAL (mExceptionCount, 0);
+  UT_ASSERT_TRUE (CompareVmState (&Expected, &Actual));
+  UT_ASSERT_EQUAL (mEbcJitCodeUsed, 0);
+
+  mTestCpuInstalled = TRUE;
+  RunProgram (Entry, TestModeJit, 0, &Actual);
+  UT_ASSERT_EQUAL (mExceptionCount, 0);
+  UT_ASSERT_TRUE (CompareVmState (&Expected, &Actual));
+  UT_ASSERT_NOT_EQUAL (mEbcJitCodeUsed, 0);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Run random programs in the interpreter and with the JIT and check that
+  the results agree.
+
+  @param[in]  Context    Unused.
+
+  @retval  UNIT_TEST_PASSED             The results match.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The JIT produced a different result.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+RandomProgramsShouldMatchInterpreter (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EBC_ASM     Asm;
+  VMIP        Entry;
+  VM_CONTEXT  Expected;
+  VM_CONTEXT  Actual;
+  UINT8       ExpectedData[TEST_DATA_SIZE];
+  UINT64      Seed;
+  BOOLEAN     Match;
+
+  for (Seed = 1; Seed <= TEST_RANDOM_PROGRAMS; Seed++) {
+    Asm.Ptr = mTestCode;
+    Entry = BuildRandomProgram (&Asm, Seed);
+    UT_ASSERT_TRUE ((UINTN) (Asm.Ptr - mTestCode) <= TEST_CODE_SIZE);
+
+    RunProgram (Entry, TestModeStep, Seed, &Expected);
+    UT_ASSERT_EQUAL (mExceptionCount, 0);
+    CopyMem (ExpectedData, mTestData, TEST_DATA_SIZE);
+
+    RunProgram (Entry, TestModeJit, Seed, &Actual);
+    UT_ASSERT_EQUAL (mExceptionCount, 0);
+    UT_ASSERT_NOT_EQUAL (mEbcJitCodeUsed, 0);
+    Match = CompareVmState (&Expected, &Actual);
+    if (!Match || (CompareMem (ExpectedData, mTestData, TEST_DATA_SIZE) != 0)) {
+      DEBUG ((DEBUG_ERROR, "Program %ld does not match\n", Seed));
+    }
+
+    UT_ASSERT_TRUE (Match);
+    UT_ASSERT_MEM_EQUAL (mTestData, ExpectedData, TEST_DATA_SIZE);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Modify the immediate data of an instruction that is already compiled and
+  check that FlushEbcJit() makes the JIT pick it up, and that the code
+  buffer is left executable and read-only.
+
+  @param[in]  Context    Unused.
+
+  @retval  UNIT_TEST_PASSED             The modified code was executed.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A stale compiled block was used.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+FlushShouldDropCompiledBlocks (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EBC_ASM     Asm;
+  VMIP        Entry;
+  VM_CONTEXT  Actual;
+
+  Asm.Ptr = mTestCode;
+  Entry   = BuildSumKernel (&Asm);
+  RunProgram (Entry, TestModeJit, 0, &Actual);
+  UT_ASSERT_EQUAL (Actual.Gpr[2], 7 * TEST_SUM_ITERATIONS);
+  UT_ASSERT_EQUAL (mTestCodeAttributes, EFI_MEMORY_RO);
+
+  //
+  // Change MOVIqw R3, 7 behind the back of the JIT. The compiled loop keeps
+  // running until the caches are flushed.
+  //
+  UT_ASSERT_EQUAL (ReadUnaligned16 ((UINT16 *) (Entry + 4 + 4 + 2)), 7);
+  WriteUnaligned16 ((UINT16 *) (Entry + 4 + 4 + 2), 9);
+  InitTestVm (Entry, 0, &Actual);
+  EbcExecute (&Actual);
+  UT_ASSERT_EQUAL (Actual.Gpr[2], 7 * TEST_SUM_ITERATIONS);
+
+  FlushEbcDecodeCache ();
+  FlushEbcJit ();
+  InitTestVm (Entry, 0, &Actual);
+  EbcExecute (&Actual);
+  UT_ASSERT_EQUAL (mExceptionCount, 0);
+  UT_ASSERT_EQUAL (Actual.Gpr[2], 9 * TEST_SUM_ITERATIONS);
+  UT_ASSERT_EQUAL (mTestCodeAttributes, EFI_MEMORY_RO);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Run R0 into the stack top inside a compiled loop and check that the stack
+  fault is reported at the same instruction as in the interpreter.
+
+  @param[in]  Context    Unused.
+
+  @retval  UNIT_TEST_PASSED             The fault was reported at the same
+                                        instruction.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The compiled loop missed the fault.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+StackFaultShouldMatchInterpreter (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EBC_ASM     Asm;
+  VMIP        Entry;
+  VM_CONTEXT  Expected;
+  VM_CONTEXT  Actual;
+
+  Asm.Ptr = mTestCode;
+  Entry   = BuildStackFaultKernel (&Asm);
+
+  RunProgram (Entry, TestModeThreaded, 0, &Expected);
+  UT_ASSERT_EQUAL (mExceptionCount, 1);
+
+  RunProgram (Entry, TestModeJit, 0, &Actual);
+  UT_ASSERT_EQUAL (mExceptionCount, 1);
+  UT_ASSERT_NOT_EQUAL (mEbcJitCodeUsed, 0);
+  UT_ASSERT_TRUE (CompareVmState (&Expected, &Actual));
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Run the checksum kernel in the interpreter and with the JIT, check that
+  the results agree and report the run times.
+
+  @param[in]  Context    Unused.
+
+  @retval  UNIT_TEST_PASSED             The results match.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The JIT produced a different result.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+ChecksumKernelShouldMatchInterpreter (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EBC_ASM     Asm;
+  VMIP        Entry;
+  VM_CONTEXT  Expected;
+  VM_CONTEXT  Actual;
+  clock_t     Ticks;
+  UINTN       Index;
+
+  Asm.Ptr = mTestCode;
+  Entry   = BuildChecksumKernel (&Asm);
+
+  for (Index = 0; Index < TEST_CHECKSUM_COUNT; Index++) {
+    mTestChecksumSource[Index] = MultU64x32 (0x0123456789ABCDEFULL, (UINT32) Index + 1);
+  }
+
+  ZeroMem (mTestChecksumDestination, TEST_CHECKSUM_COUNT * sizeof (UINT64));
+  Ticks = RunProgram (Entry, TestModeThreaded, 0, &Expected);
+  UT_ASSERT_EQUAL (mExceptionCount, 0);
+  UT_ASSERT_MEM_EQUAL (mTestChecksumDestination, mTestChecksumSource, TEST_CHECKSUM_COUNT * sizeof (UINT64));
+  ReportTime ("Checksum", "interpreter", Ticks);
+
+  ZeroMem (mTestChecksumDestination, TEST_CHECKSUM_COUNT * sizeof (UINT64));
+  Ticks = RunProgram (Entry, TestModeJit, 0, &Actual);
+  UT_ASSERT_EQUAL (mExceptionCount, 0);
+  UT_ASSERT_TRUE (CompareVmState (&Expected, &Actual));
+  UT_ASSERT_MEM_EQUAL (mTestChecksumDestination, mTestChecksumSource, TEST_CHECKSUM_COUNT * sizeof (UINT64));
+  ReportTime ("Checksum", "JIT        ", Ticks);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialze the unit test framework, suite, and unit tests for the EBC
+  JIT compiler and run them.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      JitTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  mTestBootServices.AllocatePages  = TestAllocatePages;
+  mTestBootServices.FreePages      = TestFreePages;
+  mTestBootServices.LocateProtocol = TestLocateProtocol;
+  mTestCpu.SetMemoryAttributes     = TestSetMemoryAttributes;
+  gBS                      = &mTestBootServices;
+  mTestCode                = AllocateZeroPool (TEST_CODE_SIZE);
+  mTestStack               = AllocateZeroPool (TEST_STACK_SIZE);
+  mTestData                = AllocateZeroPool (TEST_DATA_SIZE);
+  mTestDataInitial         = AllocateZeroPool (TEST_DATA_SIZE);
+  mTestChecksumSource      = AllocateZeroPool (TEST_CHECKSUM_COUNT * sizeof (UINT64));
+  mTestChecksumDestination = AllocateZeroPool (TEST_CHECKSUM_COUNT * sizeof (UINT64));
+  if ((mTestCode == NULL) || (mTestStack == NULL) ||
+      (mTestData == NULL) || (mTestDataInitial == NULL) ||
+      (mTestChecksumSource == NULL) || (mTestChecksumDestination == NULL)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  InitEbcDecodeCache ();
+  Status = InitEbcJit ();
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "The JIT compiler is not available on this host - %r\n", Status));
+    goto EXIT;
+  }
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&JitTests, Framework, "EBC JIT Compiler Tests", "EbcDxe.Jit", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for EBC JIT Compiler Tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  //
+  // The first test must run before the CPU architectural protocol is
+  // installed.
+  //
+  // --------------Suite------Description------------------------------------Name--------Function------------------------------Pre---Post---Context-----------
+  //
+  AddTestCase (JitTests, "Without CPU arch protocol code is interpreted", "NoCpu",    NoCpuArchShouldInterpret,             NULL, NULL, NULL);
+  AddTestCase (JitTests, "Random programs match the interpreter",         "Random",   RandomProgramsShouldMatchInterpreter, NULL, NULL, NULL);
+  AddTestCase (JitTests, "Flush drops compiled blocks",                   "Flush",    FlushShouldDropCompiledBlocks,        NULL, NULL, NULL);
+  AddTestCase (JitTests, "Stack faults match the interpreter",            "Stack",    StackFaultShouldMatchInterpreter,     NULL, NULL, NULL);
+  AddTestCase (JitTests, "Checksum kernel matches the interpreter",       "Checksum", ChecksumKernelShouldMatchInterpreter, NULL, NULL, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  FreeEbcJit ();
+  FreeEbcDecodeCache ();
+  return Status;
+}
+
+///
+/// Avoid ECC error for function name that starts with lower case letter
+///
+#define EbcJitUnitTestMain main
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+  @param[in] Argc  Number of arguments
+  @param[in] Argv  Array of pointers to arguments
+
+  @retval 0      Success
+  @retval other  Error
+**/
+INT32
+EbcJitUnitTestMain (
+  IN INT32  Argc,
+  IN CHAR8  *Argv[]
+  )
+{
+  UnitTestingEntry ();
+  return 0;
+}
@@ -0,0 +1,362 @@
+/** @file
+  Minimal EBC assembler shared by the EbcDxe host based unit tests.
+
+  Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "EbcTestAssembler.h"
+
+/**
+  Emit MOVIqq Reg, Immed.
+
+  @param  Asm    The assembler state.
+  @param  Reg    The destination register.
+  @param  Immed  The 64-bit immediate.
+
+**/
+VOID
+EmitMoviqq (
+  IN EBC_ASM  *Asm,
+  IN UINT8    Reg,
+  IN UINT64   Immed
+  )
+{
+  Asm->Ptr[0] = OPCODE_MOVI | MOVI_DATAWIDTH64;
+  Asm->Ptr[1] = (UINT8) (MOVI_MOVEWIDTH64 | Reg);
+  WriteUnaligned64 ((UINT64 *) (Asm->Ptr + 2), Immed);
+  Asm->Ptr += 10;
+}
+
+/**
+  Emit MOVIqw Reg, Immed.
+
+  @param  Asm    The assembler state.
+  @param  Reg    The destination register.
+  @param  Immed  The 16-bit immediate, sign extended to 64 bits.
+
+**/
+VOID
+EmitMoviqw (
+  IN EBC_ASM  *Asm,
+  IN UINT8    Reg,
+  IN INT16    Immed
+  )
+{
+  Asm->Ptr[0] = OPCODE_MOVI | MOVI_DATAWIDTH16;
+  Asm->Ptr[1] = (UINT8) (MOVI_MOVEWIDTH64 | Reg);
+  WriteUnaligned16 ((UINT16 *) (Asm->Ptr + 2), (UINT16) Immed);
+  Asm->Ptr += 4;
+}
+
+/**
+  Emit a MOVxx instruction without index data.
+
+  @param  Asm        The assembler state.
+  @param  Opcode     One of the OPCODE_MOVxx opcodes.
+  @param  Reg1       The destination register.
+  @param  Indirect1  TRUE to store to @Reg1.
+  @param  Reg2       The source register.
+  @param  Indirect2  TRUE to load from @Reg2.
+
+**/
+VOID
+EmitMov (
+  IN EBC_ASM  *Asm,
+  IN UINT8    Opcode,
+  IN UINT8    Reg1,
+  IN BOOLEAN  Indirect1,
+  IN UINT8    Reg2,
+  IN BOOLEAN  Indirect2
+  )
+{
+  Asm->Ptr[0] = Opcode;
+  Asm->Ptr[1] = (UINT8) (Reg1 | (Reg2 << 4) |
+                         (Indirect1 ? OPERAND_M_INDIRECT1 : 0) |
+                         (Indirect2 ? OPERAND_M_INDIRECT2 : 0));
+  Asm->Ptr += 2;
+}
+
+/**
+  Encode a constant 16-bit index, which has no natural units.
+
+  @param  Offset  The byte offset, -4095 to 4095.
+
+  @return The encoded index.
+
+**/
+STATIC
+UINT16
+EncodeIndex16 (
+  IN INT16  Offset
+  )
+{
+  ASSERT ((Offset > -0x1000) && (Offset < 0x1000));
+  if (Offset < 0) {
+    return (UINT16) (BIT15 | -Offset);
+  }
+
+  return (UINT16) Offset;
+}
+
+/**
+  Emit a MOVxxw instruction with 16-bit constant indexes. An index of zero
+  is left out of the encoding.
+
+  @param  Asm        The assembler state.
+  @param  Opcode     One of the OPCODE_MOVxW opcodes.
+  @param  Reg1       The destination register.
+  @param  Indirect1  TRUE to store to @Reg1(Index1).
+  @param  Index1     The byte offset from Reg1, -4095 to 4095.
+  @param  Reg2       The source register.
+  @param  Indirect2  TRUE to load from @Reg2(Index2).
+  @param  Index2     The byte offset from Reg2, -4095 to 4095.
+
+**/
+VOID
+EmitMovIndexed (
+  IN EBC_ASM  *Asm,
+  IN UINT8    Opcode,
+  IN UINT8    Reg1,
+  IN BOOLEAN  Indirect1,
+  IN INT16    Index1,
+  IN UINT8    Reg2,
+  IN BOOLEAN  Indirect2,
+  IN INT16    Index2
+  )
+{
+  UINT8  *Instruction;
+
+  Instruction = Asm->Ptr;
+  EmitMov (Asm, Opcode, Reg1, Indirect1, Reg2, Indirect2);
+  if (Index1 != 0) {
+    Instruction[0] |= OPCODE_M_IMMED_OP1;
+    WriteUnaligned16 ((UINT16 *) Asm->Ptr, EncodeIndex16 (Index1));
+    Asm->Ptr += sizeof (UINT16);
+  }
+
+  if (Index2 != 0) {
+    Instruction[0] |= OPCODE_M_IMMED_OP2;
+    WriteUnaligned16 ((UINT16 *) Asm->Ptr, EncodeIndex16 (Index2));
+    Asm->Ptr += sizeof (UINT16);
+  }
+}
+
+/**
+  Emit a data manipulation instruction, with immediate data if Immed is
+  not zero.
+
+  @param  Asm      The assembler state.
+  @param  Opcode   The data manipulation opcode.
+  @param  Is64Bit  TRUE for the 64-bit form.
+  @param  Reg1     The destination and first source register.
+  @param  Reg2     The second source register.
+  @param  Immed    The immediate added to Reg2.
+
+**/
+VOID
+EmitDataManip (
+  IN EBC_ASM  *Asm,
+  IN UINT8    Opcode,
+  IN BOOLEAN  Is64Bit,
+  IN UINT8    Reg1,
+  IN UINT8    Reg2,
+  IN INT16    Immed
+  )
+{
+  Asm->Ptr[0] = (UINT8) (Opcode | (Is64Bit ? DATAMANIP_M_64 : 0));
+  Asm->Ptr[1] = (UINT8) (Reg1 | (Reg2 << 4));
+  if (Immed != 0) {
+    Asm->Ptr[0] |= DATAMANIP_M_IMMDATA;
+    WriteUnaligned16 ((UINT16 *) (Asm->Ptr + 2), (UINT16) Immed);
+    Asm->Ptr += 2;
+  }
+
+  Asm->Ptr += 2;
+}
+
+/**
+  Emit CMPxx Reg1, Reg2.
+
+  @param  Asm      The assembler state.
+  @param  Opcode   One of the OPCODE_CMPxx opcodes.
+  @param  Is64Bit  TRUE for the 64-bit form.
+  @param  Reg1     The first register.
+  @param  Reg2     The second register.
+
+**/
+VOID
+EmitCmp (
+  IN EBC_ASM  *Asm,
+  IN UINT8    Opcode,
+  IN BOOLEAN  Is64Bit,
+  IN UINT8    Reg1,
+  IN UINT8    Reg2
+  )
+{
+  Asm->Ptr[0] = (UINT8) (Opcode | (Is64Bit ? OPCODE_M_64BIT : 0));
+  Asm->Ptr[1] = (UINT8) (Reg1 | (Reg2 << 4));
+  Asm->Ptr += 2;
+}
+
+/**
+  Emit CMPIxxw Reg, Immed.
+
+  @param  Asm      The assembler state.
+  @param  Opcode   One of the OPCODE_CMPIxx opcodes.
+  @param  Is64Bit  TRUE for the 64-bit form.
+  @param  Reg      The register to compare.
+  @param  Immed    The 16-bit immediate.
+
+**/
+VOID
+EmitCmpi (
+  IN EBC_ASM  *Asm,
+  IN UINT8    Opcode,
+  IN BOOLEAN  Is64Bit,
+  IN UINT8    Reg,
+  IN INT16    Immed
+  )
+{
+  Asm->Ptr[0] = (UINT8) (Opcode | (Is64Bit ? OPCODE_M_CMPI64 : 0));
+  Asm->Ptr[1] = Reg;
+  WriteUnaligned16 ((UINT16 *) (Asm->Ptr + 2), (UINT16) Immed);
+  Asm->Ptr += 4;
+}
+
+/**
+  Emit a JMP8.
+
+  @param  Asm        The assembler state.
+  @param  Condition  TEST_JMP_ALWAYS, TEST_JMP_CC or TEST_JMP_CS.
+  @param  Target     The jump target. Forward jumps are fixed up with
+                     PatchJmp8().
+
+  @return The address of the JMP8.
+
+**/
+UINT8 *
+EmitJmp8 (
+  IN EBC_ASM  *Asm,
+  IN UINT8    Condition,
+  IN VMIP     Target
+  )
+{
+  UINT8  *Jmp;
+
+  Jmp     = Asm->Ptr;
+  Jmp[0]  = (UINT8) (OPCODE_JMP8 | Condition);
+  Jmp[1]  = (UINT8) (INT8) ((Target - (Jmp + 2)) / 2);
+  Asm->Ptr += 2;
+  return Jmp;
+}
+
+/**
+  Update the target of a JMP8 emitted by EmitJmp8().
+
+  @param  Jmp     The address of the JMP8.
+  @param  Target  The new target.
+
+**/
+VOID
+PatchJmp8 (
+  IN UINT8  *Jmp,
+  IN VMIP   Target
+  )
+{
+  Jmp[1] = (UINT8) (INT8) ((Target - (Jmp + 2)) / 2);
+}
+
+/**
+  Emit a relative JMP32 with immediate data.
+
+  @param  Asm        The assembler state.
+  @param  Condition  TEST_JMP_ALWAYS, TEST_JMP_CC or TEST_JMP_CS.
+  @param  Target     The jump target.
+
+**/
+VOID
+EmitJmp32 (
+  IN EBC_ASM  *Asm,
+  IN UINT8    Condition,
+  IN VMIP     Target
+  )
+{
+  Asm->Ptr[0] = OPCODE_JMP | OPCODE_M_IMMDATA;
+  Asm->Ptr[1] = (UINT8) (JMP_M_RELATIVE | Condition);
+  WriteUnaligned32 ((UINT32 *) (Asm->Ptr + 2), (UINT32) (Target - (Asm->Ptr + 6)));
+  Asm->Ptr += 6;
+}
+
+/**
+  Emit a relative CALL32 with immediate data.
+
+  @param  Asm     The assembler state.
+  @param  Target  The EBC function to call.
+
+**/
+VOID
+EmitCall32Relative (
+  IN EBC_ASM  *Asm,
+  IN VMIP     Target
+  )
+{
+  Asm->Ptr[0] = OPCODE_CALL | OPCODE_M_IMMDATA;
+  Asm->Ptr[1] = OPERAND_M_RELATIVE_ADDR;
+  WriteUnaligned32 ((UINT32 *) (Asm->Ptr + 2), (UINT32) (Target - (Asm->Ptr + 6)));
+  Asm->Ptr += 6;
+}
+
+/**
+  Emit an absolute CALL64.
+
+  @param  Asm     The assembler state.
+  @param  Target  The EBC function to call.
+
+**/
+VOID
+EmitCall64 (
+  IN EBC_ASM  *Asm,
+  IN VMIP     Target
+  )
+{
+  Asm->Ptr[0] = OPCODE_CALL | OPCODE_M_IMMDATA | OPCODE_M_IMMDATA64;
+  Asm->Ptr[1] = 0;
+  WriteUnaligned64 ((UINT64 *) (Asm->Ptr + 2), (UINT64) (UINTN) Target);
+  Asm->Ptr += 10;
+}
+
+/**
+  Emit an absolute CALL32 Reg.
+
+  @param  Asm  The assembler state.
+  @param  Reg  The register holding the EBC function to call.
+
+**/
+VOID
+EmitCallRegister (
+  IN EBC_ASM  *Asm,
+  IN UINT8    Reg
+  )
+{
+  Asm->Ptr[0] = OPCODE_CALL;
+  Asm->Ptr[1] = Reg;
+  Asm->Ptr += 2;
+}
+
+/**
+  Emit RET.
+
+  @param  Asm  The assembler state.
+
+**/
+VOID
+EmitRet (
+  IN EBC_ASM  *Asm
+  )
+{
+  Asm->Ptr[0] = OPCODE_RET;
+  Asm->Ptr[1] = 0;
+  Asm->Ptr += 2;
+}
@@ -0,0 +1,262 @@
+/** @file
+  Minimal EBC assembler shared by the EbcDxe host based unit tests.
+
+  Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef EBC_TEST_ASSEMBLER_H_
+#define EBC_TEST_ASSEMBLER_H_
+
+#include "../EbcInt.h"
+#include "../EbcExecute.h"
+
+//
+// Condition bits of the JMP instructions.
+//
+#define TEST_JMP_ALWAYS           0
+#define TEST_JMP_CC               CONDITION_M_CONDITIONAL
+#define TEST_JMP_CS               (CONDITION_M_CONDITIONAL | CONDITION_M_CS)
+
+//
+// Assembler state.
+//
+typedef struct {
+  UINT8   *Ptr;
+} EBC_ASM;
+
+/**
+  Emit MOVIqq Reg, Immed.
+
+  @param  Asm    The assembler state.
+  @param  Reg    The destination register.
+  @param  Immed  The 64-bit immediate.
+
+**/
+VOID
+EmitMoviqq (
+  IN EBC_ASM  *Asm,
+  IN UINT8    Reg,
+  IN UINT64   Immed
+  );
+
+/**
+  Emit MOVIqw Reg, Immed.
+
+  @param  Asm    The assembler state.
+  @param  Reg    The destination register.
+  @param  Immed  The 16-bit immediate, sign extended to 64 bits.
+
+**/
+VOID
+EmitMoviqw (
+  IN EBC_ASM  *Asm,
+  IN UINT8    Reg,
+  IN INT16    Immed
+  );
+
+/**
+  Emit a MOVxx instruction without index data.
+
+  @param  Asm        The assembler state.
+  @param  Opcode     One of the OPCODE_MOVxx opcodes.
+  @param  Reg1       The destination register.
+  @param  Indirect1  TRUE to store to @Reg1.
+  @param  Reg2       The source register.
+  @param  Indirect2  TRUE to load from @Reg2.
+
+**/
+VOID
+EmitMov (
+  IN EBC_ASM  *Asm,
+  IN UINT8    Opcode,
+  IN UINT8    Reg1,
+  IN BOOLEAN  Indirect1,
+  IN UINT8    Reg2,
+  IN BOOLEAN  Indirect2
+  );
+
+/**
+  Emit a MOVxxw instruction with 16-bit constant indexes. An index of zero
+  is left out of the encoding.
+
+  @param  Asm        The assembler state.
+  @param  Opcode     One of the OPCODE_MOVxW opcodes.
+  @param  Reg1       The destination register.
+  @param  Indirect1  TRUE to store to @Reg1(Index1).
+  @param  Index1     The byte offset from Reg1, -4095 to 4095.
+  @param  Reg2       The source register.
+  @param  Indirect2  TRUE to load from @Reg2(Index2).
+  @param  Index2     The byte offset from Reg2, -4095 to 4095.
+
+**/
+VOID
+EmitMovIndexed (
+  IN EBC_ASM  *Asm,
+  IN UINT8    Opcode,
+  IN UINT8    Reg1,
+  IN BOOLEAN  Indirect1,
+  IN INT16    Index1,
+  IN UINT8    Reg2,
+  IN BOOLEAN  Indirect2,
+  IN INT16    Index2
+  );
+
+/**
+  Emit a data manipulation instruction, with immediate data if Immed is
+  not zero.
+
+  @param  Asm      The assembler state.
+  @param  Opcode   The data manipulation opcode.
+  @param  Is64Bit  TRUE for the 64-bit form.
+  @param  Reg1     The destination and first source register.
+  @param  Reg2     The second source register.
+  @param  Immed    The immediate added to Reg2.
+
+**/
+VOID
+EmitDataManip (
+  IN EBC_ASM  *Asm,
+  IN UINT8    Opcode,
+  IN BOOLEAN  Is64Bit,
+  IN UINT8    Reg1,
+  IN UINT8    Reg2,
+  IN INT16    Immed
+  );
+
+/**
+  Emit CMPxx Reg1, Reg2.
+
+  @param  Asm      The assembler state.
+  @param  Opcode   One of the OPCODE_CMPxx opcodes.
+  @param  Is64Bit  TRUE for the 64-bit form.
+  @param  Reg1     The first register.
+  @param  Reg2     The second register.
+
+**/
+VOID
+EmitCmp (
+  IN EBC_ASM  *Asm,
+  IN UINT8    Opcode,
+  IN BOOLEAN  Is64Bit,
+  IN UINT8    Reg1,
+  IN UINT8    Reg2
+  );
+
+/**
+  Emit CMPIxxw Reg, Immed.
+
+  @param  Asm      The assembler state.
+  @param  Opcode   One of the OPCODE_CMPIxx opcodes.
+  @param  Is64Bit  TRUE for the 64-bit form.
+  @param  Reg      The register to compare.
+  @param  Immed    The 16-bit immediate.
+
+**/
+VOID
+EmitCmpi (
+  IN EBC_ASM  *Asm,
+  IN UINT8    Opcode,
+  IN BOOLEAN  Is64Bit,
+  IN UINT8    Reg,
+  IN INT16    Immed
+  );
+
+/**
+  Emit a JMP8.
+
+  @param  Asm        The assembler state.
+  @param  Condition  TEST_JMP_ALWAYS, TEST_JMP_CC or TEST_JMP_CS.
+  @param  Target     The jump target. Forward jumps are fixed up with
+                     PatchJmp8().
+
+  @return The address of the JMP8.
+
+**/
+UINT8 *
+EmitJmp8 (
+  IN EBC_ASM  *Asm,
+  IN UINT8    Condition,
+  IN VMIP     Target
+  );
+
+/**
+  Update the target of a JMP8 emitted by EmitJmp8().
+
+  @param  Jmp     The address of the JMP8.
+  @param  Target  The new target.
+
+**/
+VOID
+PatchJmp8 (
+  IN UINT8  *Jmp,
+  IN VMIP   Target
+  );
+
+/**
+  Emit a relative JMP32 with immediate data.
+
+  @param  Asm        The assembler state.
+  @param  Condition  TEST_JMP_ALWAYS, TEST_JMP_CC or TEST_JMP_CS.
+  @param  Target     The jump target.
+
+**/
+VOID
+EmitJmp32 (
+  IN EBC_ASM  *Asm,
+  IN UINT8    Condition,
+  IN VMIP     Target
+  );
+
+/**
+  Emit a relative CALL32 with immediate data.
+
+  @param  Asm     The assembler state.
+  @param  Target  The EBC function to call.
+
+**/
+VOID
+EmitCall32Relative (
+  IN EBC_ASM  *Asm,
+  IN VMIP     Target
+  );
+
+/**
+  Emit an absolute CALL64.
+
+  @param  Asm     The assembler state.
+  @param  Target  The EBC function to call.
+
+**/
+VOID
+EmitCall64 (
+  IN EBC_ASM  *Asm,
+  IN VMIP     Target
+  );
+
+/**
+  Emit an absolute CALL32 Reg.
+
+  @param  Asm  The assembler state.
+  @param  Reg  The register holding the EBC function to call.
+
+**/
+VOID
+EmitCallRegister (
+  IN EBC_ASM  *Asm,
+  IN UINT8    Reg
+  );
+
+/**
+  Emit RET.
+
+  @param  Asm  The assembler state.
+
+**/
+VOID
+EmitRet (
+  IN EBC_ASM  *Asm
+  );
+
+#endif
@@ -0,0 +1,609 @@
+/** @file
+  Host based unit test and benchmark of the EBC interpreter. Small EBC
+  kernels are run once by single-stepping through EbcExecuteInstructions(),
+  which always uses the opcode table, and then through EbcExecute() with and
+  without the decoded instruction cache. The results must match, and the
+  instruction rate of each mode is reported.
+
+  Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <time.h>
+#include <cmocka.h>
+
+#include "../EbcDebuggerHook.h"
+#include "EbcTestAssembler.h"
+
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME        "EBC Interpreter Threaded Code Unit Tests"
+#define UNIT_TEST_APP_VERSION     "1.0"
+
+#define TEST_CODE_SIZE            SIZE_4KB
+#define TEST_STACK_SIZE           SIZE_64KB
+#define TEST_COPY_COUNT           512
+#define TEST_ALU_ITERATIONS       200000
+#define TEST_COPY_ITERATIONS      200
+#define TEST_CALL_ITERATIONS      100000
+
+typedef enum {
+  TestModeStep,
+  TestModeOpcodeTable,
+  TestModeThreaded
+} TEST_MODE;
+
+typedef
+VMIP
+(*BUILD_KERNEL) (
+  IN EBC_ASM  *Asm
+  );
+
+typedef struct {
+  CHAR8         *Name;
+  BUILD_KERNEL  Build;
+  BOOLEAN       CopiesMemory;
+} TEST_KERNEL;
+
+VM_CONTEXT         *mVmPtr = NULL;
+EFI_BOOT_SERVICES  *gBS;
+EFI_BOOT_SERVICES  mTestBootServices;
+UINTN              mExceptionCount;
+UINT8              *mTestCode;
+UINT8              *mTestStack;
+UINT64             *mTestCopySource;
+UINT64             *mTestCopyDestination;
+
+/**
+  EbcExecute() looks for the EBC simple debugger in DEBUG builds.
+
+  @param  Protocol      Provides the protocol to search for.
+  @param  Registration  Optional registration key.
+  @param  Interface     On return, a pointer to the first interface.
+
+  @retval EFI_NOT_FOUND No debugger is installed.
+
+**/
+EFI_STATUS
+EFIAPI
+TestLocateProtocol (
+  IN  EFI_GUID  *Protocol,
+  IN  VOID      *Registration OPTIONAL,
+  OUT VOID      **Interface
+  )
+{
+  return EFI_NOT_FOUND;
+}
+
+/**
+  Count exceptions signaled by the interpreter. None are expected.
+
+  @param  ExceptionType          Specifies the processor exception detected.
+  @param  ExceptionFlags         Specifies the exception context.
+  @param  VmPtr                  Pointer to a VM context.
+
+  @retval EFI_SUCCESS            This function completed successfully.
+
+**/
+EFI_STATUS
+EbcDebugSignalException (
+  IN EFI_EXCEPTION_TYPE                   ExceptionType,
+  IN EXCEPTION_FLAGS                      ExceptionFlags,
+  IN VM_CONTEXT                           *VmPtr
+  )
+{
+  DEBUG ((DEBUG_ERROR, "EBC exception %d at 0x%p\n", ExceptionType, VmPtr->Ip));
+  mExceptionCount++;
+  VmPtr->StopFlags |= STOPFLAG_APP_DONE;
+  return EFI_SUCCESS;
+}
+
+/**
+  The kernels don't use BREAK 5.
+
+  @param  ImageHandle            The image handle.
+  @param  EbcEntryPoint          Address of the EBC code.
+  @param  Thunk                  Returned thunk.
+  @param  Flags                  Thunk flags.
+
+  @retval EFI_UNSUPPORTED        Thunks are not supported on the host.
+
+**/
+EFI_STATUS
+EbcCreateThunks (
+  IN EFI_HANDLE           ImageHandle,
+  IN VOID                 *EbcEntryPoint,
+  OUT VOID                **Thunk,
+  IN  UINT32              Flags
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+/**
+  The kernels don't call native code.
+
+  @param  VmPtr            Pointer to a VM context.
+  @param  FuncAddr         Callee's address
+  @param  NewStackPointer  New stack pointer after the call
+  @param  FramePtr         New frame pointer after the call
+  @param  Size             The size of call instruction
+
+**/
+VOID
+EbcLLCALLEX (
+  IN VM_CONTEXT   *VmPtr,
+  IN UINTN        FuncAddr,
+  IN UINTN        NewStackPointer,
+  IN VOID         *FramePtr,
+  IN UINT8        Size
+  )
+{
+  EbcDebugSignalException (EXCEPT_EBC_UNDEFINED, EXCEPTION_FLAG_FATAL, VmPtr);
+}
+
+/**
+  Arithmetic loop mixing 32 and 64-bit, signed and unsigned operations,
+  with CMP/CMPI followed by both JMP8 and JMP32.
+
+  @param  Asm     Assembler state.
+
+  @return The entry point of the kernel.
+
+**/
+VMIP
+BuildAluKernel (
+  IN EBC_ASM  *Asm
+  )
+{
+  VMIP   Entry;
+  VMIP   Loop;
+  UINT8  *Skip;
+
+  Entry = Asm->Ptr;
+  EmitMoviqq (Asm, 1, TEST_ALU_ITERATIONS);
+  EmitMoviqw (Asm, 2, 0x1234);
+  EmitMoviqw (Asm, 3, 7);
+  EmitMoviqw (Asm, 4, 1);
+  EmitMoviqq (Asm, 5, 0x9E3779B97F4A7C15ULL);
+  EmitMoviqw (Asm, 7, 0);
+
+  Loop = Asm->Ptr;
+  EmitDataManip (Asm, OPCODE_ADD, TRUE, 2, 3, 0);
+  EmitDataManip (Asm, OPCODE_MUL, TRUE, 2, 5, 0);
+  EmitDataManip (Asm, OPCODE_XOR, TRUE, 2, 1, 0);
+  EmitMov (Asm, OPCODE_MOVQW, 6, FALSE, 2, FALSE);
+  EmitDataManip (Asm, OPCODE_SHR, TRUE, 6, 4, 16);
+  EmitDataManip (Asm, OPCODE_ADD, FALSE, 6, 3, -5);
+  EmitDataManip (Asm, OPCODE_ASHR, FALSE, 6, 4, 0);
+  EmitDataManip (Asm, OPCODE_EXTNDW, TRUE, 6, 6, 0);
+  EmitDataManip (Asm, OPCODE_DIV, FALSE, 6, 4, 2);
+  EmitDataManip (Asm, OPCODE_ADD, TRUE, 7, 6, 0);
+  EmitMov (Asm, OPCODE_MOVBW, 6, FALSE, 2, FALSE);
+  EmitDataManip (Asm, OPCODE_MODU, TRUE, 6, 4, 9);
+  EmitDataManip (Asm, OPCODE_ADD, TRUE, 7, 6, 0);
+  EmitDataManip (Asm, OPCODE_NOT, FALSE, 6, 7, 0);
+  EmitDataManip (Asm, OPCODE_AND, TRUE, 6, 5, 0);
+  EmitDataManip (Asm, OPCODE_XOR, TRUE, 7, 6, 0);
+  EmitCmp (Asm, OPCODE_CMPULTE, TRUE, 6, 7);
+  Skip = EmitJmp8 (Asm, TEST_JMP_CS, Asm->Ptr);
+  EmitDataManip (Asm, OPCODE_ADD, TRUE, 7, 4, 3);
+  PatchJmp8 (Skip, Asm->Ptr);
+  EmitCmp (Asm, OPCODE_CMPLTE, FALSE, 7, 2);
+  EmitJmp8 (Asm, TEST_JMP_CC, Asm->Ptr + 2);
+  EmitDataManip (Asm, OPCODE_SUB, TRUE, 1, 4, 0);
+  EmitCmpi (Asm, OPCODE_CMPIEQ, TRUE, 1, 0);
+  EmitJmp32 (Asm, TEST_JMP_CC, Loop);
+  EmitRet (Asm);
+  return Entry;
+}
+
+/**
+  Memory copy loop using indirect moves.
+
+  @param  Asm     Assembler state.
+
+  @return The entry point of the kernel.
+
+**/
+VMIP
+BuildCopyKernel (
+  IN EBC_ASM  *Asm
+  )
+{
+  VMIP  Entry;
+  VMIP  Outer;
+  VMIP  Inner;
+
+  Entry = Asm->Ptr;
+  EmitMoviqw (Asm, 4, 1);
+  EmitMoviqw (Asm, 5, sizeof (UINT64));
+  EmitMoviqq (Asm, 6, TEST_COPY_ITERATIONS);
+
+  Outer = Asm->Ptr;
+  EmitMoviqq (Asm, 1, (UINT64) (UINTN) mTestCopySource);
+  EmitMoviqq (Asm, 2, (UINT64) (UINTN) mTestCopyDestination);
+  EmitMoviqq (Asm, 3, TEST_COPY_COUNT);
+
+  Inner = Asm->Ptr;
+  EmitMov (Asm, OPCODE_MOVQW, 2, TRUE, 1, TRUE);
+  EmitDataManip (Asm, OPCODE_ADD, TRUE, 1, 5, 0);
+  EmitDataManip (Asm, OPCODE_ADD, TRUE, 2, 5, 0);
+  EmitDataManip (Asm, OPCODE_SUB, TRUE, 3, 4, 0);
+  EmitCmpi (Asm, OPCODE_CMPIUGTE, TRUE, 3, 1);
+  EmitJmp8 (Asm, TEST_JMP_CS, Inner);
+
+  EmitDataManip (Asm, OPCODE_SUB, TRUE, 6, 4, 0);
+  EmitCmpi (Asm, OPCODE_CMPIEQ, TRUE, 6, 0);
+  EmitJmp8 (Asm, TEST_JMP_CC, Outer);
+  EmitRet (Asm);
+  return Entry;
+}
+
+/**
+  Call/return loop using relative, absolute and register calls.
+
+  @param  Asm     Assembler state.
+
+  @return The entry point of the kernel.
+
+**/
+VMIP
+BuildCallKernel (
+  IN EBC_ASM  *Asm
+  )
+{
+  VMIP  Function;
+  VMIP  Entry;
+  VMIP  Loop;
+
+  Function = Asm->Ptr;
+  EmitDataManip (Asm, OPCODE_ADD, TRUE, 7, 4, 0);
+  EmitDataManip (Asm, OPCODE_XOR, TRUE, 7, 1, 0);
+  EmitRet (Asm);
+
+  Entry = Asm->Ptr;
+  EmitMoviqq (Asm, 1, TEST_CALL_ITERATIONS);
+  EmitMoviqw (Asm, 4, 1);
+  EmitMoviqw (Asm, 7, 0);
+
+  Loop = Asm->Ptr;
+  EmitCall32Relative (Asm, Function);
+  EmitCall64 (Asm, Function);
+  EmitMoviqq (Asm, 6, (UINT64) (UINTN) Function);
+  EmitCallRegister (Asm, 6);
+  EmitDataManip (Asm, OPCODE_SUB, TRUE, 1, 4, 0);
+  EmitCmpi (Asm, OPCODE_CMPIEQ, TRUE, 1, 0);
+  EmitJmp8 (Asm, TEST_JMP_CC, Loop);
+  EmitRet (Asm);
+  return Entry;
+}
+
+/**
+  Run a kernel from its entry point to the final RET.
+
+  @param  Entry             Entry point of the kernel.
+  @param  Mode              How to run the kernel.
+  @param  VmPtr             Receives the final VM state.
+  @param  InstructionCount  Receives the number of instructions executed, only
+                            counted in TestModeStep.
+
+  @return The run time in clock ticks.
+
+**/
+clock_t
+RunKernel (
+  IN  VMIP        Entry,
+  IN  TEST_MODE   Mode,
+  OUT VM_CONTEXT  *VmPtr,
+  OUT UINT64      *InstructionCount
+  )
+{
+  clock_t  Start;
+  UINTN    Count;
+
+  //
+  // Same stack layout as ExecuteEbcImageEntryPoint().
+  //
+  ZeroMem (VmPtr, sizeof (VM_CONTEXT));
+  VmPtr->Ip              = Entry;
+  VmPtr->StackPool       = mTestStack;
+  VmPtr->StackTop        = mTestStack;
+  VmPtr->Gpr[0]          = (UINT64) (UINTN) (mTestStack + TEST_STACK_SIZE);
+  VmPtr->HighStackBottom = (UINTN) VmPtr->Gpr[0];
+  VmPtr->Gpr[0]         -= sizeof (UINTN);
+  *(UINTN *) (UINTN) VmPtr->Gpr[0] = (UINTN) VM_STACK_KEY_VALUE;
+  VmPtr->StackMagicPtr   = (UINTN *) (UINTN) VmPtr->Gpr[0];
+  VmPtr->LowStackTop     = (UINTN) VmPtr->Gpr[0];
+  VmPtr->Gpr[0]         -= 2 * sizeof (UINT64);
+  VmPtr->StackRetAddr    = (UINT64) VmPtr->Gpr[0];
+  VmPtr->FramePtr        = (VOID *) (UINTN) (VmPtr->Gpr[0] + 8);
+
+  mExceptionCount   = 0;
+  *InstructionCount = 0;
+
+  if (Mode == TestModeOpcodeTable) {
+    FreeEbcDecodeCache ();
+  } else if (Mode == TestModeThreaded) {
+    InitEbcDecodeCache ();
+  }
+
+  Start = clock ();
+  if (Mode == TestModeStep) {
+    while ((VmPtr->StopFlags & STOPFLAG_APP_DONE) == 0) {
+      Count = 1;
+      if (EFI_ERROR (EbcExecuteInstructions (NULL, VmPtr, &Count))) {
+        break;
+      }
+
+      *InstructionCount += Count;
+    }
+  } else {
+    EbcExecute (VmPtr);
+  }
+
+  return clock () - Start;
+}
+
+/**
+  Compare the architectural state of two VM contexts.
+
+  @param  Expected    State after TestModeStep.
+  @param  Actual      State after another mode.
+
+  @retval TRUE        The states match.
+
+**/
+BOOLEAN
+CompareVmState (
+  IN VM_CONTEXT  *Expected,
+  IN VM_CONTEXT  *Actual
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < ARRAY_SIZE (Expected->Gpr); Index++) {
+    if (Expected->Gpr[Index] != Actual->Gpr[Index]) {
+      DEBUG ((DEBUG_ERROR, "R%d: expected 0x%lx, got 0x%lx\n", Index, Expected->Gpr[Index], Actual->Gpr[Index]));
+      return FALSE;
+    }
+  }
+
+  return (BOOLEAN) ((Expected->Ip == Actual->Ip) &&
+                    ((Expected->Flags & VMFLAGS_CC) == (Actual->Flags & VMFLAGS_CC)));
+}
+
+/**
+  Report the instruction rate of a run.
+
+**/
+VOID
+ReportRate (
+  IN CHAR8    *Name,
+  IN CHAR8    *Mode,
+  IN UINT64   InstructionCount,
+  IN clock_t  Ticks
+  )
+{
+  if (Ticks == 0) {
+    Ticks = 1;
+  }
+
+  DEBUG ((
+    DEBUG_INFO,
+    "%a: %a %ld instructions in %ld ms, %ld instructions/s\n",
+    Name,
+    Mode,
+    InstructionCount,
+    (UINT64) Ticks * 1000 / CLOCKS_PER_SEC,
+    DivU64x64Remainder (InstructionCount * CLOCKS_PER_SEC, (UINT64) Ticks, NULL)
+    ));
+}
+
+/**
+  Run a kernel in every mode, check that the results agree and report the
+  instruction rate of each mode.
+
+  @param[in]  Context    The TEST_KERNEL to run.
+
+  @retval  UNIT_TEST_PASSED             The results match.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A mode produced a different result.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+KernelShouldMatchReference (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  TEST_KERNEL  *Kernel;
+  EBC_ASM      Asm;
+  VMIP         Entry;
+  VM_CONTEXT   Expected;
+  VM_CONTEXT   Actual;
+  UINT64       InstructionCount;
+  UINT64       Unused;
+  clock_t      Ticks;
+  UINTN        Index;
+
+  Kernel = (TEST_KERNEL *) Context;
+  Asm.Ptr = mTestCode;
+  Entry = Kernel->Build (&Asm);
+  UT_ASSERT_TRUE ((UINTN) (Asm.Ptr - mTestCode) <= TEST_CODE_SIZE);
+  FlushEbcDecodeCache ();
+
+  for (Index = 0; Index < TEST_COPY_COUNT; Index++) {
+    mTestCopySource[Index] = MultU64x32 (0x0123456789ABCDEFULL, (UINT32) Index + 1);
+  }
+
+  ZeroMem (mTestCopyDestination, TEST_COPY_COUNT * sizeof (UINT64));
+  Ticks = RunKernel (Entry, TestModeStep, &Expected, &InstructionCount);
+  UT_ASSERT_EQUAL (mExceptionCount, 0);
+  ReportRate (Kernel->Name, "single step ", InstructionCount, Ticks);
+
+  ZeroMem (mTestCopyDestination, TEST_COPY_COUNT * sizeof (UINT64));
+  Ticks = RunKernel (Entry, TestModeOpcodeTable, &Actual, &Unused);
+  UT_ASSERT_EQUAL (mExceptionCount, 0);
+  UT_ASSERT_TRUE (CompareVmState (&Expected, &Actual));
+  ReportRate (Kernel->Name, "opcode table", InstructionCount, Ticks);
+
+  ZeroMem (mTestCopyDestination, TEST_COPY_COUNT * sizeof (UINT64));
+  Ticks = RunKernel (Entry, TestModeThreaded, &Actual, &Unused);
+  UT_ASSERT_EQUAL (mExceptionCount, 0);
+  UT_ASSERT_TRUE (CompareVmState (&Expected, &Actual));
+  ReportRate (Kernel->Name, "threaded    ", InstructionCount, Ticks);
+
+  if (Kernel->CopiesMemory) {
+    UT_ASSERT_MEM_EQUAL (mTestCopyDestination, mTestCopySource, TEST_COPY_COUNT * sizeof (UINT64));
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Modify the immediate data of an instruction that is already decoded and
+  check that FlushEbcDecodeCache() makes the interpreter pick it up.
+
+  @param[in]  Context    Unused.
+
+  @retval  UNIT_TEST_PASSED             The modified code was executed.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A stale decoded instruction was used.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+FlushShouldDropDecodedInstructions (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EBC_ASM     Asm;
+  VMIP        Entry;
+  VM_CONTEXT  Before;
+  VM_CONTEXT  Expected;
+  VM_CONTEXT  Actual;
+  UINT64      Unused;
+
+  Asm.Ptr = mTestCode;
+  Entry = BuildAluKernel (&Asm);
+  FlushEbcDecodeCache ();
+  RunKernel (Entry, TestModeThreaded, &Before, &Unused);
+
+  //
+  // The third instruction is MOVIqw R3, 7.
+  //
+  UT_ASSERT_EQUAL (ReadUnaligned16 ((UINT16 *) (Entry + 10 + 4 + 2)), 7);
+  WriteUnaligned16 ((UINT16 *) (Entry + 10 + 4 + 2), 9);
+  FlushEbcDecodeCache ();
+
+  RunKernel (Entry, TestModeStep, &Expected, &Unused);
+  RunKernel (Entry, TestModeThreaded, &Actual, &Unused);
+  UT_ASSERT_EQUAL (mExceptionCount, 0);
+  UT_ASSERT_TRUE (CompareVmState (&Expected, &Actual));
+  UT_ASSERT_NOT_EQUAL (Before.Gpr[7], Actual.Gpr[7]);
+  return UNIT_TEST_PASSED;
+}
+
+TEST_KERNEL  mAluKernel  = { "ALU",  BuildAluKernel,  FALSE };
+TEST_KERNEL  mCopyKernel = { "Copy", BuildCopyKernel, TRUE  };
+TEST_KERNEL  mCallKernel = { "Call", BuildCallKernel, FALSE };
+
+/**
+  Initialze the unit test framework, suite, and unit tests for the EBC
+  interpreter and run them.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      ThreadedCodeTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  mTestBootServices.LocateProtocol = TestLocateProtocol;
+  gBS                  = &mTestBootServices;
+  mTestCode            = AllocateZeroPool (TEST_CODE_SIZE);
+  mTestStack           = AllocateZeroPool (TEST_STACK_SIZE);
+  mTestCopySource      = AllocateZeroPool (TEST_COPY_COUNT * sizeof (UINT64));
+  mTestCopyDestination = AllocateZeroPool (TEST_COPY_COUNT * sizeof (UINT64));
+  if ((mTestCode == NULL) || (mTestStack == NULL) ||
+      (mTestCopySource == NULL) || (mTestCopyDestination == NULL)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&ThreadedCodeTests, Framework, "EBC Threaded Code Tests", "EbcDxe.ThreadedCode", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for EBC Threaded Code Tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  //
+  // --------------Suite---------------Description-------------------------Name---------Function----------------------------Pre---Post---Context-----------
+  //
+  AddTestCase (ThreadedCodeTests, "ALU kernel matches single step",      "Alu",       KernelShouldMatchReference,         NULL, NULL, &mAluKernel);
+  AddTestCase (ThreadedCodeTests, "Copy kernel matches single step",     "Copy",      KernelShouldMatchReference,         NULL, NULL, &mCopyKernel);
+  AddTestCase (ThreadedCodeTests, "Call kernel matches single step",     "Call",      KernelShouldMatchReference,         NULL, NULL, &mCallKernel);
+  AddTestCase (ThreadedCodeTests, "Flush drops decoded instructions",    "Flush",     FlushShouldDropDecodedInstructions, NULL, NULL, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  FreeEbcDecodeCache ();
+  return Status;
+}
+
+///
+/// Avoid ECC error for function name that starts with lower case letter
+///
+#define EbcThreadedCodeUnitTestMain main
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+  @param[in] Argc  Number of arguments
+  @param[in] Argv  Array of pointers to arguments
+
+  @retval 0      Success
+  @retval other  Error
+**/
+INT32
+EbcThreadedCodeUnitTestMain (
+  IN INT32  Argc,
+  IN CHAR8  *Argv[]
+  )
+{
+  UnitTestingEntry ();
+  return 0;
+}
@@ -0,0 +1,1178 @@
+/** @file
+  Compiles hot EBC code to native x64 code.
+
+  EbcExecute() asks EbcJitExecute() to run the instruction at VmPtr->Ip.
+  Instruction addresses that the interpreter reaches often enough are
+  compiled to a native block, starting at that address and following the
+  code linearly through conditional jumps. A block is built from the same
+  pre-decoded instructions that the interpreter caches, and stops at the
+  first instruction it does not handle, such as CALL, RET or anything that
+  may raise an exception. On exit the block stores the address of the next
+  instruction in VmPtr->Ip, and the interpreter takes over from there.
+
+  Blocks keep the EBC registers and flags in the VM context, so the VM state
+  is always exactly what the interpreter would have produced when a block
+  returns. Jumps to instructions inside the same block, such as the back
+  edge of a loop, stay in native code.
+
+  The interpreter checks the VM stack after every instruction. A block leaves
+  right after an instruction that writes R0 or memory if the stack pointer
+  is at or below the stack top or the stack magic value is gone, so that
+  EbcExecute() reports the stack fault at the same instruction. Blocks are
+  not run while single-stepping or while the debugger hooks are enabled.
+
+  The code buffer is only writable while a block is compiled and is read-only
+  executable otherwise, using the CPU architectural protocol. Nothing is
+  compiled until that protocol is available.
+
+Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "EbcInt.h"
+#include "EbcExecute.h"
+#include "EbcDebuggerHook.h"
+
+#include <Protocol/Cpu.h>
+#include <Library/PcdLib.h>
+
+//
+// Number of entries in the table of hot instruction addresses. Must be a
+// power of 2.
+//
+#define EBC_JIT_TABLE_SIZE              512
+
+//
+// Number of times the interpreter has to reach an address before it is
+// compiled.
+//
+#define EBC_JIT_HOT_THRESHOLD           32
+
+//
+// Count value of addresses that can not start a block.
+//
+#define EBC_JIT_NOT_COMPILABLE          MAX_UINT32
+
+//
+// Size of the native code buffer. When it is full, all blocks are dropped
+// and compilation starts over.
+//
+#define EBC_JIT_CODE_PAGES              16
+
+//
+// Limits for one block. EBC_JIT_MAX_INSTRUCTION_CODE is larger than the
+// code emitted for any single EBC instruction including its stack check,
+// and EBC_JIT_EXIT_SIZE is the size of the code that leaves a block.
+//
+#define EBC_JIT_MAX_INSTRUCTIONS        64
+#define EBC_JIT_MAX_INSTRUCTION_CODE    128
+#define EBC_JIT_EXIT_SIZE               18
+#define EBC_JIT_MIN_FREE_SPACE          (EBC_JIT_MAX_INSTRUCTIONS * (EBC_JIT_MAX_INSTRUCTION_CODE + EBC_JIT_EXIT_SIZE))
+
+//
+// x64 registers used by the generated code. The VM context pointer is
+// moved from RCX to R11 on entry, so that CL is free for shift counts.
+//
+#define JIT_RAX                         0
+#define JIT_RCX                         1
+#define JIT_RDX                         2
+#define JIT_R8                          8
+#define JIT_R11                         11
+
+#define JIT_GPR_OFFSET(Index)           ((UINT32) (OFFSET_OF (VM_CONTEXT, Gpr) + (Index) * sizeof (VM_REGISTER)))
+#define JIT_FLAGS_OFFSET                ((UINT32) OFFSET_OF (VM_CONTEXT, Flags))
+#define JIT_IP_OFFSET                   ((UINT32) OFFSET_OF (VM_CONTEXT, Ip))
+#define JIT_STACK_TOP_OFFSET            ((UINT32) OFFSET_OF (VM_CONTEXT, StackTop))
+#define JIT_STACK_MAGIC_PTR_OFFSET      ((UINT32) OFFSET_OF (VM_CONTEXT, StackMagicPtr))
+
+//
+// x64 condition codes, as used by SETcc and Jcc.
+//
+#define JIT_CC_BE                       0x6
+#define JIT_CC_AE                       0x3
+#define JIT_CC_E                        0x4
+#define JIT_CC_NE                       0x5
+#define JIT_CC_LE                       0xE
+#define JIT_CC_GE                       0xD
+
+/**
+  A compiled block.
+
+  @param  VmPtr             A pointer to a VM context whose Ip is the start
+                            of the block.
+
+**/
+typedef
+VOID
+(EFIAPI *EBC_JIT_BLOCK) (
+  IN VM_CONTEXT  *VmPtr
+  );
+
+typedef struct {
+  VMIP           Ip;
+  UINTN          Generation;
+  UINT32         Count;       // times the interpreter reached Ip
+  EBC_JIT_BLOCK  Block;       // NULL until compiled
+} EBC_JIT_ENTRY;
+
+//
+// Native code of an instruction in the block being compiled.
+//
+typedef struct {
+  VMIP   Ip;
+  UINT8  *Code;
+} EBC_JIT_LABEL;
+
+//
+// A jump to an instruction that has not been compiled yet.
+//
+typedef struct {
+  VMIP   Target;
+  UINT8  *Rel32;
+} EBC_JIT_FIXUP;
+
+typedef struct {
+  UINT8          *Ptr;
+  UINT8          *End;
+  UINTN          LabelCount;
+  EBC_JIT_LABEL  Labels[EBC_JIT_MAX_INSTRUCTIONS];
+  UINTN          FixupCount;
+  EBC_JIT_FIXUP  Fixups[EBC_JIT_MAX_INSTRUCTIONS];
+} EBC_JIT_COMPILER;
+
+EBC_JIT_ENTRY          *mEbcJitTable = NULL;
+UINT8                  *mEbcJitCode = NULL;
+UINTN                  mEbcJitCodeUsed;
+EFI_CPU_ARCH_PROTOCOL  *mEbcJitCpu = NULL;
+
+//
+// Bumped each time all blocks are dropped. Entries are allocated zeroed,
+// so generation 0 is never valid.
+//
+UINTN                  mEbcJitGeneration = 1;
+
+//
+// Blocks are only compiled and run by EbcExecute() while it owns the
+// decoded instruction cache, so a single compiler state is enough.
+//
+EBC_JIT_COMPILER       mEbcJitCompiler;
+
+/**
+  Emit a byte.
+
+  @param  Jit               The compiler state.
+  @param  Byte              The byte to emit.
+
+**/
+VOID
+JitEmit8 (
+  IN EBC_JIT_COMPILER  *Jit,
+  IN UINT8             Byte
+  )
+{
+  *Jit->Ptr++ = Byte;
+}
+
+/**
+  Emit a 32-bit value.
+
+  @param  Jit               The compiler state.
+  @param  Value             The value to emit.
+
+**/
+VOID
+JitEmit32 (
+  IN EBC_JIT_COMPILER  *Jit,
+  IN UINT32            Value
+  )
+{
+  WriteUnaligned32 ((UINT32 *) Jit->Ptr, Value);
+  Jit->Ptr += sizeof (UINT32);
+}
+
+/**
+  Emit a 64-bit value.
+
+  @param  Jit               The compiler state.
+  @param  Value             The value to emit.
+
+**/
+VOID
+JitEmit64 (
+  IN EBC_JIT_COMPILER  *Jit,
+  IN UINT64            Value
+  )
+{
+  WriteUnaligned64 ((UINT64 *) Jit->Ptr, Value);
+  Jit->Ptr += sizeof (UINT64);
+}
+
+/**
+  Emit a REX prefix if one is needed.
+
+  @param  Jit               The compiler state.
+  @param  Wide              TRUE for a 64-bit operand size.
+  @param  Reg               The register in the ModRM reg field.
+  @param  Rm                The register in the ModRM r/m field.
+
+**/
+VOID
+JitEmitRex (
+  IN EBC_JIT_COMPILER  *Jit,
+  IN BOOLEAN           Wide,
+  IN UINT8             Reg,
+  IN UINT8             Rm
+  )
+{
+  UINT8  Rex;
+
+  Rex = (UINT8) ((Wide ? BIT3 : 0) | ((Reg >= 8) ? BIT2 : 0) | ((Rm >= 8) ? BIT0 : 0));
+  if (Rex != 0) {
+    JitEmit8 (Jit, (UINT8) (0x40 | Rex));
+  }
+}
+
+/**
+  Emit an instruction with a register operand and a register or memory
+  operand.
+
+  @param  Jit               The compiler state.
+  @param  Wide              TRUE for a 64-bit operand size.
+  @param  Opcode            The opcode bytes, first byte in bits 7:0.
+  @param  OpcodeLength      Number of opcode bytes.
+  @param  Reg               The register in the ModRM reg field, or the
+                            opcode extension.
+  @param  Rm                The register in the ModRM r/m field.
+  @param  Memory            TRUE to address memory at [Rm], or at
+                            [Rm + Disp] if Rm is R11.
+  @param  Disp              The displacement from R11.
+
+**/
+VOID
+JitEmitModRm (
+  IN EBC_JIT_COMPILER  *Jit,
+  IN BOOLEAN           Wide,
+  IN UINT32            Opcode,
+  IN UINTN             OpcodeLength,
+  IN UINT8             Reg,
+  IN UINT8             Rm,
+  IN BOOLEAN           Memory,
+  IN UINT32            Disp
+  )
+{
+  JitEmitRex (Jit, Wide, Reg, Rm);
+  while (OpcodeLength-- > 0) {
+    JitEmit8 (Jit, (UINT8) Opcode);
+    Opcode >>= 8;
+  }
+
+  if (!Memory) {
+    JitEmit8 (Jit, (UINT8) (0xC0 | ((Reg & 7) << 3) | (Rm & 7)));
+  } else if (Rm == JIT_R11) {
+    JitEmit8 (Jit, (UINT8) (0x80 | ((Reg & 7) << 3) | (Rm & 7)));
+    JitEmit32 (Jit, Disp);
+  } else {
+    ASSERT ((Rm & 7) != 4 && (Rm & 7) != 5);
+    JitEmit8 (Jit, (UINT8) (((Reg & 7) << 3) | (Rm & 7)));
+  }
+}
+
+/**
+  Emit MOV Reg, Gpr[Index].
+
+  @param  Jit               The compiler state.
+  @param  Reg               The x64 register to load.
+  @param  Index             The EBC register.
+
+**/
+VOID
+JitEmitLoadGpr (
+  IN EBC_JIT_COMPILER  *Jit,
+  IN UINT8             Reg,
+  IN UINT8             Index
+  )
+{
+  JitEmitModRm (Jit, TRUE, 0x8B, 1, Reg, JIT_R11, TRUE, JIT_GPR_OFFSET (Index));
+}
+
+/**
+  Emit MOV Gpr[Index], Reg.
+
+  @param  Jit               The compiler state.
+  @param  Index             The EBC register.
+  @param  Reg               The x64 register to store.
+
+**/
+VOID
+JitEmitStoreGpr (
+  IN EBC_JIT_COMPILER  *Jit,
+  IN UINT8             Index,
+  IN UINT8             Reg
+  )
+{
+  JitEmitModRm (Jit, TRUE, 0x89, 1, Reg, JIT_R11, TRUE, JIT_GPR_OFFSET (Index));
+}
+
+/**
+  Emit MOV Reg, Value.
+
+  @param  Jit               The compiler state.
+  @param  Reg               The x64 register to load.
+  @param  Value             The value.
+
+**/
+VOID
+JitEmitLoadImmediate (
+  IN EBC_JIT_COMPILER  *Jit,
+  IN UINT8             Reg,
+  IN UINT64            Value
+  )
+{
+  JitEmitRex (Jit, TRUE, 0, Reg);
+  JitEmit8 (Jit, (UINT8) (0xB8 | (Reg & 7)));
+  JitEmit64 (Jit, Value);
+}
+
+/**
+  Emit ADD Reg, Value, using R8 for values that do not fit a sign-extended
+  32-bit immediate. Nothing is emitted if Value is zero.
+
+  @param  Jit               The compiler state.
+  @param  Reg               The x64 register to add to.
+  @param  Value             The value.
+
+**/
+VOID
+JitEmitAddImmediate (
+  IN EBC_JIT_COMPILER  *Jit,
+  IN UINT8             Reg,
+  IN UINT64            Value
+  )
+{
+  if (Value == 0) {
+    return;
+  }
+
+  if ((INT64) Value == (INT64) (INT32) Value) {
+    JitEmitModRm (Jit, TRUE, 0x81, 1, 0, Reg, FALSE, 0);
+    JitEmit32 (Jit, (UINT32) Value);
+  } else {
+    JitEmitLoadImmediate (Jit, JIT_R8, Value);
+    JitEmitModRm (Jit, TRUE, 0x01, 1, JIT_R8, Reg, FALSE, 0);
+  }
+}
+
+/**
+  Emit code that leaves the block with VmPtr->Ip set to Ip.
+
+  @param  Jit               The compiler state.
+  @param  Ip                The next instruction for the interpreter.
+
+**/
+VOID
+JitEmitExit (
+  IN EBC_JIT_COMPILER  *Jit,
+  IN VMIP              Ip
+  )
+{
+  JitEmitLoadImmediate (Jit, JIT_RAX, (UINT64) (UINTN) Ip);
+  JitEmitModRm (Jit, TRUE, 0x89, 1, JIT_RAX, JIT_R11, TRUE, JIT_IP_OFFSET);
+  JitEmit8 (Jit, 0xC3);
+}
+
+/**
+  Emit code that leaves the block with VmPtr->Ip set to Ip if the x64
+  condition is true.
+
+  @param  Jit               The compiler state.
+  @param  Condition         An x64 condition code.
+  @param  Ip                The next instruction for the interpreter.
+
+**/
+VOID
+JitEmitExitIf (
+  IN EBC_JIT_COMPILER  *Jit,
+  IN UINT8             Condition,
+  IN VMIP              Ip
+  )
+{
+  //
+  // Jcc rel8 with the inverted condition, over the exit.
+  //
+  JitEmit8 (Jit, (UINT8) (0x70 | (Condition ^ 1)));
+  JitEmit8 (Jit, EBC_JIT_EXIT_SIZE);
+  JitEmitExit (Jit, Ip);
+}
+
+/**
+  Emit the stack checks EbcExecute() does after an instruction, leaving the
+  block with VmPtr->Ip set to the next instruction if one of them fails.
+
+  @param  Jit               The compiler state.
+  @param  WritesMemory      TRUE if the instruction writes memory, which
+                            may overwrite the stack magic value.
+  @param  Ip                The next instruction for the interpreter.
+
+**/
+VOID
+JitEmitStackCheck (
+  IN EBC_JIT_COMPILER  *Jit,
+  IN BOOLEAN           WritesMemory,
+  IN VMIP              Ip
+  )
+{
+  if (WritesMemory) {
+    //
+    // MOV RDX, [R11 + StackMagicPtr]; CMP [RDX], VM_STACK_KEY_VALUE
+    //
+    JitEmitModRm (Jit, TRUE, 0x8B, 1, JIT_RDX, JIT_R11, TRUE, JIT_STACK_MAGIC_PTR_OFFSET);
+    JitEmitLoadImmediate (Jit, JIT_RAX, (UINT64) VM_STACK_KEY_VALUE);
+    JitEmitModRm (Jit, TRUE, 0x39, 1, JIT_RAX, JIT_RDX, TRUE, 0);
+    JitEmitExitIf (Jit, JIT_CC_NE, Ip);
+  } else {
+    //
+    // MOV RAX, Gpr[0]; CMP RAX, [R11 + StackTop]
+    //
+    JitEmitLoadGpr (Jit, JIT_RAX, 0);
+    JitEmitModRm (Jit, TRUE, 0x3B, 1, JIT_RAX, JIT_R11, TRUE, JIT_STACK_TOP_OFFSET);
+    JitEmitExitIf (Jit, JIT_CC_BE, Ip);
+  }
+}
+
+/**
+  Emit a jump to an EBC instruction. Instructions already compiled into the
+  block are jumped to directly, and other targets are fixed up when they are
+  compiled or when the block is finished.
+
+  @param  Jit               The compiler state.
+  @param  Condition         An x64 condition code, or MAX_UINT8 for an
+                            unconditional jump.
+  @param  Target            The target EBC instruction.
+
+**/
+VOID
+JitEmitJump (
+  IN EBC_JIT_COMPILER  *Jit,
+  IN UINT8             Condition,
+  IN VMIP              Target
+  )
+{
+  UINTN  Index;
+  UINT8  *Code;
+
+  if (Condition == MAX_UINT8) {
+    JitEmit8 (Jit, 0xE9);
+  } else {
+    JitEmit8 (Jit, 0x0F);
+    JitEmit8 (Jit, (UINT8) (0x80 | Condition));
+  }
+
+  Code = NULL;
+  for (Index = 0; Index < Jit->LabelCount; Index++) {
+    if (Jit->Labels[Index].Ip == Target) {
+      Code = Jit->Labels[Index].Code;
+      break;
+    }
+  }
+
+  if (Code == NULL) {
+    ASSERT (Jit->FixupCount < EBC_JIT_MAX_INSTRUCTIONS);
+    Jit->Fixups[Jit->FixupCount].Target = Target;
+    Jit->Fixups[Jit->FixupCount].Rel32  = Jit->Ptr;
+    Jit->FixupCount++;
+    Code = Jit->Ptr + sizeof (UINT32);
+  }
+
+  JitEmit32 (Jit, (UINT32) (Code - (Jit->Ptr + sizeof (UINT32))));
+}
+
+/**
+  Point the pending jumps to Target at the current position of the block.
+
+  @param  Jit               The compiler state.
+  @param  Target            The EBC instruction about to be compiled.
+
+**/
+VOID
+JitResolveFixups (
+  IN EBC_JIT_COMPILER  *Jit,
+  IN VMIP              Target
+  )
+{
+  UINTN  Index;
+
+  Index = 0;
+  while (Index < Jit->FixupCount) {
+    if (Jit->Fixups[Index].Target == Target) {
+      WriteUnaligned32 (
+        (UINT32 *) Jit->Fixups[Index].Rel32,
+        (UINT32) (Jit->Ptr - (Jit->Fixups[Index].Rel32 + sizeof (UINT32)))
+        );
+      Jit->Fixups[Index] = Jit->Fixups[--Jit->FixupCount];
+    } else {
+      Index++;
+    }
+  }
+}
+
+/**
+  Compile a MOVxx instruction, following VmThreadedMove() and
+  VmThreadedMoveMemory().
+
+  @param  Jit               The compiler state.
+  @param  Decoded           The decoded instruction.
+
+**/
+VOID
+JitCompileMove (
+  IN EBC_JIT_COMPILER              *Jit,
+  IN CONST VM_DECODED_INSTRUCTION  *Decoded
+  )
+{
+  //
+  // Source into RAX, zero extended from the move size when it is read from
+  // memory.
+  //
+  if (OPERAND2_INDIRECT (Decoded->Operands)) {
+    JitEmitLoadGpr (Jit, JIT_RDX, Decoded->Operand2);
+    JitEmitAddImmediate (Jit, JIT_RDX, Decoded->Data);
+    switch (Decoded->MoveSize) {
+    case sizeof (UINT8):
+      JitEmitModRm (Jit, FALSE, 0xB60F, 2, JIT_RAX, JIT_RDX, TRUE, 0);
+      break;
+
+    case sizeof (UINT16):
+      JitEmitModRm (Jit, FALSE, 0xB70F, 2, JIT_RAX, JIT_RDX, TRUE, 0);
+      break;
+
+    case sizeof (UINT32):
+      JitEmitModRm (Jit, FALSE, 0x8B, 1, JIT_RAX, JIT_RDX, TRUE, 0);
+      break;
+
+    default:
+      JitEmitModRm (Jit, TRUE, 0x8B, 1, JIT_RAX, JIT_RDX, TRUE, 0);
+      break;
+    }
+  } else {
+    JitEmitLoadGpr (Jit, JIT_RAX, Decoded->Operand2);
+    JitEmitAddImmediate (Jit, JIT_RAX, Decoded->Data);
+  }
+
+  if (OPERAND1_INDIRECT (Decoded->Operands)) {
+    JitEmitLoadGpr (Jit, JIT_RDX, Decoded->Operand1);
+    JitEmitAddImmediate (Jit, JIT_RDX, Decoded->Index);
+    switch (Decoded->MoveSize) {
+    case sizeof (UINT8):
+      JitEmitModRm (Jit, FALSE, 0x88, 1, JIT_RAX, JIT_RDX, TRUE, 0);
+      break;
+
+    case sizeof (UINT16):
+      JitEmit8 (Jit, 0x66);
+      JitEmitModRm (Jit, FALSE, 0x89, 1, JIT_RAX, JIT_RDX, TRUE, 0);
+      break;
+
+    case sizeof (UINT32):
+      JitEmitModRm (Jit, FALSE, 0x89, 1, JIT_RAX, JIT_RDX, TRUE, 0);
+      break;
+
+    default:
+      JitEmitModRm (Jit, TRUE, 0x89, 1, JIT_RAX, JIT_RDX, TRUE, 0);
+      break;
+    }
+
+    return;
+  }
+
+  if (Decoded->Mask == 0xFF) {
+    JitEmitModRm (Jit, FALSE, 0xB60F, 2, JIT_RAX, JIT_RAX, FALSE, 0);
+  } else if (Decoded->Mask == 0xFFFF) {
+    JitEmitModRm (Jit, FALSE, 0xB70F, 2, JIT_RAX, JIT_RAX, FALSE, 0);
+  } else if (Decoded->Mask == 0xFFFFFFFF) {
+    JitEmitModRm (Jit, FALSE, 0x89, 1, JIT_RAX, JIT_RAX, FALSE, 0);
+  }
+
+  JitEmitStoreGpr (Jit, Decoded->Operand1, JIT_RAX);
+}
+
+/**
+  Compile a data manipulation instruction, following VmThreadedDataManip().
+  The 32-bit forms use 32-bit x64 instructions, which clear bits 63:32 of
+  the result just like the interpreter does.
+
+  @param  Jit               The compiler state.
+  @param  Decoded           The decoded instruction.
+
+  @retval TRUE              The instruction was compiled.
+  @retval FALSE             The instruction may raise an exception and must
+                            be left to the interpreter.
+
+**/
+BOOLEAN
+JitCompileDataManip (
+  IN EBC_JIT_COMPILER              *Jit,
+  IN CONST VM_DECODED_INSTRUCTION  *Decoded
+  )
+{
+  BOOLEAN  Wide;
+
+  Wide = Decoded->Is64Bit;
+
+  //
+  // Op1 in RAX, Op2 in RDX.
+  //
+  JitEmitLoadGpr (Jit, JIT_RAX, Decoded->Operand1);
+  JitEmitLoadGpr (Jit, JIT_RDX, Decoded->Operand2);
+  JitEmitAddImmediate (Jit, JIT_RDX, Decoded->Data);
+
+  switch (Decoded->Opcode) {
+  case OPCODE_NOT:
+    JitEmitModRm (Jit, Wide, 0x8B, 1, JIT_RAX, JIT_RDX, FALSE, 0);
+    JitEmitModRm (Jit, Wide, 0xF7, 1, 2, JIT_RAX, FALSE, 0);
+    break;
+
+  case OPCODE_NEG:
+    JitEmitModRm (Jit, Wide, 0x8B, 1, JIT_RAX, JIT_RDX, FALSE, 0);
+    JitEmitModRm (Jit, Wide, 0xF7, 1, 3, JIT_RAX, FALSE, 0);
+    break;
+
+  case OPCODE_ADD:
+    JitEmitModRm (Jit, Wide, 0x01, 1, JIT_RDX, JIT_RAX, FALSE, 0);
+    break;
+
+  case OPCODE_SUB:
+    JitEmitModRm (Jit, Wide, 0x29, 1, JIT_RDX, JIT_RAX, FALSE, 0);
+    break;
+
+  case OPCODE_MUL:
+  case OPCODE_MULU:
+    //
+    // The low half of the product does not depend on signedness.
+    //
+    JitEmitModRm (Jit, Wide, 0xAF0F, 2, JIT_RAX, JIT_RDX, FALSE, 0);
+    break;
+
+  case OPCODE_AND:
+    JitEmitModRm (Jit, Wide, 0x21, 1, JIT_RDX, JIT_RAX, FALSE, 0);
+    break;
+
+  case OPCODE_OR:
+    JitEmitModRm (Jit, Wide, 0x09, 1, JIT_RDX, JIT_RAX, FALSE, 0);
+    break;
+
+  case OPCODE_XOR:
+    JitEmitModRm (Jit, Wide, 0x31, 1, JIT_RDX, JIT_RAX, FALSE, 0);
+    break;
+
+  case OPCODE_SHL:
+  case OPCODE_SHR:
+  case OPCODE_ASHR:
+    //
+    // MOV RCX, RDX, then SHL/SHR/SAR RAX, CL. The count is masked to the
+    // operand size, as for the shifts the interpreter is compiled to.
+    //
+    JitEmitModRm (Jit, TRUE, 0x8B, 1, JIT_RCX, JIT_RDX, FALSE, 0);
+    JitEmitModRm (
+      Jit,
+      Wide,
+      0xD3,
+      1,
+      (UINT8) ((Decoded->Opcode == OPCODE_SHL) ? 4 : (Decoded->Opcode == OPCODE_SHR) ? 5 : 7),
+      JIT_RAX,
+      FALSE,
+      0
+      );
+    break;
+
+  case OPCODE_EXTNDB:
+    JitEmitModRm (Jit, Wide, 0xBE0F, 2, JIT_RAX, JIT_RDX, FALSE, 0);
+    break;
+
+  case OPCODE_EXTNDW:
+    JitEmitModRm (Jit, Wide, 0xBF0F, 2, JIT_RAX, JIT_RDX, FALSE, 0);
+    break;
+
+  case OPCODE_EXTNDD:
+    if (Wide) {
+      JitEmitModRm (Jit, TRUE, 0x63, 1, JIT_RAX, JIT_RDX, FALSE, 0);
+    } else {
+      JitEmitModRm (Jit, FALSE, 0x8B, 1, JIT_RAX, JIT_RDX, FALSE, 0);
+    }
+    break;
+
+  default:
+    //
+    // DIV, DIVU, MOD and MODU raise an exception on a zero divisor.
+    //
+    return FALSE;
+  }
+
+  JitEmitStoreGpr (Jit, Decoded->Operand1, JIT_RAX);
+  return TRUE;
+}
+
+/**
+  Compile a CMP or CMPI instruction, following VmThreadedEvaluateCompare().
+
+  @param  Jit               The compiler state.
+  @param  Decoded           The decoded instruction.
+
+**/
+VOID
+JitCompileCompare (
+  IN EBC_JIT_COMPILER              *Jit,
+  IN CONST VM_DECODED_INSTRUCTION  *Decoded
+  )
+{
+  UINT8  Condition;
+
+  switch (Decoded->Compare) {
+  case OPCODE_CMPEQ:
+    Condition = JIT_CC_E;
+    break;
+
+  case OPCODE_CMPLTE:
+    Condition = JIT_CC_LE;
+    break;
+
+  case OPCODE_CMPGTE:
+    Condition = JIT_CC_GE;
+    break;
+
+  case OPCODE_CMPULTE:
+    Condition = JIT_CC_BE;
+    break;
+
+  default:
+    Condition = JIT_CC_AE;
+    break;
+  }
+
+  JitEmitLoadGpr (Jit, JIT_RAX, Decoded->Operand1);
+  if (Decoded->Operand2 != VM_DECODED_NO_REGISTER) {
+    JitEmitLoadGpr (Jit, JIT_RDX, Decoded->Operand2);
+    JitEmitAddImmediate (Jit, JIT_RDX, Decoded->Data);
+  } else {
+    JitEmitLoadImmediate (Jit, JIT_RDX, Decoded->Data);
+  }
+
+  //
+  // CMP RAX, RDX; SETcc AL; MOVZX EAX, AL
+  //
+  JitEmitModRm (Jit, Decoded->Is64Bit, 0x39, 1, JIT_RDX, JIT_RAX, FALSE, 0);
+  JitEmitModRm (Jit, FALSE, (UINT32) ((0x90 | Condition) << 8) | 0x0F, 2, 0, JIT_RAX, FALSE, 0);
+  JitEmitModRm (Jit, FALSE, 0xB60F, 2, JIT_RAX, JIT_RAX, FALSE, 0);
+
+  //
+  // Flags = (Flags & ~VMFLAGS_CC) | RAX
+  //
+  JitEmitModRm (Jit, TRUE, 0x8B, 1, JIT_RDX, JIT_R11, TRUE, JIT_FLAGS_OFFSET);
+  JitEmitModRm (Jit, TRUE, 0x83, 1, 4, JIT_RDX, FALSE, 0);
+  JitEmit8 (Jit, (UINT8) ~VMFLAGS_CC);
+  JitEmitModRm (Jit, TRUE, 0x09, 1, JIT_RAX, JIT_RDX, FALSE, 0);
+  JitEmitModRm (Jit, TRUE, 0x89, 1, JIT_RDX, JIT_R11, TRUE, JIT_FLAGS_OFFSET);
+}
+
+/**
+  Compile a JMP8 or JMP with an immediate target, following
+  VmThreadedJump().
+
+  @param  Jit               The compiler state.
+  @param  Decoded           The decoded instruction.
+
+**/
+VOID
+JitCompileJump (
+  IN EBC_JIT_COMPILER              *Jit,
+  IN CONST VM_DECODED_INSTRUCTION  *Decoded
+  )
+{
+  if ((Decoded->Condition & CONDITION_M_CONDITIONAL) == 0) {
+    JitEmitJump (Jit, MAX_UINT8, Decoded->Target);
+    return;
+  }
+
+  //
+  // TEST BYTE [R11 + Flags], VMFLAGS_CC
+  //
+  JitEmitModRm (Jit, FALSE, 0xF6, 1, 0, JIT_R11, TRUE, JIT_FLAGS_OFFSET);
+  JitEmit8 (Jit, VMFLAGS_CC);
+
+  JitEmitJump (
+    Jit,
+    (UINT8) (((Decoded->Condition & CONDITION_M_CS) != 0) ? JIT_CC_NE : JIT_CC_E),
+    Decoded->Target
+    );
+}
+
+/**
+  Compile the block that starts at VmPtr->Ip.
+
+  @param  VmPtr             A pointer to a VM context.
+
+  @return The compiled block, or NULL if the first instruction can not be
+          compiled.
+
+**/
+EBC_JIT_BLOCK
+JitCompileBlock (
+  IN VM_CONTEXT  *VmPtr
+  )
+{
+  EBC_JIT_COMPILER        *Jit;
+  VM_DECODED_INSTRUCTION  Decoded;
+  UINT8                   *Block;
+  VMIP                    Ip;
+  UINT32                  Offset;
+  UINTN                   Index;
+  BOOLEAN                 Compiled;
+  BOOLEAN                 FallsThrough;
+  BOOLEAN                 WritesR0;
+  BOOLEAN                 WritesMemory;
+
+  Jit      = &mEbcJitCompiler;
+  Jit->Ptr = mEbcJitCode + mEbcJitCodeUsed;
+  Jit->End = mEbcJitCode + EFI_PAGES_TO_SIZE (EBC_JIT_CODE_PAGES);
+  Jit->LabelCount = 0;
+  Jit->FixupCount = 0;
+
+  Block = Jit->Ptr;
+
+  //
+  // MOV R11, RCX
+  //
+  JitEmitModRm (Jit, TRUE, 0x89, 1, JIT_RCX, JIT_R11, FALSE, 0);
+
+  Offset       = 0;
+  FallsThrough = TRUE;
+  while (Jit->LabelCount < EBC_JIT_MAX_INSTRUCTIONS) {
+    Ip = VmPtr->Ip + Offset;
+    JitResolveFixups (Jit, Ip);
+
+    if ((UINTN) (Jit->End - Jit->Ptr) < EBC_JIT_MAX_INSTRUCTION_CODE + (Jit->FixupCount + 2) * EBC_JIT_EXIT_SIZE) {
+      break;
+    }
+
+    ZeroMem (&Decoded, sizeof (Decoded));
+    if (!VmDecodeThreadedInstruction (VmPtr, Offset, &Decoded)) {
+      break;
+    }
+
+    Jit->Labels[Jit->LabelCount].Ip   = Ip;
+    Jit->Labels[Jit->LabelCount].Code = Jit->Ptr;
+
+    Compiled     = TRUE;
+    WritesR0     = FALSE;
+    WritesMemory = FALSE;
+    switch (Decoded.Opcode) {
+    case OPCODE_JMP8:
+    case OPCODE_JMP:
+      JitCompileJump (Jit, &Decoded);
+      break;
+
+    case OPCODE_CALL:
+      Compiled = FALSE;
+      break;
+
+    case OPCODE_CMPEQ:
+    case OPCODE_CMPLTE:
+    case OPCODE_CMPGTE:
+    case OPCODE_CMPULTE:
+    case OPCODE_CMPUGTE:
+    case OPCODE_CMPIEQ:
+    case OPCODE_CMPILTE:
+    case OPCODE_CMPIGTE:
+    case OPCODE_CMPIULTE:
+    case OPCODE_CMPIUGTE:
+      JitCompileCompare (Jit, &Decoded);
+      break;
+
+    case OPCODE_MOVI:
+    case OPCODE_MOVIN:
+    case OPCODE_MOVREL:
+      JitEmitLoadImmediate (Jit, JIT_RAX, Decoded.Data);
+      JitEmitStoreGpr (Jit, Decoded.Operand1, JIT_RAX);
+      WritesR0 = (BOOLEAN) (Decoded.Operand1 == 0);
+      break;
+
+    default:
+      if ((Decoded.Opcode >= OPCODE_NOT) && (Decoded.Opcode <= OPCODE_EXTNDD)) {
+        Compiled = JitCompileDataManip (Jit, &Decoded);
+        WritesR0 = (BOOLEAN) (Decoded.Operand1 == 0);
+      } else {
+        JitCompileMove (Jit, &Decoded);
+        WritesMemory = (BOOLEAN) (OPERAND1_INDIRECT (Decoded.Operands) != 0);
+        WritesR0     = (BOOLEAN) (!WritesMemory && (Decoded.Operand1 == 0));
+      }
+      break;
+    }
+
+    if (!Compiled) {
+      Jit->Ptr = Jit->Labels[Jit->LabelCount].Code;
+      break;
+    }
+
+    if (WritesR0 || WritesMemory) {
+      JitEmitStackCheck (Jit, WritesMemory, Ip + Decoded.Size);
+    }
+
+    Jit->LabelCount++;
+    Offset += Decoded.Size;
+
+    //
+    // After an unconditional jump, only go on if an earlier jump in the
+    // block targets code further down.
+    //
+    if (((Decoded.Opcode == OPCODE_JMP8) || (Decoded.Opcode == OPCODE_JMP)) &&
+        ((Decoded.Condition & CONDITION_M_CONDITIONAL) == 0)) {
+      FallsThrough = FALSE;
+      for (Index = 0; Index < Jit->FixupCount; Index++) {
+        if (Jit->Fixups[Index].Target >= VmPtr->Ip + Offset) {
+          FallsThrough = TRUE;
+          break;
+        }
+      }
+
+      if (!FallsThrough) {
+        break;
+      }
+    }
+  }
+
+  if (Jit->LabelCount == 0) {
+    return NULL;
+  }
+
+  if (FallsThrough) {
+    JitEmitExit (Jit, VmPtr->Ip + Offset);
+  }
+
+  //
+  // Leave the block for every jump whose target was not compiled.
+  //
+  while (Jit->FixupCount > 0) {
+    Ip = Jit->Fixups[0].Target;
+    JitResolveFixups (Jit, Ip);
+    JitEmitExit (Jit, Ip);
+  }
+
+  mEbcJitCodeUsed = ALIGN_VALUE ((UINTN) (Jit->Ptr - mEbcJitCode), 16);
+  return (EBC_JIT_BLOCK) (UINTN) Block;
+}
+
+/**
+  Change the protection of the code buffer.
+
+  @param  Writable          TRUE to make the buffer writable and not
+                            executable, FALSE to make it read-only and
+                            executable.
+
+  @retval EFI_SUCCESS       The protection was changed.
+  @retval Others            The CPU architectural protocol failed.
+
+**/
+EFI_STATUS
+JitProtectCode (
+  IN BOOLEAN  Writable
+  )
+{
+  return mEbcJitCpu->SetMemoryAttributes (
+                       mEbcJitCpu,
+                       (EFI_PHYSICAL_ADDRESS) (UINTN) mEbcJitCode,
+                       EFI_PAGES_TO_SIZE (EBC_JIT_CODE_PAGES),
+                       Writable ? EFI_MEMORY_XP : EFI_MEMORY_RO
+                       );
+}
+
+/**
+  Compile the block that starts at VmPtr->Ip into the code buffer, dropping
+  all blocks first if the buffer is full.
+
+  @param  VmPtr             A pointer to a VM context.
+
+  @return The compiled block, or NULL if no block could be compiled.
+
+**/
+EBC_JIT_BLOCK
+JitCompile (
+  IN VM_CONTEXT  *VmPtr
+  )
+{
+  EFI_STATUS     Status;
+  EBC_JIT_BLOCK  Block;
+
+  if (mEbcJitCpu == NULL) {
+    Status = gBS->LocateProtocol (&gEfiCpuArchProtocolGuid, NULL, (VOID **) &mEbcJitCpu);
+    if (EFI_ERROR (Status)) {
+      mEbcJitCpu = NULL;
+      return NULL;
+    }
+  }
+
+  if (EFI_PAGES_TO_SIZE (EBC_JIT_CODE_PAGES) - mEbcJitCodeUsed < EBC_JIT_MIN_FREE_SPACE) {
+    mEbcJitGeneration++;
+    mEbcJitCodeUsed = 0;
+  }
+
+  Status = JitProtectCode (TRUE);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_WARN, "EbcJit: can not unprotect code buffer - %r\n", Status));
+    FreeEbcJit ();
+    return NULL;
+  }
+
+  Block = JitCompileBlock (VmPtr);
+
+  Status = JitProtectCode (FALSE);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_WARN, "EbcJit: can not protect code buffer - %r\n", Status));
+    FreeEbcJit ();
+    return NULL;
+  }
+
+  return Block;
+}
+
+/**
+  Allocate the tables and the code buffer of the JIT compiler, if it is
+  enabled with PcdEbcJitEnable.
+
+  @retval EFI_SUCCESS           The JIT compiler is ready.
+  @retval EFI_UNSUPPORTED       The JIT compiler is disabled.
+  @retval EFI_OUT_OF_RESOURCES  Memory could not be allocated.
+
+**/
+EFI_STATUS
+InitEbcJit (
+  VOID
+  )
+{
+  EFI_STATUS            Status;
+  EFI_PHYSICAL_ADDRESS  Code;
+
+  if (!FeaturePcdGet (PcdEbcJitEnable)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if (mEbcJitTable != NULL) {
+    return EFI_SUCCESS;
+  }
+
+  Status = gBS->AllocatePages (AllocateAnyPages, EfiBootServicesCode, EBC_JIT_CODE_PAGES, &Code);
+  if (EFI_ERROR (Status)) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  mEbcJitTable = AllocateZeroPool (EBC_JIT_TABLE_SIZE * sizeof (EBC_JIT_ENTRY));
+  if (mEbcJitTable == NULL) {
+    gBS->FreePages (Code, EBC_JIT_CODE_PAGES);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  mEbcJitCode     = (UINT8 *) (UINTN) Code;
+  mEbcJitCodeUsed = 0;
+  return EFI_SUCCESS;
+}
+
+/**
+  Free the tables and the code buffer of the JIT compiler. EBC code runs in
+  the interpreter only from then on.
+
+**/
+VOID
+FreeEbcJit (
+  VOID
+  )
+{
+  if (mEbcJitTable != NULL) {
+    FreePool (mEbcJitTable);
+    mEbcJitTable = NULL;
+  }
+
+  if (mEbcJitCode != NULL) {
+    //
+    // Pages keep the attributes they were given, make them writable again
+    // before they go back to the memory pool.
+    //
+    if (mEbcJitCpu != NULL) {
+      JitProtectCode (TRUE);
+    }
+
+    gBS->FreePages ((EFI_PHYSICAL_ADDRESS) (UINTN) mEbcJitCode, EBC_JIT_CODE_PAGES);
+    mEbcJitCode = NULL;
+  }
+}
+
+/**
+  Drop all compiled blocks. This must be called whenever EBC code that may
+  have been compiled is modified or unloaded.
+
+**/
+VOID
+FlushEbcJit (
+  VOID
+  )
+{
+  mEbcJitGeneration++;
+}
+
+/**
+  Run the compiled block that starts at VmPtr->Ip, compiling it first if the
+  address has become hot. The caller must own mVmDecodeCacheBusy.
+
+  @param  VmPtr             A pointer to a VM context.
+
+  @retval TRUE              A block ran and VmPtr->Ip is the next instruction
+                            for the interpreter.
+  @retval FALSE             No block was run.
+
+**/
+BOOLEAN
+EbcJitExecute (
+  IN VM_CONTEXT  *VmPtr
+  )
+{
+  EBC_JIT_ENTRY  *Entry;
+
+  if (mEbcJitTable == NULL) {
+    return FALSE;
+  }
+
+  //
+  // A debugger has to see every instruction, leave them to the interpreter.
+  //
+  if (VMFLAG_ISSET (VmPtr, VMFLAGS_STEP) || EbcDebuggerHookIsEnabled ()) {
+    return FALSE;
+  }
+
+  Entry = &mEbcJitTable[((UINTN) VmPtr->Ip >> 1) & (EBC_JIT_TABLE_SIZE - 1)];
+  if ((Entry->Ip != VmPtr->Ip) || (Entry->Generation != mEbcJitGeneration)) {
+    Entry->Ip         = VmPtr->Ip;
+    Entry->Generation = mEbcJitGeneration;
+    Entry->Count      = 0;
+    Entry->Block      = NULL;
+  }
+
+  if (Entry->Block == NULL) {
+    if ((Entry->Count == EBC_JIT_NOT_COMPILABLE) || (++Entry->Count < EBC_JIT_HOT_THRESHOLD)) {
+      return FALSE;
+    }
+
+    Entry->Block = JitCompile (VmPtr);
+    if (mEbcJitTable == NULL) {
+      return FALSE;
+    }
+
+    //
+    // Compiling may have dropped all blocks to make room.
+    //
+    Entry->Generation = mEbcJitGeneration;
+    if (Entry->Block == NULL) {
+      Entry->Count = (mEbcJitCpu == NULL) ? 0 : EBC_JIT_NOT_COMPILABLE;
+      return FALSE;
+    }
+  }
+
+  Entry->Block (VmPtr);
+  return TRUE;
+}
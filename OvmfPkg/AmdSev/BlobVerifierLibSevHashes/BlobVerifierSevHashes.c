@@ -159,6 +159,23 @@ VerifyBlob (
   return EFI_ACCESS_DENIED;
 }
 
+/**
+  Report whether VerifyBlob() actually verifies blobs.
+
+  Without a hashes table, VerifyBlob() rejects every blob; that is still
+  verification.
+
+  @retval TRUE   VerifyBlob() checks the data of the blobs.
+**/
+BOOLEAN
+EFIAPI
+BlobVerifierIsActive (
+  VOID
+  )
+{
+  return TRUE;
+}
+
 /**
   Locate the SEV hashes table.
 
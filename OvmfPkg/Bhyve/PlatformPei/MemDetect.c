@@ -430,6 +430,9 @@ QemuInitializeRam (
   UINT64                      LowerMemorySize;
   UINT64                      UpperMemorySize;
   MTRR_SETTINGS               MtrrSettings;
+  MTRR_MEMORY_RANGE           UcRanges[2];
+  UINT8                       Scratch[SIZE_16KB];
+  UINTN                       ScratchSize;
   EFI_STATUS                  Status;
 
   DEBUG ((DEBUG_INFO, "%a called\n", __FUNCTION__));
@@ -511,22 +514,31 @@ QemuInitializeRam (
     SetMem (&MtrrSettings.Fixed, sizeof MtrrSettings.Fixed, 0x06);
     ZeroMem (&MtrrSettings.Variables, sizeof MtrrSettings.Variables);
     MtrrSettings.MtrrDefType |= BIT11 | BIT10 | 6;
-    MtrrSetAllMtrrs (&MtrrSettings);
 
     //
     // Set memory range from 640KB to 1MB to uncacheable
     //
-    Status = MtrrSetMemoryAttribute (BASE_512KB + BASE_128KB,
-               BASE_1MB - (BASE_512KB + BASE_128KB), CacheUncacheable);
-    ASSERT_EFI_ERROR (Status);
+    UcRanges[0].BaseAddress = BASE_512KB + BASE_128KB;
+    UcRanges[0].Length      = BASE_1MB - (BASE_512KB + BASE_128KB);
+    UcRanges[0].Type        = CacheUncacheable;
 
     //
     // Set memory range from the "top of lower RAM" (RAM below 4GB) to 4GB as
     // uncacheable
     //
-    Status = MtrrSetMemoryAttribute (LowerMemorySize,
-               SIZE_4GB - LowerMemorySize, CacheUncacheable);
+    UcRanges[1].BaseAddress = LowerMemorySize;
+    UcRanges[1].Length      = SIZE_4GB - LowerMemorySize;
+    UcRanges[1].Type        = CacheUncacheable;
+
+    //
+    // Calculate all the MTRRs at once in the buffer, and program them with a
+    // single cache disable / flush cycle.
+    //
+    ScratchSize = sizeof (Scratch);
+    Status = MtrrSetMemoryAttributesInMtrrSettings (&MtrrSettings, Scratch,
+               &ScratchSize, UcRanges, ARRAY_SIZE (UcRanges));
     ASSERT_EFI_ERROR (Status);
+    MtrrSetAllMtrrs (&MtrrSettings);
   }
 }
 
@@ -35,4 +35,20 @@ VerifyBlob (
   IN  UINT32          BufSize
   );
 
+/**
+  Report whether VerifyBlob() actually verifies blobs.
+
+  Callers that cannot pass the complete data of a blob to VerifyBlob(), such
+  as a loader reading the blob on demand, must not use the blob if this
+  function returns TRUE.
+
+  @retval TRUE   VerifyBlob() checks the data of the blobs.
+  @retval FALSE  VerifyBlob() accepts every blob.
+**/
+BOOLEAN
+EFIAPI
+BlobVerifierIsActive (
+  VOID
+  );
+
 #endif
@@ -30,6 +30,25 @@ QemuFwCfgIsAvailable (
   );
 
 
+/**
+  Returns a boolean indicating if the firmware configuration interface
+  transfers data with DMA.
+
+  With DMA, QemuFwCfgSkipBytes() completes in constant time, and large
+  QemuFwCfgReadBytes() requests complete in a single transfer.
+
+  @retval    TRUE   The DMA interface is available
+  @retval    FALSE  The DMA interface is not available, or the firmware
+                    configuration interface itself is not available
+
+**/
+BOOLEAN
+EFIAPI
+QemuFwCfgDmaIsAvailable (
+  VOID
+  );
+
+
 /**
   Selects a firmware configuration item for reading.
 
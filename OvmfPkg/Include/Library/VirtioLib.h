@@ -217,6 +217,73 @@ VirtioFlush (
   );
 
 
+/**
+
+  Decide whether the host has to be notified about the descriptor chains that
+  were made available since OldAvailIdx.
+
+  This function implements the device side notification suppression checks
+  from virtio-0.9.5, 2.4.1.4 Notifying the Device. With
+  VIRTIO_F_RING_EVENT_IDX negotiated, the host reports in the avail_event
+  field of the used ring the available index that it wants to be notified
+  about. Otherwise, the host can only turn notifications off altogether, with
+  VRING_USED_F_NO_NOTIFY.
+
+  The caller is responsible for publishing the new available index in
+  *Ring->Avail.Idx before calling this function.
+
+  @param[in] Ring         The virtio ring that descriptor chains were made
+                          available on.
+
+  @param[in] OldAvailIdx  The value of *Ring->Avail.Idx before the caller made
+                          the new descriptor chains available.
+
+  @param[in] EventIdx     TRUE iff VIRTIO_F_RING_EVENT_IDX has been negotiated
+                          with the host.
+
+  @retval TRUE   The caller should call VirtIo->SetQueueNotify().
+
+  @retval FALSE  The host is going to process the new descriptor chains
+                 without a notification.
+
+**/
+BOOLEAN
+EFIAPI
+VirtioRingNeedNotify (
+  IN VRING   *Ring,
+  IN UINT16  OldAvailIdx,
+  IN BOOLEAN EventIdx
+  );
+
+
+/**
+
+  Ask the host not to interrupt for the used buffers of a ring that the
+  driver polls.
+
+  Without VIRTIO_F_RING_EVENT_IDX, the VRING_AVAIL_F_NO_INTERRUPT flag set by
+  the driver suffices. With it, the host disregards that flag, and interrupts
+  when the used index passes the used_event field of the available ring. This
+  function keeps the latter half the index space ahead of the used index that
+  the driver has consumed, so that the host never reaches it.
+
+  @param[in,out] Ring         The virtio ring being polled.
+
+  @param[in]     LastUsedIdx  The used index last consumed by the driver.
+
+  @param[in]     EventIdx     TRUE iff VIRTIO_F_RING_EVENT_IDX has been
+                              negotiated with the host.
+
+**/
+VOID
+EFIAPI
+VirtioRingSuppressInterrupts (
+  IN OUT VRING   *Ring,
+  IN     UINT16  LastUsedIdx,
+  IN     BOOLEAN EventIdx
+  );
+
+
 /**
 
   Report the feature bits to the VirtIo 1.0 device that the VirtIo 1.0 driver
@@ -31,3 +31,17 @@ VerifyBlob (
 {
   return EFI_SUCCESS;
 }
+
+/**
+  Report whether VerifyBlob() actually verifies blobs.
+
+  @retval FALSE  VerifyBlob() accepts every blob.
+**/
+BOOLEAN
+EFIAPI
+BlobVerifierIsActive (
+  VOID
+  )
+{
+  return FALSE;
+}
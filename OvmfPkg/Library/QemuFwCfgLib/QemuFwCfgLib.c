@@ -158,6 +158,26 @@ QemuFwCfgSkipBytes (
 }
 
 
+/**
+  Returns a boolean indicating if the firmware configuration interface
+  transfers data with DMA.
+
+  @retval    TRUE   The DMA interface is available
+  @retval    FALSE  The DMA interface is not available, or the firmware
+                    configuration interface itself is not available
+
+**/
+BOOLEAN
+EFIAPI
+QemuFwCfgDmaIsAvailable (
+  VOID
+  )
+{
+  return (BOOLEAN)(InternalQemuFwCfgIsAvailable () &&
+                   InternalQemuFwCfgDmaIsAvailable ());
+}
+
+
 /**
   Reads a UINT8 firmware configuration value
 
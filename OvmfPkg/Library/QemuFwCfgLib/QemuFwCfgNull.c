@@ -33,6 +33,25 @@ QemuFwCfgIsAvailable (
 }
 
 
+/**
+  Returns a boolean indicating if the firmware configuration interface
+  transfers data with DMA.
+
+  @retval    TRUE   The DMA interface is available
+  @retval    FALSE  The DMA interface is not available, or the firmware
+                    configuration interface itself is not available
+
+**/
+BOOLEAN
+EFIAPI
+QemuFwCfgDmaIsAvailable (
+  VOID
+  )
+{
+  return FALSE;
+}
+
+
 /**
   Selects a firmware configuration item for reading.
 
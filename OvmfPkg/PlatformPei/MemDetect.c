@@ -700,6 +700,9 @@ QemuInitializeRam (
   UINT64                      LowerMemorySize;
   UINT64                      UpperMemorySize;
   MTRR_SETTINGS               MtrrSettings;
+  MTRR_MEMORY_RANGE           UcRanges[2];
+  UINT8                       Scratch[SIZE_16KB];
+  UINTN                       ScratchSize;
   EFI_STATUS                  Status;
 
   DEBUG ((DEBUG_INFO, "%a called\n", __FUNCTION__));
@@ -787,22 +790,31 @@ QemuInitializeRam (
     SetMem (&MtrrSettings.Fixed, sizeof MtrrSettings.Fixed, 0x06);
     ZeroMem (&MtrrSettings.Variables, sizeof MtrrSettings.Variables);
     MtrrSettings.MtrrDefType |= BIT11 | BIT10 | 6;
-    MtrrSetAllMtrrs (&MtrrSettings);
 
     //
     // Set memory range from 640KB to 1MB to uncacheable
     //
-    Status = MtrrSetMemoryAttribute (BASE_512KB + BASE_128KB,
-               BASE_1MB - (BASE_512KB + BASE_128KB), CacheUncacheable);
-    ASSERT_EFI_ERROR (Status);
+    UcRanges[0].BaseAddress = BASE_512KB + BASE_128KB;
+    UcRanges[0].Length      = BASE_1MB - (BASE_512KB + BASE_128KB);
+    UcRanges[0].Type        = CacheUncacheable;
 
     //
     // Set the memory range from the start of the 32-bit MMIO area (32-bit PCI
     // MMIO aperture on i440fx, PCIEXBAR on q35) to 4GB as uncacheable.
     //
-    Status = MtrrSetMemoryAttribute (mQemuUc32Base, SIZE_4GB - mQemuUc32Base,
-               CacheUncacheable);
+    UcRanges[1].BaseAddress = mQemuUc32Base;
+    UcRanges[1].Length      = SIZE_4GB - mQemuUc32Base;
+    UcRanges[1].Type        = CacheUncacheable;
+
+    //
+    // Calculate all the MTRRs at once in the buffer, and program them with a
+    // single cache disable / flush cycle.
+    //
+    ScratchSize = sizeof (Scratch);
+    Status = MtrrSetMemoryAttributesInMtrrSettings (&MtrrSettings, Scratch,
+               &ScratchSize, UcRanges, ARRAY_SIZE (UcRanges));
     ASSERT_EFI_ERROR (Status);
+    MtrrSetAllMtrrs (&MtrrSettings);
   }
 }
 
@@ -22,6 +22,7 @@
 #include <Library/DevicePathLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/QemuFwCfgLib.h>
+#include <Library/TimerLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/UefiRuntimeServicesTableLib.h>
 #include <Protocol/DevicePath.h>
@@ -46,7 +47,9 @@ typedef struct {
     UINT32                      Size;
   }                             FwCfgItem[2];
   UINT32                        Size;
-  UINT8                         *Data;
+  UINT8                         *Data;          // NULL if streamed
+  UINT64                        StreamedBytes;
+  UINT64                        StreamedNanoSeconds;
 } KERNEL_BLOB;
 
 STATIC KERNEL_BLOB mKernelBlob[KernelBlobTypeMax] = {
@@ -71,6 +74,13 @@ STATIC KERNEL_BLOB mKernelBlob[KernelBlobTypeMax] = {
 
 STATIC UINT64 mTotalBlobBytes;
 
+//
+// The largest fw_cfg DMA transfer that ReadBlob() issues when streaming a blob
+// straight into the buffer of the caller. Under SEV, every transfer is bounced
+// through a shared buffer of this size, so keep it moderate.
+//
+#define STREAM_CHUNK_SIZE  SIZE_4MB
+
 //
 // Device path for the handle that incorporates our "EFI stub filesystem".
 //
@@ -107,6 +117,155 @@ STATIC CONST SINGLE_VENMEDIA_NODE_DEVPATH mInitrdDevicePath = {
   }
 };
 
+//
+// Access to the blob contents.
+//
+
+/**
+  Calculate the time elapsed between two performance counter readings,
+  accounting for a single wrap-around of the counter.
+
+  @param[in] Start  The counter value at the start of the interval.
+  @param[in] End    The counter value at the end of the interval.
+
+  @return  The length of the interval in nanoseconds.
+**/
+STATIC
+UINT64
+GetElapsedNanoSeconds (
+  IN UINT64 Start,
+  IN UINT64 End
+  )
+{
+  UINT64 CounterStart;
+  UINT64 CounterEnd;
+  UINT64 Ticks;
+
+  GetPerformanceCounterProperties (&CounterStart, &CounterEnd);
+  if (CounterEnd >= CounterStart) {
+    if (End >= Start) {
+      Ticks = End - Start;
+    } else {
+      Ticks = (CounterEnd - Start) + (End - CounterStart) + 1;
+    }
+  } else {
+    if (Start >= End) {
+      Ticks = Start - End;
+    } else {
+      Ticks = (Start - CounterEnd) + (CounterStart - End) + 1;
+    }
+  }
+  return GetTimeInNanoSecond (Ticks);
+}
+
+/**
+  Copy a range of a blob's contents to a caller-provided buffer.
+
+  If the blob has been downloaded into memory, the range is copied from there.
+  Otherwise the range is read from fw_cfg, directly into Buffer, in DMA
+  transfers of at most STREAM_CHUNK_SIZE bytes. The fw_cfg items are reselected
+  on every call, as other drivers may have accessed fw_cfg in the meantime.
+
+  @param[in,out] Blob    The blob to read from. The throughput statistics of
+                         streamed blobs are updated.
+  @param[in]     Offset  The offset of the range within the blob.
+  @param[in]     Size    The size of the range. The caller is responsible for
+                         ensuring that (Offset + Size) does not exceed
+                         Blob->Size.
+  @param[out]    Buffer  The buffer to copy the range to.
+**/
+STATIC
+VOID
+ReadBlob (
+  IN OUT KERNEL_BLOB *Blob,
+  IN     UINT64      Offset,
+  IN     UINTN       Size,
+  OUT    VOID        *Buffer
+  )
+{
+  UINT8   *Destination;
+  UINT64  ItemOffset;
+  UINT64  ItemLeft;
+  UINTN   Chunk;
+  UINTN   Idx;
+  UINT64  Start;
+
+  ASSERT (Offset + Size <= Blob->Size);
+
+  if (Blob->Data != NULL) {
+    CopyMem (Buffer, Blob->Data + Offset, Size);
+    return;
+  }
+
+  Destination = Buffer;
+  ItemOffset  = Offset;
+  for (Idx = 0; Idx < ARRAY_SIZE (Blob->FwCfgItem) && Size > 0; Idx++) {
+    if (Blob->FwCfgItem[Idx].DataKey == 0) {
+      break;
+    }
+    if (ItemOffset >= Blob->FwCfgItem[Idx].Size) {
+      ItemOffset -= Blob->FwCfgItem[Idx].Size;
+      continue;
+    }
+
+    QemuFwCfgSelectItem (Blob->FwCfgItem[Idx].DataKey);
+    QemuFwCfgSkipBytes ((UINTN)ItemOffset);
+
+    ItemLeft   = Blob->FwCfgItem[Idx].Size - ItemOffset;
+    ItemOffset = 0;
+    while (ItemLeft > 0 && Size > 0) {
+      Chunk = MIN (Size, STREAM_CHUNK_SIZE);
+      if (Chunk > ItemLeft) {
+        Chunk = (UINTN)ItemLeft;
+      }
+
+      //
+      // Time each transfer separately, so that the interval stays well below
+      // the wrap-around period of the performance counter.
+      //
+      Start = GetPerformanceCounter ();
+      QemuFwCfgReadBytes (Chunk, Destination);
+      Blob->StreamedNanoSeconds += GetElapsedNanoSeconds (
+                                     Start,
+                                     GetPerformanceCounter ()
+                                     );
+      Blob->StreamedBytes += Chunk;
+
+      Destination += Chunk;
+      ItemLeft    -= Chunk;
+      Size        -= Chunk;
+    }
+  }
+
+  ASSERT (Size == 0);
+}
+
+/**
+  Log the throughput statistics of a streamed blob.
+
+  @param[in] Blob  The blob to report on. Nothing is logged for blobs that have
+                   been downloaded into memory.
+**/
+STATIC
+VOID
+ReportBlobThroughput (
+  IN CONST KERNEL_BLOB *Blob
+  )
+{
+  UINT64 MicroSeconds;
+
+  if (Blob->Data != NULL || Blob->StreamedBytes == 0) {
+    return;
+  }
+
+  MicroSeconds = DivU64x32 (Blob->StreamedNanoSeconds, 1000);
+  DEBUG ((DEBUG_INFO, "%a: streamed %Lu bytes for \"%s\" in %Lu us "
+    "(%Lu MB/s)\n", __FUNCTION__, Blob->StreamedBytes, Blob->Name,
+    MicroSeconds,
+    MicroSeconds == 0 ? 0 : DivU64x64Remainder (Blob->StreamedBytes,
+                              MicroSeconds, NULL)));
+}
+
 //
 // The "file in the EFI stub filesystem" abstraction.
 //
@@ -200,7 +359,13 @@ StubFileClose (
   IN EFI_FILE_PROTOCOL *This
   )
 {
-  FreePool (STUB_FILE_FROM_FILE (This));
+  STUB_FILE *StubFile;
+
+  StubFile = STUB_FILE_FROM_FILE (This);
+  if (StubFile->BlobType != KernelBlobTypeMax) {
+    ReportBlobThroughput (&mKernelBlob[StubFile->BlobType]);
+  }
+  FreePool (StubFile);
   return EFI_SUCCESS;
 }
 
@@ -359,7 +524,7 @@ StubFileRead (
   )
 {
   STUB_FILE         *StubFile;
-  CONST KERNEL_BLOB *Blob;
+  KERNEL_BLOB       *Blob;
   UINT64            Left;
 
   StubFile = STUB_FILE_FROM_FILE (This);
@@ -402,9 +567,7 @@ StubFileRead (
   if (*BufferSize > Left) {
     *BufferSize = (UINTN)Left;
   }
-  if (Blob->Data != NULL) {
-    CopyMem (Buffer, Blob->Data + StubFile->Position, *BufferSize);
-  }
+  ReadBlob (Blob, StubFile->Position, *BufferSize, Buffer);
   StubFile->Position += *BufferSize;
   return EFI_SUCCESS;
 }
@@ -878,7 +1041,7 @@ InitrdLoadFile2 (
   OUT     VOID                          *Buffer     OPTIONAL
   )
 {
-  CONST KERNEL_BLOB   *InitrdBlob = &mKernelBlob[KernelBlobTypeInitrd];
+  KERNEL_BLOB         *InitrdBlob = &mKernelBlob[KernelBlobTypeInitrd];
 
   ASSERT (InitrdBlob->Size > 0);
 
@@ -900,7 +1063,8 @@ InitrdLoadFile2 (
     return EFI_BUFFER_TOO_SMALL;
   }
 
-  CopyMem (Buffer, InitrdBlob->Data, InitrdBlob->Size);
+  ReadBlob (InitrdBlob, 0, InitrdBlob->Size, Buffer);
+  ReportBlobThroughput (InitrdBlob);
 
   *BufferSize = InitrdBlob->Size;
   return EFI_SUCCESS;
@@ -917,19 +1081,24 @@ STATIC CONST EFI_LOAD_FILE2_PROTOCOL     mInitrdLoadFile2 = {
 /**
   Populate a blob in mKernelBlob.
 
-  param[in,out] Blob  Pointer to the KERNEL_BLOB element in mKernelBlob that is
-                      to be filled from fw_cfg.
+  param[in,out] Blob    Pointer to the KERNEL_BLOB element in mKernelBlob that
+                        is to be filled from fw_cfg.
+
+  param[in]     Stream  If TRUE, only determine the size of the blob, and leave
+                        Blob->Data NULL; the contents will be read from fw_cfg
+                        on demand by ReadBlob().
 
   @retval EFI_SUCCESS           Blob has been populated. If fw_cfg reported a
-                                size of zero for the blob, then Blob->Data has
-                                been left unchanged.
+                                size of zero for the blob, or Stream is TRUE,
+                                then Blob->Data has been left unchanged.
 
   @retval EFI_OUT_OF_RESOURCES  Failed to allocate memory for Blob->Data.
 **/
 STATIC
 EFI_STATUS
 FetchBlob (
-  IN OUT KERNEL_BLOB *Blob
+  IN OUT KERNEL_BLOB *Blob,
+  IN     BOOLEAN     Stream
   )
 {
   UINT32 Left;
@@ -952,6 +1121,12 @@ FetchBlob (
     return EFI_SUCCESS;
   }
 
+  if (Stream) {
+    DEBUG ((DEBUG_INFO, "%a: streaming %Ld bytes for \"%s\"\n", __FUNCTION__,
+      (INT64)Blob->Size, Blob->Name));
+    return EFI_SUCCESS;
+  }
+
   //
   // Read blob.
   //
@@ -999,6 +1174,11 @@ FetchBlob (
   QEMU's fw_cfg. Construct a minimal SimpleFileSystem that contains the two
   image files.
 
+  If PcdQemuKernelLoaderFsStreaming is set, fw_cfg supports DMA, and no blob
+  verifier is linked in, the kernel and the initial ramdisk are not
+  downloaded; they are read from fw_cfg when the files are read, straight into
+  the buffers of the readers.
+
   @retval EFI_NOT_FOUND         Kernel image was not found.
   @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
   @retval EFI_PROTOCOL_ERROR    Unterminated kernel command line.
@@ -1020,6 +1200,7 @@ QemuKernelLoaderFsDxeEntrypoint (
   EFI_STATUS                Status;
   EFI_HANDLE                FileSystemHandle;
   EFI_HANDLE                InitrdLoadFile2Handle;
+  BOOLEAN                   Stream;
 
   if (!QemuFwCfgIsAvailable ()) {
     return EFI_NOT_FOUND;
@@ -1031,28 +1212,48 @@ QemuKernelLoaderFsDxeEntrypoint (
     return Status;
   }
 
+  //
+  // Streaming relies on DMA: with the IO port interface, every read that does
+  // not start at offset zero of an item would have to skip the preceding
+  // bytes one by one. A streamed blob never exists in memory as a whole, so
+  // it cannot be verified; download everything if a verifier is linked in.
+  // The command line is small; always download it.
+  //
+  Stream = FeaturePcdGet (PcdQemuKernelLoaderFsStreaming) &&
+           QemuFwCfgDmaIsAvailable () &&
+           !BlobVerifierIsActive ();
+
   //
   // Fetch all blobs.
   //
   for (BlobType = 0; BlobType < KernelBlobTypeMax; ++BlobType) {
     CurrentBlob = &mKernelBlob[BlobType];
-    Status = FetchBlob (CurrentBlob);
-    if (EFI_ERROR (Status)) {
-      goto FreeBlobs;
-    }
-    Status = VerifyBlob (
-               CurrentBlob->Name,
-               CurrentBlob->Data,
-               CurrentBlob->Size
+    Status = FetchBlob (
+               CurrentBlob,
+               Stream && BlobType != KernelBlobTypeCommandLine
                );
     if (EFI_ERROR (Status)) {
       goto FreeBlobs;
     }
+    //
+    // Streamed blobs have no data here; they are only streamed if the
+    // verifier accepts every blob anyway.
+    //
+    if (CurrentBlob->Data != NULL || CurrentBlob->Size == 0) {
+      Status = VerifyBlob (
+                 CurrentBlob->Name,
+                 CurrentBlob->Data,
+                 CurrentBlob->Size
+                 );
+      if (EFI_ERROR (Status)) {
+        goto FreeBlobs;
+      }
+    }
     mTotalBlobBytes += CurrentBlob->Size;
   }
   KernelBlob      = &mKernelBlob[KernelBlobTypeKernel];
 
-  if (KernelBlob->Data == NULL) {
+  if (KernelBlob->Size == 0) {
     Status = EFI_NOT_FOUND;
     goto FreeBlobs;
   }
@@ -1099,9 +1300,9 @@ FreeBlobs:
     CurrentBlob = &mKernelBlob[--BlobType];
     if (CurrentBlob->Data != NULL) {
       FreePool (CurrentBlob->Data);
-      CurrentBlob->Size = 0;
       CurrentBlob->Data = NULL;
     }
+    CurrentBlob->Size = 0;
   }
 
   return Status;
@@ -0,0 +1,679 @@
+/** @file
+
+  Request engine of the virtio-blk driver.
+
+  Read and write tasks are cut into virtio-blk requests of at most
+  Dev->MaxRequestSize bytes, and as many requests are placed on the ring at
+  once as there are free request slots, so that the host can work on them in
+  parallel. The available index is published, and the host is notified, once
+  per batch.
+
+  Every request slot owns a fixed set of descriptors: either three consecutive
+  entries of the descriptor table, or -- with VIRTIO_F_RING_INDIRECT_DESC --
+  a single entry that points to the slot's own indirect descriptor table. This
+  way the used element that the host returns identifies the slot, and free
+  descriptors need not be tracked.
+
+  All state below is protected by raising the TPL to TPL_NOTIFY.
+
+  Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+#include <Library/VirtioLib.h>
+
+#include "VirtioBlk.h"
+
+/**
+
+  Report the completion of a task to its submitter.
+
+  @param[in,out] Task  The task that has no request in flight or pending any
+                       longer. Tasks with a token are freed.
+
+**/
+STATIC
+VOID
+CompleteTask (
+  IN OUT VBLK_TASK *Task
+  )
+{
+  EFI_BLOCK_IO2_TOKEN *Token;
+
+  if (Task->Token == NULL) {
+    //
+    // The blocking submitter polls this field; the task lives on its stack.
+    //
+    Task->Done = TRUE;
+    return;
+  }
+
+  Token                    = Task->Token;
+  Token->TransactionStatus = Task->Status;
+  FreePool (Task);
+  gBS->SignalEvent (Token->Event);
+}
+
+/**
+
+  Build a virtio-blk request for the next RequestSize bytes of a task in a
+  free request slot, and make it available to the host. The available index
+  is not published.
+
+  @param[in,out] Dev          The virtio-blk device. There must be a free
+                              request slot.
+
+  @param[in]     Task         The task to submit the request for.
+
+  @param[in]     RequestSize  The number of bytes to transfer, zero for
+                              flush. It must not exceed Dev->MaxRequestSize.
+
+  @retval EFI_SUCCESS  The request has been placed on the ring.
+
+  @return              Error codes from VirtioMapAllBytesInSharedBuffer().
+
+**/
+STATIC
+EFI_STATUS
+SubmitRequest (
+  IN OUT VBLK_DEV  *Dev,
+  IN     VBLK_TASK *Task,
+  IN     UINTN     RequestSize
+  )
+{
+  UINT16               SlotIdx;
+  VBLK_SLOT            *Slot;
+  VBLK_SHARED_REQ      *Shared;
+  EFI_PHYSICAL_ADDRESS SharedDeviceAddress;
+  EFI_PHYSICAL_ADDRESS BufferDeviceAddress;
+  BOOLEAN              RequestIsWrite;
+  VRING_DESC           Chain[VBLK_MAX_DATA_DESC + 2];
+  UINT16               NumDesc;
+  UINT16               HeadDescIdx;
+  UINT16               Index;
+  UINTN                Offset;
+  DESC_INDICES         Indices;
+  volatile VRING_DESC  *Desc;
+  EFI_STATUS           Status;
+
+  ASSERT (Dev->NumFreeSlots > 0);
+  ASSERT (RequestSize <= Dev->MaxRequestSize);
+
+  SlotIdx             = Dev->FreeSlots[Dev->NumFreeSlots - 1];
+  Slot                = &Dev->Slots[SlotIdx];
+  Shared              = &Dev->SharedReqs[SlotIdx];
+  SharedDeviceAddress = Dev->SharedReqsDeviceAddr + SlotIdx * sizeof *Shared;
+  RequestIsWrite      = (BOOLEAN) (Task->Type != VIRTIO_BLK_T_IN);
+
+  BufferDeviceAddress = 0;
+  Slot->BufferMapping = NULL;
+  if (RequestSize > 0) {
+    Status = VirtioMapAllBytesInSharedBuffer (
+               Dev->VirtIo,
+               (RequestIsWrite ?
+                VirtioOperationBusMasterRead :
+                VirtioOperationBusMasterWrite),
+               Task->Buffer,
+               RequestSize,
+               &BufferDeviceAddress,
+               &Slot->BufferMapping
+               );
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  Dev->NumFreeSlots--;
+  Slot->Task = Task;
+
+  //
+  // Prepare the virtio-blk request header. IO Priority is homogeneously 0.
+  // Preset a host status for ourselves that we do not accept as success.
+  //
+  Shared->Header.Type   = Task->Type;
+  Shared->Header.IoPrio = 0;
+  Shared->Header.Sector = MultU64x32 (
+                            Task->Lba,
+                            Dev->BlockIoMedia.BlockSize / 512
+                            );
+  Shared->HostStatus    = VIRTIO_BLK_S_IOERR;
+
+  //
+  // Header, data segments (VRING_DESC_F_WRITE is interpreted from the host's
+  // point of view), host status.
+  //
+  NumDesc = 0;
+  Chain[NumDesc].Addr  = SharedDeviceAddress +
+                         OFFSET_OF (VBLK_SHARED_REQ, Header);
+  Chain[NumDesc].Len   = sizeof Shared->Header;
+  Chain[NumDesc].Flags = 0;
+  NumDesc++;
+
+  for (Offset = 0; Offset < RequestSize; Offset += Chain[NumDesc - 1].Len) {
+    ASSERT (NumDesc <= VBLK_MAX_DATA_DESC);
+    Chain[NumDesc].Addr  = BufferDeviceAddress + Offset;
+    Chain[NumDesc].Len   = (UINT32) MIN (RequestSize - Offset,
+                                      Dev->MaxSegmentSize);
+    Chain[NumDesc].Flags = (UINT16) (RequestIsWrite ? 0 : VRING_DESC_F_WRITE);
+    NumDesc++;
+  }
+
+  Chain[NumDesc].Addr  = SharedDeviceAddress +
+                         OFFSET_OF (VBLK_SHARED_REQ, HostStatus);
+  Chain[NumDesc].Len   = sizeof Shared->HostStatus;
+  Chain[NumDesc].Flags = VRING_DESC_F_WRITE;
+  NumDesc++;
+
+  if (Dev->IndirectDesc) {
+    for (Index = 0; Index < NumDesc; Index++) {
+      Shared->Indirect[Index].Addr  = Chain[Index].Addr;
+      Shared->Indirect[Index].Len   = Chain[Index].Len;
+      Shared->Indirect[Index].Flags = (UINT16) (Chain[Index].Flags |
+                                                (Index + 1 < NumDesc ?
+                                                 VRING_DESC_F_NEXT : 0));
+      Shared->Indirect[Index].Next  = (UINT16) (Index + 1);
+    }
+
+    HeadDescIdx = SlotIdx;
+    Desc        = &Dev->Ring.Desc[HeadDescIdx];
+    Desc->Addr  = SharedDeviceAddress + OFFSET_OF (VBLK_SHARED_REQ, Indirect);
+    Desc->Len   = (UINT32) (NumDesc * sizeof (VRING_DESC));
+    Desc->Flags = VRING_DESC_F_INDIRECT;
+    Desc->Next  = 0;
+  } else {
+    //
+    // Dev->MaxRequestSize <= Dev->MaxSegmentSize in this case, hence the
+    // three descriptors of the slot suffice.
+    //
+    ASSERT (NumDesc <= 3);
+    HeadDescIdx         = (UINT16) (SlotIdx * 3);
+    Indices.HeadDescIdx = HeadDescIdx;
+    Indices.NextDescIdx = HeadDescIdx;
+    for (Index = 0; Index < NumDesc; Index++) {
+      VirtioAppendDesc (
+        &Dev->Ring,
+        Chain[Index].Addr,
+        Chain[Index].Len,
+        (UINT16) (Chain[Index].Flags |
+                  (Index + 1 < NumDesc ? VRING_DESC_F_NEXT : 0)),
+        &Indices
+        );
+    }
+  }
+
+  //
+  // virtio-0.9.5, 2.4.1.2 Updating the Available Ring
+  //
+  Dev->Ring.Avail.Ring[Dev->NextAvailIdx++ % Dev->Ring.QueueSize] =
+    HeadDescIdx;
+  return EFI_SUCCESS;
+}
+
+/**
+
+  Submit pending tasks, in order, to the free request slots, then publish the
+  new requests to the host with a single update of the available index and at
+  most one notification.
+
+  A flush task is submitted only once the ring has drained, and no further
+  request is submitted while it is in flight.
+
+  @param[in,out] Dev  The virtio-blk device.
+
+**/
+STATIC
+VOID
+SubmitTasks (
+  IN OUT VBLK_DEV *Dev
+  )
+{
+  UINT16     OldAvailIdx;
+  VBLK_TASK  *Task;
+  UINTN      RequestSize;
+  EFI_STATUS Status;
+
+  OldAvailIdx = Dev->NextAvailIdx;
+
+  while (!IsListEmpty (&Dev->PendingTasks) &&
+         Dev->NumFreeSlots > 0 &&
+         !Dev->FlushInFlight) {
+    Task = VBLK_TASK_FROM_LINK (GetFirstNode (&Dev->PendingTasks));
+    if (Task->Type == VIRTIO_BLK_T_FLUSH &&
+        Dev->NumFreeSlots < Dev->NumSlots) {
+      break;
+    }
+
+    RequestSize = MIN (Task->Remaining, Dev->MaxRequestSize);
+    Status = SubmitRequest (Dev, Task, RequestSize);
+    if (EFI_ERROR (Status)) {
+      //
+      // Give up on the rest of the task; it completes when the requests
+      // already in flight do.
+      //
+      Task->Status    = EFI_DEVICE_ERROR;
+      Task->Remaining = 0;
+    } else {
+      Task->Outstanding++;
+      Task->Remaining -= RequestSize;
+      Task->Buffer    += RequestSize;
+      Task->Lba       += RequestSize / Dev->BlockIoMedia.BlockSize;
+      Dev->FlushInFlight = (BOOLEAN) (Task->Type == VIRTIO_BLK_T_FLUSH);
+    }
+
+    if (Task->Remaining == 0) {
+      RemoveEntryList (&Task->Link);
+      if (Task->Outstanding == 0) {
+        CompleteTask (Task);
+      }
+    }
+  }
+
+  if (Dev->NextAvailIdx == OldAvailIdx) {
+    return;
+  }
+
+  //
+  // virtio-0.9.5, 2.4.1.3 Updating the Index Field
+  //
+  MemoryFence ();
+  *Dev->Ring.Avail.Idx = Dev->NextAvailIdx;
+
+  //
+  // virtio-0.9.5, 2.4.1.4 Notifying the Device
+  //
+  if (VirtioRingNeedNotify (&Dev->Ring, OldAvailIdx, Dev->EventIdx)) {
+    Status = Dev->VirtIo->SetQueueNotify (Dev->VirtIo, 0);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "%a: SetQueueNotify(): %r\n", __FUNCTION__,
+        Status));
+    }
+  }
+}
+
+/**
+
+  Reap the requests that the host has returned in the used ring, and complete
+  the tasks whose last request this was.
+
+  @param[in,out] Dev  The virtio-blk device.
+
+  @return  The number of requests reaped.
+
+**/
+STATIC
+UINTN
+ProcessUsedRing (
+  IN OUT VBLK_DEV *Dev
+  )
+{
+  UINT16                         UsedIdx;
+  UINTN                          Count;
+  volatile CONST VRING_USED_ELEM *UsedElem;
+  UINT16                         SlotIdx;
+  VBLK_SLOT                      *Slot;
+  VBLK_TASK                      *Task;
+  EFI_STATUS                     UnmapStatus;
+
+  //
+  // virtio-0.9.5, 2.4.2 Receiving Used Buffers From the Device
+  //
+  MemoryFence ();
+  UsedIdx = *Dev->Ring.Used.Idx;
+  MemoryFence ();
+
+  Count = 0;
+  while (Dev->LastUsedIdx != UsedIdx) {
+    UsedElem = &Dev->Ring.Used.UsedElem[Dev->LastUsedIdx++ %
+                                        Dev->Ring.QueueSize];
+    SlotIdx  = (UINT16) (Dev->IndirectDesc ? UsedElem->Id : UsedElem->Id / 3);
+    ASSERT (SlotIdx < Dev->NumSlots);
+    Slot = &Dev->Slots[SlotIdx];
+    Task = Slot->Task;
+    ASSERT (Task != NULL);
+
+    if (Dev->SharedReqs[SlotIdx].HostStatus != VIRTIO_BLK_S_OK) {
+      Task->Status = EFI_DEVICE_ERROR;
+    }
+
+    if (Slot->BufferMapping != NULL) {
+      UnmapStatus = Dev->VirtIo->UnmapSharedBuffer (
+                                   Dev->VirtIo,
+                                   Slot->BufferMapping
+                                   );
+      if (EFI_ERROR (UnmapStatus) && Task->Type == VIRTIO_BLK_T_IN) {
+        //
+        // Data from the bus master may not reach the caller; fail the task.
+        //
+        Task->Status = EFI_DEVICE_ERROR;
+      }
+    }
+
+    if (Task->Type == VIRTIO_BLK_T_FLUSH) {
+      Dev->FlushInFlight = FALSE;
+    }
+
+    Slot->Task = NULL;
+    Dev->FreeSlots[Dev->NumFreeSlots++] = SlotIdx;
+    Count++;
+
+    Task->Outstanding--;
+    if (Task->Outstanding == 0 && Task->Remaining == 0) {
+      CompleteTask (Task);
+    }
+  }
+
+  if (Count > 0) {
+    VirtioRingSuppressInterrupts (&Dev->Ring, Dev->LastUsedIdx, Dev->EventIdx);
+  }
+
+  return Count;
+}
+
+/**
+
+  Timer notification function that drives the tasks of EFI_BLOCK_IO2_PROTOCOL
+  callers to completion.
+
+  @param[in] Event    Event whose notification function is being invoked.
+
+  @param[in] Context  Pointer to the VBLK_DEV structure.
+
+**/
+STATIC
+VOID
+EFIAPI
+VirtioBlkPollTimer (
+  IN EFI_EVENT Event,
+  IN VOID      *Context
+  )
+{
+  VirtioBlkPoll (Context);
+}
+
+/**
+
+  Set up the request slots of a virtio-blk device, and create the timer that
+  completes asynchronous requests.
+
+  The virtio ring must have been initialized, and Dev->IndirectDesc,
+  Dev->EventIdx, Dev->MaxSegmentSize and Dev->MaxRequestSize must have been
+  set.
+
+  @param[in,out] Dev  The virtio-blk device.
+
+  @retval EFI_SUCCESS           The request slots are ready.
+
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+
+  @return                       Error codes from VirtIo->AllocateSharedPages(),
+                                VirtioMapAllBytesInSharedBuffer(), or the
+                                CreateEvent() boot service.
+
+**/
+EFI_STATUS
+VirtioBlkQueueInit (
+  IN OUT VBLK_DEV *Dev
+  )
+{
+  UINTN      NumSlots;
+  UINT16     Index;
+  EFI_STATUS Status;
+
+  NumSlots = Dev->IndirectDesc ? Dev->Ring.QueueSize :
+                                 Dev->Ring.QueueSize / 3;
+  Dev->NumSlots = (UINT16) MIN (NumSlots, VBLK_MAX_REQUESTS);
+  ASSERT (Dev->NumSlots > 0);
+
+  Dev->Slots     = AllocateZeroPool (Dev->NumSlots * sizeof *Dev->Slots);
+  Dev->FreeSlots = AllocatePool (Dev->NumSlots * sizeof *Dev->FreeSlots);
+  if (Dev->Slots == NULL || Dev->FreeSlots == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto FreeSlots;
+  }
+
+  //
+  // The request headers, host statuses and indirect tables are accessed by
+  // both the processor and the device; map them once for all requests.
+  //
+  Dev->SharedReqsPages = EFI_SIZE_TO_PAGES (
+                           Dev->NumSlots * sizeof *Dev->SharedReqs
+                           );
+  Status = Dev->VirtIo->AllocateSharedPages (
+                          Dev->VirtIo,
+                          Dev->SharedReqsPages,
+                          (VOID **)&Dev->SharedReqs
+                          );
+  if (EFI_ERROR (Status)) {
+    goto FreeSlots;
+  }
+  ZeroMem (Dev->SharedReqs, EFI_PAGES_TO_SIZE (Dev->SharedReqsPages));
+
+  Status = VirtioMapAllBytesInSharedBuffer (
+             Dev->VirtIo,
+             VirtioOperationBusMasterCommonBuffer,
+             Dev->SharedReqs,
+             EFI_PAGES_TO_SIZE (Dev->SharedReqsPages),
+             &Dev->SharedReqsDeviceAddr,
+             &Dev->SharedReqsMap
+             );
+  if (EFI_ERROR (Status)) {
+    goto FreeSharedReqs;
+  }
+
+  Status = gBS->CreateEvent (EVT_TIMER | EVT_NOTIFY_SIGNAL, TPL_NOTIFY,
+                  &VirtioBlkPollTimer, Dev, &Dev->PollTimer);
+  if (EFI_ERROR (Status)) {
+    goto UnmapSharedReqs;
+  }
+  Dev->PollTimerArmed = FALSE;
+
+  //
+  // Hand out the slots with the lowest descriptor indices first.
+  //
+  for (Index = 0; Index < Dev->NumSlots; Index++) {
+    Dev->FreeSlots[Index] = (UINT16) (Dev->NumSlots - 1 - Index);
+  }
+  Dev->NumFreeSlots  = Dev->NumSlots;
+  Dev->NextAvailIdx  = *Dev->Ring.Avail.Idx;
+  Dev->LastUsedIdx   = *Dev->Ring.Used.Idx;
+  Dev->FlushInFlight = FALSE;
+  InitializeListHead (&Dev->PendingTasks);
+
+  //
+  // We're going to poll the answers, the host should not send interrupts.
+  //
+  *Dev->Ring.Avail.Flags = (UINT16) VRING_AVAIL_F_NO_INTERRUPT;
+  VirtioRingSuppressInterrupts (&Dev->Ring, Dev->LastUsedIdx, Dev->EventIdx);
+
+  DEBUG ((DEBUG_INFO, "%a: Slots=%d MaxRequestSize=0x%x Indirect=%d "
+    "EventIdx=%d\n", __FUNCTION__, Dev->NumSlots, Dev->MaxRequestSize,
+    Dev->IndirectDesc, Dev->EventIdx));
+  return EFI_SUCCESS;
+
+UnmapSharedReqs:
+  Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, Dev->SharedReqsMap);
+
+FreeSharedReqs:
+  Dev->VirtIo->FreeSharedPages (
+                 Dev->VirtIo,
+                 Dev->SharedReqsPages,
+                 Dev->SharedReqs
+                 );
+
+FreeSlots:
+  if (Dev->FreeSlots != NULL) {
+    FreePool (Dev->FreeSlots);
+  }
+  if (Dev->Slots != NULL) {
+    FreePool (Dev->Slots);
+  }
+
+  return Status;
+}
+
+/**
+
+  Release the resources set up by VirtioBlkQueueInit().
+
+  The caller is responsible for resetting the device, and for making sure that
+  no request is in flight, first.
+
+  @param[in,out] Dev  The virtio-blk device.
+
+**/
+VOID
+VirtioBlkQueueUninit (
+  IN OUT VBLK_DEV *Dev
+  )
+{
+  ASSERT (Dev->NumFreeSlots == Dev->NumSlots);
+  ASSERT (IsListEmpty (&Dev->PendingTasks));
+
+  gBS->CloseEvent (Dev->PollTimer);
+  Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, Dev->SharedReqsMap);
+  Dev->VirtIo->FreeSharedPages (
+                 Dev->VirtIo,
+                 Dev->SharedReqsPages,
+                 Dev->SharedReqs
+                 );
+  FreePool (Dev->FreeSlots);
+  FreePool (Dev->Slots);
+
+  Dev->SharedReqs = NULL;
+  Dev->FreeSlots  = NULL;
+  Dev->Slots      = NULL;
+}
+
+/**
+
+  Queue a task, and submit as much of it to the host as the free request slots
+  allow.
+
+  @param[in,out] Dev   The virtio-blk device.
+
+  @param[in,out] Task  The task to queue. Task->Status must be EFI_SUCCESS on
+                       input.
+
+**/
+VOID
+VirtioBlkQueueTask (
+  IN OUT VBLK_DEV  *Dev,
+  IN OUT VBLK_TASK *Task
+  )
+{
+  EFI_TPL OldTpl;
+  BOOLEAN Async;
+
+  Task->Signature   = VBLK_TASK_SIG;
+  Task->Outstanding = 0;
+  Task->Done        = FALSE;
+
+  //
+  // A task with a token may be completed, and freed, by SubmitTasks().
+  //
+  Async = (BOOLEAN) (Task->Token != NULL);
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  InsertTailList (&Dev->PendingTasks, &Task->Link);
+  SubmitTasks (Dev);
+
+  //
+  // Blocking submitters poll the engine themselves; only tasks with a token
+  // need the timer. VirtioBlkPoll() cancels it when the queue drains.
+  //
+  if (Async && !Dev->PollTimerArmed &&
+      !EFI_ERROR (gBS->SetTimer (Dev->PollTimer, TimerPeriodic,
+                         VBLK_POLL_PERIOD))) {
+    Dev->PollTimerArmed = TRUE;
+  }
+  gBS->RestoreTPL (OldTpl);
+}
+
+/**
+
+  Reap the requests completed by the host, and submit pending tasks to the
+  freed request slots.
+
+  @param[in,out] Dev  The virtio-blk device.
+
+  @retval TRUE   At least one request completed.
+
+  @retval FALSE  No request completed.
+
+**/
+BOOLEAN
+VirtioBlkPoll (
+  IN OUT VBLK_DEV *Dev
+  )
+{
+  EFI_TPL OldTpl;
+  UINTN   Count;
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  Count  = ProcessUsedRing (Dev);
+  if (Count > 0) {
+    SubmitTasks (Dev);
+  }
+
+  if (Dev->PollTimerArmed &&
+      Dev->NumFreeSlots == Dev->NumSlots &&
+      IsListEmpty (&Dev->PendingTasks)) {
+    gBS->SetTimer (Dev->PollTimer, TimerCancel, 0);
+    Dev->PollTimerArmed = FALSE;
+  }
+  gBS->RestoreTPL (OldTpl);
+
+  return (BOOLEAN) (Count > 0);
+}
+
+/**
+
+  Complete all queued tasks that have not reached the host yet with
+  EFI_ABORTED, and wait until the host has processed the requests in flight.
+
+  @param[in,out] Dev  The virtio-blk device.
+
+**/
+VOID
+VirtioBlkAbortTasks (
+  IN OUT VBLK_DEV *Dev
+  )
+{
+  EFI_TPL   OldTpl;
+  VBLK_TASK *Task;
+  BOOLEAN   Idle;
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  while (!IsListEmpty (&Dev->PendingTasks)) {
+    Task = VBLK_TASK_FROM_LINK (GetFirstNode (&Dev->PendingTasks));
+    RemoveEntryList (&Task->Link);
+    Task->Status    = EFI_ABORTED;
+    Task->Remaining = 0;
+    if (Task->Outstanding == 0) {
+      CompleteTask (Task);
+    }
+  }
+  gBS->RestoreTPL (OldTpl);
+
+  //
+  // virtio-blk requests cannot be cancelled once the host has seen them.
+  //
+  for (;;) {
+    VirtioBlkPoll (Dev);
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    Idle   = (BOOLEAN) (Dev->NumFreeSlots == Dev->NumSlots);
+    gBS->RestoreTPL (OldTpl);
+    if (Idle) {
+      break;
+    }
+    gBS->Stall (1);
+  }
+}
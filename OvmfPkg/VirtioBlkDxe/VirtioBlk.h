@@ -13,14 +13,72 @@
 #define _VIRTIO_BLK_DXE_H_
 
 #include <Protocol/BlockIo.h>
+#include <Protocol/BlockIo2.h>
 #include <Protocol/ComponentName.h>
 #include <Protocol/DriverBinding.h>
 
-#include <IndustryStandard/Virtio.h>
+#include <IndustryStandard/VirtioBlk.h>
 
 
 #define VBLK_SIG SIGNATURE_32 ('V', 'B', 'L', 'K')
 
+//
+// Limits of the request engine in Queue.c.
+//
+#define VBLK_MAX_REQUESTS     128          // virtio-blk requests in flight
+#define VBLK_MAX_REQUEST_SIZE SIZE_256KB   // bytes per virtio-blk request
+#define VBLK_MAX_DATA_DESC    16           // data segments per indirect table
+
+//
+// Period of the timer that reaps completed requests for EFI_BLOCK_IO2_PROTOCOL
+// callers, in 100ns units.
+//
+#define VBLK_POLL_PERIOD      EFI_TIMER_PERIOD_MILLISECONDS (1)
+
+//
+// The part of a virtio-blk request that the host accesses, apart from the
+// data buffer. One such structure exists for each request slot, in a single
+// area that is mapped for common buffer access at initialization time. The
+// indirect descriptor table is only used with VIRTIO_F_RING_INDIRECT_DESC.
+//
+typedef struct {
+  VRING_DESC     Indirect[VBLK_MAX_DATA_DESC + 2];
+  VIRTIO_BLK_REQ Header;
+  UINT8          HostStatus;
+  UINT8          Reserved[15]; // keep the next indirect table 16-byte aligned
+} VBLK_SHARED_REQ;
+
+#define VBLK_TASK_SIG SIGNATURE_32 ('V', 'B', 'L', 'T')
+
+//
+// A read, write or flush request submitted through EFI_BLOCK_IO_PROTOCOL or
+// EFI_BLOCK_IO2_PROTOCOL. A task is carried out as one or more virtio-blk
+// requests.
+//
+typedef struct {
+  UINT32              Signature;
+  LIST_ENTRY          Link;        // on VBLK_DEV.PendingTasks
+  EFI_BLOCK_IO2_TOKEN *Token;      // NULL for a blocking request
+  UINT32              Type;        // VIRTIO_BLK_T_IN, _OUT or _FLUSH
+  EFI_LBA             Lba;         // first block not submitted yet
+  UINT8               *Buffer;     // first byte not submitted yet
+  UINTN               Remaining;   // bytes not submitted yet
+  UINTN               Outstanding; // virtio-blk requests in flight
+  EFI_STATUS          Status;
+  BOOLEAN             Done;        // blocking request completed
+} VBLK_TASK;
+
+#define VBLK_TASK_FROM_LINK(LinkPointer) \
+        CR (LinkPointer, VBLK_TASK, Link, VBLK_TASK_SIG)
+
+//
+// Driver side state of a request slot.
+//
+typedef struct {
+  VBLK_TASK *Task;                 // NULL if the slot is free
+  VOID      *BufferMapping;        // NULL for flush
+} VBLK_SLOT;
+
 typedef struct {
   //
   // Parts of this structure are initialized / torn down in various functions
@@ -34,13 +92,35 @@ typedef struct {
   EFI_EVENT              ExitBoot;             // DriverBindingStart  0
   VRING                  Ring;                 // VirtioRingInit      2
   EFI_BLOCK_IO_PROTOCOL  BlockIo;              // VirtioBlkInit       1
+  EFI_BLOCK_IO2_PROTOCOL BlockIo2;             // VirtioBlkInit       1
   EFI_BLOCK_IO_MEDIA     BlockIoMedia;         // VirtioBlkInit       1
   VOID                   *RingMap;             // VirtioRingMap       2
+  BOOLEAN                IndirectDesc;         // VirtioBlkInit       1
+  BOOLEAN                EventIdx;             // VirtioBlkInit       1
+  UINT32                 MaxSegmentSize;       // VirtioBlkInit       1
+  UINT32                 MaxRequestSize;       // VirtioBlkInit       1
+  UINT16                 NumSlots;             // VirtioBlkQueueInit  2
+  UINT16                 NumFreeSlots;         // VirtioBlkQueueInit  2
+  VBLK_SLOT              *Slots;               // VirtioBlkQueueInit  2
+  UINT16                 *FreeSlots;           // VirtioBlkQueueInit  2
+  VBLK_SHARED_REQ        *SharedReqs;          // VirtioBlkQueueInit  2
+  UINTN                  SharedReqsPages;      // VirtioBlkQueueInit  2
+  EFI_PHYSICAL_ADDRESS   SharedReqsDeviceAddr; // VirtioBlkQueueInit  2
+  VOID                   *SharedReqsMap;       // VirtioBlkQueueInit  2
+  UINT16                 NextAvailIdx;         // VirtioBlkQueueInit  2
+  UINT16                 LastUsedIdx;          // VirtioBlkQueueInit  2
+  BOOLEAN                FlushInFlight;        // VirtioBlkQueueInit  2
+  LIST_ENTRY             PendingTasks;         // VirtioBlkQueueInit  2
+  EFI_EVENT              PollTimer;            // VirtioBlkQueueInit  2
+  BOOLEAN                PollTimerArmed;       // VirtioBlkQueueInit  2
 } VBLK_DEV;
 
 #define VIRTIO_BLK_FROM_BLOCK_IO(BlockIoPointer) \
         CR (BlockIoPointer, VBLK_DEV, BlockIo, VBLK_SIG)
 
+#define VIRTIO_BLK_FROM_BLOCK_IO2(BlockIo2Pointer) \
+        CR (BlockIo2Pointer, VBLK_DEV, BlockIo2, VBLK_SIG)
+
 
 /**
 
@@ -253,6 +333,144 @@ VirtioBlkFlushBlocks (
   );
 
 
+//
+// UEFI Spec 2.9, 13.10 Block I/O 2 Protocol
+//
+// The functions below accept the same requests as their EFI_BLOCK_IO_PROTOCOL
+// counterparts. If Token or Token->Event is NULL, they block; otherwise they
+// return as soon as the request is queued, and signal Token->Event when it
+// completes.
+//
+EFI_STATUS
+EFIAPI
+VirtioBlkResetEx (
+  IN EFI_BLOCK_IO2_PROTOCOL *This,
+  IN BOOLEAN                ExtendedVerification
+  );
+
+EFI_STATUS
+EFIAPI
+VirtioBlkReadBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN     UINT32                 MediaId,
+  IN     EFI_LBA                Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token,
+  IN     UINTN                  BufferSize,
+  OUT    VOID                   *Buffer
+  );
+
+EFI_STATUS
+EFIAPI
+VirtioBlkWriteBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN     UINT32                 MediaId,
+  IN     EFI_LBA                Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token,
+  IN     UINTN                  BufferSize,
+  IN     VOID                   *Buffer
+  );
+
+EFI_STATUS
+EFIAPI
+VirtioBlkFlushBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token
+  );
+
+
+//
+// Request engine, implemented in Queue.c.
+//
+
+/**
+
+  Set up the request slots of a virtio-blk device, and create the timer that
+  completes asynchronous requests. The timer is only armed while
+  asynchronous requests are in flight.
+
+  The virtio ring must have been initialized, and Dev->IndirectDesc,
+  Dev->EventIdx, Dev->MaxSegmentSize and Dev->MaxRequestSize must have been
+  set.
+
+  @param[in,out] Dev  The virtio-blk device.
+
+  @retval EFI_SUCCESS           The request slots are ready.
+
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+
+  @return                       Error codes from VirtIo->AllocateSharedPages(),
+                                VirtioMapAllBytesInSharedBuffer(), or the
+                                CreateEvent() boot service.
+
+**/
+EFI_STATUS
+VirtioBlkQueueInit (
+  IN OUT VBLK_DEV *Dev
+  );
+
+/**
+
+  Release the resources set up by VirtioBlkQueueInit().
+
+  The caller is responsible for resetting the device, and for making sure that
+  no request is in flight, first.
+
+  @param[in,out] Dev  The virtio-blk device.
+
+**/
+VOID
+VirtioBlkQueueUninit (
+  IN OUT VBLK_DEV *Dev
+  );
+
+/**
+
+  Queue a task, and submit as much of it to the host as the free request slots
+  allow.
+
+  @param[in,out] Dev   The virtio-blk device.
+
+  @param[in,out] Task  The task to queue. Task->Status must be EFI_SUCCESS on
+                       input.
+
+**/
+VOID
+VirtioBlkQueueTask (
+  IN OUT VBLK_DEV  *Dev,
+  IN OUT VBLK_TASK *Task
+  );
+
+/**
+
+  Reap the requests completed by the host, and submit pending tasks to the
+  freed request slots.
+
+  @param[in,out] Dev  The virtio-blk device.
+
+  @retval TRUE   At least one request completed.
+
+  @retval FALSE  No request completed.
+
+**/
+BOOLEAN
+VirtioBlkPoll (
+  IN OUT VBLK_DEV *Dev
+  );
+
+/**
+
+  Complete all queued tasks that have not reached the host yet with
+  EFI_ABORTED, and wait until the host has processed the requests in flight.
+
+  @param[in,out] Dev  The virtio-blk device.
+
+**/
+VOID
+VirtioBlkAbortTasks (
+  IN OUT VBLK_DEV *Dev
+  );
+
+
 //
 // The purpose of the following scaffolding (EFI_COMPONENT_NAME_PROTOCOL and
 // EFI_COMPONENT_NAME2_PROTOCOL implementation) is to format the driver's name
@@ -0,0 +1,637 @@
+/** @file
+  Lookup and attribute cache for the Virtio Filesystem device.
+
+  FUSE_LOOKUP and FUSE_GETATTR responses carry validity timeouts, for which
+  the client may rely on the name-to-inode resolution and on the attributes,
+  respectively, without asking the device again. The functions in this file
+  remember those responses, so that repeatedly opening the same pathnames, and
+  repeatedly querying the same files, do not cost a request round-trip each.
+  The read-ahead windows of open files are aged like the attributes of the
+  files.
+
+  The clock of the caches is a periodic timer that is only armed while some
+  cached data may still be valid.
+
+  Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <Library/BaseLib.h>                  // AsciiStrLen()
+#include <Library/BaseMemoryLib.h>            // CopyMem()
+#include <Library/UefiBootServicesTableLib.h> // gBS
+
+#include "VirtioFsDxe.h"
+
+/**
+  Advance the clock of the cache by one period, and stop the clock once all
+  expiry times handed out by VirtioFsCacheExpiry() have passed.
+
+  @param[in] Event           The periodic timer event. Ignored.
+
+  @param[in] VirtioFsAsVoid  Pointer to the VIRTIO_FS object, passed in as a
+                             pointer-to-VOID.
+**/
+STATIC
+VOID
+EFIAPI
+VirtioFsCacheClockTick (
+  IN EFI_EVENT Event,
+  IN VOID      *VirtioFsAsVoid
+  )
+{
+  VIRTIO_FS *VirtioFs;
+
+  VirtioFs = VirtioFsAsVoid;
+  VirtioFs->CacheTime++;
+  if ((INT32)(VirtioFs->CacheLastExpiry - VirtioFs->CacheTime) <= 0) {
+    gBS->SetTimer (VirtioFs->CacheClock, TimerCancel, 0);
+    VirtioFs->CacheClockArmed = FALSE;
+  }
+}
+
+/**
+  Convert a FUSE validity timeout to an absolute expiry time on the clock of
+  the cache, and make sure the clock runs until then.
+
+  @param[in] VirtioFs  The Virtio Filesystem device whose clock the expiry
+                       time should refer to.
+
+  @param[in] Valid     The seconds part of the validity timeout.
+
+  @param[in] ValidNsec The nanoseconds part of the validity timeout.
+
+  @param[out] Expiry   The expiry time, in clock periods.
+
+  @retval TRUE   Expiry has been set.
+
+  @retval FALSE  The validity timeout is shorter than one clock period, or
+                 the clock could not be started; the response must not be
+                 cached.
+**/
+STATIC
+BOOLEAN
+VirtioFsCacheExpiry (
+  IN  VIRTIO_FS *VirtioFs,
+  IN  UINT64    Valid,
+  IN  UINT32    ValidNsec,
+  OUT UINT32    *Expiry
+  )
+{
+  UINT64     Ticks;
+  EFI_TPL    OldTpl;
+  EFI_STATUS Status;
+
+  if (Valid >= VIRTIO_FS_CACHE_MAX_TICKS / (1000 / VIRTIO_FS_CACHE_TICK_MS)) {
+    Ticks = VIRTIO_FS_CACHE_MAX_TICKS;
+  } else {
+    Ticks = Valid * (1000 / VIRTIO_FS_CACHE_TICK_MS) +
+            ValidNsec / (VIRTIO_FS_CACHE_TICK_MS * 1000000);
+    Ticks = MIN (Ticks, VIRTIO_FS_CACHE_MAX_TICKS);
+  }
+  if (Ticks == 0) {
+    return FALSE;
+  }
+
+  //
+  // Synchronize with VirtioFsCacheClockTick().
+  //
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  *Expiry = VirtioFs->CacheTime + (UINT32)Ticks;
+  if (!VirtioFs->CacheClockArmed) {
+    //
+    // The trigger time is expressed in 100ns units.
+    //
+    Status = gBS->SetTimer (VirtioFs->CacheClock, TimerPeriodic,
+                    VIRTIO_FS_CACHE_TICK_MS * 10000);
+    if (EFI_ERROR (Status)) {
+      gBS->RestoreTPL (OldTpl);
+      return FALSE;
+    }
+    VirtioFs->CacheClockArmed = TRUE;
+    VirtioFs->CacheLastExpiry = *Expiry;
+  } else if ((INT32)(*Expiry - VirtioFs->CacheLastExpiry) > 0) {
+    VirtioFs->CacheLastExpiry = *Expiry;
+  }
+  gBS->RestoreTPL (OldTpl);
+  return TRUE;
+}
+
+/**
+  Check whether an expiry time calculated by VirtioFsCacheExpiry() is still in
+  the future.
+
+  The comparison is correct across the wrap-around of the clock, because
+  VIRTIO_FS_CACHE_MAX_TICKS is much smaller than MAX_INT32.
+**/
+STATIC
+BOOLEAN
+VirtioFsCacheValid (
+  IN VIRTIO_FS *VirtioFs,
+  IN UINT32    Expiry
+  )
+{
+  return (INT32)(Expiry - VirtioFs->CacheTime) > 0;
+}
+
+/**
+  Release a lookup cache entry, returning all device-side references that the
+  entry holds with a single FUSE_FORGET.
+
+  @param[in,out] VirtioFs  The Virtio Filesystem device that owns Entry.
+
+  @param[in,out] Entry     The entry to release. Entry->LocalRefs must be
+                           zero, except when the cache is being torn down.
+**/
+STATIC
+VOID
+VirtioFsCacheRelease (
+  IN OUT VIRTIO_FS                    *VirtioFs,
+  IN OUT VIRTIO_FS_LOOKUP_CACHE_ENTRY *Entry
+  )
+{
+  ASSERT (Entry->InUse);
+
+  if (Entry->ServerRefs > 0) {
+    //
+    // Failure to forget is non-fatal; the device keeps the inode referenced
+    // until the FUSE session ends.
+    //
+    VirtioFsFuseForgetLookups (VirtioFs, Entry->NodeId, Entry->ServerRefs);
+  }
+  Entry->InUse = FALSE;
+}
+
+/**
+  Locate the non-stale lookup cache entry for (DirNodeId, Name).
+
+  @return  The entry found, or NULL.
+**/
+STATIC
+VIRTIO_FS_LOOKUP_CACHE_ENTRY *
+VirtioFsCacheFindName (
+  IN VIRTIO_FS *VirtioFs,
+  IN UINT64    DirNodeId,
+  IN CHAR8     *Name
+  )
+{
+  UINTN                        Idx;
+  VIRTIO_FS_LOOKUP_CACHE_ENTRY *Entry;
+
+  for (Idx = 0; Idx < VIRTIO_FS_LOOKUP_CACHE_ENTRIES; Idx++) {
+    Entry = &VirtioFs->LookupCache[Idx];
+    if (Entry->InUse && !Entry->Stale && Entry->DirNodeId == DirNodeId &&
+        AsciiStrCmp (Entry->Name, Name) == 0) {
+      return Entry;
+    }
+  }
+  return NULL;
+}
+
+/**
+  Set up the lookup and attribute caches, and create their clock. The clock is
+  started when the first entry is cached.
+
+  @param[in,out] VirtioFs  The Virtio Filesystem device whose caches should be
+                           set up.
+
+  @retval EFI_SUCCESS  The caches are empty and ready for use.
+
+  @return              Error codes propagated from gBS->CreateEvent().
+**/
+EFI_STATUS
+VirtioFsCacheInit (
+  IN OUT VIRTIO_FS *VirtioFs
+  )
+{
+  EFI_STATUS Status;
+
+  ZeroMem (VirtioFs->LookupCache, sizeof VirtioFs->LookupCache);
+  ZeroMem (VirtioFs->AttrCache, sizeof VirtioFs->AttrCache);
+  VirtioFs->CacheTime       = 0;
+  VirtioFs->CacheClockArmed = FALSE;
+  VirtioFs->CacheLastExpiry = 0;
+  VirtioFs->CacheVictim     = 0;
+
+  //
+  // The clock runs at TPL_NOTIFY so that it keeps ticking while
+  // EFI_FILE_PROTOCOL callers execute at TPL_CALLBACK; otherwise cache entries
+  // could outlive their validity timeouts.
+  //
+  Status = gBS->CreateEvent (EVT_TIMER | EVT_NOTIFY_SIGNAL, TPL_NOTIFY,
+                  VirtioFsCacheClockTick, VirtioFs, &VirtioFs->CacheClock);
+  return Status;
+}
+
+/**
+  Empty the lookup and attribute caches, and stop their clock.
+
+  The function may only be called after VirtioFsCacheInit() returns
+  successfully, while the FUSE session is still active.
+
+  @param[in,out] VirtioFs  The Virtio Filesystem device whose caches should be
+                           torn down.
+**/
+VOID
+VirtioFsCacheUninit (
+  IN OUT VIRTIO_FS *VirtioFs
+  )
+{
+  UINTN Idx;
+
+  for (Idx = 0; Idx < VIRTIO_FS_LOOKUP_CACHE_ENTRIES; Idx++) {
+    if (VirtioFs->LookupCache[Idx].InUse) {
+      VirtioFsCacheRelease (VirtioFs, &VirtioFs->LookupCache[Idx]);
+    }
+  }
+  gBS->CloseEvent (VirtioFs->CacheClock);
+}
+
+/**
+  Resolve (DirNodeId, Name) to an inode from the lookup cache.
+
+  On success, the caller receives a reference to NodeId exactly like from a
+  successful FUSE_LOOKUP; the reference must be dropped with
+  VirtioFsFuseForget().
+
+  @param[in,out] VirtioFs  The Virtio Filesystem device.
+
+  @param[in] DirNodeId     The inode number of the directory in which Name
+                           should be resolved.
+
+  @param[in] Name          The single-component filename to resolve.
+
+  @param[out] NodeId       The inode number which Name has been resolved to.
+
+  @param[out] FuseAttr     The cached attributes of NodeId.
+
+  @retval TRUE   Both the resolution and the attributes of the inode were
+                 found in the cache, and are still valid.
+
+  @retval FALSE  The caller has to send FUSE_LOOKUP.
+**/
+BOOLEAN
+VirtioFsCacheLookup (
+  IN OUT VIRTIO_FS                          *VirtioFs,
+  IN     UINT64                             DirNodeId,
+  IN     CHAR8                              *Name,
+     OUT UINT64                             *NodeId,
+     OUT VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE *FuseAttr
+  )
+{
+  VIRTIO_FS_LOOKUP_CACHE_ENTRY *Entry;
+
+  Entry = VirtioFsCacheFindName (VirtioFs, DirNodeId, Name);
+  if (Entry == NULL) {
+    return FALSE;
+  }
+  if (!VirtioFsCacheValid (VirtioFs, Entry->Expiry)) {
+    Entry->Stale = TRUE;
+    if (Entry->LocalRefs == 0) {
+      VirtioFsCacheRelease (VirtioFs, Entry);
+    }
+    return FALSE;
+  }
+  if (!VirtioFsCacheGetAttr (VirtioFs, Entry->NodeId, FuseAttr)) {
+    return FALSE;
+  }
+
+  Entry->LocalRefs++;
+  *NodeId = Entry->NodeId;
+  return TRUE;
+}
+
+/**
+  Remember the result of a successful FUSE_LOOKUP.
+
+  The reference that the device handed out with the FUSE_LOOKUP response is
+  taken over by the cache (if the response can be cached); the caller's
+  subsequent VirtioFsFuseForget() call for NodeResp->NodeId will be absorbed
+  by the cache then.
+
+  @param[in,out] VirtioFs  The Virtio Filesystem device.
+
+  @param[in] DirNodeId     The directory inode that the lookup was made in.
+
+  @param[in] Name          The filename that was looked up.
+
+  @param[in] NodeResp      The VIRTIO_FS_FUSE_NODE_RESPONSE object from the
+                           FUSE_LOOKUP response.
+
+  @param[in] FuseAttr      The VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE object from
+                           the FUSE_LOOKUP response.
+**/
+VOID
+VirtioFsCacheAddLookup (
+  IN OUT VIRTIO_FS                          *VirtioFs,
+  IN     UINT64                             DirNodeId,
+  IN     CHAR8                              *Name,
+  IN     VIRTIO_FS_FUSE_NODE_RESPONSE       *NodeResp,
+  IN     VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE *FuseAttr
+  )
+{
+  VIRTIO_FS_LOOKUP_CACHE_ENTRY *Entry;
+  UINT32                       Expiry;
+  UINTN                        Idx;
+
+  VirtioFsCacheSetAttr (VirtioFs, NodeResp->NodeId, FuseAttr,
+    NodeResp->AttrValid, NodeResp->AttrValidNsec);
+
+  if (!VirtioFsCacheExpiry (VirtioFs, NodeResp->EntryValid,
+         NodeResp->EntryValidNsec, &Expiry) ||
+      AsciiStrLen (Name) > VIRTIO_FS_LOOKUP_CACHE_NAME_LENGTH) {
+    return;
+  }
+
+  Entry = VirtioFsCacheFindName (VirtioFs, DirNodeId, Name);
+  if (Entry != NULL) {
+    if (Entry->NodeId == NodeResp->NodeId) {
+      //
+      // Refresh the existing entry, and account for the new reference.
+      //
+      Entry->Expiry = Expiry;
+      Entry->ServerRefs++;
+      Entry->LocalRefs++;
+      return;
+    }
+    //
+    // The name has been re-bound to a different inode.
+    //
+    Entry->Stale = TRUE;
+    if (Entry->LocalRefs == 0) {
+      VirtioFsCacheRelease (VirtioFs, Entry);
+    }
+  }
+
+  //
+  // Look for a free entry, or evict an unpinned one, in round-robin order.
+  //
+  Entry = NULL;
+  for (Idx = 0; Idx < VIRTIO_FS_LOOKUP_CACHE_ENTRIES; Idx++) {
+    if (!VirtioFs->LookupCache[Idx].InUse) {
+      Entry = &VirtioFs->LookupCache[Idx];
+      break;
+    }
+  }
+  for (Idx = 0;
+       Entry == NULL && Idx < VIRTIO_FS_LOOKUP_CACHE_ENTRIES;
+       Idx++) {
+    VIRTIO_FS_LOOKUP_CACHE_ENTRY *Victim;
+
+    Victim = &VirtioFs->LookupCache[VirtioFs->CacheVictim];
+    VirtioFs->CacheVictim = (VirtioFs->CacheVictim + 1) %
+                            VIRTIO_FS_LOOKUP_CACHE_ENTRIES;
+    if (Victim->LocalRefs == 0) {
+      VirtioFsCacheRelease (VirtioFs, Victim);
+      Entry = Victim;
+    }
+  }
+  if (Entry == NULL) {
+    //
+    // All entries are pinned by open files; the caller's reference remains
+    // uncached.
+    //
+    return;
+  }
+
+  Entry->InUse      = TRUE;
+  Entry->Stale      = FALSE;
+  Entry->Expiry     = Expiry;
+  Entry->DirNodeId  = DirNodeId;
+  Entry->NodeId     = NodeResp->NodeId;
+  Entry->ServerRefs = 1;
+  Entry->LocalRefs  = 1;
+  AsciiStrCpyS (Entry->Name, sizeof Entry->Name, Name);
+}
+
+/**
+  Absorb a FUSE_FORGET for NodeId in the lookup cache, if possible.
+
+  Device-side references to an inode are interchangeable, so any reference to
+  NodeId that a cache entry accounts for in LocalRefs can be taken back by the
+  cache, regardless of whether the caller received its reference from the
+  cache or from an uncached FUSE_LOOKUP or FUSE_READDIRPLUS.
+
+  @param[in,out] VirtioFs  The Virtio Filesystem device.
+
+  @param[in] NodeId        The inode that the caller wants to un-reference.
+
+  @retval TRUE   The reference has been returned to the cache; the caller must
+                 not send FUSE_FORGET.
+
+  @retval FALSE  The caller has to send FUSE_FORGET.
+**/
+BOOLEAN
+VirtioFsCacheForget (
+  IN OUT VIRTIO_FS *VirtioFs,
+  IN     UINT64    NodeId
+  )
+{
+  UINTN                        Idx;
+  VIRTIO_FS_LOOKUP_CACHE_ENTRY *Entry;
+
+  for (Idx = 0; Idx < VIRTIO_FS_LOOKUP_CACHE_ENTRIES; Idx++) {
+    Entry = &VirtioFs->LookupCache[Idx];
+    if (Entry->InUse && Entry->NodeId == NodeId && Entry->LocalRefs > 0) {
+      Entry->LocalRefs--;
+      if (Entry->Stale && Entry->LocalRefs == 0) {
+        VirtioFsCacheRelease (VirtioFs, Entry);
+      }
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+/**
+  Fetch the attributes of NodeId from the attribute cache.
+
+  @param[in,out] VirtioFs  The Virtio Filesystem device.
+
+  @param[in] NodeId        The inode whose attributes are requested.
+
+  @param[out] FuseAttr     The cached attributes.
+
+  @retval TRUE   FuseAttr has been populated from a valid cache entry.
+
+  @retval FALSE  The caller has to send FUSE_GETATTR.
+**/
+BOOLEAN
+VirtioFsCacheGetAttr (
+  IN OUT VIRTIO_FS                          *VirtioFs,
+  IN     UINT64                             NodeId,
+     OUT VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE *FuseAttr
+  )
+{
+  VIRTIO_FS_ATTR_CACHE_ENTRY *Entry;
+
+  Entry = &VirtioFs->AttrCache[NodeId % VIRTIO_FS_ATTR_CACHE_ENTRIES];
+  if (NodeId == 0 || Entry->NodeId != NodeId) {
+    return FALSE;
+  }
+  if (!VirtioFsCacheValid (VirtioFs, Entry->Expiry)) {
+    Entry->NodeId = 0;
+    return FALSE;
+  }
+  CopyMem (FuseAttr, &Entry->Attr, sizeof *FuseAttr);
+  return TRUE;
+}
+
+/**
+  Remember the attributes of NodeId, as reported by the device.
+
+  @param[in,out] VirtioFs   The Virtio Filesystem device.
+
+  @param[in] NodeId         The inode whose attributes have been reported.
+
+  @param[in] FuseAttr       The attributes.
+
+  @param[in] AttrValid      The seconds part of the attribute validity timeout.
+
+  @param[in] AttrValidNsec  The nanoseconds part of the attribute validity
+                            timeout.
+**/
+VOID
+VirtioFsCacheSetAttr (
+  IN OUT VIRTIO_FS                          *VirtioFs,
+  IN     UINT64                             NodeId,
+  IN     VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE *FuseAttr,
+  IN     UINT64                             AttrValid,
+  IN     UINT32                             AttrValidNsec
+  )
+{
+  VIRTIO_FS_ATTR_CACHE_ENTRY *Entry;
+  UINT32                     Expiry;
+
+  Entry = &VirtioFs->AttrCache[NodeId % VIRTIO_FS_ATTR_CACHE_ENTRIES];
+  if (!VirtioFsCacheExpiry (VirtioFs, AttrValid, AttrValidNsec, &Expiry)) {
+    if (Entry->NodeId == NodeId) {
+      Entry->NodeId = 0;
+    }
+    return;
+  }
+  Entry->NodeId = NodeId;
+  Entry->Expiry = Expiry;
+  CopyMem (&Entry->Attr, FuseAttr, sizeof Entry->Attr);
+}
+
+/**
+  Age the read-ahead window of VirtioFsFile, which has just been filled, like
+  the cached attributes of the file.
+
+  The caller is expected to have fetched the attributes of the file with
+  VirtioFsFuseGetAttr() immediately before filling the window. If those
+  attributes have not been cached, the window is only good for the current
+  read.
+
+  @param[in,out] VirtioFs      The Virtio Filesystem device.
+
+  @param[in,out] VirtioFsFile  The file whose read-ahead window has been
+                               filled.
+**/
+VOID
+VirtioFsCacheSetReadAhead (
+  IN OUT VIRTIO_FS      *VirtioFs,
+  IN OUT VIRTIO_FS_FILE *VirtioFsFile
+  )
+{
+  VIRTIO_FS_ATTR_CACHE_ENTRY *Entry;
+
+  Entry = &VirtioFs->AttrCache[VirtioFsFile->NodeId %
+                               VIRTIO_FS_ATTR_CACHE_ENTRIES];
+  if (Entry->NodeId == VirtioFsFile->NodeId &&
+      VirtioFsCacheValid (VirtioFs, Entry->Expiry)) {
+    VirtioFsFile->ReadAheadExpiry = Entry->Expiry;
+  } else {
+    VirtioFsFile->ReadAheadExpiry = VirtioFs->CacheTime;
+  }
+}
+
+/**
+  Drop the read-ahead window of VirtioFsFile if it has expired.
+
+  @param[in] VirtioFs          The Virtio Filesystem device.
+
+  @param[in,out] VirtioFsFile  The file whose read-ahead window should be
+                               checked.
+**/
+VOID
+VirtioFsCacheAgeReadAhead (
+  IN     VIRTIO_FS      *VirtioFs,
+  IN OUT VIRTIO_FS_FILE *VirtioFsFile
+  )
+{
+  if (VirtioFsFile->ReadAheadFill > 0 &&
+      !VirtioFsCacheValid (VirtioFs, VirtioFsFile->ReadAheadExpiry)) {
+    VirtioFsFile->ReadAheadFill = 0;
+  }
+}
+
+/**
+  Drop everything cached about the contents and the attributes of NodeId.
+
+  This function is to be called before the file identified by NodeId is
+  modified. It drops the cached attributes of NodeId, and the read-ahead
+  windows of all files that are open on NodeId.
+
+  @param[in,out] VirtioFs  The Virtio Filesystem device.
+
+  @param[in] NodeId        The inode that is about to be modified.
+**/
+VOID
+VirtioFsCacheInvalidateNode (
+  IN OUT VIRTIO_FS *VirtioFs,
+  IN     UINT64    NodeId
+  )
+{
+  VIRTIO_FS_ATTR_CACHE_ENTRY *Entry;
+  LIST_ENTRY                 *OpenFilesEntry;
+
+  Entry = &VirtioFs->AttrCache[NodeId % VIRTIO_FS_ATTR_CACHE_ENTRIES];
+  if (Entry->NodeId == NodeId) {
+    Entry->NodeId = 0;
+  }
+
+  BASE_LIST_FOR_EACH (OpenFilesEntry, &VirtioFs->OpenFiles) {
+    VIRTIO_FS_FILE *VirtioFsFile;
+
+    VirtioFsFile = VIRTIO_FS_FILE_FROM_OPEN_FILES_ENTRY (OpenFilesEntry);
+    if (VirtioFsFile->NodeId == NodeId) {
+      VirtioFsFile->ReadAheadFill = 0;
+    }
+  }
+}
+
+/**
+  Drop all name resolutions and all attributes from the caches.
+
+  This function is to be called before the namespace of the filesystem is
+  modified (entries are created, removed, or renamed). Such changes affect
+  name resolution, the attributes of the directories involved, and the link
+  counts of the inodes involved.
+
+  @param[in,out] VirtioFs  The Virtio Filesystem device.
+**/
+VOID
+VirtioFsCacheInvalidateNames (
+  IN OUT VIRTIO_FS *VirtioFs
+  )
+{
+  UINTN                        Idx;
+  VIRTIO_FS_LOOKUP_CACHE_ENTRY *Entry;
+
+  for (Idx = 0; Idx < VIRTIO_FS_LOOKUP_CACHE_ENTRIES; Idx++) {
+    Entry = &VirtioFs->LookupCache[Idx];
+    if (!Entry->InUse) {
+      continue;
+    }
+    Entry->Stale = TRUE;
+    if (Entry->LocalRefs == 0) {
+      VirtioFsCacheRelease (VirtioFs, Entry);
+    }
+  }
+
+  for (Idx = 0; Idx < VIRTIO_FS_ATTR_CACHE_ENTRIES; Idx++) {
+    VirtioFs->AttrCache[Idx].NodeId = 0;
+  }
+}
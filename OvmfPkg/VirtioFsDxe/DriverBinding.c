@@ -89,10 +89,15 @@ VirtioFsBindingStart (
     goto UninitVirtioFs;
   }
 
+  Status = VirtioFsCacheInit (VirtioFs);
+  if (EFI_ERROR (Status)) {
+    goto UninitVirtioFs;
+  }
+
   Status = gBS->CreateEvent (EVT_SIGNAL_EXIT_BOOT_SERVICES, TPL_CALLBACK,
                   VirtioFsExitBoot, VirtioFs, &VirtioFs->ExitBoot);
   if (EFI_ERROR (Status)) {
-    goto UninitVirtioFs;
+    goto UninitCache;
   }
 
   InitializeListHead (&VirtioFs->OpenFiles);
@@ -112,6 +117,9 @@ CloseExitBoot:
   CloseStatus = gBS->CloseEvent (VirtioFs->ExitBoot);
   ASSERT_EFI_ERROR (CloseStatus);
 
+UninitCache:
+  VirtioFsCacheUninit (VirtioFs);
+
 UninitVirtioFs:
   VirtioFsUninit (VirtioFs);
 
@@ -163,6 +171,7 @@ VirtioFsBindingStop (
   Status = gBS->CloseEvent (VirtioFs->ExitBoot);
   ASSERT_EFI_ERROR (Status);
 
+  VirtioFsCacheUninit (VirtioFs);
   VirtioFsUninit (VirtioFs);
 
   Status = gBS->CloseProtocol (ControllerHandle, &gVirtioDeviceProtocolGuid,
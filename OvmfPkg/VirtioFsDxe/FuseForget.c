@@ -12,6 +12,42 @@
   Make the Virtio Filesysem device drop one reference count from a NodeId that
   the driver looked up by filename.
 
+  If the lookup cache accounts for a reference to NodeId, the reference is
+  returned to the cache, and no request is sent. Otherwise, FUSE_FORGET is
+  sent with VirtioFsFuseForgetLookups().
+
+  The function may only be called after VirtioFsFuseInitSession() returns
+  successfully and before VirtioFsUninit() is called.
+
+  @param[in,out] VirtioFs  The Virtio Filesystem device to send the FUSE_FORGET
+                           request to. On output, the FUSE request counter
+                           "VirtioFs->RequestId" may have been incremented.
+
+  @param[in] NodeId        The inode number that the client learned by way of
+                           lookup, and that the server should now un-reference
+                           exactly once.
+
+  @retval EFI_SUCCESS  The reference has been dropped.
+
+  @return              Error codes propagated from
+                       VirtioFsFuseForgetLookups().
+**/
+EFI_STATUS
+VirtioFsFuseForget (
+  IN OUT VIRTIO_FS *VirtioFs,
+  IN     UINT64    NodeId
+  )
+{
+  if (VirtioFsCacheForget (VirtioFs, NodeId)) {
+    return EFI_SUCCESS;
+  }
+  return VirtioFsFuseForgetLookups (VirtioFs, NodeId, 1);
+}
+
+/**
+  Make the Virtio Filesysem device drop a number of reference counts from a
+  NodeId that the driver looked up by filename.
+
   Send the FUSE_FORGET request to the Virtio Filesysem device for this. Unlike
   most other FUSE requests, FUSE_FORGET doesn't elicit a response, not even the
   common VIRTIO_FS_FUSE_RESPONSE header.
@@ -24,8 +60,9 @@
                            "VirtioFs->RequestId" will have been incremented.
 
   @param[in] NodeId        The inode number that the client learned by way of
-                           lookup, and that the server should now un-reference
-                           exactly once.
+                           lookup, and that the server should now un-reference.
+
+  @param[in] NumberOfLookups  The number of references to drop.
 
   @retval EFI_SUCCESS  The FUSE_FORGET request has been submitted.
 
@@ -33,9 +70,10 @@
                        VirtioFsFuseNewRequest(), VirtioFsSgListsSubmit().
 **/
 EFI_STATUS
-VirtioFsFuseForget (
+VirtioFsFuseForgetLookups (
   IN OUT VIRTIO_FS *VirtioFs,
-  IN     UINT64    NodeId
+  IN     UINT64    NodeId,
+  IN     UINT64    NumberOfLookups
   )
 {
   VIRTIO_FS_FUSE_REQUEST        CommonReq;
@@ -75,7 +113,7 @@ VirtioFsFuseForget (
   //
   // Populate the FUSE_FORGET-specific fields.
   //
-  ForgetReq.NumberOfLookups = 1;
+  ForgetReq.NumberOfLookups = NumberOfLookups;
 
   //
   // Submit the request. There's not going to be a response.
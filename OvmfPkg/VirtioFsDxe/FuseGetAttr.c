@@ -12,12 +12,15 @@
   Send a FUSE_GETATTR request to the Virtio Filesystem device, for fetching the
   attributes of an inode.
 
+  The attributes are served from the attribute cache if possible, without
+  contacting the Virtio Filesystem device.
+
   The function may only be called after VirtioFsFuseInitSession() returns
   successfully and before VirtioFsUninit() is called.
 
   @param[in,out] VirtioFs  The Virtio Filesystem device to send the
                            FUSE_GETATTR request to. On output, the FUSE request
-                           counter "VirtioFs->RequestId" will have been
+                           counter "VirtioFs->RequestId" may have been
                            incremented.
 
   @param[in] NodeId        The inode number for which the attributes should be
@@ -52,6 +55,10 @@ VirtioFsFuseGetAttr (
   VIRTIO_FS_SCATTER_GATHER_LIST   RespSgList;
   EFI_STATUS                      Status;
 
+  if (VirtioFsCacheGetAttr (VirtioFs, NodeId, FuseAttr)) {
+    return EFI_SUCCESS;
+  }
+
   //
   // Set up the scatter-gather lists.
   //
@@ -112,5 +119,9 @@ VirtioFsFuseGetAttr (
       __FUNCTION__, VirtioFs->Label, NodeId, CommonResp.Error));
     Status = VirtioFsErrnoToEfiStatus (CommonResp.Error);
   }
+  if (!EFI_ERROR (Status)) {
+    VirtioFsCacheSetAttr (VirtioFs, NodeId, FuseAttr, GetAttrResp.AttrValid,
+      GetAttrResp.AttrValidNsec);
+  }
   return Status;
 }
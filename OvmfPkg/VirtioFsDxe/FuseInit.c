@@ -25,7 +25,9 @@
                            "VirtioFs->RequestId" is set to 1 on output. The
                            maximum write buffer size exposed in the FUSE_INIT
                            response is saved in "VirtioFs->MaxWrite", on
-                           output.
+                           output. The read-ahead window size, derived from
+                           the FUSE_INIT response, is saved in
+                           "VirtioFs->ReadAhead", on output.
 
   @retval EFI_SUCCESS      The FUSE session has been started.
 
@@ -100,7 +102,7 @@ VirtioFsFuseInitSession (
   //
   InitReq.Major        = VIRTIO_FS_FUSE_MAJOR;
   InitReq.Minor        = VIRTIO_FS_FUSE_MINOR;
-  InitReq.MaxReadahead = 0;
+  InitReq.MaxReadahead = VIRTIO_FS_MAX_READ_AHEAD;
   InitReq.Flags        = VIRTIO_FS_FUSE_INIT_REQ_F_DO_READDIRPLUS;
 
   //
@@ -138,5 +140,11 @@ VirtioFsFuseInitSession (
   // Save the maximum write buffer size for FUSE_WRITE requests.
   //
   VirtioFs->MaxWrite = InitResp.MaxWrite;
+
+  //
+  // Size the read-ahead window for sequential FUSE_READ requests. The device
+  // accepts FUSE_READ requests at least as large as FUSE_WRITE requests.
+  //
+  VirtioFs->ReadAhead = MIN (InitResp.MaxWrite, VIRTIO_FS_MAX_READ_AHEAD);
   return EFI_SUCCESS;
 }
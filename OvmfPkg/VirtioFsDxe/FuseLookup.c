@@ -17,12 +17,16 @@
   The function returns EFI_NOT_FOUND exclusively if the Virtio Filesystem
   device explicitly responds with ENOENT -- "No such file or directory".
 
+  The resolution is served from the lookup cache if possible, without
+  contacting the Virtio Filesystem device. Either way, the caller receives a
+  reference to NodeId that it has to drop with VirtioFsFuseForget().
+
   The function may only be called after VirtioFsFuseInitSession() returns
   successfully and before VirtioFsUninit() is called.
 
   @param[in,out] VirtioFs  The Virtio Filesystem device to send the FUSE_LOOKUP
                            request to. On output, the FUSE request counter
-                           "VirtioFs->RequestId" will have been incremented.
+                           "VirtioFs->RequestId" may have been incremented.
 
   @param[in] DirNodeId     The inode number of the directory in which Name
                            should be resolved to an inode.
@@ -68,6 +72,10 @@ VirtioFsFuseLookup (
   VIRTIO_FS_SCATTER_GATHER_LIST RespSgList;
   EFI_STATUS                    Status;
 
+  if (VirtioFsCacheLookup (VirtioFs, DirNodeId, Name, NodeId, FuseAttr)) {
+    return EFI_SUCCESS;
+  }
+
   //
   // Set up the scatter-gather lists.
   //
@@ -138,8 +146,10 @@ VirtioFsFuseLookup (
   }
 
   //
-  // Output the NodeId to which Name has been resolved to.
+  // Remember the resolution and the attributes for as long as the device
+  // permits. Output the NodeId to which Name has been resolved to.
   //
+  VirtioFsCacheAddLookup (VirtioFs, DirNodeId, Name, &NodeResp, FuseAttr);
   *NodeId = NodeResp.NodeId;
   return EFI_SUCCESS;
 
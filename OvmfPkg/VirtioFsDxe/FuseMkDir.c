@@ -104,6 +104,12 @@ VirtioFsFuseMkDir (
                     VIRTIO_FS_FUSE_MODE_PERM_RWXO);
   MkDirReq.Umask = 0;
 
+  //
+  // The request changes the namespace; drop the cached name resolutions and
+  // attributes.
+  //
+  VirtioFsCacheInvalidateNames (VirtioFs);
+
   //
   // Submit the request.
   //
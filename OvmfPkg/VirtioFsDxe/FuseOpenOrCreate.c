@@ -123,6 +123,12 @@ VirtioFsFuseOpenOrCreate (
   CreateReq.Umask   = 0;
   CreateReq.Padding = 0;
 
+  //
+  // The request changes the namespace; drop the cached name resolutions and
+  // attributes.
+  //
+  VirtioFsCacheInvalidateNames (VirtioFs);
+
   //
   // Submit the request.
   //
@@ -1,5 +1,5 @@
 /** @file
-  FUSE_READ / FUSE_READDIRPLUS wrapper for the Virtio Filesystem device.
+  FUSE_READ / FUSE_READDIRPLUS wrappers for the Virtio Filesystem device.
 
   Copyright (C) 2020, Red Hat, Inc.
 
@@ -189,3 +189,194 @@ VirtioFsFuseReadFileOrDir (
   *Size = (UINT32)TailBufferFill;
   return EFI_SUCCESS;
 }
+
+/**
+  Read a range of a regular file with multiple FUSE_READ requests in flight.
+
+  The range is split into chunks of ChunkSize bytes (except the last chunk,
+  which may be shorter). Up to VIRTIO_FS_MAX_EXCHANGES chunks are requested
+  from the Virtio Filesystem device at once, with VirtioFsSgListsSubmitBatch(),
+  so that the device can service them in parallel.
+
+  The function may only be called after VirtioFsFuseInitSession() returns
+  successfully and before VirtioFsUninit() is called.
+
+  @param[in,out] VirtioFs  The Virtio Filesystem device to send the FUSE_READ
+                           requests to. On output, the FUSE request counter
+                           "VirtioFs->RequestId" will have been incremented by
+                           the number of requests sent.
+
+  @param[in] NodeId        The inode number of the regular file to read from.
+
+  @param[in] FuseHandle    The open handle to the regular file to read from.
+
+  @param[in] Offset        The absolute file position at which to start
+                           reading.
+
+  @param[in] ChunkSize     The number of bytes to request with one FUSE_READ.
+                           Must be positive.
+
+  @param[in,out] Size      On input, the number of bytes to read. On output,
+                           the number of bytes actually read, contiguously from
+                           Offset, which may be smaller than the value on input
+                           (due to EOF, or due to an error). The function stops
+                           at the first chunk that the device populates only
+                           partially.
+
+  @param[out] Data         Buffer to read the bytes from the regular file into.
+                           The caller is responsible for providing room for (at
+                           least) as many bytes in Data as Size is on input.
+
+  @retval EFI_SUCCESS            Read successful. The caller is responsible for
+                                 checking Size to learn the actual byte count
+                                 transferred.
+
+  @retval EFI_INVALID_PARAMETER  ChunkSize is zero.
+
+  @retval EFI_UNSUPPORTED        The request virtqueue is too small for a
+                                 single FUSE_READ exchange.
+
+  @return                        The "errno" value mapped to an EFI_STATUS
+                                 code, if the Virtio Filesystem device
+                                 explicitly reported an error. Size reports the
+                                 data read before the failing chunk.
+
+  @return                        Error codes propagated from
+                                 VirtioFsSgListsValidate(),
+                                 VirtioFsFuseNewRequest(),
+                                 VirtioFsSgListsSubmitBatch(),
+                                 VirtioFsFuseCheckResponse().
+**/
+EFI_STATUS
+VirtioFsFuseReadFileBatch (
+  IN OUT VIRTIO_FS *VirtioFs,
+  IN     UINT64    NodeId,
+  IN     UINT64    FuseHandle,
+  IN     UINT64    Offset,
+  IN     UINT32    ChunkSize,
+  IN OUT UINTN     *Size,
+     OUT VOID      *Data
+  )
+{
+  VIRTIO_FS_FUSE_REQUEST        CommonReq[VIRTIO_FS_MAX_EXCHANGES];
+  VIRTIO_FS_FUSE_READ_REQUEST   ReadReq[VIRTIO_FS_MAX_EXCHANGES];
+  VIRTIO_FS_IO_VECTOR           ReqIoVec[VIRTIO_FS_MAX_EXCHANGES][2];
+  VIRTIO_FS_SCATTER_GATHER_LIST ReqSgList[VIRTIO_FS_MAX_EXCHANGES];
+  VIRTIO_FS_SCATTER_GATHER_LIST *ReqSgListPtr[VIRTIO_FS_MAX_EXCHANGES];
+  VIRTIO_FS_FUSE_RESPONSE       CommonResp[VIRTIO_FS_MAX_EXCHANGES];
+  VIRTIO_FS_IO_VECTOR           RespIoVec[VIRTIO_FS_MAX_EXCHANGES][2];
+  VIRTIO_FS_SCATTER_GATHER_LIST RespSgList[VIRTIO_FS_MAX_EXCHANGES];
+  VIRTIO_FS_SCATTER_GATHER_LIST *RespSgListPtr[VIRTIO_FS_MAX_EXCHANGES];
+  UINTN                         MaxExchanges;
+  UINTN                         NumExchanges;
+  UINTN                         Exchange;
+  UINTN                         Transferred;
+  UINTN                         Queued;
+  UINTN                         TailBufferFill;
+  EFI_STATUS                    Status;
+
+  if (ChunkSize == 0) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  //
+  // Each exchange takes four descriptors: two for the request, two for the
+  // response.
+  //
+  MaxExchanges = MIN (VIRTIO_FS_MAX_EXCHANGES,
+                   VirtioFs->QueueSize / (ARRAY_SIZE (ReqIoVec[0]) +
+                                          ARRAY_SIZE (RespIoVec[0])));
+  if (MaxExchanges == 0) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Status      = EFI_SUCCESS;
+  Transferred = 0;
+  while (Transferred < *Size) {
+    //
+    // Set up, validate and populate the exchanges for the next batch of
+    // chunks.
+    //
+    Queued = 0;
+    for (NumExchanges = 0;
+         NumExchanges < MaxExchanges && Transferred + Queued < *Size;
+         NumExchanges++) {
+      Exchange = NumExchanges;
+
+      ReqIoVec[Exchange][0].Buffer = &CommonReq[Exchange];
+      ReqIoVec[Exchange][0].Size   = sizeof CommonReq[Exchange];
+      ReqIoVec[Exchange][1].Buffer = &ReadReq[Exchange];
+      ReqIoVec[Exchange][1].Size   = sizeof ReadReq[Exchange];
+      ReqSgList[Exchange].IoVec    = ReqIoVec[Exchange];
+      ReqSgList[Exchange].NumVec   = ARRAY_SIZE (ReqIoVec[Exchange]);
+      ReqSgListPtr[Exchange]       = &ReqSgList[Exchange];
+
+      RespIoVec[Exchange][0].Buffer = &CommonResp[Exchange];
+      RespIoVec[Exchange][0].Size   = sizeof CommonResp[Exchange];
+      RespIoVec[Exchange][1].Buffer = (UINT8 *)Data + Transferred + Queued;
+      RespIoVec[Exchange][1].Size   = MIN ((UINTN)ChunkSize,
+                                        *Size - Transferred - Queued);
+      RespSgList[Exchange].IoVec    = RespIoVec[Exchange];
+      RespSgList[Exchange].NumVec   = ARRAY_SIZE (RespIoVec[Exchange]);
+      RespSgListPtr[Exchange]       = &RespSgList[Exchange];
+
+      Status = VirtioFsSgListsValidate (VirtioFs, &ReqSgList[Exchange],
+                 &RespSgList[Exchange]);
+      if (EFI_ERROR (Status)) {
+        goto Done;
+      }
+
+      Status = VirtioFsFuseNewRequest (VirtioFs, &CommonReq[Exchange],
+                 ReqSgList[Exchange].TotalSize, VirtioFsFuseOpRead, NodeId);
+      if (EFI_ERROR (Status)) {
+        goto Done;
+      }
+
+      ReadReq[Exchange].FileHandle = FuseHandle;
+      ReadReq[Exchange].Offset     = Offset + Transferred + Queued;
+      ReadReq[Exchange].Size       = (UINT32)RespIoVec[Exchange][1].Size;
+      ReadReq[Exchange].ReadFlags  = 0;
+      ReadReq[Exchange].LockOwner  = 0;
+      ReadReq[Exchange].Flags      = 0;
+      ReadReq[Exchange].Padding    = 0;
+
+      Queued += RespIoVec[Exchange][1].Size;
+    }
+
+    //
+    // Submit the batch.
+    //
+    Status = VirtioFsSgListsSubmitBatch (VirtioFs, NumExchanges, ReqSgListPtr,
+               RespSgListPtr);
+    if (EFI_ERROR (Status)) {
+      goto Done;
+    }
+
+    //
+    // Verify the responses in file order, and account for the contiguous
+    // data.
+    //
+    for (Exchange = 0; Exchange < NumExchanges; Exchange++) {
+      Status = VirtioFsFuseCheckResponse (&RespSgList[Exchange],
+                 CommonReq[Exchange].Unique, &TailBufferFill);
+      if (EFI_ERROR (Status)) {
+        if (Status == EFI_DEVICE_ERROR) {
+          DEBUG ((DEBUG_ERROR, "%a: Label=\"%s\" NodeId=%Lu FuseHandle=%Lu "
+            "Offset=0x%Lx Size=0x%x Errno=%d\n", __FUNCTION__,
+            VirtioFs->Label, NodeId, FuseHandle, ReadReq[Exchange].Offset,
+            ReadReq[Exchange].Size, CommonResp[Exchange].Error));
+          Status = VirtioFsErrnoToEfiStatus (CommonResp[Exchange].Error);
+        }
+        goto Done;
+      }
+      Transferred += TailBufferFill;
+      if (TailBufferFill < RespIoVec[Exchange][1].Size) {
+        goto Done;
+      }
+    }
+  }
+
+Done:
+  *Size = Transferred;
+  return Status;
+}
@@ -108,6 +108,12 @@ VirtioFsFuseRename (
   Rename2Req.Flags   = VIRTIO_FS_FUSE_RENAME2_REQ_F_NOREPLACE;
   Rename2Req.Padding = 0;
 
+  //
+  // The request changes the namespace; drop the cached name resolutions and
+  // attributes.
+  //
+  VirtioFsCacheInvalidateNames (VirtioFs);
+
   //
   // Submit the request.
   //
@@ -140,6 +140,12 @@ VirtioFsFuseSetAttr (
     AttrReq.Valid |= VIRTIO_FS_FUSE_SETATTR_REQ_F_MODE;
   }
 
+  //
+  // Drop the cached attributes and file contents that the request is going
+  // to change.
+  //
+  VirtioFsCacheInvalidateNode (VirtioFs, NodeId);
+
   //
   // Submit the request.
   //
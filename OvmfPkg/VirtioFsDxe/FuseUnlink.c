@@ -92,6 +92,12 @@ VirtioFsFuseRemoveFileOrDir (
     return Status;
   }
 
+  //
+  // The request changes the namespace; drop the cached name resolutions and
+  // attributes.
+  //
+  VirtioFsCacheInvalidateNames (VirtioFs);
+
   //
   // Submit the request.
   //
@@ -124,6 +124,12 @@ VirtioFsFuseWrite (
   WriteReq.Flags      = 0;
   WriteReq.Padding    = 0;
 
+  //
+  // Drop the cached attributes and file contents that the request is going
+  // to change.
+  //
+  VirtioFsCacheInvalidateNode (VirtioFs, NodeId);
+
   //
   // Submit the request.
   //
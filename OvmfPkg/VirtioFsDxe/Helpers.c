@@ -10,6 +10,7 @@
 #include <Library/BaseMemoryLib.h>       // CopyMem()
 #include <Library/MemoryAllocationLib.h> // AllocatePool()
 #include <Library/TimeBaseLib.h>         // EpochToEfiTime()
+#include <Library/UefiBootServicesTableLib.h> // gBS
 #include <Library/VirtioLib.h>           // Virtio10WriteFeatures()
 
 #include "VirtioFsDxe.h"
@@ -228,6 +229,7 @@ VirtioFsInit (
   if (EFI_ERROR (Status)) {
     goto UnmapQueue;
   }
+  VirtioFs->Broken = FALSE;
 
   return EFI_SUCCESS;
 
@@ -500,8 +502,7 @@ VirtioFsSgListsValidate (
                             more response bytes than ResponseSgList->TotalSize.
 
   @return                   Error codes propagated from
-                            VirtioMapAllBytesInSharedBuffer(), VirtioFlush(),
-                            or VirtioFs->Virtio->UnmapSharedBuffer().
+                            VirtioFsSgListsSubmitBatch().
 **/
 EFI_STATUS
 VirtioFsSgListsSubmit (
@@ -510,192 +511,374 @@ VirtioFsSgListsSubmit (
   IN OUT VIRTIO_FS_SCATTER_GATHER_LIST *ResponseSgList OPTIONAL
   )
 {
-  VIRTIO_FS_SCATTER_GATHER_LIST *SgListParam[2];
-  VIRTIO_MAP_OPERATION          SgListVirtioMapOp[ARRAY_SIZE (SgListParam)];
-  UINT16                        SgListDescriptorFlag[ARRAY_SIZE (SgListParam)];
+  return VirtioFsSgListsSubmitBatch (VirtioFs, 1, &RequestSgList,
+           &ResponseSgList);
+}
+
+/**
+  Submit a number of validated (request buffer list, response buffer list)
+  pairs to the Virtio Filesystem device at once, and wait for all of them to
+  complete.
+
+  The descriptor chains of the exchanges are placed back-to-back in the
+  descriptor table, made available to the device with a single update of the
+  available index, and announced with a single notification. This lets the
+  Virtio Filesystem device work on the requests in parallel (the device is
+  free to complete them in any order). The function polls until every
+  exchange has been completed.
+
+  Each pair of VIRTIO_FS_SCATTER_GATHER_LIST objects must have been validated
+  together, using the VirtioFsSgListsValidate() function. The output fields
+  are set up for each pair as described at VirtioFsSgListsSubmit().
+
+  The function may only be called after VirtioFsInit() returns successfully and
+  before VirtioFsUninit() is called.
+
+  @param[in,out] VirtioFs        The Virtio Filesystem device that the
+                                 request-response exchanges should now be
+                                 submitted to.
+
+  @param[in] NumExchanges        The number of elements in RequestSgList and
+                                 ResponseSgList. Must be positive, and not
+                                 greater than VIRTIO_FS_MAX_EXCHANGES.
+
+  @param[in,out] RequestSgList   Array of pointers to the scatter-gather lists
+                                 that describe the request parts of the
+                                 exchanges.
+
+  @param[in,out] ResponseSgList  Array of pointers to the scatter-gather lists
+                                 that describe the response parts of the
+                                 exchanges. An element may be NULL if and only
+                                 if NULL was passed to VirtioFsSgListsValidate()
+                                 as ResponseSgList for the same exchange.
+
+  @retval EFI_SUCCESS            All transfers complete. For each exchange, the
+                                 caller should investigate the
+                                 VIRTIO_FS_IO_VECTOR.Transferred fields in the
+                                 response list, like after
+                                 VirtioFsSgListsSubmit().
+
+  @retval EFI_INVALID_PARAMETER  NumExchanges is zero, or greater than
+                                 VIRTIO_FS_MAX_EXCHANGES.
+
+  @retval EFI_UNSUPPORTED        The total number of IO Vectors across all
+                                 exchanges exceeds VirtioFs->QueueSize.
+
+  @retval EFI_DEVICE_ERROR       The Virtio Filesystem device completed an
+                                 unknown descriptor chain, or reported
+                                 populating more response bytes than the
+                                 TotalSize of a response list. In the first
+                                 case, and if notifying the device failed,
+                                 the device has been reset, and all further
+                                 submissions fail with EFI_DEVICE_ERROR too.
+
+  @return                        Error codes propagated from
+                                 VirtioMapAllBytesInSharedBuffer(),
+                                 VirtioFs->Virtio->SetQueueNotify(), or
+                                 VirtioFs->Virtio->UnmapSharedBuffer().
+**/
+EFI_STATUS
+VirtioFsSgListsSubmitBatch (
+  IN OUT VIRTIO_FS                     *VirtioFs,
+  IN     UINTN                         NumExchanges,
+  IN OUT VIRTIO_FS_SCATTER_GATHER_LIST **RequestSgList,
+  IN OUT VIRTIO_FS_SCATTER_GATHER_LIST **ResponseSgList
+  )
+{
+  VIRTIO_MAP_OPERATION          SgListVirtioMapOp[2];
+  UINT16                        SgListDescriptorFlag[ARRAY_SIZE (SgListVirtioMapOp)];
+  UINT16                        HeadDescIdx[VIRTIO_FS_MAX_EXCHANGES];
+  UINT32                        UsedLen[VIRTIO_FS_MAX_EXCHANGES];
+  BOOLEAN                       Completed[VIRTIO_FS_MAX_EXCHANGES];
+  UINTN                         Exchange;
   UINTN                         ListId;
   VIRTIO_FS_SCATTER_GATHER_LIST *SgList;
   UINTN                         IoVecIdx;
   VIRTIO_FS_IO_VECTOR           *IoVec;
+  UINTN                         DescriptorsNeeded;
   EFI_STATUS                    Status;
   DESC_INDICES                  Indices;
+  UINT16                        AvailIdx;
+  UINT16                        UsedIdx;
+  UINTN                         Pending;
+  UINTN                         PollPeriodUsecs;
   UINT32                        TotalBytesWrittenByDevice;
   UINT32                        BytesPermittedForWrite;
 
-  SgListParam[0]          = RequestSgList;
+  if (NumExchanges == 0 || NumExchanges > VIRTIO_FS_MAX_EXCHANGES) {
+    return EFI_INVALID_PARAMETER;
+  }
+  if (VirtioFs->Broken) {
+    return EFI_DEVICE_ERROR;
+  }
+
   SgListVirtioMapOp[0]    = VirtioOperationBusMasterRead;
   SgListDescriptorFlag[0] = 0;
 
-  SgListParam[1]          = ResponseSgList;
   SgListVirtioMapOp[1]    = VirtioOperationBusMasterWrite;
   SgListDescriptorFlag[1] = VRING_DESC_F_WRITE;
 
   //
-  // Map all IO Vectors.
+  // VirtioFsSgListsValidate() has checked each exchange in isolation; the
+  // chains of all exchanges have to fit in the descriptor table together.
   //
-  for (ListId = 0; ListId < ARRAY_SIZE (SgListParam); ListId++) {
-    SgList = SgListParam[ListId];
-    if (SgList == NULL) {
-      continue;
+  DescriptorsNeeded = 0;
+  for (Exchange = 0; Exchange < NumExchanges; Exchange++) {
+    DescriptorsNeeded += RequestSgList[Exchange]->NumVec;
+    if (ResponseSgList[Exchange] != NULL) {
+      DescriptorsNeeded += ResponseSgList[Exchange]->NumVec;
     }
-    for (IoVecIdx = 0; IoVecIdx < SgList->NumVec; IoVecIdx++) {
-      IoVec = &SgList->IoVec[IoVecIdx];
-      //
-      // Map this IO Vector.
-      //
-      Status = VirtioMapAllBytesInSharedBuffer (
-                 VirtioFs->Virtio,
-                 SgListVirtioMapOp[ListId],
-                 IoVec->Buffer,
-                 IoVec->Size,
-                 &IoVec->MappedAddress,
-                 &IoVec->Mapping
-                 );
-      if (EFI_ERROR (Status)) {
-        goto Unmap;
+  }
+  if (DescriptorsNeeded > VirtioFs->QueueSize) {
+    return EFI_UNSUPPORTED;
+  }
+
+  //
+  // Map all IO Vectors.
+  //
+  Status = EFI_SUCCESS;
+  for (Exchange = 0; Exchange < NumExchanges; Exchange++) {
+    for (ListId = 0; ListId < ARRAY_SIZE (SgListVirtioMapOp); ListId++) {
+      SgList = (ListId == 0) ? RequestSgList[Exchange] :
+                               ResponseSgList[Exchange];
+      if (SgList == NULL) {
+        continue;
+      }
+      for (IoVecIdx = 0; IoVecIdx < SgList->NumVec; IoVecIdx++) {
+        IoVec = &SgList->IoVec[IoVecIdx];
+        //
+        // Map this IO Vector.
+        //
+        Status = VirtioMapAllBytesInSharedBuffer (
+                   VirtioFs->Virtio,
+                   SgListVirtioMapOp[ListId],
+                   IoVec->Buffer,
+                   IoVec->Size,
+                   &IoVec->MappedAddress,
+                   &IoVec->Mapping
+                   );
+        if (EFI_ERROR (Status)) {
+          goto Unmap;
+        }
+        IoVec->Mapped = TRUE;
       }
-      IoVec->Mapped = TRUE;
     }
   }
 
   //
-  // Compose the descriptor chain.
+  // Compose the descriptor chains. Each chain starts where the previous one
+  // ended, and each head goes to the next slot of the available ring.
   //
   VirtioPrepare (&VirtioFs->Ring, &Indices);
-  for (ListId = 0; ListId < ARRAY_SIZE (SgListParam); ListId++) {
-    SgList = SgListParam[ListId];
-    if (SgList == NULL) {
-      continue;
-    }
-    for (IoVecIdx = 0; IoVecIdx < SgList->NumVec; IoVecIdx++) {
-      UINT16 NextFlag;
+  AvailIdx = *VirtioFs->Ring.Avail.Idx;
+  for (Exchange = 0; Exchange < NumExchanges; Exchange++) {
+    UINTN LastListId;
 
-      IoVec = &SgList->IoVec[IoVecIdx];
-      //
-      // Set VRING_DESC_F_NEXT on all except the very last descriptor.
-      //
-      NextFlag = VRING_DESC_F_NEXT;
-      if (ListId == ARRAY_SIZE (SgListParam) - 1 &&
-          IoVecIdx == SgList->NumVec - 1) {
-        NextFlag = 0;
+    LastListId = (ResponseSgList[Exchange] == NULL) ? 0 : 1;
+
+    Indices.HeadDescIdx   = Indices.NextDescIdx;
+    HeadDescIdx[Exchange] = Indices.HeadDescIdx;
+    Completed[Exchange]   = FALSE;
+
+    for (ListId = 0; ListId <= LastListId; ListId++) {
+      SgList = (ListId == 0) ? RequestSgList[Exchange] :
+                               ResponseSgList[Exchange];
+      for (IoVecIdx = 0; IoVecIdx < SgList->NumVec; IoVecIdx++) {
+        UINT16 NextFlag;
+
+        IoVec = &SgList->IoVec[IoVecIdx];
+        //
+        // Set VRING_DESC_F_NEXT on all except the very last descriptor of the
+        // chain.
+        //
+        NextFlag = VRING_DESC_F_NEXT;
+        if (ListId == LastListId && IoVecIdx == SgList->NumVec - 1) {
+          NextFlag = 0;
+        }
+        VirtioAppendDesc (
+          &VirtioFs->Ring,
+          IoVec->MappedAddress,
+          (UINT32)IoVec->Size,
+          SgListDescriptorFlag[ListId] | NextFlag,
+          &Indices
+          );
       }
-      VirtioAppendDesc (
-        &VirtioFs->Ring,
-        IoVec->MappedAddress,
-        (UINT32)IoVec->Size,
-        SgListDescriptorFlag[ListId] | NextFlag,
-        &Indices
-        );
     }
+
+    VirtioFs->Ring.Avail.Ring[(UINT16)(AvailIdx + Exchange) %
+                              VirtioFs->QueueSize] = HeadDescIdx[Exchange];
   }
 
   //
-  // Submit the descriptor chain.
+  // virtio-0.9.5, 2.4.1.3 Updating the Index Field; 2.4.1.4 Notifying the
+  // Device.
   //
-  Status = VirtioFlush (VirtioFs->Virtio, VIRTIO_FS_REQUEST_QUEUE,
-             &VirtioFs->Ring, &Indices, &TotalBytesWrittenByDevice);
+  MemoryFence ();
+  *VirtioFs->Ring.Avail.Idx = (UINT16)(AvailIdx + NumExchanges);
+  MemoryFence ();
+  Status = VirtioFs->Virtio->SetQueueNotify (VirtioFs->Virtio,
+                              VIRTIO_FS_REQUEST_QUEUE);
   if (EFI_ERROR (Status)) {
-    goto Unmap;
+    goto ResetDevice;
   }
 
   //
-  // Sanity-check: the Virtio Filesystem device should not have written more
-  // bytes than what we offered buffers for.
+  // virtio-0.9.5, 2.4.2 Receiving Used Buffers From the Device. All earlier
+  // exchanges have been completed, so the used ring is in sync with the
+  // available ring that we started from. Keep slowing down until we reach a
+  // poll period of slightly above 1 ms, like VirtioFlush() does.
   //
-  if (ResponseSgList == NULL) {
-    BytesPermittedForWrite = 0;
-  } else {
-    BytesPermittedForWrite = ResponseSgList->TotalSize;
-  }
-  if (TotalBytesWrittenByDevice > BytesPermittedForWrite) {
-    Status = EFI_DEVICE_ERROR;
-    goto Unmap;
-  }
+  UsedIdx         = AvailIdx;
+  Pending         = NumExchanges;
+  PollPeriodUsecs = 1;
+  while (Pending > 0) {
+    volatile CONST VRING_USED_ELEM *UsedElem;
 
-  //
-  // Update the transfer sizes in the IO Vectors.
-  //
-  for (ListId = 0; ListId < ARRAY_SIZE (SgListParam); ListId++) {
-    SgList = SgListParam[ListId];
-    if (SgList == NULL) {
+    MemoryFence ();
+    if (*VirtioFs->Ring.Used.Idx == UsedIdx) {
+      gBS->Stall (PollPeriodUsecs);
+      if (PollPeriodUsecs < 1024) {
+        PollPeriodUsecs *= 2;
+      }
       continue;
     }
-    for (IoVecIdx = 0; IoVecIdx < SgList->NumVec; IoVecIdx++) {
-      IoVec = &SgList->IoVec[IoVecIdx];
-      if (SgListVirtioMapOp[ListId] == VirtioOperationBusMasterRead) {
-        //
-        // We report that the Virtio Filesystem device has read all buffers in
-        // the request.
-        //
-        IoVec->Transferred = IoVec->Size;
-      } else {
-        //
-        // Regarding the response, calculate how much of the current IO Vector
-        // has been populated by the Virtio Filesystem device. In
-        // "TotalBytesWrittenByDevice", VirtioFlush() reported the total count
-        // across all device-writeable descriptors, in the order they were
-        // chained on the ring.
-        //
-        IoVec->Transferred = MIN ((UINTN)TotalBytesWrittenByDevice,
-                               IoVec->Size);
-        TotalBytesWrittenByDevice -= (UINT32)IoVec->Transferred;
+    MemoryFence ();
+
+    UsedElem = &VirtioFs->Ring.Used.UsedElem[UsedIdx % VirtioFs->QueueSize];
+    for (Exchange = 0; Exchange < NumExchanges; Exchange++) {
+      if (!Completed[Exchange] && HeadDescIdx[Exchange] == UsedElem->Id) {
+        break;
+      }
+    }
+    if (Exchange == NumExchanges) {
+      DEBUG ((DEBUG_ERROR, "%a: Label=\"%s\" unexpected used Id=%u\n",
+        __FUNCTION__, VirtioFs->Label, UsedElem->Id));
+      Status = EFI_DEVICE_ERROR;
+      goto ResetDevice;
+    }
+    Completed[Exchange] = TRUE;
+    UsedLen[Exchange]   = UsedElem->Len;
+    UsedIdx++;
+    Pending--;
+  }
+
+  for (Exchange = 0; Exchange < NumExchanges; Exchange++) {
+    //
+    // Sanity-check: the Virtio Filesystem device should not have written more
+    // bytes than what we offered buffers for.
+    //
+    TotalBytesWrittenByDevice = UsedLen[Exchange];
+    if (ResponseSgList[Exchange] == NULL) {
+      BytesPermittedForWrite = 0;
+    } else {
+      BytesPermittedForWrite = ResponseSgList[Exchange]->TotalSize;
+    }
+    if (TotalBytesWrittenByDevice > BytesPermittedForWrite) {
+      Status = EFI_DEVICE_ERROR;
+      goto Unmap;
+    }
+
+    //
+    // Update the transfer sizes in the IO Vectors.
+    //
+    for (ListId = 0; ListId < ARRAY_SIZE (SgListVirtioMapOp); ListId++) {
+      SgList = (ListId == 0) ? RequestSgList[Exchange] :
+                               ResponseSgList[Exchange];
+      if (SgList == NULL) {
+        continue;
+      }
+      for (IoVecIdx = 0; IoVecIdx < SgList->NumVec; IoVecIdx++) {
+        IoVec = &SgList->IoVec[IoVecIdx];
+        if (SgListVirtioMapOp[ListId] == VirtioOperationBusMasterRead) {
+          //
+          // We report that the Virtio Filesystem device has read all buffers
+          // in the request.
+          //
+          IoVec->Transferred = IoVec->Size;
+        } else {
+          //
+          // Regarding the response, calculate how much of the current IO
+          // Vector has been populated by the Virtio Filesystem device. The
+          // used element reported the total count across all device-writeable
+          // descriptors, in the order they were chained on the ring.
+          //
+          IoVec->Transferred = MIN ((UINTN)TotalBytesWrittenByDevice,
+                                 IoVec->Size);
+          TotalBytesWrittenByDevice -= (UINT32)IoVec->Transferred;
+        }
       }
     }
+
+    //
+    // By now, "TotalBytesWrittenByDevice" has been exhausted.
+    //
+    ASSERT (TotalBytesWrittenByDevice == 0);
   }
 
   //
-  // By now, "TotalBytesWrittenByDevice" has been exhausted.
+  // We've succeeded; skip the reset.
   //
-  ASSERT (TotalBytesWrittenByDevice == 0);
+  goto Unmap;
 
+ResetDevice:
   //
-  // We've succeeded; fall through.
+  // The device may still own some of the exchanges of the batch, and write to
+  // their buffers. The only way to get them back before unmapping them is to
+  // reset the device, which makes the driver unusable until it is restarted.
   //
+  VirtioFs->Virtio->SetDeviceStatus (VirtioFs->Virtio, 0);
+  VirtioFs->Broken = TRUE;
+
 Unmap:
   //
   // Unmap all mapped IO Vectors on both the success and the error paths. The
   // unmapping occurs in reverse order of mapping, in an attempt to avoid
   // memory fragmentation.
   //
-  ListId = ARRAY_SIZE (SgListParam);
-  while (ListId > 0) {
-    --ListId;
-    SgList = SgListParam[ListId];
-    if (SgList == NULL) {
-      continue;
-    }
-    IoVecIdx = SgList->NumVec;
-    while (IoVecIdx > 0) {
-      EFI_STATUS UnmapStatus;
-
-      --IoVecIdx;
-      IoVec = &SgList->IoVec[IoVecIdx];
-      //
-      // Unmap this IO Vector, if it has been mapped.
-      //
-      if (!IoVec->Mapped) {
+  Exchange = NumExchanges;
+  while (Exchange > 0) {
+    --Exchange;
+    ListId = ARRAY_SIZE (SgListVirtioMapOp);
+    while (ListId > 0) {
+      --ListId;
+      SgList = (ListId == 0) ? RequestSgList[Exchange] :
+                               ResponseSgList[Exchange];
+      if (SgList == NULL) {
         continue;
       }
-      UnmapStatus = VirtioFs->Virtio->UnmapSharedBuffer (VirtioFs->Virtio,
-                                        IoVec->Mapping);
-      //
-      // Re-set the following fields to the values they initially got from
-      // VirtioFsSgListsValidate() -- the above unmapping attempt is considered
-      // final, even if it fails.
-      //
-      IoVec->Mapped        = FALSE;
-      IoVec->MappedAddress = 0;
-      IoVec->Mapping       = NULL;
+      IoVecIdx = SgList->NumVec;
+      while (IoVecIdx > 0) {
+        EFI_STATUS UnmapStatus;
 
-      //
-      // If we are on the success path, but the unmapping failed, we need to
-      // transparently flip to the failure path -- the caller must learn they
-      // should not consult the response buffers.
-      //
-      // The branch below can be taken at most once.
-      //
-      if (!EFI_ERROR (Status) && EFI_ERROR (UnmapStatus)) {
-        Status = UnmapStatus;
+        --IoVecIdx;
+        IoVec = &SgList->IoVec[IoVecIdx];
+        //
+        // Unmap this IO Vector, if it has been mapped.
+        //
+        if (!IoVec->Mapped) {
+          continue;
+        }
+        UnmapStatus = VirtioFs->Virtio->UnmapSharedBuffer (VirtioFs->Virtio,
+                                          IoVec->Mapping);
+        //
+        // Re-set the following fields to the values they initially got from
+        // VirtioFsSgListsValidate() -- the above unmapping attempt is
+        // considered final, even if it fails.
+        //
+        IoVec->Mapped        = FALSE;
+        IoVec->MappedAddress = 0;
+        IoVec->Mapping       = NULL;
+
+        //
+        // If we are on the success path, but the unmapping failed, we need to
+        // transparently flip to the failure path -- the caller must learn they
+        // should not consult the response buffers.
+        //
+        // The branch below can be taken at most once.
+        //
+        if (!EFI_ERROR (Status) && EFI_ERROR (UnmapStatus)) {
+          Status = UnmapStatus;
+        }
       }
     }
   }
@@ -774,8 +957,8 @@ VirtioFsFuseNewRequest (
   and excluding the last one, are assumed fixed size. The last response buffer
   may or may not be fixed size, as specified by the caller.
 
-  This function may only be called after VirtioFsSgListsSubmit() returns
-  successfully.
+  This function may only be called after VirtioFsSgListsSubmit() or
+  VirtioFsSgListsSubmitBatch() returns successfully.
 
   @param[in] ResponseSgList   The scatter-gather list that describes the
                               response part of the exchange -- the buffers that
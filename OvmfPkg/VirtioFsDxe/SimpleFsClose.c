@@ -63,6 +63,9 @@ VirtioFsSimpleFileClose (
   if (VirtioFsFile->FileInfoArray != NULL) {
     FreePool (VirtioFsFile->FileInfoArray);
   }
+  if (VirtioFsFile->ReadAheadBuffer != NULL) {
+    FreePool (VirtioFsFile->ReadAheadBuffer);
+  }
   FreePool (VirtioFsFile);
   return EFI_SUCCESS;
 }
@@ -105,6 +105,9 @@ VirtioFsSimpleFileDelete (
   if (VirtioFsFile->FileInfoArray != NULL) {
     FreePool (VirtioFsFile->FileInfoArray);
   }
+  if (VirtioFsFile->ReadAheadBuffer != NULL) {
+    FreePool (VirtioFsFile->ReadAheadBuffer);
+  }
   FreePool (VirtioFsFile);
   return Status;
 }
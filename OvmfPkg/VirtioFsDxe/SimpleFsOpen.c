@@ -497,6 +497,11 @@ VirtioFsSimpleFileOpen (
   NewVirtioFsFile->SingleFileInfoSize     = 0;
   NewVirtioFsFile->NumFileInfo            = 0;
   NewVirtioFsFile->NextFileInfo           = 0;
+  NewVirtioFsFile->ReadAheadBuffer        = NULL;
+  NewVirtioFsFile->ReadAheadOffset        = 0;
+  NewVirtioFsFile->ReadAheadFill          = 0;
+  NewVirtioFsFile->ReadAheadExpiry        = 0;
+  NewVirtioFsFile->NextSequentialPosition = 0;
 
   //
   // One more file is now open for the filesystem.
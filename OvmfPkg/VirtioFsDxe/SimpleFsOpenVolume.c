@@ -79,6 +79,11 @@ VirtioFsOpenVolume (
   VirtioFsFile->SingleFileInfoSize     = 0;
   VirtioFsFile->NumFileInfo            = 0;
   VirtioFsFile->NextFileInfo           = 0;
+  VirtioFsFile->ReadAheadBuffer        = NULL;
+  VirtioFsFile->ReadAheadOffset        = 0;
+  VirtioFsFile->ReadAheadFill          = 0;
+  VirtioFsFile->ReadAheadExpiry        = 0;
+  VirtioFsFile->NextSequentialPosition = 0;
 
   //
   // One more file open for the filesystem.
@@ -351,6 +351,12 @@ ReadFileInfoCache (
 
 /**
   Read from a regular file.
+
+  Small reads that continue where the previous read ended are served from the
+  read-ahead window of the file, which is refilled with a single FUSE_READ of
+  VirtioFs->ReadAhead bytes, and which expires with the cached attributes of
+  the file. Other reads go directly to the caller's buffer,
+  with multiple FUSE_READ requests in flight.
 **/
 STATIC
 EFI_STATUS
@@ -363,6 +369,7 @@ ReadRegularFile (
   VIRTIO_FS                          *VirtioFs;
   EFI_STATUS                         Status;
   VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE FuseAttr;
+  BOOLEAN                            Sequential;
   UINTN                              Transferred;
   UINTN                              Left;
 
@@ -374,35 +381,95 @@ ReadRegularFile (
   if (EFI_ERROR (Status) || VirtioFsFile->FilePosition > FuseAttr.Size) {
     return EFI_DEVICE_ERROR;
   }
+  VirtioFsCacheAgeReadAhead (VirtioFs, VirtioFsFile);
 
+  Sequential  = (BOOLEAN)(VirtioFsFile->FilePosition ==
+                          VirtioFsFile->NextSequentialPosition);
   Status      = EFI_SUCCESS;
   Transferred = 0;
   Left        = *BufferSize;
   while (Left > 0) {
-    UINT32 ReadSize;
+    UINT64 Position;
+    UINTN  ReadSize;
+    UINT32 FillSize;
+
+    Position = VirtioFsFile->FilePosition + Transferred;
 
     //
-    // FUSE_READ cannot express a >=4GB buffer size.
+    // Copy out what the read-ahead window has at Position.
     //
-    ReadSize = (UINT32)MIN ((UINTN)MAX_UINT32, Left);
-    Status = VirtioFsFuseReadFileOrDir (
+    if (VirtioFsFile->ReadAheadFill > 0 &&
+        Position >= VirtioFsFile->ReadAheadOffset &&
+        Position - VirtioFsFile->ReadAheadOffset <
+        VirtioFsFile->ReadAheadFill) {
+      UINTN WindowOffset;
+
+      WindowOffset = (UINTN)(Position - VirtioFsFile->ReadAheadOffset);
+      ReadSize     = MIN (Left, VirtioFsFile->ReadAheadFill - WindowOffset);
+      CopyMem (
+        (UINT8 *)Buffer + Transferred,
+        VirtioFsFile->ReadAheadBuffer + WindowOffset,
+        ReadSize
+        );
+      Transferred += ReadSize;
+      Left        -= ReadSize;
+      continue;
+    }
+
+    //
+    // Refill the window at Position for a small sequential read.
+    //
+    if (Sequential && Left < VirtioFs->ReadAhead) {
+      if (VirtioFsFile->ReadAheadBuffer == NULL) {
+        VirtioFsFile->ReadAheadBuffer = AllocatePool (VirtioFs->ReadAhead);
+        if (VirtioFsFile->ReadAheadBuffer == NULL) {
+          Sequential = FALSE;
+          continue;
+        }
+      }
+      VirtioFsFile->ReadAheadFill = 0;
+      FillSize = VirtioFs->ReadAhead;
+      Status = VirtioFsFuseReadFileOrDir (
+                 VirtioFs,
+                 VirtioFsFile->NodeId,
+                 VirtioFsFile->FuseHandle,
+                 FALSE,                                    // IsDir
+                 Position,
+                 &FillSize,
+                 VirtioFsFile->ReadAheadBuffer
+                 );
+      if (EFI_ERROR (Status) || FillSize == 0) {
+        break;
+      }
+      VirtioFsFile->ReadAheadOffset = Position;
+      VirtioFsFile->ReadAheadFill   = FillSize;
+      VirtioFsCacheSetReadAhead (VirtioFs, VirtioFsFile);
+      continue;
+    }
+
+    //
+    // Read the rest directly into the caller's buffer, in window-sized chunks
+    // that the device can service in parallel. This stops at EOF or at the
+    // first error.
+    //
+    ReadSize = Left;
+    Status = VirtioFsFuseReadFileBatch (
                VirtioFs,
                VirtioFsFile->NodeId,
                VirtioFsFile->FuseHandle,
-               FALSE,                                    // IsDir
-               VirtioFsFile->FilePosition + Transferred,
+               Position,
+               VirtioFs->ReadAhead,
                &ReadSize,
                (UINT8 *)Buffer + Transferred
                );
-    if (EFI_ERROR (Status) || ReadSize == 0) {
-      break;
-    }
     Transferred += ReadSize;
     Left        -= ReadSize;
+    break;
   }
 
   *BufferSize = Transferred;
-  VirtioFsFile->FilePosition += Transferred;
+  VirtioFsFile->FilePosition          += Transferred;
+  VirtioFsFile->NextSequentialPosition = VirtioFsFile->FilePosition;
   //
   // If we managed to read some data, return success. If zero bytes were
   // transferred due to zero-sized buffer on input or due to EOF on first read,
@@ -52,6 +52,40 @@
 //
 #define VIRTIO_FS_FILE_MAX_FILE_INFO 256
 
+//
+// Maximum number of request-response exchanges that VirtioFsSgListsSubmitBatch()
+// can place on the request queue at once.
+//
+#define VIRTIO_FS_MAX_EXCHANGES 8
+
+//
+// Upper limit for the read-ahead window of a regular file. The window is
+// further limited by the FUSE_INIT-negotiated VIRTIO_FS.MaxWrite.
+//
+#define VIRTIO_FS_MAX_READ_AHEAD SIZE_128KB
+
+//
+// Number of entries in the lookup cache, and in the attribute cache.
+//
+#define VIRTIO_FS_LOOKUP_CACHE_ENTRIES 64
+#define VIRTIO_FS_ATTR_CACHE_ENTRIES   64
+
+//
+// Longest filename (in CHAR8 elements, excluding the terminating '\0') that
+// the lookup cache stores. Longer names are always looked up on the device.
+//
+#define VIRTIO_FS_LOOKUP_CACHE_NAME_LENGTH 63
+
+//
+// Period of the clock against which the validity timeouts of cache entries
+// are measured, in milliseconds. The FUSE-provided timeouts are truncated to
+// whole clock periods (so a timeout shorter than one period disables caching
+// for the entry), and capped at VIRTIO_FS_CACHE_MAX_TICKS periods. The clock
+// only runs until the last expiry time that has been handed out.
+//
+#define VIRTIO_FS_CACHE_TICK_MS   10
+#define VIRTIO_FS_CACHE_MAX_TICKS (3600 * (1000 / VIRTIO_FS_CACHE_TICK_MS))
+
 //
 // Filesystem label encoded in UCS-2, transformed from the UTF-8 representation
 // in "VIRTIO_FS_CONFIG.Tag", and NUL-terminated. Only the printable ASCII code
@@ -59,6 +93,41 @@
 //
 typedef CHAR16 VIRTIO_FS_LABEL[VIRTIO_FS_TAG_BYTES + 1];
 
+//
+// Entry in the lookup cache, resolving (DirNodeId, Name) to NodeId.
+//
+// FUSE_LOOKUP increments the lookup count of the inode on the device side;
+// every such reference has to be returned with FUSE_FORGET. ServerRefs counts
+// the references that the device has handed out for this entry. LocalRefs
+// counts the references that callers of VirtioFsFuseLookup() hold via this
+// entry (and that VirtioFsFuseForget() will consume). While LocalRefs is
+// positive, the entry may not be evicted. When the entry is evicted, a single
+// FUSE_FORGET returns all of ServerRefs.
+//
+// Stale entries are not used for resolving names anymore; they only wait for
+// LocalRefs to drop to zero.
+//
+typedef struct {
+  BOOLEAN InUse;
+  BOOLEAN Stale;
+  UINT32  Expiry;
+  UINT64  DirNodeId;
+  UINT64  NodeId;
+  UINT64  ServerRefs;
+  UINT64  LocalRefs;
+  CHAR8   Name[VIRTIO_FS_LOOKUP_CACHE_NAME_LENGTH + 1];
+} VIRTIO_FS_LOOKUP_CACHE_ENTRY;
+
+//
+// Entry in the attribute cache, which is direct-mapped by NodeId. FUSE never
+// uses the zero NodeId, so NodeId==0 marks an empty entry.
+//
+typedef struct {
+  UINT64                             NodeId;
+  UINT32                             Expiry;
+  VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE Attr;
+} VIRTIO_FS_ATTR_CACHE_ENTRY;
+
 //
 // Main context structure, expressing an EFI_SIMPLE_FILE_SYSTEM_PROTOCOL
 // interface on top of the Virtio Filesystem device.
@@ -69,19 +138,32 @@ typedef struct {
   // at various call depths. The table to the right should make it easier to
   // track them.
   //
-  //                              field         init function       init depth
-  //                              -----------   ------------------  ----------
-  UINT64                          Signature; // DriverBindingStart  0
-  VIRTIO_DEVICE_PROTOCOL          *Virtio;   // DriverBindingStart  0
-  VIRTIO_FS_LABEL                 Label;     // VirtioFsInit        1
-  UINT16                          QueueSize; // VirtioFsInit        1
-  VRING                           Ring;      // VirtioRingInit      2
-  VOID                            *RingMap;  // VirtioRingMap       2
-  UINT64                          RequestId; // FuseInitSession     1
-  UINT32                          MaxWrite;  // FuseInitSession     1
-  EFI_EVENT                       ExitBoot;  // DriverBindingStart  0
-  LIST_ENTRY                      OpenFiles; // DriverBindingStart  0
-  EFI_SIMPLE_FILE_SYSTEM_PROTOCOL SimpleFs;  // DriverBindingStart  0
+  //                              field           init function       init depth
+  //                              -------------   ------------------  ----------
+  UINT64                          Signature;   // DriverBindingStart  0
+  VIRTIO_DEVICE_PROTOCOL          *Virtio;     // DriverBindingStart  0
+  VIRTIO_FS_LABEL                 Label;       // VirtioFsInit        1
+  UINT16                          QueueSize;   // VirtioFsInit        1
+  VRING                           Ring;        // VirtioRingInit      2
+  VOID                            *RingMap;    // VirtioRingMap       2
+  UINT64                          RequestId;   // FuseInitSession     1
+  UINT32                          MaxWrite;    // FuseInitSession     1
+  UINT32                          ReadAhead;   // FuseInitSession     1
+  BOOLEAN                         Broken;      // VirtioFsInit        1
+  EFI_EVENT                       CacheClock;  // VirtioFsCacheInit   1
+  volatile UINT32                 CacheTime;   // VirtioFsCacheInit   1
+  BOOLEAN                         CacheClockArmed;
+                                               // VirtioFsCacheInit   1
+  UINT32                          CacheLastExpiry;
+                                               // VirtioFsCacheInit   1
+  UINTN                           CacheVictim; // VirtioFsCacheInit   1
+  EFI_EVENT                       ExitBoot;    // DriverBindingStart  0
+  LIST_ENTRY                      OpenFiles;   // DriverBindingStart  0
+  EFI_SIMPLE_FILE_SYSTEM_PROTOCOL SimpleFs;    // DriverBindingStart  0
+  VIRTIO_FS_LOOKUP_CACHE_ENTRY    LookupCache[VIRTIO_FS_LOOKUP_CACHE_ENTRIES];
+                                               // VirtioFsCacheInit   1
+  VIRTIO_FS_ATTR_CACHE_ENTRY      AttrCache[VIRTIO_FS_ATTR_CACHE_ENTRIES];
+                                               // VirtioFsCacheInit   1
 } VIRTIO_FS;
 
 #define VIRTIO_FS_FROM_SIMPLE_FS(SimpleFsReference) \
@@ -109,10 +191,10 @@ typedef struct {
   EFI_PHYSICAL_ADDRESS MappedAddress;
   VOID                 *Mapping;
   //
-  // Transferred is updated after VirtioFlush() returns successfully:
+  // Transferred is updated after the device completes the exchange:
   // - for VirtioOperationBusMasterRead, Transferred is set to Size;
   // - for VirtioOperationBusMasterWrite, Transferred is calculated from the
-  //   UsedLen output parameter of VirtioFlush().
+  //   length that the device reported in the used ring element.
   //
   UINTN Transferred;
 } VIRTIO_FS_IO_VECTOR;
@@ -174,6 +256,22 @@ typedef struct {
   UINTN SingleFileInfoSize;
   UINTN NumFileInfo;
   UINTN NextFileInfo;
+  //
+  // Read-ahead window for sequential reads from a regular file.
+  //
+  // Small reads that continue where the previous read ended are served from
+  // ReadAheadBuffer, which holds ReadAheadFill bytes of the file, starting at
+  // ReadAheadOffset. The buffer is refilled with a single FUSE_READ of
+  // VIRTIO_FS.ReadAhead bytes. NextSequentialPosition is the file position at
+  // which the most recent read ended. The window is dropped whenever the file
+  // (by NodeId) is written or its attributes are changed, and it expires
+  // together with the cached attributes it was read under (ReadAheadExpiry).
+  //
+  UINT8  *ReadAheadBuffer;
+  UINT64 ReadAheadOffset;
+  UINTN  ReadAheadFill;
+  UINT32 ReadAheadExpiry;
+  UINT64 NextSequentialPosition;
 } VIRTIO_FS_FILE;
 
 #define VIRTIO_FS_FILE_FROM_SIMPLE_FILE(SimpleFileReference) \
@@ -218,6 +316,14 @@ VirtioFsSgListsSubmit (
   IN OUT VIRTIO_FS_SCATTER_GATHER_LIST *ResponseSgList OPTIONAL
   );
 
+EFI_STATUS
+VirtioFsSgListsSubmitBatch (
+  IN OUT VIRTIO_FS                     *VirtioFs,
+  IN     UINTN                         NumExchanges,
+  IN OUT VIRTIO_FS_SCATTER_GATHER_LIST **RequestSgList,
+  IN OUT VIRTIO_FS_SCATTER_GATHER_LIST **ResponseSgList
+  );
+
 EFI_STATUS
 VirtioFsFuseNewRequest (
   IN OUT VIRTIO_FS              *VirtioFs,
@@ -308,6 +414,83 @@ VirtioFsGetFuseModeUpdate (
      OUT UINT32        *Mode
      );
 
+//
+// Lookup and attribute cache for the Virtio Filesystem device.
+//
+
+EFI_STATUS
+VirtioFsCacheInit (
+  IN OUT VIRTIO_FS *VirtioFs
+  );
+
+VOID
+VirtioFsCacheUninit (
+  IN OUT VIRTIO_FS *VirtioFs
+  );
+
+BOOLEAN
+VirtioFsCacheLookup (
+  IN OUT VIRTIO_FS                          *VirtioFs,
+  IN     UINT64                             DirNodeId,
+  IN     CHAR8                              *Name,
+     OUT UINT64                             *NodeId,
+     OUT VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE *FuseAttr
+  );
+
+VOID
+VirtioFsCacheAddLookup (
+  IN OUT VIRTIO_FS                          *VirtioFs,
+  IN     UINT64                             DirNodeId,
+  IN     CHAR8                              *Name,
+  IN     VIRTIO_FS_FUSE_NODE_RESPONSE       *NodeResp,
+  IN     VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE *FuseAttr
+  );
+
+BOOLEAN
+VirtioFsCacheForget (
+  IN OUT VIRTIO_FS *VirtioFs,
+  IN     UINT64    NodeId
+  );
+
+BOOLEAN
+VirtioFsCacheGetAttr (
+  IN OUT VIRTIO_FS                          *VirtioFs,
+  IN     UINT64                             NodeId,
+     OUT VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE *FuseAttr
+  );
+
+VOID
+VirtioFsCacheSetAttr (
+  IN OUT VIRTIO_FS                          *VirtioFs,
+  IN     UINT64                             NodeId,
+  IN     VIRTIO_FS_FUSE_ATTRIBUTES_RESPONSE *FuseAttr,
+  IN     UINT64                             AttrValid,
+  IN     UINT32                             AttrValidNsec
+  );
+
+VOID
+VirtioFsCacheSetReadAhead (
+  IN OUT VIRTIO_FS      *VirtioFs,
+  IN OUT VIRTIO_FS_FILE *VirtioFsFile
+  );
+
+VOID
+VirtioFsCacheAgeReadAhead (
+  IN     VIRTIO_FS      *VirtioFs,
+  IN OUT VIRTIO_FS_FILE *VirtioFsFile
+  );
+
+VOID
+VirtioFsCacheInvalidateNode (
+  IN OUT VIRTIO_FS *VirtioFs,
+  IN     UINT64    NodeId
+  );
+
+VOID
+VirtioFsCacheInvalidateNames (
+  IN OUT VIRTIO_FS *VirtioFs
+  );
+
 //
 // Wrapper functions for FUSE commands (primitives).
 //
@@ -327,6 +510,13 @@ VirtioFsFuseForget (
   IN     UINT64    NodeId
   );
 
+EFI_STATUS
+VirtioFsFuseForgetLookups (
+  IN OUT VIRTIO_FS *VirtioFs,
+  IN     UINT64    NodeId,
+  IN     UINT64    NumberOfLookups
+  );
+
 EFI_STATUS
 VirtioFsFuseGetAttr (
   IN OUT VIRTIO_FS                          *VirtioFs,
@@ -379,6 +569,17 @@ VirtioFsFuseReadFileOrDir (
      OUT VOID      *Data
   );
 
+EFI_STATUS
+VirtioFsFuseReadFileBatch (
+  IN OUT VIRTIO_FS *VirtioFs,
+  IN     UINT64    NodeId,
+  IN     UINT64    FuseHandle,
+  IN     UINT64    Offset,
+  IN     UINT32    ChunkSize,
+  IN OUT UINTN     *Size,
+     OUT VOID      *Data
+  );
+
 EFI_STATUS
 VirtioFsFuseWrite (
   IN OUT VIRTIO_FS *VirtioFs,
@@ -135,14 +135,15 @@ ReleaseQueue:
   - tracking of heads of free descriptor chains from the above,
   - one common virtio-net request header (never modified by the host) for all
     pending TX packets,
+  - one bounce buffer per pending TX packet, mapped for the device once,
   - select polling over TX interrupt.
 
   @param[in,out] Dev       The VNET_DEV driver instance about to enter the
                            EfiSimpleNetworkInitialized state.
 
   @retval EFI_OUT_OF_RESOURCES  Failed to allocate the stack to track the heads
-                                of free descriptor chains or failed to init
-                                TxBufCollection.
+                                of free descriptor chains or the array to
+                                track the caller buffers of pending packets.
   @return                       Status codes from VIRTIO_DEVICE_PROTOCOL.
                                 AllocateSharedPages() or
                                 VirtioMapAllBytesInSharedBuffer()
@@ -158,12 +159,15 @@ VirtioNetInitTx (
 {
   UINTN                 TxSharedReqSize;
   UINTN                 PktIdx;
+  UINTN                 NumBytes;
   EFI_STATUS            Status;
   EFI_PHYSICAL_ADDRESS  DeviceAddress;
+  EFI_PHYSICAL_ADDRESS  TxBufDeviceAddress;
   VOID                  *TxSharedReqBuffer;
+  VOID                  *TxBuffer;
 
   Dev->TxMaxPending = (UINT16) MIN (Dev->TxRing.QueueSize / 2,
-                                 VNET_MAX_PENDING);
+                                 VNET_MAX_TX_PENDING);
   Dev->TxCurPending = 0;
   Dev->TxFreeStack  = AllocatePool (Dev->TxMaxPending *
                         sizeof *Dev->TxFreeStack);
@@ -171,11 +175,9 @@ VirtioNetInitTx (
     return EFI_OUT_OF_RESOURCES;
   }
 
-  Dev->TxBufCollection = OrderedCollectionInit (
-                           VirtioNetTxBufMapInfoCompare,
-                           VirtioNetTxBufDeviceAddressCompare
-                           );
-  if (Dev->TxBufCollection == NULL) {
+  Dev->TxCallerBuf = AllocateZeroPool (Dev->TxMaxPending *
+                       sizeof *Dev->TxCallerBuf);
+  if (Dev->TxCallerBuf == NULL) {
     Status = EFI_OUT_OF_RESOURCES;
     goto FreeTxFreeStack;
   }
@@ -190,7 +192,7 @@ VirtioNetInitTx (
                           &TxSharedReqBuffer
                           );
   if (EFI_ERROR (Status)) {
-    goto UninitTxBufCollection;
+    goto FreeTxCallerBuf;
   }
 
   ZeroMem (TxSharedReqBuffer, sizeof *Dev->TxSharedReq);
@@ -209,14 +211,40 @@ VirtioNetInitTx (
 
   Dev->TxSharedReq = TxSharedReqBuffer;
 
-
   //
-  // In VirtIo 1.0, the NumBuffers field is mandatory. In 0.9.5, it depends on
-  // VIRTIO_NET_F_MRG_RXBUF, which we never negotiate.
+  // Packets are copied into per-descriptor-chain bounce buffers, which are
+  // mapped only once, rather than mapping and unmapping each caller-supplied
+  // buffer on the fly. A maximum size Ethernet frame is much cheaper to copy
+  // than a pool allocation plus a map / unmap pair, especially when the
+  // mapping bounces anyway (for example with SEV).
   //
-  TxSharedReqSize = (Dev->VirtIo->Revision < VIRTIO_SPEC_REVISION (1, 0, 0)) ?
-                    sizeof (Dev->TxSharedReq->V0_9_5) :
-                    sizeof *Dev->TxSharedReq;
+  Dev->TxBufSize = Dev->Snm.MediaHeaderSize + Dev->Snm.MaxPacketSize;
+  NumBytes = Dev->TxMaxPending * Dev->TxBufSize;
+  Dev->TxBufNrPages = EFI_SIZE_TO_PAGES (NumBytes);
+  Status = Dev->VirtIo->AllocateSharedPages (
+                          Dev->VirtIo,
+                          Dev->TxBufNrPages,
+                          &TxBuffer
+                          );
+  if (EFI_ERROR (Status)) {
+    goto UnmapTxSharedReqBuffer;
+  }
+
+  Status = VirtioMapAllBytesInSharedBuffer (
+             Dev->VirtIo,
+             VirtioOperationBusMasterCommonBuffer,
+             TxBuffer,
+             NumBytes,
+             &TxBufDeviceAddress,
+             &Dev->TxBufMap
+             );
+  if (EFI_ERROR (Status)) {
+    goto FreeTxBuffer;
+  }
+
+  Dev->TxBuf = TxBuffer;
+
+  TxSharedReqSize = VirtioNetReqSize (Dev);
 
   for (PktIdx = 0; PktIdx < Dev->TxMaxPending; ++PktIdx) {
     UINT16 DescIdx;
@@ -234,10 +262,13 @@ VirtioNetInitTx (
     Dev->TxRing.Desc[DescIdx].Next  = (UINT16) (DescIdx + 1);
 
     //
-    // The second descriptor of each pending TX packet is updated on the fly,
-    // but it always terminates the descriptor chain of the packet.
+    // The second descriptor of each pending TX packet points to the bounce
+    // buffer of the chain; only its length is updated on the fly. It always
+    // terminates the descriptor chain of the packet.
     //
+    Dev->TxRing.Desc[DescIdx + 1].Addr  = TxBufDeviceAddress;
     Dev->TxRing.Desc[DescIdx + 1].Flags = 0;
+    TxBufDeviceAddress += Dev->TxBufSize;
   }
 
   //
@@ -247,7 +278,8 @@ VirtioNetInitTx (
   Dev->TxSharedReq->V0_9_5.GsoType = VIRTIO_NET_HDR_GSO_NONE;
 
   //
-  // For VirtIo 1.0 only -- the field exists, but it is unused
+  // For VirtIo 1.0 and VIRTIO_NET_F_MRG_RXBUF only -- the field exists, but
+  // it is unused
   //
   Dev->TxSharedReq->NumBuffers = 0;
 
@@ -262,9 +294,20 @@ VirtioNetInitTx (
   // want no interrupt when a transmit completes
   //
   *Dev->TxRing.Avail.Flags = (UINT16) VRING_AVAIL_F_NO_INTERRUPT;
+  VirtioRingSuppressInterrupts (&Dev->TxRing, Dev->TxLastUsed, Dev->EventIdx);
 
   return EFI_SUCCESS;
 
+FreeTxBuffer:
+  Dev->VirtIo->FreeSharedPages (
+                 Dev->VirtIo,
+                 Dev->TxBufNrPages,
+                 TxBuffer
+                 );
+
+UnmapTxSharedReqBuffer:
+  Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, Dev->TxSharedReqMap);
+
 FreeTxSharedReqBuffer:
   Dev->VirtIo->FreeSharedPages (
                  Dev->VirtIo,
@@ -272,8 +315,8 @@ FreeTxSharedReqBuffer:
                  TxSharedReqBuffer
                  );
 
-UninitTxBufCollection:
-  OrderedCollectionUninit (Dev->TxBufCollection);
+FreeTxCallerBuf:
+  FreePool (Dev->TxCallerBuf);
 
 FreeTxFreeStack:
   FreePool (Dev->TxFreeStack);
@@ -293,7 +336,8 @@ FreeTxFreeStack:
     packet data into,
   - select polling over RX interrupt,
   - fully populate the RX queue with a static pattern of virtio descriptor
-    chains.
+    chains (two-part chains, or single descriptors if VIRTIO_NET_F_MRG_RXBUF
+    has been negotiated).
 
   @param[in,out] Dev       The VNET_DEV driver instance about to enter the
                            EfiSimpleNetworkInitialized state.
@@ -313,37 +357,41 @@ VirtioNetInitRx (
   )
 {
   EFI_STATUS            Status;
-  UINTN                 VirtioNetReqSize;
+  UINTN                 ReqSize;
   UINTN                 RxBufSize;
-  UINT16                RxAlwaysPending;
   UINTN                 PktIdx;
   UINT16                DescIdx;
   UINTN                 NumBytes;
   EFI_PHYSICAL_ADDRESS  RxBufDeviceAddress;
   VOID                  *RxBuffer;
 
-  //
-  // In VirtIo 1.0, the NumBuffers field is mandatory. In 0.9.5, it depends on
-  // VIRTIO_NET_F_MRG_RXBUF, which we never negotiate.
-  //
-  VirtioNetReqSize = (Dev->VirtIo->Revision < VIRTIO_SPEC_REVISION (1, 0, 0)) ?
-                     sizeof (VIRTIO_NET_REQ) :
-                     sizeof (VIRTIO_1_0_NET_REQ);
+  ReqSize = VirtioNetReqSize (Dev);
 
   //
-  // For each incoming packet we must supply two descriptors:
+  // Each RX buffer accommodates the virtio-net request header plus the
+  // network data (which consists of Ethernet header and Ethernet payload).
+  //
+  // Without VIRTIO_NET_F_MRG_RXBUF, we must supply two descriptors per RX
+  // buffer:
   // - the recipient for the virtio-net request header, plus
-  // - the recipient for the network data (which consists of Ethernet header
-  //   and Ethernet payload).
+  // - the recipient for the network data.
+  //
+  // With VIRTIO_NET_F_MRG_RXBUF, the host places the header and the data into
+  // a single descriptor, and may spread a packet over several RX buffers (it
+  // never does in practice, because each buffer fits a full frame). This
+  // allows for twice as many RX buffers pre-posted on the same queue.
   //
-  RxBufSize = VirtioNetReqSize +
-              (Dev->Snm.MediaHeaderSize + Dev->Snm.MaxPacketSize);
+  RxBufSize = ReqSize + (Dev->Snm.MediaHeaderSize + Dev->Snm.MaxPacketSize);
 
   //
-  // Limit the number of pending RX packets if the queue is big. The division
-  // by two is due to the above "two descriptors per packet" trait.
+  // Limit the number of pending RX packets if the queue is big.
   //
-  RxAlwaysPending = (UINT16) MIN (Dev->RxRing.QueueSize / 2, VNET_MAX_PENDING);
+  Dev->RxMaxPending = (UINT16) MIN (
+                                 Dev->RxMergeable ?
+                                 Dev->RxRing.QueueSize :
+                                 Dev->RxRing.QueueSize / 2,
+                                 VNET_MAX_RX_PENDING
+                                 );
 
   //
   // The RxBuf is shared between guest and hypervisor, use
@@ -351,7 +399,7 @@ VirtioNetInitRx (
   // BusMasterCommonBuffer so that it can be accessed by both guest and
   // hypervisor.
   //
-  NumBytes = RxAlwaysPending * RxBufSize;
+  NumBytes = Dev->RxMaxPending * RxBufSize;
   Dev->RxBufNrPages = EFI_SIZE_TO_PAGES (NumBytes);
   Status = Dev->VirtIo->AllocateSharedPages (
                           Dev->VirtIo,
@@ -391,14 +439,15 @@ VirtioNetInitRx (
   // and VirtioNetIsPacketAvailable().
   //
   *Dev->RxRing.Avail.Flags = (UINT16) VRING_AVAIL_F_NO_INTERRUPT;
+  VirtioRingSuppressInterrupts (&Dev->RxRing, Dev->RxLastUsed, Dev->EventIdx);
 
   //
-  // now set up a separate, two-part descriptor chain for each RX packet, and
-  // link each chain into (from) the available ring as well
+  // now set up a separate descriptor chain for each RX packet, and link each
+  // chain into (from) the available ring as well
   //
   DescIdx = 0;
   RxBufDeviceAddress = Dev->RxBufDeviceBase;
-  for (PktIdx = 0; PktIdx < RxAlwaysPending; ++PktIdx) {
+  for (PktIdx = 0; PktIdx < Dev->RxMaxPending; ++PktIdx) {
     //
     // virtio-0.9.5, 2.4.1.2 Updating the Available Ring
     // invisible to the host until we update the Index Field
@@ -408,14 +457,22 @@ VirtioNetInitRx (
     //
     // virtio-0.9.5, 2.4.1.1 Placing Buffers into the Descriptor Table
     //
+    if (Dev->RxMergeable) {
+      Dev->RxRing.Desc[DescIdx].Addr  = RxBufDeviceAddress;
+      Dev->RxRing.Desc[DescIdx].Len   = (UINT32) RxBufSize;
+      Dev->RxRing.Desc[DescIdx].Flags = VRING_DESC_F_WRITE;
+      RxBufDeviceAddress += Dev->RxRing.Desc[DescIdx++].Len;
+      continue;
+    }
+
     Dev->RxRing.Desc[DescIdx].Addr  = RxBufDeviceAddress;
-    Dev->RxRing.Desc[DescIdx].Len   = (UINT32) VirtioNetReqSize;
+    Dev->RxRing.Desc[DescIdx].Len   = (UINT32) ReqSize;
     Dev->RxRing.Desc[DescIdx].Flags = VRING_DESC_F_WRITE | VRING_DESC_F_NEXT;
     Dev->RxRing.Desc[DescIdx].Next  = (UINT16) (DescIdx + 1);
     RxBufDeviceAddress += Dev->RxRing.Desc[DescIdx++].Len;
 
     Dev->RxRing.Desc[DescIdx].Addr  = RxBufDeviceAddress;
-    Dev->RxRing.Desc[DescIdx].Len   = (UINT32) (RxBufSize - VirtioNetReqSize);
+    Dev->RxRing.Desc[DescIdx].Len   = (UINT32) (RxBufSize - ReqSize);
     Dev->RxRing.Desc[DescIdx].Flags = VRING_DESC_F_WRITE;
     RxBufDeviceAddress += Dev->RxRing.Desc[DescIdx++].Len;
   }
@@ -424,7 +481,7 @@ VirtioNetInitRx (
   // virtio-0.9.5, 2.4.1.3 Updating the Index Field
   //
   MemoryFence ();
-  *Dev->RxRing.Avail.Idx = RxAlwaysPending;
+  *Dev->RxRing.Avail.Idx = Dev->RxMaxPending;
 
   //
   // At this point reception may already be running. In order to make it sure,
@@ -556,8 +613,21 @@ VirtioNetInitialize (
   ASSERT (Dev->Snm.MediaPresentSupported ==
     !!(Features & VIRTIO_NET_F_STATUS));
 
-  Features &= VIRTIO_NET_F_MAC | VIRTIO_NET_F_STATUS | VIRTIO_F_VERSION_1 |
-              VIRTIO_F_IOMMU_PLATFORM;
+  Features &= VIRTIO_NET_F_MAC | VIRTIO_NET_F_STATUS | VIRTIO_NET_F_MRG_RXBUF |
+              VIRTIO_NET_F_GUEST_CSUM | VIRTIO_F_RING_EVENT_IDX |
+              VIRTIO_F_VERSION_1 | VIRTIO_F_IOMMU_PLATFORM;
+
+  //
+  // VIRTIO_NET_F_GUEST_CSUM lets the host pass up packets with a partial
+  // checksum (for example, those originating on the host itself), instead of
+  // completing the checksum for us. The Simple Network Protocol has no means
+  // to hand such packets to the upper network stack, so VirtioNetReceive()
+  // completes the checksum. VIRTIO_NET_F_CSUM is not negotiated, because the
+  // upper network stack always fills in the checksums of outgoing packets.
+  //
+  Dev->RxMergeable = (BOOLEAN) ((Features & VIRTIO_NET_F_MRG_RXBUF) != 0);
+  Dev->RxCsum      = (BOOLEAN) ((Features & VIRTIO_NET_F_GUEST_CSUM) != 0);
+  Dev->EventIdx    = (BOOLEAN) ((Features & VIRTIO_F_RING_EVENT_IDX) != 0);
 
   //
   // In virtio-1.0, feature negotiation is expected to complete before queue
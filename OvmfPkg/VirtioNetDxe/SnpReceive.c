@@ -15,6 +15,130 @@
 
 #include "VirtioNet.h"
 
+/**
+  Locate the network data in one RX buffer that the host has returned on the
+  used ring.
+
+  @param[in]  Dev      The VNET_DEV driver instance.
+  @param[in]  UsedIdx  The (free-running) used ring index of the RX buffer.
+  @param[in]  First    TRUE iff this is the first RX buffer of the packet, that
+                       is, if it starts with the virtio-net request header.
+  @param[out] Data     The network data in the RX buffer.
+  @param[out] DataLen  The length of the network data in the RX buffer.
+
+  @return  The index of the head descriptor of the RX buffer, to be recycled
+           to the available ring.
+*/
+
+STATIC
+UINT16
+VirtioNetGetRxFragment (
+  IN  VNET_DEV *Dev,
+  IN  UINT16   UsedIdx,
+  IN  BOOLEAN  First,
+  OUT UINT8    **Data,
+  OUT UINT32   *DataLen
+  )
+{
+  UINT16 UsedElemIdx;
+  UINT16 DescIdx;
+  UINT16 DataDescIdx;
+  UINT32 RxLen;
+  UINT32 Skip;
+
+  UsedElemIdx = UsedIdx % Dev->RxRing.QueueSize;
+  DescIdx = (UINT16) Dev->RxRing.Used.UsedElem[UsedElemIdx].Id;
+  RxLen   = Dev->RxRing.Used.UsedElem[UsedElemIdx].Len;
+
+  if (Dev->RxMergeable) {
+    //
+    // the virtio-net request header, if any, shares the descriptor with the
+    // data
+    //
+    DataDescIdx = DescIdx;
+    Skip = First ? sizeof (VIRTIO_1_0_NET_REQ) : 0;
+  } else {
+    DataDescIdx = DescIdx + 1;
+    Skip = 0;
+    RxLen -= Dev->RxRing.Desc[DescIdx].Len;
+  }
+
+  //
+  // the virtio-net request header must be complete; we skip it. The host must
+  // not have filled in more data than requested.
+  //
+  ASSERT (RxLen >= Skip);
+  ASSERT (RxLen <= Dev->RxRing.Desc[DataDescIdx].Len);
+
+  *Data = Dev->RxBuf + (UINTN)(Dev->RxRing.Desc[DataDescIdx].Addr -
+                               Dev->RxBufDeviceBase) + Skip;
+  *DataLen = RxLen - Skip;
+  return DescIdx;
+}
+
+
+/**
+  Complete the partial checksum of a packet that the host has passed up with
+  VIRTIO_NET_HDR_F_NEEDS_CSUM.
+
+  The host has stored the checksum of the pseudo header at CsumOffset bytes
+  into the transport header at CsumStart. Sum the packet from CsumStart to the
+  end, and store the result.
+
+  @param[in,out] Packet      The packet, including the media header.
+  @param[in]     PacketLen   The length of Packet in bytes.
+  @param[in]     CsumStart   The offset in Packet to start the checksum at.
+  @param[in]     CsumOffset  The offset from CsumStart to store the checksum
+                             at.
+
+  @retval EFI_DEVICE_ERROR  The checksum location is outside of the packet.
+  @retval EFI_SUCCESS       The checksum has been completed.
+*/
+
+STATIC
+EFI_STATUS
+VirtioNetCompleteChecksum (
+  IN OUT UINT8  *Packet,
+  IN     UINTN  PacketLen,
+  IN     UINT16 CsumStart,
+  IN     UINT16 CsumOffset
+  )
+{
+  UINTN  Idx;
+  UINT32 Sum;
+  UINT16 Csum;
+
+  if ((UINTN) CsumStart + CsumOffset + sizeof (UINT16) > PacketLen) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  //
+  // the ones' complement sum of the big endian 16-bit words, padded with a
+  // zero byte at the end if needed
+  //
+  Sum = 0;
+  for (Idx = CsumStart; Idx + 1 < PacketLen; Idx += 2) {
+    Sum += (UINT32) ((Packet[Idx] << 8) | Packet[Idx + 1]);
+    Sum = (Sum & 0xFFFF) + (Sum >> 16);
+  }
+  if (Idx < PacketLen) {
+    Sum += (UINT32) (Packet[Idx] << 8);
+    Sum = (Sum & 0xFFFF) + (Sum >> 16);
+  }
+
+  //
+  // a zero checksum means "none" for UDP; transmit it as all ones
+  //
+  Csum = (UINT16) ~Sum;
+  if (Csum == 0) {
+    Csum = 0xFFFF;
+  }
+  Packet[CsumStart + CsumOffset]     = (UINT8) (Csum >> 8);
+  Packet[CsumStart + CsumOffset + 1] = (UINT8) Csum;
+  return EFI_SUCCESS;
+}
+
+
 /**
   Receives a packet from a network interface.
 
@@ -65,18 +189,25 @@ VirtioNetReceive (
   OUT UINT16                     *Protocol   OPTIONAL
   )
 {
-  VNET_DEV   *Dev;
-  EFI_TPL    OldTpl;
-  EFI_STATUS Status;
-  UINT16     RxCurUsed;
-  UINT16     UsedElemIdx;
-  UINT32     DescIdx;
-  UINT32     RxLen;
-  UINTN      OrigBufferSize;
-  UINT8      *RxPtr;
-  UINT16     AvailIdx;
-  EFI_STATUS NotifyStatus;
-  UINTN      RxBufOffset;
+  VNET_DEV           *Dev;
+  EFI_TPL            OldTpl;
+  EFI_STATUS         Status;
+  UINT16             RxCurUsed;
+  UINT16             UsedElemIdx;
+  UINT32             DescIdx;
+  VIRTIO_1_0_NET_REQ *RxReq;
+  UINT8              RxFlags;
+  UINT16             CsumStart;
+  UINT16             CsumOffset;
+  UINT16             NumBuffers;
+  UINT16             BufIdx;
+  UINT32             FragLen;
+  UINT32             RxLen;
+  UINTN              OrigBufferSize;
+  UINT8              *RxPtr;
+  UINT16             OldAvailIdx;
+  UINT16             AvailIdx;
+  EFI_STATUS         NotifyStatus;
 
   if (This == NULL || BufferSize == NULL || Buffer == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -107,19 +238,39 @@ VirtioNetReceive (
     goto Exit;
   }
 
+  //
+  // With VIRTIO_NET_F_MRG_RXBUF, the packet may span several RX buffers; the
+  // virtio-net request header in the first one tells how many. The host
+  // publishes them on the used ring together.
+  //
   UsedElemIdx = Dev->RxLastUsed % Dev->RxRing.QueueSize;
   DescIdx = Dev->RxRing.Used.UsedElem[UsedElemIdx].Id;
-  RxLen   = Dev->RxRing.Used.UsedElem[UsedElemIdx].Len;
+  RxReq = (VIRTIO_1_0_NET_REQ *)(Dev->RxBuf +
+                                 (UINTN)(Dev->RxRing.Desc[DescIdx].Addr -
+                                         Dev->RxBufDeviceBase));
+  RxFlags    = RxReq->V0_9_5.Flags;
+  CsumStart  = RxReq->V0_9_5.CsumStart;
+  CsumOffset = RxReq->V0_9_5.CsumOffset;
+  NumBuffers = Dev->RxMergeable ? RxReq->NumBuffers : 1;
+  if (NumBuffers == 0 ||
+      NumBuffers > (UINT16) (RxCurUsed - Dev->RxLastUsed)) {
+    ASSERT (FALSE);
+    NumBuffers = 1;
+    Status = EFI_DEVICE_ERROR;
+    goto RecycleDesc; // drop malformed packet
+  }
 
-  //
-  // the virtio-net request header must be complete; we skip it
-  //
-  ASSERT (RxLen >= Dev->RxRing.Desc[DescIdx].Len);
-  RxLen -= Dev->RxRing.Desc[DescIdx].Len;
-  //
-  // the host must not have filled in more data than requested
-  //
-  ASSERT (RxLen <= Dev->RxRing.Desc[DescIdx + 1].Len);
+  RxLen = 0;
+  for (BufIdx = 0; BufIdx < NumBuffers; ++BufIdx) {
+    VirtioNetGetRxFragment (
+      Dev,
+      (UINT16) (Dev->RxLastUsed + BufIdx),
+      (BOOLEAN) (BufIdx == 0),
+      &RxPtr,
+      &FragLen
+      );
+    RxLen += FragLen;
+  }
 
   OrigBufferSize = *BufferSize;
   *BufferSize = RxLen;
@@ -138,11 +289,27 @@ VirtioNetReceive (
     *HeaderSize = Dev->Snm.MediaHeaderSize;
   }
 
-  RxBufOffset = (UINTN)(Dev->RxRing.Desc[DescIdx + 1].Addr -
-                        Dev->RxBufDeviceBase);
-  RxPtr = Dev->RxBuf + RxBufOffset;
-  CopyMem (Buffer, RxPtr, RxLen);
+  RxLen = 0;
+  for (BufIdx = 0; BufIdx < NumBuffers; ++BufIdx) {
+    VirtioNetGetRxFragment (
+      Dev,
+      (UINT16) (Dev->RxLastUsed + BufIdx),
+      (BOOLEAN) (BufIdx == 0),
+      &RxPtr,
+      &FragLen
+      );
+    CopyMem ((UINT8 *) Buffer + RxLen, RxPtr, FragLen);
+    RxLen += FragLen;
+  }
+
+  if (Dev->RxCsum && (RxFlags & VIRTIO_NET_HDR_F_NEEDS_CSUM) != 0) {
+    Status = VirtioNetCompleteChecksum (Buffer, RxLen, CsumStart, CsumOffset);
+    if (EFI_ERROR (Status)) {
+      goto RecycleDesc; // drop packet with bogus checksum request
+    }
+  }
 
+  RxPtr = Buffer;
   if (DestAddr != NULL) {
     CopyMem (DestAddr, RxPtr, SIZE_OF_VNET (Mac));
   }
@@ -161,22 +328,36 @@ VirtioNetReceive (
   Status = EFI_SUCCESS;
 
 RecycleDesc:
-  ++Dev->RxLastUsed;
-
   //
   // virtio-0.9.5, 2.4.1 Supplying Buffers to The Device
   //
-  AvailIdx = *Dev->RxRing.Avail.Idx;
-  Dev->RxRing.Avail.Ring[AvailIdx++ % Dev->RxRing.QueueSize] =
-    (UINT16) DescIdx;
+  OldAvailIdx = *Dev->RxRing.Avail.Idx;
+  AvailIdx = OldAvailIdx;
+  for (BufIdx = 0; BufIdx < NumBuffers; ++BufIdx) {
+    DescIdx = VirtioNetGetRxFragment (
+                Dev,
+                Dev->RxLastUsed++,
+                (BOOLEAN) (BufIdx == 0),
+                &RxPtr,
+                &FragLen
+                );
+    Dev->RxRing.Avail.Ring[AvailIdx++ % Dev->RxRing.QueueSize] =
+      (UINT16) DescIdx;
+  }
+  VirtioRingSuppressInterrupts (&Dev->RxRing, Dev->RxLastUsed, Dev->EventIdx);
 
   MemoryFence ();
   *Dev->RxRing.Avail.Idx = AvailIdx;
 
-  MemoryFence ();
-  NotifyStatus = Dev->VirtIo->SetQueueNotify (Dev->VirtIo, VIRTIO_NET_Q_RX);
-  if (!EFI_ERROR (Status)) { // earlier error takes precedence
-    Status = NotifyStatus;
+  //
+  // The host only wants to be notified once it has run out of RX buffers, or
+  // (with VIRTIO_F_RING_EVENT_IDX) has asked for the buffers just recycled.
+  //
+  if (VirtioRingNeedNotify (&Dev->RxRing, OldAvailIdx, Dev->EventIdx)) {
+    NotifyStatus = Dev->VirtIo->SetQueueNotify (Dev->VirtIo, VIRTIO_NET_Q_RX);
+    if (!EFI_ERROR (Status)) { // earlier error takes precedence
+      Status = NotifyStatus;
+    }
   }
 
 Exit:
@@ -72,7 +72,6 @@ VirtioNetTransmit (
   EFI_STATUS            Status;
   UINT16                DescIdx;
   UINT16                AvailIdx;
-  EFI_PHYSICAL_ADDRESS  DeviceAddress;
 
   if (This == NULL || BufferSize == 0 || Buffer == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -139,25 +138,15 @@ VirtioNetTransmit (
   }
 
   //
-  // Map the transmit buffer system physical address to device address.
-  //
-  Status = VirtioNetMapTxBuf (
-             Dev,
-             Buffer,
-             BufferSize,
-             &DeviceAddress
-             );
-  if (EFI_ERROR (Status)) {
-    Status = EFI_DEVICE_ERROR;
-    goto Exit;
-  }
-
+  // Copy the packet to the bounce buffer of a free descriptor chain, and
+  // remember the caller's buffer for VirtioNetGetStatus().
   //
   // virtio-0.9.5, 2.4.1 Supplying Buffers to The Device
   //
   DescIdx = Dev->TxFreeStack[Dev->TxCurPending++];
-  Dev->TxRing.Desc[DescIdx + 1].Addr  = DeviceAddress;
-  Dev->TxRing.Desc[DescIdx + 1].Len   = (UINT32) BufferSize;
+  CopyMem (Dev->TxBuf + (DescIdx / 2) * Dev->TxBufSize, Buffer, BufferSize);
+  Dev->TxCallerBuf[DescIdx / 2] = Buffer;
+  Dev->TxRing.Desc[DescIdx + 1].Len = (UINT32) BufferSize;
 
   //
   // the available index is never written by the host, we can read it back
@@ -169,8 +158,17 @@ VirtioNetTransmit (
   MemoryFence ();
   *Dev->TxRing.Avail.Idx = AvailIdx;
 
-  MemoryFence ();
-  Status = Dev->VirtIo->SetQueueNotify (Dev->VirtIo, VIRTIO_NET_Q_TX);
+  //
+  // Skip the kick while the host is still working through earlier packets;
+  // it will pick this one up without a notification.
+  //
+  // virtio-0.9.5, 2.4.1.4 Notifying the Device
+  //
+  Status = EFI_SUCCESS;
+  if (VirtioRingNeedNotify (&Dev->TxRing, (UINT16) (AvailIdx - 1),
+        Dev->EventIdx)) {
+    Status = Dev->VirtIo->SetQueueNotify (Dev->VirtIo, VIRTIO_NET_Q_TX);
+  }
 
 Exit:
   gBS->RestoreTPL (OldTpl);
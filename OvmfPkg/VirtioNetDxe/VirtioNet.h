@@ -20,14 +20,14 @@
 #include <Protocol/DevicePath.h>
 #include <Protocol/DriverBinding.h>
 #include <Protocol/SimpleNetwork.h>
-#include <Library/OrderedCollectionLib.h>
 
 #define VNET_SIG SIGNATURE_32 ('V', 'N', 'E', 'T')
 
 //
 // maximum number of pending packets, separately for each direction
 //
-#define VNET_MAX_PENDING 64
+#define VNET_MAX_RX_PENDING 512
+#define VNET_MAX_TX_PENDING 64
 
 //
 // State diagram:
@@ -77,10 +77,15 @@ typedef struct {
   EFI_DEVICE_PATH_PROTOCOL    *MacDevicePath;    // VirtioNetDriverBindingStart
   EFI_HANDLE                  MacHandle;         // VirtioNetDriverBindingStart
 
+  BOOLEAN                     RxMergeable;       // VirtioNetInitialize
+  BOOLEAN                     RxCsum;            // VirtioNetInitialize
+  BOOLEAN                     EventIdx;          // VirtioNetInitialize
+
   VRING                       RxRing;            // VirtioNetInitRing
   VOID                        *RxRingMap;        // VirtioRingMap and
                                                  // VirtioNetInitRing
   UINT8                       *RxBuf;            // VirtioNetInitRx
+  UINT16                      RxMaxPending;      // VirtioNetInitRx
   UINT16                      RxLastUsed;        // VirtioNetInitRx
   UINTN                       RxBufNrPages;      // VirtioNetInitRx
   EFI_PHYSICAL_ADDRESS        RxBufDeviceBase;   // VirtioNetInitRx
@@ -95,7 +100,11 @@ typedef struct {
   VIRTIO_1_0_NET_REQ          *TxSharedReq;      // VirtioNetInitTx
   VOID                        *TxSharedReqMap;   // VirtioNetInitTx
   UINT16                      TxLastUsed;        // VirtioNetInitTx
-  ORDERED_COLLECTION          *TxBufCollection;  // VirtioNetInitTx
+  UINT8                       *TxBuf;            // VirtioNetInitTx
+  UINTN                       TxBufNrPages;      // VirtioNetInitTx
+  UINTN                       TxBufSize;         // VirtioNetInitTx
+  VOID                        *TxBufMap;         // VirtioNetInitTx
+  VOID                        **TxCallerBuf;     // VirtioNetInitTx
 } VNET_DEV;
 
 
@@ -276,39 +285,10 @@ VirtioNetUninitRing (
   IN     VOID     *RingMap
   );
 
-//
-// utility functions to map caller-supplied Tx buffer system physical address
-// to a device address and vice versa
-//
-EFI_STATUS
-EFIAPI
-VirtioNetMapTxBuf (
-  IN  VNET_DEV              *Dev,
-  IN  VOID                  *Buffer,
-  IN  UINTN                 NumberOfBytes,
-  OUT EFI_PHYSICAL_ADDRESS  *DeviceAddress
-  );
-
-EFI_STATUS
-EFIAPI
-VirtioNetUnmapTxBuf (
-  IN  VNET_DEV              *Dev,
-  OUT VOID                  **Buffer,
-  IN  EFI_PHYSICAL_ADDRESS  DeviceAddress
-  );
-
-INTN
-EFIAPI
-VirtioNetTxBufMapInfoCompare (
-  IN CONST VOID *UserStruct1,
-  IN CONST VOID *UserStruct2
-  );
-
-INTN
+UINTN
 EFIAPI
-VirtioNetTxBufDeviceAddressCompare (
-  IN CONST VOID *StandaloneKey,
-  IN CONST VOID *UserStruct
+VirtioNetReqSize (
+  IN VNET_DEV *Dev
   );
 
 
@@ -1796,6 +1796,10 @@ typedef struct {
   EFI_FILE_GET_INFO     GetInfo;
   EFI_FILE_SET_INFO     SetInfo;
   EFI_FILE_FLUSH        Flush;
+  EFI_FILE_OPEN_EX      OpenEx;
+  EFI_FILE_READ_EX      ReadEx;
+  EFI_FILE_WRITE_EX     WriteEx;
+  EFI_FILE_FLUSH_EX     FlushEx;
   BOOLEAN               Unicode;
   EFI_FILE_PROTOCOL     *Orig;
 } EFI_FILE_PROTOCOL_FILE;
@@ -2113,6 +2117,91 @@ FileInterfaceFileWrite(
   }
 }
 
+/**
+  Opens a new file relative to the source file's location, with non-blocking
+  I/O.
+
+  @param[in]  This       The protocol instance pointer.
+  @param[out] NewHandle  Returns File Handle for FileName.
+  @param[in]  FileName   Null terminated string. "\", ".", and ".." are supported.
+  @param[in]  OpenMode   Open mode for file.
+  @param[in]  Attributes Only used for EFI_FILE_MODE_CREATE.
+  @param[in, out] Token  The token associated with the transaction.
+
+  @return The status returned by the wrapped file.
+**/
+EFI_STATUS
+EFIAPI
+FileInterfaceFileOpenEx (
+  IN EFI_FILE_PROTOCOL        *This,
+  OUT EFI_FILE_PROTOCOL       **NewHandle,
+  IN CHAR16                   *FileName,
+  IN UINT64                   OpenMode,
+  IN UINT64                   Attributes,
+  IN OUT EFI_FILE_IO_TOKEN    *Token
+  )
+{
+  return ((EFI_FILE_PROTOCOL_FILE*)This)->Orig->OpenEx(((EFI_FILE_PROTOCOL_FILE*)This)->Orig, NewHandle, FileName, OpenMode, Attributes, Token);
+}
+
+/**
+  Read data from the file, with non-blocking I/O.
+
+  Only used for Unicode files, whose data is not converted.
+
+  @param[in] This       The protocol instance pointer.
+  @param[in, out] Token The token associated with the transaction.
+
+  @return The status returned by the wrapped file.
+**/
+EFI_STATUS
+EFIAPI
+FileInterfaceFileReadEx (
+  IN EFI_FILE_PROTOCOL        *This,
+  IN OUT EFI_FILE_IO_TOKEN    *Token
+  )
+{
+  return ((EFI_FILE_PROTOCOL_FILE*)This)->Orig->ReadEx(((EFI_FILE_PROTOCOL_FILE*)This)->Orig, Token);
+}
+
+/**
+  Write data to the file, with non-blocking I/O.
+
+  Only used for Unicode files, whose data is not converted.
+
+  @param[in] This       The protocol instance pointer.
+  @param[in, out] Token The token associated with the transaction.
+
+  @return The status returned by the wrapped file.
+**/
+EFI_STATUS
+EFIAPI
+FileInterfaceFileWriteEx (
+  IN EFI_FILE_PROTOCOL        *This,
+  IN OUT EFI_FILE_IO_TOKEN    *Token
+  )
+{
+  return ((EFI_FILE_PROTOCOL_FILE*)This)->Orig->WriteEx(((EFI_FILE_PROTOCOL_FILE*)This)->Orig, Token);
+}
+
+/**
+  Flush data back for the file handle, with non-blocking I/O.
+
+  @param[in] This       The protocol instance pointer.
+  @param[in, out] Token The token associated with the transaction.
+
+  @return The status returned by the wrapped file.
+**/
+EFI_STATUS
+EFIAPI
+FileInterfaceFileFlushEx (
+  IN EFI_FILE_PROTOCOL        *This,
+  IN OUT EFI_FILE_IO_TOKEN    *Token
+  )
+{
+  return ((EFI_FILE_PROTOCOL_FILE*)This)->Orig->FlushEx(((EFI_FILE_PROTOCOL_FILE*)This)->Orig, Token);
+}
+
 /**
   Create a file interface with unicode information.
 
@@ -2136,7 +2225,6 @@ CreateFileInterfaceFile(
   if (NewOne == NULL) {
     return (NULL);
   }
-  CopyMem(NewOne, Template, sizeof(EFI_FILE_PROTOCOL_FILE));
   NewOne->Orig        = (EFI_FILE_PROTOCOL *)Template;
   NewOne->Unicode     = Unicode;
   NewOne->Open        = FileInterfaceFileOpen;
@@ -2150,5 +2238,19 @@ CreateFileInterfaceFile(
   NewOne->SetInfo     = FileInterfaceFileSetInfo;
   NewOne->Flush       = FileInterfaceFileFlush;
 
+  //
+  // The non-blocking I/O is passed through for Unicode files only, since the
+  // data of ASCII files is converted.
+  //
+  if (Unicode && (Template->Revision >= EFI_FILE_PROTOCOL_REVISION2)) {
+    NewOne->Revision  = EFI_FILE_PROTOCOL_REVISION2;
+    NewOne->OpenEx    = FileInterfaceFileOpenEx;
+    NewOne->ReadEx    = FileInterfaceFileReadEx;
+    NewOne->WriteEx   = FileInterfaceFileWriteEx;
+    NewOne->FlushEx   = FileInterfaceFileFlushEx;
+  } else {
+    NewOne->Revision  = EFI_FILE_PROTOCOL_REVISION;
+  }
+
   return ((EFI_FILE_PROTOCOL *)NewOne);
 }
@@ -68,6 +68,7 @@ STATIC CONST CHAR16 mStartupScript[]        = L"startup.nsh";
 CONST CHAR16 mNoNestingEnvVarName[]         = L"nonesting";
 CONST CHAR16 mNoNestingTrue[]               = L"True";
 CONST CHAR16 mNoNestingFalse[]              = L"False";
+STATIC CONST CHAR16 mScriptProfileEnvVarName[] = L"scriptprofile";
 
 /**
   Cleans off leading and trailing spaces and tabs.
@@ -707,6 +708,7 @@ FreeResources:
   }
 
   ShellFreeEnvVarList ();
+  ShellFreeAliasCache ();
 
   if (ShellCommandGetExit()) {
     return ((EFI_STATUS)ShellCommandGetExitCode());
@@ -1595,6 +1597,7 @@ ShellConvertVariables (
   IN CONST CHAR16 *OriginalCommandLine
   )
 {
+  CONST CHAR16        *EnvList;
   CONST CHAR16        *MasterEnvList;
   UINTN               NewSize;
   CHAR16              *NewCommandLine1;
@@ -1636,7 +1639,16 @@ ShellConvertVariables (
     }
   }
 
-  for (MasterEnvList = EfiShellGetEnv(NULL)
+  //
+  // Environment variables are only replaced between % characters, there is
+  // no need to walk through all of them when the command line has none.
+  //
+  EnvList = NULL;
+  if (StrStr (OriginalCommandLine, L"%") != NULL) {
+    EnvList = EfiShellGetEnv(NULL);
+  }
+
+  for (MasterEnvList = EnvList
     ;  MasterEnvList != NULL && *MasterEnvList != CHAR_NULL //&& *(MasterEnvList+1) != CHAR_NULL
     ;  MasterEnvList += StrLen(MasterEnvList) + 1
    ){
@@ -1671,7 +1683,7 @@ ShellConvertVariables (
   }
   CopyMem (NewCommandLine1, OriginalCommandLine, StrSize (OriginalCommandLine));
 
-  for (MasterEnvList = EfiShellGetEnv(NULL)
+  for (MasterEnvList = EnvList
     ;  MasterEnvList != NULL && *MasterEnvList != CHAR_NULL
     ;  MasterEnvList += StrLen(MasterEnvList) + 1
    ){
@@ -1687,6 +1699,9 @@ ShellConvertVariables (
               ((ItemSize+(2*sizeof(CHAR16)))/sizeof(CHAR16)),
               L"%"
               );
+    if (StrStr (NewCommandLine1, ItemTemp) == NULL) {
+      continue;
+    }
     ShellCopySearchAndReplace(NewCommandLine1, NewCommandLine2, NewSize, ItemTemp, EfiShellGetEnv(MasterEnvList), TRUE, FALSE);
     StrCpyS(NewCommandLine1, NewSize/sizeof(CHAR16), NewCommandLine2);
   }
@@ -1928,6 +1943,147 @@ ShellSubstituteAliases(
   return (EFI_SUCCESS);
 }
 
+//
+// Number of hash buckets of the executable path cache, must be a power of 2,
+// and number of entries beyond which the cache is emptied.
+//
+#define PATH_CACHE_BUCKETS      32
+#define PATH_CACHE_MAX_ENTRIES  128
+
+//
+// A command name resolved to a file with ShellFindFilePathEx().
+//
+typedef struct {
+  LIST_ENTRY  Link;
+  CHAR16      *Name;      ///< The command name, as typed.
+  CHAR16      *Path;      ///< The file found for Name.
+} PATH_CACHE_ENTRY;
+
+//
+// Cache of the executable path lookups, which otherwise try each executable
+// extension in the current directory and in each directory of the path
+// environment variable, twice for every command line.
+//
+STATIC LIST_ENTRY  mPathCache[PATH_CACHE_BUCKETS];
+STATIC UINTN       mPathCacheCount;
+STATIC BOOLEAN     mPathCacheReady;
+
+/**
+  Remove the entries of the executable path cache.
+
+  The cache must be flushed when the path environment variable, the current
+  directory or the file system mappings change, and when a file that could
+  shadow a cached one is created.
+
+  @param[in] FileName   If not NULL, the file that was created.  The cache is
+                        only flushed if the file has an executable extension.
+**/
+VOID
+ShellFlushPathCache (
+  IN CONST CHAR16 *FileName OPTIONAL
+  )
+{
+  PATH_CACHE_ENTRY  *Entry;
+  CONST CHAR16      *Extension;
+  UINTN             Index;
+
+  if (FileName != NULL) {
+    if (StrLen (FileName) < 4) {
+      return;
+    }
+    Extension = FileName + StrLen (FileName) - 4;
+    if (gUnicodeCollation->StriColl (gUnicodeCollation, (CHAR16 *)Extension, (CHAR16 *)mScriptExtension) != 0 &&
+        gUnicodeCollation->StriColl (gUnicodeCollation, (CHAR16 *)Extension, L".EFI") != 0) {
+      return;
+    }
+  }
+
+  for (Index = 0; Index < PATH_CACHE_BUCKETS; Index++) {
+    if (!mPathCacheReady) {
+      InitializeListHead (&mPathCache[Index]);
+      continue;
+    }
+    while (!IsListEmpty (&mPathCache[Index])) {
+      Entry = (PATH_CACHE_ENTRY *)GetFirstNode (&mPathCache[Index]);
+      RemoveEntryList (&Entry->Link);
+      FreePool (Entry->Name);
+      FreePool (Entry->Path);
+      FreePool (Entry);
+    }
+  }
+  mPathCacheCount = 0;
+  mPathCacheReady = TRUE;
+}
+
+/**
+  Find the file to run for a command name, trying each executable extension
+  in the current directory and in the path environment variable.
+
+  The result is cached, a cached file is only checked to still exist.
+
+  @param[in] CmdName    The command name.
+
+  @return The path of the file, which the caller must free, or NULL if no file
+          was found.
+**/
+CHAR16 *
+ShellFindExecutablePath (
+  IN CONST CHAR16 *CmdName
+  )
+{
+  LIST_ENTRY        *Bucket;
+  PATH_CACHE_ENTRY  *Entry;
+  CHAR16            *Path;
+
+  if (!mPathCacheReady) {
+    ShellFlushPathCache (NULL);
+  }
+
+  Bucket = &mPathCache[ShellHashString (CmdName) & (PATH_CACHE_BUCKETS - 1)];
+  for ( Entry = (PATH_CACHE_ENTRY *)GetFirstNode (Bucket)
+      ; !IsNull (Bucket, &Entry->Link)
+      ; Entry = (PATH_CACHE_ENTRY *)GetNextNode (Bucket, &Entry->Link)
+     ){
+    if (StrCmp (CmdName, Entry->Name) == 0) {
+      if (!EFI_ERROR (ShellFileExists (Entry->Path))) {
+        return AllocateCopyPool (StrSize (Entry->Path), Entry->Path);
+      }
+      //
+      // The file was deleted or renamed, look the command up again.
+      //
+      RemoveEntryList (&Entry->Link);
+      mPathCacheCount--;
+      FreePool (Entry->Name);
+      FreePool (Entry->Path);
+      FreePool (Entry);
+      break;
+    }
+  }
+
+  Path = ShellFindFilePathEx (CmdName, mExecutableExtensions);
+  if (Path == NULL) {
+    return NULL;
+  }
+
+  if (mPathCacheCount >= PATH_CACHE_MAX_ENTRIES) {
+    ShellFlushPathCache (NULL);
+  }
+  Entry = AllocateZeroPool (sizeof (PATH_CACHE_ENTRY));
+  if (Entry != NULL) {
+    Entry->Name = AllocateCopyPool (StrSize (CmdName), CmdName);
+    Entry->Path = AllocateCopyPool (StrSize (Path), Path);
+    if (Entry->Name == NULL || Entry->Path == NULL) {
+      SHELL_FREE_NON_NULL (Entry->Name);
+      SHELL_FREE_NON_NULL (Entry->Path);
+      FreePool (Entry);
+    } else {
+      InsertTailList (Bucket, &Entry->Link);
+      mPathCacheCount++;
+    }
+  }
+  return Path;
+}
+
 /**
   Takes the Argv[0] part of the command line and determine the meaning of it.
 
@@ -1971,7 +2127,7 @@ GetOperationType(
   //
   // Test for a file
   //
-  if ((FileWithPath = ShellFindFilePathEx(CmdName, mExecutableExtensions)) != NULL) {
+  if ((FileWithPath = ShellFindExecutablePath(CmdName)) != NULL) {
     //
     // See if that file has a script file extension
     //
@@ -2469,7 +2625,7 @@ RunCommandOrFile(
       // Process a relative path and also check in the path environment variable
       //
       if (CommandWithPath == NULL) {
-        CommandWithPath = ShellFindFilePathEx(FirstParameter, mExecutableExtensions);
+        CommandWithPath = ShellFindExecutablePath(FirstParameter);
       }
 
       //
@@ -2770,6 +2926,194 @@ RunCommand(
   return (RunShellCommand(CmdLine, NULL));
 }
 
+/**
+  Parse a line of a script once, when the script is loaded, rather than each
+  time the line is run in a loop.
+
+  The comments and the ^ of the ^: escapes are removed from the line, and its
+  first word is extracted to find the ends of the loops and the labels.
+
+  @param[in, out] Command       The line of the script.
+
+  @retval EFI_SUCCESS           The line was parsed.
+  @retval EFI_OUT_OF_RESOURCES  A memory allocation failed.
+**/
+STATIC
+EFI_STATUS
+ParseScriptCommand (
+  IN OUT SCRIPT_COMMAND_LIST  *Command
+  )
+{
+  CHAR16  *Walker;
+
+  for (Walker = Command->Cl; *Walker == L' ' || *Walker == L'\t'; Walker++);
+
+  Command->Name     = AllocateCopyPool (StrSize (Walker), Walker);
+  Command->ParsedCl = AllocateCopyPool (StrSize (Command->Cl), Command->Cl);
+  if (Command->Name == NULL || Command->ParsedCl == NULL) {
+    return (EFI_OUT_OF_RESOURCES);
+  }
+
+  Walker = StrStr (Command->Name, L" ");
+  if (Walker != NULL) {
+    *Walker = CHAR_NULL;
+  }
+
+  //
+  // NULL out comments
+  //
+  for (Walker = Command->ParsedCl ; *Walker != CHAR_NULL ; Walker++) {
+    if (*Walker == L'^') {
+      if ( *(Walker+1) == L':') {
+        CopyMem(Walker, Walker+1, StrSize(Walker) - sizeof(Walker[0]));
+      } else if (*(Walker+1) == L'#') {
+        Walker++;
+      }
+    } else if (*Walker == L'#') {
+      *Walker = CHAR_NULL;
+      break;
+    }
+  }
+
+  return (EFI_SUCCESS);
+}
+
+//
+// Time spent running one line of a script, when the scriptprofile environment
+// variable is set.
+//
+typedef struct {
+  UINT64  Ticks;
+  UINTN   Count;
+} SCRIPT_LINE_PROFILE;
+
+/**
+  Start profiling a script if the scriptprofile environment variable is set
+  and the platform has a timestamp counter.
+
+  @param[in]  LineCount     The number of lines of the script.
+  @param[out] Timestamp     The timestamp protocol used to time the lines.
+  @param[out] Properties    The properties of the timestamp counter.
+
+  @return The profile of each line of the script, indexed by line number, to
+          be freed by the caller.  NULL if the script is not profiled.
+**/
+STATIC
+SCRIPT_LINE_PROFILE *
+ScriptProfileStart (
+  IN  UINTN                     LineCount,
+  OUT EFI_TIMESTAMP_PROTOCOL    **Timestamp,
+  OUT EFI_TIMESTAMP_PROPERTIES  *Properties
+  )
+{
+  EFI_STATUS  Status;
+
+  if (EfiShellGetEnv (mScriptProfileEnvVarName) == NULL) {
+    return NULL;
+  }
+
+  Status = gBS->LocateProtocol (&gEfiTimestampProtocolGuid, NULL, (VOID **)Timestamp);
+  if (!EFI_ERROR (Status)) {
+    Status = (*Timestamp)->GetProperties (Properties);
+  }
+  if (EFI_ERROR (Status) || Properties->Frequency == 0) {
+    return NULL;
+  }
+
+  return AllocateZeroPool ((LineCount + 1) * sizeof (SCRIPT_LINE_PROFILE));
+}
+
+/**
+  Return the number of timestamp counter ticks since a previous value.
+
+  @param[in] Timestamp      The timestamp protocol.
+  @param[in] Properties     The properties of the timestamp counter.
+  @param[in] Start          The previous value of the counter.
+
+  @return The number of ticks.
+**/
+STATIC
+UINT64
+ScriptProfileElapsed (
+  IN EFI_TIMESTAMP_PROTOCOL         *Timestamp,
+  IN CONST EFI_TIMESTAMP_PROPERTIES *Properties,
+  IN UINT64                         Start
+  )
+{
+  UINT64  End;
+
+  End = Timestamp->GetTimestamp ();
+  if (End >= Start) {
+    return End - Start;
+  }
+  return Properties->EndValue - Start + End + 1;
+}
+
+/**
+  Convert timestamp counter ticks to microseconds.
+
+  @param[in] Properties     The properties of the timestamp counter.
+  @param[in] Ticks          The number of ticks.
+
+  @return The number of microseconds.
+**/
+STATIC
+UINT64
+ScriptProfileTicksToUs (
+  IN CONST EFI_TIMESTAMP_PROPERTIES *Properties,
+  IN UINT64                         Ticks
+  )
+{
+  UINT64  Seconds;
+  UINT64  Remainder;
+
+  Seconds = DivU64x64Remainder (Ticks, Properties->Frequency, &Remainder);
+  return MultU64x32 (Seconds, 1000000) +
+         DivU64x64Remainder (MultU64x32 (Remainder, 1000000), Properties->Frequency, NULL);
+}
+
+/**
+  Print the time spent on each line of a script.
+
+  @param[in] Script         The script.
+  @param[in] Profile        The profile of each line of the script.
+  @param[in] Properties     The properties of the timestamp counter.
+  @param[in] TotalTicks     The time spent running the whole script.
+**/
+STATIC
+VOID
+ScriptProfileReport (
+  IN CONST SCRIPT_FILE              *Script,
+  IN CONST SCRIPT_LINE_PROFILE      *Profile,
+  IN CONST EFI_TIMESTAMP_PROPERTIES *Properties,
+  IN UINT64                         TotalTicks
+  )
+{
+  SCRIPT_COMMAND_LIST *Command;
+
+  ShellPrintHiiEx (
+    -1, -1, NULL, STRING_TOKEN (STR_SHELL_PROFILE_HEADER), ShellInfoObject.HiiHandle,
+    Script->ScriptName,
+    ScriptProfileTicksToUs (Properties, TotalTicks)
+    );
+
+  for ( Command = (SCRIPT_COMMAND_LIST *)GetFirstNode (&Script->CommandList)
+      ; !IsNull (&Script->CommandList, &Command->Link)
+      ; Command = (SCRIPT_COMMAND_LIST *)GetNextNode (&Script->CommandList, &Command->Link)
+     ){
+    if (Profile[Command->Line].Count == 0) {
+      continue;
+    }
+    ShellPrintHiiEx (
+      -1, -1, NULL, STRING_TOKEN (STR_SHELL_PROFILE_LINE), ShellInfoObject.HiiHandle,
+      Command->Line,
+      Profile[Command->Line].Count,
+      ScriptProfileTicksToUs (Properties, Profile[Command->Line].Ticks),
+      Command->Cl
+      );
+  }
+}
+
 /**
   Function to process a NSH script file via SHELL_FILE_HANDLE.
 
@@ -2799,6 +3143,11 @@ RunScriptFileHandle (
   UINTN               LineCount;
   CHAR16              LeString[50];
   LIST_ENTRY          OldBufferList;
+  SCRIPT_LINE_PROFILE       *Profile;
+  EFI_TIMESTAMP_PROTOCOL    *Timestamp;
+  EFI_TIMESTAMP_PROPERTIES  Properties;
+  UINT64                    ScriptStart;
+  UINT64                    LineStart;
 
   ASSERT(!ShellCommandGetScriptExit());
 
@@ -2873,6 +3222,12 @@ RunScriptFileHandle (
     NewScriptFile->CurrentCommand->Line = LineCount;
 
     InsertTailList(&NewScriptFile->CommandList, &NewScriptFile->CurrentCommand->Link);
+
+    Status = ParseScriptCommand (NewScriptFile->CurrentCommand);
+    if (EFI_ERROR (Status)) {
+      DeleteScriptFileStruct(NewScriptFile);
+      return (Status);
+    }
   }
 
   //
@@ -2895,99 +3250,101 @@ RunScriptFileHandle (
     return (EFI_OUT_OF_RESOURCES);
   }
 
+  Timestamp   = NULL;
+  ScriptStart = 0;
+  LineStart   = 0;
+  Profile     = ScriptProfileStart (LineCount, &Timestamp, &Properties);
+  if (Profile != NULL) {
+    ScriptStart = Timestamp->GetTimestamp ();
+  }
+
   for ( NewScriptFile->CurrentCommand = (SCRIPT_COMMAND_LIST *)GetFirstNode(&NewScriptFile->CommandList)
       ; !IsNull(&NewScriptFile->CommandList, &NewScriptFile->CurrentCommand->Link)
       ; // conditional increment in the body of the loop
   ){
     ASSERT(CommandLine2 != NULL);
+    if (Profile != NULL) {
+      LineStart = Timestamp->GetTimestamp ();
+    }
     StrnCpyS( CommandLine2,
               PrintBuffSize/sizeof(CHAR16),
-              NewScriptFile->CurrentCommand->Cl,
+              NewScriptFile->CurrentCommand->ParsedCl,
               PrintBuffSize/sizeof(CHAR16) - 1
               );
 
     SaveBufferList(&OldBufferList);
 
-    //
-    // NULL out comments
-    //
-    for (CommandLine3 = CommandLine2 ; CommandLine3 != NULL && *CommandLine3 != CHAR_NULL ; CommandLine3++) {
-      if (*CommandLine3 == L'^') {
-        if ( *(CommandLine3+1) == L':') {
-          CopyMem(CommandLine3, CommandLine3+1, StrSize(CommandLine3) - sizeof(CommandLine3[0]));
-        } else if (*(CommandLine3+1) == L'#') {
-          CommandLine3++;
-        }
-      } else if (*CommandLine3 == L'#') {
-        *CommandLine3 = CHAR_NULL;
-      }
-    }
-
     if (CommandLine2 != NULL && StrLen(CommandLine2) >= 1) {
       //
-      // Due to variability in starting the find and replace action we need to have both buffers the same.
+      // Replace the script arguments, which are only referenced with a %.
       //
-      StrnCpyS( CommandLine,
-                PrintBuffSize/sizeof(CHAR16),
-                CommandLine2,
-                PrintBuffSize/sizeof(CHAR16) - 1
-                );
+      Status = EFI_SUCCESS;
+      if (StrStr (CommandLine2, L"%") != NULL) {
+        //
+        // Due to variability in starting the find and replace action we need to have both buffers the same.
+        //
+        StrnCpyS( CommandLine,
+                  PrintBuffSize/sizeof(CHAR16),
+                  CommandLine2,
+                  PrintBuffSize/sizeof(CHAR16) - 1
+                  );
 
-      //
-      // Remove the %0 to %9 from the command line (if we have some arguments)
-      //
-      if (NewScriptFile->Argv != NULL) {
-        switch (NewScriptFile->Argc) {
-          default:
-            Status = ShellCopySearchAndReplace(CommandLine2,  CommandLine, PrintBuffSize, L"%9", NewScriptFile->Argv[9], FALSE, FALSE);
-            ASSERT_EFI_ERROR(Status);
-          case 9:
-            Status = ShellCopySearchAndReplace(CommandLine,  CommandLine2, PrintBuffSize, L"%8", NewScriptFile->Argv[8], FALSE, FALSE);
-            ASSERT_EFI_ERROR(Status);
-          case 8:
-            Status = ShellCopySearchAndReplace(CommandLine2,  CommandLine, PrintBuffSize, L"%7", NewScriptFile->Argv[7], FALSE, FALSE);
-            ASSERT_EFI_ERROR(Status);
-          case 7:
-            Status = ShellCopySearchAndReplace(CommandLine,  CommandLine2, PrintBuffSize, L"%6", NewScriptFile->Argv[6], FALSE, FALSE);
-            ASSERT_EFI_ERROR(Status);
-          case 6:
-            Status = ShellCopySearchAndReplace(CommandLine2,  CommandLine, PrintBuffSize, L"%5", NewScriptFile->Argv[5], FALSE, FALSE);
-            ASSERT_EFI_ERROR(Status);
-          case 5:
-            Status = ShellCopySearchAndReplace(CommandLine,  CommandLine2, PrintBuffSize, L"%4", NewScriptFile->Argv[4], FALSE, FALSE);
-            ASSERT_EFI_ERROR(Status);
-          case 4:
-            Status = ShellCopySearchAndReplace(CommandLine2,  CommandLine, PrintBuffSize, L"%3", NewScriptFile->Argv[3], FALSE, FALSE);
-            ASSERT_EFI_ERROR(Status);
-          case 3:
-            Status = ShellCopySearchAndReplace(CommandLine,  CommandLine2, PrintBuffSize, L"%2", NewScriptFile->Argv[2], FALSE, FALSE);
-            ASSERT_EFI_ERROR(Status);
-          case 2:
-            Status = ShellCopySearchAndReplace(CommandLine2,  CommandLine, PrintBuffSize, L"%1", NewScriptFile->Argv[1], FALSE, FALSE);
-            ASSERT_EFI_ERROR(Status);
-          case 1:
-            Status = ShellCopySearchAndReplace(CommandLine,  CommandLine2, PrintBuffSize, L"%0", NewScriptFile->Argv[0], FALSE, FALSE);
-            ASSERT_EFI_ERROR(Status);
-            break;
-          case 0:
-            break;
+        //
+        // Remove the %0 to %9 from the command line (if we have some arguments)
+        //
+        if (NewScriptFile->Argv != NULL) {
+          switch (NewScriptFile->Argc) {
+            default:
+              Status = ShellCopySearchAndReplace(CommandLine2,  CommandLine, PrintBuffSize, L"%9", NewScriptFile->Argv[9], FALSE, FALSE);
+              ASSERT_EFI_ERROR(Status);
+            case 9:
+              Status = ShellCopySearchAndReplace(CommandLine,  CommandLine2, PrintBuffSize, L"%8", NewScriptFile->Argv[8], FALSE, FALSE);
+              ASSERT_EFI_ERROR(Status);
+            case 8:
+              Status = ShellCopySearchAndReplace(CommandLine2,  CommandLine, PrintBuffSize, L"%7", NewScriptFile->Argv[7], FALSE, FALSE);
+              ASSERT_EFI_ERROR(Status);
+            case 7:
+              Status = ShellCopySearchAndReplace(CommandLine,  CommandLine2, PrintBuffSize, L"%6", NewScriptFile->Argv[6], FALSE, FALSE);
+              ASSERT_EFI_ERROR(Status);
+            case 6:
+              Status = ShellCopySearchAndReplace(CommandLine2,  CommandLine, PrintBuffSize, L"%5", NewScriptFile->Argv[5], FALSE, FALSE);
+              ASSERT_EFI_ERROR(Status);
+            case 5:
+              Status = ShellCopySearchAndReplace(CommandLine,  CommandLine2, PrintBuffSize, L"%4", NewScriptFile->Argv[4], FALSE, FALSE);
+              ASSERT_EFI_ERROR(Status);
+            case 4:
+              Status = ShellCopySearchAndReplace(CommandLine2,  CommandLine, PrintBuffSize, L"%3", NewScriptFile->Argv[3], FALSE, FALSE);
+              ASSERT_EFI_ERROR(Status);
+            case 3:
+              Status = ShellCopySearchAndReplace(CommandLine,  CommandLine2, PrintBuffSize, L"%2", NewScriptFile->Argv[2], FALSE, FALSE);
+              ASSERT_EFI_ERROR(Status);
+            case 2:
+              Status = ShellCopySearchAndReplace(CommandLine2,  CommandLine, PrintBuffSize, L"%1", NewScriptFile->Argv[1], FALSE, FALSE);
+              ASSERT_EFI_ERROR(Status);
+            case 1:
+              Status = ShellCopySearchAndReplace(CommandLine,  CommandLine2, PrintBuffSize, L"%0", NewScriptFile->Argv[0], FALSE, FALSE);
+              ASSERT_EFI_ERROR(Status);
+              break;
+            case 0:
+              break;
+          }
         }
+        Status = ShellCopySearchAndReplace(CommandLine2,  CommandLine, PrintBuffSize, L"%1", L"\"\"", FALSE, FALSE);
+        Status = ShellCopySearchAndReplace(CommandLine,  CommandLine2, PrintBuffSize, L"%2", L"\"\"", FALSE, FALSE);
+        Status = ShellCopySearchAndReplace(CommandLine2,  CommandLine, PrintBuffSize, L"%3", L"\"\"", FALSE, FALSE);
+        Status = ShellCopySearchAndReplace(CommandLine,  CommandLine2, PrintBuffSize, L"%4", L"\"\"", FALSE, FALSE);
+        Status = ShellCopySearchAndReplace(CommandLine2,  CommandLine, PrintBuffSize, L"%5", L"\"\"", FALSE, FALSE);
+        Status = ShellCopySearchAndReplace(CommandLine,  CommandLine2, PrintBuffSize, L"%6", L"\"\"", FALSE, FALSE);
+        Status = ShellCopySearchAndReplace(CommandLine2,  CommandLine, PrintBuffSize, L"%7", L"\"\"", FALSE, FALSE);
+        Status = ShellCopySearchAndReplace(CommandLine,  CommandLine2, PrintBuffSize, L"%8", L"\"\"", FALSE, FALSE);
+        Status = ShellCopySearchAndReplace(CommandLine2,  CommandLine, PrintBuffSize, L"%9", L"\"\"", FALSE, FALSE);
+
+        StrnCpyS( CommandLine2,
+                  PrintBuffSize/sizeof(CHAR16),
+                  CommandLine,
+                  PrintBuffSize/sizeof(CHAR16) - 1
+                  );
       }
-      Status = ShellCopySearchAndReplace(CommandLine2,  CommandLine, PrintBuffSize, L"%1", L"\"\"", FALSE, FALSE);
-      Status = ShellCopySearchAndReplace(CommandLine,  CommandLine2, PrintBuffSize, L"%2", L"\"\"", FALSE, FALSE);
-      Status = ShellCopySearchAndReplace(CommandLine2,  CommandLine, PrintBuffSize, L"%3", L"\"\"", FALSE, FALSE);
-      Status = ShellCopySearchAndReplace(CommandLine,  CommandLine2, PrintBuffSize, L"%4", L"\"\"", FALSE, FALSE);
-      Status = ShellCopySearchAndReplace(CommandLine2,  CommandLine, PrintBuffSize, L"%5", L"\"\"", FALSE, FALSE);
-      Status = ShellCopySearchAndReplace(CommandLine,  CommandLine2, PrintBuffSize, L"%6", L"\"\"", FALSE, FALSE);
-      Status = ShellCopySearchAndReplace(CommandLine2,  CommandLine, PrintBuffSize, L"%7", L"\"\"", FALSE, FALSE);
-      Status = ShellCopySearchAndReplace(CommandLine,  CommandLine2, PrintBuffSize, L"%8", L"\"\"", FALSE, FALSE);
-      Status = ShellCopySearchAndReplace(CommandLine2,  CommandLine, PrintBuffSize, L"%9", L"\"\"", FALSE, FALSE);
-
-      StrnCpyS( CommandLine2,
-                PrintBuffSize/sizeof(CHAR16),
-                CommandLine,
-                PrintBuffSize/sizeof(CHAR16) - 1
-                );
 
       LastCommand = NewScriptFile->CurrentCommand;
 
@@ -3032,6 +3389,11 @@ RunScriptFileHandle (
           }
         }
 
+        if (Profile != NULL) {
+          Profile[LastCommand->Line].Ticks += ScriptProfileElapsed (Timestamp, &Properties, LineStart);
+          Profile[LastCommand->Line].Count++;
+        }
+
         if (ShellCommandGetScriptExit()) {
           //
           // ShellCommandGetExitCode() always returns a UINT64
@@ -3079,6 +3441,12 @@ RunScriptFileHandle (
 
   FreePool(CommandLine);
   FreePool(CommandLine2);
+
+  if (Profile != NULL) {
+    ScriptProfileReport (NewScriptFile, Profile, &Properties, ScriptProfileElapsed (Timestamp, &Properties, ScriptStart));
+    FreePool (Profile);
+  }
+
   ShellCommandSetNewScript (NULL);
 
   //
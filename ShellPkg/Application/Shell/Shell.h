@@ -23,6 +23,7 @@
 #include <Protocol/ShellParameters.h>
 #include <Protocol/BlockIo.h>
 #include <Protocol/HiiPackageList.h>
+#include <Protocol/Timestamp.h>
 
 #include <Library/BaseLib.h>
 #include <Library/UefiApplicationEntryPoint.h>
@@ -363,6 +364,37 @@ TrimSpaces(
   IN CHAR16 **String
   );
 
+/**
+  Remove the entries of the executable path cache.
+
+  The cache must be flushed when the path environment variable, the current
+  directory or the file system mappings change, and when a file that could
+  shadow a cached one is created.
+
+  @param[in] FileName   If not NULL, the file that was created.  The cache is
+                        only flushed if the file has an executable extension.
+**/
+VOID
+ShellFlushPathCache (
+  IN CONST CHAR16 *FileName OPTIONAL
+  );
+
+/**
+  Find the file to run for a command name, trying each executable extension
+  in the current directory and in the path environment variable.
+
+  The result is cached, a cached file is only checked to still exist.
+
+  @param[in] CmdName    The command name.
+
+  @return The path of the file, which the caller must free, or NULL if no file
+          was found.
+**/
+CHAR16 *
+ShellFindExecutablePath (
+  IN CONST CHAR16 *CmdName
+  );
+
 /**
 
   Create a new buffer list and stores the old one to OldBufferList
@@ -11,11 +11,88 @@
 #define INIT_NAME_BUFFER_SIZE  128
 #define INIT_DATA_BUFFER_SIZE  1024
 
+//
+// Number of hash buckets indexing gShellEnvVarList, must be a power of 2.
+//
+#define ENV_VAR_HASH_BUCKETS   64
+
 //
 // The list is used to cache the environment variables.
 //
 ENV_VAR_LIST                   gShellEnvVarList;
 
+//
+// The nodes of gShellEnvVarList, hashed by name through their HashLink.
+//
+STATIC LIST_ENTRY              mShellEnvVarHash[ENV_VAR_HASH_BUCKETS];
+
+/**
+  Compute a hash of a string, used to index the shell's name lookup tables.
+
+  This is the 32-bit FNV-1a hash over the UCS-2 characters.
+
+  @param[in] String             The NULL-terminated string to hash.
+
+  @return The hash of the string.
+**/
+UINTN
+ShellHashString (
+  IN CONST CHAR16 *String
+  )
+{
+  UINT32  Hash;
+
+  Hash = 0x811C9DC5;
+  for ( ; *String != CHAR_NULL; String++) {
+    Hash = (Hash ^ *String) * 0x01000193;
+  }
+  return Hash;
+}
+
+/**
+  Return the hash bucket of an environment variable name.
+
+  @param[in] Key                The name of the environment variable.
+
+  @return The list of the gShellEnvVarList nodes whose names share the hash
+          of Key.
+**/
+STATIC
+LIST_ENTRY *
+ShellEnvVarHashBucket (
+  IN CONST CHAR16 *Key
+  )
+{
+  return &mShellEnvVarHash[ShellHashString (Key) & (ENV_VAR_HASH_BUCKETS - 1)];
+}
+
+/**
+  Find the node of an environment variable in gShellEnvVarList.
+
+  @param[in] Key                The name of the environment variable.
+
+  @return The node, or NULL if the variable is not in gShellEnvVarList.
+**/
+STATIC
+ENV_VAR_LIST *
+ShellFindEnvVarNode (
+  IN CONST CHAR16 *Key
+  )
+{
+  LIST_ENTRY        *Bucket;
+  LIST_ENTRY        *Entry;
+  ENV_VAR_LIST      *Node;
+
+  Bucket = ShellEnvVarHashBucket (Key);
+  for (Entry = GetFirstNode (Bucket); !IsNull (Bucket, Entry); Entry = GetNextNode (Bucket, Entry)) {
+    Node = BASE_CR (Entry, ENV_VAR_LIST, HashLink);
+    if (Node->Key != NULL && StrCmp (Key, Node->Key) == 0) {
+      return Node;
+    }
+  }
+  return NULL;
+}
+
 /**
   Reports whether an environment variable is Volatile or Non-Volatile.
 
@@ -412,21 +489,17 @@ ShellFindEnvVarInList (
     return SHELL_INVALID_PARAMETER;
   }
 
-  for ( Node = (ENV_VAR_LIST*)GetFirstNode(&gShellEnvVarList.Link)
-      ; !IsNull(&gShellEnvVarList.Link, &Node->Link)
-      ; Node = (ENV_VAR_LIST*)GetNextNode(&gShellEnvVarList.Link, &Node->Link)
-     ){
-    if (Node->Key != NULL && StrCmp(Key, Node->Key) == 0) {
-      *Value      = AllocateCopyPool(StrSize(Node->Val), Node->Val);
-      *ValueSize  = StrSize(Node->Val);
-      if (Atts != NULL) {
-        *Atts = Node->Atts;
-      }
-      return EFI_SUCCESS;
-    }
+  Node = ShellFindEnvVarNode (Key);
+  if (Node == NULL) {
+    return EFI_NOT_FOUND;
   }
 
-  return EFI_NOT_FOUND;
+  *Value      = AllocateCopyPool(StrSize(Node->Val), Node->Val);
+  *ValueSize  = StrSize(Node->Val);
+  if (Atts != NULL) {
+    *Atts = Node->Atts;
+  }
+  return EFI_SUCCESS;
 }
 
 /**
@@ -458,6 +531,13 @@ ShellAddEnvVarToList (
     return EFI_INVALID_PARAMETER;
   }
 
+  //
+  // The executable path lookups depend on the path and the current directory.
+  //
+  if (StrCmp (Key, L"path") == 0 || StrCmp (Key, L"cwd") == 0) {
+    ShellFlushPathCache (NULL);
+  }
+
   LocalValue = AllocateCopyPool (ValueSize, Value);
   if (LocalValue == NULL) {
     return EFI_OUT_OF_RESOURCES;
@@ -466,16 +546,12 @@ ShellAddEnvVarToList (
   //
   // Update the variable value if it exists in gShellEnvVarList.
   //
-  for ( Node = (ENV_VAR_LIST*)GetFirstNode(&gShellEnvVarList.Link)
-      ; !IsNull(&gShellEnvVarList.Link, &Node->Link)
-      ; Node = (ENV_VAR_LIST*)GetNextNode(&gShellEnvVarList.Link, &Node->Link)
-     ){
-    if (Node->Key != NULL && StrCmp(Key, Node->Key) == 0) {
-      Node->Atts = Atts;
-      SHELL_FREE_NON_NULL(Node->Val);
-      Node->Val  = LocalValue;
-      return EFI_SUCCESS;
-    }
+  Node = ShellFindEnvVarNode (Key);
+  if (Node != NULL) {
+    Node->Atts = Atts;
+    SHELL_FREE_NON_NULL(Node->Val);
+    Node->Val  = LocalValue;
+    return EFI_SUCCESS;
   }
 
   //
@@ -497,6 +573,7 @@ ShellAddEnvVarToList (
   Node->Val = LocalValue;
   Node->Atts = Atts;
   InsertTailList(&gShellEnvVarList.Link, &Node->Link);
+  InsertTailList(ShellEnvVarHashBucket (Key), &Node->HashLink);
 
   return EFI_SUCCESS;
 }
@@ -521,20 +598,21 @@ ShellRemvoeEnvVarFromList (
     return EFI_INVALID_PARAMETER;
   }
 
-  for ( Node = (ENV_VAR_LIST*)GetFirstNode(&gShellEnvVarList.Link)
-      ; !IsNull(&gShellEnvVarList.Link, &Node->Link)
-      ; Node = (ENV_VAR_LIST*)GetNextNode(&gShellEnvVarList.Link, &Node->Link)
-     ){
-    if (Node->Key != NULL && StrCmp(Key, Node->Key) == 0) {
-      SHELL_FREE_NON_NULL(Node->Key);
-      SHELL_FREE_NON_NULL(Node->Val);
-      RemoveEntryList(&Node->Link);
-      SHELL_FREE_NON_NULL(Node);
-      return EFI_SUCCESS;
-    }
+  if (StrCmp (Key, L"path") == 0 || StrCmp (Key, L"cwd") == 0) {
+    ShellFlushPathCache (NULL);
+  }
+
+  Node = ShellFindEnvVarNode (Key);
+  if (Node == NULL) {
+    return EFI_NOT_FOUND;
   }
 
-  return EFI_NOT_FOUND;
+  SHELL_FREE_NON_NULL(Node->Key);
+  SHELL_FREE_NON_NULL(Node->Val);
+  RemoveEntryList(&Node->Link);
+  RemoveEntryList(&Node->HashLink);
+  SHELL_FREE_NON_NULL(Node);
+  return EFI_SUCCESS;
 }
 
 /**
@@ -548,10 +626,22 @@ ShellInitEnvVarList (
   )
 {
   EFI_STATUS    Status;
+  ENV_VAR_LIST  *Node;
+  UINTN         Index;
 
   InitializeListHead(&gShellEnvVarList.Link);
+  for (Index = 0; Index < ENV_VAR_HASH_BUCKETS; Index++) {
+    InitializeListHead (&mShellEnvVarHash[Index]);
+  }
   Status = GetEnvironmentVariableList (&gShellEnvVarList.Link);
 
+  for ( Node = (ENV_VAR_LIST*)GetFirstNode(&gShellEnvVarList.Link)
+      ; !IsNull(&gShellEnvVarList.Link, &Node->Link)
+      ; Node = (ENV_VAR_LIST*)GetNextNode(&gShellEnvVarList.Link, &Node->Link)
+     ){
+    InsertTailList (ShellEnvVarHashBucket (Node->Key), &Node->HashLink);
+  }
+
   return Status;
 }
 
@@ -564,8 +654,18 @@ ShellFreeEnvVarList (
   VOID
   )
 {
+  UINTN         Index;
+
   FreeEnvironmentVariableList (&gShellEnvVarList.Link);
   InitializeListHead(&gShellEnvVarList.Link);
+  for (Index = 0; Index < ENV_VAR_HASH_BUCKETS; Index++) {
+    InitializeListHead (&mShellEnvVarHash[Index]);
+  }
+
+  //
+  // The path variable may have been changed behind the shell.
+  //
+  ShellFlushPathCache (NULL);
 
   return;
 }
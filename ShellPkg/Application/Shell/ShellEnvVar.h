@@ -16,16 +16,30 @@
 
 typedef struct {
   LIST_ENTRY  Link;
+  LIST_ENTRY  HashLink;     ///< Link in the gShellEnvVarList hash bucket.
   CHAR16      *Key;
   CHAR16      *Val;
   UINT32      Atts;
 } ENV_VAR_LIST;
 
 //
-// The list is used to cache the environment variables.
+// The list is used to cache the environment variables.  It keeps them in
+// their creation order, and is indexed by a hash of their names for lookups.
 //
 extern ENV_VAR_LIST    gShellEnvVarList;
 
+/**
+  Compute a hash of a string, used to index the shell's name lookup tables.
+
+  @param[in] String             The NULL-terminated string to hash.
+
+  @return The hash of the string.
+**/
+UINTN
+ShellHashString (
+  IN CONST CHAR16 *String
+  );
+
 
 /**
   Reports whether an environment variable is Volatile or Non-Volatile.
@@ -130,6 +130,8 @@ EfiShellSetMap(
     return (EFI_INVALID_PARAMETER);
   }
 
+  ShellFlushPathCache (NULL);
+
   //
   // Delete the mapping
   //
@@ -1123,6 +1125,9 @@ EfiShellCreateFile(
 
   Status = InternalOpenFileDevicePath(DevicePath, FileHandle, EFI_FILE_MODE_READ|EFI_FILE_MODE_WRITE|EFI_FILE_MODE_CREATE, FileAttribs);
   FreePool(DevicePath);
+  if (!EFI_ERROR (Status)) {
+    ShellFlushPathCache (FileName);
+  }
 
   return(Status);
 }
@@ -1303,6 +1308,9 @@ EfiShellOpenFileByName(
   //
   Status = InternalOpenFileDevicePath(DevicePath, FileHandle, OpenMode, 0); // 0 = no specific file attributes
   FreePool(DevicePath);
+  if (!EFI_ERROR (Status) && (OpenMode & EFI_FILE_MODE_CREATE) != 0) {
+    ShellFlushPathCache (FileName);
+  }
 
   return(Status);
 }
@@ -3288,6 +3296,154 @@ ToLower (
   return Str;
 }
 
+//
+// Number of hash buckets of the alias cache, must be a power of 2, and number
+// of entries beyond which the cache is emptied.
+//
+#define ALIAS_CACHE_BUCKETS      32
+#define ALIAS_CACHE_MAX_ENTRIES  256
+
+//
+// An alias looked up with EfiShellGetAlias().  Command is NULL when the name
+// is not an alias, which is the case of most command names the shell checks.
+//
+typedef struct {
+  LIST_ENTRY  Link;
+  CHAR16      *Alias;     ///< Lower case name of the alias.
+  CHAR16      *Command;
+  BOOLEAN     Volatile;
+} ALIAS_CACHE_ENTRY;
+
+//
+// Cache of the gShellAliasGuid variables, which saves a GetVariable() call
+// for every command line.  Only the shell writes these variables, through
+// InternalSetAlias().
+//
+STATIC LIST_ENTRY  mAliasCache[ALIAS_CACHE_BUCKETS];
+STATIC UINTN       mAliasCacheCount;
+STATIC BOOLEAN     mAliasCacheReady;
+
+/**
+  Remove all the entries of the alias cache.
+**/
+VOID
+ShellFreeAliasCache (
+  VOID
+  )
+{
+  ALIAS_CACHE_ENTRY *Entry;
+  UINTN             Index;
+
+  for (Index = 0; Index < ALIAS_CACHE_BUCKETS; Index++) {
+    if (!mAliasCacheReady) {
+      InitializeListHead (&mAliasCache[Index]);
+      continue;
+    }
+    while (!IsListEmpty (&mAliasCache[Index])) {
+      Entry = (ALIAS_CACHE_ENTRY *)GetFirstNode (&mAliasCache[Index]);
+      RemoveEntryList (&Entry->Link);
+      SHELL_FREE_NON_NULL (Entry->Command);
+      FreePool (Entry->Alias);
+      FreePool (Entry);
+    }
+  }
+  mAliasCacheCount = 0;
+  mAliasCacheReady = TRUE;
+}
+
+/**
+  Find an alias in the alias cache.
+
+  @param[in] AliasLower         The lower case name of the alias.
+
+  @return The cache entry, or NULL if the alias is not cached.
+**/
+STATIC
+ALIAS_CACHE_ENTRY *
+AliasCacheFind (
+  IN CONST CHAR16 *AliasLower
+  )
+{
+  LIST_ENTRY        *Bucket;
+  ALIAS_CACHE_ENTRY *Entry;
+
+  if (!mAliasCacheReady) {
+    ShellFreeAliasCache ();
+  }
+
+  Bucket = &mAliasCache[ShellHashString (AliasLower) & (ALIAS_CACHE_BUCKETS - 1)];
+  for ( Entry = (ALIAS_CACHE_ENTRY *)GetFirstNode (Bucket)
+      ; !IsNull (Bucket, &Entry->Link)
+      ; Entry = (ALIAS_CACHE_ENTRY *)GetNextNode (Bucket, &Entry->Link)
+     ){
+    if (StrCmp (AliasLower, Entry->Alias) == 0) {
+      return Entry;
+    }
+  }
+  return NULL;
+}
+
+/**
+  Read an alias variable and add it to the alias cache.
+
+  @param[in] AliasLower         The lower case name of the alias.
+
+  @return The new cache entry, or NULL if the variable could not be read.
+**/
+STATIC
+ALIAS_CACHE_ENTRY *
+AliasCacheLoad (
+  IN CONST CHAR16 *AliasLower
+  )
+{
+  ALIAS_CACHE_ENTRY *Entry;
+  UINTN             Size;
+  UINT32            Attribs;
+  EFI_STATUS        Status;
+
+  Entry = AllocateZeroPool (sizeof (ALIAS_CACHE_ENTRY));
+  if (Entry == NULL) {
+    return NULL;
+  }
+  Entry->Alias = AllocateCopyPool (StrSize (AliasLower), AliasLower);
+  if (Entry->Alias == NULL) {
+    FreePool (Entry);
+    return NULL;
+  }
+
+  Size   = 0;
+  Status = gRT->GetVariable ((CHAR16 *)AliasLower, &gShellAliasGuid, &Attribs, &Size, NULL);
+  if (Status == EFI_BUFFER_TOO_SMALL) {
+    Entry->Command = AllocateZeroPool (Size + sizeof (CHAR16));
+    if (Entry->Command == NULL) {
+      Status = EFI_OUT_OF_RESOURCES;
+    } else {
+      Status = gRT->GetVariable ((CHAR16 *)AliasLower, &gShellAliasGuid, &Attribs, &Size, Entry->Command);
+    }
+  }
+
+  if (!EFI_ERROR (Status)) {
+    Entry->Volatile = (BOOLEAN)((Attribs & EFI_VARIABLE_NON_VOLATILE) == 0);
+  } else if (Status == EFI_NOT_FOUND) {
+    SHELL_FREE_NON_NULL (Entry->Command);
+  } else {
+    SHELL_FREE_NON_NULL (Entry->Command);
+    FreePool (Entry->Alias);
+    FreePool (Entry);
+    return NULL;
+  }
+
+  if (mAliasCacheCount >= ALIAS_CACHE_MAX_ENTRIES) {
+    ShellFreeAliasCache ();
+  }
+  InsertTailList (
+    &mAliasCache[ShellHashString (AliasLower) & (ALIAS_CACHE_BUCKETS - 1)],
+    &Entry->Link
+    );
+  mAliasCacheCount++;
+  return Entry;
+}
+
 /**
   This function returns the command associated with a alias or a list of all
   alias'.
@@ -3313,12 +3469,8 @@ EfiShellGetAlias(
   OUT BOOLEAN      *Volatile OPTIONAL
   )
 {
-  CHAR16      *RetVal;
-  UINTN       RetSize;
-  UINT32      Attribs;
-  EFI_STATUS  Status;
-  CHAR16      *AliasLower;
-  CHAR16      *AliasVal;
+  CHAR16            *AliasLower;
+  ALIAS_CACHE_ENTRY *Entry;
 
   // Convert to lowercase to make aliases case-insensitive
   if (Alias != NULL) {
@@ -3328,33 +3480,19 @@ EfiShellGetAlias(
     }
     ToLower (AliasLower);
 
-    if (Volatile == NULL) {
-      GetVariable2 (AliasLower, &gShellAliasGuid, (VOID **)&AliasVal, NULL);
-      FreePool(AliasLower);
-      return (AddBufferToFreeList(AliasVal));
+    Entry = AliasCacheFind (AliasLower);
+    if (Entry == NULL) {
+      Entry = AliasCacheLoad (AliasLower);
     }
-    RetSize = 0;
-    RetVal = NULL;
-    Status = gRT->GetVariable(AliasLower, &gShellAliasGuid, &Attribs, &RetSize, RetVal);
-    if (Status == EFI_BUFFER_TOO_SMALL) {
-      RetVal = AllocateZeroPool(RetSize);
-      Status = gRT->GetVariable(AliasLower, &gShellAliasGuid, &Attribs, &RetSize, RetVal);
-    }
-    if (EFI_ERROR(Status)) {
-      if (RetVal != NULL) {
-        FreePool(RetVal);
-      }
-      FreePool(AliasLower);
+    FreePool (AliasLower);
+
+    if (Entry == NULL || Entry->Command == NULL) {
       return (NULL);
     }
-    if ((EFI_VARIABLE_NON_VOLATILE & Attribs) == EFI_VARIABLE_NON_VOLATILE) {
-      *Volatile = FALSE;
-    } else {
-      *Volatile = TRUE;
+    if (Volatile != NULL) {
+      *Volatile = Entry->Volatile;
     }
-
-    FreePool (AliasLower);
-    return (AddBufferToFreeList(RetVal));
+    return (AddBufferToFreeList(AllocateCopyPool (StrSize (Entry->Command), Entry->Command)));
   }
   return (AddBufferToFreeList(InternalEfiShellGetListAlias()));
 }
@@ -3382,9 +3520,10 @@ InternalSetAlias(
   IN BOOLEAN Volatile
   )
 {
-  EFI_STATUS  Status;
-  CHAR16      *AliasLower;
-  BOOLEAN     DeleteAlias;
+  EFI_STATUS        Status;
+  CHAR16            *AliasLower;
+  BOOLEAN           DeleteAlias;
+  ALIAS_CACHE_ENTRY *Entry;
 
   DeleteAlias = FALSE;
   if (Alias == NULL) {
@@ -3416,6 +3555,18 @@ InternalSetAlias(
                     );
   }
 
+  //
+  // Drop the cached value, the next lookup reads the variable back.
+  //
+  Entry = AliasCacheFind (AliasLower);
+  if (Entry != NULL) {
+    RemoveEntryList (&Entry->Link);
+    mAliasCacheCount--;
+    SHELL_FREE_NON_NULL (Entry->Command);
+    FreePool (Entry->Alias);
+    FreePool (Entry);
+  }
+
   FreePool (AliasLower);
 
   return Status;
@@ -910,6 +910,14 @@ InternalEfiShellSetEnv(
   IN BOOLEAN Volatile
   );
 
+/**
+  Remove all the entries of the alias cache.
+**/
+VOID
+ShellFreeAliasCache (
+  VOID
+  );
+
 /**
   Function to start monitoring for CTRL-C using SimpleTextInputEx.  This
   feature's enabled state was not known when the shell initially launched.
@@ -385,6 +385,8 @@ typedef struct {
   CHAR16          *Cl;      ///< The original command line.
   VOID            *Data;    ///< The data structure format dependant upon Command. (not always used)
   BOOLEAN         Reset;    ///< Reset the command (it must be treated like a initial run (but it may have data already))
+  CHAR16          *ParsedCl;///< Cl without its comments, parsed once when the script is loaded. (may be NULL)
+  CHAR16          *Name;    ///< The first word of Cl, used to find the loop ends and the labels. (may be NULL)
 } SCRIPT_COMMAND_LIST;
 
 typedef struct {
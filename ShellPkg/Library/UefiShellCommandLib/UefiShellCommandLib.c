@@ -13,6 +13,7 @@
 
 // STATIC local variables
 STATIC SHELL_COMMAND_INTERNAL_LIST_ENTRY  mCommandList;
+STATIC LIST_ENTRY                         mCommandHash[SHELL_COMMAND_HASH_BUCKETS];
 STATIC SCRIPT_FILE_LIST                   mScriptList;
 STATIC ALIAS_LIST                         mAliasList;
 STATIC BOOLEAN                            mEchoState;
@@ -162,8 +163,13 @@ ShellCommandLibConstructor (
   )
 {
   EFI_STATUS        Status;
+  UINTN             Index;
+
   InitializeListHead(&gShellMapList.Link);
   InitializeListHead(&mCommandList.Link);
+  for (Index = 0; Index < SHELL_COMMAND_HASH_BUCKETS; Index++) {
+    InitializeListHead (&mCommandHash[Index]);
+  }
   InitializeListHead(&mAliasList.Link);
   InitializeListHead(&mScriptList.Link);
   InitializeListHead(&mFileHandleList.Link);
@@ -358,6 +364,75 @@ ShellCommandDynamicCommandExists (
   return (BOOLEAN) ((ShellCommandFindDynamicCommand(CommandString) != NULL));
 }
 
+/**
+  Return the hash bucket of a command name.
+
+  Command names are case insensitive, the hash is computed on the upper case
+  name, converted with the same collation protocol that compares the names.
+
+  @param[in] CommandString        The command name.
+
+  @return The list of the registered commands whose names share the hash of
+          CommandString.
+**/
+STATIC
+LIST_ENTRY *
+ShellCommandHashBucket (
+  IN CONST CHAR16 *CommandString
+  )
+{
+  CHAR16  Chunk[32];
+  UINTN   Index;
+  UINT32  Hash;
+
+  Hash = 0x811C9DC5;
+  while (*CommandString != CHAR_NULL) {
+    for (Index = 0; Index < ARRAY_SIZE (Chunk) - 1 && CommandString[Index] != CHAR_NULL; Index++) {
+      Chunk[Index] = CommandString[Index];
+    }
+    Chunk[Index]   = CHAR_NULL;
+    CommandString += Index;
+
+    gUnicodeCollation->StrUpr (gUnicodeCollation, Chunk);
+    for (Index = 0; Chunk[Index] != CHAR_NULL; Index++) {
+      Hash = (Hash ^ Chunk[Index]) * 0x01000193;
+    }
+  }
+  return &mCommandHash[Hash & (SHELL_COMMAND_HASH_BUCKETS - 1)];
+}
+
+/**
+  Find a command on the internal command list.
+
+  @param[in] CommandString        The command name.
+
+  @return The command, or NULL if it is not on the list.
+**/
+STATIC
+SHELL_COMMAND_INTERNAL_LIST_ENTRY *
+ShellCommandFindInternalCommand (
+  IN CONST CHAR16 *CommandString
+  )
+{
+  LIST_ENTRY                        *Bucket;
+  LIST_ENTRY                        *Entry;
+  SHELL_COMMAND_INTERNAL_LIST_ENTRY *Node;
+
+  Bucket = ShellCommandHashBucket (CommandString);
+  for (Entry = GetFirstNode (Bucket); !IsNull (Bucket, Entry); Entry = GetNextNode (Bucket, Entry)) {
+    Node = BASE_CR (Entry, SHELL_COMMAND_INTERNAL_LIST_ENTRY, HashLink);
+    ASSERT(Node->CommandString != NULL);
+    if (gUnicodeCollation->StriColl(
+          gUnicodeCollation,
+          (CHAR16*)CommandString,
+          Node->CommandString) == 0
+       ){
+      return (Node);
+    }
+  }
+  return (NULL);
+}
+
 /**
   Checks if a command is already on the internal command list.
 
@@ -368,8 +443,6 @@ ShellCommandIsCommandOnInternalList(
   IN CONST  CHAR16 *CommandString
   )
 {
-  SHELL_COMMAND_INTERNAL_LIST_ENTRY *Node;
-
   //
   // assert for NULL parameter
   //
@@ -378,20 +451,7 @@ ShellCommandIsCommandOnInternalList(
   //
   // check for the command
   //
-  for ( Node = (SHELL_COMMAND_INTERNAL_LIST_ENTRY *)GetFirstNode(&mCommandList.Link)
-      ; !IsNull(&mCommandList.Link, &Node->Link)
-      ; Node = (SHELL_COMMAND_INTERNAL_LIST_ENTRY *)GetNextNode(&mCommandList.Link, &Node->Link)
-     ){
-    ASSERT(Node->CommandString != NULL);
-    if (gUnicodeCollation->StriColl(
-          gUnicodeCollation,
-          (CHAR16*)CommandString,
-          Node->CommandString) == 0
-       ){
-      return (TRUE);
-    }
-  }
-  return (FALSE);
+  return (BOOLEAN)(ShellCommandFindInternalCommand (CommandString) != NULL);
 }
 
 /**
@@ -461,18 +521,9 @@ ShellCommandGetInternalCommandHelp(
   //
   // check for the command
   //
-  for ( Node = (SHELL_COMMAND_INTERNAL_LIST_ENTRY *)GetFirstNode(&mCommandList.Link)
-      ; !IsNull(&mCommandList.Link, &Node->Link)
-      ; Node = (SHELL_COMMAND_INTERNAL_LIST_ENTRY *)GetNextNode(&mCommandList.Link, &Node->Link)
-     ){
-    ASSERT(Node->CommandString != NULL);
-    if (gUnicodeCollation->StriColl(
-          gUnicodeCollation,
-          (CHAR16*)CommandString,
-          Node->CommandString) == 0
-       ){
-      return (HiiGetString(Node->HiiHandle, Node->ManFormatHelp, NULL));
-    }
+  Node = ShellCommandFindInternalCommand (CommandString);
+  if (Node != NULL) {
+    return (HiiGetString(Node->HiiHandle, Node->ManFormatHelp, NULL));
   }
   return (NULL);
 }
@@ -634,6 +685,7 @@ ShellCommandRegisterCommandName (
   // Insert a new entry on top of the list
   //
   InsertHeadList (&mCommandList.Link, &Node->Link);
+  InsertTailList (ShellCommandHashBucket (CommandString), &Node->HashLink);
 
   //
   // Move a new registered command to its sorted ordered location in the list
@@ -727,26 +779,17 @@ ShellCommandRunCommandHandler (
   //
   // check for the command
   //
-  for ( Node = (SHELL_COMMAND_INTERNAL_LIST_ENTRY *)GetFirstNode(&mCommandList.Link)
-      ; !IsNull(&mCommandList.Link, &Node->Link)
-      ; Node = (SHELL_COMMAND_INTERNAL_LIST_ENTRY *)GetNextNode(&mCommandList.Link, &Node->Link)
-     ){
-    ASSERT(Node->CommandString != NULL);
-    if (gUnicodeCollation->StriColl(
-          gUnicodeCollation,
-          (CHAR16*)CommandString,
-          Node->CommandString) == 0
-      ){
-      if (CanAffectLE != NULL) {
-        *CanAffectLE = Node->LastError;
-      }
-      if (RetVal != NULL) {
-        *RetVal = Node->CommandHandler(NULL, gST);
-      } else {
-        Node->CommandHandler(NULL, gST);
-      }
-      return (RETURN_SUCCESS);
+  Node = ShellCommandFindInternalCommand (CommandString);
+  if (Node != NULL) {
+    if (CanAffectLE != NULL) {
+      *CanAffectLE = Node->LastError;
+    }
+    if (RetVal != NULL) {
+      *RetVal = Node->CommandHandler(NULL, gST);
+    } else {
+      Node->CommandHandler(NULL, gST);
     }
+    return (RETURN_SUCCESS);
   }
 
   //
@@ -794,18 +837,9 @@ ShellCommandGetManFileNameHandler (
   //
   // check for the command
   //
-  for ( Node = (SHELL_COMMAND_INTERNAL_LIST_ENTRY *)GetFirstNode(&mCommandList.Link)
-      ; !IsNull(&mCommandList.Link, &Node->Link)
-      ; Node = (SHELL_COMMAND_INTERNAL_LIST_ENTRY *)GetNextNode(&mCommandList.Link, &Node->Link)
-     ){
-    ASSERT(Node->CommandString != NULL);
-    if (gUnicodeCollation->StriColl(
-          gUnicodeCollation,
-          (CHAR16*)CommandString,
-          Node->CommandString) == 0
-       ){
-      return (Node->GetManFileName());
-    }
+  Node = ShellCommandFindInternalCommand (CommandString);
+  if (Node != NULL) {
+    return (Node->GetManFileName());
   }
   return (NULL);
 }
@@ -1117,6 +1151,8 @@ DeleteScriptFileStruct (
       if (Script->CurrentCommand->Data != NULL) {
         SHELL_FREE_NON_NULL(Script->CurrentCommand->Data);
       }
+      SHELL_FREE_NON_NULL(Script->CurrentCommand->ParsedCl);
+      SHELL_FREE_NON_NULL(Script->CurrentCommand->Name);
       SHELL_FREE_NON_NULL(Script->CurrentCommand);
     }
   }
@@ -49,8 +49,14 @@ typedef struct{
   BOOLEAN                     LastError;
   EFI_HII_HANDLE              HiiHandle;
   EFI_STRING_ID               ManFormatHelp;
+  LIST_ENTRY                  HashLink;       ///< Link in the hash bucket of CommandString.
 } SHELL_COMMAND_INTERNAL_LIST_ENTRY;
 
+//
+// Number of hash buckets indexing the registered commands, must be a power of 2.
+//
+#define SHELL_COMMAND_HASH_BUCKETS  64
+
 typedef struct {
   LIST_ENTRY Link;
   SCRIPT_FILE *Data;
@@ -28,6 +28,31 @@ typedef struct {
 
 #define DMP_STORE_VARIABLE_SIGNATURE  SIGNATURE_32 ('_', 'd', 's', 's')
 
+//
+// Buffer type, for reading and writing the variable file in chunks rather
+// than one variable at a time.
+//
+typedef struct {
+  SHELL_FILE_HANDLE FileHandle;
+  UINT8             *Data;      // dynamically allocated buffer
+  UINTN             Allocated;  // the allocated size of Data
+  UINTN             Next;       // next position in Data to read or write at
+  UINTN             Left;       // number of bytes left in Data for reading at Next
+} DMP_STORE_FILE_BUFFER;
+
+#define DMP_STORE_FILE_BUFFER_SIZE  SIZE_64KB
+
+//
+// Number of variables and bytes saved or loaded, and the time it took.
+//
+typedef struct {
+  UINTN                     Count;
+  UINT64                    Bytes;
+  EFI_TIMESTAMP_PROTOCOL    *Timestamp;
+  EFI_TIMESTAMP_PROPERTIES  Properties;
+  UINT64                    Start;
+} DMP_STORE_STATS;
+
 /**
   Base on the input attribute value to return the attribute string.
 
@@ -111,13 +136,321 @@ BinaryToHexString (
   return HexString;
 }
 
+/**
+  Start measuring the time spent saving or loading the variables.
+
+  @param[out] Stats          The statistics to initialize.
+**/
+VOID
+DmpStoreStatsStart (
+  OUT DMP_STORE_STATS  *Stats
+  )
+{
+  EFI_STATUS  Status;
+
+  ZeroMem (Stats, sizeof (*Stats));
+  Status = gBS->LocateProtocol (&gEfiTimestampProtocolGuid, NULL, (VOID **) &Stats->Timestamp);
+  if (!EFI_ERROR (Status)) {
+    Status = Stats->Timestamp->GetProperties (&Stats->Properties);
+  }
+  if (EFI_ERROR (Status) || (Stats->Properties.Frequency == 0)) {
+    Stats->Timestamp = NULL;
+    return;
+  }
+  Stats->Start = Stats->Timestamp->GetTimestamp ();
+}
+
+/**
+  Print the number of variables and bytes saved or loaded, and the throughput
+  when a timestamp counter is available.
+
+  @param[in] Stats           The statistics.
+**/
+VOID
+DmpStoreStatsReport (
+  IN CONST DMP_STORE_STATS  *Stats
+  )
+{
+  UINT64  End;
+  UINT64  Ticks;
+  UINT64  Remainder;
+  UINT64  Milliseconds;
+
+  if (Stats->Timestamp == NULL) {
+    ShellPrintHiiEx (
+      -1, -1, NULL, STRING_TOKEN (STR_DMPSTORE_STATS), gShellDebug1HiiHandle,
+      Stats->Count, Stats->Bytes
+      );
+    return;
+  }
+
+  End = Stats->Timestamp->GetTimestamp ();
+  if (End >= Stats->Start) {
+    Ticks = End - Stats->Start;
+  } else {
+    Ticks = Stats->Properties.EndValue - Stats->Start + End + 1;
+  }
+  Milliseconds = MultU64x32 (DivU64x64Remainder (Ticks, Stats->Properties.Frequency, &Remainder), 1000) +
+                 DivU64x64Remainder (MultU64x32 (Remainder, 1000), Stats->Properties.Frequency, NULL);
+
+  ShellPrintHiiEx (
+    -1, -1, NULL, STRING_TOKEN (STR_DMPSTORE_STATS_TIME), gShellDebug1HiiHandle,
+    Stats->Count, Stats->Bytes, Milliseconds,
+    DivU64x64Remainder (Stats->Bytes, MAX (Milliseconds, 1), NULL)
+    );
+}
+
+/**
+  Initialize a DMP_STORE_FILE_BUFFER.
+
+  @param[out] FileBuffer     The DMP_STORE_FILE_BUFFER to initialize.
+  @param[in]  FileHandle     The file to read or write through the buffer.
+
+  @retval EFI_SUCCESS           The buffer is initialized.
+  @retval EFI_OUT_OF_RESOURCES  There is not enough memory for the buffer.
+**/
+EFI_STATUS
+DmpStoreFileBufferInit (
+  OUT DMP_STORE_FILE_BUFFER  *FileBuffer,
+  IN  SHELL_FILE_HANDLE      FileHandle
+  )
+{
+  FileBuffer->FileHandle = FileHandle;
+  FileBuffer->Allocated  = DMP_STORE_FILE_BUFFER_SIZE;
+  FileBuffer->Data       = AllocatePool (FileBuffer->Allocated);
+  FileBuffer->Next       = 0;
+  FileBuffer->Left       = 0;
+  if (FileBuffer->Data == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  return EFI_SUCCESS;
+}
+
+/**
+  Read bytes from the file, through the buffer.
+
+  @param[in, out] FileBuffer The buffer.
+  @param[in, out] Size       On input, the number of bytes to read. On output,
+                             the number of bytes read, which is smaller only
+                             at the end of the file.
+  @param[out]     Buffer     The bytes read.
+
+  @retval EFI_SUCCESS        Size bytes were read.
+  @return                    The error returned by ShellReadFile().
+**/
+EFI_STATUS
+DmpStoreFileBufferRead (
+  IN OUT DMP_STORE_FILE_BUFFER  *FileBuffer,
+  IN OUT UINTN                  *Size,
+  OUT    VOID                   *Buffer
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Copied;
+  UINTN       Length;
+
+  for (Copied = 0; Copied < *Size; Copied += Length) {
+    if (FileBuffer->Left == 0) {
+      FileBuffer->Next = 0;
+      FileBuffer->Left = FileBuffer->Allocated;
+      Status = ShellReadFile (FileBuffer->FileHandle, &FileBuffer->Left, FileBuffer->Data);
+      if (EFI_ERROR (Status)) {
+        FileBuffer->Left = 0;
+        return Status;
+      }
+      if (FileBuffer->Left == 0) {
+        break;
+      }
+    }
+    Length = MIN (*Size - Copied, FileBuffer->Left);
+    CopyMem ((UINT8 *) Buffer + Copied, FileBuffer->Data + FileBuffer->Next, Length);
+    FileBuffer->Next += Length;
+    FileBuffer->Left -= Length;
+  }
+
+  *Size = Copied;
+  return EFI_SUCCESS;
+}
+
+/**
+  Write the bytes held in the buffer to the file.
+
+  @param[in, out] FileBuffer The buffer.
+
+  @retval EFI_SUCCESS        The bytes were written.
+  @retval EFI_DEVICE_ERROR   Not all the bytes were written.
+  @return                    The error returned by ShellWriteFile().
+**/
+EFI_STATUS
+DmpStoreFileBufferFlush (
+  IN OUT DMP_STORE_FILE_BUFFER  *FileBuffer
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Size;
+
+  if (FileBuffer->Next == 0) {
+    return EFI_SUCCESS;
+  }
+
+  Size   = FileBuffer->Next;
+  Status = ShellWriteFile (FileBuffer->FileHandle, &Size, FileBuffer->Data);
+  if (!EFI_ERROR (Status) && (Size != FileBuffer->Next)) {
+    Status = EFI_DEVICE_ERROR;
+  }
+  FileBuffer->Next = 0;
+  return Status;
+}
+
+/**
+  Reserve space for writing bytes to the file, through the buffer.
+
+  The bytes held in the buffer are written to the file first if there is not
+  enough space left after them.
+
+  @param[in, out] FileBuffer The buffer.
+  @param[in]      Size       The number of bytes to reserve.
+  @param[out]     Space      The reserved space, or NULL if Size is larger
+                             than the buffer.
+
+  @retval EFI_SUCCESS        Space is returned.
+  @return                    The error returned by DmpStoreFileBufferFlush().
+**/
+EFI_STATUS
+DmpStoreFileBufferReserve (
+  IN OUT DMP_STORE_FILE_BUFFER  *FileBuffer,
+  IN     UINTN                  Size,
+  OUT    UINT8                  **Space
+  )
+{
+  EFI_STATUS  Status;
+
+  *Space = NULL;
+  if (Size > FileBuffer->Allocated - FileBuffer->Next) {
+    Status = DmpStoreFileBufferFlush (FileBuffer);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+  if (Size <= FileBuffer->Allocated - FileBuffer->Next) {
+    *Space = FileBuffer->Data + FileBuffer->Next;
+    FileBuffer->Next += Size;
+  }
+  return EFI_SUCCESS;
+}
+
+/**
+  Uninitialize a DMP_STORE_FILE_BUFFER.
+
+  @param[in, out] FileBuffer The buffer, initialized with
+                             DmpStoreFileBufferInit().
+**/
+VOID
+DmpStoreFileBufferUninit (
+  IN OUT DMP_STORE_FILE_BUFFER  *FileBuffer
+  )
+{
+  SHELL_FREE_NON_NULL (FileBuffer->Data);
+}
+
+/**
+  Read and check the next variable of the file.
+
+  The variable is read into Record, which is grown as needed and may be
+  reused for the next variable.
+
+  @param[in, out] FileBuffer The buffer of the file to be read.
+  @param[in, out] Record     The buffer holding the variable, or NULL.
+  @param[in, out] RecordSize The size in bytes of Record.
+  @param[out]     Variable   The variable, whose Name and Data point into
+                             Record.
+  @param[out]     Size       The size in bytes of the variable in the file.
+
+  @retval SHELL_SUCCESS           The variable is read.
+  @retval SHELL_VOLUME_CORRUPTED  The file is in bad format.
+  @retval SHELL_OUT_OF_RESOURCES  There is not enough memory to perform the operation.
+**/
+SHELL_STATUS
+ReadSingleVariableFromFile (
+  IN OUT DMP_STORE_FILE_BUFFER  *FileBuffer,
+  IN OUT UINT8                  **Record,
+  IN OUT UINTN                  *RecordSize,
+  OUT    DMP_STORE_VARIABLE     *Variable,
+  OUT    UINTN                  *Size
+  )
+{
+  EFI_STATUS           Status;
+  UINT32               Sizes[2];
+  UINTN                BufferSize;
+  UINTN                RemainingSize;
+  UINT32               Crc32;
+
+  //
+  // NameSize and DataSize
+  //
+  BufferSize = sizeof (Sizes);
+  Status = DmpStoreFileBufferRead (FileBuffer, &BufferSize, Sizes);
+  if (EFI_ERROR (Status) || (BufferSize != sizeof (Sizes))) {
+    return SHELL_VOLUME_CORRUPTED;
+  }
+
+  //
+  // Name, Guid, Attributes, Data, Crc32
+  //
+  RemainingSize = (UINTN) Sizes[0] + sizeof (EFI_GUID) + sizeof (UINT32) + Sizes[1] + sizeof (Crc32);
+  BufferSize    = sizeof (Sizes) + RemainingSize;
+  if (BufferSize > *RecordSize) {
+    SHELL_FREE_NON_NULL (*Record);
+    *RecordSize = 0;
+    *Record     = AllocatePool (BufferSize);
+    if (*Record == NULL) {
+      return SHELL_OUT_OF_RESOURCES;
+    }
+    *RecordSize = BufferSize;
+  }
+  CopyMem (*Record, Sizes, sizeof (Sizes));
+  BufferSize = RemainingSize;
+  Status = DmpStoreFileBufferRead (FileBuffer, &BufferSize, *Record + sizeof (Sizes));
+  if (EFI_ERROR (Status) || (BufferSize != RemainingSize)) {
+    return SHELL_VOLUME_CORRUPTED;
+  }
+
+  //
+  // Check Crc32
+  //
+  BufferSize = RemainingSize + sizeof (Sizes) - sizeof (Crc32);
+  gBS->CalculateCrc32 (
+         *Record,
+         BufferSize,
+         &Crc32
+         );
+  if (Crc32 != ReadUnaligned32 ((UINT32 *) (*Record + BufferSize))) {
+    return SHELL_VOLUME_CORRUPTED;
+  }
+
+  Variable->Signature = DMP_STORE_VARIABLE_SIGNATURE;
+  Variable->Name      = (CHAR16 *) (*Record + sizeof (Sizes));
+  Variable->DataSize  = Sizes[1];
+  Variable->Data      = (UINT8 *) Variable->Name + Sizes[0] + sizeof (EFI_GUID) + sizeof (UINT32);
+  CopyMem (&Variable->Guid,       (UINT8 *) Variable->Name + Sizes[0],                    sizeof (EFI_GUID));
+  CopyMem (&Variable->Attributes, (UINT8 *) Variable->Name + Sizes[0] + sizeof (EFI_GUID), sizeof (UINT32));
+
+  *Size = BufferSize + sizeof (Crc32);
+  return SHELL_SUCCESS;
+}
+
 /**
   Load the variable data from file and set to variable data base.
 
+  The file is read twice through a buffer: once to check that all the
+  variables are well formed, then to set them. Only one variable is held in
+  memory at a time.
+
   @param[in]  FileHandle     The file to be read.
   @param[in]  Name           The name of the variables to be loaded.
   @param[in]  Guid           The guid of the variables to be loaded.
   @param[out] Found          TRUE when at least one variable was loaded and set.
+  @param[in, out] Stats      The number of variables and bytes loaded.
 
   @retval SHELL_DEVICE_ERROR      Cannot access the file.
   @retval SHELL_VOLUME_CORRUPTED  The file is in bad format.
@@ -126,112 +459,45 @@ BinaryToHexString (
 **/
 SHELL_STATUS
 LoadVariablesFromFile (
-  IN SHELL_FILE_HANDLE FileHandle,
-  IN CONST CHAR16      *Name,
-  IN CONST EFI_GUID    *Guid,
-  OUT BOOLEAN          *Found
+  IN SHELL_FILE_HANDLE   FileHandle,
+  IN CONST CHAR16        *Name,
+  IN CONST EFI_GUID      *Guid,
+  OUT BOOLEAN            *Found,
+  IN OUT DMP_STORE_STATS *Stats
   )
 {
-  EFI_STATUS           Status;
-  SHELL_STATUS         ShellStatus;
-  UINT32               NameSize;
-  UINT32               DataSize;
-  UINTN                BufferSize;
-  UINTN                RemainingSize;
-  UINT64               Position;
-  UINT64               FileSize;
-  LIST_ENTRY           List;
-  DMP_STORE_VARIABLE   *Variable;
-  LIST_ENTRY           *Link;
-  CHAR16               *Attributes;
-  UINT8                *Buffer;
-  UINT32               Crc32;
+  EFI_STATUS             Status;
+  SHELL_STATUS           ShellStatus;
+  UINT64                 Position;
+  UINT64                 FileSize;
+  UINTN                  Size;
+  DMP_STORE_FILE_BUFFER  FileBuffer;
+  DMP_STORE_VARIABLE     Variable;
+  CHAR16                 *Attributes;
+  UINT8                  *Record;
+  UINTN                  RecordSize;
 
   Status = ShellGetFileSize (FileHandle, &FileSize);
   if (EFI_ERROR (Status)) {
     return SHELL_DEVICE_ERROR;
   }
 
-  ShellStatus = SHELL_SUCCESS;
+  Status = DmpStoreFileBufferInit (&FileBuffer, FileHandle);
+  if (EFI_ERROR (Status)) {
+    return SHELL_OUT_OF_RESOURCES;
+  }
 
-  InitializeListHead (&List);
+  ShellStatus = SHELL_SUCCESS;
+  Record      = NULL;
+  RecordSize  = 0;
 
   Position = 0;
   while (Position < FileSize) {
-    //
-    // NameSize
-    //
-    BufferSize = sizeof (NameSize);
-    Status = ShellReadFile (FileHandle, &BufferSize, &NameSize);
-    if (EFI_ERROR (Status) || (BufferSize != sizeof (NameSize))) {
-      ShellStatus = SHELL_VOLUME_CORRUPTED;
-      break;
-    }
-
-    //
-    // DataSize
-    //
-    BufferSize = sizeof (DataSize);
-    Status = ShellReadFile (FileHandle, &BufferSize, &DataSize);
-    if (EFI_ERROR (Status) || (BufferSize != sizeof (DataSize))) {
-      ShellStatus = SHELL_VOLUME_CORRUPTED;
-      break;
-    }
-
-    //
-    // Name, Guid, Attributes, Data, Crc32
-    //
-    RemainingSize = NameSize + sizeof (EFI_GUID) + sizeof (UINT32) + DataSize + sizeof (Crc32);
-    BufferSize    = sizeof (NameSize) + sizeof (DataSize) + RemainingSize;
-    Buffer        = AllocatePool (BufferSize);
-    if (Buffer == NULL) {
-      ShellStatus = SHELL_OUT_OF_RESOURCES;
-      break;
-    }
-    BufferSize    = RemainingSize;
-    Status = ShellReadFile (FileHandle, &BufferSize, (UINT32 *) Buffer + 2);
-    if (EFI_ERROR (Status) || (BufferSize != RemainingSize)) {
-      ShellStatus = SHELL_VOLUME_CORRUPTED;
-      FreePool (Buffer);
+    ShellStatus = ReadSingleVariableFromFile (&FileBuffer, &Record, &RecordSize, &Variable, &Size);
+    if (ShellStatus != SHELL_SUCCESS) {
       break;
     }
-
-    //
-    // Check Crc32
-    //
-    * (UINT32 *) Buffer       = NameSize;
-    * ((UINT32 *) Buffer + 1) = DataSize;
-    BufferSize = RemainingSize + sizeof (NameSize) + sizeof (DataSize) - sizeof (Crc32);
-    gBS->CalculateCrc32 (
-           Buffer,
-           BufferSize,
-           &Crc32
-           );
-    if (Crc32 != * (UINT32 *) (Buffer + BufferSize)) {
-      FreePool (Buffer);
-      ShellStatus = SHELL_VOLUME_CORRUPTED;
-      break;
-    }
-
-    Position += BufferSize + sizeof (Crc32);
-
-    Variable = AllocateZeroPool (sizeof (*Variable) + NameSize + DataSize);
-    if (Variable == NULL) {
-      FreePool (Buffer);
-      ShellStatus = SHELL_OUT_OF_RESOURCES;
-      break;
-    }
-    Variable->Signature = DMP_STORE_VARIABLE_SIGNATURE;
-    Variable->Name      = (CHAR16 *) (Variable + 1);
-    Variable->DataSize  = DataSize;
-    Variable->Data      = (UINT8 *) Variable->Name + NameSize;
-    CopyMem (Variable->Name,        Buffer + sizeof (NameSize) + sizeof (DataSize),                                                  NameSize);
-    CopyMem (&Variable->Guid,       Buffer + sizeof (NameSize) + sizeof (DataSize) + NameSize,                                       sizeof (EFI_GUID));
-    CopyMem (&Variable->Attributes, Buffer + sizeof (NameSize) + sizeof (DataSize) + NameSize + sizeof (EFI_GUID),                   sizeof (UINT32));
-    CopyMem (Variable->Data,        Buffer + sizeof (NameSize) + sizeof (DataSize) + NameSize + sizeof (EFI_GUID) + sizeof (UINT32), DataSize);
-
-    InsertTailList (&List, &Variable->Link);
-    FreePool (Buffer);
+    Position += Size;
   }
 
   if ((Position != FileSize) || (ShellStatus != SHELL_SUCCESS)) {
@@ -241,49 +507,65 @@ LoadVariablesFromFile (
     }
   }
 
-  for ( Link = GetFirstNode (&List)
-      ; !IsNull (&List, Link) && (ShellStatus == SHELL_SUCCESS)
-      ; Link = GetNextNode (&List, Link)
-      ) {
-    Variable = CR (Link, DMP_STORE_VARIABLE, Link, DMP_STORE_VARIABLE_SIGNATURE);
+  //
+  // Every variable is well formed, read them again to set them.
+  //
+  if (ShellStatus == SHELL_SUCCESS) {
+    Status = ShellSetFilePosition (FileHandle, 0);
+    if (EFI_ERROR (Status)) {
+      ShellStatus = SHELL_DEVICE_ERROR;
+    }
+  }
+
+  FileBuffer.Left = 0;
+  Position        = 0;
+  while ((Position < FileSize) && (ShellStatus == SHELL_SUCCESS)) {
+    ShellStatus = ReadSingleVariableFromFile (&FileBuffer, &Record, &RecordSize, &Variable, &Size);
+    if (ShellStatus != SHELL_SUCCESS) {
+      ShellPrintHiiEx(-1, -1, NULL, STRING_TOKEN (STR_DMPSTORE_LOAD_BAD_FILE), gShellDebug1HiiHandle, L"dmpstore");
+      break;
+    }
+    Position += Size;
 
-    if (((Name == NULL) || gUnicodeCollation->MetaiMatch (gUnicodeCollation, Variable->Name, (CHAR16 *) Name)) &&
-        ((Guid == NULL) || CompareGuid (&Variable->Guid, Guid))
+    if (((Name == NULL) || gUnicodeCollation->MetaiMatch (gUnicodeCollation, Variable.Name, (CHAR16 *) Name)) &&
+        ((Guid == NULL) || CompareGuid (&Variable.Guid, Guid))
        ) {
-      Attributes = GetAttrType (Variable->Attributes);
+      Attributes = GetAttrType (Variable.Attributes);
       ShellPrintHiiEx (
         -1, -1, NULL, STRING_TOKEN(STR_DMPSTORE_HEADER_LINE), gShellDebug1HiiHandle,
-        Attributes, &Variable->Guid, Variable->Name, Variable->DataSize
+        Attributes, &Variable.Guid, Variable.Name, Variable.DataSize
         );
       SHELL_FREE_NON_NULL(Attributes);
 
       *Found = TRUE;
       Status = gRT->SetVariable (
-                      Variable->Name,
-                      &Variable->Guid,
-                      Variable->Attributes,
-                      Variable->DataSize,
-                      Variable->Data
+                      Variable.Name,
+                      &Variable.Guid,
+                      Variable.Attributes,
+                      Variable.DataSize,
+                      Variable.Data
                       );
       if (EFI_ERROR (Status)) {
-        ShellPrintHiiEx(-1, -1, NULL, STRING_TOKEN (STR_DMPSTORE_LOAD_GEN_FAIL), gShellDebug1HiiHandle, L"dmpstore", Variable->Name, Status);
+        ShellPrintHiiEx(-1, -1, NULL, STRING_TOKEN (STR_DMPSTORE_LOAD_GEN_FAIL), gShellDebug1HiiHandle, L"dmpstore", Variable.Name, Status);
+      } else {
+        Stats->Count++;
+        Stats->Bytes += Variable.DataSize;
       }
     }
   }
 
-  for (Link = GetFirstNode (&List); !IsNull (&List, Link); ) {
-    Variable = CR (Link, DMP_STORE_VARIABLE, Link, DMP_STORE_VARIABLE_SIGNATURE);
-    Link = RemoveEntryList (&Variable->Link);
-    FreePool (Variable);
-  }
-
+  SHELL_FREE_NON_NULL (Record);
+  DmpStoreFileBufferUninit (&FileBuffer);
   return ShellStatus;
 }
 
 /**
   Append one variable to file.
 
-  @param[in] FileHandle        The file to be appended.
+  The variable is written to the buffer of the file, which is written to the
+  file when it is full.
+
+  @param[in, out] FileBuffer   The buffer of the file to be appended.
   @param[in] Name              The variable name.
   @param[in] Guid              The variable GUID.
   @param[in] Attributes        The variable attributes.
@@ -296,18 +578,21 @@ LoadVariablesFromFile (
 **/
 EFI_STATUS
 AppendSingleVariableToFile (
-  IN SHELL_FILE_HANDLE FileHandle,
-  IN CONST CHAR16      *Name,
-  IN CONST EFI_GUID    *Guid,
-  IN UINT32            Attributes,
-  IN UINT32            DataSize,
-  IN CONST UINT8       *Data
+  IN OUT DMP_STORE_FILE_BUFFER  *FileBuffer,
+  IN CONST CHAR16               *Name,
+  IN CONST EFI_GUID             *Guid,
+  IN UINT32                     Attributes,
+  IN UINT32                     DataSize,
+  IN CONST UINT8                *Data
   )
 {
   UINT32              NameSize;
   UINT8               *Buffer;
   UINT8               *Ptr;
   UINTN               BufferSize;
+  UINTN               WrittenSize;
+  UINT32              Crc32;
+  BOOLEAN             InFileBuffer;
   EFI_STATUS          Status;
 
   NameSize   = (UINT32) StrSize (Name);
@@ -317,18 +602,29 @@ AppendSingleVariableToFile (
              + NameSize + DataSize
              + sizeof (UINT32);
 
-  Buffer = AllocatePool (BufferSize);
-  if (Buffer == NULL) {
-    return EFI_OUT_OF_RESOURCES;
+  //
+  // Most variables fit in the buffer, only the larger ones need their own
+  // allocation.
+  //
+  Status = DmpStoreFileBufferReserve (FileBuffer, BufferSize, &Buffer);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+  InFileBuffer = (BOOLEAN) (Buffer != NULL);
+  if (!InFileBuffer) {
+    Buffer = AllocatePool (BufferSize);
+    if (Buffer == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
   }
 
   Ptr = Buffer;
   //
   // NameSize and DataSize
   //
-  * (UINT32 *) Ptr = NameSize;
+  WriteUnaligned32 ((UINT32 *) Ptr, NameSize);
   Ptr += sizeof (NameSize);
-  *(UINT32 *) Ptr = DataSize;
+  WriteUnaligned32 ((UINT32 *) Ptr, DataSize);
   Ptr += sizeof (DataSize);
 
   //
@@ -346,7 +642,7 @@ AppendSingleVariableToFile (
   //
   // Attributes
   //
-  * (UINT32 *) Ptr = Attributes;
+  WriteUnaligned32 ((UINT32 *) Ptr, Attributes);
   Ptr += sizeof (Attributes);
 
   //
@@ -358,14 +654,18 @@ AppendSingleVariableToFile (
   //
   // Crc32
   //
-  gBS->CalculateCrc32 (Buffer, (UINTN) Ptr - (UINTN) Buffer, (UINT32 *) Ptr);
+  gBS->CalculateCrc32 (Buffer, (UINTN) Ptr - (UINTN) Buffer, &Crc32);
+  WriteUnaligned32 ((UINT32 *) Ptr, Crc32);
+
+  if (InFileBuffer) {
+    return EFI_SUCCESS;
+  }
 
-  Status = ShellWriteFile (FileHandle, &BufferSize, Buffer);
+  WrittenSize = BufferSize;
+  Status = ShellWriteFile (FileBuffer->FileHandle, &WrittenSize, Buffer);
   FreePool (Buffer);
 
-  if (!EFI_ERROR (Status) &&
-      (BufferSize != sizeof (NameSize) + sizeof (DataSize) + sizeof (*Guid) + sizeof (Attributes) + NameSize + DataSize + sizeof (UINT32))
-    ) {
+  if (!EFI_ERROR (Status) && (WrittenSize != BufferSize)) {
     Status = EFI_DEVICE_ERROR;
   }
 
@@ -373,219 +673,338 @@ AppendSingleVariableToFile (
 }
 
 /**
-  Recursive function to display or delete variables.
+  Get the names and GUIDs of the variables to process.
 
-  This function will call itself to create a stack-based list of allt he variables to process,
-  then fromt he last to the first, they will do either printing or deleting.
+  All the variables are enumerated before any is processed, since once one
+  is deleted GetNextVariableName() will not work. The variables are returned
+  from the last enumerated to the first.
 
-  This is necessary since once a delete happens GetNextVariableName() will work.
-
-  @param[in] Name                 The variable name of the EFI variable (or NULL).
-  @param[in] Guid                 The GUID of the variable set (or NULL).
-  @param[in] Type                 The operation type.
-  @param[in] FileHandle           The file to operate on (or NULL).
-  @param[in] PrevName             The previous variable name from GetNextVariableName. L"" to start.
-  @param[in] FoundVarGuid         The previous GUID from GetNextVariableName. ignored at start.
-  @param[in] FoundOne             If a VariableName or Guid was specified and one was printed or
-                                  deleted, then set this to TRUE, otherwise ignored.
-  @param[in] StandardFormatOutput TRUE indicates Standard-Format Output.
+  @param[in]  Name                The variable name of the EFI variable (or NULL).
+  @param[in]  Guid                The GUID of the variable set (or NULL).
+  @param[out] List                The list of DMP_STORE_VARIABLE to process,
+                                  without their Attributes, DataSize and Data.
 
   @retval SHELL_SUCCESS           The operation was successful.
   @retval SHELL_OUT_OF_RESOURCES  A memorty allocation failed.
   @retval SHELL_ABORTED           The abort message was received.
   @retval SHELL_DEVICE_ERROR      UEFI Variable Services returned an error.
-  @retval SHELL_NOT_FOUND         the Name/Guid pair could not be found.
 **/
 SHELL_STATUS
-CascadeProcessVariables (
+CollectVariablesToProcess (
   IN CONST CHAR16      *Name        OPTIONAL,
   IN CONST EFI_GUID    *Guid        OPTIONAL,
-  IN DMP_STORE_TYPE    Type,
-  IN EFI_FILE_PROTOCOL *FileHandle  OPTIONAL,
-  IN CONST CHAR16      * CONST PrevName,
-  IN EFI_GUID          FoundVarGuid,
-  IN BOOLEAN           *FoundOne,
-  IN BOOLEAN           StandardFormatOutput
+  OUT LIST_ENTRY       *List
   )
 {
   EFI_STATUS                Status;
   CHAR16                    *FoundVarName;
-  UINT8                     *DataBuffer;
-  UINTN                     DataSize;
-  UINT32                    Atts;
-  SHELL_STATUS              ShellStatus;
+  UINTN                     FoundVarNameSize;
+  EFI_GUID                  FoundVarGuid;
+  CHAR16                    *NewName;
   UINTN                     NameSize;
-  CHAR16                    *AttrString;
-  CHAR16                    *HexString;
-  EFI_STATUS                SetStatus;
-  CONST CHAR16              *GuidName;
+  DMP_STORE_VARIABLE        *Variable;
 
-  if (ShellGetExecutionBreakFlag()) {
-    return (SHELL_ABORTED);
+  //
+  // The name buffer is reused and grown as needed, so each variable is
+  // usually enumerated with a single call.
+  //
+  FoundVarNameSize = 0x100;
+  FoundVarName     = AllocateZeroPool (FoundVarNameSize);
+  if (FoundVarName == NULL) {
+    return SHELL_OUT_OF_RESOURCES;
   }
+  ZeroMem (&FoundVarGuid, sizeof (EFI_GUID));
 
-  NameSize      = 0;
-  FoundVarName  = NULL;
-
-  if (PrevName!=NULL) {
-    StrnCatGrow(&FoundVarName, &NameSize, PrevName, 0);
-  } else {
-    FoundVarName = AllocateZeroPool(sizeof(CHAR16));
-    NameSize = sizeof(CHAR16);
-  }
+  while (TRUE) {
+    if (ShellGetExecutionBreakFlag()) {
+      FreePool (FoundVarName);
+      return (SHELL_ABORTED);
+    }
 
-  Status = gRT->GetNextVariableName (&NameSize, FoundVarName, &FoundVarGuid);
-  if (Status == EFI_BUFFER_TOO_SMALL) {
-    SHELL_FREE_NON_NULL(FoundVarName);
-    FoundVarName = AllocateZeroPool (NameSize);
-    if (FoundVarName != NULL) {
-      if (PrevName != NULL) {
-        StrnCpyS(FoundVarName, NameSize/sizeof(CHAR16), PrevName, NameSize/sizeof(CHAR16) - 1);
+    NameSize = FoundVarNameSize;
+    Status = gRT->GetNextVariableName (&NameSize, FoundVarName, &FoundVarGuid);
+    if (Status == EFI_BUFFER_TOO_SMALL) {
+      NewName = ReallocatePool (FoundVarNameSize, NameSize, FoundVarName);
+      if (NewName == NULL) {
+        FreePool (FoundVarName);
+        return SHELL_OUT_OF_RESOURCES;
       }
-
+      FoundVarName     = NewName;
+      FoundVarNameSize = NameSize;
       Status = gRT->GetNextVariableName (&NameSize, FoundVarName, &FoundVarGuid);
-    } else {
-      Status = EFI_OUT_OF_RESOURCES;
     }
-  }
 
-  //
-  // No more is fine.
-  //
-  if (Status == EFI_NOT_FOUND) {
-    SHELL_FREE_NON_NULL(FoundVarName);
-    return (SHELL_SUCCESS);
-  } else if (EFI_ERROR(Status)) {
-    SHELL_FREE_NON_NULL(FoundVarName);
-    return (SHELL_DEVICE_ERROR);
+    //
+    // No more is fine.
+    //
+    if (Status == EFI_NOT_FOUND) {
+      break;
+    } else if (EFI_ERROR(Status)) {
+      FreePool (FoundVarName);
+      return (SHELL_DEVICE_ERROR);
+    }
+
+    //
+    // Only keep the variable if Guid and VariableName are each either NULL
+    // or a match
+    //
+    if ( ( Name == NULL
+        || gUnicodeCollation->MetaiMatch(gUnicodeCollation, FoundVarName, (CHAR16*) Name) )
+       && ( Guid == NULL
+        || CompareGuid(&FoundVarGuid, Guid) )
+        ) {
+      NameSize = StrSize (FoundVarName);
+      Variable = AllocateZeroPool (sizeof (*Variable) + NameSize);
+      if (Variable == NULL) {
+        FreePool (FoundVarName);
+        return SHELL_OUT_OF_RESOURCES;
+      }
+      Variable->Signature = DMP_STORE_VARIABLE_SIGNATURE;
+      Variable->Name      = (CHAR16 *) (Variable + 1);
+      CopyMem (Variable->Name, FoundVarName, NameSize);
+      CopyGuid (&Variable->Guid, &FoundVarGuid);
+      InsertHeadList (List, &Variable->Link);
+    }
   }
 
-  //
-  // Recurse to the next iteration.  We know "our" variable's name.
-  //
-  ShellStatus = CascadeProcessVariables (Name, Guid, Type, FileHandle, FoundVarName, FoundVarGuid, FoundOne, StandardFormatOutput);
+  FreePool (FoundVarName);
+  return SHELL_SUCCESS;
+}
 
-  if (ShellGetExecutionBreakFlag() || (ShellStatus == SHELL_ABORTED)) {
-    SHELL_FREE_NON_NULL(FoundVarName);
-    return (SHELL_ABORTED);
-  }
+/**
+  Display, save or delete one variable.
 
-  //
-  // No matter what happened we process our own variable
-  // Only continue if Guid and VariableName are each either NULL or a match
-  //
-  if ( ( Name == NULL
-      || gUnicodeCollation->MetaiMatch(gUnicodeCollation, FoundVarName, (CHAR16*) Name) )
-     && ( Guid == NULL
-      || CompareGuid(&FoundVarGuid, Guid) )
-      ) {
-    DataSize      = 0;
-    DataBuffer    = NULL;
+  @param[in] Variable             The variable.
+  @param[in] Type                 The operation type.
+  @param[in] FileBuffer           The buffer of the file to save to (or NULL).
+  @param[in] StandardFormatOutput TRUE indicates Standard-Format Output.
+  @param[in, out] DataBuffer      The buffer to read the variable data into,
+                                  grown as needed and reused for the next
+                                  variable.
+  @param[in, out] DataBufferSize  The size in bytes of DataBuffer.
+  @param[in, out] Stats           The number of variables and bytes saved.
+
+  @retval EFI_SUCCESS             The variable was processed.
+  @return                         The error returned while getting the
+                                  variable or saving it.
+**/
+EFI_STATUS
+ProcessSingleVariable (
+  IN     CONST DMP_STORE_VARIABLE  *Variable,
+  IN     DMP_STORE_TYPE            Type,
+  IN     DMP_STORE_FILE_BUFFER     *FileBuffer  OPTIONAL,
+  IN     BOOLEAN                   StandardFormatOutput,
+  IN OUT UINT8                     **DataBuffer,
+  IN OUT UINTN                     *DataBufferSize,
+  IN OUT DMP_STORE_STATS           *Stats
+  )
+{
+  EFI_STATUS                Status;
+  UINTN                     DataSize;
+  UINT32                    Atts;
+  CHAR16                    *AttrString;
+  CHAR16                    *HexString;
+  EFI_STATUS                SetStatus;
+  CONST CHAR16              *GuidName;
+
+  Atts     = 0;
+  DataSize = *DataBufferSize;
+  Status = gRT->GetVariable (Variable->Name, (EFI_GUID *) &Variable->Guid, &Atts, &DataSize, *DataBuffer);
+  if (Status == EFI_BUFFER_TOO_SMALL) {
+    SHELL_FREE_NON_NULL (*DataBuffer);
+    *DataBufferSize = 0;
+    *DataBuffer     = AllocatePool (DataSize);
+    if (*DataBuffer == NULL) {
+      Status = EFI_OUT_OF_RESOURCES;
+    } else {
+      *DataBufferSize = DataSize;
+      Status = gRT->GetVariable (Variable->Name, (EFI_GUID *) &Variable->Guid, &Atts, &DataSize, *DataBuffer);
+    }
+  }
     //
-    // do the print or delete
+    // Last error check then print this variable out.
     //
-    *FoundOne = TRUE;
-    Status = gRT->GetVariable (FoundVarName, &FoundVarGuid, &Atts, &DataSize, DataBuffer);
-    if (Status == EFI_BUFFER_TOO_SMALL) {
-      SHELL_FREE_NON_NULL (DataBuffer);
-      DataBuffer = AllocatePool (DataSize);
-      if (DataBuffer == NULL) {
-        Status = EFI_OUT_OF_RESOURCES;
-      } else {
-        Status = gRT->GetVariable (FoundVarName, &FoundVarGuid, &Atts, &DataSize, DataBuffer);
-      }
-    }
-      //
-      // Last error check then print this variable out.
-      //
-    if (Type == DmpStoreDisplay) {
-      if (!EFI_ERROR(Status) && (DataBuffer != NULL) && (FoundVarName != NULL)) {
-        AttrString = GetAttrType(Atts);
-        if (StandardFormatOutput) {
-          HexString = AllocatePool ((DataSize * 2 + 1) * sizeof (CHAR16));
-          if (HexString != NULL) {
-            ShellPrintHiiEx (
-              -1, -1, NULL, STRING_TOKEN (STR_DMPSTORE_VAR_SFO), gShellDebug1HiiHandle,
-              FoundVarName, &FoundVarGuid, Atts, DataSize,
-              BinaryToHexString (
-                DataBuffer, DataSize, HexString, (DataSize * 2 + 1) * sizeof (CHAR16)
-                )
-              );
-            FreePool (HexString);
-          } else {
-            Status = EFI_OUT_OF_RESOURCES;
-          }
-        } else {
-          Status = gEfiShellProtocol->GetGuidName(&FoundVarGuid, &GuidName);
-          if (EFI_ERROR (Status)) {
-            ShellPrintHiiEx (
-              -1, -1, NULL, STRING_TOKEN (STR_DMPSTORE_HEADER_LINE), gShellDebug1HiiHandle,
-              AttrString, &FoundVarGuid, FoundVarName, DataSize
-              );
-          } else {
-            ShellPrintHiiEx (
-              -1, -1, NULL, STRING_TOKEN (STR_DMPSTORE_HEADER_LINE2), gShellDebug1HiiHandle,
-              AttrString, GuidName, FoundVarName, DataSize
-              );
-          }
-          DumpHex (2, 0, DataSize, DataBuffer);
-        }
-        SHELL_FREE_NON_NULL (AttrString);
-      }
-    } else if (Type == DmpStoreSave) {
-      if (!EFI_ERROR(Status) && (DataBuffer != NULL) && (FoundVarName != NULL)) {
-        AttrString = GetAttrType (Atts);
-        ShellPrintHiiEx (
-          -1, -1, NULL, STRING_TOKEN (STR_DMPSTORE_HEADER_LINE), gShellDebug1HiiHandle,
-          AttrString, &FoundVarGuid, FoundVarName, DataSize
-          );
-        Status = AppendSingleVariableToFile (
-                   FileHandle,
-                   FoundVarName,
-                   &FoundVarGuid,
-                   Atts,
-                   (UINT32) DataSize,
-                   DataBuffer
-                   );
-        SHELL_FREE_NON_NULL (AttrString);
-      }
-    } else if (Type == DmpStoreDelete) {
-      //
-      // We only need name to delete it...
-      //
-      SetStatus = gRT->SetVariable (FoundVarName, &FoundVarGuid, Atts, 0, NULL);
+  if (Type == DmpStoreDisplay) {
+    if (!EFI_ERROR(Status) && (*DataBuffer != NULL)) {
+      AttrString = GetAttrType(Atts);
       if (StandardFormatOutput) {
-        if (SetStatus == EFI_SUCCESS) {
+        HexString = AllocatePool ((DataSize * 2 + 1) * sizeof (CHAR16));
+        if (HexString != NULL) {
           ShellPrintHiiEx (
-            -1, -1, NULL, STRING_TOKEN (STR_DMPSTORE_NO_VAR_FOUND_NG_SFO), gShellDebug1HiiHandle,
-            FoundVarName, &FoundVarGuid
+            -1, -1, NULL, STRING_TOKEN (STR_DMPSTORE_VAR_SFO), gShellDebug1HiiHandle,
+            Variable->Name, &Variable->Guid, Atts, DataSize,
+            BinaryToHexString (
+              *DataBuffer, DataSize, HexString, (DataSize * 2 + 1) * sizeof (CHAR16)
+              )
             );
+          FreePool (HexString);
+        } else {
+          Status = EFI_OUT_OF_RESOURCES;
         }
       } else {
+        Status = gEfiShellProtocol->GetGuidName(&Variable->Guid, &GuidName);
+        if (EFI_ERROR (Status)) {
+          ShellPrintHiiEx (
+            -1, -1, NULL, STRING_TOKEN (STR_DMPSTORE_HEADER_LINE), gShellDebug1HiiHandle,
+            AttrString, &Variable->Guid, Variable->Name, DataSize
+            );
+        } else {
+          ShellPrintHiiEx (
+            -1, -1, NULL, STRING_TOKEN (STR_DMPSTORE_HEADER_LINE2), gShellDebug1HiiHandle,
+            AttrString, GuidName, Variable->Name, DataSize
+            );
+        }
+        DumpHex (2, 0, DataSize, *DataBuffer);
+      }
+      SHELL_FREE_NON_NULL (AttrString);
+    }
+  } else if (Type == DmpStoreSave) {
+    if (!EFI_ERROR(Status) && (*DataBuffer != NULL)) {
+      AttrString = GetAttrType (Atts);
+      ShellPrintHiiEx (
+        -1, -1, NULL, STRING_TOKEN (STR_DMPSTORE_HEADER_LINE), gShellDebug1HiiHandle,
+        AttrString, &Variable->Guid, Variable->Name, DataSize
+        );
+      Status = AppendSingleVariableToFile (
+                 FileBuffer,
+                 Variable->Name,
+                 &Variable->Guid,
+                 Atts,
+                 (UINT32) DataSize,
+                 *DataBuffer
+                 );
+      if (!EFI_ERROR (Status)) {
+        Stats->Count++;
+        Stats->Bytes += DataSize;
+      }
+      SHELL_FREE_NON_NULL (AttrString);
+    }
+  } else if (Type == DmpStoreDelete) {
+    //
+    // We only need name to delete it...
+    //
+    SetStatus = gRT->SetVariable (Variable->Name, (EFI_GUID *) &Variable->Guid, Atts, 0, NULL);
+    if (StandardFormatOutput) {
+      if (SetStatus == EFI_SUCCESS) {
         ShellPrintHiiEx (
-          -1, -1, NULL, STRING_TOKEN (STR_DMPSTORE_DELETE_LINE), gShellDebug1HiiHandle,
-          &FoundVarGuid, FoundVarName, SetStatus
+          -1, -1, NULL, STRING_TOKEN (STR_DMPSTORE_NO_VAR_FOUND_NG_SFO), gShellDebug1HiiHandle,
+          Variable->Name, &Variable->Guid
           );
       }
+    } else {
+      ShellPrintHiiEx (
+        -1, -1, NULL, STRING_TOKEN (STR_DMPSTORE_DELETE_LINE), gShellDebug1HiiHandle,
+        &Variable->Guid, Variable->Name, SetStatus
+        );
+    }
+  }
+
+  return Status;
+}
+
+/**
+  Display, save or delete the variables.
+
+  @param[in] Name                 The variable name of the EFI variable (or NULL).
+  @param[in] Guid                 The GUID of the variable set (or NULL).
+  @param[in] Type                 The operation type.
+  @param[in] FileHandle           The file to operate on (or NULL).
+  @param[out] FoundOne            If a VariableName or Guid was specified and one was printed or
+                                  deleted, then set this to TRUE, otherwise ignored.
+  @param[in] StandardFormatOutput TRUE indicates Standard-Format Output.
+  @param[in, out] Stats           The number of variables and bytes saved.
+
+  @retval SHELL_SUCCESS           The operation was successful.
+  @retval SHELL_OUT_OF_RESOURCES  A memorty allocation failed.
+  @retval SHELL_ABORTED           The abort message was received.
+  @retval SHELL_DEVICE_ERROR      UEFI Variable Services returned an error.
+  @retval SHELL_NOT_FOUND         the Name/Guid pair could not be found.
+**/
+SHELL_STATUS
+CascadeProcessVariables (
+  IN CONST CHAR16      *Name        OPTIONAL,
+  IN CONST EFI_GUID    *Guid        OPTIONAL,
+  IN DMP_STORE_TYPE    Type,
+  IN EFI_FILE_PROTOCOL *FileHandle  OPTIONAL,
+  OUT BOOLEAN          *FoundOne,
+  IN BOOLEAN           StandardFormatOutput,
+  IN OUT DMP_STORE_STATS *Stats
+  )
+{
+  EFI_STATUS             Status;
+  SHELL_STATUS           ShellStatus;
+  LIST_ENTRY             List;
+  LIST_ENTRY             *Link;
+  DMP_STORE_VARIABLE     *Variable;
+  DMP_STORE_FILE_BUFFER  FileBuffer;
+  UINT8                  *DataBuffer;
+  UINTN                  DataBufferSize;
+
+  ZeroMem (&FileBuffer, sizeof (FileBuffer));
+  if (Type == DmpStoreSave) {
+    Status = DmpStoreFileBufferInit (&FileBuffer, FileHandle);
+    if (EFI_ERROR (Status)) {
+      return SHELL_OUT_OF_RESOURCES;
     }
-    SHELL_FREE_NON_NULL(DataBuffer);
   }
 
-  SHELL_FREE_NON_NULL(FoundVarName);
+  InitializeListHead (&List);
+  ShellStatus = CollectVariablesToProcess (Name, Guid, &List);
+  if (ShellStatus == SHELL_OUT_OF_RESOURCES) {
+    for (Link = GetFirstNode (&List); !IsNull (&List, Link); ) {
+      Variable = CR (Link, DMP_STORE_VARIABLE, Link, DMP_STORE_VARIABLE_SIGNATURE);
+      Link = RemoveEntryList (&Variable->Link);
+      FreePool (Variable);
+    }
+    DmpStoreFileBufferUninit (&FileBuffer);
+    return ShellStatus;
+  }
 
-  if (Status == EFI_DEVICE_ERROR) {
-    ShellStatus = SHELL_DEVICE_ERROR;
-  } else if (Status == EFI_SECURITY_VIOLATION) {
-    ShellStatus = SHELL_SECURITY_VIOLATION;
-  } else if (EFI_ERROR(Status)) {
-    ShellStatus = SHELL_NOT_READY;
+  DataBuffer     = NULL;
+  DataBufferSize = 0;
+  for (Link = GetFirstNode (&List); !IsNull (&List, Link); ) {
+    Variable = CR (Link, DMP_STORE_VARIABLE, Link, DMP_STORE_VARIABLE_SIGNATURE);
+
+    if (ShellGetExecutionBreakFlag() || (ShellStatus == SHELL_ABORTED)) {
+      ShellStatus = SHELL_ABORTED;
+    } else {
+      *FoundOne = TRUE;
+      Status = ProcessSingleVariable (
+                 Variable,
+                 Type,
+                 &FileBuffer,
+                 StandardFormatOutput,
+                 &DataBuffer,
+                 &DataBufferSize,
+                 Stats
+                 );
+      if (Status == EFI_DEVICE_ERROR) {
+        ShellStatus = SHELL_DEVICE_ERROR;
+      } else if (Status == EFI_SECURITY_VIOLATION) {
+        ShellStatus = SHELL_SECURITY_VIOLATION;
+      } else if (EFI_ERROR(Status)) {
+        ShellStatus = SHELL_NOT_READY;
+      }
+    }
+
+    Link = RemoveEntryList (&Variable->Link);
+    FreePool (Variable);
+  }
+  SHELL_FREE_NON_NULL (DataBuffer);
+
+  if (Type == DmpStoreSave) {
+    Status = DmpStoreFileBufferFlush (&FileBuffer);
+    if (EFI_ERROR (Status) && (ShellStatus != SHELL_ABORTED)) {
+      ShellStatus = SHELL_DEVICE_ERROR;
+    }
+    DmpStoreFileBufferUninit (&FileBuffer);
   }
 
   return (ShellStatus);
 }
 
 /**
-  Function to display or delete variables.  This will set up and call into the recursive function.
+  Function to display or delete variables.  This will set up and call into the processing function.
 
   @param[in] Name                 The variable name of the EFI variable (or NULL).
   @param[in] Guid                 The GUID of the variable set (or NULL).
@@ -610,20 +1029,24 @@ ProcessVariables (
 {
   SHELL_STATUS              ShellStatus;
   BOOLEAN                   Found;
-  EFI_GUID                  FoundVarGuid;
+  DMP_STORE_STATS           Stats;
 
   Found         = FALSE;
   ShellStatus   = SHELL_SUCCESS;
-  ZeroMem (&FoundVarGuid, sizeof(EFI_GUID));
 
   if (StandardFormatOutput) {
     ShellPrintHiiEx(-1, -1, NULL, STRING_TOKEN(STR_GEN_SFO_HEADER), gShellDebug1HiiHandle, L"dmpstore");
   }
 
+  DmpStoreStatsStart (&Stats);
   if (Type == DmpStoreLoad) {
-    ShellStatus = LoadVariablesFromFile (FileHandle, Name, Guid, &Found);
+    ShellStatus = LoadVariablesFromFile (FileHandle, Name, Guid, &Found, &Stats);
   } else {
-    ShellStatus = CascadeProcessVariables (Name, Guid, Type, FileHandle, NULL, FoundVarGuid, &Found, StandardFormatOutput);
+    ShellStatus = CascadeProcessVariables (Name, Guid, Type, FileHandle, &Found, StandardFormatOutput, &Stats);
+  }
+
+  if ((Type == DmpStoreLoad) || (Type == DmpStoreSave)) {
+    DmpStoreStatsReport (&Stats);
   }
 
   if (!Found) {
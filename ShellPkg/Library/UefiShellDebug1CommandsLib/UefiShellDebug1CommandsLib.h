@@ -33,6 +33,7 @@
 #include <Protocol/SimplePointer.h>
 #include <Protocol/CpuIo2.h>
 #include <Protocol/PciRootBridgeIo.h>
+#include <Protocol/Timestamp.h>
 
 #include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
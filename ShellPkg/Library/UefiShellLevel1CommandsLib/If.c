@@ -727,25 +727,30 @@ MoveToTagSpecial (
    ){
 
     //
-    // get just the first part of the command line...
+    // get just the first part of the command line, which the shell extracted
+    // when it loaded the script...
     //
     CommandName   = NULL;
-    CommandName   = StrnCatGrow(&CommandName, NULL, CommandNode->Cl, 0);
-    if (CommandName == NULL) {
-      continue;
-    }
-    CommandWalker = CommandName;
+    if (CommandNode->Name != NULL) {
+      CommandWalker = CommandNode->Name;
+    } else {
+      CommandName   = StrnCatGrow(&CommandName, NULL, CommandNode->Cl, 0);
+      if (CommandName == NULL) {
+        continue;
+      }
+      CommandWalker = CommandName;
 
-    //
-    // Skip leading spaces and tabs.
-    //
-    while ((CommandWalker[0] == L' ') || (CommandWalker[0] == L'\t')) {
-      CommandWalker++;
-    }
-    TempLocation  = StrStr(CommandWalker, L" ");
+      //
+      // Skip leading spaces and tabs.
+      //
+      while ((CommandWalker[0] == L' ') || (CommandWalker[0] == L'\t')) {
+        CommandWalker++;
+      }
+      TempLocation  = StrStr(CommandWalker, L" ");
 
-    if (TempLocation != NULL) {
-      *TempLocation = CHAR_NULL;
+      if (TempLocation != NULL) {
+        *TempLocation = CHAR_NULL;
+      }
     }
 
     //
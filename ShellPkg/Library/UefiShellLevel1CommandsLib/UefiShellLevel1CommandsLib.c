@@ -135,26 +135,31 @@ TestNodeForMove (
   Found = FALSE;
 
   //
-  // get just the first part of the command line...
+  // get just the first part of the command line, which the shell extracted
+  // when it loaded the script...
   //
   CommandName   = NULL;
-  CommandName   = StrnCatGrow(&CommandName, NULL, CommandNode->Cl, 0);
-  if (CommandName == NULL) {
-    return (FALSE);
-  }
+  if (CommandNode->Name != NULL) {
+    CommandNameWalker = CommandNode->Name;
+  } else {
+    CommandName   = StrnCatGrow(&CommandName, NULL, CommandNode->Cl, 0);
+    if (CommandName == NULL) {
+      return (FALSE);
+    }
 
-  CommandNameWalker = CommandName;
+    CommandNameWalker = CommandName;
 
-  //
-  // Skip leading spaces and tabs.
-  //
-  while ((CommandNameWalker[0] == L' ') || (CommandNameWalker[0] == L'\t')) {
-    CommandNameWalker++;
-  }
-  TempLocation  = StrStr(CommandNameWalker, L" ");
+    //
+    // Skip leading spaces and tabs.
+    //
+    while ((CommandNameWalker[0] == L' ') || (CommandNameWalker[0] == L'\t')) {
+      CommandNameWalker++;
+    }
+    TempLocation  = StrStr(CommandNameWalker, L" ");
 
-  if (TempLocation != NULL) {
-    *TempLocation = CHAR_NULL;
+    if (TempLocation != NULL) {
+      *TempLocation = CHAR_NULL;
+    }
   }
 
   //
@@ -211,7 +216,7 @@ TestNodeForMove (
   //
   // Free the memory for this loop...
   //
-  FreePool(CommandName);
+  SHELL_FREE_NON_NULL(CommandName);
   return (Found);
 }
 
@@ -11,6 +11,349 @@
 #include <Guid/FileSystemInfo.h>
 #include <Guid/FileSystemVolumeLabelInfo.h>
 
+//
+// Largest buffer used to copy the data of a file. Two are allocated when the
+// file systems of both files support non-blocking I/O, so the next block is
+// read while the previous one is written.
+//
+#define COPY_BUFFER_MAX_SIZE      SIZE_4MB
+
+//
+// Periods per second of the timer measuring a copy. The progress is reported
+// every second.
+//
+#define COPY_PERIODS_PER_SECOND   10
+#define COPY_TIMER_PERIOD         EFI_TIMER_PERIOD_MILLISECONDS (1000 / COPY_PERIODS_PER_SECOND)
+
+typedef struct {
+  CONST CHAR16    *CmdName;
+  UINT64          FileSize;
+  UINT64          Copied;
+  EFI_EVENT       Timer;
+  volatile UINTN  Periods;
+  UINTN           LastReport;
+  BOOLEAN         Reported;
+} COPY_PROGRESS;
+
+/**
+  Count the periods of the timer measuring a copy.
+
+  @param[in] Event      The timer event.
+  @param[in] Context    The COPY_PROGRESS of the copy.
+**/
+VOID
+EFIAPI
+CopyTimerNotify (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  ((COPY_PROGRESS *) Context)->Periods++;
+}
+
+/**
+  Report the progress and the throughput of a copy.
+
+  Nothing is reported for the copies that complete within the first report
+  period.
+
+  @param[in, out] Progress  The progress of the copy.
+  @param[in]      Done      TRUE for the final report of the copy.
+**/
+VOID
+CopyReportProgress (
+  IN OUT COPY_PROGRESS  *Progress,
+  IN     BOOLEAN        Done
+  )
+{
+  UINTN   Periods;
+  UINT64  Percent;
+  UINT64  Rate;
+
+  if (Progress->Timer == NULL) {
+    return;
+  }
+
+  Periods = Progress->Periods;
+  if (Done ? !Progress->Reported : (Periods - Progress->LastReport < COPY_PERIODS_PER_SECOND)) {
+    return;
+  }
+
+  Progress->LastReport = Periods;
+  Progress->Reported   = TRUE;
+
+  Rate = 0;
+  if (Periods != 0) {
+    Rate = RShiftU64 (
+             DivU64x32 (MultU64x32 (Progress->Copied, COPY_PERIODS_PER_SECOND), (UINT32) Periods),
+             20
+             );
+  }
+
+  if (Done) {
+    ShellPrintHiiEx (
+      -1, -1, NULL, STRING_TOKEN (STR_CP_PROGRESS_DONE), gShellLevel2HiiHandle,
+      Progress->CmdName,
+      RShiftU64 (Progress->Copied, 20),
+      (UINT64) (Periods / COPY_PERIODS_PER_SECOND),
+      Rate
+      );
+  } else {
+    Percent = 100;
+    if (Progress->FileSize != 0) {
+      Percent = DivU64x64Remainder (MultU64x32 (Progress->Copied, 100), Progress->FileSize, NULL);
+    }
+    ShellPrintHiiEx (
+      -1, -1, NULL, STRING_TOKEN (STR_CP_PROGRESS), gShellLevel2HiiHandle,
+      Progress->CmdName,
+      Percent,
+      RShiftU64 (Progress->Copied, 20),
+      Rate
+      );
+  }
+}
+
+/**
+  Start a read or a write of a copy.
+
+  @param[in]      File      The file to access.
+  @param[in, out] Token     The token of the access.
+  @param[in]      Write     TRUE to write, FALSE to read.
+  @param[in]      NonBlock  TRUE to use ReadEx() or WriteEx(), which complete
+                            when Token->Event is signaled. Otherwise the
+                            access is complete on return.
+
+  @return The status returned by the file system.
+**/
+EFI_STATUS
+CopyStartIo (
+  IN     EFI_FILE_PROTOCOL  *File,
+  IN OUT EFI_FILE_IO_TOKEN  *Token,
+  IN     BOOLEAN            Write,
+  IN     BOOLEAN            NonBlock
+  )
+{
+  if (NonBlock) {
+    return Write ? File->WriteEx (File, Token) : File->ReadEx (File, Token);
+  }
+
+  Token->Status = Write ?
+                  File->Write (File, &Token->BufferSize, Token->Buffer) :
+                  File->Read (File, &Token->BufferSize, Token->Buffer);
+  return Token->Status;
+}
+
+/**
+  Wait for a read or a write started by CopyStartIo() to complete.
+
+  @param[in, out] Token     The token of the access.
+  @param[in]      NonBlock  The NonBlock value passed to CopyStartIo().
+
+  @return The status of the access.
+**/
+EFI_STATUS
+CopyFinishIo (
+  IN OUT EFI_FILE_IO_TOKEN  *Token,
+  IN     BOOLEAN            NonBlock
+  )
+{
+  UINTN   Index;
+
+  if (NonBlock) {
+    gBS->WaitForEvent (1, &Token->Event, &Index);
+  }
+  return Token->Status;
+}
+
+/**
+  Copy the data of a file to another file.
+
+  The data is copied in blocks of up to COPY_BUFFER_MAX_SIZE bytes, or less
+  if the memory is short. When both files support non-blocking I/O, the next
+  block is read with ReadEx() while the previous one is written with
+  WriteEx(). Otherwise blocking Read() and Write() calls alternate.
+
+  @param[in] SourceHandle   The file to read, at position 0.
+  @param[in] DestHandle     The file to write, at position 0.
+  @param[in] FileSize       The size of the source file, for the progress.
+  @param[in] ShowProgress   TRUE to report the progress and the throughput
+                            of the copies that last more than a second.
+  @param[in] Source         The name of the source file, for the messages.
+  @param[in] Dest           The name of the destination file, for the messages.
+  @param[in] CmdName        The command copying the file, for the messages.
+
+  @retval SHELL_SUCCESS           The data was copied.
+  @retval SHELL_OUT_OF_RESOURCES  The buffer could not be allocated.
+  @retval SHELL_ABORTED           The copy was interrupted by the user.
+  @return Other                   The status of the failed access.
+**/
+SHELL_STATUS
+CopyFileData (
+  IN SHELL_FILE_HANDLE  SourceHandle,
+  IN SHELL_FILE_HANDLE  DestHandle,
+  IN UINT64             FileSize,
+  IN BOOLEAN            ShowProgress,
+  IN CONST CHAR16       *Source,
+  IN CONST CHAR16       *Dest,
+  IN CONST CHAR16       *CmdName
+  )
+{
+  EFI_FILE_PROTOCOL   *SourceFile;
+  EFI_FILE_PROTOCOL   *DestFile;
+  BOOLEAN             NonBlock;
+  UINTN               BufferSize;
+  VOID                *Buffers[2];
+  UINTN               Current;
+  EFI_FILE_IO_TOKEN   ReadToken;
+  EFI_FILE_IO_TOKEN   WriteToken;
+  EFI_STATUS          Status;
+  EFI_STATUS          ReadStatus;
+  BOOLEAN             More;
+  COPY_PROGRESS       Progress;
+  SHELL_STATUS        ShellStatus;
+
+  SourceFile  = ConvertShellHandleToEfiFileProtocol (SourceHandle);
+  DestFile    = ConvertShellHandleToEfiFileProtocol (DestHandle);
+  ShellStatus = SHELL_SUCCESS;
+  ZeroMem (&ReadToken, sizeof (ReadToken));
+  ZeroMem (&WriteToken, sizeof (WriteToken));
+  ZeroMem (&Progress, sizeof (Progress));
+  Buffers[0]  = NULL;
+  Buffers[1]  = NULL;
+
+  NonBlock = (BOOLEAN) (SourceFile->Revision >= EFI_FILE_PROTOCOL_REVISION2 &&
+                        DestFile->Revision >= EFI_FILE_PROTOCOL_REVISION2);
+  if (NonBlock) {
+    Status = gBS->CreateEvent (0, TPL_CALLBACK, NULL, NULL, &ReadToken.Event);
+    if (!EFI_ERROR (Status)) {
+      Status = gBS->CreateEvent (0, TPL_CALLBACK, NULL, NULL, &WriteToken.Event);
+    }
+    NonBlock = (BOOLEAN) !EFI_ERROR (Status);
+  }
+
+  //
+  // Size the buffers after the file, so that a short read ends the copy, and
+  // halve them while they cannot be allocated.
+  //
+  BufferSize = PcdGet32 (PcdShellFileOperationSize);
+  while ((BufferSize < COPY_BUFFER_MAX_SIZE) && (BufferSize <= FileSize)) {
+    BufferSize *= 2;
+  }
+  while (TRUE) {
+    Buffers[0] = AllocatePool (BufferSize);
+    Buffers[1] = NonBlock ? AllocatePool (BufferSize) : Buffers[0];
+    if ((Buffers[0] != NULL) && (Buffers[1] != NULL)) {
+      break;
+    }
+    if (NonBlock) {
+      SHELL_FREE_NON_NULL (Buffers[1]);
+    }
+    SHELL_FREE_NON_NULL (Buffers[0]);
+    Buffers[1] = NULL;
+    if (BufferSize <= PcdGet32 (PcdShellFileOperationSize)) {
+      ShellPrintHiiEx (-1, -1, NULL, STRING_TOKEN (STR_GEN_OUT_MEM), gShellLevel2HiiHandle, CmdName);
+      ShellStatus = SHELL_OUT_OF_RESOURCES;
+      goto Done;
+    }
+    BufferSize /= 2;
+  }
+
+  if (ShowProgress) {
+    Progress.CmdName  = CmdName;
+    Progress.FileSize = FileSize;
+    Status = gBS->CreateEvent (EVT_TIMER | EVT_NOTIFY_SIGNAL, TPL_CALLBACK, CopyTimerNotify, &Progress, &Progress.Timer);
+    if (!EFI_ERROR (Status)) {
+      gBS->SetTimer (Progress.Timer, TimerPeriodic, COPY_TIMER_PERIOD);
+    } else {
+      Progress.Timer = NULL;
+    }
+  }
+
+  //
+  // Read the first block. File systems that report revision 2 without
+  // supporting non-blocking I/O get blocking I/O.
+  //
+  Current              = 0;
+  ReadToken.Buffer     = Buffers[Current];
+  ReadToken.BufferSize = BufferSize;
+  ReadStatus = CopyStartIo (SourceFile, &ReadToken, FALSE, NonBlock);
+  if (NonBlock && (ReadStatus == EFI_UNSUPPORTED)) {
+    NonBlock             = FALSE;
+    ReadToken.BufferSize = BufferSize;
+    ReadStatus = CopyStartIo (SourceFile, &ReadToken, FALSE, NonBlock);
+  }
+  if (!EFI_ERROR (ReadStatus)) {
+    ReadStatus = CopyFinishIo (&ReadToken, NonBlock);
+  }
+
+  while (!EFI_ERROR (ReadStatus) && (ReadToken.BufferSize > 0)) {
+    //
+    // Write the block just read, and read the next one meanwhile. The source
+    // is at its end when a block is short.
+    //
+    WriteToken.Buffer     = ReadToken.Buffer;
+    WriteToken.BufferSize = ReadToken.BufferSize;
+    Status = CopyStartIo (DestFile, &WriteToken, TRUE, NonBlock);
+
+    More = (BOOLEAN) (!EFI_ERROR (Status) && (ReadToken.BufferSize == BufferSize));
+    if (More) {
+      Current              = (Current + 1) % ARRAY_SIZE (Buffers);
+      ReadToken.Buffer     = Buffers[Current];
+      ReadToken.BufferSize = BufferSize;
+      ReadStatus = CopyStartIo (SourceFile, &ReadToken, FALSE, NonBlock);
+    }
+
+    if (!EFI_ERROR (Status)) {
+      Status = CopyFinishIo (&WriteToken, NonBlock);
+    }
+    if (More && !EFI_ERROR (ReadStatus)) {
+      ReadStatus = CopyFinishIo (&ReadToken, NonBlock);
+    }
+
+    if (EFI_ERROR (Status)) {
+      ShellStatus = (SHELL_STATUS) (Status & (~MAX_BIT));
+      ShellPrintHiiEx (-1, -1, NULL, STRING_TOKEN (STR_GEN_CPY_WRITE_ERROR), gShellLevel2HiiHandle, CmdName, Dest);
+      goto Done;
+    }
+
+    Progress.Copied += WriteToken.BufferSize;
+    CopyReportProgress (&Progress, FALSE);
+
+    if (!More) {
+      break;
+    }
+    if (ShellGetExecutionBreakFlag ()) {
+      ShellStatus = SHELL_ABORTED;
+      goto Done;
+    }
+  }
+
+  if (EFI_ERROR (ReadStatus)) {
+    ShellStatus = (SHELL_STATUS) (ReadStatus & (~MAX_BIT));
+    ShellPrintHiiEx (-1, -1, NULL, STRING_TOKEN (STR_GEN_CPY_READ_ERROR), gShellLevel2HiiHandle, CmdName, Source);
+    goto Done;
+  }
+
+  CopyReportProgress (&Progress, TRUE);
+
+Done:
+  if (Progress.Timer != NULL) {
+    gBS->CloseEvent (Progress.Timer);
+  }
+  if (ReadToken.Event != NULL) {
+    gBS->CloseEvent (ReadToken.Event);
+  }
+  if (WriteToken.Event != NULL) {
+    gBS->CloseEvent (WriteToken.Event);
+  }
+  if (Buffers[1] != Buffers[0]) {
+    SHELL_FREE_NON_NULL (Buffers[1]);
+  }
+  SHELL_FREE_NON_NULL (Buffers[0]);
+
+  return ShellStatus;
+}
+
 /**
   Function to take a list of files to copy and a destination location and do
   the verification and copying of those files to that location.  This function
@@ -60,17 +403,16 @@ CopySingleFile(
   )
 {
   VOID                  *Response;
-  UINTN                 ReadSize;
   SHELL_FILE_HANDLE     SourceHandle;
   SHELL_FILE_HANDLE     DestHandle;
   EFI_STATUS            Status;
-  VOID                  *Buffer;
   CHAR16                *TempName;
   UINTN                 Size;
   EFI_SHELL_FILE_INFO   *List;
   SHELL_STATUS          ShellStatus;
   UINT64                SourceFileSize;
   UINT64                DestFileSize;
+  UINT64                CopySize;
   EFI_FILE_PROTOCOL     *DestVolumeFP;
   EFI_FILE_SYSTEM_INFO  *DestVolumeInfo;
   UINTN                 DestVolumeInfoSize;
@@ -84,7 +426,6 @@ CopySingleFile(
   DestVolumeInfo  = NULL;
   ShellStatus     = SHELL_SUCCESS;
 
-  ReadSize = PcdGet32(PcdShellFileOperationSize);
   // Why bother copying a file to itself
   if (StrCmp(Source, Dest) == 0) {
     return (SHELL_SUCCESS);
@@ -176,6 +517,7 @@ CopySingleFile(
     //
     ShellGetFileSize(SourceHandle, &SourceFileSize);
     ShellGetFileSize(DestHandle, &DestFileSize);
+    CopySize = SourceFileSize;
 
     //
     //if the destination file already exists then it will be replaced, meaning the sourcefile effectively needs less storage space
@@ -221,28 +563,18 @@ CopySingleFile(
       return(SHELL_VOLUME_FULL);
     } else {
       //
-      // copy data between files
+      // copy data between files. mv has no quiet mode, it only passes
+      // SilentMode to skip the overwrite prompt it has done already.
       //
-      Buffer = AllocateZeroPool(ReadSize);
-      if (Buffer == NULL) {
-        ShellPrintHiiEx (-1, -1, NULL, STRING_TOKEN (STR_GEN_OUT_MEM), gShellLevel2HiiHandle, CmdName);
-        return SHELL_OUT_OF_RESOURCES;
-      }
-      while (ReadSize == PcdGet32(PcdShellFileOperationSize) && !EFI_ERROR(Status)) {
-        Status = ShellReadFile(SourceHandle, &ReadSize, Buffer);
-        if (!EFI_ERROR(Status)) {
-          Status = ShellWriteFile(DestHandle, &ReadSize, Buffer);
-          if (EFI_ERROR(Status)) {
-            ShellStatus = (SHELL_STATUS) (Status & (~MAX_BIT));
-            ShellPrintHiiEx(-1, -1, NULL, STRING_TOKEN (STR_GEN_CPY_WRITE_ERROR), gShellLevel2HiiHandle, CmdName, Dest);
-            break;
-          }
-        } else {
-          ShellStatus = (SHELL_STATUS) (Status & (~MAX_BIT));
-          ShellPrintHiiEx(-1, -1, NULL, STRING_TOKEN (STR_GEN_CPY_READ_ERROR), gShellLevel2HiiHandle, CmdName, Source);
-          break;
-        }
-      }
+      ShellStatus = CopyFileData (
+                      SourceHandle,
+                      DestHandle,
+                      CopySize,
+                      (BOOLEAN) (!SilentMode || (StrCmp (CmdName, L"mv") == 0)),
+                      Source,
+                      Dest,
+                      CmdName
+                      );
     }
     SHELL_FREE_NON_NULL(DestVolumeInfo);
   }
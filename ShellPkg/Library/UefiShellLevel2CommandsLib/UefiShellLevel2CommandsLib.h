@@ -320,6 +320,38 @@ ShellCommandRunVol (
   IN EFI_SYSTEM_TABLE  *SystemTable
   );
 
+/**
+  Copy the data of a file to another file.
+
+  The data is copied in blocks of up to 4 MB. When both files support
+  non-blocking I/O, the next block is read with ReadEx() while the previous
+  one is written with WriteEx().
+
+  @param[in] SourceHandle   The file to read, at position 0.
+  @param[in] DestHandle     The file to write, at position 0.
+  @param[in] FileSize       The size of the source file, for the progress.
+  @param[in] ShowProgress   TRUE to report the progress and the throughput
+                            of the copies that last more than a second.
+  @param[in] Source         The name of the source file, for the messages.
+  @param[in] Dest           The name of the destination file, for the messages.
+  @param[in] CmdName        The command copying the file, for the messages.
+
+  @retval SHELL_SUCCESS           The data was copied.
+  @retval SHELL_OUT_OF_RESOURCES  The buffer could not be allocated.
+  @retval SHELL_ABORTED           The copy was interrupted by the user.
+  @return Other                   The status of the failed access.
+**/
+SHELL_STATUS
+CopyFileData (
+  IN SHELL_FILE_HANDLE  SourceHandle,
+  IN SHELL_FILE_HANDLE  DestHandle,
+  IN UINT64             FileSize,
+  IN BOOLEAN            ShowProgress,
+  IN CONST CHAR16       *Source,
+  IN CONST CHAR16       *Dest,
+  IN CONST CHAR16       *CmdName
+  );
+
 /**
   Function to Copy one file to another location
 
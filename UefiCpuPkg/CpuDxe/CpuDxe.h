@@ -27,6 +27,7 @@
 #include <Library/MemoryAllocationLib.h>
 #include <Library/DebugLib.h>
 #include <Library/MtrrLib.h>
+#include <Library/CpuPageTableLib.h>
 #include <Library/LocalApicLib.h>
 #include <Library/UefiCpuLib.h>
 #include <Library/UefiLib.h>
@@ -57,18 +57,12 @@
 #define PAGING_1G_ADDRESS_MASK_64 0x000FFFFFC0000000ull
 
 #define MAX_PF_ENTRY_COUNT        10
+#define MAX_PENDING_FREE_PAGES    64
 #define MAX_DEBUG_MESSAGE_LENGTH  0x100
 #define IA32_PF_EC_ID             BIT4
 
-typedef enum {
-  PageNone,
-  Page4K,
-  Page2M,
-  Page1G,
-} PAGE_ATTRIBUTE;
-
 typedef struct {
-  PAGE_ATTRIBUTE   Attribute;
+  CPU_PAGE_SIZE    Attribute;
   UINT64           Length;
   UINT64           AddressMask;
 } PAGE_ATTRIBUTE_TABLE;
@@ -80,13 +74,30 @@ typedef enum {
 } PAGE_ACTION;
 
 PAGE_ATTRIBUTE_TABLE mPageAttributeTable[] = {
-  {Page4K,  SIZE_4KB, PAGING_4K_ADDRESS_MASK_64},
-  {Page2M,  SIZE_2MB, PAGING_2M_ADDRESS_MASK_64},
-  {Page1G,  SIZE_1GB, PAGING_1G_ADDRESS_MASK_64},
+  {CpuPage4K,  SIZE_4KB, PAGING_4K_ADDRESS_MASK_64},
+  {CpuPage2M,  SIZE_2MB, PAGING_2M_ADDRESS_MASK_64},
+  {CpuPage1G,  SIZE_1GB, PAGING_1G_ADDRESS_MASK_64},
 };
 
 PAGE_TABLE_POOL                   *mPageTablePool = NULL;
 BOOLEAN                           mPageTablePoolLock = FALSE;
+//
+// Page table pages released by merging, linked through their first 8 bytes.
+//
+VOID                              *mPageTableFreeList = NULL;
+UINTN                             mPageTableFreeListPages = 0;
+//
+// Page table pages released by merging which any processor may still cache.
+// They are left untouched until every processor has flushed its TLB.
+//
+VOID                              *mPageTablePendingFree[MAX_PENDING_FREE_PAGES];
+UINTN                             mPageTablePendingFreePages = 0;
+BOOLEAN                           mPageTableReleasing = FALSE;
+//
+// Nesting depth of AssignMemoryPageAttributes(), which may be re-entered
+// through the memory allocations made while it runs.
+//
+UINTN                             mPageTableUpdateDepth = 0;
 PAGE_TABLE_LIB_PAGING_CONTEXT     mPagingContext;
 EFI_SMM_BASE2_PROTOCOL            *mSmmBase2 = NULL;
 
@@ -227,7 +238,7 @@ GetCurrentPagingContext (
 **/
 UINTN
 PageAttributeToLength (
-  IN PAGE_ATTRIBUTE  PageAttribute
+  IN CPU_PAGE_SIZE   PageAttribute
   )
 {
   UINTN  Index;
@@ -248,7 +259,7 @@ PageAttributeToLength (
 **/
 UINTN
 PageAttributeToMask (
-  IN PAGE_ATTRIBUTE  PageAttribute
+  IN CPU_PAGE_SIZE   PageAttribute
   )
 {
   UINTN  Index;
@@ -261,96 +272,59 @@ PageAttributeToMask (
 }
 
 /**
-  Return page table entry to match the address.
+  Describe the page table of a paging context for CpuPageTableLib.
 
   @param[in]  PagingContext     The paging context.
-  @param[in]  Address           The address to be checked.
-  @param[out] PageAttributes    The page attribute of the page entry.
-
-  @return The page entry.
+  @param[out] PageTable         The page table.
 **/
-VOID *
-GetPageTableEntry (
+VOID
+GetCpuPageTable (
   IN  PAGE_TABLE_LIB_PAGING_CONTEXT     *PagingContext,
-  IN  PHYSICAL_ADDRESS                  Address,
-  OUT PAGE_ATTRIBUTE                    *PageAttribute
+  OUT CPU_PAGE_TABLE                    *PageTable
   )
 {
-  UINTN                 Index1;
-  UINTN                 Index2;
-  UINTN                 Index3;
-  UINTN                 Index4;
-  UINTN                 Index5;
-  UINT64                *L1PageTable;
-  UINT64                *L2PageTable;
-  UINT64                *L3PageTable;
-  UINT64                *L4PageTable;
-  UINT64                *L5PageTable;
-  UINT64                AddressEncMask;
+  UINT32                Attributes;
 
   ASSERT (PagingContext != NULL);
 
-  Index5 = ((UINTN)RShiftU64 (Address, 48)) & PAGING_PAE_INDEX_MASK;
-  Index4 = ((UINTN)RShiftU64 (Address, 39)) & PAGING_PAE_INDEX_MASK;
-  Index3 = ((UINTN)Address >> 30) & PAGING_PAE_INDEX_MASK;
-  Index2 = ((UINTN)Address >> 21) & PAGING_PAE_INDEX_MASK;
-  Index1 = ((UINTN)Address >> 12) & PAGING_PAE_INDEX_MASK;
+  if (PagingContext->MachineType == IMAGE_FILE_MACHINE_X64) {
+    Attributes               = PagingContext->ContextData.X64.Attributes;
+    PageTable->PageTableBase = PagingContext->ContextData.X64.PageTableBase;
+    PageTable->Levels        = ((Attributes & PAGE_TABLE_LIB_PAGING_CONTEXT_IA32_X64_ATTRIBUTES_5_LEVEL) != 0) ? 5 : 4;
+    PageTable->Page1GSupport = (BOOLEAN)((Attributes & PAGE_TABLE_LIB_PAGING_CONTEXT_IA32_X64_ATTRIBUTES_PAGE_1G_SUPPORT) != 0);
+  } else {
+    ASSERT((PagingContext->ContextData.Ia32.Attributes & PAGE_TABLE_LIB_PAGING_CONTEXT_IA32_X64_ATTRIBUTES_PAE) != 0);
+    PageTable->PageTableBase = PagingContext->ContextData.Ia32.PageTableBase;
+    PageTable->Levels        = 3;
+    PageTable->Page1GSupport = FALSE;
+  }
 
+  //
   // Make sure AddressEncMask is contained to smallest supported address field.
   //
-  AddressEncMask = PcdGet64 (PcdPteMemoryEncryptionAddressOrMask) & PAGING_1G_ADDRESS_MASK_64;
-
-  if (PagingContext->MachineType == IMAGE_FILE_MACHINE_X64) {
-    if ((PagingContext->ContextData.X64.Attributes & PAGE_TABLE_LIB_PAGING_CONTEXT_IA32_X64_ATTRIBUTES_5_LEVEL) != 0) {
-      L5PageTable = (UINT64 *)(UINTN)PagingContext->ContextData.X64.PageTableBase;
-      if (L5PageTable[Index5] == 0) {
-        *PageAttribute = PageNone;
-        return NULL;
-      }
+  PageTable->AddressEncMask = PcdGet64 (PcdPteMemoryEncryptionAddressOrMask) & PAGING_1G_ADDRESS_MASK_64;
+}
 
-      L4PageTable = (UINT64 *)(UINTN)(L5PageTable[Index5] & ~AddressEncMask & PAGING_4K_ADDRESS_MASK_64);
-    } else {
-      L4PageTable = (UINT64 *)(UINTN)PagingContext->ContextData.X64.PageTableBase;
-    }
-    if (L4PageTable[Index4] == 0) {
-      *PageAttribute = PageNone;
-      return NULL;
-    }
+/**
+  Return page table entry to match the address.
 
-    L3PageTable = (UINT64 *)(UINTN)(L4PageTable[Index4] & ~AddressEncMask & PAGING_4K_ADDRESS_MASK_64);
-  } else {
-    ASSERT((PagingContext->ContextData.Ia32.Attributes & PAGE_TABLE_LIB_PAGING_CONTEXT_IA32_X64_ATTRIBUTES_PAE) != 0);
-    L3PageTable = (UINT64 *)(UINTN)PagingContext->ContextData.Ia32.PageTableBase;
-  }
-  if (L3PageTable[Index3] == 0) {
-    *PageAttribute = PageNone;
-    return NULL;
-  }
-  if ((L3PageTable[Index3] & IA32_PG_PS) != 0) {
-    // 1G
-    *PageAttribute = Page1G;
-    return &L3PageTable[Index3];
-  }
+  @param[in]  PagingContext     The paging context.
+  @param[in]  Address           The address to be checked.
+  @param[out] PageAttributes    The page attribute of the page entry.
 
-  L2PageTable = (UINT64 *)(UINTN)(L3PageTable[Index3] & ~AddressEncMask & PAGING_4K_ADDRESS_MASK_64);
-  if (L2PageTable[Index2] == 0) {
-    *PageAttribute = PageNone;
-    return NULL;
-  }
-  if ((L2PageTable[Index2] & IA32_PG_PS) != 0) {
-    // 2M
-    *PageAttribute = Page2M;
-    return &L2PageTable[Index2];
-  }
+  @return The page entry.
+**/
+UINT64 *
+GetPageTableEntry (
+  IN  PAGE_TABLE_LIB_PAGING_CONTEXT     *PagingContext,
+  IN  PHYSICAL_ADDRESS                  Address,
+  OUT CPU_PAGE_SIZE                     *PageAttribute
+  )
+{
+  CPU_PAGE_TABLE        PageTable;
 
-  // 4k
-  L1PageTable = (UINT64 *)(UINTN)(L2PageTable[Index2] & ~AddressEncMask & PAGING_4K_ADDRESS_MASK_64);
-  if ((L1PageTable[Index1] == 0) && (Address != 0)) {
-    *PageAttribute = PageNone;
-    return NULL;
-  }
-  *PageAttribute = Page4K;
-  return &L1PageTable[Index1];
+  GetCpuPageTable (PagingContext, &PageTable);
+  return CpuPageTableGetEntry (&PageTable, Address, PageAttribute);
 }
 
 /**
@@ -380,43 +354,42 @@ GetAttributesFromPageEntry (
 }
 
 /**
-  Modify memory attributes of page entry.
+  Compute the bits of the page entries to set and to clear to modify their
+  memory attributes.
 
   @param[in]  PagingContext    The paging context.
-  @param[in]  PageEntry        The page entry.
   @param[in]  Attributes       The bit mask of attributes to modify for the memory region.
   @param[in]  PageAction       The page action.
-  @param[out] IsModified       TRUE means page table modified. FALSE means page table not modified.
+  @param[out] Change           The SetBits and ClearBits of the change are returned.
 **/
 VOID
-ConvertPageEntryAttribute (
+GetPageEntryChange (
   IN  PAGE_TABLE_LIB_PAGING_CONTEXT     *PagingContext,
-  IN  UINT64                            *PageEntry,
   IN  UINT64                            Attributes,
   IN  PAGE_ACTION                       PageAction,
-  OUT BOOLEAN                           *IsModified
+  OUT CPU_PAGE_TABLE_CHANGE             *Change
   )
 {
-  UINT64  CurrentPageEntry;
-  UINT64  NewPageEntry;
   UINT32  *PageAttributes;
+  UINT64  SetBits;
+  UINT64  ClearBits;
 
-  CurrentPageEntry = *PageEntry;
-  NewPageEntry = CurrentPageEntry;
+  SetBits   = 0;
+  ClearBits = 0;
   if ((Attributes & EFI_MEMORY_RP) != 0) {
     switch (PageAction) {
     case PageActionAssign:
     case PageActionSet:
-      NewPageEntry &= ~(UINT64)IA32_PG_P;
+      ClearBits |= IA32_PG_P;
       break;
     case PageActionClear:
-      NewPageEntry |= IA32_PG_P;
+      SetBits |= IA32_PG_P;
       break;
     }
   } else {
     switch (PageAction) {
     case PageActionAssign:
-      NewPageEntry |= IA32_PG_P;
+      SetBits |= IA32_PG_P;
       break;
     case PageActionSet:
     case PageActionClear:
@@ -427,16 +400,16 @@ ConvertPageEntryAttribute (
     switch (PageAction) {
     case PageActionAssign:
     case PageActionSet:
-      NewPageEntry &= ~(UINT64)IA32_PG_RW;
+      ClearBits |= IA32_PG_RW;
       break;
     case PageActionClear:
-      NewPageEntry |= IA32_PG_RW;
+      SetBits |= IA32_PG_RW;
       break;
     }
   } else {
     switch (PageAction) {
     case PageActionAssign:
-      NewPageEntry |= IA32_PG_RW;
+      SetBits |= IA32_PG_RW;
       break;
     case PageActionSet:
     case PageActionClear:
@@ -451,16 +424,16 @@ ConvertPageEntryAttribute (
       switch (PageAction) {
       case PageActionAssign:
       case PageActionSet:
-        NewPageEntry |= IA32_PG_NX;
+        SetBits |= IA32_PG_NX;
         break;
       case PageActionClear:
-        NewPageEntry &= ~IA32_PG_NX;
+        ClearBits |= IA32_PG_NX;
         break;
       }
     } else {
       switch (PageAction) {
       case PageActionAssign:
-        NewPageEntry &= ~IA32_PG_NX;
+        ClearBits |= IA32_PG_NX;
         break;
       case PageActionSet:
       case PageActionClear:
@@ -468,126 +441,8 @@ ConvertPageEntryAttribute (
       }
     }
   }
-  *PageEntry = NewPageEntry;
-  if (CurrentPageEntry != NewPageEntry) {
-    *IsModified = TRUE;
-    DEBUG ((DEBUG_VERBOSE, "ConvertPageEntryAttribute 0x%lx", CurrentPageEntry));
-    DEBUG ((DEBUG_VERBOSE, "->0x%lx\n", NewPageEntry));
-  } else {
-    *IsModified = FALSE;
-  }
-}
-
-/**
-  This function returns if there is need to split page entry.
-
-  @param[in]  BaseAddress      The base address to be checked.
-  @param[in]  Length           The length to be checked.
-  @param[in]  PageEntry        The page entry to be checked.
-  @param[in]  PageAttribute    The page attribute of the page entry.
-
-  @retval SplitAttributes on if there is need to split page entry.
-**/
-PAGE_ATTRIBUTE
-NeedSplitPage (
-  IN  PHYSICAL_ADDRESS                  BaseAddress,
-  IN  UINT64                            Length,
-  IN  UINT64                            *PageEntry,
-  IN  PAGE_ATTRIBUTE                    PageAttribute
-  )
-{
-  UINT64                PageEntryLength;
-
-  PageEntryLength = PageAttributeToLength (PageAttribute);
-
-  if (((BaseAddress & (PageEntryLength - 1)) == 0) && (Length >= PageEntryLength)) {
-    return PageNone;
-  }
-
-  if (((BaseAddress & PAGING_2M_MASK) != 0) || (Length < SIZE_2MB)) {
-    return Page4K;
-  }
-
-  return Page2M;
-}
-
-/**
-  This function splits one page entry to small page entries.
-
-  @param[in]  PageEntry         The page entry to be splitted.
-  @param[in]  PageAttribute     The page attribute of the page entry.
-  @param[in]  SplitAttribute    How to split the page entry.
-  @param[in]  AllocatePagesFunc If page split is needed, this function is used to allocate more pages.
-
-  @retval RETURN_SUCCESS            The page entry is splitted.
-  @retval RETURN_UNSUPPORTED        The page entry does not support to be splitted.
-  @retval RETURN_OUT_OF_RESOURCES   No resource to split page entry.
-**/
-RETURN_STATUS
-SplitPage (
-  IN  UINT64                            *PageEntry,
-  IN  PAGE_ATTRIBUTE                    PageAttribute,
-  IN  PAGE_ATTRIBUTE                    SplitAttribute,
-  IN  PAGE_TABLE_LIB_ALLOCATE_PAGES     AllocatePagesFunc
-  )
-{
-  UINT64   BaseAddress;
-  UINT64   *NewPageEntry;
-  UINTN    Index;
-  UINT64   AddressEncMask;
-
-  ASSERT (PageAttribute == Page2M || PageAttribute == Page1G);
-
-  ASSERT (AllocatePagesFunc != NULL);
-
-  // Make sure AddressEncMask is contained to smallest supported address field.
-  //
-  AddressEncMask = PcdGet64 (PcdPteMemoryEncryptionAddressOrMask) & PAGING_1G_ADDRESS_MASK_64;
-
-  if (PageAttribute == Page2M) {
-    //
-    // Split 2M to 4K
-    //
-    ASSERT (SplitAttribute == Page4K);
-    if (SplitAttribute == Page4K) {
-      NewPageEntry = AllocatePagesFunc (1);
-      DEBUG ((DEBUG_VERBOSE, "Split - 0x%x\n", NewPageEntry));
-      if (NewPageEntry == NULL) {
-        return RETURN_OUT_OF_RESOURCES;
-      }
-      BaseAddress = *PageEntry & ~AddressEncMask & PAGING_2M_ADDRESS_MASK_64;
-      for (Index = 0; Index < SIZE_4KB / sizeof(UINT64); Index++) {
-        NewPageEntry[Index] = (BaseAddress + SIZE_4KB * Index) | AddressEncMask | ((*PageEntry) & PAGE_PROGATE_BITS);
-      }
-      (*PageEntry) = (UINT64)(UINTN)NewPageEntry | AddressEncMask | ((*PageEntry) & PAGE_ATTRIBUTE_BITS);
-      return RETURN_SUCCESS;
-    } else {
-      return RETURN_UNSUPPORTED;
-    }
-  } else if (PageAttribute == Page1G) {
-    //
-    // Split 1G to 2M
-    // No need support 1G->4K directly, we should use 1G->2M, then 2M->4K to get more compact page table.
-    //
-    ASSERT (SplitAttribute == Page2M || SplitAttribute == Page4K);
-    if ((SplitAttribute == Page2M || SplitAttribute == Page4K)) {
-      NewPageEntry = AllocatePagesFunc (1);
-      DEBUG ((DEBUG_VERBOSE, "Split - 0x%x\n", NewPageEntry));
-      if (NewPageEntry == NULL) {
-        return RETURN_OUT_OF_RESOURCES;
-      }
-      BaseAddress = *PageEntry & ~AddressEncMask  & PAGING_1G_ADDRESS_MASK_64;
-      for (Index = 0; Index < SIZE_4KB / sizeof(UINT64); Index++) {
-        NewPageEntry[Index] = (BaseAddress + SIZE_2MB * Index) | AddressEncMask | IA32_PG_PS | ((*PageEntry) & PAGE_PROGATE_BITS);
-      }
-      (*PageEntry) = (UINT64)(UINTN)NewPageEntry | AddressEncMask | ((*PageEntry) & PAGE_ATTRIBUTE_BITS);
-      return RETURN_SUCCESS;
-    } else {
-      return RETURN_UNSUPPORTED;
-    }
-  } else {
-    return RETURN_UNSUPPORTED;
-  }
+  Change->SetBits   = SetBits;
+  Change->ClearBits = ClearBits;
 }
 
 /**
@@ -696,12 +551,10 @@ ConvertMemoryPageAttributes (
   )
 {
   PAGE_TABLE_LIB_PAGING_CONTEXT     CurrentPagingContext;
-  UINT64                            *PageEntry;
-  PAGE_ATTRIBUTE                    PageAttribute;
-  UINTN                             PageEntryLength;
-  PAGE_ATTRIBUTE                    SplitAttribute;
+  CPU_PAGE_TABLE                    PageTable;
+  CPU_PAGE_TABLE_CHANGE             Change;
+  CPU_PAGE_TABLE_FREE_PAGES         FreePagesFunc;
   RETURN_STATUS                     Status;
-  BOOLEAN                           IsEntryModified;
   BOOLEAN                           IsWpEnabled;
 
   if ((BaseAddress & (SIZE_4KB - 1)) != 0) {
@@ -757,16 +610,28 @@ ConvertMemoryPageAttributes (
 
 //  DEBUG ((DEBUG_ERROR, "ConvertMemoryPageAttributes(%x) - %016lx, %016lx, %02lx\n", IsSet, BaseAddress, Length, Attributes));
 
-  if (IsSplitted != NULL) {
-    *IsSplitted = FALSE;
-  }
-  if (IsModified != NULL) {
-    *IsModified = FALSE;
-  }
   if (AllocatePagesFunc == NULL) {
     AllocatePagesFunc = AllocatePageTableMemory;
   }
 
+  //
+  // Merge back the tables split by earlier changes only when updating the
+  // current page table from the outermost call with the default allocator.
+  // The released tables stay pending until ReleasePageTableMemory() has seen
+  // every processor flush its TLB. The page table pool marks itself read-only
+  // from a nested call, which must leave the tables it is splitting alone.
+  //
+  FreePagesFunc = NULL;
+  if ((PagingContext == NULL) && !mPageTablePoolLock &&
+      (AllocatePagesFunc == AllocatePageTableMemory)) {
+    FreePagesFunc = FreePageTableMemory;
+  }
+
+  GetCpuPageTable (&CurrentPagingContext, &PageTable);
+  GetPageEntryChange (&CurrentPagingContext, Attributes, PageAction, &Change);
+  Change.BaseAddress = BaseAddress;
+  Change.Length      = Length;
+
   //
   // Make sure that the page table is changeable.
   //
@@ -775,54 +640,19 @@ ConvertMemoryPageAttributes (
     DisableReadOnlyPageWriteProtect ();
   }
 
-  //
-  // Below logic is to check 2M/4K page to make sure we do not waste memory.
-  //
-  Status = EFI_SUCCESS;
-  while (Length != 0) {
-    PageEntry = GetPageTableEntry (&CurrentPagingContext, BaseAddress, &PageAttribute);
-    if (PageEntry == NULL) {
-      Status = RETURN_UNSUPPORTED;
-      goto Done;
-    }
-    PageEntryLength = PageAttributeToLength (PageAttribute);
-    SplitAttribute = NeedSplitPage (BaseAddress, Length, PageEntry, PageAttribute);
-    if (SplitAttribute == PageNone) {
-      ConvertPageEntryAttribute (&CurrentPagingContext, PageEntry, Attributes, PageAction, &IsEntryModified);
-      if (IsEntryModified) {
-        if (IsModified != NULL) {
-          *IsModified = TRUE;
-        }
-      }
-      //
-      // Convert success, move to next
-      //
-      BaseAddress += PageEntryLength;
-      Length -= PageEntryLength;
-    } else {
-      if (AllocatePagesFunc == NULL) {
-        Status = RETURN_UNSUPPORTED;
-        goto Done;
-      }
-      Status = SplitPage (PageEntry, PageAttribute, SplitAttribute, AllocatePagesFunc);
-      if (RETURN_ERROR (Status)) {
-        Status = RETURN_UNSUPPORTED;
-        goto Done;
-      }
-      if (IsSplitted != NULL) {
-        *IsSplitted = TRUE;
-      }
-      if (IsModified != NULL) {
-        *IsModified = TRUE;
-      }
-      //
-      // Just split current page
-      // Convert success in next around
-      //
-    }
+  Status = CpuPageTableUpdate (
+             &PageTable,
+             &Change,
+             1,
+             AllocatePagesFunc,
+             FreePagesFunc,
+             IsSplitted,
+             IsModified
+             );
+  if (RETURN_ERROR (Status)) {
+    Status = RETURN_UNSUPPORTED;
   }
 
-Done:
   //
   // Restore page table write protection, if any.
   //
@@ -875,6 +705,7 @@ AssignMemoryPageAttributes (
   BOOLEAN        IsSplitted;
 
 //  DEBUG((DEBUG_INFO, "AssignMemoryPageAttributes: 0x%lx - 0x%lx (0x%lx)\n", BaseAddress, Length, Attributes));
+  mPageTableUpdateDepth++;
   Status = ConvertMemoryPageAttributes (PagingContext, BaseAddress, Length, Attributes, PageActionAssign, AllocatePagesFunc, &IsSplitted, &IsModified);
   if (!EFI_ERROR(Status)) {
     if ((PagingContext == NULL) && IsModified) {
@@ -887,8 +718,13 @@ AssignMemoryPageAttributes (
       //
       CpuFlushTlb();
     }
+
+    if (PagingContext == NULL) {
+      ReleasePageTableMemory ();
+    }
   }
 
+  mPageTableUpdateDepth--;
   return Status;
 }
 
@@ -918,7 +754,7 @@ RefreshGcdMemoryAttributesFromPaging (
   UINTN                               NumberOfDescriptors;
   EFI_GCD_MEMORY_SPACE_DESCRIPTOR     *MemorySpaceMap;
   PAGE_TABLE_LIB_PAGING_CONTEXT       PagingContext;
-  PAGE_ATTRIBUTE                      PageAttribute;
+  CPU_PAGE_SIZE                       PageAttribute;
   UINT64                              *PageEntry;
   UINT64                              PageLength;
   UINT64                              MemorySpaceLength;
@@ -1067,8 +903,11 @@ InitializePageTablePool (
   IN  UINTN                           PoolPages
   )
 {
-  VOID                      *Buffer;
-  BOOLEAN                   IsModified;
+  VOID                           *Buffer;
+  BOOLEAN                        IsModified;
+  PAGE_TABLE_LIB_PAGING_CONTEXT  PagingContext;
+  CPU_PAGE_TABLE                 PageTable;
+  CPU_PAGE_TABLE_STATS           Stats;
 
   //
   // Do not allow re-entrance.
@@ -1099,6 +938,21 @@ InitializePageTablePool (
     (UINT64)PoolPages
     ));
 
+  DEBUG_CODE_BEGIN ();
+    GetCurrentPagingContext (&PagingContext);
+    GetCpuPageTable (&PagingContext, &PageTable);
+    CpuPageTableGetStats (&PageTable, &Stats);
+    DEBUG ((
+      DEBUG_INFO,
+      "Paging: %lu table pages, %lu 4K, %lu 2M, %lu 1G pages, %lu table pages free\r\n",
+      (UINT64)Stats.TablePages,
+      (UINT64)Stats.Pages4K,
+      (UINT64)Stats.Pages2M,
+      (UINT64)Stats.Pages1G,
+      (UINT64)mPageTableFreeListPages
+      ));
+  DEBUG_CODE_END ();
+
   //
   // Link all pools into a list for easier track later.
   //
@@ -1166,6 +1020,16 @@ AllocatePageTableMemory (
     return NULL;
   }
 
+  //
+  // Reuse the pages released by merging first.
+  //
+  if ((Pages == 1) && (mPageTableFreeList != NULL)) {
+    Buffer = mPageTableFreeList;
+    mPageTableFreeList = *(VOID **)Buffer;
+    mPageTableFreeListPages--;
+    return Buffer;
+  }
+
   //
   // Renew the pool if necessary.
   //
@@ -1184,6 +1048,149 @@ AllocatePageTableMemory (
   return Buffer;
 }
 
+/**
+  This API provides a way to free memory allocated for page table.
+
+  The pages are kept in the page table pool. Since the processors may still
+  cache them, they are neither written nor reused by AllocatePageTableMemory()
+  before ReleasePageTableMemory() has flushed the TLB of all processors. Pages
+  which don't fit in the pending list are never reused.
+
+  @param  Buffer                The pages to free.
+  @param  Pages                 The number of 4 KB pages to free.
+
+**/
+VOID
+EFIAPI
+FreePageTableMemory (
+  IN VOID            *Buffer,
+  IN UINTN           Pages
+  )
+{
+  UINT8                           *Page;
+
+  for (Page = Buffer; Pages > 0; Page += EFI_PAGE_SIZE, Pages--) {
+    if (mPageTablePendingFreePages == MAX_PENDING_FREE_PAGES) {
+      break;
+    }
+    mPageTablePendingFree[mPageTablePendingFreePages++] = Page;
+  }
+}
+
+/**
+  Flush the TLB of the AP running it.
+
+  @param[in] Buffer  Not used.
+**/
+VOID
+EFIAPI
+FlushTlbOnAp (
+  IN VOID            *Buffer
+  )
+{
+  CpuFlushTlb ();
+}
+
+/**
+  Make the page table pages released by merging available to
+  AllocatePageTableMemory().
+
+  The caller must have flushed the TLB of the BSP. The APs are made to flush
+  theirs, and the pages stay pending if that is not possible at the moment,
+  e.g. because the APs are busy. The MP services may only be used at
+  TPL_APPLICATION and not from within another call to them, so the pages
+  also stay pending when the caller runs at a higher TPL or inside another
+  page table update.
+
+**/
+VOID
+ReleasePageTableMemory (
+  VOID
+  )
+{
+  EFI_STATUS                Status;
+  EFI_MP_SERVICES_PROTOCOL  *MpService;
+  UINTN                     Pages;
+  UINTN                     Index;
+  BOOLEAN                   IsWpEnabled;
+  EFI_TPL                   OldTpl;
+
+  //
+  // Allocations made while syncing the APs may change the page table again,
+  // and release more pages which the APs have not flushed yet.
+  //
+  if ((mPageTablePendingFreePages == 0) || mPageTableReleasing ||
+      (mPageTableUpdateDepth > 1)) {
+    return;
+  }
+
+  OldTpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+  gBS->RestoreTPL (OldTpl);
+  if (OldTpl > TPL_APPLICATION) {
+    return;
+  }
+
+  mPageTableReleasing = TRUE;
+  Pages = mPageTablePendingFreePages;
+
+  //
+  // No AP runs code of the DXE phase before the MP services are installed.
+  //
+  Status = gBS->LocateProtocol (
+                  &gEfiMpServiceProtocolGuid,
+                  NULL,
+                  (VOID **)&MpService
+                  );
+  if (!EFI_ERROR (Status)) {
+    Status = MpService->StartupAllAPs (
+                          MpService,          // This
+                          FlushTlbOnAp,       // Procedure
+                          FALSE,              // SingleThread
+                          NULL,               // WaitEvent
+                          0,                  // TimeoutInMicrosecsond
+                          NULL,               // ProcedureArgument
+                          NULL                // FailedCpuList
+                          );
+    if (Status == EFI_NOT_STARTED) {
+      //
+      // There is no enabled AP.
+      //
+      Status = EFI_SUCCESS;
+    }
+  } else {
+    Status = EFI_SUCCESS;
+  }
+
+  if (!EFI_ERROR (Status)) {
+    //
+    // The free list is linked through the pages, which are read-only.
+    //
+    IsWpEnabled = IsReadOnlyPageWriteProtected ();
+    if (IsWpEnabled) {
+      DisableReadOnlyPageWriteProtect ();
+    }
+
+    for (Index = 0; Index < Pages; Index++) {
+      *(VOID **)mPageTablePendingFree[Index] = mPageTableFreeList;
+      mPageTableFreeList = mPageTablePendingFree[Index];
+      mPageTableFreeListPages++;
+    }
+
+    if (IsWpEnabled) {
+      EnableReadOnlyPageWriteProtect ();
+    }
+
+    mPageTablePendingFreePages -= Pages;
+    CopyMem (
+      mPageTablePendingFree,
+      &mPageTablePendingFree[Pages],
+      mPageTablePendingFreePages * sizeof (mPageTablePendingFree[0])
+      );
+  }
+
+  mPageTableReleasing = FALSE;
+}
+
 /**
   Special handler for #DB exception, which will restore the page attributes
   (not-present). It should work with #PF handler which will set pages to
@@ -1263,7 +1270,7 @@ PageFaultExceptionHandler (
   EFI_STATUS                      Status;
   UINT64                          PFAddress;
   PAGE_TABLE_LIB_PAGING_CONTEXT   PagingContext;
-  PAGE_ATTRIBUTE                  PageAttribute;
+  CPU_PAGE_SIZE                   PageAttribute;
   UINT64                          Attributes;
   UINT64                          *PageEntry;
   UINTN                           Index;
@@ -139,6 +139,40 @@ AllocatePageTableMemory (
   IN UINTN           Pages
   );
 
+/**
+  This API provides a way to free memory allocated for page table.
+
+  The pages are kept in the page table pool. Since the processors may still
+  cache them, they are neither written nor reused by AllocatePageTableMemory()
+  before ReleasePageTableMemory() has flushed the TLB of all processors. Pages
+  which don't fit in the pending list are never reused.
+
+  @param  Buffer                The pages to free.
+  @param  Pages                 The number of 4 KB pages to free.
+
+**/
+VOID
+EFIAPI
+FreePageTableMemory (
+  IN VOID            *Buffer,
+  IN UINTN           Pages
+  );
+
+/**
+  Make the page table pages released by merging available to
+  AllocatePageTableMemory().
+
+  The caller must have flushed the TLB of the BSP. The APs are made to flush
+  theirs, and the pages stay pending if that is not possible at the moment,
+  e.g. because the APs are busy, the caller runs above TPL_APPLICATION, or
+  the call is nested in another page table update.
+
+**/
+VOID
+ReleasePageTableMemory (
+  VOID
+  );
+
 /**
   Get paging details.
 
@@ -0,0 +1,232 @@
+/** @file
+  Library to walk, split, update and re-merge IA32 PAE and X64 page tables.
+
+  Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _CPU_PAGE_TABLE_LIB_H_
+#define _CPU_PAGE_TABLE_LIB_H_
+
+typedef enum {
+  CpuPageNone,
+  CpuPage4K,
+  CpuPage2M,
+  CpuPage1G
+} CPU_PAGE_SIZE;
+
+//
+// Describes the page table to operate on.
+//
+typedef struct {
+  //
+  // Address of the top level table: the PML5 or PML4 table in X64 mode,
+  // the page directory pointer table in IA32 PAE mode.
+  //
+  UINT64   PageTableBase;
+  //
+  // Number of paging levels: 3 for IA32 PAE, 4 or 5 for X64.
+  //
+  UINT32   Levels;
+  //
+  // TRUE if 1GB pages may be created.
+  //
+  BOOLEAN  Page1GSupport;
+  //
+  // Memory encryption mask that is part of the address field of all entries.
+  //
+  UINT64   AddressEncMask;
+} CPU_PAGE_TABLE;
+
+//
+// One change of a batch passed to CpuPageTableUpdate(). The bits of the leaf
+// entries mapping the range that are in ClearBits are cleared first, then
+// the bits in SetBits are set. Neither may contain address, PS or PAT bits.
+//
+typedef struct {
+  PHYSICAL_ADDRESS  BaseAddress;
+  UINT64            Length;
+  UINT64            SetBits;
+  UINT64            ClearBits;
+} CPU_PAGE_TABLE_CHANGE;
+
+//
+// Shape of a page table, as returned by CpuPageTableGetStats().
+//
+typedef struct {
+  //
+  // 4KB pages holding the page table, including the top level table.
+  //
+  UINTN  TablePages;
+  //
+  // Leaf entries of each size.
+  //
+  UINTN  Pages4K;
+  UINTN  Pages2M;
+  UINTN  Pages1G;
+  //
+  // Tables whose entries map a contiguous range with uniform attributes,
+  // which CpuPageTableMerge() would replace with one larger page.
+  //
+  UINTN  MergeableTables;
+} CPU_PAGE_TABLE_STATS;
+
+/**
+  Allocates one or more 4KB pages for page table.
+
+  @param  Pages                 The number of 4 KB pages to allocate.
+
+  @return A pointer to the allocated buffer or NULL if allocation fails.
+
+**/
+typedef
+VOID *
+(EFIAPI *CPU_PAGE_TABLE_ALLOCATE_PAGES) (
+  IN UINTN  Pages
+  );
+
+/**
+  Frees one or more 4KB pages that were used for page table.
+
+  @param  Buffer                The pages to free.
+  @param  Pages                 The number of 4 KB pages to free.
+
+**/
+typedef
+VOID
+(EFIAPI *CPU_PAGE_TABLE_FREE_PAGES) (
+  IN VOID   *Buffer,
+  IN UINTN  Pages
+  );
+
+/**
+  Return the leaf entry that maps an address.
+
+  @param[in]  PageTable     The page table.
+  @param[in]  Address       The address to look up.
+  @param[out] PageSize      The size of the page mapped by the entry, or
+                            CpuPageNone if the address is not mapped.
+
+  @return The leaf entry, or NULL if the address is not mapped.
+
+**/
+UINT64 *
+EFIAPI
+CpuPageTableGetEntry (
+  IN  CONST CPU_PAGE_TABLE  *PageTable,
+  IN  PHYSICAL_ADDRESS      Address,
+  OUT CPU_PAGE_SIZE         *PageSize
+  );
+
+/**
+  Split a 2MB page into 4KB pages, or a 1GB page into 2MB pages.
+
+  The new entries keep all the attributes of the split entry, so the split
+  does not change the mapping.
+
+  @param[in]      PageTable     The page table.
+  @param[in, out] PageEntry     The leaf entry to split.
+  @param[in]      PageSize      The size of the page mapped by PageEntry.
+  @param[in]      AllocatePages Function used to allocate the new table.
+
+  @retval RETURN_SUCCESS            The page entry is split.
+  @retval RETURN_UNSUPPORTED        The page entry cannot be split.
+  @retval RETURN_OUT_OF_RESOURCES   No resource to split the page entry.
+
+**/
+RETURN_STATUS
+EFIAPI
+CpuPageTableSplitEntry (
+  IN     CONST CPU_PAGE_TABLE           *PageTable,
+  IN OUT UINT64                         *PageEntry,
+  IN     CPU_PAGE_SIZE                  PageSize,
+  IN     CPU_PAGE_TABLE_ALLOCATE_PAGES  AllocatePages
+  );
+
+/**
+  Apply a batch of attribute changes to a page table.
+
+  Large pages that are only partially covered by a change are split. Once all
+  the changes are applied, and if FreePages is not NULL, the tables covering
+  the changed ranges whose entries have become uniform are merged back into
+  large pages, see CpuPageTableMerge().
+
+  The caller is responsible for making the page table writable and for
+  flushing the TLB if IsModified returns TRUE.
+
+  @param[in]  PageTable     The page table.
+  @param[in]  Changes       The changes to apply, in order.
+  @param[in]  ChangeCount   The number of entries in Changes.
+  @param[in]  AllocatePages Function used to allocate tables when splitting
+                            large pages. NULL means splitting is unsupported.
+  @param[in]  FreePages     Function used to free the tables released by
+                            merging. NULL means no merging is done.
+  @param[out] IsSplitted    TRUE means page table splitted.
+  @param[out] IsModified    TRUE means page table modified.
+
+  @retval RETURN_SUCCESS           All the changes were applied.
+  @retval RETURN_INVALID_PARAMETER A change has a zero length.
+  @retval RETURN_UNSUPPORTED       A change is not 4KB aligned, or covers an
+                                   address that is not mapped, or a page
+                                   needs splitting and AllocatePages is NULL.
+  @retval RETURN_OUT_OF_RESOURCES  A table could not be allocated. The changes
+                                   before the failing one were applied.
+
+**/
+RETURN_STATUS
+EFIAPI
+CpuPageTableUpdate (
+  IN  CONST CPU_PAGE_TABLE                *PageTable,
+  IN  CONST CPU_PAGE_TABLE_CHANGE         *Changes,
+  IN  UINTN                               ChangeCount,
+  IN  CPU_PAGE_TABLE_ALLOCATE_PAGES       AllocatePages OPTIONAL,
+  IN  CPU_PAGE_TABLE_FREE_PAGES           FreePages     OPTIONAL,
+  OUT BOOLEAN                             *IsSplitted   OPTIONAL,
+  OUT BOOLEAN                             *IsModified   OPTIONAL
+  );
+
+/**
+  Replace the tables covering a range that map a contiguous range with
+  uniform attributes by 2MB pages, and 1GB pages if supported.
+
+  The accessed bit of the entries is ignored, and so is the dirty bit of
+  writable entries. The restrictions of the replaced non-leaf entry (not
+  writable, supervisor only, no execute) are folded into the new leaf.
+
+  The caller is responsible for making the page table writable and for
+  flushing the TLB if tables were released.
+
+  @param[in]  PageTable     The page table.
+  @param[in]  BaseAddress   The start of the range.
+  @param[in]  Length        The length of the range.
+  @param[in]  FreePages     Function used to free the released tables. NULL
+                            means they are left allocated.
+
+  @return The number of tables released.
+
+**/
+UINTN
+EFIAPI
+CpuPageTableMerge (
+  IN  CONST CPU_PAGE_TABLE                *PageTable,
+  IN  PHYSICAL_ADDRESS                    BaseAddress,
+  IN  UINT64                              Length,
+  IN  CPU_PAGE_TABLE_FREE_PAGES           FreePages OPTIONAL
+  );
+
+/**
+  Count the tables and the leaf entries of each size of a page table.
+
+  @param[in]  PageTable     The page table.
+  @param[out] Stats         The statistics.
+
+**/
+VOID
+EFIAPI
+CpuPageTableGetStats (
+  IN  CONST CPU_PAGE_TABLE                *PageTable,
+  OUT CPU_PAGE_TABLE_STATS                *Stats
+  );
+
+#endif
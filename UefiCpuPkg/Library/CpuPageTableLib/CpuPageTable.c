@@ -0,0 +1,695 @@
+/** @file
+  Walk, split, update and re-merge IA32 PAE and X64 page tables.
+
+  Memory protection changes the attributes of many small ranges: the code and
+  data sections of every image, the guard pages of every heap allocation. Each
+  change splits the large pages it only partially covers, and nothing merged
+  them back, so the page tables kept growing and most of the memory ended up
+  mapped with 4KB pages. CpuPageTableMerge() replaces tables whose entries
+  have become uniform again by a single large page.
+
+  Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Base.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/CpuPageTableLib.h>
+
+#define IA32_PG_P                   BIT0
+#define IA32_PG_RW                  BIT1
+#define IA32_PG_U                   BIT2
+#define IA32_PG_A                   BIT5
+#define IA32_PG_D                   BIT6
+#define IA32_PG_PS                  BIT7
+#define IA32_PG_PAT_4K              BIT7
+#define IA32_PG_PAT_2M              BIT12
+#define IA32_PG_NX                  BIT63
+
+//
+// Attributes of the non-leaf entries created by splitting: all the
+// restrictions are carried by the leaf entries.
+//
+#define PAGE_TABLE_NON_LEAF_BITS    (IA32_PG_D | IA32_PG_A | IA32_PG_U | IA32_PG_RW | IA32_PG_P)
+
+#define PAGING_4K_ADDRESS_MASK_64   0x000FFFFFFFFFF000ull
+#define PAGING_2M_ADDRESS_MASK_64   0x000FFFFFFFE00000ull
+#define PAGING_1G_ADDRESS_MASK_64   0x000FFFFFC0000000ull
+
+#define PAGING_PAE_INDEX_MASK       0x1FF
+#define PAGING_ENTRIES_PER_TABLE    512
+#define PAGING_PAE_PDPT_ENTRIES     4
+
+/**
+  Return the number of entries of a table.
+
+  @param[in]  PageTable     The page table.
+  @param[in]  Level         The level of the table, 1 for the page tables.
+
+  @return The number of entries.
+**/
+STATIC
+UINTN
+GetEntryCount (
+  IN  CONST CPU_PAGE_TABLE  *PageTable,
+  IN  UINT32                Level
+  )
+{
+  if ((Level == PageTable->Levels) && (Level == 3)) {
+    return PAGING_PAE_PDPT_ENTRIES;
+  }
+  return PAGING_ENTRIES_PER_TABLE;
+}
+
+/**
+  Return the size of the range mapped by one entry of a table.
+
+  @param[in]  Level         The level of the table, 1 for the page tables.
+
+  @return The size in bytes.
+**/
+STATIC
+UINT64
+GetEntrySize (
+  IN  UINT32                Level
+  )
+{
+  return LShiftU64 (SIZE_4KB, 9 * (Level - 1));
+}
+
+/**
+  Check whether an entry maps a page rather than pointing to a table.
+
+  @param[in]  Entry         The entry.
+  @param[in]  Level         The level of the table holding the entry.
+
+  @retval TRUE   The entry is a leaf entry.
+  @retval FALSE  The entry points to a table.
+**/
+STATIC
+BOOLEAN
+IsLeafEntry (
+  IN  UINT64                Entry,
+  IN  UINT32                Level
+  )
+{
+  return (BOOLEAN)((Level == 1) || ((Level <= 3) && ((Entry & IA32_PG_PS) != 0)));
+}
+
+/**
+  Return the table a non-leaf entry points to.
+
+  @param[in]  PageTable     The page table.
+  @param[in]  Entry         The non-leaf entry.
+
+  @return The table.
+**/
+STATIC
+UINT64 *
+GetChildTable (
+  IN  CONST CPU_PAGE_TABLE  *PageTable,
+  IN  UINT64                Entry
+  )
+{
+  return (UINT64 *)(UINTN)(Entry & ~PageTable->AddressEncMask & PAGING_4K_ADDRESS_MASK_64);
+}
+
+/**
+  Return the leaf entry that maps an address.
+
+  @param[in]  PageTable     The page table.
+  @param[in]  Address       The address to look up.
+  @param[out] PageSize      The size of the page mapped by the entry, or
+                            CpuPageNone if the address is not mapped.
+
+  @return The leaf entry, or NULL if the address is not mapped.
+
+**/
+UINT64 *
+EFIAPI
+CpuPageTableGetEntry (
+  IN  CONST CPU_PAGE_TABLE  *PageTable,
+  IN  PHYSICAL_ADDRESS      Address,
+  OUT CPU_PAGE_SIZE         *PageSize
+  )
+{
+  UINT64                    *Table;
+  UINT64                    *Entry;
+  UINT32                    Level;
+  UINTN                     Index;
+
+  ASSERT (PageTable != NULL);
+  ASSERT (PageTable->Levels >= 3 && PageTable->Levels <= 5);
+
+  *PageSize = CpuPageNone;
+  Table     = (UINT64 *)(UINTN)PageTable->PageTableBase;
+  for (Level = PageTable->Levels; Level > 0; Level--) {
+    Index = (UINTN)RShiftU64 (Address, 12 + 9 * (Level - 1)) & PAGING_PAE_INDEX_MASK;
+    if (Index >= GetEntryCount (PageTable, Level)) {
+      return NULL;
+    }
+    Entry = &Table[Index];
+    //
+    // The entry mapping page 0 may be all zero, for NULL pointer detection.
+    //
+    if ((*Entry == 0) && ((Level != 1) || (Address >= SIZE_4KB))) {
+      return NULL;
+    }
+    if (IsLeafEntry (*Entry, Level)) {
+      *PageSize = (Level == 1) ? CpuPage4K : ((Level == 2) ? CpuPage2M : CpuPage1G);
+      return Entry;
+    }
+    Table = GetChildTable (PageTable, *Entry);
+  }
+
+  return NULL;
+}
+
+/**
+  Split a 2MB page into 4KB pages, or a 1GB page into 2MB pages.
+
+  The new entries keep all the attributes of the split entry, so the split
+  does not change the mapping.
+
+  @param[in]      PageTable     The page table.
+  @param[in, out] PageEntry     The leaf entry to split.
+  @param[in]      PageSize      The size of the page mapped by PageEntry.
+  @param[in]      AllocatePages Function used to allocate the new table.
+
+  @retval RETURN_SUCCESS            The page entry is split.
+  @retval RETURN_UNSUPPORTED        The page entry cannot be split.
+  @retval RETURN_OUT_OF_RESOURCES   No resource to split the page entry.
+
+**/
+RETURN_STATUS
+EFIAPI
+CpuPageTableSplitEntry (
+  IN     CONST CPU_PAGE_TABLE           *PageTable,
+  IN OUT UINT64                         *PageEntry,
+  IN     CPU_PAGE_SIZE                  PageSize,
+  IN     CPU_PAGE_TABLE_ALLOCATE_PAGES  AllocatePages
+  )
+{
+  UINT64                    *NewTable;
+  UINT64                    AddressMask;
+  UINT64                    BaseAddress;
+  UINT64                    Attributes;
+  UINT64                    ChildSize;
+  UINTN                     Index;
+
+  ASSERT (AllocatePages != NULL);
+
+  if (PageSize == CpuPage2M) {
+    AddressMask = PAGING_2M_ADDRESS_MASK_64 & ~PageTable->AddressEncMask;
+    ChildSize   = SIZE_4KB;
+  } else if (PageSize == CpuPage1G) {
+    AddressMask = PAGING_1G_ADDRESS_MASK_64 & ~PageTable->AddressEncMask;
+    ChildSize   = SIZE_2MB;
+  } else {
+    return RETURN_UNSUPPORTED;
+  }
+
+  NewTable = AllocatePages (1);
+  DEBUG ((DEBUG_VERBOSE, "Split - %p\n", NewTable));
+  if (NewTable == NULL) {
+    return RETURN_OUT_OF_RESOURCES;
+  }
+
+  BaseAddress = *PageEntry & AddressMask;
+  Attributes  = *PageEntry & ~AddressMask;
+  if (PageSize == CpuPage2M) {
+    //
+    // The PAT bit of 4KB entries is where the PS bit of 2MB entries is.
+    //
+    Attributes &= ~(UINT64)(IA32_PG_PS | IA32_PG_PAT_2M);
+    if ((*PageEntry & IA32_PG_PAT_2M) != 0) {
+      Attributes |= IA32_PG_PAT_4K;
+    }
+  }
+
+  for (Index = 0; Index < PAGING_ENTRIES_PER_TABLE; Index++) {
+    NewTable[Index] = (BaseAddress + ChildSize * Index) | Attributes;
+  }
+  *PageEntry = (UINT64)(UINTN)NewTable | PageTable->AddressEncMask | PAGE_TABLE_NON_LEAF_BITS;
+
+  return RETURN_SUCCESS;
+}
+
+/**
+  Return the attributes of a leaf entry that must be equal in all the entries
+  of a table for them to be merged.
+
+  @param[in]  Entry         The leaf entry.
+  @param[in]  AddressMask   The address bits of the entry.
+
+  @return The attributes to compare.
+**/
+STATIC
+UINT64
+GetMergeAttributes (
+  IN  UINT64                Entry,
+  IN  UINT64                AddressMask
+  )
+{
+  UINT64                    Ignored;
+
+  //
+  // The processor sets the accessed bit, and the dirty bit of writable pages,
+  // so they carry no attribute. The dirty bit of read-only pages does: it
+  // marks shadow stack pages.
+  //
+  Ignored = IA32_PG_A;
+  if ((Entry & IA32_PG_RW) != 0) {
+    Ignored |= IA32_PG_D;
+  }
+  return Entry & ~AddressMask & ~Ignored;
+}
+
+/**
+  Compute the large page that can replace a table.
+
+  @param[in]  PageTable     The page table.
+  @param[in]  ParentEntry   The non-leaf entry pointing to the table.
+  @param[in]  Table         The table.
+  @param[in]  Level         The level of the table, 1 or 2.
+  @param[out] LeafEntry     The leaf entry to replace ParentEntry with.
+
+  @retval TRUE   The entries of the table map a contiguous range with uniform
+                 attributes; LeafEntry is returned.
+  @retval FALSE  The table cannot be merged.
+**/
+STATIC
+BOOLEAN
+GetMergedEntry (
+  IN  CONST CPU_PAGE_TABLE  *PageTable,
+  IN  UINT64                ParentEntry,
+  IN  CONST UINT64          *Table,
+  IN  UINT32                Level,
+  OUT UINT64                *LeafEntry
+  )
+{
+  UINT64                    AddressMask;
+  UINT64                    BaseAddress;
+  UINT64                    Attributes;
+  UINT64                    ChildSize;
+  UINTN                     Index;
+
+  if (Level == 1) {
+    AddressMask = PAGING_4K_ADDRESS_MASK_64 & ~PageTable->AddressEncMask;
+  } else {
+    AddressMask = PAGING_2M_ADDRESS_MASK_64 & ~PageTable->AddressEncMask;
+    if ((Table[0] & IA32_PG_PS) == 0) {
+      return FALSE;
+    }
+  }
+  ChildSize   = GetEntrySize (Level);
+  BaseAddress = Table[0] & AddressMask;
+  if ((BaseAddress & (ChildSize * PAGING_ENTRIES_PER_TABLE - 1)) != 0) {
+    return FALSE;
+  }
+
+  Attributes = GetMergeAttributes (Table[0], AddressMask);
+  for (Index = 1; Index < PAGING_ENTRIES_PER_TABLE; Index++) {
+    if (((Table[Index] & AddressMask) != BaseAddress + ChildSize * Index) ||
+        (GetMergeAttributes (Table[Index], AddressMask) != Attributes)) {
+      return FALSE;
+    }
+  }
+
+  Attributes = Table[0] & ~AddressMask;
+  if (Level == 1) {
+    Attributes &= ~(UINT64)IA32_PG_PAT_4K;
+    if ((Table[0] & IA32_PG_PAT_4K) != 0) {
+      Attributes |= IA32_PG_PAT_2M;
+    }
+    Attributes |= IA32_PG_PS;
+  }
+
+  //
+  // Keep the restrictions of the non-leaf entry that is replaced.
+  //
+  if ((ParentEntry & IA32_PG_RW) == 0) {
+    Attributes &= ~(UINT64)IA32_PG_RW;
+  }
+  if ((ParentEntry & IA32_PG_U) == 0) {
+    Attributes &= ~(UINT64)IA32_PG_U;
+  }
+  if ((ParentEntry & IA32_PG_NX) != 0) {
+    Attributes |= IA32_PG_NX;
+  }
+
+  *LeafEntry = BaseAddress | Attributes;
+  return TRUE;
+}
+
+/**
+  Check whether the tables pointed to by the entries of a level may be
+  replaced by large pages.
+
+  @param[in]  PageTable     The page table.
+  @param[in]  Level         The level of the table holding the entries.
+
+  @retval TRUE   The tables may be merged.
+  @retval FALSE  No larger page is available.
+**/
+STATIC
+BOOLEAN
+IsMergeableLevel (
+  IN  CONST CPU_PAGE_TABLE  *PageTable,
+  IN  UINT32                Level
+  )
+{
+  return (BOOLEAN)((Level == 2) ||
+                   ((Level == 3) && PageTable->Page1GSupport && (PageTable->Levels > 3)));
+}
+
+/**
+  Merge the tables below a table that cover a range, bottom up.
+
+  @param[in]  PageTable     The page table.
+  @param[in]  Table         The table.
+  @param[in]  Level         The level of the table.
+  @param[in]  TableBase     The address of the range mapped by the table.
+  @param[in]  Start         The start of the range to merge.
+  @param[in]  End           The end of the range to merge, exclusive.
+  @param[in]  FreePages     Function used to free the released tables.
+
+  @return The number of tables released.
+**/
+STATIC
+UINTN
+MergeTable (
+  IN  CONST CPU_PAGE_TABLE                *PageTable,
+  IN  UINT64                              *Table,
+  IN  UINT32                              Level,
+  IN  UINT64                              TableBase,
+  IN  UINT64                              Start,
+  IN  UINT64                              End,
+  IN  CPU_PAGE_TABLE_FREE_PAGES           FreePages OPTIONAL
+  )
+{
+  UINT64                    *ChildTable;
+  UINT64                    EntrySize;
+  UINT64                    EntryBase;
+  UINT64                    LeafEntry;
+  UINTN                     Count;
+  UINTN                     Index;
+  UINTN                     Released;
+
+  if (Level == 1) {
+    return 0;
+  }
+
+  Released  = 0;
+  EntrySize = GetEntrySize (Level);
+  Count     = GetEntryCount (PageTable, Level);
+  for (Index = 0; Index < Count; Index++) {
+    EntryBase = TableBase + EntrySize * Index;
+    if (EntryBase >= End) {
+      break;
+    }
+    if ((EntryBase + EntrySize <= Start) ||
+        ((Table[Index] & IA32_PG_P) == 0) ||
+        IsLeafEntry (Table[Index], Level)) {
+      continue;
+    }
+
+    ChildTable = GetChildTable (PageTable, Table[Index]);
+    Released  += MergeTable (PageTable, ChildTable, Level - 1, EntryBase, Start, End, FreePages);
+
+    if (IsMergeableLevel (PageTable, Level) &&
+        GetMergedEntry (PageTable, Table[Index], ChildTable, Level - 1, &LeafEntry)) {
+      Table[Index] = LeafEntry;
+      if (FreePages != NULL) {
+        FreePages (ChildTable, 1);
+      }
+      Released++;
+    }
+  }
+
+  return Released;
+}
+
+/**
+  Replace the tables covering a range that map a contiguous range with
+  uniform attributes by 2MB pages, and 1GB pages if supported.
+
+  The accessed bit of the entries is ignored, and so is the dirty bit of
+  writable entries. The restrictions of the replaced non-leaf entry (not
+  writable, supervisor only, no execute) are folded into the new leaf.
+
+  The caller is responsible for making the page table writable and for
+  flushing the TLB if tables were released.
+
+  @param[in]  PageTable     The page table.
+  @param[in]  BaseAddress   The start of the range.
+  @param[in]  Length        The length of the range.
+  @param[in]  FreePages     Function used to free the released tables. NULL
+                            means they are left allocated.
+
+  @return The number of tables released.
+
+**/
+UINTN
+EFIAPI
+CpuPageTableMerge (
+  IN  CONST CPU_PAGE_TABLE                *PageTable,
+  IN  PHYSICAL_ADDRESS                    BaseAddress,
+  IN  UINT64                              Length,
+  IN  CPU_PAGE_TABLE_FREE_PAGES           FreePages OPTIONAL
+  )
+{
+  UINT64                    End;
+
+  ASSERT (PageTable != NULL);
+  ASSERT (PageTable->Levels >= 3 && PageTable->Levels <= 5);
+
+  if (Length == 0) {
+    return 0;
+  }
+  End = BaseAddress + Length;
+  if (End < BaseAddress) {
+    End = MAX_UINT64;
+  }
+
+  return MergeTable (
+           PageTable,
+           (UINT64 *)(UINTN)PageTable->PageTableBase,
+           PageTable->Levels,
+           0,
+           BaseAddress,
+           End,
+           FreePages
+           );
+}
+
+/**
+  Apply a batch of attribute changes to a page table.
+
+  Large pages that are only partially covered by a change are split. Once all
+  the changes are applied, and if FreePages is not NULL, the tables covering
+  the changed ranges whose entries have become uniform are merged back into
+  large pages, see CpuPageTableMerge().
+
+  The caller is responsible for making the page table writable and for
+  flushing the TLB if IsModified returns TRUE.
+
+  @param[in]  PageTable     The page table.
+  @param[in]  Changes       The changes to apply, in order.
+  @param[in]  ChangeCount   The number of entries in Changes.
+  @param[in]  AllocatePages Function used to allocate tables when splitting
+                            large pages. NULL means splitting is unsupported.
+  @param[in]  FreePages     Function used to free the tables released by
+                            merging. NULL means no merging is done.
+  @param[out] IsSplitted    TRUE means page table splitted.
+  @param[out] IsModified    TRUE means page table modified.
+
+  @retval RETURN_SUCCESS           All the changes were applied.
+  @retval RETURN_INVALID_PARAMETER A change has a zero length.
+  @retval RETURN_UNSUPPORTED       A change is not 4KB aligned, or covers an
+                                   address that is not mapped, or a page
+                                   needs splitting and AllocatePages is NULL.
+  @retval RETURN_OUT_OF_RESOURCES  A table could not be allocated. The changes
+                                   before the failing one were applied.
+
+**/
+RETURN_STATUS
+EFIAPI
+CpuPageTableUpdate (
+  IN  CONST CPU_PAGE_TABLE                *PageTable,
+  IN  CONST CPU_PAGE_TABLE_CHANGE         *Changes,
+  IN  UINTN                               ChangeCount,
+  IN  CPU_PAGE_TABLE_ALLOCATE_PAGES       AllocatePages OPTIONAL,
+  IN  CPU_PAGE_TABLE_FREE_PAGES           FreePages     OPTIONAL,
+  OUT BOOLEAN                             *IsSplitted   OPTIONAL,
+  OUT BOOLEAN                             *IsModified   OPTIONAL
+  )
+{
+  RETURN_STATUS             Status;
+  UINT64                    *PageEntry;
+  UINT64                    NewPageEntry;
+  CPU_PAGE_SIZE             PageSize;
+  UINT64                    PageLength;
+  PHYSICAL_ADDRESS          BaseAddress;
+  UINT64                    Length;
+  UINTN                     Index;
+  BOOLEAN                   Splitted;
+  BOOLEAN                   Modified;
+
+  ASSERT (PageTable != NULL);
+  ASSERT (Changes != NULL || ChangeCount == 0);
+
+  Status   = RETURN_SUCCESS;
+  Splitted = FALSE;
+  Modified = FALSE;
+
+  for (Index = 0; Index < ChangeCount; Index++) {
+    ASSERT (((Changes[Index].SetBits | Changes[Index].ClearBits) &
+             (PAGING_4K_ADDRESS_MASK_64 | IA32_PG_PS)) == 0);
+
+    BaseAddress = Changes[Index].BaseAddress;
+    Length      = Changes[Index].Length;
+    if (Length == 0) {
+      Status = RETURN_INVALID_PARAMETER;
+      break;
+    }
+    if (((BaseAddress & (SIZE_4KB - 1)) != 0) || ((Length & (SIZE_4KB - 1)) != 0)) {
+      Status = RETURN_UNSUPPORTED;
+      break;
+    }
+
+    while (Length != 0) {
+      PageEntry = CpuPageTableGetEntry (PageTable, BaseAddress, &PageSize);
+      if (PageEntry == NULL) {
+        Status = RETURN_UNSUPPORTED;
+        break;
+      }
+      PageLength = (PageSize == CpuPage4K) ? SIZE_4KB : ((PageSize == CpuPage2M) ? SIZE_2MB : SIZE_1GB);
+
+      if (((BaseAddress & (PageLength - 1)) == 0) && (Length >= PageLength)) {
+        NewPageEntry = (*PageEntry & ~Changes[Index].ClearBits) | Changes[Index].SetBits;
+        if (NewPageEntry != *PageEntry) {
+          DEBUG ((DEBUG_VERBOSE, "CpuPageTableUpdate 0x%lx", *PageEntry));
+          DEBUG ((DEBUG_VERBOSE, "->0x%lx\n", NewPageEntry));
+          *PageEntry = NewPageEntry;
+          Modified   = TRUE;
+        }
+        BaseAddress += PageLength;
+        Length      -= PageLength;
+      } else {
+        //
+        // Only split the current page; the change is applied to the smaller
+        // pages in the next rounds.
+        //
+        if (AllocatePages == NULL) {
+          Status = RETURN_UNSUPPORTED;
+          break;
+        }
+        Status = CpuPageTableSplitEntry (PageTable, PageEntry, PageSize, AllocatePages);
+        if (RETURN_ERROR (Status)) {
+          break;
+        }
+        Splitted = TRUE;
+        Modified = TRUE;
+      }
+    }
+    if (RETURN_ERROR (Status)) {
+      break;
+    }
+  }
+
+  //
+  // Merge once the whole batch is applied, so that a page split by one
+  // change and restored by a later one costs a single merge.
+  //
+  if (FreePages != NULL) {
+    while (Index-- > 0) {
+      if (CpuPageTableMerge (PageTable, Changes[Index].BaseAddress, Changes[Index].Length, FreePages) != 0) {
+        Modified = TRUE;
+      }
+    }
+  }
+
+  if (IsSplitted != NULL) {
+    *IsSplitted = Splitted;
+  }
+  if (IsModified != NULL) {
+    *IsModified = Modified;
+  }
+  return Status;
+}
+
+/**
+  Count the tables and leaf entries below a table.
+
+  @param[in]      PageTable     The page table.
+  @param[in]      Table         The table.
+  @param[in]      Level         The level of the table.
+  @param[in, out] Stats         The statistics to update.
+**/
+STATIC
+VOID
+CollectStats (
+  IN     CONST CPU_PAGE_TABLE             *PageTable,
+  IN     CONST UINT64                     *Table,
+  IN     UINT32                           Level,
+  IN OUT CPU_PAGE_TABLE_STATS             *Stats
+  )
+{
+  UINT64                    *ChildTable;
+  UINT64                    LeafEntry;
+  UINTN                     Count;
+  UINTN                     Index;
+
+  Stats->TablePages++;
+  Count = GetEntryCount (PageTable, Level);
+  for (Index = 0; Index < Count; Index++) {
+    if (Table[Index] == 0) {
+      continue;
+    }
+    if (IsLeafEntry (Table[Index], Level)) {
+      if (Level == 1) {
+        Stats->Pages4K++;
+      } else if (Level == 2) {
+        Stats->Pages2M++;
+      } else {
+        Stats->Pages1G++;
+      }
+      continue;
+    }
+    if ((Table[Index] & IA32_PG_P) == 0) {
+      continue;
+    }
+
+    ChildTable = GetChildTable (PageTable, Table[Index]);
+    CollectStats (PageTable, ChildTable, Level - 1, Stats);
+    if (IsMergeableLevel (PageTable, Level) &&
+        GetMergedEntry (PageTable, Table[Index], ChildTable, Level - 1, &LeafEntry)) {
+      Stats->MergeableTables++;
+    }
+  }
+}
+
+/**
+  Count the tables and the leaf entries of each size of a page table.
+
+  @param[in]  PageTable     The page table.
+  @param[out] Stats         The statistics.
+
+**/
+VOID
+EFIAPI
+CpuPageTableGetStats (
+  IN  CONST CPU_PAGE_TABLE                *PageTable,
+  OUT CPU_PAGE_TABLE_STATS                *Stats
+  )
+{
+  ASSERT (PageTable != NULL);
+  ASSERT (Stats != NULL);
+
+  ZeroMem (Stats, sizeof (*Stats));
+  CollectStats (PageTable, (UINT64 *)(UINTN)PageTable->PageTableBase, PageTable->Levels, Stats);
+}
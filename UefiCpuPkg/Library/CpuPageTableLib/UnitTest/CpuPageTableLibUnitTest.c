@@ -0,0 +1,681 @@
+/** @file
+  Unit tests of the CpuPageTableLib instance of the CpuPageTableLib class
+
+  Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UnitTestLib.h>
+#include <Library/CpuPageTableLib.h>
+
+#define UNIT_TEST_APP_NAME        "CpuPageTableLib Unit Tests"
+#define UNIT_TEST_APP_VERSION     "1.0"
+
+#define IA32_PG_P                 BIT0
+#define IA32_PG_RW                BIT1
+#define IA32_PG_A                 BIT5
+#define IA32_PG_D                 BIT6
+#define IA32_PG_PS                BIT7
+#define IA32_PG_NX                BIT63
+
+#define PAGING_4K_ADDRESS_MASK_64 0x000FFFFFFFFFF000ull
+
+//
+// The tests identity map the first 4GB, and keep the expected attributes of
+// every 4KB page in a shadow map: bit 0 for present, bit 1 for writable and
+// bit 2 for no execute.
+//
+#define TEST_MEMORY_SIZE          SIZE_4GB
+#define TEST_PAGE_COUNT           ((UINTN)(TEST_MEMORY_SIZE / SIZE_4KB))
+#define TEST_INITIAL_ATTRIBUTES   (IA32_PG_P | IA32_PG_RW)
+#define TEST_BATCH_COUNT          64
+#define TEST_MAX_BATCH_SIZE       8
+
+typedef struct {
+  UINT32   Levels;
+  BOOLEAN  Page1GSupport;
+  UINT64   AddressEncMask;
+  UINT64   Seed;
+} CPU_PAGE_TABLE_TEST_CONTEXT;
+
+STATIC CPU_PAGE_TABLE_TEST_CONTEXT  mTestContexts[] = {
+  { 4, TRUE,  0,      0x5DEECE66Dull },
+  { 4, FALSE, 0,      0x2545F4914F6CDD1Dull },
+  { 5, TRUE,  0,      0x9E3779B97F4A7C15ull },
+  { 4, TRUE,  BIT51,  0xD1B54A32D192ED03ull },
+  { 3, FALSE, 0,      0x8CB92BA72F3D8DD7ull }
+};
+
+STATIC UINT64  mRandomState;
+STATIC UINTN   mAllocatedPages;
+STATIC UINT8   *mShadow;
+
+/**
+  Return the next number of a deterministic pseudo random sequence.
+
+  @return A 64-bit pseudo random number.
+**/
+STATIC
+UINT64
+Random64 (
+  VOID
+  )
+{
+  mRandomState ^= LShiftU64 (mRandomState, 13);
+  mRandomState ^= RShiftU64 (mRandomState, 7);
+  mRandomState ^= LShiftU64 (mRandomState, 17);
+  return mRandomState;
+}
+
+/**
+  Return a pseudo random number in a range.
+
+  @param Start  The lowest number.
+  @param Limit  The highest number.
+
+  @return A number in [Start, Limit].
+**/
+STATIC
+UINT64
+RandomBetween (
+  IN UINT64  Start,
+  IN UINT64  Limit
+  )
+{
+  return Start + Random64 () % (Limit - Start + 1);
+}
+
+/**
+  Allocate zeroed pages for page table, counting them.
+
+  @param  Pages                 The number of 4 KB pages to allocate.
+
+  @return A pointer to the allocated buffer or NULL if allocation fails.
+**/
+STATIC
+VOID *
+EFIAPI
+TestAllocatePages (
+  IN UINTN  Pages
+  )
+{
+  VOID  *Buffer;
+
+  Buffer = AllocateAlignedPages (Pages, SIZE_4KB);
+  if (Buffer != NULL) {
+    ZeroMem (Buffer, EFI_PAGES_TO_SIZE (Pages));
+    mAllocatedPages += Pages;
+  }
+  return Buffer;
+}
+
+/**
+  Free pages allocated by TestAllocatePages().
+
+  @param  Buffer                The pages to free.
+  @param  Pages                 The number of 4 KB pages to free.
+**/
+STATIC
+VOID
+EFIAPI
+TestFreePages (
+  IN VOID   *Buffer,
+  IN UINTN  Pages
+  )
+{
+  ASSERT (mAllocatedPages >= Pages);
+  mAllocatedPages -= Pages;
+  FreeAlignedPages (Buffer, Pages);
+}
+
+/**
+  Free all the tables of a page table, bottom up.
+
+  @param PageTable  The page table.
+  @param Table      The table to free.
+  @param Level      The level of the table.
+**/
+STATIC
+VOID
+DestroyTable (
+  IN CPU_PAGE_TABLE  *PageTable,
+  IN UINT64          *Table,
+  IN UINT32          Level
+  )
+{
+  UINTN   Index;
+  UINTN   Count;
+
+  Count = ((Level == 3) && (PageTable->Levels == 3)) ? 4 : 512;
+  for (Index = 0; (Level > 1) && (Index < Count); Index++) {
+    if (((Table[Index] & IA32_PG_P) != 0) &&
+        ((Level > 3) || ((Table[Index] & IA32_PG_PS) == 0))) {
+      DestroyTable (
+        PageTable,
+        (UINT64 *)(UINTN)(Table[Index] & ~PageTable->AddressEncMask & PAGING_4K_ADDRESS_MASK_64),
+        Level - 1
+        );
+    }
+  }
+  TestFreePages (Table, 1);
+}
+
+/**
+  Create a page table identity mapping the first 4GB with the largest pages
+  the configuration supports, and reset the shadow map.
+
+  @param Context    The configuration to test.
+  @param PageTable  Returns the page table.
+
+  @retval UNIT_TEST_PASSED  The page table is created.
+**/
+STATIC
+UNIT_TEST_STATUS
+CreatePageTable (
+  IN  CPU_PAGE_TABLE_TEST_CONTEXT  *Context,
+  OUT CPU_PAGE_TABLE               *PageTable
+  )
+{
+  UINT64  *Table;
+  UINT64  *Child;
+  UINT64  *Directory;
+  UINT64  *Pdpt;
+  UINT64  NonLeaf;
+  UINTN   Index;
+  UINTN   Index2M;
+
+  mRandomState    = Context->Seed;
+  mAllocatedPages = 0;
+  SetMem (mShadow, TEST_PAGE_COUNT, (UINT8)(TEST_INITIAL_ATTRIBUTES));
+
+  PageTable->Levels         = Context->Levels;
+  PageTable->Page1GSupport  = Context->Page1GSupport;
+  PageTable->AddressEncMask = Context->AddressEncMask;
+  NonLeaf                   = Context->AddressEncMask | IA32_PG_A | IA32_PG_RW | IA32_PG_P;
+
+  Pdpt = TestAllocatePages (1);
+  UT_ASSERT_NOT_NULL (Pdpt);
+  Table = Pdpt;
+  for (Index = 3; Index < Context->Levels; Index++) {
+    Child = Table;
+    Table = TestAllocatePages (1);
+    UT_ASSERT_NOT_NULL (Table);
+    Table[0] = (UINT64)(UINTN)Child | NonLeaf;
+  }
+  PageTable->PageTableBase = (UINT64)(UINTN)Table;
+
+  for (Index = 0; Index < 4; Index++) {
+    if (Context->Page1GSupport) {
+      Pdpt[Index] = MultU64x32 (SIZE_1GB, (UINT32)Index) | Context->AddressEncMask |
+                    IA32_PG_PS | TEST_INITIAL_ATTRIBUTES;
+      continue;
+    }
+    Directory = TestAllocatePages (1);
+    UT_ASSERT_NOT_NULL (Directory);
+    for (Index2M = 0; Index2M < 512; Index2M++) {
+      Directory[Index2M] = MultU64x32 (SIZE_2MB, (UINT32)(Index * 512 + Index2M)) |
+                           Context->AddressEncMask | IA32_PG_PS | TEST_INITIAL_ATTRIBUTES;
+    }
+    Pdpt[Index] = (UINT64)(UINTN)Directory | Context->AddressEncMask | IA32_PG_P;
+    if (Context->Levels > 3) {
+      Pdpt[Index] = (UINT64)(UINTN)Directory | NonLeaf;
+    }
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Return the shadow attributes of a leaf entry.
+
+  @param Entry  The leaf entry.
+
+  @return The attributes in the shadow map encoding.
+**/
+STATIC
+UINT8
+GetShadowAttributes (
+  IN UINT64  Entry
+  )
+{
+  return (UINT8)((((Entry & IA32_PG_P) != 0) ? BIT0 : 0) |
+                 (((Entry & IA32_PG_RW) != 0) ? BIT1 : 0) |
+                 (((Entry & IA32_PG_NX) != 0) ? BIT2 : 0));
+}
+
+/**
+  Apply a change to the shadow map.
+
+  @param Change  The change.
+**/
+STATIC
+VOID
+ApplyShadowChange (
+  IN CPU_PAGE_TABLE_CHANGE  *Change
+  )
+{
+  UINT8  SetBits;
+  UINT8  ClearBits;
+  UINTN  Page;
+  UINTN  LastPage;
+
+  SetBits   = GetShadowAttributes (Change->SetBits);
+  ClearBits = GetShadowAttributes (Change->ClearBits);
+  LastPage  = (UINTN)((Change->BaseAddress + Change->Length) / SIZE_4KB);
+  for (Page = (UINTN)(Change->BaseAddress / SIZE_4KB); Page < LastPage; Page++) {
+    mShadow[Page] = (UINT8)((mShadow[Page] & ~ClearBits) | SetBits);
+  }
+}
+
+/**
+  Check that every page is identity mapped with the attributes of the shadow
+  map, and that the page table has the expected shape.
+
+  @param PageTable      The page table.
+  @param CheckMerged    TRUE if no table may be left mergeable.
+
+  @retval UNIT_TEST_PASSED  The page table matches the shadow map.
+**/
+STATIC
+UNIT_TEST_STATUS
+VerifyPageTable (
+  IN CPU_PAGE_TABLE  *PageTable,
+  IN BOOLEAN         CheckMerged
+  )
+{
+  CPU_PAGE_TABLE_STATS  Stats;
+  UINT64                *Entry;
+  CPU_PAGE_SIZE         PageSize;
+  UINT64                Address;
+  UINT64                PageLength;
+  UINT8                 Attributes;
+  UINTN                 Page;
+
+  Address = 0;
+  while (Address < TEST_MEMORY_SIZE) {
+    Entry = CpuPageTableGetEntry (PageTable, Address, &PageSize);
+    UT_ASSERT_NOT_NULL (Entry);
+    if (PageSize == CpuPage4K) {
+      PageLength = SIZE_4KB;
+    } else if (PageSize == CpuPage2M) {
+      PageLength = SIZE_2MB;
+      UT_ASSERT_TRUE ((*Entry & IA32_PG_PS) != 0);
+    } else {
+      UT_ASSERT_EQUAL (PageSize, CpuPage1G);
+      UT_ASSERT_TRUE (PageTable->Page1GSupport);
+      PageLength = SIZE_1GB;
+      UT_ASSERT_TRUE ((*Entry & IA32_PG_PS) != 0);
+    }
+    UT_ASSERT_EQUAL (*Entry & PageTable->AddressEncMask, PageTable->AddressEncMask);
+    UT_ASSERT_EQUAL (*Entry & ~PageTable->AddressEncMask & PAGING_4K_ADDRESS_MASK_64 & ~(PageLength - 1), Address);
+
+    Attributes = GetShadowAttributes (*Entry);
+    for (Page = (UINTN)(Address / SIZE_4KB); Page < (UINTN)((Address + PageLength) / SIZE_4KB); Page++) {
+      UT_ASSERT_EQUAL (mShadow[Page], Attributes);
+    }
+    Address += PageLength;
+  }
+
+  CpuPageTableGetStats (PageTable, &Stats);
+  UT_ASSERT_EQUAL (Stats.TablePages, mAllocatedPages);
+  if (CheckMerged) {
+    UT_ASSERT_EQUAL (Stats.MergeableTables, 0);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Generate a random change. Most changes are small, like the ones memory
+  protection makes for image sections and guard pages; some cover several
+  large pages.
+
+  @param Change  Returns the change.
+**/
+STATIC
+VOID
+GenerateRandomChange (
+  OUT CPU_PAGE_TABLE_CHANGE  *Change
+  )
+{
+  UINT64  Bits[3];
+  UINTN   Index;
+  UINT64  Class;
+
+  Class = RandomBetween (0, 99);
+  if (Class < 60) {
+    Change->BaseAddress = RandomBetween (0, TEST_PAGE_COUNT - 1) * SIZE_4KB;
+    Change->Length      = RandomBetween (1, 64) * SIZE_4KB;
+  } else if (Class < 85) {
+    Change->BaseAddress = RandomBetween (0, TEST_PAGE_COUNT - 1) * SIZE_4KB;
+    Change->Length      = RandomBetween (1, 8 * 512) * SIZE_4KB;
+  } else {
+    Change->BaseAddress = RandomBetween (0, TEST_MEMORY_SIZE / SIZE_2MB - 1) * SIZE_2MB;
+    Change->Length      = RandomBetween (1, 1024) * SIZE_2MB;
+  }
+  if (Change->BaseAddress + Change->Length > TEST_MEMORY_SIZE) {
+    Change->Length = TEST_MEMORY_SIZE - Change->BaseAddress;
+  }
+
+  //
+  // Restoring the initial attributes is frequent, so that pages get merged.
+  //
+  if (RandomBetween (0, 2) == 0) {
+    Change->SetBits   = TEST_INITIAL_ATTRIBUTES;
+    Change->ClearBits = IA32_PG_NX;
+    return;
+  }
+
+  Bits[0]           = IA32_PG_P;
+  Bits[1]           = IA32_PG_RW;
+  Bits[2]           = IA32_PG_NX;
+  Change->SetBits   = 0;
+  Change->ClearBits = 0;
+  for (Index = 0; Index < ARRAY_SIZE (Bits); Index++) {
+    switch (RandomBetween (0, 2)) {
+      case 0:
+        Change->SetBits |= Bits[Index];
+        break;
+      case 1:
+        Change->ClearBits |= Bits[Index];
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+/**
+  Set the accessed and dirty bits of random leaf entries, as the processor
+  does. They must not prevent merging.
+
+  @param PageTable  The page table.
+**/
+STATIC
+VOID
+SimulateAccesses (
+  IN CPU_PAGE_TABLE  *PageTable
+  )
+{
+  UINT64         *Entry;
+  CPU_PAGE_SIZE  PageSize;
+  UINTN          Index;
+
+  for (Index = 0; Index < 64; Index++) {
+    Entry = CpuPageTableGetEntry (PageTable, RandomBetween (0, TEST_PAGE_COUNT - 1) * SIZE_4KB, &PageSize);
+    if ((Entry != NULL) && ((*Entry & IA32_PG_P) != 0)) {
+      *Entry |= IA32_PG_A;
+      if ((*Entry & IA32_PG_RW) != 0) {
+        *Entry |= IA32_PG_D;
+      }
+    }
+  }
+}
+
+/**
+  Apply random batches of changes, merging after each batch, and check that
+  the mapping matches the shadow map and that no mergeable table is left.
+  Restoring the initial attributes must restore the initial page table.
+
+  @param Context    The configuration to test.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+UnitTestUpdateAndMerge (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UNIT_TEST_STATUS       Status;
+  CPU_PAGE_TABLE         PageTable;
+  CPU_PAGE_TABLE_STATS   InitialStats;
+  CPU_PAGE_TABLE_STATS   Stats;
+  CPU_PAGE_TABLE_CHANGE  Changes[TEST_MAX_BATCH_SIZE];
+  UINTN                  ChangeCount;
+  UINTN                  Batch;
+  UINTN                  Index;
+  BOOLEAN                IsModified;
+
+  Status = CreatePageTable ((CPU_PAGE_TABLE_TEST_CONTEXT *)Context, &PageTable);
+  UT_ASSERT_EQUAL (Status, UNIT_TEST_PASSED);
+  CpuPageTableGetStats (&PageTable, &InitialStats);
+  UT_ASSERT_EQUAL (InitialStats.TablePages, mAllocatedPages);
+
+  for (Batch = 0; Batch < TEST_BATCH_COUNT; Batch++) {
+    ChangeCount = (UINTN)RandomBetween (1, TEST_MAX_BATCH_SIZE);
+    for (Index = 0; Index < ChangeCount; Index++) {
+      GenerateRandomChange (&Changes[Index]);
+      ApplyShadowChange (&Changes[Index]);
+    }
+    UT_ASSERT_NOT_EFI_ERROR (
+      CpuPageTableUpdate (&PageTable, Changes, ChangeCount, TestAllocatePages, TestFreePages, NULL, &IsModified)
+      );
+    Status = VerifyPageTable (&PageTable, TRUE);
+    UT_ASSERT_EQUAL (Status, UNIT_TEST_PASSED);
+    SimulateAccesses (&PageTable);
+  }
+
+  Changes[0].BaseAddress = 0;
+  Changes[0].Length      = TEST_MEMORY_SIZE;
+  Changes[0].SetBits     = TEST_INITIAL_ATTRIBUTES;
+  Changes[0].ClearBits   = IA32_PG_NX;
+  ApplyShadowChange (&Changes[0]);
+  UT_ASSERT_NOT_EFI_ERROR (
+    CpuPageTableUpdate (&PageTable, Changes, 1, TestAllocatePages, TestFreePages, NULL, NULL)
+    );
+  Status = VerifyPageTable (&PageTable, TRUE);
+  UT_ASSERT_EQUAL (Status, UNIT_TEST_PASSED);
+
+  CpuPageTableGetStats (&PageTable, &Stats);
+  UT_ASSERT_MEM_EQUAL (&Stats, &InitialStats, sizeof (Stats));
+
+  DestroyTable (&PageTable, (UINT64 *)(UINTN)PageTable.PageTableBase, PageTable.Levels);
+  UT_ASSERT_EQUAL (mAllocatedPages, 0);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Apply random batches of changes without merging, then merge the whole
+  range at once, and check that the mapping is unchanged by the merge.
+
+  @param Context    The configuration to test.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+UnitTestDeferredMerge (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UNIT_TEST_STATUS       Status;
+  CPU_PAGE_TABLE         PageTable;
+  CPU_PAGE_TABLE_STATS   Stats;
+  CPU_PAGE_TABLE_CHANGE  Change;
+  UINTN                  Batch;
+  UINTN                  Released;
+  BOOLEAN                IsSplitted;
+
+  Status = CreatePageTable ((CPU_PAGE_TABLE_TEST_CONTEXT *)Context, &PageTable);
+  UT_ASSERT_EQUAL (Status, UNIT_TEST_PASSED);
+
+  for (Batch = 0; Batch < TEST_BATCH_COUNT; Batch++) {
+    GenerateRandomChange (&Change);
+    ApplyShadowChange (&Change);
+    UT_ASSERT_NOT_EFI_ERROR (
+      CpuPageTableUpdate (&PageTable, &Change, 1, TestAllocatePages, NULL, &IsSplitted, NULL)
+      );
+  }
+  Status = VerifyPageTable (&PageTable, FALSE);
+  UT_ASSERT_EQUAL (Status, UNIT_TEST_PASSED);
+
+  CpuPageTableGetStats (&PageTable, &Stats);
+  Released = CpuPageTableMerge (&PageTable, 0, TEST_MEMORY_SIZE, TestFreePages);
+  UT_ASSERT_TRUE (Released >= Stats.MergeableTables);
+  UT_ASSERT_EQUAL (Stats.TablePages - Released, mAllocatedPages);
+  Status = VerifyPageTable (&PageTable, TRUE);
+  UT_ASSERT_EQUAL (Status, UNIT_TEST_PASSED);
+
+  DestroyTable (&PageTable, (UINT64 *)(UINTN)PageTable.PageTableBase, PageTable.Levels);
+  UT_ASSERT_EQUAL (mAllocatedPages, 0);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Check the parameter validation of CpuPageTableUpdate().
+
+  @param Context    The configuration to test.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+UnitTestInvalidChanges (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UNIT_TEST_STATUS       Status;
+  CPU_PAGE_TABLE         PageTable;
+  CPU_PAGE_TABLE_CHANGE  Change;
+
+  Status = CreatePageTable ((CPU_PAGE_TABLE_TEST_CONTEXT *)Context, &PageTable);
+  UT_ASSERT_EQUAL (Status, UNIT_TEST_PASSED);
+
+  Change.BaseAddress = SIZE_1MB;
+  Change.Length      = 0;
+  Change.SetBits     = IA32_PG_NX;
+  Change.ClearBits   = 0;
+  UT_ASSERT_STATUS_EQUAL (
+    CpuPageTableUpdate (&PageTable, &Change, 1, TestAllocatePages, TestFreePages, NULL, NULL),
+    RETURN_INVALID_PARAMETER
+    );
+
+  Change.Length = SIZE_4KB + 1;
+  UT_ASSERT_STATUS_EQUAL (
+    CpuPageTableUpdate (&PageTable, &Change, 1, TestAllocatePages, TestFreePages, NULL, NULL),
+    RETURN_UNSUPPORTED
+    );
+
+  //
+  // Splitting is required but not allowed.
+  //
+  Change.Length = SIZE_4KB;
+  UT_ASSERT_STATUS_EQUAL (
+    CpuPageTableUpdate (&PageTable, &Change, 1, NULL, NULL, NULL, NULL),
+    RETURN_UNSUPPORTED
+    );
+
+  Change.BaseAddress = TEST_MEMORY_SIZE;
+  UT_ASSERT_STATUS_EQUAL (
+    CpuPageTableUpdate (&PageTable, &Change, 1, TestAllocatePages, TestFreePages, NULL, NULL),
+    RETURN_UNSUPPORTED
+    );
+
+  Status = VerifyPageTable (&PageTable, TRUE);
+  UT_ASSERT_EQUAL (Status, UNIT_TEST_PASSED);
+
+  DestroyTable (&PageTable, (UINT64 *)(UINTN)PageTable.PageTableBase, PageTable.Levels);
+  UT_ASSERT_EQUAL (mAllocatedPages, 0);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  CpuPageTableLib and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      PageTableTests;
+  UINTN                       Index;
+
+  Framework = NULL;
+
+  mShadow = AllocatePool (TEST_PAGE_COUNT);
+  if (mShadow == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // Setup the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  //
+  // Populate the CpuPageTableLib Unit Test Suite.
+  //
+  Status = CreateUnitTestSuite (&PageTableTests, Framework, "CpuPageTableLib Tests", "CpuPageTableLib.CpuPageTableLib", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for CpuPageTableLib Tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+  for (Index = 0; Index < ARRAY_SIZE (mTestContexts); Index++) {
+    AddTestCase (PageTableTests, "Test CpuPageTableUpdate with merging", "UpdateAndMerge", UnitTestUpdateAndMerge, NULL, NULL, &mTestContexts[Index]);
+    AddTestCase (PageTableTests, "Test CpuPageTableMerge",               "DeferredMerge",  UnitTestDeferredMerge,  NULL, NULL, &mTestContexts[Index]);
+    AddTestCase (PageTableTests, "Test invalid changes",                 "InvalidChanges", UnitTestInvalidChanges, NULL, NULL, &mTestContexts[Index]);
+  }
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework != NULL) {
+    FreeUnitTestFramework (Framework);
+  }
+  FreePool (mShadow);
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+  @param Argc  Number of arguments.
+  @param Argv  Array of arguments.
+
+  @return Test application exit code.
+**/
+INT32
+main (
+  INT32 Argc,
+  CHAR8 *Argv[]
+  )
+{
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+  return UnitTestingEntry ();
+}
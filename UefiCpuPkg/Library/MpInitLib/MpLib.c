@@ -281,6 +281,7 @@ GetApLoopMode (
 {
   UINT8                         ApLoopMode;
   CPUID_MONITOR_MWAIT_EBX       MonitorMwaitEbx;
+  CPUID_VERSION_INFO_EBX        VersionInfoEbx;
 
   ASSERT (MonitorFilterSize != NULL);
 
@@ -304,8 +305,16 @@ GetApLoopMode (
     }
   }
 
-  if (ApLoopMode != ApInMwaitLoop) {
+  if (ApLoopMode == ApInHltLoop) {
     *MonitorFilterSize = sizeof (UINT32);
+  } else if (ApLoopMode == ApInRunLoop) {
+    //
+    // Keep the start-up signal of each AP in its own cache line, so APs
+    // polling their signals do not slow each other and the BSP down.
+    // CPUID.[EAX=01H]:EBX.BIT8-15: CLFLUSH line size in 8-byte units
+    //
+    AsmCpuid (CPUID_VERSION_INFO, NULL, &VersionInfoEbx.Uint32, NULL, NULL);
+    *MonitorFilterSize = MAX (sizeof (UINT32), VersionInfoEbx.Bits.CacheLineSize * 8);
   } else {
     //
     // CPUID.[EAX=05H]:EBX.BIT0-15: Largest monitor-line size in bytes
@@ -769,6 +778,11 @@ ApWakeupFunction (
       //
       GetProcessorNumber (CpuMpData, &ProcessorNumber);
       //
+      // Pass a hierarchical wakeup on before clearing the start-up signal,
+      // so the signal is only cleared once all APs below this one are awake.
+      //
+      RelayApWakeup (CpuMpData, ProcessorNumber);
+      //
       // Clear AP start-up signal when AP waken up
       //
       ApStartupSignalBuffer = CpuMpData->CpuData[ProcessorNumber].StartupApSignal;
@@ -989,6 +1003,206 @@ WaitApWakeup (
   }
 }
 
+/**
+  Wait for AP wakeup in MWAIT, instead of spinning, till AP is waken up.
+
+  The start-up signal of every AP lives in its own monitor line, and the AP
+  writes it when it clears the signal, which ends the MWAIT.
+
+  @param[in] ApStartupSignalBuffer  Pointer to AP wakeup signal
+**/
+VOID
+WaitApWakeupInMwait (
+  IN volatile UINT32        *ApStartupSignalBuffer
+  )
+{
+  while (InterlockedCompareExchange32 (
+          (UINT32 *) ApStartupSignalBuffer,
+          WAKEUP_AP_SIGNAL,
+          WAKEUP_AP_SIGNAL
+          ) != 0) {
+    AsmMonitor ((UINTN) ApStartupSignalBuffer, 0, 0);
+    if (*ApStartupSignalBuffer == WAKEUP_AP_SIGNAL) {
+      //
+      // The AP is expected to wake up shortly, so only use C1 here rather
+      // than CpuMpData->ApTargetCState.
+      //
+      AsmMwait (0, 0);
+    }
+  }
+}
+
+/**
+  Hand the procedure of a hierarchical wakeup to an AP and set its start-up
+  signal.
+
+  @param[in] CpuMpData          Pointer to CPU MP Data
+  @param[in] GroupBase          Index of the first AP of the package in
+                                CpuMpData->WakeupOrder
+  @param[in] GroupSize          Number of APs of the package in
+                                CpuMpData->WakeupOrder
+  @param[in] GroupIndex         Index of the AP to wake up in the package
+  @param[in] Procedure          The function to be invoked by AP
+  @param[in] ProcedureArgument  The argument to be passed into AP function
+**/
+VOID
+SignalApInWakeupTree (
+  IN CPU_MP_DATA               *CpuMpData,
+  IN UINT32                    GroupBase,
+  IN UINT32                    GroupSize,
+  IN UINT32                    GroupIndex,
+  IN UINTN                     Procedure,
+  IN UINTN                     ProcedureArgument
+  )
+{
+  CPU_AP_DATA                  *CpuData;
+
+  CpuData = &CpuMpData->CpuData[CpuMpData->WakeupOrder[GroupBase + GroupIndex]];
+  CpuData->ApFunction         = Procedure;
+  CpuData->ApFunctionArgument = ProcedureArgument;
+  CpuData->WakeupGroupBase    = GroupBase;
+  CpuData->WakeupGroupSize    = GroupSize;
+  CpuData->WakeupIndex        = GroupIndex;
+  SetApState (CpuData, CpuStateReady);
+  *(UINT32 *) CpuData->StartupApSignal = WAKEUP_AP_SIGNAL;
+}
+
+/**
+  Wake up the APs this AP is responsible for in a hierarchical wakeup, and
+  wait until they are awake.
+
+  The APs of a package form a tree in CpuMpData->WakeupOrder, with the AP
+  at index I of the package waking up the APs at indexes
+  I * ApWakeupFanout + 1 to I * ApWakeupFanout + ApWakeupFanout.
+
+  @param[in] CpuMpData          Pointer to CPU MP Data
+  @param[in] ProcessorNumber    The handle number of the calling AP
+**/
+VOID
+RelayApWakeup (
+  IN CPU_MP_DATA               *CpuMpData,
+  IN UINTN                     ProcessorNumber
+  )
+{
+  CPU_AP_DATA                  *CpuData;
+  UINT32                       GroupBase;
+  UINT32                       GroupSize;
+  UINT32                       First;
+  UINT32                       Last;
+  UINT32                       Child;
+  volatile UINT32              *StartupApSignal;
+
+  CpuData   = &CpuMpData->CpuData[ProcessorNumber];
+  GroupSize = CpuData->WakeupGroupSize;
+  if (GroupSize == 0) {
+    return;
+  }
+
+  GroupBase = CpuData->WakeupGroupBase;
+  First     = CpuData->WakeupIndex * CpuMpData->ApWakeupFanout + 1;
+  Last      = MIN (First + CpuMpData->ApWakeupFanout, GroupSize);
+  for (Child = First; Child < Last; Child++) {
+    SignalApInWakeupTree (
+      CpuMpData,
+      GroupBase,
+      GroupSize,
+      Child,
+      CpuData->ApFunction,
+      CpuData->ApFunctionArgument
+      );
+  }
+
+  for (Child = First; Child < Last; Child++) {
+    StartupApSignal = CpuMpData->CpuData[CpuMpData->WakeupOrder[GroupBase + Child]].StartupApSignal;
+    if (CpuMpData->ApLoopMode == ApInMwaitLoop) {
+      WaitApWakeupInMwait (StartupApSignal);
+    } else {
+      WaitApWakeup (StartupApSignal);
+    }
+  }
+
+  CpuData->WakeupGroupSize = 0;
+}
+
+/**
+  Wake up APs in Mwait-Loop or Run-Loop state through a tree per package.
+
+  The BSP only wakes up the first AP of each package. Every AP woken up this
+  way wakes up CpuMpData->ApWakeupFanout more APs of its package before it
+  runs the procedure, so the time to wake up all APs grows with the
+  logarithm of the AP count instead of linearly.
+
+  @param[in] CpuMpData          Pointer to CPU MP Data
+  @param[in] Procedure          The function to be invoked by AP
+  @param[in] ProcedureArgument  The argument to be passed into AP function
+  @param[in] WakeUpDisabledAps  Whether need to wake up disabled APs.
+**/
+VOID
+WakeUpApsByTree (
+  IN CPU_MP_DATA               *CpuMpData,
+  IN EFI_AP_PROCEDURE          Procedure,              OPTIONAL
+  IN VOID                      *ProcedureArgument,     OPTIONAL
+  IN BOOLEAN                   WakeUpDisabledAps
+  )
+{
+  CPU_AP_DATA                  *CpuData;
+  UINT32                       *WakeupOrder;
+  UINT32                       Count;
+  UINT32                       GroupBase;
+  UINT32                       Index;
+
+  CpuData     = CpuMpData->CpuData;
+  WakeupOrder = CpuMpData->WakeupOrder;
+
+  //
+  // Processor numbers follow the APIC IDs, so the APs of a package are
+  // next to each other.
+  //
+  Count = 0;
+  for (Index = 0; Index < CpuMpData->CpuCount; Index++) {
+    if (Index == CpuMpData->BspNumber) {
+      continue;
+    }
+
+    if (GetApState (&CpuData[Index]) == CpuStateDisabled && !WakeUpDisabledAps) {
+      continue;
+    }
+
+    WakeupOrder[Count++] = Index;
+  }
+
+  //
+  // Wake up the first AP of every package.
+  //
+  GroupBase = 0;
+  for (Index = 1; Index <= Count; Index++) {
+    if ((Index == Count) ||
+        (CpuData[WakeupOrder[Index]].PackageId != CpuData[WakeupOrder[GroupBase]].PackageId)) {
+      SignalApInWakeupTree (
+        CpuMpData,
+        GroupBase,
+        Index - GroupBase,
+        0,
+        (UINTN) Procedure,
+        (UINTN) ProcedureArgument
+        );
+      GroupBase = Index;
+    }
+  }
+
+  //
+  // An AP clears its start-up signal only after the APs it wakes up have
+  // cleared theirs, so all APs are awake once the first AP of every package
+  // is.
+  //
+  for (Index = 0; Index < Count; Index++) {
+    if ((Index == 0) ||
+        (CpuData[WakeupOrder[Index]].PackageId != CpuData[WakeupOrder[Index - 1]].PackageId)) {
+      WaitApWakeup (CpuData[WakeupOrder[Index]].StartupApSignal);
+    }
+  }
+}
+
 /**
   This function will fill the exchange info structure.
 
@@ -1366,7 +1580,9 @@ WakeUpAP (
 
   ExchangeInfo = CpuMpData->MpCpuExchangeInfo;
 
-  if (Broadcast) {
+  if (Broadcast && !ResetVectorRequired && (CpuMpData->ApWakeupFanout != 0)) {
+    WakeUpApsByTree (CpuMpData, Procedure, ProcedureArgument, WakeUpDisabledAps);
+  } else if (Broadcast) {
     for (Index = 0; Index < CpuMpData->CpuCount; Index++) {
       if (Index != CpuMpData->BspNumber) {
         CpuData = &CpuMpData->CpuData[Index];
@@ -1989,7 +2205,7 @@ MpInitLibInitialize (
   BufferSize  = ALIGN_VALUE (BufferSize, 8);
   BufferSize += VolatileRegisters.Idtr.Limit + 1;
   BufferSize += sizeof (CPU_MP_DATA);
-  BufferSize += (sizeof (CPU_AP_DATA) + sizeof (CPU_INFO_IN_HOB))* MaxLogicalProcessorNumber;
+  BufferSize += (sizeof (CPU_AP_DATA) + sizeof (UINT32) + sizeof (CPU_INFO_IN_HOB))* MaxLogicalProcessorNumber;
   MpBuffer    = AllocatePages (EFI_SIZE_TO_PAGES (BufferSize));
   ASSERT (MpBuffer != NULL);
   ZeroMem (MpBuffer, BufferSize);
@@ -2012,6 +2228,8 @@ MpInitLibInitialize (
   //         CPU_MP_DATA
   //    +--------------------+ <-- CpuMpData->CpuData
   //        CPU_AP_DATA (N)
+  //    +--------------------+ <-- CpuMpData->WakeupOrder
+  //          UINT32 (N)
   //    +--------------------+ <-- CpuMpData->CpuInfoInHob
   //      CPU_INFO_IN_HOB (N)
   //    +--------------------+
@@ -2030,7 +2248,8 @@ MpInitLibInitialize (
   CpuMpData->WaitEvent        = NULL;
   CpuMpData->SwitchBspFlag    = FALSE;
   CpuMpData->CpuData          = (CPU_AP_DATA *) (CpuMpData + 1);
-  CpuMpData->CpuInfoInHob     = (UINT64) (UINTN) (CpuMpData->CpuData + MaxLogicalProcessorNumber);
+  CpuMpData->WakeupOrder      = (UINT32 *) (CpuMpData->CpuData + MaxLogicalProcessorNumber);
+  CpuMpData->CpuInfoInHob     = (UINT64) (UINTN) (CpuMpData->WakeupOrder + MaxLogicalProcessorNumber);
   InitializeSpinLock(&CpuMpData->MpLock);
   CpuMpData->SevEsIsEnabled = PcdGetBool (PcdSevEsIsEnabled);
   CpuMpData->SevEsAPBuffer  = (UINTN) -1;
@@ -2067,6 +2286,14 @@ MpInitLibInitialize (
   CpuMpData->ApLoopMode = ApLoopMode;
   DEBUG ((DEBUG_INFO, "AP Loop Mode is %d\n", CpuMpData->ApLoopMode));
 
+  //
+  // APs in Hlt-Loop state are woken up by INIT-SIPI-SIPI, which can not be
+  // relayed by other APs.
+  //
+  if (CpuMpData->ApLoopMode != ApInHltLoop) {
+    CpuMpData->ApWakeupFanout = PcdGet8 (PcdCpuApWakeupFanout);
+  }
+
   CpuMpData->WakeUpByInitSipiSipi = (CpuMpData->ApLoopMode == ApInHltLoop);
 
   //
@@ -2105,6 +2332,23 @@ MpInitLibInitialize (
     }
   }
 
+  if (CpuMpData->ApWakeupFanout != 0) {
+    //
+    // Group the APs by package for the hierarchical wakeup.
+    //
+    CpuInfoInHob = (CPU_INFO_IN_HOB *) (UINTN) CpuMpData->CpuInfoInHob;
+    for (Index = 0; Index < CpuMpData->CpuCount; Index++) {
+      GetProcessorLocationByApicId (
+        CpuInfoInHob[Index].InitialApicId,
+        &CpuMpData->CpuData[Index].PackageId,
+        NULL,
+        NULL
+        );
+    }
+
+    DEBUG ((DEBUG_INFO, "AP Wakeup Fanout is %d\n", CpuMpData->ApWakeupFanout));
+  }
+
   if (!GetMicrocodePatchInfoFromHob (
          &CpuMpData->MicrocodePatchAddress,
          &CpuMpData->MicrocodePatchRegionSize
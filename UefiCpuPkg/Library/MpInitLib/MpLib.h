@@ -146,6 +146,14 @@ typedef struct {
   UINT8                          PlatformId;
   UINT64                         MicrocodeEntryAddr;
   UINT32                         MicrocodeRevision;
+  //
+  // Position of the AP in CPU_MP_DATA.WakeupOrder during a hierarchical
+  // wakeup. WakeupGroupSize is zero when the AP has no APs to wake up.
+  //
+  UINT32                         PackageId;
+  volatile UINT32                WakeupGroupBase;
+  volatile UINT32                WakeupGroupSize;
+  volatile UINT32                WakeupIndex;
 } CPU_AP_DATA;
 
 //
@@ -292,6 +300,15 @@ struct _CPU_MP_DATA {
   CPU_MP_DATA                    *NewCpuMpData;
 
   UINT64                         GhcbBase;
+
+  //
+  // Hierarchical wakeup of APs in Mwait-Loop and Run-Loop state.
+  // ApWakeupFanout is the number of APs each woken AP wakes up, zero if the
+  // BSP wakes up every AP. WakeupOrder lists the APs of the current
+  // broadcast, grouped by package.
+  //
+  UINT8                          ApWakeupFanout;
+  UINT32                         *WakeupOrder;
 };
 
 #define AP_SAFE_STACK_SIZE  128
@@ -450,6 +467,19 @@ GetSevEsAPMemory (
   VOID
   );
 
+/**
+  Wake up the APs this AP is responsible for in a hierarchical wakeup, and
+  wait until they are awake.
+
+  @param[in] CpuMpData          Pointer to CPU MP Data
+  @param[in] ProcessorNumber    The handle number of the calling AP
+**/
+VOID
+RelayApWakeup (
+  IN CPU_MP_DATA               *CpuMpData,
+  IN UINTN                     ProcessorNumber
+  );
+
 /**
   This function will be called by BSP to wakeup AP.
 
@@ -41,12 +41,11 @@ typedef struct {
   UINT64                 Address;
   UINT64                 Alignment;
   UINT64                 Length;
-  MTRR_MEMORY_CACHE_TYPE Type : 7;
+  MTRR_MEMORY_CACHE_TYPE Type;
 
   //
   // Temprary use for calculating the best MTRR settings.
   //
-  BOOLEAN                Visited : 1;
   UINT8                  Weight;
   UINT16                 Previous;
 } MTRR_LIB_ADDRESS;
@@ -1112,6 +1111,12 @@ MtrrLibGetNumberOfTypes (
   the Previous of all vertices from Start to Stop is updated to reflect
   how the memory range is covered by MTRR.
 
+  Vertices are sorted by address and an MTRR always covers a range from a
+  lower vertex to a higher one, so the graph is acyclic. The shortest path is
+  found by relaxing the edges into each vertex in address order, which visits
+  every edge once instead of repeatedly searching for the closest unvisited
+  vertex.
+
   @param VertexCount     The count of vertices in the graph.
   @param Vertices        Array holding all vertices.
   @param Weight          2-dimention array holding weights between vertices.
@@ -1130,57 +1135,32 @@ MtrrLibCalculateLeastMtrrs (
   )
 {
   UINT16                         Index;
-  UINT8                          MinWeight;
-  UINT16                         MinI;
+  UINT16                         Pre;
   UINT8                          Mandatory;
   UINT8                          Optional;
+  UINTN                          PathWeight;
 
-  for (Index = Start; Index <= Stop; Index++) {
-    Vertices[Index].Visited = FALSE;
-    Mandatory = Weight[M(Start,Index)];
-    Vertices[Index].Weight = Mandatory;
-    if (Mandatory != MAX_WEIGHT) {
-      Optional = IncludeOptional ? Weight[O(Start, Index)] : 0;
-      Vertices[Index].Weight += Optional;
-      ASSERT (Vertices[Index].Weight >= Optional);
-    }
-  }
+  Vertices[Start].Weight = 0;
+  for (Index = Start + 1; Index <= Stop; Index++) {
+    Vertices[Index].Weight = MAX_WEIGHT;
 
-  MinI = Start;
-  MinWeight = 0;
-  while (!Vertices[Stop].Visited) {
     //
-    // Update the weight from the shortest vertex to other unvisited vertices
+    // The edge from the previous vertex always exists, so every vertex is
+    // reachable and the weight of every vertex before Index is final.
     //
-    for (Index = Start + 1; Index <= Stop; Index++) {
-      if (!Vertices[Index].Visited) {
-        Mandatory = Weight[M(MinI, Index)];
-        if (Mandatory != MAX_WEIGHT) {
-          Optional = IncludeOptional ? Weight[O(MinI, Index)] : 0;
-          if (MinWeight + Mandatory + Optional <= Vertices[Index].Weight) {
-            Vertices[Index].Weight   = MinWeight + Mandatory + Optional;
-            Vertices[Index].Previous = MinI; // Previous is Start based.
-          }
-        }
+    for (Pre = Start; Pre < Index; Pre++) {
+      Mandatory = Weight[M(Pre, Index)];
+      if (Mandatory == MAX_WEIGHT) {
+        continue;
       }
-    }
-
-    //
-    // Find the shortest vertex from Start
-    //
-    MinI      = VertexCount;
-    MinWeight = MAX_WEIGHT;
-    for (Index = Start + 1; Index <= Stop; Index++) {
-      if (!Vertices[Index].Visited && MinWeight > Vertices[Index].Weight) {
-        MinI      = Index;
-        MinWeight = Vertices[Index].Weight;
+      Optional   = IncludeOptional ? Weight[O(Pre, Index)] : 0;
+      PathWeight = (UINTN)Vertices[Pre].Weight + Mandatory + Optional;
+      if (PathWeight <= Vertices[Index].Weight) {
+        Vertices[Index].Weight   = (UINT8)PathWeight;
+        Vertices[Index].Previous = Pre; // Previous is Start based.
       }
     }
-
-    //
-    // Mark the shortest vertex from Start as visited
-    //
-    Vertices[MinI].Visited = TRUE;
+    ASSERT (Vertices[Index].Weight != MAX_WEIGHT);
   }
 }
 
@@ -1501,6 +1481,8 @@ MtrrLibCalculateMtrrs (
   UINT16                    Start;
   UINT16                    Stop;
   UINT8                     Type;
+  UINT8                     RangeTypes;
+  UINT8                     RangeTypeCount;
   RETURN_STATUS             Status;
 
   Base0 = Ranges[0].BaseAddress;
@@ -1580,9 +1562,20 @@ MtrrLibCalculateMtrrs (
   }
 
   for (TypeCount = 2; TypeCount <= 3; TypeCount++) {
-    for (Start = 0; Start < VertexCount; Start++) {
+    for (Start = 0; Start + 2 < VertexCount; Start++) {
+      //
+      // Every vertex lies in one range, so the types of [Start, Stop) are
+      // collected one vertex at a time as Stop grows, instead of searching
+      // the ranges again for every [Start, Stop).
+      //
+      RangeTypes     = (UINT8)(1 << Vertices[Start].Type);
+      RangeTypeCount = 1;
       for (Stop = Start + 2; Stop < VertexCount; Stop++) {
         ASSERT (Vertices[Stop].Address > Vertices[Start].Address);
+        if ((RangeTypes & (1 << Vertices[Stop - 1].Type)) == 0) {
+          RangeTypes |= (UINT8)(1 << Vertices[Stop - 1].Type);
+          RangeTypeCount++;
+        }
         Length = Vertices[Stop].Address - Vertices[Start].Address;
         if (Length > Vertices[Start].Alignment) {
           //
@@ -1591,9 +1584,7 @@ MtrrLibCalculateMtrrs (
           break;
         }
         if ((Weight[M(Start, Stop)] == MAX_WEIGHT) && MtrrLibIsPowerOfTwo (Length)) {
-          if (MtrrLibGetNumberOfTypes (
-                Ranges, RangeCount, Vertices[Start].Address, Vertices[Stop].Address - Vertices[Start].Address, &Type
-                ) == TypeCount) {
+          if (RangeTypeCount == TypeCount) {
             //
             // Update the Weight[Start, Stop] using subtractive path.
             //
@@ -1601,7 +1592,7 @@ MtrrLibCalculateMtrrs (
               DefaultType, A0,
               Ranges, RangeCount,
               (UINT16)VertexCount, Vertices, Weight,
-              Start, Stop, Type, TypeCount,
+              Start, Stop, RangeTypes, TypeCount,
               NULL, 0, NULL
               );
           } else if (TypeCount == 2) {
@@ -67,6 +67,26 @@ typedef struct {
 
 STATIC CHAR8 *mCacheDescription[] = { "UC", "WC", "N/A", "N/A", "WT", "WP", "WB" };
 
+//
+// Solver statistics collected from the random memory layout tests, so that a
+// change to the MTRR calculation which makes it slower or use more MTRRs shows
+// up in the test report.
+//
+typedef struct {
+  CHAR8   *Name;
+  UINTN   Layouts;
+  UINTN   Ranges;
+  UINT64  TotalTime;
+  UINT64  MaxTime;
+  UINTN   ExpectedMtrrs;
+  UINTN   ActualMtrrs;
+} MTRR_LIB_SOLVER_STATISTICS;
+
+STATIC MTRR_LIB_SOLVER_STATISTICS mSolverStatistics[] = {
+  { "MtrrSetMemoryAttributeInMtrrSettings" },
+  { "MtrrSetMemoryAttributesInMtrrSettings" }
+};
+
 /**
   Compare the actual memory ranges against expected memory ranges and return PASS when they match.
 
@@ -116,7 +136,63 @@ DumpMemoryRanges (
 }
 
 /**
+  Record how long it took to program a random memory layout and how many
+  variable MTRRs were used.
+
+  @param Statistics     Statistics to update.
+  @param RangeCount     Count of memory ranges in the layout.
+  @param Time           Processor time spent in MtrrLib, in clock ticks.
+  @param ExpectedMtrrs  Count of variable MTRRs used to generate the layout.
+  @param ActualMtrrs    Count of variable MTRRs used by MtrrLib.
 **/
+VOID
+RecordSolverStatistics (
+  IN OUT MTRR_LIB_SOLVER_STATISTICS  *Statistics,
+  IN     UINTN                       RangeCount,
+  IN     UINT64                      Time,
+  IN     UINT32                      ExpectedMtrrs,
+  IN     UINT32                      ActualMtrrs
+  )
+{
+  Statistics->Layouts++;
+  Statistics->Ranges        += RangeCount;
+  Statistics->TotalTime     += Time;
+  Statistics->MaxTime        = MAX (Statistics->MaxTime, Time);
+  Statistics->ExpectedMtrrs += ExpectedMtrrs;
+  Statistics->ActualMtrrs   += ActualMtrrs;
+  UT_LOG_INFO (
+    "Solved %d ranges with %d MTRRs (generated with %d) in %ld us\n",
+    RangeCount, ActualMtrrs, ExpectedMtrrs, Time * 1000000 / CLOCKS_PER_SEC
+    );
+}
+
+/**
+  Print the solver statistics collected by the random memory layout tests.
+**/
+VOID
+DumpSolverStatistics (
+  VOID
+  )
+{
+  UINTN                       Index;
+  MTRR_LIB_SOLVER_STATISTICS  *Statistics;
+
+  for (Index = 0; Index < ARRAY_SIZE (mSolverStatistics); Index++) {
+    Statistics = &mSolverStatistics[Index];
+    if (Statistics->Layouts == 0) {
+      continue;
+    }
+    DEBUG ((
+      DEBUG_INFO,
+      "%a: %d layouts, %d ranges, %ld us total, %ld us average, %ld us max, %d MTRRs used (generated with %d)\n",
+      Statistics->Name, Statistics->Layouts, Statistics->Ranges,
+      Statistics->TotalTime * 1000000 / CLOCKS_PER_SEC,
+      Statistics->TotalTime * 1000000 / CLOCKS_PER_SEC / Statistics->Layouts,
+      Statistics->MaxTime * 1000000 / CLOCKS_PER_SEC,
+      Statistics->ActualMtrrs, Statistics->ExpectedMtrrs
+      ));
+  }
+}
 
 /**
   Generate random count of MTRRs for each cache type.
@@ -206,6 +282,8 @@ UnitTestMtrrSetMemoryAttributesInMtrrSettings (
   UINTN                           ActualMemoryRangesCount;
 
   MTRR_SETTINGS             *Mtrrs[2];
+  clock_t                   StartTime;
+  clock_t                   EndTime;
 
   SystemParameter = (MTRR_LIB_SYSTEM_PARAMETER *) Context;
   GenerateRandomMemoryTypeCombination (
@@ -244,11 +322,13 @@ UnitTestMtrrSetMemoryAttributesInMtrrSettings (
 
   for (MtrrIndex = 0; MtrrIndex < ARRAY_SIZE (Mtrrs); MtrrIndex++) {
     Scratch = calloc (ScratchSize, sizeof (UINT8));
+    StartTime = clock ();
     Status = MtrrSetMemoryAttributesInMtrrSettings (Mtrrs[MtrrIndex], Scratch, &ScratchSize, ExpectedMemoryRanges, ExpectedMemoryRangesCount);
     if (Status == RETURN_BUFFER_TOO_SMALL) {
       Scratch = realloc (Scratch, ScratchSize);
       Status = MtrrSetMemoryAttributesInMtrrSettings (Mtrrs[MtrrIndex], Scratch, &ScratchSize, ExpectedMemoryRanges, ExpectedMemoryRangesCount);
     }
+    EndTime = clock ();
     UT_ASSERT_STATUS_EQUAL (Status, RETURN_SUCCESS);
 
     if (Mtrrs[MtrrIndex] == NULL) {
@@ -266,6 +346,17 @@ UnitTestMtrrSetMemoryAttributesInMtrrSettings (
     VerifyMemoryRanges (ExpectedMemoryRanges, ExpectedMemoryRangesCount, ActualMemoryRanges, ActualMemoryRangesCount);
     UT_ASSERT_TRUE (ExpectedVariableMtrrUsage >= ActualVariableMtrrUsage);
 
+    //
+    // Only the calculation into a buffer is timed, writing the emulated MSRs
+    // is not part of the solver.
+    //
+    if (Mtrrs[MtrrIndex] != NULL) {
+      RecordSolverStatistics (
+        &mSolverStatistics[1], ExpectedMemoryRangesCount, EndTime - StartTime,
+        ExpectedVariableMtrrUsage, ActualVariableMtrrUsage
+        );
+    }
+
     ZeroMem (&LocalMtrrs, sizeof (LocalMtrrs));
   }
 
@@ -925,6 +1016,8 @@ UnitTestMtrrSetMemoryAttributeInMtrrSettings (
   UINTN                           ActualMemoryRangesCount;
 
   MTRR_SETTINGS                   *Mtrrs[2];
+  clock_t                         StartTime;
+  clock_t                         EndTime;
 
   SystemParameter = (MTRR_LIB_SYSTEM_PARAMETER *) Context;
   GenerateRandomMemoryTypeCombination (
@@ -956,6 +1049,7 @@ UnitTestMtrrSetMemoryAttributeInMtrrSettings (
   Mtrrs[1]               = NULL;
 
   for (MtrrIndex = 0; MtrrIndex < ARRAY_SIZE (Mtrrs); MtrrIndex++) {
+    StartTime = clock ();
     for (Index = 0; Index < ExpectedMemoryRangesCount; Index++) {
       Status = MtrrSetMemoryAttributeInMtrrSettings (
                  Mtrrs[MtrrIndex],
@@ -968,6 +1062,7 @@ UnitTestMtrrSetMemoryAttributeInMtrrSettings (
         return UNIT_TEST_SKIPPED;
       }
     }
+    EndTime = clock ();
 
     if (Mtrrs[MtrrIndex] == NULL) {
       ZeroMem (&LocalMtrrs, sizeof (LocalMtrrs));
@@ -983,6 +1078,13 @@ UnitTestMtrrSetMemoryAttributeInMtrrSettings (
     VerifyMemoryRanges (ExpectedMemoryRanges, ExpectedMemoryRangesCount, ActualMemoryRanges, ActualMemoryRangesCount);
     UT_ASSERT_TRUE (ExpectedVariableMtrrUsage >= ActualVariableMtrrUsage);
 
+    if (Mtrrs[MtrrIndex] != NULL) {
+      RecordSolverStatistics (
+        &mSolverStatistics[0], ExpectedMemoryRangesCount, EndTime - StartTime,
+        ExpectedVariableMtrrUsage, ActualVariableMtrrUsage
+        );
+    }
+
     ZeroMem (&LocalMtrrs, sizeof (LocalMtrrs));
   }
 
@@ -1099,6 +1201,7 @@ UnitTestingEntry (
   // Execute the tests.
   //
   Status = RunAllTestSuites (Framework);
+  DumpSolverStatistics ();
 
 EXIT:
   if (Framework != NULL) {
@@ -34,6 +34,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/BaseMemoryLib.h>
 #include <Library/PcdLib.h>
 #include <Library/MtrrLib.h>
+#include <Library/CpuPageTableLib.h>
 #include <Library/SmmCpuPlatformHookLib.h>
 #include <Library/SmmServicesTableLib.h>
 #include <Library/MemoryAllocationLib.h>
@@ -150,19 +151,6 @@ typedef union {
 
 #define SMRR_MAX_ADDRESS       BASE_4GB
 
-typedef enum {
-  PageNone,
-  Page4K,
-  Page2M,
-  Page1G,
-} PAGE_ATTRIBUTE;
-
-typedef struct {
-  PAGE_ATTRIBUTE   Attribute;
-  UINT64           Length;
-  UINT64           AddressMask;
-} PAGE_ATTRIBUTE_TABLE;
-
 //
 // Size of Task-State Segment defined in IA32 Manual
 //
@@ -26,12 +26,6 @@ UINTN                             mGcdMemNumberOfDesc = 0;
 
 EFI_MEMORY_ATTRIBUTES_TABLE  *mUefiMemoryAttributesTable = NULL;
 
-PAGE_ATTRIBUTE_TABLE mPageAttributeTable[] = {
-  {Page4K,  SIZE_4KB, PAGING_4K_ADDRESS_MASK_64},
-  {Page2M,  SIZE_2MB, PAGING_2M_ADDRESS_MASK_64},
-  {Page1G,  SIZE_1GB, PAGING_1G_ADDRESS_MASK_64},
-};
-
 UINTN  mInternalCr3;
 
 /**
@@ -50,45 +44,31 @@ SetPageTableBase (
 }
 
 /**
-  Return length according to page attributes.
-
-  @param[in]  PageAttributes   The page attribute of the page entry.
+  Describe the page table in use for CpuPageTableLib.
 
-  @return The length of page entry.
+  @param[out]  PageTable        The page table.
 **/
-UINTN
-PageAttributeToLength (
-  IN PAGE_ATTRIBUTE  PageAttribute
+VOID
+GetCpuPageTable (
+  OUT CPU_PAGE_TABLE                    *PageTable
   )
 {
-  UINTN  Index;
-  for (Index = 0; Index < sizeof(mPageAttributeTable)/sizeof(mPageAttributeTable[0]); Index++) {
-    if (PageAttribute == mPageAttributeTable[Index].Attribute) {
-      return (UINTN)mPageAttributeTable[Index].Length;
-    }
-  }
-  return 0;
-}
-
-/**
-  Return address mask according to page attributes.
+  UINTN                 PageTableBase;
+  BOOLEAN               Enable5LevelPaging;
 
-  @param[in]  PageAttributes   The page attribute of the page entry.
+  GetPageTable (&PageTableBase, &Enable5LevelPaging);
 
-  @return The address mask of page entry.
-**/
-UINTN
-PageAttributeToMask (
-  IN PAGE_ATTRIBUTE  PageAttribute
-  )
-{
-  UINTN  Index;
-  for (Index = 0; Index < sizeof(mPageAttributeTable)/sizeof(mPageAttributeTable[0]); Index++) {
-    if (PageAttribute == mPageAttributeTable[Index].Attribute) {
-      return (UINTN)mPageAttributeTable[Index].AddressMask;
-    }
+  PageTable->PageTableBase = PageTableBase;
+  if (sizeof(UINTN) == sizeof(UINT64)) {
+    PageTable->Levels = Enable5LevelPaging ? 5 : 4;
+  } else {
+    PageTable->Levels = 3;
   }
-  return 0;
+  //
+  // The tables are never merged back, see ConvertMemoryPageAttributes().
+  //
+  PageTable->Page1GSupport  = FALSE;
+  PageTable->AddressEncMask = mAddressEncMask;
 }
 
 /**
@@ -99,83 +79,16 @@ PageAttributeToMask (
 
   @return The page entry.
 **/
-VOID *
+UINT64 *
 GetPageTableEntry (
   IN  PHYSICAL_ADDRESS                  Address,
-  OUT PAGE_ATTRIBUTE                    *PageAttribute
+  OUT CPU_PAGE_SIZE                     *PageAttribute
   )
 {
-  UINTN                 Index1;
-  UINTN                 Index2;
-  UINTN                 Index3;
-  UINTN                 Index4;
-  UINTN                 Index5;
-  UINT64                *L1PageTable;
-  UINT64                *L2PageTable;
-  UINT64                *L3PageTable;
-  UINT64                *L4PageTable;
-  UINT64                *L5PageTable;
-  UINTN                 PageTableBase;
-  BOOLEAN               Enable5LevelPaging;
-
-  GetPageTable (&PageTableBase, &Enable5LevelPaging);
-
-  Index5 = ((UINTN)RShiftU64 (Address, 48)) & PAGING_PAE_INDEX_MASK;
-  Index4 = ((UINTN)RShiftU64 (Address, 39)) & PAGING_PAE_INDEX_MASK;
-  Index3 = ((UINTN)Address >> 30) & PAGING_PAE_INDEX_MASK;
-  Index2 = ((UINTN)Address >> 21) & PAGING_PAE_INDEX_MASK;
-  Index1 = ((UINTN)Address >> 12) & PAGING_PAE_INDEX_MASK;
+  CPU_PAGE_TABLE        PageTable;
 
-  if (sizeof(UINTN) == sizeof(UINT64)) {
-    if (Enable5LevelPaging) {
-      L5PageTable = (UINT64 *)PageTableBase;
-      if (L5PageTable[Index5] == 0) {
-        *PageAttribute = PageNone;
-        return NULL;
-      }
-
-      L4PageTable = (UINT64 *)(UINTN)(L5PageTable[Index5] & ~mAddressEncMask & PAGING_4K_ADDRESS_MASK_64);
-    } else {
-      L4PageTable = (UINT64 *)PageTableBase;
-    }
-    if (L4PageTable[Index4] == 0) {
-      *PageAttribute = PageNone;
-      return NULL;
-    }
-
-    L3PageTable = (UINT64 *)(UINTN)(L4PageTable[Index4] & ~mAddressEncMask & PAGING_4K_ADDRESS_MASK_64);
-  } else {
-    L3PageTable = (UINT64 *)PageTableBase;
-  }
-  if (L3PageTable[Index3] == 0) {
-    *PageAttribute = PageNone;
-    return NULL;
-  }
-  if ((L3PageTable[Index3] & IA32_PG_PS) != 0) {
-    // 1G
-    *PageAttribute = Page1G;
-    return &L3PageTable[Index3];
-  }
-
-  L2PageTable = (UINT64 *)(UINTN)(L3PageTable[Index3] & ~mAddressEncMask & PAGING_4K_ADDRESS_MASK_64);
-  if (L2PageTable[Index2] == 0) {
-    *PageAttribute = PageNone;
-    return NULL;
-  }
-  if ((L2PageTable[Index2] & IA32_PG_PS) != 0) {
-    // 2M
-    *PageAttribute = Page2M;
-    return &L2PageTable[Index2];
-  }
-
-  // 4k
-  L1PageTable = (UINT64 *)(UINTN)(L2PageTable[Index2] & ~mAddressEncMask & PAGING_4K_ADDRESS_MASK_64);
-  if ((L1PageTable[Index1] == 0) && (Address != 0)) {
-    *PageAttribute = PageNone;
-    return NULL;
-  }
-  *PageAttribute = Page4K;
-  return &L1PageTable[Index1];
+  GetCpuPageTable (&PageTable);
+  return CpuPageTableGetEntry (&PageTable, Address, PageAttribute);
 }
 
 /**
@@ -205,171 +118,61 @@ GetAttributesFromPageEntry (
 }
 
 /**
-  Modify memory attributes of page entry.
+  Compute the bits of the page entries to set and to clear to modify their
+  memory attributes.
 
-  @param[in]   PageEntry        The page entry.
   @param[in]   Attributes       The bit mask of attributes to modify for the memory region.
   @param[in]   IsSet            TRUE means to set attributes. FALSE means to clear attributes.
-  @param[out]  IsModified       TRUE means page table modified. FALSE means page table not modified.
+  @param[out]  Change           The SetBits and ClearBits of the change are returned.
 **/
 VOID
-ConvertPageEntryAttribute (
-  IN  UINT64                            *PageEntry,
+GetPageEntryChange (
   IN  UINT64                            Attributes,
   IN  BOOLEAN                           IsSet,
-  OUT BOOLEAN                           *IsModified
+  OUT CPU_PAGE_TABLE_CHANGE             *Change
   )
 {
-  UINT64  CurrentPageEntry;
-  UINT64  NewPageEntry;
+  UINT64  SetBits;
+  UINT64  ClearBits;
 
-  CurrentPageEntry = *PageEntry;
-  NewPageEntry = CurrentPageEntry;
+  SetBits   = 0;
+  ClearBits = 0;
   if ((Attributes & EFI_MEMORY_RP) != 0) {
     if (IsSet) {
-      NewPageEntry &= ~(UINT64)IA32_PG_P;
+      ClearBits |= IA32_PG_P;
     } else {
-      NewPageEntry |= IA32_PG_P;
+      SetBits |= IA32_PG_P;
     }
   }
   if ((Attributes & EFI_MEMORY_RO) != 0) {
     if (IsSet) {
-      NewPageEntry &= ~(UINT64)IA32_PG_RW;
+      ClearBits |= IA32_PG_RW;
       if (mInternalCr3 != 0) {
         // Environment setup
         // ReadOnly page need set Dirty bit for shadow stack
-        NewPageEntry |= IA32_PG_D;
+        SetBits |= IA32_PG_D;
         // Clear user bit for supervisor shadow stack
-        NewPageEntry &= ~(UINT64)IA32_PG_U;
+        ClearBits |= IA32_PG_U;
       } else {
         // Runtime update
         // Clear dirty bit for non shadow stack, to protect RO page.
-        NewPageEntry &= ~(UINT64)IA32_PG_D;
+        ClearBits |= IA32_PG_D;
       }
     } else {
-      NewPageEntry |= IA32_PG_RW;
+      SetBits |= IA32_PG_RW;
     }
   }
   if ((Attributes & EFI_MEMORY_XP) != 0) {
     if (mXdSupported) {
       if (IsSet) {
-        NewPageEntry |= IA32_PG_NX;
+        SetBits |= IA32_PG_NX;
       } else {
-        NewPageEntry &= ~IA32_PG_NX;
-      }
-    }
-  }
-  *PageEntry = NewPageEntry;
-  if (CurrentPageEntry != NewPageEntry) {
-    *IsModified = TRUE;
-    DEBUG ((DEBUG_VERBOSE, "ConvertPageEntryAttribute 0x%lx", CurrentPageEntry));
-    DEBUG ((DEBUG_VERBOSE, "->0x%lx\n", NewPageEntry));
-  } else {
-    *IsModified = FALSE;
-  }
-}
-
-/**
-  This function returns if there is need to split page entry.
-
-  @param[in]  BaseAddress      The base address to be checked.
-  @param[in]  Length           The length to be checked.
-  @param[in]  PageEntry        The page entry to be checked.
-  @param[in]  PageAttribute    The page attribute of the page entry.
-
-  @retval SplitAttributes on if there is need to split page entry.
-**/
-PAGE_ATTRIBUTE
-NeedSplitPage (
-  IN  PHYSICAL_ADDRESS                  BaseAddress,
-  IN  UINT64                            Length,
-  IN  UINT64                            *PageEntry,
-  IN  PAGE_ATTRIBUTE                    PageAttribute
-  )
-{
-  UINT64                PageEntryLength;
-
-  PageEntryLength = PageAttributeToLength (PageAttribute);
-
-  if (((BaseAddress & (PageEntryLength - 1)) == 0) && (Length >= PageEntryLength)) {
-    return PageNone;
-  }
-
-  if (((BaseAddress & PAGING_2M_MASK) != 0) || (Length < SIZE_2MB)) {
-    return Page4K;
-  }
-
-  return Page2M;
-}
-
-/**
-  This function splits one page entry to small page entries.
-
-  @param[in]  PageEntry        The page entry to be splitted.
-  @param[in]  PageAttribute    The page attribute of the page entry.
-  @param[in]  SplitAttribute   How to split the page entry.
-
-  @retval RETURN_SUCCESS            The page entry is splitted.
-  @retval RETURN_UNSUPPORTED        The page entry does not support to be splitted.
-  @retval RETURN_OUT_OF_RESOURCES   No resource to split page entry.
-**/
-RETURN_STATUS
-SplitPage (
-  IN  UINT64                            *PageEntry,
-  IN  PAGE_ATTRIBUTE                    PageAttribute,
-  IN  PAGE_ATTRIBUTE                    SplitAttribute
-  )
-{
-  UINT64   BaseAddress;
-  UINT64   *NewPageEntry;
-  UINTN    Index;
-
-  ASSERT (PageAttribute == Page2M || PageAttribute == Page1G);
-
-  if (PageAttribute == Page2M) {
-    //
-    // Split 2M to 4K
-    //
-    ASSERT (SplitAttribute == Page4K);
-    if (SplitAttribute == Page4K) {
-      NewPageEntry = AllocatePageTableMemory (1);
-      DEBUG ((DEBUG_VERBOSE, "Split - 0x%x\n", NewPageEntry));
-      if (NewPageEntry == NULL) {
-        return RETURN_OUT_OF_RESOURCES;
+        ClearBits |= IA32_PG_NX;
       }
-      BaseAddress = *PageEntry & PAGING_2M_ADDRESS_MASK_64;
-      for (Index = 0; Index < SIZE_4KB / sizeof(UINT64); Index++) {
-        NewPageEntry[Index] = (BaseAddress + SIZE_4KB * Index) | mAddressEncMask | ((*PageEntry) & PAGE_PROGATE_BITS);
-      }
-      (*PageEntry) = (UINT64)(UINTN)NewPageEntry | mAddressEncMask | PAGE_ATTRIBUTE_BITS;
-      return RETURN_SUCCESS;
-    } else {
-      return RETURN_UNSUPPORTED;
     }
-  } else if (PageAttribute == Page1G) {
-    //
-    // Split 1G to 2M
-    // No need support 1G->4K directly, we should use 1G->2M, then 2M->4K to get more compact page table.
-    //
-    ASSERT (SplitAttribute == Page2M || SplitAttribute == Page4K);
-    if ((SplitAttribute == Page2M || SplitAttribute == Page4K)) {
-      NewPageEntry = AllocatePageTableMemory (1);
-      DEBUG ((DEBUG_VERBOSE, "Split - 0x%x\n", NewPageEntry));
-      if (NewPageEntry == NULL) {
-        return RETURN_OUT_OF_RESOURCES;
-      }
-      BaseAddress = *PageEntry & PAGING_1G_ADDRESS_MASK_64;
-      for (Index = 0; Index < SIZE_4KB / sizeof(UINT64); Index++) {
-        NewPageEntry[Index] = (BaseAddress + SIZE_2MB * Index) | mAddressEncMask | IA32_PG_PS | ((*PageEntry) & PAGE_PROGATE_BITS);
-      }
-      (*PageEntry) = (UINT64)(UINTN)NewPageEntry | mAddressEncMask | PAGE_ATTRIBUTE_BITS;
-      return RETURN_SUCCESS;
-    } else {
-      return RETURN_UNSUPPORTED;
-    }
-  } else {
-    return RETURN_UNSUPPORTED;
   }
+  Change->SetBits   = SetBits;
+  Change->ClearBits = ClearBits;
 }
 
 /**
@@ -409,12 +212,9 @@ ConvertMemoryPageAttributes (
   OUT BOOLEAN                           *IsModified   OPTIONAL
   )
 {
-  UINT64                            *PageEntry;
-  PAGE_ATTRIBUTE                    PageAttribute;
-  UINTN                             PageEntryLength;
-  PAGE_ATTRIBUTE                    SplitAttribute;
+  CPU_PAGE_TABLE                    PageTable;
+  CPU_PAGE_TABLE_CHANGE             Change;
   RETURN_STATUS                     Status;
-  BOOLEAN                           IsEntryModified;
   EFI_PHYSICAL_ADDRESS              MaximumSupportMemAddress;
 
   ASSERT (Attributes != 0);
@@ -440,51 +240,27 @@ ConvertMemoryPageAttributes (
 
 //  DEBUG ((DEBUG_ERROR, "ConvertMemoryPageAttributes(%x) - %016lx, %016lx, %02lx\n", IsSet, BaseAddress, Length, Attributes));
 
-  if (IsSplitted != NULL) {
-    *IsSplitted = FALSE;
-  }
-  if (IsModified != NULL) {
-    *IsModified = FALSE;
-  }
+  GetCpuPageTable (&PageTable);
+  GetPageEntryChange (Attributes, IsSet, &Change);
+  Change.BaseAddress = BaseAddress;
+  Change.Length      = Length;
 
   //
-  // Below logic is to check 2M/4K page to make sure we do not waste memory.
+  // Tables split here are not merged back: the page table pool cannot take
+  // pages back, and the on-demand paging keeps its own bookkeeping in the
+  // available bits of the entries.
   //
-  while (Length != 0) {
-    PageEntry = GetPageTableEntry (BaseAddress, &PageAttribute);
-    if (PageEntry == NULL) {
-      return RETURN_UNSUPPORTED;
-    }
-    PageEntryLength = PageAttributeToLength (PageAttribute);
-    SplitAttribute = NeedSplitPage (BaseAddress, Length, PageEntry, PageAttribute);
-    if (SplitAttribute == PageNone) {
-      ConvertPageEntryAttribute (PageEntry, Attributes, IsSet, &IsEntryModified);
-      if (IsEntryModified) {
-        if (IsModified != NULL) {
-          *IsModified = TRUE;
-        }
-      }
-      //
-      // Convert success, move to next
-      //
-      BaseAddress += PageEntryLength;
-      Length -= PageEntryLength;
-    } else {
-      Status = SplitPage (PageEntry, PageAttribute, SplitAttribute);
-      if (RETURN_ERROR (Status)) {
-        return RETURN_UNSUPPORTED;
-      }
-      if (IsSplitted != NULL) {
-        *IsSplitted = TRUE;
-      }
-      if (IsModified != NULL) {
-        *IsModified = TRUE;
-      }
-      //
-      // Just split current page
-      // Convert success in next around
-      //
-    }
+  Status = CpuPageTableUpdate (
+             &PageTable,
+             &Change,
+             1,
+             AllocatePageTableMemory,
+             NULL,
+             IsSplitted,
+             IsModified
+             );
+  if (RETURN_ERROR (Status)) {
+    return RETURN_UNSUPPORTED;
   }
 
   return RETURN_SUCCESS;
@@ -1513,7 +1289,7 @@ EdkiiSmmGetMemoryAttributes (
   EFI_PHYSICAL_ADDRESS  Address;
   UINT64                *PageEntry;
   UINT64                MemAttr;
-  PAGE_ATTRIBUTE        PageAttr;
+  CPU_PAGE_SIZE         PageAttr;
   INT64                 Size;
 
   if (Length < SIZE_4KB || Attributes == NULL) {
@@ -1526,7 +1302,7 @@ EdkiiSmmGetMemoryAttributes (
   do {
 
     PageEntry = GetPageTableEntry (BaseAddress, &PageAttr);
-    if (PageEntry == NULL || PageAttr == PageNone) {
+    if (PageEntry == NULL || PageAttr == CpuPageNone) {
       return EFI_UNSUPPORTED;
     }
 
@@ -1540,19 +1316,19 @@ EdkiiSmmGetMemoryAttributes (
     }
 
     switch (PageAttr) {
-    case Page4K:
+    case CpuPage4K:
       Address     = *PageEntry & ~mAddressEncMask & PAGING_4K_ADDRESS_MASK_64;
       Size        -= (SIZE_4KB - (BaseAddress - Address));
       BaseAddress += (SIZE_4KB - (BaseAddress - Address));
       break;
 
-    case Page2M:
+    case CpuPage2M:
       Address     = *PageEntry & ~mAddressEncMask & PAGING_2M_ADDRESS_MASK_64;
       Size        -= SIZE_2MB - (BaseAddress - Address);
       BaseAddress += SIZE_2MB - (BaseAddress - Address);
       break;
 
-    case Page1G:
+    case CpuPage1G:
       Address     = *PageEntry & ~mAddressEncMask & PAGING_1G_ADDRESS_MASK_64;
       Size        -= SIZE_1GB - (BaseAddress - Address);
       BaseAddress += SIZE_1GB - (BaseAddress - Address);